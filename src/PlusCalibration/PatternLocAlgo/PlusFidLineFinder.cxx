@@ -422,6 +422,61 @@ double PlusFidLineFinder::ComputeDistancePointLine( const PlusFidDot& dot, const
 
 //-----------------------------------------------------------------------------
 
+bool PlusFidLineFinder::DotNeighborDistanceLessThan( const DotNeighbor& neighbor1, const DotNeighbor& neighbor2 )
+{
+  return neighbor1.DistancePx < neighbor2.DistancePx;
+}
+
+//-----------------------------------------------------------------------------
+
+void PlusFidLineFinder::BuildDotNeighborIndex()
+{
+  LOG_TRACE( "FidLineFinder::BuildDotNeighborIndex" );
+
+  m_DotNeighbors.clear();
+  m_DotNeighbors.resize( m_DotsVector.size() );
+
+  for ( unsigned int originIndex = 0; originIndex < m_DotsVector.size(); originIndex++ )
+  {
+    std::vector<DotNeighbor>& neighbors = m_DotNeighbors[originIndex];
+    neighbors.reserve( m_DotsVector.size() - 1 );
+    for ( unsigned int dotIndex = 0; dotIndex < m_DotsVector.size(); dotIndex++ )
+    {
+      if ( dotIndex == originIndex )
+      {
+        continue;
+      }
+      // Distance and angle are computed exactly the same way as in the line tests, so that they can be used instead of them
+      DotNeighbor neighbor;
+      neighbor.DistancePx = SegmentLength( m_DotsVector[originIndex], m_DotsVector[dotIndex] );
+      neighbor.AngleRad = ComputeAngleRad( m_DotsVector[originIndex], m_DotsVector[dotIndex] );
+      neighbor.DotIndex = dotIndex;
+      neighbors.push_back( neighbor );
+    }
+    std::stable_sort( neighbors.begin(), neighbors.end(), DotNeighborDistanceLessThan );
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void PlusFidLineFinder::GetDotNeighborsInLengthRange( unsigned int originDotIndex, double minLengthPx, double maxLengthPx,
+    std::vector<DotNeighbor>::const_iterator& beginIt, std::vector<DotNeighbor>::const_iterator& endIt ) const
+{
+  const std::vector<DotNeighbor>& neighbors = m_DotNeighbors[originDotIndex];
+
+  DotNeighbor bound;
+  bound.AngleRad = 0;
+  bound.DotIndex = 0;
+
+  bound.DistancePx = minLengthPx;
+  beginIt = std::lower_bound( neighbors.begin(), neighbors.end(), bound, DotNeighborDistanceLessThan );
+
+  bound.DistancePx = maxLengthPx;
+  endIt = std::upper_bound( beginIt, neighbors.end(), bound, DotNeighborDistanceLessThan );
+}
+
+//-----------------------------------------------------------------------------
+
 void PlusFidLineFinder::FindLines2Points()
 {
   LOG_TRACE( "FidLineFinder::FindLines2Points" );
@@ -431,42 +486,54 @@ void PlusFidLineFinder::FindLines2Points()
     return;
   }
 
-  std::vector<PlusFidLine> twoPointsLinesVector;
+  std::vector<PlusFidLine> twoPointsLinesVector; // sorted by PlusFidLine::compareLines, so that duplicates can be found by a binary search
 
   for( unsigned int i = 0 ; i < m_Patterns.size() ; i++ )
   {
     //the expected length of the line
     int lineLenPx = floor( m_Patterns[i]->GetDistanceToOriginMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 );
+    double lineLenTolerancePx = floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 );
 
     for ( unsigned int dot1Index = 0; dot1Index < m_DotsVector.size() - 1; dot1Index++ )
     {
-      for ( unsigned int dot2Index = dot1Index + 1; dot2Index < m_DotsVector.size(); dot2Index++ )
+      // only the dots at the expected distance are examined
+      std::vector<DotNeighbor>::const_iterator neighborsBeginIt;
+      std::vector<DotNeighbor>::const_iterator neighborsEndIt;
+      GetDotNeighborsInLengthRange( dot1Index, lineLenPx - lineLenTolerancePx, lineLenPx + lineLenTolerancePx, neighborsBeginIt, neighborsEndIt );
+
+      for ( std::vector<DotNeighbor>::const_iterator neighborIt = neighborsBeginIt; neighborIt != neighborsEndIt; ++neighborIt )
       {
-        double length = SegmentLength( m_DotsVector[dot1Index], m_DotsVector[dot2Index] );
-        bool acceptLength = fabs( length - lineLenPx ) < floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[m_Patterns[i]->GetWires().size() - 1] / m_ApproximateSpacingMmPerPixel + 0.5 );
+        unsigned int dot2Index = neighborIt->DotIndex;
+        if ( dot2Index <= dot1Index )
+        {
+          // each pair is examined only once
+          continue;
+        }
 
-        if( acceptLength ) //to only add valid two point lines
+        bool acceptLength = fabs( neighborIt->DistancePx - lineLenPx ) < lineLenTolerancePx;
+        if( !acceptLength )
         {
-          double angleRad = ComputeAngleRad( m_DotsVector[dot1Index], m_DotsVector[dot2Index] );
-          bool acceptAngle = AcceptAngleRad( angleRad );
+          continue;
+        }
 
-          if( acceptAngle )
-          {
-            PlusFidLine twoPointsLine;
-            twoPointsLine.AddPoint( dot1Index );
-            twoPointsLine.AddPoint( dot2Index );
+        bool acceptAngle = AcceptAngleRad( neighborIt->AngleRad );
+        if( !acceptAngle )
+        {
+          continue;
+        }
 
-            bool duplicate = std::binary_search( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), twoPointsLine, PlusFidLine::compareLines );
+        PlusFidLine twoPointsLine;
+        twoPointsLine.AddPoint( dot1Index );
+        twoPointsLine.AddPoint( dot2Index );
 
-            if( !duplicate )
-            {
-              twoPointsLine.SetStartPointIndex( dot1Index );
-              ComputeLine( twoPointsLine );
+        std::vector<PlusFidLine>::iterator insertPositionIt = std::lower_bound( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), twoPointsLine, PlusFidLine::compareLines );
+        bool duplicate = ( insertPositionIt != twoPointsLinesVector.end() && !PlusFidLine::compareLines( twoPointsLine, *insertPositionIt ) );
 
-              twoPointsLinesVector.push_back( twoPointsLine );
-              std::sort( twoPointsLinesVector.begin(), twoPointsLinesVector.end(), PlusFidLine::compareLines ); //the lines need to be sorted that way each time for the binary search to be performed
-            }
-          }
+        if( !duplicate )
+        {
+          twoPointsLine.SetStartPointIndex( dot1Index );
+          ComputeLine( twoPointsLine );
+          twoPointsLinesVector.insert( insertPositionIt, twoPointsLine );
         }
       }
     }
@@ -483,7 +550,9 @@ void PlusFidLineFinder::FindLinesNPoints()
   /* For each point, loop over each 2-point line and try to make a 3-point
   * line. For the third point use the theta of the line and compute a value
   * for p. Accept the line if the compute p is within some small distance
-  * of the 2-point line. */
+  * of the 2-point line.
+  * Only the dots that are at the expected distance from the line origin (according to the
+  * phantom definition) and that are inside the angular corridor around the line direction are examined. */
 
   LOG_TRACE( "FidLineFinder::FindLines3Points" );
 
@@ -507,13 +576,56 @@ void PlusFidLineFinder::FindLinesNPoints()
         continue;
       }
 
+      int lineLenPx = floor( m_Patterns[i]->GetDistanceToOriginMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 );
+      double lineLenTolerancePx = floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 );
+
+      // A dot at distance r from the origin that is closer than dist to the line deviates from the line direction by at most asin(dist/r).
+      // The corridor is computed for the smallest accepted r; a small margin is added so that rounding errors cannot reject a dot.
+      double minLengthPx = lineLenPx - lineLenTolerancePx;
+      double corridorHalfWidthRad = vtkMath::Pi();
+      if ( minLengthPx > dist )
+      {
+        corridorHalfWidthRad = asin( dist / minLengthPx ) + 1e-3;
+      }
+
       for ( unsigned int l = 0; l < m_LinesVector[linesVectorIndex - 1].size(); l++ )
       {
         PlusFidLine currentShorterPointsLine;
         currentShorterPointsLine = m_LinesVector[linesVectorIndex - 1][l]; //the current max point line we want to expand
 
-        for ( unsigned int b3 = 0; b3 < m_DotsVector.size(); b3++ )
+        const PlusFidDot& originDot = m_DotsVector[currentShorterPointsLine.GetStartPointIndex()];
+        const PlusFidDot& endDot = m_DotsVector[currentShorterPointsLine.GetEndPointIndex()];
+        double lineAngleRad = ComputeAngleRad( originDot, endDot );
+
+        std::vector<DotNeighbor>::const_iterator neighborsBeginIt;
+        std::vector<DotNeighbor>::const_iterator neighborsEndIt;
+        GetDotNeighborsInLengthRange( currentShorterPointsLine.GetStartPointIndex(), minLengthPx, lineLenPx + lineLenTolerancePx, neighborsBeginIt, neighborsEndIt );
+
+        for ( std::vector<DotNeighbor>::const_iterator neighborIt = neighborsBeginIt; neighborIt != neighborsEndIt; ++neighborIt )
         {
+          unsigned int b3 = neighborIt->DotIndex;
+
+          double length = neighborIt->DistancePx; //distance between the origin and the point we try to add
+          bool acceptLength = fabs( length - lineLenPx ) < lineLenTolerancePx;
+          if( !acceptLength )
+          {
+            continue;
+          }
+
+          if ( length > dist )
+          {
+            double angleDifferenceRad = fabs( neighborIt->AngleRad - lineAngleRad );
+            if ( angleDifferenceRad > vtkMath::Pi() )
+            {
+              angleDifferenceRad = 2 * vtkMath::Pi() - angleDifferenceRad;
+            }
+            if ( angleDifferenceRad > corridorHalfWidthRad )
+            {
+              // outside of the corridor, cannot be close enough to the line
+              continue;
+            }
+          }
+
           std::vector<int> candidatesIndex;
           bool checkDuplicateFlag = false;//assume there is no duplicate
 
@@ -547,25 +659,14 @@ void PlusFidLineFinder::FindLinesNPoints()
             }
             line.SetStartPointIndex( currentShorterPointsLine.GetStartPointIndex() );
 
-
-            double length = SegmentLength( m_DotsVector[currentShorterPointsLine.GetStartPointIndex()], m_DotsVector[b3] ); //distance between the origin and the point we try to add
-
-            int lineLenPx = floor( m_Patterns[i]->GetDistanceToOriginMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 );
-            bool acceptLength = fabs( length - lineLenPx ) < floor( m_Patterns[i]->GetDistanceToOriginToleranceMm()[linesVectorIndex - 2] / m_ApproximateSpacingMmPerPixel + 0.5 );
-
-            if( !acceptLength )
-            {
-              continue;
-            }
-
             // Create the vector between the origin point to the end point and between the origin point to the new point to check if the new point is between the origin and the end point
-            double originToEndPointVector[3] = { m_DotsVector[currentShorterPointsLine.GetEndPointIndex()].GetX() - m_DotsVector[currentShorterPointsLine.GetStartPointIndex()].GetX() ,
-                                                 m_DotsVector[currentShorterPointsLine.GetEndPointIndex()].GetY() - m_DotsVector[currentShorterPointsLine.GetStartPointIndex()].GetY() ,
+            double originToEndPointVector[3] = { endDot.GetX() - originDot.GetX() ,
+                                                 endDot.GetY() - originDot.GetY() ,
                                                  0
                                                };
 
-            double originToNewPointVector[3] = {m_DotsVector[b3].GetX() - m_DotsVector[currentShorterPointsLine.GetStartPointIndex()].GetX() ,
-                                                m_DotsVector[b3].GetY() - m_DotsVector[currentShorterPointsLine.GetStartPointIndex()].GetY() ,
+            double originToNewPointVector[3] = {m_DotsVector[b3].GetX() - originDot.GetX() ,
+                                                m_DotsVector[b3].GetY() - originDot.GetY() ,
                                                 0
                                                };
 
@@ -583,14 +684,15 @@ void PlusFidLineFinder::FindLinesNPoints()
               m_LinesVector.push_back( emptyLine );
             }
 
-            if( !std::binary_search( m_LinesVector[linesVectorIndex].begin(), m_LinesVector[linesVectorIndex].end(), line, PlusFidLine::compareLines ) )
+            // the lines are kept sorted so that lines that are already in the list can be quickly found by a binary search
+            std::vector<PlusFidLine>& nPointsLinesVector = m_LinesVector[linesVectorIndex];
+            std::vector<PlusFidLine>::iterator insertPositionIt = std::lower_bound( nPointsLinesVector.begin(), nPointsLinesVector.end(), line, PlusFidLine::compareLines );
+            if( insertPositionIt == nPointsLinesVector.end() || PlusFidLine::compareLines( line, *insertPositionIt ) )
             {
               ComputeLine( line );
               if( AcceptLine( line ) )
               {
-                m_LinesVector[linesVectorIndex].push_back( line );
-                // sort the lines so that lines that are already in the list can be quickly found by a binary search
-                std::sort ( m_LinesVector[linesVectorIndex].begin(), m_LinesVector[linesVectorIndex].end(), PlusFidLine::compareLines );
+                nPointsLinesVector.insert( insertPositionIt, line );
               }
             }
           }
@@ -613,6 +715,7 @@ void PlusFidLineFinder::Clear()
   m_DotsVector.clear();
   m_LinesVector.clear();
   m_CandidateFidValues.clear();
+  m_DotNeighbors.clear();
 
   std::vector<PlusFidLine> emptyLine;
   m_LinesVector.push_back( emptyLine ); //initializing the 0 vector of lines (unused)
@@ -668,6 +771,9 @@ void PlusFidLineFinder::FindLines( )
 {
   LOG_TRACE( "FidLineFinder::FindLines" );
 
+  // Index the dots by their distance from each other, used for quickly finding candidate points of lines
+  BuildDotNeighborIndex();
+
   // Make pairs of dots into 2-point lines.
   FindLines2Points();
 
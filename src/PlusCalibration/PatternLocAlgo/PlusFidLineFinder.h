@@ -17,6 +17,8 @@ class vtkXMLDataElement;
 \brief This class is used to find the n-points lines from a list of dots. The lines have fixed length and tolerance
 and their direction vector restricted according to the configuration file. It first finds 2-points lines and
 then computes n-points lines from these 2-points lines.
+For each dot the other dots are indexed by their distance and angle from it, so that only the dots at the expected
+distance from the line origin and inside the collinearity corridor of the line are examined when a line is extended.
 \ingroup PlusLibPatternRecognition
 */
 
@@ -77,6 +79,24 @@ public:
   void Clear();
 
 protected:
+  /*! A dot as seen from an origin dot: its distance and angle from the origin */
+  struct DotNeighbor
+  {
+    double DistancePx;
+    double AngleRad;
+    unsigned int DotIndex;
+  };
+
+  /*! Compare two neighbors by their distance from the origin dot */
+  static bool DotNeighborDistanceLessThan( const DotNeighbor& neighbor1, const DotNeighbor& neighbor2 );
+
+  /*! Build for each dot the list of all other dots, sorted by their distance from it */
+  void BuildDotNeighborIndex();
+
+  /*! Get the neighbors of an origin dot whose distance from the origin is in the [minLengthPx, maxLengthPx] range */
+  void GetDotNeighborsInLengthRange( unsigned int originDotIndex, double minLengthPx, double maxLengthPx,
+                                     std::vector<DotNeighbor>::const_iterator& beginIt, std::vector<DotNeighbor>::const_iterator& endIt ) const;
+
   /*! Compute parameters such as the minimum and the maximum angle allowed for one line in the case where the segmentation
   parameters are to be computed. This allows a better precision and possibly an increase of computation speed. */
   void ComputeParameters();
@@ -133,6 +153,9 @@ protected:
   std::vector<PlusFidDot> m_DotsVector;
   std::vector< std::vector<PlusFidLine> > m_LinesVector;
 
+  /*! For each dot of m_DotsVector all the other dots, sorted by their distance from it */
+  std::vector< std::vector<DotNeighbor> > m_DotNeighbors;
+
   std::vector<PlusFidPattern*> m_Patterns;
 };
 
@@ -10,15 +10,54 @@ See License.txt for details.
 #include "vtkPoints.h"
 #include "vtkLine.h"
 
+#include "vtkMultiThreader.h"
+
 #include "vtkPlusTrackedFrameList.h"
 #include "PlusTrackedFrame.h"
 
 static const double DOT_STEPS  = 4.0;
 static const double DOT_RADIUS = 6.0;
 
+namespace
+{
+  struct RecognizePatternThreadFunctionInfoStruct
+  {
+    vtkPlusTrackedFrameList* TrackedFrameList;
+    std::vector<unsigned int> FrameIndices;
+    // Results of each frame, written by the thread that processed the frame
+    std::vector<PlusStatus> FrameStatus;
+    std::vector<PlusFidPatternRecognition::PatternRecognitionError> FrameErrors;
+    // Each thread uses its own copy of the algorithm, as the segmentation, line finder and labeling store per-frame state
+    std::vector<PlusFidPatternRecognition*> PatternRecognitions;
+  };
+
+  //-----------------------------------------------------------------------------
+
+  VTK_THREAD_RETURN_TYPE RecognizePatternThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    RecognizePatternThreadFunctionInfoStruct* str = static_cast<RecognizePatternThreadFunctionInfoStruct*>(threadInfo->UserData);
+
+    int threadId = threadInfo->ThreadID;
+    int threadCount = threadInfo->NumberOfThreads;
+    PlusFidPatternRecognition* patternRecognition = str->PatternRecognitions[threadId];
+
+    // Frames are distributed in an interleaved way to balance the load between threads
+    for (unsigned int i = threadId; i < str->FrameIndices.size(); i += threadCount)
+    {
+      unsigned int frameIndex = str->FrameIndices[i];
+      str->FrameStatus[i] = patternRecognition->RecognizePattern(str->TrackedFrameList->GetTrackedFrame(frameIndex), str->FrameErrors[i], frameIndex);
+    }
+
+    return VTK_THREAD_RETURN_VALUE;
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 PlusFidPatternRecognition::PlusFidPatternRecognition()
+  : m_MaxLineLengthToleranceMm(0)
+  , m_NumberOfThreads(0)
 {
 
 }
@@ -178,17 +217,57 @@ PlusStatus PlusFidPatternRecognition::RecognizePattern(vtkPlusTrackedFrameList*
     *numberOfSuccessfullySegmentedImages = 0;
   }
 
+  RecognizePatternThreadFunctionInfoStruct str;
+  str.TrackedFrameList = trackedFrameList;
   for (unsigned int currentFrameIndex = 0; currentFrameIndex < trackedFrameList->GetNumberOfTrackedFrames(); currentFrameIndex++)
   {
-    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(currentFrameIndex);
-
     // segment only non segmented frames
-    if (trackedFrame->GetFiducialPointsCoordinatePx() != NULL)
+    if (trackedFrameList->GetTrackedFrame(currentFrameIndex)->GetFiducialPointsCoordinatePx() == NULL)
     {
-      continue;
+      str.FrameIndices.push_back(currentFrameIndex);
     }
+  }
+  if (str.FrameIndices.empty())
+  {
+    return status;
+  }
+  str.FrameStatus.resize(str.FrameIndices.size(), PLUS_FAIL);
+  str.FrameErrors.resize(str.FrameIndices.size(), PATTERN_RECOGNITION_ERROR_NO_ERROR);
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (m_NumberOfThreads > 0)
+  {
+    threader->SetNumberOfThreads(m_NumberOfThreads);
+  }
+  if (static_cast<unsigned int>(threader->GetNumberOfThreads()) > str.FrameIndices.size())
+  {
+    threader->SetNumberOfThreads(static_cast<int>(str.FrameIndices.size()));
+  }
+  int numberOfThreads = threader->GetNumberOfThreads();
+
+  // Create per-thread copies of the algorithm (with their own working image buffers)
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+  {
+    str.PatternRecognitions.push_back(new PlusFidPatternRecognition(*this));
+  }
+
+  threader->SetSingleMethod(RecognizePatternThreadFunction, &str);
+  threader->SingleMethodExecute();
+
+  for (std::vector<PlusFidPatternRecognition*>::iterator it = str.PatternRecognitions.begin(); it != str.PatternRecognitions.end(); ++it)
+  {
+    delete *it;
+  }
+
+  // Collect the results in frame order
+  for (unsigned int i = 0; i < str.FrameIndices.size(); ++i)
+  {
+    unsigned int currentFrameIndex = str.FrameIndices[i];
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(currentFrameIndex);
 
-    if (RecognizePattern(trackedFrame, patternRecognitionError, currentFrameIndex) != PLUS_SUCCESS)
+    // the reported error is the error of the last processed frame, as in sequential processing
+    patternRecognitionError = str.FrameErrors[i];
+    if (str.FrameStatus[i] != PLUS_SUCCESS)
     {
       if (patternRecognitionError != PATTERN_RECOGNITION_ERROR_TOO_MANY_CANDIDATES)
       {
@@ -44,7 +44,9 @@ public:
 
   /*!
   Run pattern recognition on a tracked frame list.
-  It only segments the tracked frames which were not already segmented
+  It only segments the tracked frames which were not already segmented.
+  Frames are processed in parallel on NumberOfThreads threads, each thread uses its own copy of the
+  segmentation, line finder and labeling objects. The results are the same as with sequential processing.
   \param trackedFrameList Tracked frame list to segment
   \param numberOfSuccessfullySegmentedImages Out parameter holding the number of segmented images in this call (it is only equals the number of all segmented images in the tracked frame if it was not segmented at all)
   \param segmentedFramesIndices Indices of the frames that were properly segmented
@@ -95,6 +97,12 @@ public:
   /*! Reads the phantom definition and computes the NWires intersection if needed */
   PlusStatus ReadPhantomDefinition(vtkXMLDataElement* rootConfigElement);
 
+  /*! Set the number of threads used for segmenting a tracked frame list. If 0 then the number of threads is determined automatically. */
+  void SetNumberOfThreads(int numberOfThreads) { m_NumberOfThreads = numberOfThreads; };
+
+  /*! Get the number of threads used for segmenting a tracked frame list (0 = automatic) */
+  int GetNumberOfThreads() { return m_NumberOfThreads; };
+
 protected:
 
   PlusFidSegmentation           m_FidSegmentation;
@@ -103,6 +111,9 @@ protected:
   std::vector<PlusFidPattern*>  m_Patterns;
 
   double                        m_MaxLineLengthToleranceMm;
+
+  /*! Number of threads used for segmenting a tracked frame list (0 = automatic) */
+  int                           m_NumberOfThreads;
 };
 
 //-----------------------------------------------------------------------------
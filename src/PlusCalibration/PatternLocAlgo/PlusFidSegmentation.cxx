@@ -13,6 +13,11 @@
 #include <iostream>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PLUS_FID_SEGMENTATION_USE_SSE2
+#endif
+
 #include "itkRGBPixel.h"
 #include "itkImage.h"
 #include "itkImageFileReader.h"
@@ -25,6 +30,159 @@ static const short MAX_CLUSTER_VALS = 16384;
 
 const int PlusFidSegmentation::DEFAULT_NUMBER_OF_MAXIMUM_FIDUCIAL_POINT_CANDIDATES = 20;
 
+namespace
+{
+  typedef unsigned char MorphPixelType;
+
+  //-----------------------------------------------------------------------------
+  // Element-wise minimum/maximum of two rows. These are the inner loops of the running min/max
+  // computation, processed 16 pixels at a time if SSE2 is available.
+  inline void MinimumOfRows(MorphPixelType* out, const MorphPixelType* a, const MorphPixelType* b, int length)
+  {
+    int i = 0;
+#ifdef PLUS_FID_SEGMENTATION_USE_SSE2
+    for (; i + 16 <= length; i += 16)
+    {
+      __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_min_epu8(va, vb));
+    }
+#endif
+    for (; i < length; i++)
+    {
+      out[i] = std::min(a[i], b[i]);
+    }
+  }
+
+  inline void MaximumOfRows(MorphPixelType* out, const MorphPixelType* a, const MorphPixelType* b, int length)
+  {
+    int i = 0;
+#ifdef PLUS_FID_SEGMENTATION_USE_SSE2
+    for (; i + 16 <= length; i += 16)
+    {
+      __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_max_epu8(va, vb));
+    }
+#endif
+    for (; i < length; i++)
+    {
+      out[i] = std::max(a[i], b[i]);
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  /*
+    Erosion (running minimum) or dilation (running maximum) with a line structuring element of 2*barSize+1 pixels,
+    using the van Herk/Gil-Werman algorithm: the line is split into blocks of the structuring element length,
+    the prefix and suffix min/max are computed within each block, then each output pixel is the min/max of one
+    suffix and one prefix value. The cost is independent of the bar size. The result is exactly the same as
+    computing the min/max of all the pixels under the structuring element.
+
+    The structuring element is centered at the current pixel and each of its pixels is one row below the previous
+    one and shifted by columnShiftPerRow columns (0: 90 deg, +1: 135 deg, -1: 45 deg). If horizontal is true then
+    the structuring element is horizontal (0 deg) and columnShiftPerRow is ignored.
+
+    Only pixels in the region of interest (roi: xmin, ymin, xmax, ymax) are computed, other pixels are set to 0.
+    The region of interest has to be at least barSize pixels away from the image boundary.
+  */
+  void RunningMinMax(MorphPixelType* dest, const MorphPixelType* image, const unsigned int frameSize[2], const unsigned int roi[4],
+                     int barSize, bool horizontal, int columnShiftPerRow, bool erode,
+                     std::vector<MorphPixelType>& prefixBuffer, std::vector<MorphPixelType>& suffixBuffer)
+  {
+    void (*minMaxOfRows)(MorphPixelType*, const MorphPixelType*, const MorphPixelType*, int) = erode ? MinimumOfRows : MaximumOfRows;
+    const int frameWidth = frameSize[0];
+    const int structuringElementLength = 2 * barSize + 1;
+    const int roiWidth = roi[2] - roi[0];
+
+    memset(dest, 0, frameSize[1]*frameSize[0]*sizeof(MorphPixelType));
+
+    if (horizontal)
+    {
+      // Each row is processed independently, the prefix and suffix are computed sequentially along the row
+      // and the combination step is vectorized
+      const int lineLength = roiWidth + 2 * barSize;
+      prefixBuffer.resize(lineLength);
+      suffixBuffer.resize(lineLength);
+      MorphPixelType* prefix = &prefixBuffer[0];
+      MorphPixelType* suffix = &suffixBuffer[0];
+      for (unsigned int ir = roi[1]; ir < roi[3]; ir++)
+      {
+        const MorphPixelType* line = image + ir * frameWidth + roi[0] - barSize;
+        for (int blockStart = 0; blockStart < lineLength; blockStart += structuringElementLength)
+        {
+          int blockEnd = std::min(blockStart + structuringElementLength, lineLength);
+          prefix[blockStart] = line[blockStart];
+          for (int i = blockStart + 1; i < blockEnd; i++)
+          {
+            prefix[i] = erode ? std::min(prefix[i - 1], line[i]) : std::max(prefix[i - 1], line[i]);
+          }
+          suffix[blockEnd - 1] = line[blockEnd - 1];
+          for (int i = blockEnd - 2; i >= blockStart; i--)
+          {
+            suffix[i] = erode ? std::min(suffix[i + 1], line[i]) : std::max(suffix[i + 1], line[i]);
+          }
+        }
+        // output pixel i covers line[i .. i+2*barSize]
+        minMaxOfRows(dest + ir * frameWidth + roi[0], suffix, prefix + 2 * barSize, roiWidth);
+      }
+      return;
+    }
+
+    // Vertical and diagonal structuring elements: the prefix and suffix are computed for a whole row at once,
+    // from the previous (or next) row shifted by columnShiftPerRow, so all the inner loops are row operations.
+    // Columns are extended by barSize on both sides for diagonal elements.
+    const int columnMargin = (columnShiftPerRow != 0) ? barSize : 0;
+    const int firstColumn = roi[0] - columnMargin;
+    const int width = roiWidth + 2 * columnMargin;
+    const int firstRow = roi[1] - barSize;
+    const int numberOfRows = (roi[3] - roi[1]) + 2 * barSize;
+    prefixBuffer.resize(numberOfRows * width);
+    suffixBuffer.resize(numberOfRows * width);
+    MorphPixelType* prefix = &prefixBuffer[0];
+    MorphPixelType* suffix = &suffixBuffer[0];
+
+    // Range of columns that have a predecessor in the computed range: [shiftedStart, shiftedStart+shiftedLength)
+    // The predecessor of the remaining boundary column is outside of the computed range and that column is not used
+    // by any output pixel, so it is just initialized with the image value.
+    const int shiftedStart = std::max(columnShiftPerRow, 0);
+    const int shiftedLength = width - std::abs(columnShiftPerRow);
+    for (int blockStart = 0; blockStart < numberOfRows; blockStart += structuringElementLength)
+    {
+      int blockEnd = std::min(blockStart + structuringElementLength, numberOfRows);
+      memcpy(prefix + blockStart * width, image + (firstRow + blockStart) * frameWidth + firstColumn, width);
+      for (int i = blockStart + 1; i < blockEnd; i++)
+      {
+        const MorphPixelType* imageRow = image + (firstRow + i) * frameWidth + firstColumn;
+        MorphPixelType* prefixRow = prefix + i * width;
+        memcpy(prefixRow, imageRow, width);
+        minMaxOfRows(prefixRow + shiftedStart, prefixRow - width + shiftedStart - columnShiftPerRow, imageRow + shiftedStart, shiftedLength);
+      }
+      memcpy(suffix + (blockEnd - 1) * width, image + (firstRow + blockEnd - 1) * frameWidth + firstColumn, width);
+      for (int i = blockEnd - 2; i >= blockStart; i--)
+      {
+        const MorphPixelType* imageRow = image + (firstRow + i) * frameWidth + firstColumn;
+        MorphPixelType* suffixRow = suffix + i * width;
+        memcpy(suffixRow, imageRow, width);
+        int suffixStart = std::max(-columnShiftPerRow, 0);
+        minMaxOfRows(suffixRow + suffixStart, suffixRow + width + suffixStart + columnShiftPerRow, imageRow + suffixStart, shiftedLength);
+      }
+    }
+
+    // Output pixel (ir, ic) is the min/max of the suffix starting at (ir-barSize, ic-columnShiftPerRow*barSize)
+    // and the prefix ending at (ir+barSize, ic+columnShiftPerRow*barSize)
+    for (unsigned int ir = roi[1]; ir < roi[3]; ir++)
+    {
+      int suffixRowIndex = ir - roi[1];
+      int prefixRowIndex = suffixRowIndex + 2 * barSize;
+      minMaxOfRows(dest + ir * frameWidth + roi[0],
+                   suffix + suffixRowIndex * width + columnMargin - columnShiftPerRow * barSize,
+                   prefix + prefixRowIndex * width + columnMargin + columnShiftPerRow * barSize,
+                   roiWidth);
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 
 PlusFidSegmentation::PlusFidSegmentation()
@@ -76,6 +234,19 @@ PlusFidSegmentation::PlusFidSegmentation()
 
 //-----------------------------------------------------------------------------
 
+PlusFidSegmentation::PlusFidSegmentation( const PlusFidSegmentation& other )
+  : m_Working(new PlusFidSegmentation::PixelType[1])
+  , m_Dilated(new PlusFidSegmentation::PixelType[1])
+  , m_Eroded(new PlusFidSegmentation::PixelType[1])
+  , m_UnalteredImage(new PlusFidSegmentation::PixelType[1])
+{
+  m_FrameSize[0] = 0;
+  m_FrameSize[1] = 0;
+  *this = other;
+}
+
+//-----------------------------------------------------------------------------
+
 PlusFidSegmentation::~PlusFidSegmentation()
 {
   delete[] m_Dilated;
@@ -86,6 +257,70 @@ PlusFidSegmentation::~PlusFidSegmentation()
 
 //-----------------------------------------------------------------------------
 
+PlusFidSegmentation& PlusFidSegmentation::operator=( const PlusFidSegmentation& other )
+{
+  // Handle self-assignment
+  if ( this == &other )
+  {
+    return *this;
+  }
+
+  // Working images, allocated the same way as in SetFrameSize
+  long size = ( ( other.m_FrameSize[0] != 0 ) && ( other.m_FrameSize[1] != 0 ) ) ? other.m_FrameSize[0] * other.m_FrameSize[1] : 1;
+  delete[] m_Dilated;
+  delete[] m_Eroded;
+  delete[] m_Working;
+  delete[] m_UnalteredImage;
+  m_Dilated = new PlusFidSegmentation::PixelType[size];
+  m_Eroded = new PlusFidSegmentation::PixelType[size];
+  m_Working = new PlusFidSegmentation::PixelType[size];
+  m_UnalteredImage = new PlusFidSegmentation::PixelType[size];
+  memcpy( m_Dilated, other.m_Dilated, size * sizeof( PlusFidSegmentation::PixelType ) );
+  memcpy( m_Eroded, other.m_Eroded, size * sizeof( PlusFidSegmentation::PixelType ) );
+  memcpy( m_Working, other.m_Working, size * sizeof( PlusFidSegmentation::PixelType ) );
+  memcpy( m_UnalteredImage, other.m_UnalteredImage, size * sizeof( PlusFidSegmentation::PixelType ) );
+
+  m_FrameSize[0] = other.m_FrameSize[0];
+  m_FrameSize[1] = other.m_FrameSize[1];
+  for ( int i = 0 ; i < 4 ; i++ )
+  {
+    m_RegionOfInterest[i] = other.m_RegionOfInterest[i];
+    m_ImageScalingTolerancePercent[i] = other.m_ImageScalingTolerancePercent[i];
+  }
+  for ( int i = 0 ; i < 3 ; i++ )
+  {
+    m_ImageNormalVectorInPhantomFrameEstimation[i] = other.m_ImageNormalVectorInPhantomFrameEstimation[i];
+  }
+  for ( int i = 0 ; i < 6 ; i++ )
+  {
+    m_ImageNormalVectorInPhantomFrameMaximumRotationAngleDeg[i] = other.m_ImageNormalVectorInPhantomFrameMaximumRotationAngleDeg[i];
+  }
+  for ( int i = 0 ; i < 16 ; i++ )
+  {
+    m_ImageToPhantomTransform[i] = other.m_ImageToPhantomTransform[i];
+  }
+
+  m_UseOriginalImageIntensityForDotIntensityScore = other.m_UseOriginalImageIntensityForDotIntensityScore;
+  m_NumberOfMaximumFiducialPointCandidates = other.m_NumberOfMaximumFiducialPointCandidates;
+  m_ThresholdImagePercent = other.m_ThresholdImagePercent;
+  m_MorphologicalOpeningBarSizeMm = other.m_MorphologicalOpeningBarSizeMm;
+  m_MorphologicalOpeningCircleRadiusMm = other.m_MorphologicalOpeningCircleRadiusMm;
+  m_PossibleFiducialsImageFilename = other.m_PossibleFiducialsImageFilename;
+  m_FiducialGeometry = other.m_FiducialGeometry;
+  m_MorphologicalCircle = other.m_MorphologicalCircle;
+  m_ApproximateSpacingMmPerPixel = other.m_ApproximateSpacingMmPerPixel;
+  m_DotsFound = other.m_DotsFound;
+  m_FoundDotsCoordinateValue = other.m_FoundDotsCoordinateValue;
+  m_NumDots = other.m_NumDots;
+  m_CandidateFidValues = other.m_CandidateFidValues;
+  m_DotsVector = other.m_DotsVector;
+  m_DebugOutput = other.m_DebugOutput;
+
+  return *this;
+}
+
+//-----------------------------------------------------------------------------
+
 void PlusFidSegmentation::UpdateParameters()
 {
   LOG_TRACE("FidSegmentation::UpdateParameters");
@@ -277,87 +512,11 @@ unsigned int PlusFidSegmentation::GetMorphologicalOpeningBarSizePx()
 
 //-----------------------------------------------------------------------------
 
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::ErodePoint0(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::ErodePoint0");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = UCHAR_MAX;
-  unsigned int p = ir * m_FrameSize[0] + ic - barSize; // current pixel - bar size (position of the start of the bar)
-  unsigned int p_max = ir * m_FrameSize[0] + ic + barSize; // current pixel +  bar size (position of the end  of the bar)
-
-  //find lowest intensity in bar shaped area in image
-  for (; p <= p_max; p++)
-  {
-    if (image[p] < dval)
-    {
-      dval = image[p];
-    }
-    if (image[p] == 0)
-    {
-      break;
-    }
-  }
-
-  return dval;
-}
-
-//-----------------------------------------------------------------------------
-
 void PlusFidSegmentation::Erode0(PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image)
 {
   //LOG_TRACE("FidSegmentation::Erode0");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  for (unsigned int ir = m_RegionOfInterest[1]; ir < m_RegionOfInterest[3]; ir++)
-  {
-    unsigned int ic = m_RegionOfInterest[0];
-    unsigned int p_base = ir * m_FrameSize[0];
-
-    PlusFidSegmentation::PixelType dval = ErodePoint0(image, ir, ic);   // find lowest pixel intensity in surrounding region ( positions +/- 8 of current pixel position)
-    dest[p_base + ic] = dval; // p_base+ic = current pixel
-
-    for (ic++; ic < m_RegionOfInterest[2]; ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[p_base + ic + barSize];
-      PlusFidSegmentation::PixelType del_val = image[p_base + ic - 1 - barSize];
-
-      dval = new_val <= dval ? new_val  : // dval = new val if new val is less than or equal to dval
-             del_val > dval ? std::min(dval, new_val) :   // if del val is greater than dval, dval= min of dval and new val
-             ErodePoint0(image, ir, ic);   //else dval = result of erode function
-
-      dest[ir * m_FrameSize[0] + ic] = dval; // update new "eroded" picture
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::ErodePoint45(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::ErodePoint45");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  PlusFidSegmentation::PixelType dval = UCHAR_MAX;
-  unsigned int p = (ir + barSize) * m_FrameSize[0] + ic - barSize;
-  unsigned int p_max = (ir - barSize) * m_FrameSize[0] + ic + barSize;
-
-  for (; p >= p_max; p = p - m_FrameSize[0] + 1)
-  {
-    if (image[p] < dval)
-    {
-      dval = image[p];
-    }
-    if (image[p] == 0)
-    {
-      break;
-    }
-  }
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), true, 0, true, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -366,77 +525,7 @@ void PlusFidSegmentation::Erode45(PlusFidSegmentation::PixelType* dest, PlusFidS
 {
   //LOG_TRACE("FidSegmentation::Erode45");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  /* Down the left side. */
-  for (unsigned int sr = m_RegionOfInterest[1]; sr < m_RegionOfInterest[3]; sr++)
-  {
-    unsigned int ir = sr;
-    unsigned int ic = m_RegionOfInterest[0];
-
-    PlusFidSegmentation::PixelType dval = ErodePoint45(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ir--, ic++; ir >= m_RegionOfInterest[1] && ic < m_RegionOfInterest[2]; ir--, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir - barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir + 1 + barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val <= dval ? new_val :
-             del_val > dval ? std::min(dval, new_val) :
-             ErodePoint45(image, ir, ic);
-
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-
-  /* Across the bottom */
-  for (unsigned int sc = m_RegionOfInterest[0]; sc < m_RegionOfInterest[2]; sc++)
-  {
-    unsigned int ic = sc;
-    unsigned int ir = m_RegionOfInterest[3] - 1;
-
-    PlusFidSegmentation::PixelType dval = ErodePoint45(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ir--, ic++; ir >= m_RegionOfInterest[1] && ic < m_RegionOfInterest[2]; ir--, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir - barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir + 1 + barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val <= dval ? new_val :
-             del_val > dval ? std::min(dval, new_val) :
-             ErodePoint45(image, ir, ic);
-
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::ErodePoint90(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::ErodePoint90");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = UCHAR_MAX;
-  unsigned int p = (ir - barSize) * m_FrameSize[0] + ic;
-  unsigned int p_max = (ir + barSize) * m_FrameSize[0] + ic;
-
-  for (; p <= p_max; p += m_FrameSize[0])
-  {
-    if (image[p] < dval)
-    {
-      dval = image[p];
-    }
-    if (image[p] == 0)
-    {
-      break;
-    }
-  }
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, -1, true, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -445,54 +534,7 @@ void PlusFidSegmentation::Erode90(PlusFidSegmentation::PixelType* dest, PlusFidS
 {
   //LOG_TRACE("FidSegmentation::Erode90");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  for (unsigned int ic = m_RegionOfInterest[0]; ic < m_RegionOfInterest[2]; ic++)
-  {
-    unsigned int ir = m_RegionOfInterest[1];
-
-    PlusFidSegmentation::PixelType dval = ErodePoint90(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ir++; ir < m_RegionOfInterest[3]; ir++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + ic];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + ic];
-
-      dval = new_val <= dval ? new_val :
-             del_val > dval ? std::min(dval, new_val) :
-             ErodePoint90(image, ir, ic);
-
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::ErodePoint135(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::ErodePoint135");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = UCHAR_MAX;
-  unsigned int p = (ir - barSize) * m_FrameSize[0] + ic - barSize;
-  unsigned int p_max = (ir + barSize) * m_FrameSize[0] + ic + barSize;
-
-  for (; p <= p_max; p = p + m_FrameSize[0] + 1)
-  {
-    if (image[p] < dval)
-    {
-      dval = image[p];
-    }
-    if (image[p] == 0)
-    {
-      break;
-    }
-  }
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, 0, true, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -501,53 +543,7 @@ void PlusFidSegmentation::Erode135(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Erode135");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  /* Up the left side. */
-  for (unsigned int sr = m_RegionOfInterest[3] - 1; sr >= m_RegionOfInterest[1]; sr--)
-  {
-    unsigned int ir = sr;
-    unsigned int ic = m_RegionOfInterest[0];
-
-    PlusFidSegmentation::PixelType dval = ErodePoint135(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ir++, ic++; ir < m_RegionOfInterest[3] && ic < m_RegionOfInterest[2]; ir++, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val <= dval ? new_val :
-             del_val > dval ? std::min(dval, new_val) :
-             ErodePoint135(image, ir, ic);
-
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-
-  /* Across the top. */
-  for (unsigned int sc = m_RegionOfInterest[0]; sc < m_RegionOfInterest[2]; sc++)
-  {
-    unsigned int ic = sc;
-    unsigned int ir = m_RegionOfInterest[1];
-
-    PlusFidSegmentation::PixelType dval = ErodePoint135(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ir++, ic++; ir < m_RegionOfInterest[3] && ic < m_RegionOfInterest[2]; ir++, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val <= dval ? new_val :
-             del_val > dval ? std::min(dval, new_val) :
-             ErodePoint135(image, ir, ic);
-
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, 1, true, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -589,86 +585,11 @@ void PlusFidSegmentation::ErodeCircle(PlusFidSegmentation::PixelType* dest, Plus
 
 //-----------------------------------------------------------------------------
 
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::DilatePoint0(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::DilatePoint0");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = 0;
-  unsigned int p = ir * m_FrameSize[0] + ic - barSize;
-  unsigned int p_max = ir * m_FrameSize[0] + ic + barSize;
-
-  for (; p <= p_max; p++)
-  {
-    if (image[p] > dval)
-    {
-      dval = image[p];
-    }
-  }
-
-  return dval;
-}
-
-//-----------------------------------------------------------------------------
-
 void PlusFidSegmentation::Dilate0(PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image)
 {
   //LOG_TRACE("FidSegmentation::Dilate0");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  for (unsigned int ir = m_RegionOfInterest[1]; ir < m_RegionOfInterest[3]; ir++)
-  {
-    unsigned int ic = m_RegionOfInterest[0];
-    unsigned int p_base = ir * m_FrameSize[0];
-
-    PlusFidSegmentation::PixelType dval = DilatePoint0(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-
-    for (ic++; ic < m_RegionOfInterest[2]; ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[p_base + ic + barSize];
-      PlusFidSegmentation::PixelType del_val = image[p_base + ic - 1 - barSize];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint0(image, ir, ic));
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::DilatePoint45(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::DilatePoint45");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = 0;
-  unsigned int p = (ir + barSize) * m_FrameSize[0] + ic - barSize;
-  unsigned int p_max = (ir - barSize) * m_FrameSize[0] + ic + barSize;
-
-  while (p >= p_max)
-  {
-    if (image[p] > dval)
-    {
-      dval = image[p];
-    }
-    if (p - m_FrameSize[0] + 1 > p)
-    {
-      // unsigned int underflow, adjust
-      p = 0;
-    }
-    else
-    {
-      p = p - m_FrameSize[0] + 1;
-    }
-  }
-
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), true, 0, false, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -677,69 +598,7 @@ void PlusFidSegmentation::Dilate45(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Dilate45");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  /* Down the left side. */
-  for (unsigned int sr = m_RegionOfInterest[1]; sr < m_RegionOfInterest[3]; sr++)
-  {
-    unsigned int ir = sr;
-    unsigned int ic = m_RegionOfInterest[0];
-
-    PlusFidSegmentation::PixelType dval = DilatePoint45(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval ;
-    for (ir--, ic++; ir >= m_RegionOfInterest[1] && ic < m_RegionOfInterest[2]; ir--, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir - barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir + 1 + barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint45(image, ir, ic));
-      dest[ir * m_FrameSize[0] + ic] = dval ;
-    }
-  }
-
-  /* Across the bottom */
-  for (unsigned int sc = m_RegionOfInterest[0]; sc < m_RegionOfInterest[2]; sc++)
-  {
-    unsigned int ic = sc;
-    unsigned int ir = m_RegionOfInterest[3] - 1;
-
-    PlusFidSegmentation::PixelType dval = DilatePoint45(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval ;
-    for (ir--, ic++; ir >= m_RegionOfInterest[1] && ic < m_RegionOfInterest[2]; ir--, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir - barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir + 1 + barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint45(image, ir, ic));
-      dest[ir * m_FrameSize[0] + ic] = dval ;
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::DilatePoint90(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::DilatePoint90");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = 0;
-  unsigned int p = (ir - barSize) * m_FrameSize[0] + ic;
-  unsigned int p_max = (ir + barSize) * m_FrameSize[0] + ic;
-
-  for (; p <= p_max; p += m_FrameSize[0])
-  {
-    if (image[p] > dval)
-    {
-      dval = image[p];
-    }
-  }
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, -1, false, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -748,48 +607,7 @@ void PlusFidSegmentation::Dilate90(PlusFidSegmentation::PixelType* dest, PlusFid
 {
   //LOG_TRACE("FidSegmentation::Dilate90");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  for (unsigned int ic = m_RegionOfInterest[0]; ic < m_RegionOfInterest[2]; ic++)
-  {
-    unsigned int ir = m_RegionOfInterest[1];
-
-    PlusFidSegmentation::PixelType dval = DilatePoint90(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval ;
-    for (ir++; ir < m_RegionOfInterest[3]; ir++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + ic];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + ic];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint90(image, ir, ic));
-
-      dest[ir * m_FrameSize[0] + ic] = dval ;
-    }
-  }
-}
-
-//-----------------------------------------------------------------------------
-
-inline PlusFidSegmentation::PixelType PlusFidSegmentation::DilatePoint135(PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic)
-{
-  //LOG_TRACE("FidSegmentation::DilatePoint135");
-
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-  PlusFidSegmentation::PixelType dval = 0;
-  unsigned int p = (ir - barSize) * m_FrameSize[0] + ic - barSize;
-  unsigned int p_max = (ir + barSize) * m_FrameSize[0] + ic + barSize;
-
-  for (; p <= p_max; p = p + m_FrameSize[0] + 1)
-  {
-    if (image[p] > dval)
-    {
-      dval = image[p];
-    }
-  }
-  return dval;
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, 0, false, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
@@ -798,48 +616,7 @@ void PlusFidSegmentation::Dilate135(PlusFidSegmentation::PixelType* dest, PlusFi
 {
   //LOG_TRACE("FidSegmentation::Dilate135");
 
-  memset(dest, 0, m_FrameSize[1]*m_FrameSize[0]*sizeof(PlusFidSegmentation::PixelType));
-  const unsigned int barSize = GetMorphologicalOpeningBarSizePx();
-
-  /* Up the left side. */
-  for (unsigned int sr = m_RegionOfInterest[3] - 1; sr >= m_RegionOfInterest[1]; sr--)
-  {
-    unsigned int ir = sr;
-    unsigned int ic = m_RegionOfInterest[0];
-
-    PlusFidSegmentation::PixelType dval = DilatePoint135(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval ;
-    for (ir++, ic++; ir < m_RegionOfInterest[3] && ic < m_RegionOfInterest[2]; ir++, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint135(image, ir, ic));
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
-
-  /* Across the top. */
-  for (unsigned int sc = m_RegionOfInterest[0]; sc < m_RegionOfInterest[2]; sc++)
-  {
-    unsigned int ic = sc;
-    unsigned int ir = m_RegionOfInterest[1];
-
-    PlusFidSegmentation::PixelType dval = DilatePoint135(image, ir, ic);
-    dest[ir * m_FrameSize[0] + ic] = dval;
-    for (ir++, ic++; ir < m_RegionOfInterest[3] && ic < m_RegionOfInterest[2]; ir++, ic++)
-    {
-      PlusFidSegmentation::PixelType new_val = image[(ir + barSize) * m_FrameSize[0] + (ic + barSize)];
-      PlusFidSegmentation::PixelType del_val = image[(ir - 1 - barSize) * m_FrameSize[0] + (ic - 1 - barSize)];
-
-      dval = new_val >= dval ? new_val :
-             (del_val < dval ? std::max(dval, new_val) :
-              DilatePoint135(image, ir, ic));
-      dest[ir * m_FrameSize[0] + ic] = dval;
-    }
-  }
+  RunningMinMax(dest, image, m_FrameSize, m_RegionOfInterest, GetMorphologicalOpeningBarSizePx(), false, 1, false, m_MorphologyPrefixBuffer, m_MorphologySuffixBuffer);
 }
 
 //-----------------------------------------------------------------------------
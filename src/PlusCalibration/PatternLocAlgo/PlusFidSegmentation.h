@@ -56,6 +56,12 @@ public:
   PlusFidSegmentation();
   virtual ~PlusFidSegmentation();
 
+  /*! Copy constructor. The working image buffers are deep copied, so the copy can be used independently (e.g., in another thread). */
+  PlusFidSegmentation( const PlusFidSegmentation& other );
+
+  /*! Assignment operator. The working image buffers are deep copied. */
+  PlusFidSegmentation& operator=( const PlusFidSegmentation& other );
+
   /* Read the configuration file */
   PlusStatus ReadConfiguration( vtkXMLDataElement* rootConfigElement );
 
@@ -74,22 +80,14 @@ public:
   void ValidateRegionOfInterest();
 
   /*! Morphological operations performed by the algorithm */
-  inline PlusFidSegmentation::PixelType ErodePoint0( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Erode0( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType ErodePoint45( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Erode45( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType ErodePoint90( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Erode90( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType ErodePoint135( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Erode135( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
   void ErodeCircle( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType DilatePoint0( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Dilate0( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType DilatePoint45( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Dilate45( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType DilatePoint90( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Dilate90( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
-  inline PlusFidSegmentation::PixelType DilatePoint135( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic );
   void Dilate135( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
   inline PlusFidSegmentation::PixelType DilatePoint( PlusFidSegmentation::PixelType* image, unsigned int ir, unsigned int ic, PlusCoordinate2D* shape, int slen );
   void DilateCircle( PlusFidSegmentation::PixelType* dest, PlusFidSegmentation::PixelType* image );
@@ -245,6 +243,10 @@ protected:
   std::vector<PlusFidDot> m_DotsVector;
 
   bool m_DebugOutput;
+
+  /*! Scratch buffers of the running min/max computation in the erode and dilate operations (not copied) */
+  std::vector<PlusFidSegmentation::PixelType> m_MorphologyPrefixBuffer;
+  std::vector<PlusFidSegmentation::PixelType> m_MorphologySuffixBuffer;
 };
 
 #endif // _FIDUCIAL_SEGMENTATION_H
@@ -9,13 +9,17 @@ See License.txt for details.
 #include "PlusFidPatternRecognition.h"
 #include "PlusPatternLocResultFile.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusAccurateTimer.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkSmartPointer.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkXMLDataElement.h"
+#include "vtkMultiThreader.h"
+#include "vtkPoints.h"
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx"
 #include <fstream> 
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 
@@ -111,6 +115,90 @@ void SegmentImageSequence( vtkPlusTrackedFrameList* trackedFrameList, std::ofstr
   }
 }
 
+// Remove the segmentation results from all frames, so that they are segmented again by the next RecognizePattern call
+void ClearSegmentationResults(vtkPlusTrackedFrameList* trackedFrameList)
+{
+  for (unsigned int frameIndex=0; frameIndex<trackedFrameList->GetNumberOfTrackedFrames(); frameIndex++)
+  {
+    trackedFrameList->GetTrackedFrame(frameIndex)->SetFiducialPointsCoordinatePx(NULL);
+  }
+}
+
+// Segment the whole sequence in batch mode sequentially and with multiple threads, report throughput
+// and check that the results are identical. Returns the number of differences.
+int BenchmarkBatchSegmentation(vtkPlusTrackedFrameList* trackedFrameList, PlusFidPatternRecognition& patternRecognition, int numberOfThreads)
+{
+  int numberOfFailures=0;
+  const unsigned int numberOfFrames=trackedFrameList->GetNumberOfTrackedFrames();
+  if (numberOfFrames==0)
+  {
+    LOG_ERROR("Cannot run batch segmentation benchmark, the sequence is empty");
+    return 1;
+  }
+  // debug images would dominate the computation time
+  bool debugOutput=patternRecognition.GetFidSegmentation()->GetDebugOutput();
+  patternRecognition.GetFidSegmentation()->SetDebugOutput(false);
+  PlusFidPatternRecognition::PatternRecognitionError error;
+
+  // Sequential batch segmentation, the results are stored as reference
+  ClearSegmentationResults(trackedFrameList);
+  patternRecognition.SetNumberOfThreads(1);
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  patternRecognition.RecognizePattern(trackedFrameList, error);
+  double sequentialTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  std::vector< vtkSmartPointer<vtkPoints> > sequentialResults;
+  for (unsigned int frameIndex=0; frameIndex<numberOfFrames; frameIndex++)
+  {
+    sequentialResults.push_back(trackedFrameList->GetTrackedFrame(frameIndex)->GetFiducialPointsCoordinatePx());
+  }
+
+  // Parallel batch segmentation
+  ClearSegmentationResults(trackedFrameList);
+  patternRecognition.SetNumberOfThreads(numberOfThreads);
+  startTime = vtkPlusAccurateTimer::GetSystemTime();
+  patternRecognition.RecognizePattern(trackedFrameList, error);
+  double parallelTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+  for (unsigned int frameIndex=0; frameIndex<numberOfFrames; frameIndex++)
+  {
+    vtkPoints* sequentialPoints=sequentialResults[frameIndex];
+    vtkPoints* parallelPoints=trackedFrameList->GetTrackedFrame(frameIndex)->GetFiducialPointsCoordinatePx();
+    if (sequentialPoints==NULL || parallelPoints==NULL)
+    {
+      if (sequentialPoints!=parallelPoints)
+      {
+        LOG_ERROR("Frame "<<frameIndex<<": segmentation result is missing in "<<(sequentialPoints==NULL?"sequential":"parallel")<<" batch mode");
+        numberOfFailures++;
+      }
+      continue;
+    }
+    if (sequentialPoints->GetNumberOfPoints()!=parallelPoints->GetNumberOfPoints())
+    {
+      LOG_ERROR("Frame "<<frameIndex<<": number of fiducials mismatch: sequential="<<sequentialPoints->GetNumberOfPoints()<<", parallel="<<parallelPoints->GetNumberOfPoints());
+      numberOfFailures++;
+      continue;
+    }
+    for (vtkIdType pointIndex=0; pointIndex<sequentialPoints->GetNumberOfPoints(); pointIndex++)
+    {
+      double* sequentialPoint=sequentialPoints->GetPoint(pointIndex);
+      double* parallelPoint=parallelPoints->GetPoint(pointIndex);
+      if (sequentialPoint[0]!=parallelPoint[0] || sequentialPoint[1]!=parallelPoint[1])
+      {
+        LOG_ERROR("Frame "<<frameIndex<<": fiducial ["<<pointIndex<<"] mismatch between sequential and parallel batch mode");
+        numberOfFailures++;
+      }
+    }
+  }
+
+  LOG_INFO("Batch segmentation of "<<numberOfFrames<<" frames: sequential "<<std::fixed<<std::setprecision(1)<<numberOfFrames/sequentialTimeSec<<" frames/s, "
+    <<"parallel ("<<(numberOfThreads>0?numberOfThreads:vtkMultiThreader::GetGlobalDefaultNumberOfThreads())<<" threads) "<<numberOfFrames/parallelTimeSec<<" frames/s, "
+    <<"speedup "<<std::setprecision(2)<<sequentialTimeSec/parallelTimeSec);
+
+  ClearSegmentationResults(trackedFrameList);
+  patternRecognition.GetFidSegmentation()->SetDebugOutput(debugOutput);
+  return numberOfFailures;
+}
+
 // return the number of differences
 int CompareSegmentationResults(const std::string& inputBaselineFileName, const std::string& outputTestResultsFileName, PlusFidPatternRecognition& patternRecognition)
 {
@@ -376,6 +464,7 @@ int main(int argc, char **argv)
   std::string outputTestResultsFileName;
   std::string outputFiducialPositionsFileName;
   std::string fiducialGeomString;  
+  int benchmarkThreads=-1;
 
   int verboseLevel=vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
@@ -391,6 +480,7 @@ int main(int argc, char **argv)
   args.AddArgument("--output-fiducial-positions-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputFiducialPositionsFileName, "Name of file for storing fiducial positions in time");
 
   args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Calibration configuration file name");
+  args.AddArgument("--benchmark-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &benchmarkThreads, "If specified then the batch segmentation throughput is measured sequentially and with this many threads (0 = automatic) and the results are compared");
 
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");  
 
@@ -465,5 +555,15 @@ int main(int argc, char **argv)
     }
   }
 
+  if (benchmarkThreads>=0)
+  {
+    LOG_INFO("Benchmark batch segmentation");
+    if (BenchmarkBatchSegmentation(trackedFrameList.GetPointer(), patternRecognition, benchmarkThreads)!=0)
+    {
+      LOG_ERROR("Parallel batch segmentation results differ from the sequential results");
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
@@ -12,6 +12,7 @@ compares the results to a baseline
 
 #include "PlusConfigure.h"
 #include "PlusMath.h"
+#include "vtkPlusAccurateTimer.h"
 #include "vtkPlusLineSegmentationAlgo.h"
 #include "vtkMath.h"
 #include "vtkPlusSequenceIO.h"
@@ -20,6 +21,7 @@ compares the results to a baseline
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx"
 #include "vtksys/SystemTools.hxx"
+#include <iomanip>
 
 const double MAX_ORIGIN_DISTANCE_PIXEL = 10;
 const double MAX_LINE_ANGLE_DIFFERENCE_DEG = 3;
@@ -204,6 +206,33 @@ int CompareLineSegmentationResults( const std::vector<vtkPlusLineSegmentationAlg
   return numberOfFailures;
 }
 
+//----------------------------------------------------------------------------
+// Returns the number of frames where the results are not exactly the same
+int CompareLineSegmentationResultsExact( const std::vector<vtkPlusLineSegmentationAlgo::LineParameters>& lineParameters, const std::vector<vtkPlusLineSegmentationAlgo::LineParameters>& referenceLineParameters )
+{
+  if ( lineParameters.size() != referenceLineParameters.size() )
+  {
+    LOG_ERROR( "Number of frames mismatch: " << lineParameters.size() << " != " << referenceLineParameters.size() );
+    return std::max( lineParameters.size(), referenceLineParameters.size() );
+  }
+  int numberOfDifferences = 0;
+  for ( unsigned int frameIndex = 0; frameIndex < lineParameters.size(); ++frameIndex )
+  {
+    const vtkPlusLineSegmentationAlgo::LineParameters& param = lineParameters[frameIndex];
+    const vtkPlusLineSegmentationAlgo::LineParameters& referenceParam = referenceLineParameters[frameIndex];
+    if ( param.lineDetected != referenceParam.lineDetected
+         || param.lineOriginPoint_Image[0] != referenceParam.lineOriginPoint_Image[0]
+         || param.lineOriginPoint_Image[1] != referenceParam.lineOriginPoint_Image[1]
+         || param.lineDirectionVector_Image[0] != referenceParam.lineDirectionVector_Image[0]
+         || param.lineDirectionVector_Image[1] != referenceParam.lineDirectionVector_Image[1] )
+    {
+      LOG_ERROR( "Line segmentation result mismatch in frame #" << frameIndex );
+      ++numberOfDifferences;
+    }
+  }
+  return numberOfDifferences;
+}
+
 //----------------------------------------------------------------------------
 int main( int argc, char** argv )
 {
@@ -217,6 +246,8 @@ int main( int argc, char** argv )
   std::vector<int> clipRectSize;
   std::string inputBaselineFileName;
   bool saveImages = false;
+  int numberOfThreads = 0;
+  bool compareWithSequential = false;
 
   args.AddArgument( "--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help." );
   args.AddArgument( "--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)" );
@@ -225,6 +256,8 @@ int main( int argc, char** argv )
   args.AddArgument( "--clip-rect-size", vtksys::CommandLineArguments::MULTI_ARGUMENT, &clipRectSize, "Size of the clipping rectangle" );
   args.AddArgument( "--save-images", vtksys::CommandLineArguments::NO_ARGUMENT, &saveImages, "Save images with detected lines overlaid" );
   args.AddArgument( "--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputBaselineFileName, "Input xml baseline file name with path" );
+  args.AddArgument( "--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads used for processing the frames (default: 0 = number of CPUs)" );
+  args.AddArgument( "--compare-with-sequential", vtksys::CommandLineArguments::NO_ARGUMENT, &compareWithSequential, "Run the segmentation on a single thread as well, check that the results are identical and report the computation times" );
 
   if ( !args.Parse() )
   {
@@ -274,16 +307,45 @@ int main( int argc, char** argv )
   lineSegmenter->SetTrackedFrameList( *trackedFrameList );
   lineSegmenter->SetSaveIntermediateImages( saveImages );
   lineSegmenter->SetIntermediateFilesOutputDirectory( vtkPlusConfig::GetInstance()->GetOutputDirectory() );
+  lineSegmenter->SetNumberOfThreads( numberOfThreads );
 
   LOG_DEBUG( "Segment lines" );
+  double segmentationStartTime = vtkPlusAccurateTimer::GetSystemTime();
   if ( lineSegmenter->Update() != PLUS_SUCCESS )
   {
     LOG_ERROR( "Failed to get line positions from video frames" );
     return PLUS_FAIL;
   }
+  double segmentationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - segmentationStartTime;
   std::vector<vtkPlusLineSegmentationAlgo::LineParameters> lineParameters;
   lineSegmenter->GetDetectedLineParameters( lineParameters );
 
+  if ( compareWithSequential )
+  {
+    LOG_DEBUG( "Segment lines on a single thread" );
+    lineSegmenter->SetNumberOfThreads( 1 );
+    double sequentialSegmentationStartTime = vtkPlusAccurateTimer::GetSystemTime();
+    if ( lineSegmenter->Update() != PLUS_SUCCESS )
+    {
+      LOG_ERROR( "Failed to get line positions from video frames on a single thread" );
+      return EXIT_FAILURE;
+    }
+    double sequentialSegmentationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - sequentialSegmentationStartTime;
+    std::vector<vtkPlusLineSegmentationAlgo::LineParameters> sequentialLineParameters;
+    lineSegmenter->GetDetectedLineParameters( sequentialLineParameters );
+
+    LOG_INFO( "Line segmentation of " << trackedFrameList->GetNumberOfTrackedFrames() << " frames: "
+              << std::fixed << std::setprecision( 3 ) << sequentialSegmentationTimeSec << " sec on a single thread, "
+              << segmentationTimeSec << " sec with " << ( numberOfThreads > 0 ? numberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads() ) << " threads" );
+
+    int numberOfDifferences = CompareLineSegmentationResultsExact( lineParameters, sequentialLineParameters );
+    if ( numberOfDifferences > 0 )
+    {
+      LOG_ERROR( "Number of differences between the single and multi-threaded results: " << numberOfDifferences << ". Test failed!" );
+      exit( EXIT_FAILURE );
+    }
+  }
+
   // Save results to file
   std::string resultSaveFilename = vtkPlusConfig::GetInstance()->GetOutputPath( "LineSegmentationResults.xml" );
   LOG_INFO( "Save calibration results to XML file: " << resultSaveFilename );
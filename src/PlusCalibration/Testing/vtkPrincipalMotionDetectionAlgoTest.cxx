@@ -0,0 +1,312 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPrincipalMotionDetectionAlgoTest.cxx
+\brief This test checks that the incremental principal motion estimate matches the batch
+estimate when no forgetting is used and that it follows a change of the motion direction
+when a forgetting factor is set
+*/
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPlusPrincipalMotionDetectionAlgo.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include <algorithm>
+#include <deque>
+
+namespace
+{
+  const double MAX_AXIS_DIRECTION_ERROR = 1e-6;
+  const double MAX_POSITION_ERROR = 1e-6;
+  const double MIN_TRACKED_DIRECTION_DOT_PRODUCT = 0.99;
+  const char PROBE_TO_REFERENCE_TRANSFORM_NAME[] = "ProbeToReference";
+}
+
+//----------------------------------------------------------------------------
+void AddSyntheticFrame(vtkPlusTrackedFrameList* trackedFrameList, double timestamp, const double position[3])
+{
+  vtkSmartPointer<vtkMatrix4x4> probeToReference = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i = 0; i < 3; ++i)
+  {
+    probeToReference->SetElement(i, 3, position[i]);
+  }
+  PlusTrackedFrame trackedFrame;
+  trackedFrame.SetTimestamp(timestamp);
+  PlusTransformName transformName;
+  transformName.SetTransformName(PROBE_TO_REFERENCE_TRANSFORM_NAME);
+  trackedFrame.SetCustomFrameTransform(transformName, probeToReference);
+  trackedFrame.SetCustomFrameTransformStatus(transformName, FIELD_OK);
+  trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME);
+}
+
+//----------------------------------------------------------------------------
+void CreateSyntheticLinearMotion(vtkPlusTrackedFrameList* trackedFrameList)
+{
+  // Sinusoidal motion along a tilted axis with a small deterministic off-axis component
+  double axis[3] = { 1.0, 2.0, 0.5 };
+  vtkMath::Normalize(axis);
+  const int numberOfFrames = 300;
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    double timestamp = 0.01 * frameIndex;
+    double amplitude = 20.0 * sin(2.0 * vtkMath::Pi() * timestamp);
+    double position[3] =
+    {
+      10.0 + amplitude * axis[0] + 0.3 * sin(17.0 * timestamp),
+      -5.0 + amplitude * axis[1] + 0.2 * cos(11.0 * timestamp),
+      30.0 + amplitude * axis[2]
+    };
+    AddSyntheticFrame(trackedFrameList, timestamp, position);
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus GetProbePositions(vtkPlusTrackedFrameList* trackedFrameList, std::deque<itk::Point<double, 3> >& positions)
+{
+  PlusTransformName transformName;
+  if (transformName.SetTransformName(PROBE_TO_REFERENCE_TRANSFORM_NAME) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+  vtkSmartPointer<vtkMatrix4x4> probeToReference = vtkSmartPointer<vtkMatrix4x4>::New();
+  positions.clear();
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    transformRepository->SetTransforms(*trackedFrameList->GetTrackedFrame(frameIndex));
+    bool valid = false;
+    transformRepository->GetTransform(transformName, probeToReference, &valid);
+    if (!valid)
+    {
+      continue;
+    }
+    itk::Point<double, 3> position;
+    position[0] = probeToReference->GetElement(0, 3);
+    position[1] = probeToReference->GetElement(1, 3);
+    position[2] = probeToReference->GetElement(2, 3);
+    positions.push_back(position);
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus TestIncrementalMatchesBatch(vtkPlusTrackedFrameList* trackedFrameList)
+{
+  // Batch estimate
+  vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo> batchAlgo = vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo>::New();
+  batchAlgo->SetTrackerFrames(trackedFrameList);
+  batchAlgo->SetProbeToReferenceTransformName(PROBE_TO_REFERENCE_TRANSFORM_NAME);
+  if (batchAlgo->Update() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Batch principal motion detection failed");
+    return PLUS_FAIL;
+  }
+  std::deque<double> batchTimestamps;
+  std::deque<double> batchPositions;
+  batchAlgo->GetDetectedTimestamps(batchTimestamps);
+  batchAlgo->GetDetectedPositions(batchPositions);
+
+  // The batch axis is computed from the same positions that Update() uses
+  std::deque<itk::Point<double, 3> > probePositions;
+  if (GetProbePositions(trackedFrameList, probePositions) != PLUS_SUCCESS || probePositions.size() < 2)
+  {
+    LOG_ERROR("Not enough valid " << PROBE_TO_REFERENCE_TRANSFORM_NAME << " transforms in the input frames");
+    return PLUS_FAIL;
+  }
+  itk::Point<double, 3> batchAxis;
+  batchAlgo->ComputePrincipalAxis(probePositions, batchAxis, probePositions.size());
+
+  // Incremental estimate without forgetting, fed with the same frames
+  vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo> incrementalAlgo = vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo>::New();
+  incrementalAlgo->SetProbeToReferenceTransformName(PROBE_TO_REFERENCE_TRANSFORM_NAME);
+  if (incrementalAlgo->SetForgettingFactor(1.0) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    if (incrementalAlgo->AddTrackedFrame(*trackedFrameList->GetTrackedFrame(frameIndex)) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameIndex << " to the incremental principal motion estimate");
+      return PLUS_FAIL;
+    }
+  }
+  double incrementalAxis[3] = { 0.0, 0.0, 0.0 };
+  if (incrementalAlgo->GetIncrementalPrincipalAxis(incrementalAxis) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental principal axis is undefined");
+    return PLUS_FAIL;
+  }
+  std::deque<double> incrementalTimestamps;
+  std::deque<double> incrementalPositions;
+  incrementalAlgo->GetDetectedTimestamps(incrementalTimestamps);
+  incrementalAlgo->GetDetectedPositions(incrementalPositions);
+
+  // Eigenvector sign is arbitrary, compare the directions
+  double batchAxisArray[3] = { batchAxis[0], batchAxis[1], batchAxis[2] };
+  double axisDotProduct = vtkMath::Dot(batchAxisArray, incrementalAxis);
+  LOG_INFO("Batch axis: " << batchAxis[0] << " " << batchAxis[1] << " " << batchAxis[2]
+           << ", incremental axis: " << incrementalAxis[0] << " " << incrementalAxis[1] << " " << incrementalAxis[2]);
+  if (fabs(axisDotProduct) < 1.0 - MAX_AXIS_DIRECTION_ERROR)
+  {
+    LOG_ERROR("Incremental principal axis does not match the batch principal axis (|dot product| = " << fabs(axisDotProduct) << ")");
+    return PLUS_FAIL;
+  }
+
+  // Leading samples are not added in incremental mode while the principal axis is undefined (all positions are identical)
+  unsigned int numberOfLeadingIdenticalPositions = 1;
+  while (numberOfLeadingIdenticalPositions < probePositions.size() && probePositions[numberOfLeadingIdenticalPositions] == probePositions[0])
+  {
+    ++numberOfLeadingIdenticalPositions;
+  }
+  unsigned int expectedIncrementalSignalLength = batchTimestamps.size() - numberOfLeadingIdenticalPositions;
+  if (incrementalTimestamps.size() != expectedIncrementalSignalLength || incrementalPositions.size() != incrementalTimestamps.size())
+  {
+    LOG_ERROR("Signal length mismatch: batch " << batchTimestamps.size() << ", incremental " << incrementalTimestamps.size()
+              << " (expected " << expectedIncrementalSignalLength << ")");
+    return PLUS_FAIL;
+  }
+  if (incrementalTimestamps.back() != batchTimestamps.back())
+  {
+    LOG_ERROR("Last timestamp mismatch: batch " << batchTimestamps.back() << ", incremental " << incrementalTimestamps.back());
+    return PLUS_FAIL;
+  }
+
+  // The last incremental sample is projected with the final axis, so it must match the batch value (up to the axis sign)
+  double axisSign = (axisDotProduct < 0 ? -1.0 : 1.0);
+  double positionError = fabs(incrementalPositions.back() - axisSign * batchPositions.back());
+  if (positionError > MAX_POSITION_ERROR * std::max(1.0, fabs(batchPositions.back())))
+  {
+    LOG_ERROR("Last position mismatch: batch " << batchPositions.back() << ", incremental " << incrementalPositions.back());
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus TestDirectionChange()
+{
+  vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo> algo = vtkSmartPointer<vtkPlusPrincipalMotionDetectionAlgo>::New();
+  if (algo->SetForgettingFactor(0.95) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  const unsigned int maximumSignalLength = 50;
+  algo->SetMaximumSignalLength(maximumSignalLength);
+
+  // Move along the X axis first, then along the Y axis
+  const int numberOfSamplesPerDirection = 200;
+  double lastTimestamp = 0.0;
+  for (int sampleIndex = 0; sampleIndex < 2 * numberOfSamplesPerDirection; ++sampleIndex)
+  {
+    lastTimestamp = 0.01 * sampleIndex;
+    double amplitude = 20.0 * sin(2.0 * vtkMath::Pi() * lastTimestamp);
+    double position[3] = { 0.0, 0.0, 0.0 };
+    position[sampleIndex < numberOfSamplesPerDirection ? 0 : 1] = amplitude;
+    if (algo->AddTrackerPosition(lastTimestamp, position) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add sample " << sampleIndex << " to the incremental principal motion estimate");
+      return PLUS_FAIL;
+    }
+  }
+
+  double principalAxis[3] = { 0.0, 0.0, 0.0 };
+  if (algo->GetIncrementalPrincipalAxis(principalAxis) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental principal axis is undefined");
+    return PLUS_FAIL;
+  }
+  LOG_INFO("Principal axis after direction change: " << principalAxis[0] << " " << principalAxis[1] << " " << principalAxis[2]);
+  if (fabs(principalAxis[1]) < MIN_TRACKED_DIRECTION_DOT_PRODUCT)
+  {
+    LOG_ERROR("Incremental principal axis did not follow the change of the motion direction to the Y axis");
+    return PLUS_FAIL;
+  }
+
+  // Only the latest samples are kept in the signal
+  std::deque<double> timestamps;
+  std::deque<double> positions;
+  algo->GetDetectedTimestamps(timestamps);
+  algo->GetDetectedPositions(positions);
+  if (timestamps.size() != maximumSignalLength || positions.size() != maximumSignalLength)
+  {
+    LOG_ERROR("Signal length is " << timestamps.size() << ", expected " << maximumSignalLength);
+    return PLUS_FAIL;
+  }
+  if (timestamps.back() != lastTimestamp)
+  {
+    LOG_ERROR("Signal does not end with the latest sample (" << timestamps.back() << " instead of " << lastTimestamp << ")");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  bool printHelp(false);
+  std::string inputTrackedFrameListFile;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputTrackedFrameListFile, "Tracker sequence file with " + std::string(PROBE_TO_REFERENCE_TRANSFORM_NAME) + " transforms. If not specified then synthetic data is used.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (inputTrackedFrameListFile.empty())
+  {
+    CreateSyntheticLinearMotion(trackedFrameList);
+  }
+  else if (vtkPlusSequenceIO::Read(inputTrackedFrameListFile, trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence metafile: " << inputTrackedFrameListFile);
+    exit(EXIT_FAILURE);
+  }
+
+  int exitStatus = EXIT_SUCCESS;
+  if (TestIncrementalMatchesBatch(trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Incremental vs. batch principal motion detection test failed");
+    exitStatus = EXIT_FAILURE;
+  }
+  if (TestDirectionChange() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Principal motion direction change test failed");
+    exitStatus = EXIT_FAILURE;
+  }
+
+  if (exitStatus == EXIT_SUCCESS)
+  {
+    LOG_INFO("Test completed successfully!");
+  }
+  return exitStatus;
+}
@@ -14,6 +14,7 @@
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
 #include "vtkPlusDataCollector.h"
+#include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkMinimalStandardRandomSequence.h"
 #include "vtkPlusPivotCalibrationAlgo.h"
@@ -27,6 +28,7 @@
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx" 
 #include "vtksys/SystemTools.hxx"
+#include <iomanip>
 #include <iostream>
 #include <stdlib.h>
 
@@ -44,6 +46,8 @@ int main (int argc, char* argv[])
   int numberOfPointsToAcquire=100;
   int verboseLevel=vtkPlusLogger::LOG_LEVEL_UNDEFINED;
   double outlierGenerationProbability=0.0;
+  int onlineReportInterval=0;
+  double onlineRobustWeightingScaleMm=0.0;
 
   vtksys::CommandLineArguments cmdargs;
   cmdargs.Initialize(argc, argv);
@@ -52,6 +56,8 @@ int main (int argc, char* argv[])
   cmdargs.AddArgument("--baseline-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputBaselineFileName, "Name of file storing baseline calibration results");
   cmdargs.AddArgument("--number-of-points-to-acquire", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfPointsToAcquire, "Number of acquired points during the pivot calibration (default: 100)");
   cmdargs.AddArgument("--outlier-generation-probability", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outlierGenerationProbability, "Probability for a point being an outlier. If this number is larger than 0 then some valid measurement points are replaced by randomly generated samples to test the robustness of the algorithm. (range: 0.0-1.0; default: 0.0)");
+  cmdargs.AddArgument("--online-report-interval", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &onlineReportInterval, "If larger than 0 then the online pivot point estimate and RMS error is reported after every N acquired points, and the final online estimate is compared to the result of the calibration (default: 0)");
+  cmdargs.AddArgument("--online-robust-weighting-scale", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &onlineRobustWeightingScaleMm, "Scale of the robust weighting function of the online estimation in mm (default: 0 = no weighting)");
   cmdargs.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");  
 
   if ( !cmdargs.Parse() )
@@ -128,6 +134,10 @@ int main (int argc, char* argv[])
     LOG_ERROR("Unable to read pivot calibration configuration!");
     exit(EXIT_FAILURE);
   }
+  if (onlineRobustWeightingScaleMm > 0)
+  {
+    pivotCalibration->SetOnlineRobustWeightingScaleMm(onlineRobustWeightingScaleMm);
+  }
 
   // Create and initialize transform repository
   PlusTrackedFrame trackedFrame;
@@ -201,6 +211,21 @@ int main (int argc, char* argv[])
     }
 
     pivotCalibration->InsertNextCalibrationPoint(stylusToReferenceMatrix);
+
+    if (onlineReportInterval > 0 && (i + 1) % onlineReportInterval == 0)
+    {
+      if (pivotCalibration->GetOnlineEstimateValid())
+      {
+        double* onlinePivotPoint_Marker = pivotCalibration->GetOnlinePivotPointPosition_Marker();
+        LOG_INFO("Online estimate after " << i + 1 << " points: pivot point = " << std::fixed << std::setprecision(3)
+          << onlinePivotPoint_Marker[0] << " x " << onlinePivotPoint_Marker[1] << " x " << onlinePivotPoint_Marker[2]
+          << ", RMS error = " << pivotCalibration->GetOnlineCalibrationRmsError() << " mm");
+      }
+      else
+      {
+        LOG_INFO("Online estimate after " << i + 1 << " points: not available yet");
+      }
+    }
   }
   vtkPlusLogger::PrintProgressbar(100.0); 
 
@@ -218,6 +243,29 @@ int main (int argc, char* argv[])
   LOG_INFO("Number of detected outliers: "<<pivotCalibration->GetNumberOfDetectedOutliers());
   LOG_INFO("Mean calibration error: "<<pivotCalibration->GetCalibrationError()<<" mm");
 
+  if (onlineReportInterval > 0)
+  {
+    if (!pivotCalibration->GetOnlineEstimateValid())
+    {
+      LOG_ERROR("Online pivot point estimate is not available");
+      exit(EXIT_FAILURE);
+    }
+    double* onlinePivotPoint_Marker = pivotCalibration->GetOnlinePivotPointPosition_Marker();
+    double pivotPoint_Marker[3] = {0};
+    for (int i = 0; i < 3; i++)
+    {
+      pivotPoint_Marker[i] = pivotCalibration->GetPivotPointToMarkerTransformMatrix()->GetElement(i, 3);
+    }
+    double onlineDifferenceMm = sqrt(vtkMath::Distance2BetweenPoints(onlinePivotPoint_Marker, pivotPoint_Marker));
+    LOG_INFO("Difference between the online estimate and the calibration result: " << onlineDifferenceMm << " mm");
+    // Outliers that are inserted before the first online estimate cannot be suppressed, so the difference is only checked if there are no outliers
+    if (numberOfOutliers == 0 && onlineDifferenceMm > TRANSLATION_ERROR_THRESHOLD)
+    {
+      LOG_ERROR("Online pivot point estimate differs from the calibration result by " << onlineDifferenceMm << " mm (threshold: " << TRANSLATION_ERROR_THRESHOLD << " mm)");
+      exit(EXIT_FAILURE);
+    }
+  }
+
   // Save result
   if (transformRepository->WriteConfiguration(configRootElement) != PLUS_SUCCESS )
   {
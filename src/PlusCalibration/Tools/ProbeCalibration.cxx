@@ -18,6 +18,7 @@ compares the results to a baseline
 #include "vtkCommand.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkPlusHTMLGenerator.h"
 #include "vtkPlusProbeCalibrationAlgo.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkSmartPointer.h"
@@ -39,6 +40,7 @@ const double ERROR_THRESHOLD = 0.05;
 #endif
 
 int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const char* currentResultFileName, double translationErrorThreshold, double rotationErrorThreshold);
+int CheckCrossValidationResults(vtkPlusProbeCalibrationAlgo* calibration, vtkPlusProbeCalibrationAlgo::CrossValidationMethodType method, int numberOfFolds, double errorThreshold);
 
 int main(int argc, char* argv[])
 {
@@ -59,6 +61,14 @@ int main(int argc, char* argv[])
   double inputRotationErrorThreshold(1e-10);
 #endif
 
+  std::string minimizer;
+  int numberOfStarts = 0;
+  int numberOfThreads = -1;
+
+  std::string crossValidationMethod;
+  int crossValidationFolds = 10;
+  double crossValidationErrorThreshold = -1.0;
+
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
   vtksys::CommandLineArguments args;
@@ -77,6 +87,14 @@ int main(int argc, char* argv[])
 
   args.AddArgument("--output-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &resultConfigFileName, "Result configuration file name. Optional.");
 
+  args.AddArgument("--minimizer", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &minimizer, "Minimizer used for optimization (POWELL or LEVENBERG_MARQUARDT). Optional, overrides the value in the configuration file.");
+  args.AddArgument("--number-of-starts", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfStarts, "Number of optimization starts. Optional, overrides the value in the configuration file.");
+  args.AddArgument("--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads used for optimization (0 = number of processors). Optional, overrides the value in the configuration file.");
+
+  args.AddArgument("--cross-validation-method", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &crossValidationMethod, "Evaluate calibration precision by cross-validation on the calibration data set (K_FOLD, LEAVE_ONE_OUT, or BOOTSTRAP) and save an HTML report. Optional.");
+  args.AddArgument("--cross-validation-folds", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &crossValidationFolds, "Number of folds (K_FOLD) or samples (BOOTSTRAP) for cross-validation. Default: 10.");
+  args.AddArgument("--cross-validation-error-threshold", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &crossValidationErrorThreshold, "Maximum allowed 3D reprojection error of the held out frames of each cross-validation fold in mm. Optional, if specified then the number of folds and the reported errors are checked.");
+
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
 
   if (!args.Parse())
@@ -115,6 +133,30 @@ int main(int argc, char* argv[])
 
   vtkSmartPointer<vtkPlusProbeCalibrationAlgo> freehandCalibration = vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New();
   freehandCalibration->ReadConfiguration(configRootElement);
+  if (!minimizer.empty())
+  {
+    if (PlusCommon::IsEqualInsensitive(minimizer, vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_POWELL)))
+    {
+      freehandCalibration->GetOptimizer()->SetMinimizer(vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_POWELL);
+    }
+    else if (PlusCommon::IsEqualInsensitive(minimizer, vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_LEVENBERG_MARQUARDT)))
+    {
+      freehandCalibration->GetOptimizer()->SetMinimizer(vtkPlusProbeCalibrationOptimizerAlgo::MINIMIZER_LEVENBERG_MARQUARDT);
+    }
+    else
+    {
+      LOG_ERROR("Invalid minimizer: " << minimizer);
+      return EXIT_FAILURE;
+    }
+  }
+  if (numberOfStarts > 0)
+  {
+    freehandCalibration->GetOptimizer()->SetNumberOfStarts(numberOfStarts);
+  }
+  if (numberOfThreads >= 0)
+  {
+    freehandCalibration->GetOptimizer()->SetNumberOfThreads(numberOfThreads);
+  }
 
   PlusFidPatternRecognition patternRecognition;
   PlusFidPatternRecognition::PatternRecognitionError error;
@@ -180,6 +222,50 @@ int main(int argc, char* argv[])
     }
   }
 
+  if (!crossValidationMethod.empty())
+  {
+    vtkPlusProbeCalibrationAlgo::CrossValidationMethodType method = vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_K_FOLD;
+    if (PlusCommon::IsEqualInsensitive(crossValidationMethod, vtkPlusProbeCalibrationAlgo::GetCrossValidationMethodAsString(vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_K_FOLD)))
+    {
+      method = vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_K_FOLD;
+    }
+    else if (PlusCommon::IsEqualInsensitive(crossValidationMethod, vtkPlusProbeCalibrationAlgo::GetCrossValidationMethodAsString(vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_LEAVE_ONE_OUT)))
+    {
+      method = vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_LEAVE_ONE_OUT;
+    }
+    else if (PlusCommon::IsEqualInsensitive(crossValidationMethod, vtkPlusProbeCalibrationAlgo::GetCrossValidationMethodAsString(vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_BOOTSTRAP)))
+    {
+      method = vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_BOOTSTRAP;
+    }
+    else
+    {
+      LOG_ERROR("Invalid cross-validation method: " << crossValidationMethod);
+      return EXIT_FAILURE;
+    }
+
+    LOG_INFO("Cross-validate...");
+    if (freehandCalibration->CrossValidate(method, crossValidationFolds, (numberOfThreads > 0 ? numberOfThreads : 0)) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Cross-validation failed!");
+      return EXIT_FAILURE;
+    }
+    if (crossValidationErrorThreshold > 0 && CheckCrossValidationResults(freehandCalibration, method, crossValidationFolds, crossValidationErrorThreshold) != 0)
+    {
+      LOG_ERROR("Cross-validation results are invalid");
+      return EXIT_FAILURE;
+    }
+
+    vtkSmartPointer<vtkPlusHTMLGenerator> htmlGenerator = vtkSmartPointer<vtkPlusHTMLGenerator>::New();
+    htmlGenerator->SetBaseFilename("ProbeCalibrationCrossValidationReport");
+    htmlGenerator->SetTitle("Probe Calibration Cross-Validation Report");
+    if (freehandCalibration->GenerateCrossValidationReport(htmlGenerator) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to generate cross-validation report!");
+      return EXIT_FAILURE;
+    }
+    LOG_INFO("Cross-validation report: " << htmlGenerator->SaveHtmlPageAutoFilename());
+  }
+
   // Save result to configuration file
   if (!resultConfigFileName.empty())
   {
@@ -214,6 +300,79 @@ int main(int argc, char* argv[])
 
 //-------------------------------------------------------------------------------------------------
 
+// return the number of failed checks
+int CheckCrossValidationResults(vtkPlusProbeCalibrationAlgo* calibration, vtkPlusProbeCalibrationAlgo::CrossValidationMethodType method, int numberOfFolds, double errorThreshold)
+{
+  int numberOfFailures = 0;
+
+  std::vector<double> foldErrorMeans;
+  calibration->GetCrossValidationFoldReprojectionError3DMeans(foldErrorMeans);
+  const int numberOfEvaluatedFolds = foldErrorMeans.size();
+  switch (method)
+  {
+  case vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_K_FOLD:
+    // Each fold holds out a block of frames, so all of them must be evaluated
+    if (numberOfEvaluatedFolds != numberOfFolds)
+    {
+      LOG_ERROR("Number of evaluated cross-validation folds is " << numberOfEvaluatedFolds << ", expected " << numberOfFolds);
+      ++numberOfFailures;
+    }
+    break;
+  case vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_LEAVE_ONE_OUT:
+    // One fold for each calibration frame
+    if (numberOfEvaluatedFolds < 2)
+    {
+      LOG_ERROR("Number of evaluated cross-validation folds is " << numberOfEvaluatedFolds << ", expected one for each calibration frame");
+      ++numberOfFailures;
+    }
+    break;
+  case vtkPlusProbeCalibrationAlgo::CROSS_VALIDATION_BOOTSTRAP:
+    // Samples that happen to draw all frames have no held out frames and are not evaluated
+    if (numberOfEvaluatedFolds < 1 || numberOfEvaluatedFolds > numberOfFolds)
+    {
+      LOG_ERROR("Number of evaluated cross-validation samples is " << numberOfEvaluatedFolds << ", expected between 1 and " << numberOfFolds);
+      ++numberOfFailures;
+    }
+    break;
+  }
+
+  for (int foldIndex = 0; foldIndex < numberOfEvaluatedFolds; ++foldIndex)
+  {
+    if (!(foldErrorMeans[foldIndex] > 0.0 && foldErrorMeans[foldIndex] <= errorThreshold))
+    {
+      LOG_ERROR("3D reprojection error of cross-validation fold " << foldIndex << " is " << foldErrorMeans[foldIndex] << "mm, expected between 0 and " << errorThreshold << "mm");
+      ++numberOfFailures;
+    }
+  }
+
+  const double errorMean = calibration->GetCrossValidationReprojectionError3DMean();
+  if (!(errorMean > 0.0 && errorMean <= errorThreshold) || !(calibration->GetCrossValidationReprojectionError3DStdDev() >= 0.0))
+  {
+    LOG_ERROR("Cross-validation 3D reprojection error is " << errorMean << "mm (stddev: " << calibration->GetCrossValidationReprojectionError3DStdDev()
+              << "mm), expected a mean between 0 and " << errorThreshold << "mm");
+    ++numberOfFailures;
+  }
+
+  double confidenceIntervalLower = 0.0;
+  double confidenceIntervalUpper = 0.0;
+  calibration->GetCrossValidationReprojectionError3DConfidenceInterval(confidenceIntervalLower, confidenceIntervalUpper);
+  if (numberOfEvaluatedFolds > 0)
+  {
+    double foldErrorMean = 0.0;
+    double foldErrorStdev = 0.0;
+    PlusMath::ComputeMeanAndStdev(foldErrorMeans, foldErrorMean, foldErrorStdev);
+    if (!(confidenceIntervalLower <= foldErrorMean && foldErrorMean <= confidenceIntervalUpper))
+    {
+      LOG_ERROR("Cross-validation confidence interval [" << confidenceIntervalLower << "mm, " << confidenceIntervalUpper << "mm] does not contain the mean fold error " << foldErrorMean << "mm");
+      ++numberOfFailures;
+    }
+  }
+
+  return numberOfFailures;
+}
+
+//-------------------------------------------------------------------------------------------------
+
 // return the number of differences
 int CompareCalibrationResultsWithBaseline(const char* baselineFileName, const char* currentResultFileName, double translationErrorThreshold, double rotationErrorThreshold)
 {
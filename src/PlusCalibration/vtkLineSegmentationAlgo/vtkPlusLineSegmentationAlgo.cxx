@@ -15,10 +15,8 @@ See License.txt for details.
 
 // ITK includes
 #include <itkBinaryThresholdImageFilter.h>
-#include <itkImageDuplicator.h>
 #include <itkImageFileWriter.h>
 #include <itkImageRegionIterator.h>
-#include <itkLineIterator.h>
 #include <itkOtsuThresholdImageFilter.h>
 #include <itkRGBPixel.h>
 #include <itkResampleImageFilter.h>
@@ -29,7 +27,9 @@ See License.txt for details.
 #include <vtkContextScene.h>
 #include <vtkContextView.h>
 #include <vtkDoubleArray.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include <vtkPen.h>
 #include <vtkPlot.h>
@@ -55,6 +55,18 @@ enum PEAK_POS_METRIC_TYPE
 };
 const PEAK_POS_METRIC_TYPE PEAK_POS_METRIC = PEAK_POS_COG;
 
+namespace
+{
+  struct SegmentLinesThreadFunctionInfoStruct
+  {
+    vtkPlusLineSegmentationAlgo* Algo;
+    std::vector<unsigned int> FrameNumbers;
+    // Results, indexed the same way as FrameNumbers. Each thread only writes its own items.
+    std::vector<char> LineDetected;
+    std::vector<double> SignalValues;
+  };
+}
+
 vtkStandardNewMacro(vtkPlusLineSegmentationAlgo);
 
 //----------------------------------------------------------------------------
@@ -69,6 +81,7 @@ vtkPlusLineSegmentationAlgo::vtkPlusLineSegmentationAlgo()
   , m_SaveIntermediateImages(false)
   , IntermediateFilesOutputDirectory("")
   , PlotIntensityProfile(false)
+  , NumberOfThreads(0)
   , m_SignalTimeRangeMin(0.0)
   , m_SignalTimeRangeMax(-1.0)
 {
@@ -193,204 +206,249 @@ PlusStatus vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric()
   nonDetectedLineParams.lineDirectionVector_Image[1] = 1;
   m_LineParameters.assign(m_TrackedFrameList->GetNumberOfTrackedFrames(), nonDetectedLineParams);
 
-  //  For each video frame, detect line and extract mindpoint and slope parameters
-  int numberOfSuccessfulLineSegmentations = 0;
+  SegmentLinesThreadFunctionInfoStruct str;
+  str.Algo = this;
   bool signalTimeRangeDefined = (m_SignalTimeRangeMin <= m_SignalTimeRangeMax);
   for (unsigned int frameNumber = 0; frameNumber < m_TrackedFrameList->GetNumberOfTrackedFrames(); ++frameNumber)
   {
-    LOG_TRACE("Calculating video position metric for frame " << frameNumber);
     PlusTrackedFrame* trackedFrame = m_TrackedFrameList->GetTrackedFrame(frameNumber);
     if (signalTimeRangeDefined && (trackedFrame->GetTimestamp() < m_SignalTimeRangeMin || trackedFrame->GetTimestamp() > m_SignalTimeRangeMax))
     {
       // frame is out of the specified signal range
-      LOG_TRACE("Skip frame, it is out of the valid signal range");
+      LOG_TRACE("Skip frame " << frameNumber << ", it is out of the valid signal range");
       continue;
     }
+    str.FrameNumbers.push_back(frameNumber);
+  }
+  str.LineDetected.assign(str.FrameNumbers.size(), 0);
+  str.SignalValues.assign(str.FrameNumbers.size(), 0.0);
 
-    // Get current image
-    if (trackedFrame->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
-    {
-      LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric only supports 8-bit images");
-      continue;
-    }
-    CharImageType::Pointer localImage = CharImageType::New();
-    PlusVideoFrame::DeepCopyVtkVolumeToItkImage<CharPixelType>(trackedFrame->GetImageData()->GetImage(), localImage);
-    if (localImage.IsNull())
+  //  For each video frame, detect line and extract mindpoint and slope parameters
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (m_SaveIntermediateImages || this->PlotIntensityProfile)
+  {
+    // saving images and plotting are not thread-safe
+    threader->SetNumberOfThreads(1);
+  }
+  else if (this->NumberOfThreads > 0)
+  {
+    threader->SetNumberOfThreads(this->NumberOfThreads);
+  }
+  threader->SetSingleMethod(SegmentLinesThreadFunction, &str);
+  threader->SingleMethodExecute();
+
+  // Collect the results in frame order
+  int numberOfSuccessfulLineSegmentations = 0;
+  for (unsigned int i = 0; i < str.FrameNumbers.size(); ++i)
+  {
+    if (!str.LineDetected[i])
     {
-      // Dropped frame
-      LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric failed to retrieve image data from frame");
       continue;
     }
+    ++numberOfSuccessfulLineSegmentations;
+    m_SignalValues.push_back(str.SignalValues[i]);
+    m_SignalTimestamps.push_back(m_TrackedFrameList->GetTrackedFrame(str.FrameNumbers[i])->GetTimestamp());
+  }
 
-    // Create an image duplicator to copy the original image
-    typedef itk::ImageDuplicator<CharImageType> DuplicatorType;
-    DuplicatorType::Pointer duplicator = DuplicatorType::New();
-    CharImageType::Pointer scanlineImage;
-    if (m_SaveIntermediateImages == true)
-    {
-      duplicator->SetInputImage(localImage);
-      duplicator->Update();
-
-      // Create an image copy to draw the scanlines on
-      scanlineImage = duplicator->GetOutput();
-    }
+  double segmentationSuccessRate = double(numberOfSuccessfulLineSegmentations) / m_TrackedFrameList->GetNumberOfTrackedFrames();
+  if (segmentationSuccessRate < EXPECTED_LINE_SEGMENTATION_SUCCESS_RATE)
+  {
+    LOG_WARNING("Line segmentation success rate is very low (" << segmentationSuccessRate * 100 << "%): a line could only be detected on " << numberOfSuccessfulLineSegmentations << " frames out of " << m_TrackedFrameList->GetNumberOfTrackedFrames());
+  }
 
-    std::vector<itk::Point<double, 2> > intensityPeakPositions;
-    CharImageType::RegionType region = localImage->GetLargestPossibleRegion();
-    LimitToClipRegion(region);
+  bool plotVideoMetric = vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE;
+  if (plotVideoMetric)
+  {
+    PlotDoubleArray(m_SignalValues);
+  }
 
-    int numOfValidScanlines = 0;
+  return PLUS_SUCCESS;
 
-    for (int currScanlineNum = 0; currScanlineNum < NUMBER_OF_SCANLINES; ++currScanlineNum)
-    {
-      // Set the scanline start pixel
-      CharImageType::IndexType startPixel;
-      double scanlineSpacingPix = static_cast<double>(region.GetSize()[0] - 1) / (NUMBER_OF_SCANLINES - 1);
-      startPixel[0] = region.GetIndex()[0] + scanlineSpacingPix * (currScanlineNum);
-      startPixel[1] = region.GetIndex()[1];
-
-      // Set the scanline end pixel
-      CharImageType::IndexType endPixel;
-      endPixel[0] = startPixel[0];
-      endPixel[1] = startPixel[1] + region.GetSize()[1] - 1;
-
-      std::deque<int> intensityProfile; // Holds intensity profile of the line
-      itk::LineIterator<CharImageType> it(localImage, startPixel, endPixel);
-      it.GoToBegin();
-
-      itk::LineIterator<CharImageType>* itScanlineImage = NULL;
-      if (m_SaveIntermediateImages == true)
-      {
-        // Iterator for the scanline image copy
-        // it's time-consuming to instantiate this iterator, so only do it if intermediate image saving is requested
-        itScanlineImage = new itk::LineIterator<CharImageType>(scanlineImage, startPixel, endPixel);
-        itScanlineImage->GoToBegin();
-      }
+} //  End LineDetection
 
-      while (!it.IsAtEnd())
-      {
-        intensityProfile.push_back((int)it.Get());
-        if (m_SaveIntermediateImages == true)
-        {
-          // Set the pixels on the scanline image copy to white
-          itScanlineImage->Set(255);
-          ++(*itScanlineImage);
-        }
-        ++it;
-      }
+//-----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusLineSegmentationAlgo::SegmentLinesThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SegmentLinesThreadFunctionInfoStruct* str = static_cast<SegmentLinesThreadFunctionInfoStruct*>(threadInfo->UserData);
 
-      // Delete the iterator declared with new()
-      if (itScanlineImage != NULL)
-      {
-        delete itScanlineImage;
-        itScanlineImage = NULL;
-      }
+  // Frames are distributed among the threads in an interleaved way, as the processing time is similar for all frames
+  std::vector<int> intensityProfile;
+  for (unsigned int i = threadInfo->ThreadID; i < str->FrameNumbers.size(); i += threadInfo->NumberOfThreads)
+  {
+    unsigned int frameNumber = str->FrameNumbers[i];
+    LOG_TRACE("Calculating video position metric for frame " << frameNumber);
+    LineParameters params;
+    double signalValue = 0.0;
+    if (str->Algo->SegmentLineOnFrame(frameNumber, intensityProfile, params, signalValue))
+    {
+      str->Algo->m_LineParameters[frameNumber] = params;
+      str->SignalValues[i] = signalValue;
+      str->LineDetected[i] = 1;
+    }
+  }
 
-      if (this->PlotIntensityProfile)
-      {
-        // Plot the intensity profile
-        PlotIntArray(intensityProfile);
-      }
+  return VTK_THREAD_RETURN_VALUE;
+}
 
-      // Find the max intensity value from the peak with the largest area
-      int maxFromLargestArea = -1;
-      int maxFromLargestAreaIndex = -1;
-      int startOfMaxArea = -1;
-      if (FindLargestPeak(intensityProfile, maxFromLargestArea, maxFromLargestAreaIndex, startOfMaxArea) == PLUS_SUCCESS)
-      {
-        double currPeakPos_y = -1;
-        switch (PEAK_POS_METRIC)
-        {
-        case PEAK_POS_COG:
-        {
-          /* Use center-of-gravity (COG) as peak-position metric*/
-          if (ComputeCenterOfGravity(intensityProfile, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
-          {
-            // unable to compute center-of-gravity; this scanline is invalid
-            continue;
-          }
-          break;
-        }
-        case PEAK_POS_START:
-        {
-          /* Use peak start as peak-position metric*/
-          if (FindPeakStart(intensityProfile, maxFromLargestArea, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
-          {
-            // unable to compute peak start; this scanline is invalid
-            continue;
-          }
-          break;
-        }
-        }
+//-----------------------------------------------------------------------------
+bool vtkPlusLineSegmentationAlgo::SegmentLineOnFrame(unsigned int frameNumber, std::vector<int>& intensityProfile, LineParameters& params, double& signalValue)
+{
+  PlusTrackedFrame* trackedFrame = m_TrackedFrameList->GetTrackedFrame(frameNumber);
 
-        itk::Point<double, 2> currPeakPos;
-        currPeakPos[0] = static_cast<double>(startPixel[0]);
-        currPeakPos[1] = startPixel[1] + currPeakPos_y;
-        intensityPeakPositions.push_back(currPeakPos);
-        ++numOfValidScanlines;
+  // Get current image
+  if (trackedFrame->GetImageData()->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+  {
+    LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric only supports 8-bit images");
+    return false;
+  }
+  vtkImageData* frameImage = trackedFrame->GetImageData()->GetImage();
+  if (frameImage == NULL || frameImage->GetScalarPointer() == NULL)
+  {
+    // Dropped frame
+    LOG_ERROR("vtkPlusLineSegmentationAlgo::ComputeVideoPositionMetric failed to retrieve image data from frame");
+    return false;
+  }
 
-      } // end if() found intensity peak
+  // The scanlines are read directly from the frame buffer
+  int extent[6] = {0, 0, 0, 0, 0, 0};
+  frameImage->GetExtent(extent);
+  vtkIdType increments[3] = {0, 0, 0};
+  frameImage->GetIncrements(increments);
+  const CharPixelType* framePixels = static_cast<const CharPixelType*>(frameImage->GetScalarPointer());
+
+  CharImageType::IndexType frameOrigin;
+  frameOrigin[0] = 0;
+  frameOrigin[1] = 0;
+  CharImageType::SizeType frameSize;
+  frameSize[0] = extent[1] - extent[0] + 1;
+  frameSize[1] = extent[3] - extent[2] + 1;
+  CharImageType::RegionType region;
+  region.SetIndex(frameOrigin);
+  region.SetSize(frameSize);
+  LimitToClipRegion(region);
+
+  CharImageType::Pointer scanlineImage;
+  if (m_SaveIntermediateImages == true)
+  {
+    // Create an image copy to draw the scanlines on
+    scanlineImage = CharImageType::New();
+    PlusVideoFrame::DeepCopyVtkVolumeToItkImage<CharPixelType>(frameImage, scanlineImage);
+  }
 
-    } // end currScanlineNum loop
+  std::vector<itk::Point<double, 2> > intensityPeakPositions;
+  int numOfValidScanlines = 0;
 
-    if (numOfValidScanlines < MINIMUM_NUMBER_OF_VALID_SCANLINES)
+  for (int currScanlineNum = 0; currScanlineNum < NUMBER_OF_SCANLINES; ++currScanlineNum)
+  {
+    // Set the scanline start pixel
+    CharImageType::IndexType startPixel;
+    double scanlineSpacingPix = static_cast<double>(region.GetSize()[0] - 1) / (NUMBER_OF_SCANLINES - 1);
+    startPixel[0] = region.GetIndex()[0] + scanlineSpacingPix * (currScanlineNum);
+    startPixel[1] = region.GetIndex()[1];
+
+    // Copy the intensity profile of the vertical scanline into a contiguous array
+    intensityProfile.resize(region.GetSize()[1]);
+    const CharPixelType* scanlinePixel = framePixels + startPixel[0] * increments[0] + startPixel[1] * increments[1];
+    for (unsigned int i = 0; i < intensityProfile.size(); ++i, scanlinePixel += increments[1])
     {
-      //TODO: drop the frame from the analysis
-      LOG_DEBUG("Only " << numOfValidScanlines << " valid scanlines; this is less than the required " << MINIMUM_NUMBER_OF_VALID_SCANLINES << ". Skipping frame" << frameNumber);
+      intensityProfile[i] = *scanlinePixel;
     }
 
-    LineParameters params;
-    ComputeLineParameters(intensityPeakPositions, params);
-    if (!params.lineDetected)
+    if (m_SaveIntermediateImages == true)
     {
-      LOG_DEBUG("Unable to compute line parameters for frame " << frameNumber);
-      continue;
+      // Set the pixels on the scanline image copy to white
+      CharImageType::IndexType scanlineImagePixel = startPixel;
+      for (unsigned int i = 0; i < intensityProfile.size(); ++i, ++scanlineImagePixel[1])
+      {
+        scanlineImage->SetPixel(scanlineImagePixel, 255);
+      }
     }
-    if (params.lineDirectionVector_Image[0] < MIN_X_SLOPE_COMPONENT_FOR_DETECTED_LINE)
+
+    if (this->PlotIntensityProfile)
     {
-      // Line is close to vertical, skip frame because intersection of
-      // line with image's horizontal half point is unstable
-      LOG_TRACE("Line on frame " << frameNumber << " is too close to vertical, skip the frame");
-      continue;
+      // Plot the intensity profile
+      PlotIntArray(intensityProfile);
     }
 
-    ++numberOfSuccessfulLineSegmentations;
-    m_LineParameters[frameNumber] = params;
-
-    // Store the y-value of the line, when the line's x-value is half of the image's width
-    double t = (region.GetIndex()[0] + 0.5 * region.GetSize()[0] - params.lineOriginPoint_Image[0]) / params.lineDirectionVector_Image[0];
-    m_SignalValues.push_back(std::abs(params.lineOriginPoint_Image[1] + t * params.lineDirectionVector_Image[1]));
+    // Find the max intensity value from the peak with the largest area
+    int maxFromLargestArea = -1;
+    int maxFromLargestAreaIndex = -1;
+    int startOfMaxArea = -1;
+    if (FindLargestPeak(intensityProfile, maxFromLargestArea, maxFromLargestAreaIndex, startOfMaxArea) == PLUS_SUCCESS)
+    {
+      double currPeakPos_y = -1;
+      switch (PEAK_POS_METRIC)
+      {
+      case PEAK_POS_COG:
+      {
+        /* Use center-of-gravity (COG) as peak-position metric*/
+        if (ComputeCenterOfGravity(intensityProfile, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
+        {
+          // unable to compute center-of-gravity; this scanline is invalid
+          continue;
+        }
+        break;
+      }
+      case PEAK_POS_START:
+      {
+        /* Use peak start as peak-position metric*/
+        if (FindPeakStart(intensityProfile, maxFromLargestArea, startOfMaxArea, currPeakPos_y) != PLUS_SUCCESS)
+        {
+          // unable to compute peak start; this scanline is invalid
+          continue;
+        }
+        break;
+      }
+      }
 
-    //  Store timestamp for image frame
-    m_SignalTimestamps.push_back(m_TrackedFrameList->GetTrackedFrame(frameNumber)->GetTimestamp());
+      itk::Point<double, 2> currPeakPos;
+      currPeakPos[0] = static_cast<double>(startPixel[0]);
+      currPeakPos[1] = startPixel[1] + currPeakPos_y;
+      intensityPeakPositions.push_back(currPeakPos);
+      ++numOfValidScanlines;
 
-    if (m_SaveIntermediateImages == true)
-    {
-      SaveIntermediateImage(frameNumber, scanlineImage,
-                            params.lineOriginPoint_Image[0], params.lineOriginPoint_Image[1], params.lineDirectionVector_Image[0], params.lineDirectionVector_Image[1],
-                            numOfValidScanlines, intensityPeakPositions);
-    }
+    } // end if() found intensity peak
 
-  } // end frameNum loop
+  } // end currScanlineNum loop
 
-  double segmentationSuccessRate = double(numberOfSuccessfulLineSegmentations) / m_TrackedFrameList->GetNumberOfTrackedFrames();
-  if (segmentationSuccessRate < EXPECTED_LINE_SEGMENTATION_SUCCESS_RATE)
+  if (numOfValidScanlines < MINIMUM_NUMBER_OF_VALID_SCANLINES)
   {
-    LOG_WARNING("Line segmentation success rate is very low (" << segmentationSuccessRate * 100 << "%): a line could only be detected on " << numberOfSuccessfulLineSegmentations << " frames out of " << m_TrackedFrameList->GetNumberOfTrackedFrames());
+    //TODO: drop the frame from the analysis
+    LOG_DEBUG("Only " << numOfValidScanlines << " valid scanlines; this is less than the required " << MINIMUM_NUMBER_OF_VALID_SCANLINES << ". Skipping frame" << frameNumber);
   }
 
-  bool plotVideoMetric = vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE;
-  if (plotVideoMetric)
+  // The seed only depends on the frame, so the result does not depend on the processing order
+  ComputeLineParameters(intensityPeakPositions, params, frameNumber + 1);
+  if (!params.lineDetected)
   {
-    PlotDoubleArray(m_SignalValues);
+    LOG_DEBUG("Unable to compute line parameters for frame " << frameNumber);
+    return false;
+  }
+  if (params.lineDirectionVector_Image[0] < MIN_X_SLOPE_COMPONENT_FOR_DETECTED_LINE)
+  {
+    // Line is close to vertical, skip frame because intersection of
+    // line with image's horizontal half point is unstable
+    LOG_TRACE("Line on frame " << frameNumber << " is too close to vertical, skip the frame");
+    return false;
   }
 
-  return PLUS_SUCCESS;
+  // Store the y-value of the line, when the line's x-value is half of the image's width
+  double t = (region.GetIndex()[0] + 0.5 * region.GetSize()[0] - params.lineOriginPoint_Image[0]) / params.lineDirectionVector_Image[0];
+  signalValue = std::abs(params.lineOriginPoint_Image[1] + t * params.lineDirectionVector_Image[1]);
 
-} //  End LineDetection
+  if (m_SaveIntermediateImages == true)
+  {
+    SaveIntermediateImage(frameNumber, scanlineImage,
+                          params.lineOriginPoint_Image[0], params.lineOriginPoint_Image[1], params.lineDirectionVector_Image[0], params.lineDirectionVector_Image[1],
+                          numOfValidScanlines, intensityPeakPositions);
+  }
+
+  return true;
+}
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(std::deque<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak)
+PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(const std::vector<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak)
 {
   // Start of peak is defined as the location at which it reaches 50% of its maximum value.
   double startPeakValue = maxFromLargestArea * 0.5;
@@ -408,7 +466,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::FindPeakStart(std::deque<int>& intensity
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(std::deque<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea)
+PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(const std::vector<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea)
 {
   int currentLargestArea = 0;
   int currentArea = 0;
@@ -487,7 +545,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::FindLargestPeak(std::deque<int>& intensi
 }
 //-----------------------------------------------------------------------------
 
-PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(std::deque<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity)
+PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(const std::vector<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity)
 {
   if (intensityProfile.size() == 0)
   {
@@ -526,7 +584,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::ComputeCenterOfGravity(std::deque<int>&
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusLineSegmentationAlgo::ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters)
+void vtkPlusLineSegmentationAlgo::ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters, unsigned int randomSeed)
 {
   outputParameters.lineDetected = false;
 
@@ -555,6 +613,9 @@ void vtkPlusLineSegmentationAlgo::ComputeLineParameters(std::vector<itk::Point<d
   //create and initialize the RANSAC algorithm
   double desiredProbabilityForNoOutliers = 0.999;
   RANSACType::Pointer ransacEstimator = RANSACType::New();
+  // Frames are already processed in parallel and there are only a few points, so RANSAC runs on the calling thread
+  ransacEstimator->SetNumberOfThreads(1);
+  ransacEstimator->SetRandomSeed(randomSeed);
 
   try
   {
@@ -729,7 +790,7 @@ PlusStatus vtkPlusLineSegmentationAlgo::Update()
 }
 
 //-----------------------------------------------------------------------------
-void vtkPlusLineSegmentationAlgo::PlotIntArray(const std::deque<int>& intensityValues)
+void vtkPlusLineSegmentationAlgo::PlotIntArray(const std::vector<int>& intensityValues)
 {
   //  Create table
   vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
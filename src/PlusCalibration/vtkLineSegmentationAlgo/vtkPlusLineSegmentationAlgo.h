@@ -9,6 +9,7 @@
 
 #include "itkImage.h"
 #include "vtkPlusCalibrationExport.h"
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 #include <deque>
 
@@ -81,6 +82,14 @@ public:
   vtkGetMacro(PlotIntensityProfile, bool);
   vtkSetMacro(PlotIntensityProfile, bool);
 
+  /*!
+    Number of threads used for processing the frames. If 0 (default) then the number of threads is set to the number of CPUs.
+    Frames are processed on a single thread if intermediate images are saved or intensity profiles are plotted.
+    The results do not depend on the number of threads.
+  */
+  vtkGetMacro(NumberOfThreads, int);
+  vtkSetMacro(NumberOfThreads, int);
+
 protected:
   vtkPlusLineSegmentationAlgo();
   virtual ~vtkPlusLineSegmentationAlgo();
@@ -89,15 +98,28 @@ protected:
 
   PlusStatus ComputeVideoPositionMetric();
 
-  PlusStatus FindPeakStart(std::deque<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak);
+  /*!
+    Detect the line on a single frame. Returns true if a line is detected.
+    \param frameNumber Index of the frame in the tracked frame list
+    \param intensityProfile Buffer for the scanline intensity profiles (reused between calls to avoid reallocation)
+    \param params Detected line parameters
+    \param signalValue Line position at the horizontal center of the clip region
+  */
+  bool SegmentLineOnFrame(unsigned int frameNumber, std::vector<int>& intensityProfile, LineParameters& params, double& signalValue);
+
+  /*! Thread function for detecting the line on a subset of the frames */
+  static VTK_THREAD_RETURN_TYPE SegmentLinesThreadFunction(void* arg);
 
-  PlusStatus FindLargestPeak(std::deque<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea);
+  PlusStatus FindPeakStart(const std::vector<int>& intensityProfile, int maxFromLargestArea, int startOfMaxArea, double& startOfPeak);
 
-  PlusStatus ComputeCenterOfGravity(std::deque<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity);
+  PlusStatus FindLargestPeak(const std::vector<int>& intensityProfile, int& maxFromLargestArea, int& maxFromLargestAreaIndex, int& startOfMaxArea);
 
-  void ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters);
+  PlusStatus ComputeCenterOfGravity(const std::vector<int>& intensityProfile, int startOfMaxArea, double& centerOfGravity);
 
-  void PlotIntArray(const std::deque<int>& intensityValues);
+  /*! Fit a line to the points using RANSAC. The random seed makes the result reproducible. */
+  void ComputeLineParameters(std::vector<itk::Point<double, 2> >& data, LineParameters& outputParameters, unsigned int randomSeed);
+
+  void PlotIntArray(const std::vector<int>& intensityValues);
 
   void PlotDoubleArray(const std::deque<double>& intensityValues);
 
@@ -122,6 +144,9 @@ protected:
   /*! Plot intensity profile for each scanline. Enable for debugging. */
   bool PlotIntensityProfile;
 
+  /*! Number of threads used for processing the frames (0 = number of CPUs) */
+  int NumberOfThreads;
+
   double m_SignalTimeRangeMin;
   double m_SignalTimeRangeMax;
 
@@ -12,6 +12,8 @@ See License.txt for details.
 
 #include "vtkMatrix4x4.h"
 
+#include <algorithm>
+
 vtkStandardNewMacro( vtkPlusLandmarkDetectionAlgo );
 
 //-----------------------------------------------------------------------------
@@ -30,12 +32,13 @@ vtkPlusLandmarkDetectionAlgo::vtkPlusLandmarkDetectionAlgo()
   this->StylusShaftMinimumDisplacementThresholdMm = 30;
   this->StylusTipMaximumDisplacementThresholdMm = 1.5;
   this->MinimunDistanceBetweenLandmarksMm = 15.0;
+
+  ResetStylusTipPoses();
 }
 
 //-----------------------------------------------------------------------------
 vtkPlusLandmarkDetectionAlgo::~vtkPlusLandmarkDetectionAlgo()
 {
-  this->StylusTipToReferenceTransformsDeque.clear();
   this->SetDetectedLandmarkPoints_Reference( NULL );
 }
 
@@ -129,11 +132,44 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::ComputeNumberOfWindows( unsigned int& n
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusLandmarkDetectionAlgo::ComputeEstimationSampleRange( unsigned int& firstSampleIndex, unsigned int& endSampleIndex )
+{
+  unsigned int numberOfRequiredWindows = 0;
+  if ( ComputeNumberOfWindows( numberOfRequiredWindows ) == PLUS_FAIL )
+  {
+    return PLUS_FAIL;
+  }
+
+  unsigned int numberOfWindowsSkip = PlusMath::Round( numberOfRequiredWindows * PERCENTAGE_WINDOWS_SKIP );
+  unsigned int estimationWindowSize = std::max<unsigned int>( numberOfWindowsSkip, 1 );
+  firstSampleIndex = estimationWindowSize * numberOfWindowsSkip;
+  endSampleIndex = numberOfRequiredWindows * estimationWindowSize;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusLandmarkDetectionAlgo::ResetStylusTipPoses()
+{
+  this->NumberOfStylusTipPoses = 0;
+  this->NumberOfStylusTipPosesInWindow = 0;
+  for ( int i = 0; i < 3; ++i )
+  {
+    this->StylusTipWindowPositionSum_Reference[i] = 0;
+  }
+  for ( int i = 0; i < 4; ++i )
+  {
+    this->StylusTipEstimationSum_Reference[i] = 0;
+    this->StylusTipEstimationSumSquaredDiff_Reference[i] = 0;
+  }
+  this->StylusTipEstimationPositions_Reference.clear();
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusLandmarkDetectionAlgo::ResetDetection()
 {
   LOG_DEBUG( "Reset" );
-  this->StylusTipToReferenceTransformsDeque.clear();
+  ResetStylusTipPoses();
   this->DetectedLandmarkPoints_Reference->Reset();
   return PLUS_SUCCESS;
 }
@@ -172,34 +208,37 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::FilterStylusTipPositionsWindow( double
     return PLUS_FAIL;
   }
 
-  if( this->StylusTipToReferenceTransformsDeque.size() < filterWindowSize )
+  if( this->NumberOfStylusTipPosesInWindow < filterWindowSize )
   {
     LOG_ERROR( "There are not enough stylus tip positions acquired yet" );
     return PLUS_FAIL;
   }
 
-  std::deque< vtkSmartPointer<vtkMatrix4x4> >::iterator stylusTipToReferenceTransformIt = this->StylusTipToReferenceTransformsDeque.end();
-  double stylusTipPositionSum_Reference[4] = {0, 0, 0, 1};
-  for( unsigned int i = 0; i < filterWindowSize; i++ )
-  {
-    stylusTipToReferenceTransformIt--;
-    stylusTipPositionSum_Reference[0] += ( *stylusTipToReferenceTransformIt )->Element[0][3];
-    stylusTipPositionSum_Reference[1] += ( *stylusTipToReferenceTransformIt )->Element[1][3];
-    stylusTipPositionSum_Reference[2] += ( *stylusTipToReferenceTransformIt )->Element[2][3];
-  }
-  //make sure we don't divide by zero
-  if( filterWindowSize == 0 )
-  {
-    LOG_ERROR( "Filter window size is zero can not be used, how does it happened!" );
-    return PLUS_FAIL;
-  }
-  stylusTipFiltered_Reference[0] = stylusTipPositionSum_Reference[0] / filterWindowSize;
-  stylusTipFiltered_Reference[1] = stylusTipPositionSum_Reference[1] / filterWindowSize;
-  stylusTipFiltered_Reference[2] = stylusTipPositionSum_Reference[2] / filterWindowSize;
+  stylusTipFiltered_Reference[0] = this->StylusTipWindowPositionSum_Reference[0] / this->NumberOfStylusTipPosesInWindow;
+  stylusTipFiltered_Reference[1] = this->StylusTipWindowPositionSum_Reference[1] / this->NumberOfStylusTipPosesInWindow;
+  stylusTipFiltered_Reference[2] = this->StylusTipWindowPositionSum_Reference[2] / this->NumberOfStylusTipPosesInWindow;
   stylusTipFiltered_Reference[3] = 1.0;
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusLandmarkDetectionAlgo::AddEstimationSample( double stylusTip_Reference[3] )
+{
+  double sample[4] = {stylusTip_Reference[0], stylusTip_Reference[1], stylusTip_Reference[2], vtkMath::Norm( stylusTip_Reference )};
+  unsigned int numberOfSamples = this->StylusTipEstimationPositions_Reference.size() / 3;
+  for ( int j = 0; j < 4; ++j )
+  {
+    // Welford's update, the mean is always computed from the running sum so that it is identical to the mean of all the samples
+    double previousMean = ( numberOfSamples > 0 ? this->StylusTipEstimationSum_Reference[j] / numberOfSamples : 0 );
+    this->StylusTipEstimationSum_Reference[j] += sample[j];
+    double mean = this->StylusTipEstimationSum_Reference[j] / ( numberOfSamples + 1 );
+    this->StylusTipEstimationSumSquaredDiff_Reference[j] += ( sample[j] - previousMean ) * ( sample[j] - mean );
+  }
+  this->StylusTipEstimationPositions_Reference.push_back( stylusTip_Reference[0] );
+  this->StylusTipEstimationPositions_Reference.push_back( stylusTip_Reference[1] );
+  this->StylusTipEstimationPositions_Reference.push_back( stylusTip_Reference[2] );
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform( vtkMatrix4x4* stylusTipToReferenceTransform, int& newLandmarkDetected )
 {
@@ -210,17 +249,30 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform
     return PLUS_FAIL;
   }
 
-  this->StylusTipToReferenceTransformsDeque.push_back( stylusTipToReferenceTransform );
-
   unsigned int filterWindowSize = 0;
   unsigned int numberOfRequiredWindows = 0;
-  if ( ComputeFilterWindowSize( filterWindowSize ) == PLUS_FAIL || ComputeNumberOfWindows( numberOfRequiredWindows ) == PLUS_FAIL )
+  unsigned int firstEstimationSampleIndex = 0;
+  unsigned int endEstimationSampleIndex = 0;
+  if ( ComputeFilterWindowSize( filterWindowSize ) == PLUS_FAIL || ComputeNumberOfWindows( numberOfRequiredWindows ) == PLUS_FAIL
+       || ComputeEstimationSampleRange( firstEstimationSampleIndex, endEstimationSampleIndex ) == PLUS_FAIL )
   {
     return PLUS_FAIL;
   }
 
-  bool windowCompleted = ( this->StylusTipToReferenceTransformsDeque.size() % filterWindowSize ) == 0;
-  if ( !windowCompleted )
+  // Only the running sums are updated for each pose, so the cost of a new pose does not depend on the window sizes
+  double stylusTip_Reference[3] = {stylusTipToReferenceTransform->Element[0][3], stylusTipToReferenceTransform->Element[1][3], stylusTipToReferenceTransform->Element[2][3]};
+  LOG_TRACE( "Window " << ( this->NumberOfStylusTipPoses / filterWindowSize ) << " P( " << stylusTip_Reference[0] << ", " << stylusTip_Reference[1] << ", " << stylusTip_Reference[2] << ")" );
+  if ( this->NumberOfStylusTipPoses >= firstEstimationSampleIndex && this->NumberOfStylusTipPoses < endEstimationSampleIndex )
+  {
+    AddEstimationSample( stylusTip_Reference );
+  }
+  this->NumberOfStylusTipPoses++;
+  this->NumberOfStylusTipPosesInWindow++;
+  this->StylusTipWindowPositionSum_Reference[0] += stylusTip_Reference[0];
+  this->StylusTipWindowPositionSum_Reference[1] += stylusTip_Reference[1];
+  this->StylusTipWindowPositionSum_Reference[2] += stylusTip_Reference[2];
+
+  if ( this->NumberOfStylusTipPosesInWindow < filterWindowSize )
   {
     // just keep collecting more data
     return PLUS_SUCCESS;
@@ -235,6 +287,10 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform
     return PLUS_FAIL;
   }
   this->StylusTipPathBoundingBox.AddPoint( stylusTipFiltered_Reference );
+  this->NumberOfStylusTipPosesInWindow = 0;
+  this->StylusTipWindowPositionSum_Reference[0] = 0;
+  this->StylusTipWindowPositionSum_Reference[1] = 0;
+  this->StylusTipWindowPositionSum_Reference[2] = 0;
 
   // Update StylusShaftPathBoundingBox
   //Point 10 cm above the stylus tip, if it moves(window change bigger than AboveLandmarkThresholdMm) while the tip is static (window change smaller than LandmarkThresholdMm then it is landmark point.
@@ -243,25 +299,8 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform
   stylusTipToReferenceTransform->MultiplyPoint( StylusShaftPoint_StylusTip, StylusShaftPoint_Reference );
   this->StylusShaftPathBoundingBox.AddPoint( StylusShaftPoint_Reference );
 
-  unsigned int numberOfAcquiredWindows = PlusMath::Floor( this->StylusTipToReferenceTransformsDeque.size() / filterWindowSize );
-
-  // Print all available StylusTipToReferenceTransform positions if debug level is TRACE
-  bool debugOutput = vtkPlusLogger::Instance()->GetLogLevel() >= vtkPlusLogger::LOG_LEVEL_TRACE;
-  if ( debugOutput )
-  {
-    LOG_TRACE( "Window Landmark (" << stylusTipFiltered_Reference[0] << ", " << stylusTipFiltered_Reference[1] << ", " << stylusTipFiltered_Reference[2] << ") found keep going" );
-    int i = 0;
-    for ( std::deque< vtkSmartPointer<vtkMatrix4x4> >::iterator markerToReferenceTransformIt = this->StylusTipToReferenceTransformsDeque.begin();
-          markerToReferenceTransformIt != this->StylusTipToReferenceTransformsDeque.end(); ++markerToReferenceTransformIt )
-    {
-      if( i % filterWindowSize == 0 )
-      {
-        LOG_TRACE( "Window " << ( i / filterWindowSize ) << ":" );
-      }
-      LOG_TRACE( "P( " << -( *markerToReferenceTransformIt )->Element[0][3] << ", " << -( *markerToReferenceTransformIt )->Element[1][3] << ", " << -( *markerToReferenceTransformIt )->Element[2][3] << ")" );
-      i++;
-    }
-  }
+  unsigned int numberOfAcquiredWindows = this->NumberOfStylusTipPoses / filterWindowSize;
+  LOG_TRACE( "Window Landmark (" << stylusTipFiltered_Reference[0] << ", " << stylusTipFiltered_Reference[1] << ", " << stylusTipFiltered_Reference[2] << ") found keep going" );
 
   // If tip is moved then clear transforms and start detection of the latest landmark from scratch
   double stylusTipPathBoundingBoxSize[3] = {0};
@@ -269,7 +308,7 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform
   if( vtkMath::Norm( stylusTipPathBoundingBoxSize ) > this->StylusTipMaximumDisplacementThresholdMm )
   {
     LOG_TRACE( "StylusTip has moved: StylusTipBoundingBox norm = " << vtkMath::Norm( stylusTipPathBoundingBoxSize ) );
-    this->StylusTipToReferenceTransformsDeque.clear();
+    ResetStylusTipPoses();
     this->StylusShaftPathBoundingBox.Reset();
     this->StylusTipPathBoundingBox.Reset();
     return PLUS_SUCCESS;
@@ -298,7 +337,7 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::InsertNextStylusTipToReferenceTransform
   EstimateLandmarkPosition();
   this->StylusTipPathBoundingBox.Reset();
   this->StylusShaftPathBoundingBox.Reset();
-  this->StylusTipToReferenceTransformsDeque.clear();
+  ResetStylusTipPoses();
 
   if( numberOfLandmarksBefore != this->DetectedLandmarkPoints_Reference->GetNumberOfPoints() )
   {
@@ -330,38 +369,19 @@ int vtkPlusLandmarkDetectionAlgo::GetNearExistingLandmarkId( double stylusTipPos
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusLandmarkDetectionAlgo::EstimateLandmarkPosition()
 {
-  unsigned int filterWindowSize = 0;
-  unsigned int numberOfRequiredWindows = 0;
-  if ( ComputeFilterWindowSize( filterWindowSize ) == PLUS_FAIL || ComputeNumberOfWindows( numberOfRequiredWindows ) == PLUS_FAIL )
+  unsigned int firstEstimationSampleIndex = 0;
+  unsigned int endEstimationSampleIndex = 0;
+  if ( ComputeEstimationSampleRange( firstEstimationSampleIndex, endEstimationSampleIndex ) == PLUS_FAIL )
   {
     return PLUS_FAIL;
   }
-
-  int numberOfWindowsSkip = filterWindowSize = PlusMath::Round( numberOfRequiredWindows * PERCENTAGE_WINDOWS_SKIP );
-  if( filterWindowSize < 1 )
+  if( firstEstimationSampleIndex == 0 )
   {
-    LOG_WARNING( "The smallest number of windows to skip is set to 1" );
-    filterWindowSize = 1;
+    LOG_WARNING( "No windows are skipped for the landmark position estimate" );
   }
 
-  unsigned int i = 0;
-  std::vector<double> values[4];
-  for ( std::deque< vtkSmartPointer<vtkMatrix4x4> >::iterator stylusTipToReferenceTransformIt = this->StylusTipToReferenceTransformsDeque.begin();
-        stylusTipToReferenceTransformIt != this->StylusTipToReferenceTransformsDeque.end(); ++stylusTipToReferenceTransformIt )
-  {
-    //Don't use first numberOfWindowsSkip windows
-    if( i >= ( filterWindowSize * numberOfWindowsSkip ) && i < ( numberOfRequiredWindows )*filterWindowSize )
-    {
-      double sylusTip_Reference[3] = {( *stylusTipToReferenceTransformIt )->Element[0][3], ( *stylusTipToReferenceTransformIt )->Element[1][3], ( *stylusTipToReferenceTransformIt )->Element[2][3]};
-      values[0].push_back( sylusTip_Reference[0] );
-      values[1].push_back( sylusTip_Reference[1] );
-      values[2].push_back( sylusTip_Reference[2] );
-      values[3].push_back( vtkMath::Norm( sylusTip_Reference ) );
-    }
-    i++;
-  }
-
-  if( values[0].size() != ( numberOfRequiredWindows - numberOfWindowsSkip )*filterWindowSize )
+  unsigned int numberOfSamples = this->StylusTipEstimationPositions_Reference.size() / 3;
+  if( numberOfSamples == 0 || numberOfSamples != endEstimationSampleIndex - firstEstimationSampleIndex )
   {
     LOG_ERROR( "Not right number of points to estimate landmark position" ); //LOG error and do something CLEAR?
     return PLUS_FAIL;
@@ -371,7 +391,8 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::EstimateLandmarkPosition()
   double stylusTipStdev_Reference[4] = {0, 0, 0, 0};
   for ( int j = 0; j < 4; ++j )
   {
-    PlusMath::ComputeMeanAndStdev( values[j], stylusTipMean_Reference[j], stylusTipStdev_Reference[j] );
+    stylusTipMean_Reference[j] = this->StylusTipEstimationSum_Reference[j] / numberOfSamples;
+    stylusTipStdev_Reference[j] = sqrt( this->StylusTipEstimationSumSquaredDiff_Reference[j] / numberOfSamples );
   }
   int existingLandmarkId = GetNearExistingLandmarkId( stylusTipMean_Reference );
   if ( existingLandmarkId != -1 )
@@ -381,15 +402,21 @@ PlusStatus vtkPlusLandmarkDetectionAlgo::EstimateLandmarkPosition()
   }
   this->DetectedLandmarkPoints_Reference->InsertNextPoint( stylusTipMean_Reference );
 
+  if ( vtkPlusLogger::Instance()->GetLogLevel() < vtkPlusLogger::LOG_LEVEL_DEBUG )
+  {
+    return PLUS_SUCCESS;
+  }
+
   LOG_DEBUG( "Stylus tip positions used for detection" );
   LOG_DEBUG( "Stylus tips STD deviation ( " << stylusTipStdev_Reference[0] << ", " << stylusTipStdev_Reference[1] << ", " << stylusTipStdev_Reference[2] << ") Norm = " << vtkMath::Norm( stylusTipStdev_Reference ) );
   LOG_DEBUG( "Stylus tips Magnitude STD deviation " << stylusTipStdev_Reference[3] );
 
   //compute the mean vector, compute the magnitude of error vector, get stats for this magnitude
   std::vector<double> sylusTipsToMeanVectorsMagnitude;
-  for( unsigned int j = 0; j < values[0].size(); j++ )
+  for( unsigned int j = 0; j < numberOfSamples; j++ )
   {
-    double sylusTipToMeanVector[3] = {stylusTipMean_Reference[0] - values[0][j], stylusTipMean_Reference[1] - values[1][j], stylusTipMean_Reference[2] - values[2][j]};
+    const double* sylusTip_Reference = &this->StylusTipEstimationPositions_Reference[3 * j];
+    double sylusTipToMeanVector[3] = {stylusTipMean_Reference[0] - sylusTip_Reference[0], stylusTipMean_Reference[1] - sylusTip_Reference[1], stylusTipMean_Reference[2] - sylusTip_Reference[2]};
     sylusTipsToMeanVectorsMagnitude.push_back( vtkMath::Norm( sylusTipToMeanVector ) );
   }
 
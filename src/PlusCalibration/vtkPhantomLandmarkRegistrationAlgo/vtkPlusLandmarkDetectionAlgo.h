@@ -15,8 +15,8 @@ See License.txt for details.
 #include "vtkBoundingBox.h"
 
 #include <list>
-#include <deque>
 #include <set>
+#include <vector>
 
 class vtkMatrix4x4;
 class vtkPlusTransformRepository;
@@ -130,9 +130,23 @@ protected:
   */
   PlusStatus KeepLastWindow();
 
-  /* Computes the average of the stylus tip positions in the last FilterWindowSize samples.*/
+  /*
+    Compute the range of stylus tip samples (counted from the start of the detection) that are averaged for the landmark position estimate.
+    Samples of the first windows detected as pivoting are skipped.
+    \param firstSampleIndex Index of the first sample used for the estimate.
+    \param endSampleIndex Index after the last sample used for the estimate.
+  */
+  PlusStatus ComputeEstimationSampleRange( unsigned int& firstSampleIndex, unsigned int& endSampleIndex );
+
+  /* Computes the average of the stylus tip positions in the current filter window from the running window sum.*/
   PlusStatus FilterStylusTipPositionsWindow( double stylusTipFiltered_Reference[4] );
 
+  /* Add a stylus tip position to the running sums of the landmark position estimate.*/
+  void AddEstimationSample( double stylusTip_Reference[3] );
+
+  /* Discard all the collected stylus tip positions and running sums, detection of the next landmark starts from scratch.*/
+  void ResetStylusTipPoses();
+
 protected:
   /*! The detected landmark point position(s)(defined in the reference coordinate system).*/
   vtkPoints* DetectedLandmarkPoints_Reference;
@@ -164,8 +178,21 @@ protected:
     StylusTipMaximumDisplacementThresholdMm a landmark is detected.
   */
   vtkBoundingBox StylusTipPathBoundingBox;
-  /*! Double ended queue the input point transformations. These are used for determining the next landmark (once the landmark is detected this list is cleared).*/
-  std::deque< vtkSmartPointer<vtkMatrix4x4> > StylusTipToReferenceTransformsDeque;
+  /*! Number of stylus tip poses inserted since the detection of the next landmark started (once the landmark is detected this counter is cleared).*/
+  unsigned int NumberOfStylusTipPoses;
+  /*! Number of stylus tip poses in the current (not yet completed) filter window.*/
+  unsigned int NumberOfStylusTipPosesInWindow;
+  /*! Running sum of the stylus tip positions in the current filter window, the filtered position is computed from it without revisiting the window.*/
+  double StylusTipWindowPositionSum_Reference[3];
+  /*! Running sum of the stylus tip positions (and position norm as 4th component) used for the landmark position estimate.*/
+  double StylusTipEstimationSum_Reference[4];
+  /*! Running sum of squared differences from the mean (Welford's method) of the samples used for the landmark position estimate.*/
+  double StylusTipEstimationSumSquaredDiff_Reference[4];
+  /*!
+    Stylus tip positions (x, y, z triplets) used for the landmark position estimate. Only the samples of the estimation range are stored,
+    so memory usage does not grow while the stylus is held at the same position.
+  */
+  std::vector<double> StylusTipEstimationPositions_Reference;
 };
 
 #endif
@@ -16,6 +16,14 @@
 #include "vtkMath.h"
 #include "vtksys/SystemTools.hxx"
 
+#include "vnl/algo/vnl_svd.h"
+
+namespace
+{
+  // The online estimate is considered valid if the normal matrix is not close to singular (the points have sufficiently different orientations)
+  const double ONLINE_ESTIMATE_MIN_RECIPROCAL_CONDITION_NUMBER = 1e-6;
+}
+
 vtkStandardNewMacro(vtkPlusPivotCalibrationAlgo);
 
 //-----------------------------------------------------------------------------
@@ -31,6 +39,9 @@ vtkPlusPivotCalibrationAlgo::vtkPlusPivotCalibrationAlgo()
   this->PivotPointPosition_Reference[1] = 0.0;
   this->PivotPointPosition_Reference[2] = 0.0;
   this->PivotPointPosition_Reference[3] = 1.0;
+
+  this->OnlineRobustWeightingScaleMm = 0.0;
+  this->ResetOnlineEstimate();
 }
 
 //-----------------------------------------------------------------------------
@@ -49,6 +60,7 @@ void vtkPlusPivotCalibrationAlgo::RemoveAllCalibrationPoints()
   }
   this->MarkerToReferenceTransformMatrixArray.clear();
   this->OutlierIndices.clear();
+  this->ResetOnlineEstimate();
 }
 
 //----------------------------------------------------------------------------
@@ -57,9 +69,118 @@ PlusStatus vtkPlusPivotCalibrationAlgo::InsertNextCalibrationPoint(vtkMatrix4x4*
   vtkMatrix4x4* markerToReferenceTransformMatrixCopy = vtkMatrix4x4::New();
   markerToReferenceTransformMatrixCopy->DeepCopy(aMarkerToReferenceTransformMatrix);
   this->MarkerToReferenceTransformMatrixArray.push_back(markerToReferenceTransformMatrixCopy);
+  this->UpdateOnlineEstimate(markerToReferenceTransformMatrixCopy);
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusPivotCalibrationAlgo::ResetOnlineEstimate()
+{
+  this->OnlineNormalMatrix.fill(0.0);
+  this->OnlineNormalVector.fill(0.0);
+  this->OnlineWeightedSquaredNormOfB = 0.0;
+  this->OnlineSumOfWeights = 0.0;
+  this->OnlineNumberOfCalibrationPoints = 0;
+  this->OnlineEstimateValid = false;
+  for (int i = 0; i < 3; i++)
+  {
+    this->OnlinePivotPointPosition_Marker[i] = 0.0;
+    this->OnlinePivotPointPosition_Reference[i] = 0.0;
+  }
+  this->OnlineCalibrationRmsError = -1.0;
+}
+
+//----------------------------------------------------------------------------
+// The least squares problem is the same as in GetPivotPointPosition, but instead of storing the rows of A and b,
+// only A^T*W*A, A^T*W*b, and b^T*W*b are accumulated (W is the weight of the point). Ai^T*Ai and Ai^T*bi are computed
+// from the 3x3 rotation matrix R and translation vector t of the point:
+//  Ai^T*Ai = [ R^T*R  -R^T ]   Ai^T*bi = [ -R^T*t ]
+//            [ -R      I   ]             [  t     ]
+void vtkPlusPivotCalibrationAlgo::UpdateOnlineEstimate(vtkMatrix4x4* markerToReferenceTransformMatrix)
+{
+  double rotation[3][3];
+  double translation[3];
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      rotation[i][j] = markerToReferenceTransformMatrix->Element[i][j];
+    }
+    translation[i] = markerToReferenceTransformMatrix->Element[i][3];
+  }
+
+  double weight = 1.0;
+  if (this->OnlineEstimateValid && this->OnlineRobustWeightingScaleMm > 0)
+  {
+    // Distance of the pivot point computed from this point from the current estimate
+    double residual[3];
+    for (int i = 0; i < 3; i++)
+    {
+      residual[i] = translation[i] - this->OnlinePivotPointPosition_Reference[i];
+      for (int j = 0; j < 3; j++)
+      {
+        residual[i] += rotation[i][j] * this->OnlinePivotPointPosition_Marker[j];
+      }
+    }
+    double normalizedResidual = vtkMath::Norm(residual) / this->OnlineRobustWeightingScaleMm;
+    weight = 1.0 / (1.0 + normalizedResidual * normalizedResidual);
+  }
+
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      double rotationTransposeTimesRotation = 0.0;
+      for (int k = 0; k < 3; k++)
+      {
+        rotationTransposeTimesRotation += rotation[k][i] * rotation[k][j];
+      }
+      this->OnlineNormalMatrix(i, j) += weight * rotationTransposeTimesRotation;
+      this->OnlineNormalMatrix(i, j + 3) -= weight * rotation[j][i];
+      this->OnlineNormalMatrix(i + 3, j) -= weight * rotation[i][j];
+    }
+    this->OnlineNormalMatrix(i + 3, i + 3) += weight;
+
+    double rotationTransposeTimesTranslation = 0.0;
+    for (int k = 0; k < 3; k++)
+    {
+      rotationTransposeTimesTranslation += rotation[k][i] * translation[k];
+    }
+    this->OnlineNormalVector(i) -= weight * rotationTransposeTimesTranslation;
+    this->OnlineNormalVector(i + 3) += weight * translation[i];
+  }
+  this->OnlineWeightedSquaredNormOfB += weight * vtkMath::Dot(translation, translation);
+  this->OnlineSumOfWeights += weight;
+  this->OnlineNumberOfCalibrationPoints++;
+
+  // Solve the 6x6 normal equations
+  vnl_matrix<double> normalMatrix(this->OnlineNormalMatrix.data_block(), 6, 6);
+  vnl_svd<double> svd(normalMatrix);
+  if (svd.sigma_max() <= 0 || svd.sigma_min() < ONLINE_ESTIMATE_MIN_RECIPROCAL_CONDITION_NUMBER * svd.sigma_max())
+  {
+    // not enough different orientations yet
+    this->OnlineEstimateValid = false;
+    return;
+  }
+  vnl_vector<double> normalVector(this->OnlineNormalVector.data_block(), 6);
+  vnl_vector<double> x = svd.solve(normalVector);
+  for (int i = 0; i < 3; i++)
+  {
+    this->OnlinePivotPointPosition_Marker[i] = x[i];
+    this->OnlinePivotPointPosition_Reference[i] = x[i + 3];
+  }
+  this->OnlineEstimateValid = true;
+
+  // Sum of weighted squared residuals: x^T*A^T*W*A*x - 2*x^T*A^T*W*b + b^T*W*b
+  double sumOfSquaredResiduals = dot_product(x, normalMatrix * x) - 2.0 * dot_product(x, normalVector) + this->OnlineWeightedSquaredNormOfB;
+  if (sumOfSquaredResiduals < 0)
+  {
+    // can happen due to rounding errors if the residuals are very small
+    sumOfSquaredResiduals = 0;
+  }
+  this->OnlineCalibrationRmsError = sqrt(sumOfSquaredResiduals / this->OnlineSumOfWeights);
+}
+
 //----------------------------------------------------------------------------
 /*
 In homogeneous coordinates:
@@ -282,6 +403,7 @@ PlusStatus vtkPlusPivotCalibrationAlgo::ReadConfiguration(vtkXMLDataElement* aCo
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectMarkerCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ReferenceCoordinateFrame, pivotCalibrationElement);
   XML_READ_CSTRING_ATTRIBUTE_REQUIRED(ObjectPivotPointCoordinateFrame, pivotCalibrationElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, OnlineRobustWeightingScaleMm, pivotCalibrationElement);
   return PLUS_SUCCESS;
 }
 
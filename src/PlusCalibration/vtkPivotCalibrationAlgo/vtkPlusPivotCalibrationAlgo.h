@@ -15,6 +15,10 @@ See License.txt for details.
 #include <vtkObject.h>
 #include <vtkMatrix4x4.h>
 
+// VNL includes
+#include "vnl/vnl_matrix_fixed.h"
+#include "vnl/vnl_vector_fixed.h"
+
 // STL includes
 #include <list>
 #include <set>
@@ -40,6 +44,12 @@ class vtkXMLDataElement;
   The method detects outlier points (points that have larger than 3x error than the standard deviation) and ignores them when computing the pivot point
   coordinates and the calibration error.
 
+  In addition to the calibration that is performed by DoPivotCalibration, an online estimate is updated whenever a calibration point is inserted.
+  The normal equations of the least squares problem are accumulated, so the update takes constant time, regardless of the number of inserted points.
+  The online estimate makes it possible to show the pivot point position and the RMS error live, while the points are acquired.
+  If OnlineRobustWeightingScaleMm is set then each new point is weighted by the Cauchy weight of its distance from the current estimate, which suppresses
+  outliers. Weights are not revised later, so outliers that are inserted before the first valid estimate are not suppressed.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 class vtkPlusCalibrationExport vtkPlusPivotCalibrationAlgo : public vtkObject
@@ -86,7 +96,22 @@ public:
   */
   int GetNumberOfDetectedOutliers();
 
+  /*! Get the number of calibration points that are used in the online estimate */
+  unsigned int GetOnlineNumberOfCalibrationPoints() { return this->OnlineNumberOfCalibrationPoints; };
+
 public:
+  /*! True if the online estimate is available (enough calibration points with sufficiently different orientations have been inserted) */
+  vtkGetMacro(OnlineEstimateValid, bool);
+  /*! Pivot point position in the marker coordinate system, estimated from the calibration points inserted so far */
+  vtkGetVector3Macro(OnlinePivotPointPosition_Marker, double);
+  /*! Pivot point position in the reference coordinate system, estimated from the calibration points inserted so far */
+  vtkGetVector3Macro(OnlinePivotPointPosition_Reference, double);
+  /*! Weighted RMS distance (in mm) of the pivot point positions computed from the inserted calibration points from the online estimate */
+  vtkGetMacro(OnlineCalibrationRmsError, double);
+  /*! Scale of the Cauchy weighting function (in mm) used for robust online estimation. If 0 (default) then all points have the same weight. */
+  vtkGetMacro(OnlineRobustWeightingScaleMm, double);
+  vtkSetMacro(OnlineRobustWeightingScaleMm, double);
+
   vtkGetMacro(CalibrationError, double);
   vtkGetObjectMacro(PivotPointToMarkerTransformMatrix, vtkMatrix4x4);
   vtkGetVector3Macro(PivotPointPosition_Reference, double);
@@ -110,6 +135,12 @@ protected:
 
   PlusStatus GetPivotPointPosition(double* pivotPoint_Marker, double* pivotPoint_Reference);
 
+  /*! Clear the online estimate and its normal equation accumulators */
+  void ResetOnlineEstimate();
+
+  /*! Add a calibration point to the normal equation accumulators and update the online estimate */
+  void UpdateOnlineEstimate(vtkMatrix4x4* markerToReferenceTransformMatrix);
+
 protected:
   /*! Pivot point to marker transform (eg. stylus tip to stylus) - the result of the calibration */
   vtkMatrix4x4*             PivotPointToMarkerTransformMatrix;
@@ -134,6 +165,25 @@ protected:
 
   /*! List of outlier sample indices */
   std::set<unsigned int>    OutlierIndices;
+
+  /*! Accumulated A^T*W*A of the least squares problem (see GetPivotPointPosition for the definition of A) */
+  vnl_matrix_fixed<double, 6, 6> OnlineNormalMatrix;
+
+  /*! Accumulated A^T*W*b of the least squares problem */
+  vnl_vector_fixed<double, 6> OnlineNormalVector;
+
+  /*! Accumulated b^T*W*b of the least squares problem, used for computing the residual error */
+  double                    OnlineWeightedSquaredNormOfB;
+
+  /*! Sum of the weights of the inserted calibration points */
+  double                    OnlineSumOfWeights;
+
+  unsigned int              OnlineNumberOfCalibrationPoints;
+  bool                      OnlineEstimateValid;
+  double                    OnlinePivotPointPosition_Marker[3];
+  double                    OnlinePivotPointPosition_Reference[3];
+  double                    OnlineCalibrationRmsError;
+  double                    OnlineRobustWeightingScaleMm;
 };
 
 #endif
@@ -17,8 +17,13 @@ See License.txt for details.
 #include "PlusMath.h"
 #include "PlusFidPatternRecognitionCommon.h"
 
+#include "vtkDoubleArray.h"
+#include "vtkIntArray.h"
 #include "vtkObjectFactory.h"
 #include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
+#include "vtkPlusHTMLGenerator.h"
+#include "vtkTable.h"
 #include "vtkPlane.h"
 #include "vtkXMLUtilities.h"
 #include "vtkXMLDataElement.h"
@@ -30,8 +35,31 @@ See License.txt for details.
 #include "vtkLine.h"
 #include "vtkPlane.h"
 
+#include <algorithm>
+#include <vnl/vnl_random.h>
+
 static const int MIN_NUMBER_OF_VALID_CALIBRATION_FRAMES = 10; // minimum number of successfully calibrated frames required for calibration
 static const double DEFAULT_ERROR_CONFIDENCE_INTERVAL = 0.95; // this fraction of the data is taken into account when computing mean and standard deviation in the final calibration error report
+static const double CROSS_VALIDATION_CONFIDENCE_INTERVAL_Z = 1.96; // normal quantile of the 95% confidence interval of the mean fold error (K_FOLD, LEAVE_ONE_OUT)
+static const double CROSS_VALIDATION_CONFIDENCE_INTERVAL_TAIL = 0.025; // tail probability of the 95% percentile confidence interval of the fold errors (BOOTSTRAP)
+static const unsigned long CROSS_VALIDATION_BOOTSTRAP_SEED = 1; // fixed seed, so that bootstrap samples are the same in every run
+
+namespace
+{
+  struct CrossValidateThreadFunctionInfoStruct
+  {
+    vtkPlusProbeCalibrationAlgo* Calibration;
+    // One calibration object for each thread, used for computing the folds
+    std::vector< vtkSmartPointer<vtkPlusProbeCalibrationAlgo> > ThreadCalibrations;
+    // Indices of the calibration frames of each fold
+    std::vector< std::vector<int> > TrainingFrameIndices;
+    std::vector< std::vector<int> > TestFrameIndices;
+    // Results of each fold
+    std::vector< vnl_matrix_fixed<double, 4, 4> > ImageToProbeTransformMatrices;
+    std::vector< std::vector<double> > TestReprojectionErrors;
+    std::vector<PlusStatus> Status;
+  };
+}
 
 vtkStandardNewMacro(vtkPlusProbeCalibrationAlgo);
 
@@ -1013,6 +1041,32 @@ void vtkPlusProbeCalibrationAlgo::UpdateNonOutlierData(const std::set<int>& outl
   }
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::ComputeImageToProbeTransform(vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix)
+{
+  std::set<int> outliers;
+  if (ComputeImageToProbeTransformByLinearLeastSquaresMethod(imageToProbeTransformMatrix, outliers) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Calibration with linear least squares method failed");
+    return PLUS_FAIL;
+  }
+
+  if (this->Optimizer->Enabled())
+  {
+    this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].Clear();
+    UpdateNonOutlierData(outliers);
+    this->Optimizer->SetImageToProbeSeedTransform(imageToProbeTransformMatrix);
+    if (this->Optimizer->Update() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Calibration optimization failed");
+      return PLUS_FAIL;
+    }
+    imageToProbeTransformMatrix = this->Optimizer->GetOptimizedImageToProbeTransformMatrix();
+  }
+
+  return PLUS_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 double vtkPlusProbeCalibrationAlgo::PointToWireDistance(const vnl_double_3& aPoint, const vnl_double_3& aLineEndPoint1, const vnl_double_3& aLineEndPoint2)
 {
@@ -1145,6 +1199,107 @@ void vtkPlusProbeCalibrationAlgo::ComputeError3d(const vnl_matrix_fixed<double,
   PlusMath::ComputeRms(reprojectionErrors, errorRms);
 }
 
+//--------------------------------------------------------------------------------
+int vtkPlusProbeCalibrationAlgo::GetNumberOfNonOutlierCalibrationFrames()
+{
+  return this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions.size();
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeResiduals2d(const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, int firstFrameIndex, int endFrameIndex, std::vector<double>& residuals, std::vector<double>* residualDerivatives)
+{
+  int nWires = this->NWires.size();
+  vnl_matrix_fixed<double, 4, 4> probeToImageTransform_vnl = vnl_inverse(imageToProbeMatrix);
+  for (int frameIndex = firstFrameIndex; frameIndex < endFrameIndex; frameIndex++)
+  {
+    const NWirePositionType& framePositions = this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions[frameIndex];
+    vnl_matrix_fixed<double, 4, 4> phantomToImageTransform_vnl = probeToImageTransform_vnl * vnl_inverse(framePositions.ProbeToPhantomTransform);
+    for (int nWireIndex = 0; nWireIndex < nWires; nWireIndex++)
+    {
+      for (int wireIndex = 0; wireIndex < 3; wireIndex++)
+      {
+        const PlusFidWire& wire = this->NWires[nWireIndex].GetWires()[wireIndex];
+        vnl_vector_fixed<double, 4> wireFrontPoint_Phantom(wire.EndPointFront[0], wire.EndPointFront[1], wire.EndPointFront[2], 1.0);
+        vnl_vector_fixed<double, 4> wireBackPoint_Phantom(wire.EndPointBack[0], wire.EndPointBack[1], wire.EndPointBack[2], 1.0);
+        vnl_vector_fixed<double, 4> wireFrontPoint_Image = phantomToImageTransform_vnl * wireFrontPoint_Phantom;
+        vnl_vector_fixed<double, 4> wireDirection_Image = phantomToImageTransform_vnl * wireBackPoint_Phantom - wireFrontPoint_Image;
+        const vnl_vector_fixed<double, 4>& segmentedPoint_Image = framePositions.AllWiresIntersectionPointsPos_Image[3 * nWireIndex + wireIndex];
+
+        if (fabs(wireDirection_Image[2]) < 1e-12)
+        {
+          // Image plane and wire are parallel, the point does not contribute to the error
+          residuals.push_back(0.0);
+          residuals.push_back(0.0);
+          if (residualDerivatives != NULL)
+          {
+            residualDerivatives->insert(residualDerivatives->end(), 24, 0.0);
+          }
+          continue;
+        }
+
+        // Intersection of the wire with the image plane (z=0)
+        double t = -wireFrontPoint_Image[2] / wireDirection_Image[2];
+        double intersection_Image[4] = { wireFrontPoint_Image[0] + t * wireDirection_Image[0], wireFrontPoint_Image[1] + t * wireDirection_Image[1], 0.0, 1.0 };
+        residuals.push_back(segmentedPoint_Image[0] - intersection_Image[0]);
+        residuals.push_back(segmentedPoint_Image[1] - intersection_Image[1]);
+
+        if (residualDerivatives == NULL)
+        {
+          continue;
+        }
+        // Perturbing imageToProbe(i,j) moves the intersection point by -probeToImage(:,i)*intersection(j), constrained to the image plane along the wire,
+        // therefore d(residual)/d(imageToProbe(i,j)) = (probeToImage(0:1,i) - probeToImage(2,i)/direction(2)*direction(0:1)) * intersection(j)
+        double planeConstrainedColumn[3][2];
+        for (int i = 0; i < 3; i++)
+        {
+          double ratio = probeToImageTransform_vnl(2, i) / wireDirection_Image[2];
+          planeConstrainedColumn[i][0] = probeToImageTransform_vnl(0, i) - ratio * wireDirection_Image[0];
+          planeConstrainedColumn[i][1] = probeToImageTransform_vnl(1, i) - ratio * wireDirection_Image[1];
+        }
+        for (int component = 0; component < 2; component++)
+        {
+          for (int i = 0; i < 3; i++)
+          {
+            for (int j = 0; j < 4; j++)
+            {
+              residualDerivatives->push_back(planeConstrainedColumn[i][component] * intersection_Image[j]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::ComputeResiduals3d(const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, int firstFrameIndex, int endFrameIndex, std::vector<double>& residuals, std::vector<double>* residualDerivatives)
+{
+  for (int frameIndex = firstFrameIndex; frameIndex < endFrameIndex; frameIndex++)
+  {
+    const NWirePositionType& framePositions = this->PreProcessedWirePositions[CALIBRATION_NOT_OUTLIER].FramePositions[frameIndex];
+    for (unsigned int nWireIndex = 0; nWireIndex < this->NWires.size(); nWireIndex++)
+    {
+      const vnl_vector_fixed<double, 4>& segmentedPoint_Image = framePositions.AllWiresIntersectionPointsPos_Image[nWireIndex * 3 + 1];
+      vnl_vector_fixed<double, 4> segmentedPoint_Probe = imageToProbeMatrix * segmentedPoint_Image;
+      for (int component = 0; component < 3; component++)
+      {
+        residuals.push_back(segmentedPoint_Probe[component] - framePositions.MiddleWireIntersectionPointsPos_Probe[nWireIndex][component]);
+        if (residualDerivatives == NULL)
+        {
+          continue;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+          for (int j = 0; j < 4; j++)
+          {
+            residualDerivatives->push_back(i == component ? segmentedPoint_Image[j] : 0.0);
+          }
+        }
+      }
+    }
+  }
+}
+
 //--------------------------------------------------------------------------------
 double vtkPlusProbeCalibrationAlgo::GetCalibrationReprojectionError3DMean()
 {
@@ -1174,3 +1329,340 @@ void vtkPlusProbeCalibrationAlgo::GetImageToProbeTransformMatrix(vtkMatrix4x4* i
 {
   PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix, imageToProbeMatrix);
 }
+
+//----------------------------------------------------------------------------
+const char* vtkPlusProbeCalibrationAlgo::GetCrossValidationMethodAsString(CrossValidationMethodType method)
+{
+  switch (method)
+  {
+  case CROSS_VALIDATION_K_FOLD: return "K_FOLD";
+  case CROSS_VALIDATION_LEAVE_ONE_OUT: return "LEAVE_ONE_OUT";
+  case CROSS_VALIDATION_BOOTSTRAP: return "BOOTSTRAP";
+  default:
+    LOG_ERROR("Unknown cross-validation method: " << method);
+    return "unknown";
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::CrossValidate(CrossValidationMethodType method, int numberOfFolds, int numberOfThreads/*=0*/)
+{
+  LOG_TRACE("vtkPlusProbeCalibrationAlgo::CrossValidate(" << GetCrossValidationMethodAsString(method) << ", " << numberOfFolds << ")");
+
+  this->CrossValidationResult = CrossValidationResultType();
+  this->CrossValidationResult.Method = method;
+
+  const int numberOfFrames = this->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions.size();
+  if (numberOfFrames == 0)
+  {
+    LOG_ERROR("Unable to perform cross-validation - calibration data is empty, run calibration first");
+    return PLUS_FAIL;
+  }
+
+  // Determine the number of folds
+  switch (method)
+  {
+  case CROSS_VALIDATION_LEAVE_ONE_OUT:
+    // K-fold with one frame in each fold
+    numberOfFolds = numberOfFrames;
+    if (numberOfFolds < 2)
+    {
+      LOG_ERROR("Unable to perform cross-validation - at least 2 calibration frames are required");
+      return PLUS_FAIL;
+    }
+    break;
+  case CROSS_VALIDATION_K_FOLD:
+    if (numberOfFolds < 2 || numberOfFolds > numberOfFrames)
+    {
+      LOG_ERROR("Unable to perform cross-validation - number of folds must be between 2 and the number of calibration frames (" << numberOfFrames << ")");
+      return PLUS_FAIL;
+    }
+    break;
+  case CROSS_VALIDATION_BOOTSTRAP:
+    if (numberOfFolds < 1)
+    {
+      LOG_ERROR("Unable to perform cross-validation - number of bootstrap samples must be positive");
+      return PLUS_FAIL;
+    }
+    break;
+  default:
+    LOG_ERROR("Unknown cross-validation method: " << method);
+    return PLUS_FAIL;
+  }
+
+  // Select the training and test frames of the folds
+  CrossValidateThreadFunctionInfoStruct str;
+  str.Calibration = this;
+  if (method == CROSS_VALIDATION_BOOTSTRAP)
+  {
+    vnl_random randomGenerator(CROSS_VALIDATION_BOOTSTRAP_SEED);
+    for (int foldIndex = 0; foldIndex < numberOfFolds; ++foldIndex)
+    {
+      std::vector<bool> frameDrawn(numberOfFrames, false);
+      str.TrainingFrameIndices.push_back(std::vector<int>());
+      str.TestFrameIndices.push_back(std::vector<int>());
+      for (int drawIndex = 0; drawIndex < numberOfFrames; ++drawIndex)
+      {
+        int frameIndex = randomGenerator.lrand32(0, numberOfFrames - 1);
+        frameDrawn[frameIndex] = true;
+        str.TrainingFrameIndices.back().push_back(frameIndex);
+      }
+      for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+      {
+        if (!frameDrawn[frameIndex])
+        {
+          str.TestFrameIndices.back().push_back(frameIndex);
+        }
+      }
+    }
+  }
+  else
+  {
+    // Contiguous blocks are held out, because neighbor frames in a sequence are strongly correlated
+    for (int foldIndex = 0; foldIndex < numberOfFolds; ++foldIndex)
+    {
+      int firstTestFrameIndex = numberOfFrames * foldIndex / numberOfFolds;
+      int endTestFrameIndex = numberOfFrames * (foldIndex + 1) / numberOfFolds;
+      str.TrainingFrameIndices.push_back(std::vector<int>());
+      str.TestFrameIndices.push_back(std::vector<int>());
+      for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+      {
+        if (frameIndex >= firstTestFrameIndex && frameIndex < endTestFrameIndex)
+        {
+          str.TestFrameIndices.back().push_back(frameIndex);
+        }
+        else
+        {
+          str.TrainingFrameIndices.back().push_back(frameIndex);
+        }
+      }
+    }
+  }
+
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (numberOfThreads > 0)
+  {
+    threader->SetNumberOfThreads(numberOfThreads);
+  }
+  threader->SetNumberOfThreads(std::min(threader->GetNumberOfThreads(), numberOfFolds));
+
+  // Each thread computes its folds on its own calibration object (with the same settings as this one)
+  for (int threadIndex = 0; threadIndex < threader->GetNumberOfThreads(); ++threadIndex)
+  {
+    vtkSmartPointer<vtkPlusProbeCalibrationAlgo> threadCalibration = vtkSmartPointer<vtkPlusProbeCalibrationAlgo>::New();
+    threadCalibration->NWires = this->NWires;
+    threadCalibration->ErrorConfidenceLevel = this->ErrorConfidenceLevel;
+    threadCalibration->Optimizer->SetOptimizationMethod(this->Optimizer->GetOptimizationMethod());
+    threadCalibration->Optimizer->SetIsotropicPixelSpacing(this->Optimizer->GetIsotropicPixelSpacing());
+    threadCalibration->Optimizer->SetMinimizer(this->Optimizer->GetMinimizer());
+    threadCalibration->Optimizer->SetNumberOfStarts(this->Optimizer->GetNumberOfStarts());
+    threadCalibration->Optimizer->SetNumberOfThreads(1); // folds are already computed in parallel
+    threadCalibration->Optimizer->SetLogLevel(vtkPlusLogger::LOG_LEVEL_DEBUG); // only the summary of the folds is reported at info level
+    str.ThreadCalibrations.push_back(threadCalibration);
+  }
+  str.ImageToProbeTransformMatrices.resize(numberOfFolds);
+  str.TestReprojectionErrors.resize(numberOfFolds);
+  str.Status.resize(numberOfFolds, PLUS_FAIL);
+
+  threader->SetSingleMethod(CrossValidateThreadFunction, &str);
+  threader->SingleMethodExecute();
+
+  // Collect the results in fold order
+  std::vector<double> allTestReprojectionErrors;
+  vtkSmartPointer<vtkMatrix4x4> imageToProbeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix, imageToProbeMatrix);
+  vtkSmartPointer<vtkMatrix4x4> foldImageToProbeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int foldIndex = 0; foldIndex < numberOfFolds; ++foldIndex)
+  {
+    if (str.Status[foldIndex] != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Cross-validation fold " << foldIndex << " failed");
+      continue;
+    }
+    if (str.TestReprojectionErrors[foldIndex].empty())
+    {
+      LOG_DEBUG("Cross-validation fold " << foldIndex << " has no held out frames");
+      continue;
+    }
+    double foldErrorMax = 0.0;
+    double foldErrorMean = 0.0;
+    double foldErrorStdev = 0.0;
+    PlusMath::ComputePercentile(str.TestReprojectionErrors[foldIndex], this->ErrorConfidenceLevel, foldErrorMax, foldErrorMean, foldErrorStdev);
+    this->CrossValidationResult.FoldReprojectionError3DMeans.push_back(foldErrorMean);
+    allTestReprojectionErrors.insert(allTestReprojectionErrors.end(), str.TestReprojectionErrors[foldIndex].begin(), str.TestReprojectionErrors[foldIndex].end());
+
+    PlusMath::ConvertVnlMatrixToVtkMatrix(str.ImageToProbeTransformMatrices[foldIndex], foldImageToProbeMatrix);
+    this->CrossValidationResult.FoldTranslationDifferencesMm.push_back(PlusMath::GetPositionDifference(imageToProbeMatrix, foldImageToProbeMatrix));
+    this->CrossValidationResult.FoldOrientationDifferencesDeg.push_back(PlusMath::GetOrientationDifference(imageToProbeMatrix, foldImageToProbeMatrix));
+  }
+  this->CrossValidationResult.ComputationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+
+  const int numberOfValidFolds = this->CrossValidationResult.FoldReprojectionError3DMeans.size();
+  if (numberOfValidFolds == 0)
+  {
+    LOG_ERROR("Cross-validation failed - none of the " << numberOfFolds << " folds could be evaluated");
+    return PLUS_FAIL;
+  }
+
+  double errorMax = 0.0;
+  PlusMath::ComputePercentile(allTestReprojectionErrors, this->ErrorConfidenceLevel, errorMax,
+                              this->CrossValidationResult.ReprojectionError3DMean, this->CrossValidationResult.ReprojectionError3DStdDev);
+
+  if (method == CROSS_VALIDATION_BOOTSTRAP)
+  {
+    // Percentile interval of the bootstrap sample errors
+    std::vector<double> sortedFoldErrors = this->CrossValidationResult.FoldReprojectionError3DMeans;
+    std::sort(sortedFoldErrors.begin(), sortedFoldErrors.end());
+    int lowerIndex = static_cast<int>(floor(CROSS_VALIDATION_CONFIDENCE_INTERVAL_TAIL * (numberOfValidFolds - 1)));
+    int upperIndex = static_cast<int>(ceil((1.0 - CROSS_VALIDATION_CONFIDENCE_INTERVAL_TAIL) * (numberOfValidFolds - 1)));
+    this->CrossValidationResult.ReprojectionError3DConfidenceIntervalLower = sortedFoldErrors[lowerIndex];
+    this->CrossValidationResult.ReprojectionError3DConfidenceIntervalUpper = sortedFoldErrors[upperIndex];
+  }
+  else
+  {
+    // Normal approximation of the interval of the mean fold error
+    double foldErrorMean = 0.0;
+    double foldErrorStdev = 0.0;
+    PlusMath::ComputeMeanAndStdev(this->CrossValidationResult.FoldReprojectionError3DMeans, foldErrorMean, foldErrorStdev);
+    double halfWidth = CROSS_VALIDATION_CONFIDENCE_INTERVAL_Z * foldErrorStdev / sqrt(static_cast<double>(numberOfValidFolds));
+    this->CrossValidationResult.ReprojectionError3DConfidenceIntervalLower = foldErrorMean - halfWidth;
+    this->CrossValidationResult.ReprojectionError3DConfidenceIntervalUpper = foldErrorMean + halfWidth;
+  }
+
+  LOG_INFO("Cross-validation (" << GetCrossValidationMethodAsString(method) << ", " << numberOfValidFolds << " of " << numberOfFolds << " folds) 3D Reprojection Error (OPE): Mean: "
+           << this->CrossValidationResult.ReprojectionError3DMean << "mm, StdDev: " << this->CrossValidationResult.ReprojectionError3DStdDev << "mm, 95% confidence interval: ["
+           << this->CrossValidationResult.ReprojectionError3DConfidenceIntervalLower << "mm, " << this->CrossValidationResult.ReprojectionError3DConfidenceIntervalUpper << "mm]");
+  LOG_INFO("Cross-validation time: " << this->CrossValidationResult.ComputationTimeSec << " sec");
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusProbeCalibrationAlgo::CrossValidateThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  CrossValidateThreadFunctionInfoStruct* str = static_cast<CrossValidateThreadFunctionInfoStruct*>(threadInfo->UserData);
+  vtkPlusProbeCalibrationAlgo* threadCalibration = str->ThreadCalibrations[threadInfo->ThreadID];
+  const std::vector<NWirePositionType>& allFramePositions = str->Calibration->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions;
+
+  // Folds are distributed among the threads in an interleaved way
+  const int numberOfFolds = str->Status.size();
+  for (int foldIndex = threadInfo->ThreadID; foldIndex < numberOfFolds; foldIndex += threadInfo->NumberOfThreads)
+  {
+    threadCalibration->PreProcessedWirePositions[CALIBRATION_ALL].Clear();
+    threadCalibration->PreProcessedWirePositions[VALIDATION_ALL].Clear();
+    for (std::vector<int>::const_iterator frameIt = str->TrainingFrameIndices[foldIndex].begin(); frameIt != str->TrainingFrameIndices[foldIndex].end(); ++frameIt)
+    {
+      threadCalibration->PreProcessedWirePositions[CALIBRATION_ALL].FramePositions.push_back(allFramePositions[*frameIt]);
+    }
+    for (std::vector<int>::const_iterator frameIt = str->TestFrameIndices[foldIndex].begin(); frameIt != str->TestFrameIndices[foldIndex].end(); ++frameIt)
+    {
+      threadCalibration->PreProcessedWirePositions[VALIDATION_ALL].FramePositions.push_back(allFramePositions[*frameIt]);
+    }
+
+    str->Status[foldIndex] = threadCalibration->ComputeImageToProbeTransform(str->ImageToProbeTransformMatrices[foldIndex]);
+    if (str->Status[foldIndex] == PLUS_SUCCESS)
+    {
+      threadCalibration->ComputeError3d(str->TestReprojectionErrors[foldIndex], VALIDATION_ALL, str->ImageToProbeTransformMatrices[foldIndex]);
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationAlgo::GenerateCrossValidationReport(vtkPlusHTMLGenerator* htmlReport)
+{
+  LOG_TRACE("vtkPlusProbeCalibrationAlgo::GenerateCrossValidationReport");
+
+  if (htmlReport == NULL)
+  {
+    LOG_ERROR("vtkPlusProbeCalibrationAlgo::GenerateCrossValidationReport failed: HTML report generator is invalid");
+    return PLUS_FAIL;
+  }
+  if (this->CrossValidationResult.FoldReprojectionError3DMeans.empty())
+  {
+    LOG_ERROR("Unable to generate report - cross-validation has not been performed");
+    return PLUS_FAIL;
+  }
+
+  htmlReport->AddText("Probe Calibration Cross-Validation", vtkPlusHTMLGenerator::H1);
+
+  const std::vector<double>& translationDifferences = this->CrossValidationResult.FoldTranslationDifferencesMm;
+  const std::vector<double>& orientationDifferences = this->CrossValidationResult.FoldOrientationDifferencesDeg;
+  double translationDifferenceMean = 0.0;
+  double translationDifferenceStdev = 0.0;
+  PlusMath::ComputeMeanAndStdev(translationDifferences, translationDifferenceMean, translationDifferenceStdev);
+  double orientationDifferenceMean = 0.0;
+  double orientationDifferenceStdev = 0.0;
+  PlusMath::ComputeMeanAndStdev(orientationDifferences, orientationDifferenceMean, orientationDifferenceStdev);
+
+  std::ostringstream report;
+  report << "Method: " << GetCrossValidationMethodAsString(this->CrossValidationResult.Method) << "</br>";
+  report << "Number of folds: " << this->CrossValidationResult.FoldReprojectionError3DMeans.size() << "</br>";
+  report << "3D reprojection error of held out frames - mean (mm): " << this->CrossValidationResult.ReprojectionError3DMean << "</br>";
+  report << "3D reprojection error of held out frames - standard deviation (mm): " << this->CrossValidationResult.ReprojectionError3DStdDev << "</br>";
+  report << "3D reprojection error of folds - 95% confidence interval (mm): " << this->CrossValidationResult.ReprojectionError3DConfidenceIntervalLower
+         << " - " << this->CrossValidationResult.ReprojectionError3DConfidenceIntervalUpper << "</br>";
+  report << "Translation difference from calibration result - mean / max (mm): " << translationDifferenceMean
+         << " / " << *std::max_element(translationDifferences.begin(), translationDifferences.end()) << "</br>";
+  report << "Orientation difference from calibration result - mean / max (deg): " << orientationDifferenceMean
+         << " / " << *std::max_element(orientationDifferences.begin(), orientationDifferences.end()) << "</br>";
+  report << "Computation time (sec): " << this->CrossValidationResult.ComputationTimeSec << "</br>";
+  htmlReport->AddParagraph(report.str().c_str());
+
+  vtkSmartPointer<vtkTable> foldTable = vtkSmartPointer<vtkTable>::New();
+  vtkSmartPointer<vtkIntArray> foldIndexColumn = vtkSmartPointer<vtkIntArray>::New();
+  foldIndexColumn->SetName("Fold");
+  foldTable->AddColumn(foldIndexColumn);
+  vtkSmartPointer<vtkDoubleArray> errorColumn = vtkSmartPointer<vtkDoubleArray>::New();
+  errorColumn->SetName("3D reprojection error mean (mm)");
+  foldTable->AddColumn(errorColumn);
+  vtkSmartPointer<vtkDoubleArray> translationColumn = vtkSmartPointer<vtkDoubleArray>::New();
+  translationColumn->SetName("Translation difference (mm)");
+  foldTable->AddColumn(translationColumn);
+  vtkSmartPointer<vtkDoubleArray> orientationColumn = vtkSmartPointer<vtkDoubleArray>::New();
+  orientationColumn->SetName("Orientation difference (deg)");
+  foldTable->AddColumn(orientationColumn);
+  const int numberOfFolds = this->CrossValidationResult.FoldReprojectionError3DMeans.size();
+  foldTable->SetNumberOfRows(numberOfFolds);
+  for (int foldIndex = 0; foldIndex < numberOfFolds; ++foldIndex)
+  {
+    foldTable->SetValue(foldIndex, 0, foldIndex);
+    foldTable->SetValue(foldIndex, 1, this->CrossValidationResult.FoldReprojectionError3DMeans[foldIndex]);
+    foldTable->SetValue(foldIndex, 2, translationDifferences[foldIndex]);
+    foldTable->SetValue(foldIndex, 3, orientationDifferences[foldIndex]);
+  }
+  htmlReport->AddTable(foldTable, 1);
+
+  htmlReport->AddHorizontalLine();
+
+  return PLUS_SUCCESS;
+}
+
+//--------------------------------------------------------------------------------
+double vtkPlusProbeCalibrationAlgo::GetCrossValidationReprojectionError3DMean()
+{
+  return this->CrossValidationResult.ReprojectionError3DMean;
+}
+
+//--------------------------------------------------------------------------------
+double vtkPlusProbeCalibrationAlgo::GetCrossValidationReprojectionError3DStdDev()
+{
+  return this->CrossValidationResult.ReprojectionError3DStdDev;
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::GetCrossValidationReprojectionError3DConfidenceInterval(double& lower, double& upper)
+{
+  lower = this->CrossValidationResult.ReprojectionError3DConfidenceIntervalLower;
+  upper = this->CrossValidationResult.ReprojectionError3DConfidenceIntervalUpper;
+}
+
+//--------------------------------------------------------------------------------
+void vtkPlusProbeCalibrationAlgo::GetCrossValidationFoldReprojectionError3DMeans(std::vector<double>& foldErrorMeans)
+{
+  foldErrorMeans = this->CrossValidationResult.FoldReprojectionError3DMeans;
+}
@@ -19,6 +19,7 @@
 #include "vtkPlusProbeCalibrationOptimizerAlgo.h"
 
 class PlusTrackedFrame;
+class vtkPlusHTMLGenerator;
 class vtkPlusTrackedFrameList;
 class vtkPlusTransformRepository;
 class vtkXMLDataElement;
@@ -122,6 +123,63 @@ public:
   void ComputeError2d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& errorMean, double& errorStDev, double& errorRms );
   void ComputeError3d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, double& errorMean, double& errorStDev, double& errorRms );
 
+  /*! Get the number of calibration frames that are used for optimization (calibration frames that do not contain outliers) */
+  int GetNumberOfNonOutlierCalibrationFrames();
+
+  /*!
+    Compute the in-plane (2D) reprojection error residuals of a range of non-outlier calibration frames and their derivatives.
+    The computation only reads the calibration data, therefore it can be called from multiple threads at the same time.
+    \param imageToProbeMatrix Image to probe transform
+    \param firstFrameIndex Index of the first non-outlier calibration frame that is processed
+    \param endFrameIndex Index after the last non-outlier calibration frame that is processed
+    \param residuals The x and y distances between the segmented wire points and the wire intersections with the image plane are appended to this vector
+    \param residualDerivatives If not NULL then derivatives of each residual with respect to the upper 3x4 elements of the image to probe matrix (12 values, row-major order) are appended to this vector
+  */
+  void ComputeResiduals2d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, int firstFrameIndex, int endFrameIndex, std::vector<double>& residuals, std::vector<double>* residualDerivatives );
+
+  /*!
+    Compute the out-of-plane (3D) reprojection error residuals of a range of non-outlier calibration frames and their derivatives.
+    The computation only reads the calibration data, therefore it can be called from multiple threads at the same time.
+    \param imageToProbeMatrix Image to probe transform
+    \param firstFrameIndex Index of the first non-outlier calibration frame that is processed
+    \param endFrameIndex Index after the last non-outlier calibration frame that is processed
+    \param residuals The x, y, z differences between the segmented middle wire points and the computed middle wire positions in the probe frame are appended to this vector
+    \param residualDerivatives If not NULL then derivatives of each residual with respect to the upper 3x4 elements of the image to probe matrix (12 values, row-major order) are appended to this vector
+  */
+  void ComputeResiduals3d( const vnl_matrix_fixed<double, 4, 4>& imageToProbeMatrix, int firstFrameIndex, int endFrameIndex, std::vector<double>& residuals, std::vector<double>* residualDerivatives );
+
+  /*! Methods for selecting the calibration frames used in the cross-validation folds */
+  enum CrossValidationMethodType
+  {
+    CROSS_VALIDATION_K_FOLD, // frames are split into contiguous blocks, each block is held out once
+    CROSS_VALIDATION_LEAVE_ONE_OUT, // each frame is held out once
+    CROSS_VALIDATION_BOOTSTRAP // frames are drawn with replacement, the frames that are not drawn are held out
+  };
+
+  static const char* GetCrossValidationMethodAsString( CrossValidationMethodType method );
+
+  /*!
+    Evaluate the precision of the calibration by repeating it (linear least squares and optional optimization) on subsets
+    of the calibration frames of the last Calibrate call and computing the 3D reprojection error on the held out frames.
+    The segmented wire positions are reused and the folds are computed in parallel. The calibration result is not changed.
+    \param method Method for selecting the frames of the folds
+    \param numberOfFolds Number of folds (K_FOLD) or number of bootstrap samples (BOOTSTRAP). Ignored for LEAVE_ONE_OUT.
+    \param numberOfThreads Number of threads used for computing the folds. If 0 then the number of threads is the number of processors.
+  */
+  PlusStatus CrossValidate( CrossValidationMethodType method, int numberOfFolds, int numberOfThreads = 0 );
+
+  /*! Add the results of the last cross-validation to an HTML report */
+  PlusStatus GenerateCrossValidationReport( vtkPlusHTMLGenerator* htmlReport );
+
+  /*! Get the mean 3D reprojection error of the held out frames of all cross-validation folds, taking into account the confidence interval. */
+  double GetCrossValidationReprojectionError3DMean();
+  /*! Get the standard deviation of 3D reprojection errors of the held out frames of all cross-validation folds, taking into account the confidence interval. */
+  double GetCrossValidationReprojectionError3DStdDev();
+  /*! Get the 95% confidence interval of the mean 3D reprojection errors of the cross-validation folds */
+  void GetCrossValidationReprojectionError3DConfidenceInterval( double& lower, double& upper );
+  /*! Get the mean 3D reprojection error of the held out frames of each cross-validation fold that could be evaluated, in fold order */
+  void GetCrossValidationFoldReprojectionError3DMeans( std::vector<double>& foldErrorMeans );
+
 protected:
 
   enum PreProcessedWirePositionIdType
@@ -187,6 +245,15 @@ protected:
   */
   void UpdateNonOutlierData( const std::set<int>& outliers );
 
+  /*!
+    Compute the image to probe transform from the calibration data (linear least squares and optimization, if enabled).
+    Neither the calibration result nor the transform repository is changed.
+  */
+  PlusStatus ComputeImageToProbeTransform( vnl_matrix_fixed<double, 4, 4>& imageToProbeTransformMatrix );
+
+  /*! Thread function for computing cross-validation folds */
+  static VTK_THREAD_RETURN_TYPE CrossValidateThreadFunction( void* arg );
+
   static double PointToWireDistance( const vnl_double_3& aPoint, const vnl_double_3& aLineEndPoint1, const vnl_double_3& aLineEndPoint2 );
 
 protected:
@@ -308,6 +375,40 @@ protected:
 
   PreProcessedWirePositionsType PreProcessedWirePositions[LAST_PREPROCESSED_WIRE_POS_ID];
 
+  struct CrossValidationResultType
+  {
+    CrossValidationMethodType Method;
+
+    /*! Mean 3D reprojection error of the held out frames of each successfully computed fold (using confidence interval) */
+    std::vector<double> FoldReprojectionError3DMeans;
+    /*! Translation difference between the image to probe transform of each fold and the calibration result */
+    std::vector<double> FoldTranslationDifferencesMm;
+    /*! Orientation difference between the image to probe transform of each fold and the calibration result */
+    std::vector<double> FoldOrientationDifferencesDeg;
+
+    /*! Mean 3D reprojection error of the held out frames of all folds (using confidence interval) */
+    double ReprojectionError3DMean;
+    /*! Standard deviation of 3D reprojection errors of the held out frames of all folds (using confidence interval) */
+    double ReprojectionError3DStdDev;
+    /*! 95% confidence interval of the fold mean 3D reprojection errors */
+    double ReprojectionError3DConfidenceIntervalLower;
+    double ReprojectionError3DConfidenceIntervalUpper;
+
+    double ComputationTimeSec;
+
+    CrossValidationResultType()
+      : Method( CROSS_VALIDATION_K_FOLD )
+      , ReprojectionError3DMean( -1.0 )
+      , ReprojectionError3DStdDev( -1.0 )
+      , ReprojectionError3DConfidenceIntervalLower( -1.0 )
+      , ReprojectionError3DConfidenceIntervalUpper( -1.0 )
+      , ComputationTimeSec( 0.0 )
+    {}
+  };
+
+  /*! Results of the last cross-validation */
+  CrossValidationResultType CrossValidationResult;
+
   /*!
     Confidence level (trusted zone) as a percentage of the independent validation data used to produce the final error computation results.  It serves as an effective way to get rid of corrupted data
     (or outliers) in the validation dataset. Default value: 0.95 (or 95%), meaning the top ranked 95% of the ascendingly-ordered PRE values from the validation data would be accepted as the valid PRE values.
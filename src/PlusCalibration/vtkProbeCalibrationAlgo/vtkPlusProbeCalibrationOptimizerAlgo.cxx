@@ -18,12 +18,107 @@ See License.txt for details.
 
 #include "vtksys/SystemTools.hxx"
 
+#include "float.h"
+#include <algorithm>
+
 #include "itkPowellOptimizer.h"
 #include "itkScaleVersor3DTransform.h"
 #include "itkSimilarity3DTransform.h"
 
+#include <vnl/vnl_random.h>
+#include <vnl/vnl_rotation_matrix.h>
+
 typedef  itk::PowellOptimizer  OptimizerType;
 
+static const int MAXIMUM_NUMBER_OF_ITERATIONS = 300;
+static const double LEVENBERG_MARQUARDT_INITIAL_DAMPING = 1e-3;
+static const int LEVENBERG_MARQUARDT_MAXIMUM_DAMPING_INCREASES = 10;
+static const double LEVENBERG_MARQUARDT_RELATIVE_VALUE_TOLERANCE = 1e-12;
+static const double MULTI_START_ROTATION_PERTURBATION_DEG = 5.0; // maximum rotation of the perturbed start transforms around each axis
+static const double MULTI_START_TRANSLATION_PERTURBATION_MM = 5.0; // maximum translation of the perturbed start transforms along each axis
+static const double MULTI_START_SCALE_PERTURBATION = 0.05; // maximum relative change of the pixel spacing in the perturbed start transforms
+
+namespace
+{
+  struct MinimizeStartsThreadFunctionInfoStruct
+  {
+    vnl_matrix_fixed<double,4,4> ImageToProbeSeedTransformMatrix;
+    std::vector< vnl_matrix_fixed<double,4,4> > ImageToProbeOptimizedTransformMatrices;
+    std::vector<double> ErrorRms;
+    std::vector<PlusStatus> Status;
+  };
+
+  struct ComputeResidualSumsThreadFunctionInfoStruct
+  {
+    vnl_matrix_fixed<double,4,4> ImageToProbeTransformMatrix;
+    int NumberOfFrames;
+    bool ComputeNormalEquations;
+    // Partial sums, one element for each thread
+    std::vector<double> SumOfSquaredResiduals;
+    std::vector<int> NumberOfResiduals;
+    std::vector< vnl_matrix_fixed<double,12,12> > JacobianTransposeJacobian;
+    std::vector< vnl_vector_fixed<double,12> > JacobianTransposeResiduals;
+  };
+
+  //-----------------------------------------------------------------------------
+  // Image to probe matrix from rotation, translation, and pixel spacing (in isotropic case both scales are the same)
+  void GetImageToProbeMatrix(const vnl_matrix_fixed<double,3,3> &rotation, const vnl_vector_fixed<double,3> &translation, const double scale[2], vnl_matrix_fixed<double,4,4> &imageToProbeMatrix)
+  {
+    double columnScale[3] = { scale[0], scale[1], ( scale[0] + scale[1] ) / 2 };
+    imageToProbeMatrix.set_identity();
+    for (int i = 0; i < 3; i++)
+    {
+      for (int j = 0; j < 3; j++)
+      {
+        imageToProbeMatrix(i,j) = rotation(i,j) * columnScale[j];
+      }
+      imageToProbeMatrix(i,3) = translation[i];
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  // Derivatives of the upper 3x4 image to probe matrix elements (rows, row-major order) with respect to the parameters (columns):
+  // incremental rotation vector (applied in the image frame), translation, and one (isotropic) or two (X, Y) pixel spacing values.
+  void GetImageToProbeMatrixDerivatives(const vnl_matrix_fixed<double,3,3> &rotation, const double scale[2], bool isotropicPixelSpacing, vnl_matrix<double> &matrixDerivatives)
+  {
+    double columnScale[3] = { scale[0], scale[1], ( scale[0] + scale[1] ) / 2 };
+    matrixDerivatives.set_size(12, isotropicPixelSpacing ? 7 : 8);
+    matrixDerivatives.fill(0.0);
+    for (int k = 0; k < 3; k++)
+    {
+      // Cross product matrix of the k-th unit vector
+      vnl_matrix_fixed<double,3,3> crossProductMatrix(0.0);
+      crossProductMatrix((k + 2) % 3, (k + 1) % 3) = 1.0;
+      crossProductMatrix((k + 1) % 3, (k + 2) % 3) = -1.0;
+      vnl_matrix_fixed<double,3,3> rotationDerivative = rotation * crossProductMatrix;
+      for (int i = 0; i < 3; i++)
+      {
+        for (int j = 0; j < 3; j++)
+        {
+          matrixDerivatives(4 * i + j, k) = rotationDerivative(i,j) * columnScale[j];
+        }
+      }
+    }
+    for (int i = 0; i < 3; i++)
+    {
+      matrixDerivatives(4 * i + 3, 3 + i) = 1.0;
+      if (isotropicPixelSpacing)
+      {
+        matrixDerivatives(4 * i + 0, 6) = rotation(i,0);
+        matrixDerivatives(4 * i + 1, 6) = rotation(i,1);
+        matrixDerivatives(4 * i + 2, 6) = rotation(i,2);
+      }
+      else
+      {
+        matrixDerivatives(4 * i + 0, 6) = rotation(i,0);
+        matrixDerivatives(4 * i + 2, 6) = 0.5 * rotation(i,2);
+        matrixDerivatives(4 * i + 1, 7) = rotation(i,1);
+        matrixDerivatives(4 * i + 2, 7) = 0.5 * rotation(i,2);
+      }
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 class DistanceToWiresCostFunction : public itk::SingleValuedCostFunction 
 {
@@ -165,6 +260,10 @@ vtkStandardNewMacro(vtkPlusProbeCalibrationOptimizerAlgo);
 //-----------------------------------------------------------------------------
 vtkPlusProbeCalibrationOptimizerAlgo::vtkPlusProbeCalibrationOptimizerAlgo()
 : IsotropicPixelSpacing(true)
+, Minimizer(MINIMIZER_POWELL)
+, NumberOfStarts(1)
+, NumberOfThreads(0)
+, LogLevel(vtkPlusLogger::LOG_LEVEL_INFO)
 , ProbeCalibrationAlgo(NULL)
 {  
 }
@@ -196,30 +295,38 @@ void vtkPlusProbeCalibrationOptimizerAlgo::ComputeError(const vnl_matrix_fixed<d
   }
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationOptimizerAlgo::LogMatrix(vtkMatrix4x4* matrix)
+{
+  std::ostringstream matrixStream;
+  PlusMath::PrintVtkMatrix(matrix, matrixStream);
+  LOG_DYNAMIC(matrixStream.str(), this->LogLevel);
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ShowTransformation(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformationMatrix)
 {
-  LOG_INFO("Translation = [" << imageToProbeTransformationMatrix.get(0,3) << " " << imageToProbeTransformationMatrix.get(1,3) << " " << imageToProbeTransformationMatrix.get(2,3) << " ]");
+  LOG_DYNAMIC("Translation = [" << imageToProbeTransformationMatrix.get(0,3) << " " << imageToProbeTransformationMatrix.get(1,3) << " " << imageToProbeTransformationMatrix.get(2,3) << " ]", this->LogLevel);
 
   vnl_matrix_fixed<double,3,3> rotationMatrix=imageToProbeTransformationMatrix.extract(3,3);
   vnl_svd<double> svd(rotationMatrix);
   vnl_matrix<double> orthogonalizedRotationMatrix;
   orthogonalizedRotationMatrix = svd.U() * svd.V().transpose(); 
   double scale[3] = { svd.W(0), svd.W(1), svd.W(2) };
-  LOG_INFO("Scale = [" << scale[0] << " " << scale[1] << " " << scale[2] << " ]");
+  LOG_DYNAMIC("Scale = [" << scale[0] << " " << scale[1] << " " << scale[2] << " ]", this->LogLevel);
 
   vnl_vector<double> xAxis=imageToProbeTransformationMatrix.get_column(0);
   xAxis.normalize();
   vnl_vector<double> yAxis=imageToProbeTransformationMatrix.get_column(1);
   yAxis.normalize();
   double xyAxesAngleDeg=vtkMath::DegreesFromRadians(acos(dot_product(xAxis,yAxis)));
-  LOG_INFO("XY axes angle = " << xyAxesAngleDeg << " deg");
+  LOG_DYNAMIC("XY axes angle = " << xyAxesAngleDeg << " deg", this->LogLevel);
 
   double errorMean=0.0;
   double errorStDev=0.0;
   double errorRms=0.0;
   ComputeError(imageToProbeTransformationMatrix, errorMean, errorStDev, errorRms);
-  LOG_INFO("Error (mm): mean=" << errorMean<< ", stdev="<<errorStDev<<", rms="<<errorRms);
+  LOG_DYNAMIC("Error (mm): mean=" << errorMean<< ", stdev="<<errorStDev<<", rms="<<errorRms, this->LogLevel);
 
   return PLUS_SUCCESS;
 }
@@ -236,23 +343,132 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
   double errorStDev=0.0;
   double errorRms=0.0;
   ComputeError(this->ImageToProbeSeedTransformMatrix, errorMean, errorStDev, errorRms);
-  LOG_INFO("Initial cost function value with unconstrained matrix = " << errorRms );
+  LOG_DYNAMIC("Initial cost function value with unconstrained matrix = " << errorRms, this->LogLevel);
   {
     vtkSmartPointer<vtkMatrix4x4> vtkMatrix=vtkSmartPointer<vtkMatrix4x4>::New();
     PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeSeedTransformMatrix, vtkMatrix); 
-    PlusMath::LogVtkMatrix(vtkMatrix);
+    LogMatrix(vtkMatrix);
   }
 
   double initialError=costFunction->GetValue(imageToProbeSeedTransformParameters);
-  LOG_INFO("Initial cost function value with constrained matrix= " << initialError );
+  LOG_DYNAMIC("Initial cost function value with constrained matrix= " << initialError, this->LogLevel);
   {
     vnl_matrix_fixed<double,4,4> imageToProbeTransform_vnl;
     DistanceToWiresCostFunction::GetTransformMatrix(imageToProbeTransform_vnl, imageToProbeSeedTransformParameters);
     vtkSmartPointer<vtkMatrix4x4> vtkMatrix=vtkSmartPointer<vtkMatrix4x4>::New();
     PlusMath::ConvertVnlMatrixToVtkMatrix(imageToProbeTransform_vnl, vtkMatrix); 
-    PlusMath::LogVtkMatrix(vtkMatrix);
+    LogMatrix(vtkMatrix);
+  }
+
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  int numberOfStarts = std::max(this->NumberOfStarts, 1);
+  if (numberOfStarts == 1)
+  {
+    if (MinimizeFromStart(this->ImageToProbeSeedTransformMatrix, this->NumberOfThreads, this->ImageToProbeTransformMatrix, errorRms) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+  else
+  {
+    // Run the starts in parallel, each of them evaluates the residuals on a single thread
+    MinimizeStartsThreadFunctionInfoStruct str;
+    str.ImageToProbeSeedTransformMatrix = this->ImageToProbeSeedTransformMatrix;
+    str.ImageToProbeOptimizedTransformMatrices.resize(numberOfStarts);
+    str.ErrorRms.resize(numberOfStarts, DBL_MAX);
+    str.Status.resize(numberOfStarts, PLUS_FAIL);
+    std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, MinimizeStartsThreadFunctionInfoStruct*> threadData(this, &str);
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    if (this->NumberOfThreads > 0)
+    {
+      threader->SetNumberOfThreads(this->NumberOfThreads);
+    }
+    threader->SetSingleMethod(MinimizeStartsThreadFunction, &threadData);
+    threader->SingleMethodExecute();
+
+    // Keep the result with the lowest error, in case of equal errors the lowest start index wins
+    int bestStartIndex = -1;
+    for (int startIndex = 0; startIndex < numberOfStarts; ++startIndex)
+    {
+      if (str.Status[startIndex] != PLUS_SUCCESS)
+      {
+        LOG_WARNING("Optimization start " << startIndex << " failed");
+        continue;
+      }
+      LOG_DYNAMIC("Optimization start " << startIndex << ": RMS error = " << str.ErrorRms[startIndex], this->LogLevel);
+      if (bestStartIndex < 0 || str.ErrorRms[startIndex] < str.ErrorRms[bestStartIndex])
+      {
+        bestStartIndex = startIndex;
+      }
+    }
+    if (bestStartIndex < 0)
+    {
+      LOG_ERROR("All the " << numberOfStarts << " optimization starts failed");
+      return PLUS_FAIL;
+    }
+    LOG_DYNAMIC("Best result is obtained from optimization start " << bestStartIndex << " of " << numberOfStarts, this->LogLevel);
+    this->ImageToProbeTransformMatrix = str.ImageToProbeOptimizedTransformMatrices[bestStartIndex];
+  }
+  LOG_DYNAMIC("Optimization time: " << vtkPlusAccurateTimer::GetSystemTime() - startTime << " sec", this->LogLevel);
+
+  // Store the matrix
+  {
+    vtkSmartPointer<vtkMatrix4x4> vtkMatrix=vtkSmartPointer<vtkMatrix4x4>::New();
+    PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix, vtkMatrix); 
+    LogMatrix(vtkMatrix);
   }
 
+  // Store the optimized parameters and show the results
+  LOG_DYNAMIC("Cost function = " << GetOptimizationMethodAsString(this->OptimizationMethod) << ", minimizer = " << GetMinimizerAsString(this->Minimizer), this->LogLevel);
+
+  LOG_DYNAMIC("Without optimization:", this->LogLevel);
+  ShowTransformation(this->ImageToProbeSeedTransformMatrix);
+
+  LOG_DYNAMIC("With optimization:", this->LogLevel);
+  ShowTransformation(this->ImageToProbeTransformMatrix);
+
+  vtkSmartPointer<vtkMatrix4x4> imageToProbeSeedTransformMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> imageToProbeTransformMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
+  PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeSeedTransformMatrix,imageToProbeSeedTransformMatrixVtk);
+  PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix,imageToProbeTransformMatrixVtk);
+  double angleDifference = PlusMath::GetOrientationDifference(imageToProbeSeedTransformMatrixVtk, imageToProbeTransformMatrixVtk);
+  LOG_DYNAMIC("Orientation difference between unoptimized and optimized matrices =  " << angleDifference << " deg", this->LogLevel);
+
+  return PLUS_SUCCESS; 
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::MinimizeFromStart(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, int numberOfThreads, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix, double &errorRms)
+{
+  PlusStatus status = PLUS_FAIL;
+  switch (this->Minimizer)
+  {
+  case MINIMIZER_POWELL:
+    status = MinimizeUsingPowell(imageToProbeStartTransformMatrix, imageToProbeOptimizedTransformMatrix);
+    break;
+  case MINIMIZER_LEVENBERG_MARQUARDT:
+    status = MinimizeUsingLevenbergMarquardt(imageToProbeStartTransformMatrix, numberOfThreads, imageToProbeOptimizedTransformMatrix);
+    break;
+  default:
+    LOG_ERROR("Invalid minimizer");
+  }
+  if (status != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  double errorMean=0.0;
+  double errorStDev=0.0;
+  ComputeError(imageToProbeOptimizedTransformMatrix, errorMean, errorStDev, errorRms);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::MinimizeUsingPowell(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix)
+{
+  DistanceToWiresCostFunction::Pointer costFunction = new DistanceToWiresCostFunction(this);
+
   OptimizerType::Pointer  optimizer = OptimizerType::New();
   try 
   {
@@ -267,7 +483,7 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
   optimizer->SetStepLength( 10 );
   optimizer->SetStepTolerance( 1e-8 );
   optimizer->SetValueTolerance( 1e-8 );
-  optimizer->SetMaximumIteration( 300 );
+  optimizer->SetMaximumIteration( MAXIMUM_NUMBER_OF_ITERATIONS );
 
 
   const double rotationParametersScale=1.0;
@@ -303,7 +519,11 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
   }
   optimizer->SetScales(scales);
 
-  optimizer->SetInitialPosition(imageToProbeSeedTransformParameters);
+  DistanceToWiresCostFunction::ParametersType imageToProbeStartTransformParameters(costFunction->GetNumberOfParameters());
+  DistanceToWiresCostFunction::GetTransformParameters(imageToProbeStartTransformParameters, imageToProbeStartTransformMatrix);
+  optimizer->SetInitialPosition(imageToProbeStartTransformParameters);
+
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
 
   try 
   {
@@ -315,35 +535,287 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::Update()
     return PLUS_FAIL;
   }
 
+  double optimizationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
   std::string stopCondition=optimizer->GetStopConditionDescription();
-  LOG_INFO("Optimization stopping condition: "<<stopCondition<<". Number of iterations: " << optimizer->GetCurrentIteration());
+  LOG_DYNAMIC("Optimization stopping condition: "<<stopCondition<<". Number of iterations: " << optimizer->GetCurrentIteration(), this->LogLevel);
+  LOG_DYNAMIC("Powell optimization time: " << optimizationTimeSec << " sec (" << 1000.0 * optimizationTimeSec / std::max<unsigned int>(optimizer->GetCurrentIteration(), 1) << " ms per iteration)", this->LogLevel);
 
-  // Store the matrix
+  costFunction->GetTransformMatrix(imageToProbeOptimizedTransformMatrix, optimizer->GetCurrentPosition());
+  return PLUS_SUCCESS;
+}
 
-  costFunction->GetTransformMatrix(this->ImageToProbeTransformMatrix, optimizer->GetCurrentPosition());
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::MinimizeUsingLevenbergMarquardt(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, int numberOfThreads, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix)
+{
+  // Start from the same constrained (orthogonal, scaled) transform as Powell's method
+  bool isotropicPixelSpacing = this->IsotropicPixelSpacing;
+  unsigned int numberOfParameters = isotropicPixelSpacing ? 7 : 8;
+  DistanceToWiresCostFunction::ParametersType startParameters(numberOfParameters);
+  DistanceToWiresCostFunction::GetTransformParameters(startParameters, imageToProbeStartTransformMatrix);
+  vnl_matrix_fixed<double,4,4> imageToProbeMatrix;
+  DistanceToWiresCostFunction::GetTransformMatrix(imageToProbeMatrix, startParameters);
+
+  double scale[2] = { startParameters[6], isotropicPixelSpacing ? startParameters[6] : startParameters[7] };
+  double columnScale[3] = { scale[0], scale[1], ( scale[0] + scale[1] ) / 2 };
+  vnl_matrix_fixed<double,3,3> rotation;
+  for (int i = 0; i < 3; i++)
   {
-    vtkSmartPointer<vtkMatrix4x4> vtkMatrix=vtkSmartPointer<vtkMatrix4x4>::New();
-    PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix, vtkMatrix); 
-    PlusMath::LogVtkMatrix(vtkMatrix);
+    for (int j = 0; j < 3; j++)
+    {
+      rotation(i,j) = imageToProbeMatrix(i,j) / columnScale[j];
+    }
   }
+  vnl_vector_fixed<double,3> translation(imageToProbeMatrix(0,3), imageToProbeMatrix(1,3), imageToProbeMatrix(2,3));
+
+  int numberOfResidualsPerPoint = (this->OptimizationMethod == MINIMIZE_DISTANCE_OF_MIDDLE_WIRES_IN_3D ? 3 : 2);
+  double damping = LEVENBERG_MARQUARDT_INITIAL_DAMPING;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  int iteration = 0;
+  std::string stopCondition = "Maximum number of iterations reached";
+  for (iteration = 0; iteration < MAXIMUM_NUMBER_OF_ITERATIONS; iteration++)
+  {
+    double iterationStartTime = vtkPlusAccurateTimer::GetSystemTime();
+
+    // Normal equations of the matrix elements, chained with the derivatives of the matrix elements with respect to the parameters
+    double sumOfSquaredResiduals = 0.0;
+    int numberOfResiduals = 0;
+    vnl_matrix_fixed<double,12,12> matrixJacobianTransposeJacobian;
+    vnl_vector_fixed<double,12> matrixJacobianTransposeResiduals;
+    if (ComputeResidualSums(imageToProbeMatrix, numberOfThreads, sumOfSquaredResiduals, numberOfResiduals, &matrixJacobianTransposeJacobian, &matrixJacobianTransposeResiduals) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vnl_matrix<double> matrixDerivatives;
+    GetImageToProbeMatrixDerivatives(rotation, scale, isotropicPixelSpacing, matrixDerivatives);
+    vnl_matrix<double> jacobianTransposeJacobian = matrixDerivatives.transpose() * vnl_matrix<double>(matrixJacobianTransposeJacobian.data_block(), 12, 12) * matrixDerivatives;
+    vnl_vector<double> jacobianTransposeResiduals = matrixDerivatives.transpose() * vnl_vector<double>(matrixJacobianTransposeResiduals.data_block(), 12);
+
+    // Increase the damping until the step decreases the cost
+    bool stepAccepted = false;
+    double newSumOfSquaredResiduals = sumOfSquaredResiduals;
+    for (int dampingIncrease = 0; dampingIncrease < LEVENBERG_MARQUARDT_MAXIMUM_DAMPING_INCREASES && !stepAccepted; dampingIncrease++)
+    {
+      vnl_matrix<double> dampedJacobianTransposeJacobian = jacobianTransposeJacobian;
+      for (unsigned int k = 0; k < numberOfParameters; k++)
+      {
+        dampedJacobianTransposeJacobian(k,k) += damping * jacobianTransposeJacobian(k,k);
+      }
+      vnl_vector<double> step = vnl_svd<double>(dampedJacobianTransposeJacobian).solve(-jacobianTransposeResiduals);
+
+      vnl_matrix_fixed<double,3,3> newRotation = rotation * vnl_rotation_matrix(vnl_vector_fixed<double,3>(step[0], step[1], step[2]));
+      vnl_vector_fixed<double,3> newTranslation = translation + vnl_vector_fixed<double,3>(step[3], step[4], step[5]);
+      double newScale[2] = { scale[0] + step[6], isotropicPixelSpacing ? scale[0] + step[6] : scale[1] + step[7] };
+      vnl_matrix_fixed<double,4,4> newImageToProbeMatrix;
+      GetImageToProbeMatrix(newRotation, newTranslation, newScale, newImageToProbeMatrix);
+
+      int newNumberOfResiduals = 0;
+      if (ComputeResidualSums(newImageToProbeMatrix, numberOfThreads, newSumOfSquaredResiduals, newNumberOfResiduals, NULL, NULL) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+      if (newSumOfSquaredResiduals < sumOfSquaredResiduals)
+      {
+        rotation = newRotation;
+        translation = newTranslation;
+        scale[0] = newScale[0];
+        scale[1] = newScale[1];
+        imageToProbeMatrix = newImageToProbeMatrix;
+        damping /= 10.0;
+        stepAccepted = true;
+      }
+      else
+      {
+        damping *= 10.0;
+      }
+    }
 
-  // Store the optimized parameters and show the results
-  LOG_INFO("Cost function = " << GetOptimizationMethodAsString(this->OptimizationMethod));
+    double currentSumOfSquaredResiduals = (stepAccepted ? newSumOfSquaredResiduals : sumOfSquaredResiduals);
+    LOG_DEBUG("Levenberg-Marquardt iteration " << iteration << ": RMS error = " << sqrt(currentSumOfSquaredResiduals * numberOfResidualsPerPoint / std::max(numberOfResiduals, 1))
+      << ", damping = " << damping << ", iteration time = " << 1000.0 * (vtkPlusAccurateTimer::GetSystemTime() - iterationStartTime) << " ms");
 
-  LOG_INFO("Without optimization:");
-  ShowTransformation(this->ImageToProbeSeedTransformMatrix);
+    if (!stepAccepted)
+    {
+      stopCondition = "No step decreases the cost function";
+      break;
+    }
+    if (sumOfSquaredResiduals - newSumOfSquaredResiduals <= LEVENBERG_MARQUARDT_RELATIVE_VALUE_TOLERANCE * sumOfSquaredResiduals)
+    {
+      stopCondition = "Relative cost function change is below tolerance";
+      iteration++;
+      break;
+    }
+  }
 
-  LOG_INFO("With optimization:");
-  ShowTransformation(this->ImageToProbeTransformMatrix);
+  double optimizationTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+  LOG_DYNAMIC("Optimization stopping condition: " << stopCondition << ". Number of iterations: " << iteration, this->LogLevel);
+  LOG_DYNAMIC("Levenberg-Marquardt optimization time: " << optimizationTimeSec << " sec (" << 1000.0 * optimizationTimeSec / std::max(iteration, 1) << " ms per iteration)", this->LogLevel);
 
-  vtkSmartPointer<vtkMatrix4x4> imageToProbeSeedTransformMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
-  vtkSmartPointer<vtkMatrix4x4> imageToProbeTransformMatrixVtk = vtkSmartPointer<vtkMatrix4x4>::New();
-  PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeSeedTransformMatrix,imageToProbeSeedTransformMatrixVtk);
-  PlusMath::ConvertVnlMatrixToVtkMatrix(this->ImageToProbeTransformMatrix,imageToProbeTransformMatrixVtk);
-  double angleDifference = PlusMath::GetOrientationDifference(imageToProbeSeedTransformMatrixVtk, imageToProbeTransformMatrixVtk);
-  LOG_INFO("Orientation difference between unoptimized and optimized matrices =  " << angleDifference << " deg");
+  imageToProbeOptimizedTransformMatrix = imageToProbeMatrix;
+  return PLUS_SUCCESS;
+}
 
-  return PLUS_SUCCESS; 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ComputeResidualSums(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformMatrix, int numberOfThreads, double &sumOfSquaredResiduals, int &numberOfResiduals,
+  vnl_matrix_fixed<double,12,12>* jacobianTransposeJacobian, vnl_vector_fixed<double,12>* jacobianTransposeResiduals)
+{
+  if (this->ProbeCalibrationAlgo == NULL)
+  {
+    LOG_ERROR("Probe calibration algorithm is not set");
+    return PLUS_FAIL;
+  }
+  if (this->OptimizationMethod != MINIMIZE_DISTANCE_OF_MIDDLE_WIRES_IN_3D && this->OptimizationMethod != MINIMIZE_DISTANCE_OF_ALL_WIRES_IN_2D)
+  {
+    LOG_ERROR("Invalid cost function");
+    return PLUS_FAIL;
+  }
+
+  ComputeResidualSumsThreadFunctionInfoStruct str;
+  str.ImageToProbeTransformMatrix = imageToProbeTransformMatrix;
+  str.NumberOfFrames = this->ProbeCalibrationAlgo->GetNumberOfNonOutlierCalibrationFrames();
+  str.ComputeNormalEquations = (jacobianTransposeJacobian != NULL && jacobianTransposeResiduals != NULL);
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (numberOfThreads > 0)
+  {
+    threader->SetNumberOfThreads(numberOfThreads);
+  }
+  int numberOfUsedThreads = threader->GetNumberOfThreads();
+  str.SumOfSquaredResiduals.resize(numberOfUsedThreads, 0.0);
+  str.NumberOfResiduals.resize(numberOfUsedThreads, 0);
+  str.JacobianTransposeJacobian.resize(numberOfUsedThreads, vnl_matrix_fixed<double,12,12>(0.0));
+  str.JacobianTransposeResiduals.resize(numberOfUsedThreads, vnl_vector_fixed<double,12>(0.0));
+  std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, ComputeResidualSumsThreadFunctionInfoStruct*> threadData(this, &str);
+  threader->SetSingleMethod(ComputeResidualSumsThreadFunction, &threadData);
+  threader->SingleMethodExecute();
+
+  // Add the partial sums in thread order
+  sumOfSquaredResiduals = 0.0;
+  numberOfResiduals = 0;
+  if (str.ComputeNormalEquations)
+  {
+    jacobianTransposeJacobian->fill(0.0);
+    jacobianTransposeResiduals->fill(0.0);
+  }
+  for (int threadIndex = 0; threadIndex < numberOfUsedThreads; ++threadIndex)
+  {
+    sumOfSquaredResiduals += str.SumOfSquaredResiduals[threadIndex];
+    numberOfResiduals += str.NumberOfResiduals[threadIndex];
+    if (str.ComputeNormalEquations)
+    {
+      (*jacobianTransposeJacobian) += str.JacobianTransposeJacobian[threadIndex];
+      (*jacobianTransposeResiduals) += str.JacobianTransposeResiduals[threadIndex];
+    }
+  }
+  if (numberOfResiduals == 0)
+  {
+    LOG_ERROR("No calibration data is available for optimization");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusProbeCalibrationOptimizerAlgo::ComputeResidualSumsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, ComputeResidualSumsThreadFunctionInfoStruct*>* threadData =
+    static_cast< std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, ComputeResidualSumsThreadFunctionInfoStruct*>* >(threadInfo->UserData);
+  vtkPlusProbeCalibrationOptimizerAlgo* self = threadData->first;
+  ComputeResidualSumsThreadFunctionInfoStruct* str = threadData->second;
+  int threadIndex = threadInfo->ThreadID;
+
+  // Each thread processes a contiguous range of frames
+  int firstFrameIndex = static_cast<int>(static_cast<long long>(str->NumberOfFrames) * threadIndex / threadInfo->NumberOfThreads);
+  int endFrameIndex = static_cast<int>(static_cast<long long>(str->NumberOfFrames) * (threadIndex + 1) / threadInfo->NumberOfThreads);
+
+  std::vector<double> residuals;
+  std::vector<double> residualDerivatives;
+  std::vector<double>* residualDerivativesPtr = (str->ComputeNormalEquations ? &residualDerivatives : NULL);
+  if (self->OptimizationMethod == MINIMIZE_DISTANCE_OF_MIDDLE_WIRES_IN_3D)
+  {
+    self->ProbeCalibrationAlgo->ComputeResiduals3d(str->ImageToProbeTransformMatrix, firstFrameIndex, endFrameIndex, residuals, residualDerivativesPtr);
+  }
+  else
+  {
+    self->ProbeCalibrationAlgo->ComputeResiduals2d(str->ImageToProbeTransformMatrix, firstFrameIndex, endFrameIndex, residuals, residualDerivativesPtr);
+  }
+
+  double sumOfSquaredResiduals = 0.0;
+  double* jacobianTransposeJacobian = str->JacobianTransposeJacobian[threadIndex].data_block();
+  double* jacobianTransposeResiduals = str->JacobianTransposeResiduals[threadIndex].data_block();
+  for (unsigned int residualIndex = 0; residualIndex < residuals.size(); ++residualIndex)
+  {
+    double residual = residuals[residualIndex];
+    sumOfSquaredResiduals += residual * residual;
+    if (!str->ComputeNormalEquations)
+    {
+      continue;
+    }
+    const double* derivatives = &residualDerivatives[12 * residualIndex];
+    for (int a = 0; a < 12; ++a)
+    {
+      jacobianTransposeResiduals[a] += derivatives[a] * residual;
+      for (int b = 0; b < 12; ++b)
+      {
+        jacobianTransposeJacobian[12 * a + b] += derivatives[a] * derivatives[b];
+      }
+    }
+  }
+  str->SumOfSquaredResiduals[threadIndex] = sumOfSquaredResiduals;
+  str->NumberOfResiduals[threadIndex] = residuals.size();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusProbeCalibrationOptimizerAlgo::GetStartTransform(int startIndex, const vnl_matrix_fixed<double,4,4> &imageToProbeSeedTransformMatrix, vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix)
+{
+  imageToProbeStartTransformMatrix = imageToProbeSeedTransformMatrix;
+  if (startIndex == 0)
+  {
+    return;
+  }
+
+  // Perturbations are generated from the start index, so the starts are the same in every run
+  vnl_random randomGenerator(startIndex);
+  double maxRotationRad = vtkMath::RadiansFromDegrees(MULTI_START_ROTATION_PERTURBATION_DEG);
+  vnl_vector_fixed<double,3> rotationVector;
+  for (int i = 0; i < 3; i++)
+  {
+    rotationVector[i] = randomGenerator.drand64(-maxRotationRad, maxRotationRad);
+  }
+  double scaleFactor = 1.0 + randomGenerator.drand64(-MULTI_START_SCALE_PERTURBATION, MULTI_START_SCALE_PERTURBATION);
+  vnl_matrix_fixed<double,3,3> seedLinearPart = imageToProbeSeedTransformMatrix.extract(3,3);
+  vnl_matrix_fixed<double,3,3> startLinearPart = seedLinearPart * vnl_rotation_matrix(rotationVector);
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      imageToProbeStartTransformMatrix(i,j) = startLinearPart(i,j) * scaleFactor;
+    }
+    imageToProbeStartTransformMatrix(i,3) += randomGenerator.drand64(-MULTI_START_TRANSLATION_PERTURBATION_MM, MULTI_START_TRANSLATION_PERTURBATION_MM);
+  }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusProbeCalibrationOptimizerAlgo::MinimizeStartsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, MinimizeStartsThreadFunctionInfoStruct*>* threadData =
+    static_cast< std::pair<vtkPlusProbeCalibrationOptimizerAlgo*, MinimizeStartsThreadFunctionInfoStruct*>* >(threadInfo->UserData);
+  vtkPlusProbeCalibrationOptimizerAlgo* self = threadData->first;
+  MinimizeStartsThreadFunctionInfoStruct* str = threadData->second;
+
+  // Starts are distributed among the threads in an interleaved way
+  int numberOfStarts = str->Status.size();
+  for (int startIndex = threadInfo->ThreadID; startIndex < numberOfStarts; startIndex += threadInfo->NumberOfThreads)
+  {
+    vnl_matrix_fixed<double,4,4> imageToProbeStartTransformMatrix;
+    self->GetStartTransform(startIndex, str->ImageToProbeSeedTransformMatrix, imageToProbeStartTransformMatrix);
+    str->Status[startIndex] = self->MinimizeFromStart(imageToProbeStartTransformMatrix, 1, str->ImageToProbeOptimizedTransformMatrices[startIndex], str->ErrorRms[startIndex]);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
 }
 
 //----------------------------------------------------------------------------
@@ -383,6 +855,19 @@ const char* vtkPlusProbeCalibrationOptimizerAlgo::GetOptimizationMethodAsString(
   }
 }
 
+//----------------------------------------------------------------------------
+const char* vtkPlusProbeCalibrationOptimizerAlgo::GetMinimizerAsString(MinimizerType type)
+{
+  switch (type)
+  {
+  case MINIMIZER_POWELL: return "POWELL";
+  case MINIMIZER_LEVENBERG_MARQUARDT: return "LEVENBERG_MARQUARDT";
+  default:
+    LOG_ERROR("Unknown minimizer: "<<type);
+    return "unknown";
+  }
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ReadConfiguration( vtkXMLDataElement* aConfig )
 {
@@ -414,6 +899,11 @@ PlusStatus vtkPlusProbeCalibrationOptimizerAlgo::ReadConfiguration( vtkXMLDataEl
   }
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IsotropicPixelSpacing, aConfig);
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(Minimizer, aConfig,
+    GetMinimizerAsString(MINIMIZER_POWELL), MINIMIZER_POWELL,
+    GetMinimizerAsString(MINIMIZER_LEVENBERG_MARQUARDT), MINIMIZER_LEVENBERG_MARQUARDT);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfStarts, aConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfThreads, aConfig);
 
   return PLUS_SUCCESS;
 }
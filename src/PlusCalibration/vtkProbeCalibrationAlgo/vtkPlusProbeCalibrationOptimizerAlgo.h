@@ -9,12 +9,14 @@ See License.txt for details.
 
 #include "PlusConfigure.h"
 
+#include "vtkMultiThreader.h"
 #include "vtkObject.h"
 
 #include "PlusFidPatternRecognitionCommon.h"
 
 #include <set>
 
+class vtkMatrix4x4;
 class vtkXMLDataElement;
 class vtkPlusProbeCalibrationAlgo;
 
@@ -31,6 +33,11 @@ class vtkPlusProbeCalibrationAlgo;
   it is more accurate to optimize the in-plane (2D) error. Also this optimizer enforces orthogonality of the image to
   probe matrix and optionally it can enforce isotropic image pixel spacing.
 
+  The cost function can be minimized by Powell's method (default) or by the Levenberg-Marquardt method using analytic
+  derivatives of the reprojection error residuals, which are evaluated on multiple threads. The optimization can be
+  started from multiple initial transforms (the seed transform and perturbed versions of it) in parallel and the
+  result with the lowest error is kept.
+
   \ingroup PlusLibCalibrationAlgo
 */
 class vtkPlusProbeCalibrationOptimizerAlgo : public vtkObject
@@ -46,6 +53,13 @@ public:
     MINIMIZE_DISTANCE_OF_ALL_WIRES_IN_2D
   };  
 
+  /* Choose one of the possible minimization methods */
+  enum MinimizerType
+  {
+    MINIMIZER_POWELL,
+    MINIMIZER_LEVENBERG_MARQUARDT
+  };
+
   vtkTypeMacro(vtkPlusProbeCalibrationOptimizerAlgo,vtkObject);
   static vtkPlusProbeCalibrationOptimizerAlgo *New();
 
@@ -75,6 +89,22 @@ public:
   void SetOptimizationMethod(OptimizationMethodType optimizationMethod) { this->OptimizationMethod=optimizationMethod; }
   static const char* GetOptimizationMethodAsString(OptimizationMethodType type);
 
+  MinimizerType GetMinimizer() { return this->Minimizer; }
+  void SetMinimizer(MinimizerType minimizer) { this->Minimizer=minimizer; }
+  static const char* GetMinimizerAsString(MinimizerType type);
+
+  /*! Number of initial transforms the optimization is started from (1 means that only the seed transform is used) */
+  int GetNumberOfStarts() { return this->NumberOfStarts; }
+  void SetNumberOfStarts(int numberOfStarts) { this->NumberOfStarts=numberOfStarts; }
+
+  /*! Number of threads used for running the starts or evaluating the residuals. If 0 then the number of threads is the number of processors. */
+  int GetNumberOfThreads() { return this->NumberOfThreads; }
+  void SetNumberOfThreads(int numberOfThreads) { this->NumberOfThreads=numberOfThreads; }
+
+  /*! Log level of the optimization progress and result messages. Debug level is used when the optimization is repeated many times, such as in cross-validation. */
+  vtkPlusLogger::LogLevelType GetLogLevel() { return this->LogLevel; }
+  void SetLogLevel(vtkPlusLogger::LogLevelType logLevel) { this->LogLevel=logLevel; }
+
   void SetImageToProbeSeedTransform(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformMatrix);
 
   void SetProbeCalibrationAlgo(vtkPlusProbeCalibrationAlgo* probeCalibrationAlgo);
@@ -82,6 +112,46 @@ public:
 protected:
 
   PlusStatus ShowTransformation(const vnl_matrix_fixed<double,4,4> &transformationMatrix);
+
+  /*! Log a matrix at the optimization log level */
+  void LogMatrix(vtkMatrix4x4* matrix);
+
+  /*!
+    Run the selected minimizer from an initial transform
+    \param imageToProbeStartTransformMatrix Initial transform
+    \param numberOfThreads Number of threads used for evaluating the residuals (only used by the Levenberg-Marquardt minimizer)
+    \param imageToProbeOptimizedTransformMatrix Optimized transform
+    \param errorRms Root mean square error of the optimized transform
+  */
+  PlusStatus MinimizeFromStart(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, int numberOfThreads, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix, double &errorRms);
+
+  /*! Minimize the cost function using Powell's method */
+  PlusStatus MinimizeUsingPowell(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix);
+
+  /*! Minimize the sum of squared residuals using the Levenberg-Marquardt method with analytic derivatives */
+  PlusStatus MinimizeUsingLevenbergMarquardt(const vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix, int numberOfThreads, vnl_matrix_fixed<double,4,4> &imageToProbeOptimizedTransformMatrix);
+
+  /*!
+    Compute the sum of squared residuals and optionally the normal equations with respect to the upper 3x4 elements of the image to probe matrix.
+    Frames are split between the threads and the partial sums are added in thread order, so the result is reproducible for a given number of threads.
+    \param imageToProbeTransformMatrix Image to probe transform
+    \param numberOfThreads Number of threads used for evaluating the residuals
+    \param sumOfSquaredResiduals Sum of squared residuals
+    \param numberOfResiduals Number of residuals
+    \param jacobianTransposeJacobian If not NULL then J^T*J is computed, where J is the derivative of the residuals with respect to the matrix elements
+    \param jacobianTransposeResiduals If not NULL then J^T*r is computed
+  */
+  PlusStatus ComputeResidualSums(const vnl_matrix_fixed<double,4,4> &imageToProbeTransformMatrix, int numberOfThreads, double &sumOfSquaredResiduals, int &numberOfResiduals,
+    vnl_matrix_fixed<double,12,12>* jacobianTransposeJacobian, vnl_vector_fixed<double,12>* jacobianTransposeResiduals);
+
+  /*! Get the initial transform of a start: the seed transform for the first start and randomly perturbed seed transforms for the others */
+  void GetStartTransform(int startIndex, const vnl_matrix_fixed<double,4,4> &imageToProbeSeedTransformMatrix, vnl_matrix_fixed<double,4,4> &imageToProbeStartTransformMatrix);
+
+  /*! Thread function for running optimization starts in parallel */
+  static VTK_THREAD_RETURN_TYPE MinimizeStartsThreadFunction(void* arg);
+
+  /*! Thread function for computing residual sums on a range of frames */
+  static VTK_THREAD_RETURN_TYPE ComputeResidualSumsThreadFunction(void* arg);
   
   vtkPlusProbeCalibrationOptimizerAlgo();
   virtual  ~vtkPlusProbeCalibrationOptimizerAlgo();
@@ -93,6 +163,18 @@ protected:
   /*! Cost function to minimize during the optimization */
   OptimizationMethodType OptimizationMethod;
 
+  /*! Method used for minimizing the cost function */
+  MinimizerType Minimizer;
+
+  /*! Number of initial transforms the optimization is started from */
+  int NumberOfStarts;
+
+  /*! Number of threads used for running the starts or evaluating the residuals (0 = number of processors) */
+  int NumberOfThreads;
+
+  /*! Log level of the optimization progress and result messages */
+  vtkPlusLogger::LogLevelType LogLevel;
+
   /*! Store the seed for the optimization process */
   vnl_matrix_fixed<double,4,4> ImageToProbeSeedTransformMatrix;
 
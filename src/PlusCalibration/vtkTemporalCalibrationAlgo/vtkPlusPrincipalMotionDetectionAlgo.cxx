@@ -13,6 +13,11 @@
 #include "vtkTable.h"
 #include "vtkPCAStatistics.h"
 
+#include "vnl/vnl_matrix.h"
+#include "vnl/vnl_vector.h"
+#include "vnl/algo/vnl_symmetric_eigensystem.h"
+
+#include "vtkPlusColumnarTrackedFrameList.h"
 #include "vtkPlusPrincipalMotionDetectionAlgo.h"
 #include "vtkPlusTransformRepository.h"
 #include "vtkPlusTrackedFrameList.h"
@@ -26,17 +31,28 @@ vtkPlusPrincipalMotionDetectionAlgo::vtkPlusPrincipalMotionDetectionAlgo()
 {
   m_SignalTimeRangeMin = 0.0;
   m_SignalTimeRangeMax = -1.0;
+  m_ForgettingFactor = 1.0;
+  m_MaximumSignalLength = 0;
+  m_IncrementalTransformRepository = vtkPlusTransformRepository::New();
+  ResetIncrementalEstimate();
 }
 
 //-----------------------------------------------------------------------------
 vtkPlusPrincipalMotionDetectionAlgo::~vtkPlusPrincipalMotionDetectionAlgo()
 {
+  if (m_IncrementalTransformRepository != NULL)
+  {
+    m_IncrementalTransformRepository->Delete();
+    m_IncrementalTransformRepository = NULL;
+  }
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusPrincipalMotionDetectionAlgo::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "ForgettingFactor: " << m_ForgettingFactor << std::endl;
+  os << indent << "MaximumSignalLength: " << m_MaximumSignalLength << std::endl;
 }
 
 //-----------------------------------------------------------------------------
@@ -91,48 +107,54 @@ PlusStatus vtkPlusPrincipalMotionDetectionAlgo::ComputeTrackerPositionMetric()
   m_SignalTimestamps.clear();
   m_SignalValues.clear();
 
+  // Get timestamps and ProbeToReference transforms of all frames as contiguous arrays
+  vtkSmartPointer<vtkPlusColumnarTrackedFrameList> trackerFrameColumns = vtkSmartPointer<vtkPlusColumnarTrackedFrameList>::New();
+  if (trackerFrameColumns->BuildFromTrackedFrameList(m_TrackerFrames, false) != PLUS_SUCCESS
+      || trackerFrameColumns->AddComputedTransformColumn(transformName, transformRepository) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot compute tracker position metric, failed to get " << m_ProbeToReferenceTransformName << " transforms of the tracker frames");
+    return PLUS_FAIL;
+  }
+  const int probeToReferenceColumnIndex = trackerFrameColumns->GetTransformColumnIndex(transformName);
+  const double* probeToReferenceMatrices = trackerFrameColumns->GetTransformMatrices(probeToReferenceColumnIndex);
+  const unsigned char* probeToReferenceValidFlags = trackerFrameColumns->GetTransformValidFlags(probeToReferenceColumnIndex);
+  const double* timestamps = trackerFrameColumns->GetTimestamps();
+
   // Find the mean tracker position
   itk::Point<double, 3> trackerPositionSum;
   trackerPositionSum[0] = trackerPositionSum[1] = trackerPositionSum[2] = 0.0;
   std::deque<itk::Point<double, 3> > trackerPositions;
   int numberOfValidFrames = 0;
   bool signalTimeRangeDefined = (m_SignalTimeRangeMin <= m_SignalTimeRangeMax);
-  for (unsigned int frame = 0; frame < m_TrackerFrames->GetNumberOfTrackedFrames(); ++frame)
+  for (int frame = 0; frame < trackerFrameColumns->GetNumberOfFrames(); ++frame)
   {
-    PlusTrackedFrame* trackedFrame = m_TrackerFrames->GetTrackedFrame(frame);
-
-    if (signalTimeRangeDefined && (trackedFrame->GetTimestamp() < m_SignalTimeRangeMin || trackedFrame->GetTimestamp() > m_SignalTimeRangeMax))
+    if (signalTimeRangeDefined && (timestamps[frame] < m_SignalTimeRangeMin || timestamps[frame] > m_SignalTimeRangeMax))
     {
       // frame is out of the specified signal range
       continue;
     }
 
-    transformRepository->SetTransforms(*trackedFrame);
-
-
-    vtkSmartPointer<vtkMatrix4x4> probeToReferenceTransform = vtkSmartPointer<vtkMatrix4x4>::New();
-    bool valid = false;
-    transformRepository->GetTransform(transformName, probeToReferenceTransform, &valid);
-    if (!valid)
+    if (!probeToReferenceValidFlags[frame])
     {
       // There is no available transform for this frame; skip that frame
       continue;
     }
 
-    //  Store current tracker position
+    //  Store current tracker position (translation column of the row-major matrix)
+    const double* probeToReferenceMatrix = probeToReferenceMatrices + 16 * frame;
     itk::Point<double, 3> currTrackerPosition;
-    currTrackerPosition[0] = probeToReferenceTransform->GetElement(0, 3);
-    currTrackerPosition[1] = probeToReferenceTransform->GetElement(1, 3);
-    currTrackerPosition[2] = probeToReferenceTransform->GetElement(2, 3);
+    currTrackerPosition[0] = probeToReferenceMatrix[3];
+    currTrackerPosition[1] = probeToReferenceMatrix[7];
+    currTrackerPosition[2] = probeToReferenceMatrix[11];
     trackerPositions.push_back(currTrackerPosition);
 
     // Add current tracker position to the running total
-    trackerPositionSum[0] = trackerPositionSum[0] + probeToReferenceTransform->GetElement(0, 3);
-    trackerPositionSum[1] = trackerPositionSum[1] + probeToReferenceTransform->GetElement(1, 3);
-    trackerPositionSum[2] = trackerPositionSum[2] + probeToReferenceTransform->GetElement(2, 3);
+    trackerPositionSum[0] = trackerPositionSum[0] + currTrackerPosition[0];
+    trackerPositionSum[1] = trackerPositionSum[1] + currTrackerPosition[1];
+    trackerPositionSum[2] = trackerPositionSum[2] + currTrackerPosition[2];
     ++numberOfValidFrames;
 
-    m_SignalTimestamps.push_back(trackedFrame->GetTimestamp());   // These timestamps will be in the desired time range
+    m_SignalTimestamps.push_back(timestamps[frame]);   // These timestamps will be in the desired time range
   }
 
   // Calculate the principal axis of motion (using PCA)
@@ -247,3 +269,175 @@ void vtkPlusPrincipalMotionDetectionAlgo::GetDetectedPositions(std::deque<double
 {
   positions = m_SignalValues;
 }
+
+//-----------------------------------------------------------------------------
+void vtkPlusPrincipalMotionDetectionAlgo::ResetIncrementalEstimate()
+{
+  m_IncrementalSumOfWeights = 0.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    m_IncrementalMean[i] = 0.0;
+    m_IncrementalPrincipalAxis[i] = 0.0;
+    for (int j = 0; j < 3; ++j)
+    {
+      m_IncrementalScatter[i][j] = 0.0;
+    }
+  }
+  m_IncrementalPrincipalAxisValid = false;
+  m_SignalTimestamps.clear();
+  m_SignalValues.clear();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusPrincipalMotionDetectionAlgo::SetForgettingFactor(double forgettingFactor)
+{
+  if (forgettingFactor <= 0.0 || forgettingFactor > 1.0)
+  {
+    LOG_ERROR("Invalid forgetting factor: " << forgettingFactor << ". It must be in the (0, 1] range.");
+    return PLUS_FAIL;
+  }
+  m_ForgettingFactor = forgettingFactor;
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+double vtkPlusPrincipalMotionDetectionAlgo::GetForgettingFactor() const
+{
+  return m_ForgettingFactor;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusPrincipalMotionDetectionAlgo::SetMaximumSignalLength(unsigned int maximumSignalLength)
+{
+  m_MaximumSignalLength = maximumSignalLength;
+  while (m_MaximumSignalLength > 0 && m_SignalValues.size() > m_MaximumSignalLength)
+  {
+    m_SignalValues.pop_front();
+    m_SignalTimestamps.pop_front();
+  }
+}
+
+//-----------------------------------------------------------------------------
+unsigned int vtkPlusPrincipalMotionDetectionAlgo::GetMaximumSignalLength() const
+{
+  return m_MaximumSignalLength;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusPrincipalMotionDetectionAlgo::AddTrackedFrame(PlusTrackedFrame& trackedFrame)
+{
+  bool signalTimeRangeDefined = (m_SignalTimeRangeMin <= m_SignalTimeRangeMax);
+  if (signalTimeRangeDefined && (trackedFrame.GetTimestamp() < m_SignalTimeRangeMin || trackedFrame.GetTimestamp() > m_SignalTimeRangeMax))
+  {
+    // frame is out of the specified signal range
+    return PLUS_SUCCESS;
+  }
+
+  PlusTransformName transformName;
+  if (transformName.SetTransformName(m_ProbeToReferenceTransformName.c_str()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cannot add tracked frame, transform name is invalid (" << m_ProbeToReferenceTransformName << ")");
+    return PLUS_FAIL;
+  }
+
+  m_IncrementalTransformRepository->SetTransforms(trackedFrame);
+  vtkSmartPointer<vtkMatrix4x4> probeToReferenceTransform = vtkSmartPointer<vtkMatrix4x4>::New();
+  bool valid = false;
+  m_IncrementalTransformRepository->GetTransform(transformName, probeToReferenceTransform, &valid);
+  if (!valid)
+  {
+    // There is no available transform for this frame; skip that frame
+    return PLUS_SUCCESS;
+  }
+
+  double position[3] =
+  {
+    probeToReferenceTransform->GetElement(0, 3),
+    probeToReferenceTransform->GetElement(1, 3),
+    probeToReferenceTransform->GetElement(2, 3)
+  };
+  return AddTrackerPosition(trackedFrame.GetTimestamp(), position);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusPrincipalMotionDetectionAlgo::AddTrackerPosition(double timestamp, const double position[3])
+{
+  // Update the exponentially weighted mean and scatter matrix (weighted Welford update).
+  // Previous samples are down-weighted by the forgetting factor, the new sample has unit weight.
+  double previousSumOfWeights = m_ForgettingFactor * m_IncrementalSumOfWeights;
+  m_IncrementalSumOfWeights = previousSumOfWeights + 1.0;
+  double deviation[3] = {0.0, 0.0, 0.0};
+  for (int i = 0; i < 3; ++i)
+  {
+    deviation[i] = position[i] - m_IncrementalMean[i];
+    m_IncrementalMean[i] += deviation[i] / m_IncrementalSumOfWeights;
+  }
+  double scatterUpdateWeight = previousSumOfWeights / m_IncrementalSumOfWeights;
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      m_IncrementalScatter[i][j] = m_ForgettingFactor * m_IncrementalScatter[i][j] + scatterUpdateWeight * deviation[i] * deviation[j];
+    }
+  }
+
+  // The principal axis is the eigenvector of the largest eigenvalue of the 3x3 covariance matrix
+  vnl_matrix<double> covariance(3, 3);
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      covariance(i, j) = m_IncrementalScatter[i][j] / m_IncrementalSumOfWeights;
+    }
+  }
+  vnl_matrix<double> eigenvectors(3, 3);
+  vnl_vector<double> eigenvalues(3);
+  vnl_symmetric_eigensystem_compute(covariance, eigenvectors, eigenvalues);
+  // Eigenvalues are sorted in ascending order
+  if (eigenvalues(2) <= 0.0)
+  {
+    // All the positions are identical so far, principal axis is undefined
+    return PLUS_SUCCESS;
+  }
+
+  double principalAxis[3] = { eigenvectors(0, 2), eigenvectors(1, 2), eigenvectors(2, 2) };
+  if (m_IncrementalPrincipalAxisValid)
+  {
+    // Eigenvector sign is arbitrary, keep it consistent with the previous axis to avoid flipping the signal
+    if (vtkMath::Dot(principalAxis, m_IncrementalPrincipalAxis) < 0)
+    {
+      principalAxis[0] = -principalAxis[0];
+      principalAxis[1] = -principalAxis[1];
+      principalAxis[2] = -principalAxis[2];
+    }
+  }
+  m_IncrementalPrincipalAxis[0] = principalAxis[0];
+  m_IncrementalPrincipalAxis[1] = principalAxis[1];
+  m_IncrementalPrincipalAxis[2] = principalAxis[2];
+  m_IncrementalPrincipalAxisValid = true;
+
+  // Project the current tracker position onto the principal axis of motion (same metric as in batch mode)
+  double currTrackerPositionProjection = position[0] * principalAxis[0] + position[1] * principalAxis[1] + position[2] * principalAxis[2];
+  m_SignalTimestamps.push_back(timestamp);
+  m_SignalValues.push_back(currTrackerPositionProjection);
+  if (m_MaximumSignalLength > 0 && m_SignalValues.size() > m_MaximumSignalLength)
+  {
+    m_SignalValues.pop_front();
+    m_SignalTimestamps.pop_front();
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusPrincipalMotionDetectionAlgo::GetIncrementalPrincipalAxis(double principalAxisOfMotion[3])
+{
+  if (!m_IncrementalPrincipalAxisValid)
+  {
+    return PLUS_FAIL;
+  }
+  principalAxisOfMotion[0] = m_IncrementalPrincipalAxis[0];
+  principalAxisOfMotion[1] = m_IncrementalPrincipalAxis[1];
+  principalAxisOfMotion[2] = m_IncrementalPrincipalAxis[2];
+  return PLUS_SUCCESS;
+}
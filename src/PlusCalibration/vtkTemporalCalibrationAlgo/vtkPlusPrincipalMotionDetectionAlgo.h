@@ -10,11 +10,20 @@
 #include <deque>
 #include "vtkObject.h"
 
+class PlusTrackedFrame;
 class vtkPlusTrackedFrameList;
+class vtkPlusTransformRepository;
 
 /*!
   \class vtkPlusPrincipalMotionDetectionAlgo
   \brief Extract the motion component along the the principal axis of the motion. Used for computing a position metric from a periodically moving tool.
+
+  The signal can be computed in two ways:
+  - Batch mode: set the input frames by SetTrackerFrames and call Update(). The principal axis is computed from all the frames in the signal time range.
+  - Incremental mode: add samples one by one by AddTrackedFrame or AddTrackerPosition (e.g., as they arrive from a live channel).
+    A running mean and covariance is maintained with exponential forgetting and each new sample is projected to the current principal axis,
+    so processing time and memory usage per sample is constant.
+
   \ingroup PlusLibCalibrationAlgorithm
 */
 class vtkPlusPrincipalMotionDetectionAlgo: public vtkObject
@@ -47,6 +56,40 @@ public:
 
   void ComputePrincipalAxis(std::deque<itk::Point<double, 3> >& trackerPositions, itk::Point<double, 3>& principalAxisOfMotion, int numValidFrames);
 
+  /*! Clear the running mean and covariance and the signal that has been computed so far in incremental mode */
+  void ResetIncrementalEstimate();
+
+  /*!
+    Set the forgetting factor used in incremental mode. Weight of each previous sample is multiplied by this factor when a new sample is added,
+    therefore the effective length of the averaging window is about 1/(1-forgettingFactor) samples.
+    Value must be in the (0, 1] range. 1.0 means no forgetting (all the samples have equal weight). Default is 1.0.
+  */
+  PlusStatus SetForgettingFactor(double forgettingFactor);
+  double GetForgettingFactor() const;
+
+  /*! Set the maximum number of samples that are kept in the signal in incremental mode, oldest samples are discarded. 0 means unlimited. Default is 0. */
+  void SetMaximumSignalLength(unsigned int maximumSignalLength);
+  unsigned int GetMaximumSignalLength() const;
+
+  /*!
+    Add a tracker position in incremental mode. The running mean and covariance is updated, the principal axis is recomputed
+    and the projection of the position onto the principal axis is appended to the detected positions.
+    The sample is not appended to the signal while the principal axis is undefined (all the positions added so far are identical).
+  */
+  PlusStatus AddTrackerPosition(double timestamp, const double position[3]);
+
+  /*!
+    Add a tracked frame in incremental mode. The position is taken from the transform set by SetProbeToReferenceTransformName.
+    Frames outside the signal time range and frames without valid transform are ignored.
+  */
+  PlusStatus AddTrackedFrame(PlusTrackedFrame& trackedFrame);
+
+  /*!
+    Get the current principal axis of motion in incremental mode
+    \return PLUS_FAIL if the principal axis is undefined yet
+  */
+  PlusStatus GetIncrementalPrincipalAxis(double principalAxisOfMotion[3]);
+
 protected:
   vtkPlusPrincipalMotionDetectionAlgo();
   virtual ~vtkPlusPrincipalMotionDetectionAlgo();
@@ -63,6 +106,17 @@ protected:
   double m_SignalTimeRangeMin;
   double m_SignalTimeRangeMax;
 
+  /*! Incremental mode state */
+  double m_ForgettingFactor;
+  unsigned int m_MaximumSignalLength;
+  double m_IncrementalSumOfWeights;
+  double m_IncrementalMean[3];
+  /*! Weighted sum of outer products of deviations from the mean (covariance = scatter / sum of weights) */
+  double m_IncrementalScatter[3][3];
+  double m_IncrementalPrincipalAxis[3];
+  bool m_IncrementalPrincipalAxisValid;
+  vtkPlusTransformRepository* m_IncrementalTransformRepository;
+
 private:
   vtkPlusPrincipalMotionDetectionAlgo(const vtkPlusPrincipalMotionDetectionAlgo&);
   void operator=(const vtkPlusPrincipalMotionDetectionAlgo&);
@@ -7,8 +7,13 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "itksys/SystemTools.hxx"
 #include "vtkPlusMetaImageSequenceIO.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <vector>
 
 #ifdef _WIN32
@@ -61,6 +66,195 @@ namespace
 
   static std::string SEQMETA_FIELD_FRAME_FIELD_PREFIX = "Seq_Frame";
   static std::string SEQMETA_FIELD_IMG_STATUS = "ImageStatus";
+
+  // Size of the blocks that are read from the file when the text header is parsed
+  static const size_t HEADER_READ_BUFFER_SIZE = 256 * 1024;
+
+  static const char* SEQMETA_HEADER_INDEX_FILE_EXTENSION = ".plusidx";
+  static const char SEQMETA_HEADER_INDEX_FILE_SIGNATURE[8] = { 'P', 'L', 'U', 'S', 'H', 'I', 'D', 'X' };
+  static const vtkTypeUInt32 SEQMETA_HEADER_INDEX_FILE_VERSION = 2;
+  // Stored in native byte order, so an index that was written on a machine with different byte order is rejected
+  static const vtkTypeUInt32 SEQMETA_HEADER_INDEX_BYTE_ORDER_MARK = 0x01020304;
+  // Written at the end of the index to detect truncated files
+  static const vtkTypeUInt32 SEQMETA_HEADER_INDEX_END_MARK = 0x21444e45;
+
+  //----------------------------------------------------------------------------
+  bool IsHeaderWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  //----------------------------------------------------------------------------
+  void TrimRange(const char*& begin, const char*& end)
+  {
+    while (begin < end && IsHeaderWhitespace(*begin))
+    {
+      ++begin;
+    }
+    while (end > begin && IsHeaderWhitespace(*(end - 1)))
+    {
+      --end;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool StartsWithInsensitive(const char* begin, const char* end, const std::string& prefix)
+  {
+    if (static_cast<size_t>(end - begin) < prefix.size())
+    {
+      return false;
+    }
+    for (size_t i = 0; i < prefix.size(); ++i)
+    {
+      if (tolower(static_cast<unsigned char>(begin[i])) != tolower(static_cast<unsigned char>(prefix[i])))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus ParseFrameNumber(const char* begin, const char* end, int& frameNumber)
+  {
+    // frame numbers are non-negative, limit the number of digits to prevent overflow
+    const ptrdiff_t maxNumberOfDigits = 9;
+    if (begin == end || end - begin > maxNumberOfDigits)
+    {
+      return PLUS_FAIL;
+    }
+    frameNumber = 0;
+    for (const char* digit = begin; digit < end; ++digit)
+    {
+      if (*digit < '0' || *digit > '9')
+      {
+        return PLUS_FAIL;
+      }
+      frameNumber = frameNumber * 10 + (*digit - '0');
+    }
+    return PLUS_SUCCESS;
+  }
+
+  /*!
+    Stores a single copy of each distinct frame field name.
+    Frame fields are usually written in the same order for each frame, so the name that followed
+    the previously found name is checked first, which makes the lookup a single comparison in most cases.
+  */
+  class FrameFieldNameTable
+  {
+  public:
+    FrameFieldNameTable()
+      : NextIndex(0)
+    {
+    }
+
+    const std::string& Intern(const char* begin, const char* end)
+    {
+      size_t length = end - begin;
+      if (this->NextIndex >= this->Names.size())
+      {
+        this->NextIndex = 0;
+      }
+      if (this->NextIndex < this->Names.size() && IsEqual(this->Names[this->NextIndex], begin, length))
+      {
+        return this->Names[this->NextIndex++];
+      }
+      for (size_t i = 0; i < this->Names.size(); ++i)
+      {
+        if (IsEqual(this->Names[i], begin, length))
+        {
+          this->NextIndex = i + 1;
+          return this->Names[i];
+        }
+      }
+      this->Names.push_back(std::string(begin, end));
+      this->NextIndex = this->Names.size();
+      return this->Names.back();
+    }
+
+  private:
+    static bool IsEqual(const std::string& name, const char* begin, size_t length)
+    {
+      return name.size() == length && memcmp(name.data(), begin, length) == 0;
+    }
+
+    std::vector<std::string> Names;
+    size_t NextIndex;
+  };
+
+  //----------------------------------------------------------------------------
+  template<class T> void AppendToIndex(std::vector<char>& index, T value)
+  {
+    const char* valuePtr = reinterpret_cast<const char*>(&value);
+    index.insert(index.end(), valuePtr, valuePtr + sizeof(T));
+  }
+
+  //----------------------------------------------------------------------------
+  void AppendStringToIndex(std::vector<char>& index, const std::string& str)
+  {
+    AppendToIndex<vtkTypeUInt32>(index, static_cast<vtkTypeUInt32>(str.size()));
+    index.insert(index.end(), str.begin(), str.end());
+  }
+
+  /*! Reads values from the header index file content, with bounds checking */
+  class HeaderIndexReader
+  {
+  public:
+    HeaderIndexReader(const std::vector<char>& index)
+      : Position(index.data())
+      , End(index.data() + index.size())
+    {
+    }
+
+    bool ReadBytes(void* destination, size_t size)
+    {
+      if (static_cast<size_t>(this->End - this->Position) < size)
+      {
+        return false;
+      }
+      memcpy(destination, this->Position, size);
+      this->Position += size;
+      return true;
+    }
+
+    template<class T> bool Read(T& value)
+    {
+      return ReadBytes(&value, sizeof(T));
+    }
+
+    bool ReadString(std::string& str)
+    {
+      vtkTypeUInt32 length = 0;
+      if (!Read(length) || static_cast<size_t>(this->End - this->Position) < length)
+      {
+        return false;
+      }
+      str.assign(this->Position, length);
+      this->Position += length;
+      return true;
+    }
+
+    bool SkipString()
+    {
+      vtkTypeUInt32 length = 0;
+      if (!Read(length) || static_cast<size_t>(this->End - this->Position) < length)
+      {
+        return false;
+      }
+      this->Position += length;
+      return true;
+    }
+
+    /*! Returns false if the remaining bytes cannot hold numberOfEntries entries of at least minimumEntrySize bytes each */
+    bool CanContain(vtkTypeUInt32 numberOfEntries, size_t minimumEntrySize) const
+    {
+      return numberOfEntries <= static_cast<size_t>(this->End - this->Position) / minimumEntrySize;
+    }
+
+  private:
+    const char* Position;
+    const char* End;
+  };
 }
 
 //----------------------------------------------------------------------------
@@ -72,12 +266,18 @@ vtkPlusMetaImageSequenceIO::vtkPlusMetaImageSequenceIO()
   : vtkPlusSequenceIOBase()
   , IsPixelDataBinary(true)
   , Output2DDataWithZDimensionIncluded(false)
+  , UseHeaderIndexFile(false)
+  , HeaderLoadedFromIndexFile(false)
+  , DecompressionStreamActive(false)
+  , CompressedBytesRemaining(0)
 {
 }
 
 //----------------------------------------------------------------------------
 vtkPlusMetaImageSequenceIO::~vtkPlusMetaImageSequenceIO()
 {
+  // The base class destructor cannot release the decompression stream
+  this->ClosePixelDataStream();
 }
 
 //----------------------------------------------------------------------------
@@ -85,102 +285,31 @@ void vtkPlusMetaImageSequenceIO::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
 
-  // TODO : anything specific to print
+  os << indent << "UseHeaderIndexFile: " << (this->UseHeaderIndexFile ? "true" : "false") << std::endl;
+  os << indent << "HeaderLoadedFromIndexFile: " << (this->HeaderLoadedFromIndexFile ? "true" : "false") << std::endl;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
 {
-  FILE* stream = NULL;
-  // open in binary mode because we determine the start of the image buffer also during this read
-  if (FileOpen(&stream, this->FileName.c_str(), "rb") != PLUS_SUCCESS)
+  this->HeaderLoadedFromIndexFile = false;
+  if (this->UseHeaderIndexFile && ReadHeaderIndexFile() == PLUS_SUCCESS)
   {
-    LOG_ERROR("The file " << this->FileName << " could not be opened for reading");
-    return PLUS_FAIL;
+    this->HeaderLoadedFromIndexFile = true;
   }
-
-  char line[MAX_LINE_LENGTH + 1] = {0};
-  while (fgets(line, MAX_LINE_LENGTH, stream))
+  else
   {
-
-    std::string lineStr = line;
-
-    // Split line into name and value
-    size_t equalSignFound;
-    equalSignFound = lineStr.find_first_of("=");
-    if (equalSignFound == std::string::npos)
-    {
-      LOG_WARNING("Parsing line failed, equal sign is missing (" << lineStr << ")");
-      continue;
-    }
-    std::string name = lineStr.substr(0, equalSignFound);
-    std::string value = lineStr.substr(equalSignFound + 1);
-
-    // trim spaces from the left and right
-    PlusCommon::Trim(name);
-    PlusCommon::Trim(value);
-    if (!PlusCommon::HasSubstrInsensitive(name, SEQMETA_FIELD_FRAME_FIELD_PREFIX))
+    if (ReadImageHeaderFields() != PLUS_SUCCESS)
     {
-      // field
-      SetCustomString(name.c_str(), value.c_str());
-
-      // Arrived to ElementDataFile, this is the last element
-      if (PlusCommon::IsEqualInsensitive(name, SEQMETA_FIELD_ELEMENT_DATA_FILE))
-      {
-        if (PlusCommon::IsEqualInsensitive(value, SEQMETA_FIELD_VALUE_ELEMENT_DATA_FILE_LOCAL))
-        {
-          // pixel data stored locally
-          this->PixelDataFileOffset = FTELL(stream);
-        }
-        else
-        {
-          // pixel data stored in separate file
-          this->PixelDataFileName = value;
-          this->PixelDataFileOffset = 0;
-        }
-        // this is the last element of the header
-        break;
-      }
+      return PLUS_FAIL;
     }
-    else
+    if (this->UseHeaderIndexFile && WriteHeaderIndexFile() != PLUS_SUCCESS)
     {
-      // frame field
-      // name: Seq_Frame0000_CustomTransform
-      name.erase(0, SEQMETA_FIELD_FRAME_FIELD_PREFIX.size());   // 0000_CustomTransform
-
-      // Split line into name and value
-      size_t underscoreFound;
-      underscoreFound = name.find_first_of("_");
-      if (underscoreFound == std::string::npos)
-      {
-        LOG_WARNING("Parsing line failed, underscore is missing from frame field name (" << lineStr << ")");
-        continue;
-      }
-      std::string frameNumberStr = name.substr(0, underscoreFound);   // 0000
-      std::string frameFieldName = name.substr(underscoreFound + 1);   // CustomTransform
-
-      int frameNumber = 0;
-      if (PlusCommon::StringToInt(frameNumberStr.c_str(), frameNumber) != PLUS_SUCCESS)
-      {
-        LOG_WARNING("Parsing line failed, cannot get frame number from frame field (" << lineStr << ")");
-        continue;
-      }
-      SetCustomFrameString(frameNumber, frameFieldName.c_str(), value.c_str());
-
-      if (ferror(stream))
-      {
-        LOG_ERROR("Error reading the file " << this->FileName);
-        break;
-      }
-      if (feof(stream))
-      {
-        break;
-      }
+      // the index is just a cache, the file can be read without it
+      LOG_DEBUG("Header index file could not be written: " << GetHeaderIndexFileName());
     }
   }
 
-  fclose(stream);
-
   int nDims = 3;
   if (PlusCommon::StringToInt(this->TrackedFrameList->GetCustomString("NDims"), nDims) == PLUS_SUCCESS)
   {
@@ -332,6 +461,400 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeader()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadImageHeaderFields()
+{
+  FILE* stream = NULL;
+  // open in binary mode because we determine the start of the image buffer also during this read
+  if (FileOpen(&stream, this->FileName.c_str(), "rb") != PLUS_SUCCESS)
+  {
+    LOG_ERROR("The file " << this->FileName << " could not be opened for reading");
+    return PLUS_FAIL;
+  }
+
+  // The file is read in large blocks and each line is parsed in place, without copying it into a string.
+  // The buffer is only enlarged if a single line does not fit into it.
+  std::vector<char> buffer(HEADER_READ_BUFFER_SIZE);
+  size_t lineBegin = 0; // position of the first unprocessed character in the buffer
+  size_t dataEnd = 0; // number of characters read into the buffer
+  FilePositionOffsetType bufferFileOffset = 0; // position of the first character of the buffer in the file
+  bool endOfFile = false;
+
+  FrameFieldNameTable frameFieldNames;
+  std::string frameFieldValue;
+  int currentFrameNumber = -1;
+  PlusTrackedFrame* currentFrame = NULL;
+
+  while (true)
+  {
+    const char* bufferBegin = buffer.data();
+    const char* lineEnd = static_cast<const char*>(memchr(bufferBegin + lineBegin, '\n', dataEnd - lineBegin));
+    if (lineEnd == NULL && !endOfFile)
+    {
+      // Line is incomplete: move it to the beginning of the buffer and read the next block
+      size_t remaining = dataEnd - lineBegin;
+      memmove(buffer.data(), buffer.data() + lineBegin, remaining);
+      bufferFileOffset += lineBegin;
+      lineBegin = 0;
+      dataEnd = remaining;
+      if (buffer.size() - dataEnd < HEADER_READ_BUFFER_SIZE / 2)
+      {
+        buffer.resize(buffer.size() + HEADER_READ_BUFFER_SIZE);
+      }
+      size_t bytesRead = fread(buffer.data() + dataEnd, 1, buffer.size() - dataEnd, stream);
+      if (bytesRead == 0)
+      {
+        if (ferror(stream))
+        {
+          LOG_ERROR("Error reading the file " << this->FileName);
+          break;
+        }
+        endOfFile = true;
+      }
+      dataEnd += bytesRead;
+      continue;
+    }
+
+    size_t nextLineBegin = 0;
+    if (lineEnd != NULL)
+    {
+      nextLineBegin = (lineEnd - bufferBegin) + 1;
+    }
+    else
+    {
+      // last line of the file, without line ending
+      if (lineBegin == dataEnd)
+      {
+        break;
+      }
+      lineEnd = bufferBegin + dataEnd;
+      nextLineBegin = dataEnd;
+    }
+
+    const char* line = bufferBegin + lineBegin;
+    lineBegin = nextLineBegin;
+
+    // Split line into name and value
+    const char* equalSign = static_cast<const char*>(memchr(line, '=', lineEnd - line));
+    if (equalSign == NULL)
+    {
+      LOG_WARNING("Parsing line failed, equal sign is missing (" << std::string(line, lineEnd) << ")");
+      continue;
+    }
+
+    // trim spaces from the left and right
+    const char* nameBegin = line;
+    const char* nameEnd = equalSign;
+    const char* valueBegin = equalSign + 1;
+    const char* valueEnd = lineEnd;
+    TrimRange(nameBegin, nameEnd);
+    TrimRange(valueBegin, valueEnd);
+
+    if (!StartsWithInsensitive(nameBegin, nameEnd, SEQMETA_FIELD_FRAME_FIELD_PREFIX))
+    {
+      // field
+      std::string name(nameBegin, nameEnd);
+      std::string value(valueBegin, valueEnd);
+      SetCustomString(name, value);
+
+      // Arrived to ElementDataFile, this is the last element
+      if (PlusCommon::IsEqualInsensitive(name, SEQMETA_FIELD_ELEMENT_DATA_FILE))
+      {
+        if (PlusCommon::IsEqualInsensitive(value, SEQMETA_FIELD_VALUE_ELEMENT_DATA_FILE_LOCAL))
+        {
+          // pixel data stored locally
+          this->PixelDataFileOffset = bufferFileOffset + static_cast<FilePositionOffsetType>(nextLineBegin);
+        }
+        else
+        {
+          // pixel data stored in separate file
+          this->PixelDataFileName = value;
+          this->PixelDataFileOffset = 0;
+        }
+        // this is the last element of the header
+        break;
+      }
+      continue;
+    }
+
+    // frame field
+    // name: Seq_Frame0000_CustomTransform
+    const char* frameNumberBegin = nameBegin + SEQMETA_FIELD_FRAME_FIELD_PREFIX.size(); // 0000_CustomTransform
+    const char* underscore = static_cast<const char*>(memchr(frameNumberBegin, '_', nameEnd - frameNumberBegin));
+    if (underscore == NULL)
+    {
+      LOG_WARNING("Parsing line failed, underscore is missing from frame field name (" << std::string(line, lineEnd) << ")");
+      continue;
+    }
+
+    int frameNumber = 0;
+    if (ParseFrameNumber(frameNumberBegin, underscore, frameNumber) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Parsing line failed, cannot get frame number from frame field (" << std::string(line, lineEnd) << ")");
+      continue;
+    }
+
+    // Fields of the same frame are stored next to each other, so the frame only has to be looked up when the frame number changes
+    if (frameNumber != currentFrameNumber)
+    {
+      this->CreateTrackedFrameIfNonExisting(frameNumber);
+      currentFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
+      currentFrameNumber = frameNumber;
+    }
+    if (currentFrame == NULL)
+    {
+      LOG_ERROR("Cannot access frame " << frameNumber);
+      continue;
+    }
+
+    frameFieldValue.assign(valueBegin, valueEnd);
+    currentFrame->SetCustomFrameField(frameFieldNames.Intern(underscore + 1, nameEnd), frameFieldValue);
+  }
+
+  fclose(stream);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusMetaImageSequenceIO::GetHeaderIndexFileName() const
+{
+  return this->FileName + SEQMETA_HEADER_INDEX_FILE_EXTENSION;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::WriteHeaderIndexFile()
+{
+  std::vector<char> index;
+  index.insert(index.end(), SEQMETA_HEADER_INDEX_FILE_SIGNATURE, SEQMETA_HEADER_INDEX_FILE_SIGNATURE + sizeof(SEQMETA_HEADER_INDEX_FILE_SIGNATURE));
+  AppendToIndex<vtkTypeUInt32>(index, SEQMETA_HEADER_INDEX_FILE_VERSION);
+  AppendToIndex<vtkTypeUInt32>(index, SEQMETA_HEADER_INDEX_BYTE_ORDER_MARK);
+
+  // The index is valid only as long as the header is not changed. The modification time is not used, as its resolution
+  // may be too coarse to detect quick successive edits and it changes when the file is copied without any change in the content.
+  // If the pixel data is stored in the header file then only the bytes before the pixel data are checked.
+  vtkTypeInt64 headerFileSize = static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(this->FileName.c_str()));
+  vtkTypeInt64 headerSize = (this->PixelDataFileName.empty() ? static_cast<vtkTypeInt64>(this->PixelDataFileOffset) : headerFileSize);
+  vtkTypeUInt32 headerChecksum = 0;
+  if (ComputeHeaderChecksum(headerSize, headerChecksum) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  AppendToIndex<vtkTypeInt64>(index, headerFileSize);
+  AppendToIndex<vtkTypeInt64>(index, headerSize);
+  AppendToIndex<vtkTypeUInt32>(index, headerChecksum);
+
+  AppendToIndex<vtkTypeInt64>(index, static_cast<vtkTypeInt64>(this->PixelDataFileOffset));
+  AppendStringToIndex(index, this->PixelDataFileName);
+
+  std::vector<std::string> fieldNames;
+  this->TrackedFrameList->GetCustomFieldNameList(fieldNames);
+  AppendToIndex<vtkTypeUInt32>(index, static_cast<vtkTypeUInt32>(fieldNames.size()));
+  for (std::vector<std::string>::iterator fieldNameIt = fieldNames.begin(); fieldNameIt != fieldNames.end(); ++fieldNameIt)
+  {
+    AppendStringToIndex(index, *fieldNameIt);
+    AppendStringToIndex(index, this->TrackedFrameList->GetCustomString(*fieldNameIt));
+  }
+
+  // Frame fields refer to the frame field names by their position in the name table
+  std::map<std::string, vtkTypeUInt32> frameFieldNameIndices;
+  std::vector<std::string> frameFieldNames;
+  std::vector<char> frameFields;
+  unsigned int numberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  AppendToIndex<vtkTypeUInt32>(frameFields, numberOfFrames);
+  for (unsigned int frameNumber = 0; frameNumber < numberOfFrames; ++frameNumber)
+  {
+    const PlusTrackedFrame::FieldMapType& fields = this->TrackedFrameList->GetTrackedFrame(frameNumber)->GetCustomFields();
+    AppendToIndex<vtkTypeUInt32>(frameFields, static_cast<vtkTypeUInt32>(fields.size()));
+    for (PlusTrackedFrame::FieldMapType::const_iterator fieldIt = fields.begin(); fieldIt != fields.end(); ++fieldIt)
+    {
+      std::map<std::string, vtkTypeUInt32>::iterator nameIndexIt = frameFieldNameIndices.find(fieldIt->first);
+      if (nameIndexIt == frameFieldNameIndices.end())
+      {
+        nameIndexIt = frameFieldNameIndices.insert(std::make_pair(fieldIt->first, static_cast<vtkTypeUInt32>(frameFieldNames.size()))).first;
+        frameFieldNames.push_back(fieldIt->first);
+      }
+      AppendToIndex<vtkTypeUInt32>(frameFields, nameIndexIt->second);
+      AppendStringToIndex(frameFields, fieldIt->second);
+    }
+  }
+
+  AppendToIndex<vtkTypeUInt32>(index, static_cast<vtkTypeUInt32>(frameFieldNames.size()));
+  for (std::vector<std::string>::iterator nameIt = frameFieldNames.begin(); nameIt != frameFieldNames.end(); ++nameIt)
+  {
+    AppendStringToIndex(index, *nameIt);
+  }
+  index.insert(index.end(), frameFields.begin(), frameFields.end());
+  AppendToIndex<vtkTypeUInt32>(index, SEQMETA_HEADER_INDEX_END_MARK);
+
+  std::string indexFileName = GetHeaderIndexFileName();
+  FILE* stream = NULL;
+  if (FileOpen(&stream, indexFileName.c_str(), "wb") != PLUS_SUCCESS)
+  {
+    LOG_DEBUG("The header index file " << indexFileName << " could not be opened for writing");
+    return PLUS_FAIL;
+  }
+  bool success = (fwrite(index.data(), 1, index.size(), stream) == index.size());
+  success = (fclose(stream) == 0) && success;
+  if (!success)
+  {
+    LOG_DEBUG("Failed to write header index file " << indexFileName);
+    vtksys::SystemTools::RemoveFile(indexFileName.c_str());
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ComputeHeaderChecksum(vtkTypeInt64 headerSize, vtkTypeUInt32& checksum)
+{
+  FILE* stream = NULL;
+  if (FileOpen(&stream, this->FileName.c_str(), "rb") != PLUS_SUCCESS)
+  {
+    LOG_DEBUG("The file " << this->FileName << " could not be opened for computing the header checksum");
+    return PLUS_FAIL;
+  }
+
+  std::vector<unsigned char> buffer(HEADER_READ_BUFFER_SIZE);
+  uLong crc = crc32(0L, Z_NULL, 0);
+  vtkTypeInt64 remainingBytes = headerSize;
+  while (remainingBytes > 0)
+  {
+    size_t bytesToRead = static_cast<size_t>(std::min<vtkTypeInt64>(remainingBytes, static_cast<vtkTypeInt64>(buffer.size())));
+    if (fread(&buffer[0], 1, bytesToRead, stream) != bytesToRead)
+    {
+      LOG_DEBUG("Failed to read " << headerSize << " header bytes from " << this->FileName);
+      fclose(stream);
+      return PLUS_FAIL;
+    }
+    crc = crc32(crc, &buffer[0], static_cast<uInt>(bytesToRead));
+    remainingBytes -= bytesToRead;
+  }
+  fclose(stream);
+
+  checksum = static_cast<vtkTypeUInt32>(crc);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadHeaderIndexFile()
+{
+  std::string indexFileName = GetHeaderIndexFileName();
+  if (!vtksys::SystemTools::FileExists(indexFileName.c_str(), true))
+  {
+    return PLUS_FAIL;
+  }
+
+  std::vector<char> index(vtksys::SystemTools::FileLength(indexFileName.c_str()));
+  FILE* stream = NULL;
+  if (FileOpen(&stream, indexFileName.c_str(), "rb") != PLUS_SUCCESS)
+  {
+    LOG_DEBUG("The header index file " << indexFileName << " could not be opened for reading");
+    return PLUS_FAIL;
+  }
+  bool readSuccess = (fread(index.data(), 1, index.size(), stream) == index.size());
+  fclose(stream);
+  if (!readSuccess)
+  {
+    LOG_DEBUG("Failed to read header index file " << indexFileName);
+    return PLUS_FAIL;
+  }
+
+  HeaderIndexReader reader(index);
+  char signature[sizeof(SEQMETA_HEADER_INDEX_FILE_SIGNATURE)] = {0};
+  vtkTypeUInt32 version = 0;
+  vtkTypeUInt32 byteOrderMark = 0;
+  if (!reader.ReadBytes(signature, sizeof(signature)) || memcmp(signature, SEQMETA_HEADER_INDEX_FILE_SIGNATURE, sizeof(signature)) != 0
+      || !reader.Read(version) || version != SEQMETA_HEADER_INDEX_FILE_VERSION
+      || !reader.Read(byteOrderMark) || byteOrderMark != SEQMETA_HEADER_INDEX_BYTE_ORDER_MARK)
+  {
+    LOG_DEBUG("Header index file " << indexFileName << " is invalid or written by a different version");
+    return PLUS_FAIL;
+  }
+
+  // The file size is compared first, as it is much faster than computing the checksum
+  vtkTypeInt64 headerFileSize = 0;
+  vtkTypeInt64 headerSize = 0;
+  vtkTypeUInt32 headerChecksum = 0;
+  vtkTypeUInt32 currentHeaderChecksum = 0;
+  if (!reader.Read(headerFileSize) || headerFileSize != static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(this->FileName.c_str()))
+      || !reader.Read(headerSize) || headerSize < 0 || headerSize > headerFileSize || !reader.Read(headerChecksum)
+      || ComputeHeaderChecksum(headerSize, currentHeaderChecksum) != PLUS_SUCCESS || currentHeaderChecksum != headerChecksum)
+  {
+    LOG_DEBUG("Header index file " << indexFileName << " is outdated");
+    return PLUS_FAIL;
+  }
+
+  vtkTypeInt64 pixelDataFileOffset = 0;
+  std::string pixelDataFileName;
+  vtkTypeUInt32 numberOfFields = 0;
+  // Entry counts are checked against the size of the index before allocating the entries, so that
+  // a corrupted count makes the index invalid instead of allocating a huge amount of memory
+  bool valid = reader.Read(pixelDataFileOffset) && reader.ReadString(pixelDataFileName)
+               && reader.Read(numberOfFields) && reader.CanContain(numberOfFields, 2 * sizeof(vtkTypeUInt32));
+  std::vector<std::pair<std::string, std::string> > fields(valid ? numberOfFields : 0);
+  for (vtkTypeUInt32 i = 0; valid && i < numberOfFields; ++i)
+  {
+    valid = reader.ReadString(fields[i].first) && reader.ReadString(fields[i].second);
+  }
+  vtkTypeUInt32 numberOfFrameFieldNames = 0;
+  valid = valid && reader.Read(numberOfFrameFieldNames) && reader.CanContain(numberOfFrameFieldNames, sizeof(vtkTypeUInt32));
+  std::vector<std::string> frameFieldNames(valid ? numberOfFrameFieldNames : 0);
+  for (vtkTypeUInt32 i = 0; valid && i < numberOfFrameFieldNames; ++i)
+  {
+    valid = reader.ReadString(frameFieldNames[i]);
+  }
+
+  // Validate the frame fields before changing the tracked frame list, so that a corrupted index cannot leave partially loaded frames behind
+  vtkTypeUInt32 numberOfFrames = 0;
+  valid = valid && reader.Read(numberOfFrames) && reader.CanContain(numberOfFrames, sizeof(vtkTypeUInt32));
+  HeaderIndexReader frameFieldsReader = reader;
+  for (vtkTypeUInt32 frameNumber = 0; valid && frameNumber < numberOfFrames; ++frameNumber)
+  {
+    vtkTypeUInt32 numberOfFrameFields = 0;
+    valid = reader.Read(numberOfFrameFields);
+    for (vtkTypeUInt32 i = 0; valid && i < numberOfFrameFields; ++i)
+    {
+      vtkTypeUInt32 nameIndex = 0;
+      valid = reader.Read(nameIndex) && nameIndex < numberOfFrameFieldNames && reader.SkipString();
+    }
+  }
+  vtkTypeUInt32 endMark = 0;
+  if (!valid || !reader.Read(endMark) || endMark != SEQMETA_HEADER_INDEX_END_MARK)
+  {
+    LOG_DEBUG("Header index file " << indexFileName << " is corrupted");
+    return PLUS_FAIL;
+  }
+
+  for (std::vector<std::pair<std::string, std::string> >::iterator fieldIt = fields.begin(); fieldIt != fields.end(); ++fieldIt)
+  {
+    SetCustomString(fieldIt->first, fieldIt->second);
+  }
+  this->PixelDataFileOffset = static_cast<FilePositionOffsetType>(pixelDataFileOffset);
+  this->PixelDataFileName = pixelDataFileName;
+
+  if (numberOfFrames > 0)
+  {
+    this->CreateTrackedFrameIfNonExisting(numberOfFrames - 1);
+  }
+  std::string frameFieldValue;
+  for (vtkTypeUInt32 frameNumber = 0; frameNumber < numberOfFrames; ++frameNumber)
+  {
+    PlusTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
+    vtkTypeUInt32 numberOfFrameFields = 0;
+    frameFieldsReader.Read(numberOfFrameFields);
+    for (vtkTypeUInt32 i = 0; i < numberOfFrameFields; ++i)
+    {
+      vtkTypeUInt32 nameIndex = 0;
+      frameFieldsReader.Read(nameIndex);
+      frameFieldsReader.ReadString(frameFieldValue);
+      trackedFrame->SetCustomFrameField(frameFieldNames[nameIndex], frameFieldValue);
+    }
+  }
+
+  LOG_DEBUG("Header fields loaded from index file " << indexFileName);
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 // Read the spacing and dimensions of the image.
 PlusStatus vtkPlusMetaImageSequenceIO::ReadImagePixels()
@@ -487,6 +1010,95 @@ PlusStatus vtkPlusMetaImageSequenceIO::ReadImagePixels()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::OpenPixelDataStream()
+{
+  this->ClosePixelDataStream();
+  if (Superclass::OpenPixelDataStream() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (!this->UseCompression)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  unsigned int compressedDataSize = 0;
+  PlusCommon::StringToInt(this->TrackedFrameList->GetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE), compressedDataSize);
+  // If the compressed size is unknown then read until the end of the file
+  this->CompressedBytesRemaining = (compressedDataSize > 0 ? compressedDataSize : std::numeric_limits<unsigned long long>::max());
+
+  this->DecompressionStream.zalloc = Z_NULL;
+  this->DecompressionStream.zfree = Z_NULL;
+  this->DecompressionStream.opaque = Z_NULL;
+  this->DecompressionStream.next_in = Z_NULL;
+  this->DecompressionStream.avail_in = 0;
+  int ret = inflateInit(&this->DecompressionStream);
+  if (ret != Z_OK)
+  {
+    LOG_ERROR("Image decompression initialization failed (errorCode=" << ret << ")");
+    Superclass::ClosePixelDataStream();
+    return PLUS_FAIL;
+  }
+  this->DecompressionInputBuffer.resize(Z_BUFSIZE);
+  this->DecompressionStreamActive = true;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusMetaImageSequenceIO::ReadPixelDataStream(unsigned char* buffer, unsigned int size)
+{
+  if (!this->DecompressionStreamActive)
+  {
+    return Superclass::ReadPixelDataStream(buffer, size);
+  }
+
+  this->DecompressionStream.next_out = buffer;
+  this->DecompressionStream.avail_out = size;
+  while (this->DecompressionStream.avail_out > 0)
+  {
+    if (this->DecompressionStream.avail_in == 0)
+    {
+      size_t bytesToRead = static_cast<size_t>(std::min<unsigned long long>(this->DecompressionInputBuffer.size(), this->CompressedBytesRemaining));
+      size_t readSize = (bytesToRead > 0 ? fread(&(this->DecompressionInputBuffer[0]), 1, bytesToRead, this->InputImageFileHandle) : 0);
+      if (readSize == 0)
+      {
+        LOG_ERROR("Cannot uncompress the pixel data: compressed data is shorter than expected in " << this->GetPixelDataFilePath());
+        return PLUS_FAIL;
+      }
+      this->CompressedBytesRemaining -= readSize;
+      this->DecompressionStream.next_in = &(this->DecompressionInputBuffer[0]);
+      this->DecompressionStream.avail_in = static_cast<uInt>(readSize);
+    }
+
+    int ret = inflate(&this->DecompressionStream, Z_NO_FLUSH);
+    if (ret == Z_STREAM_END && this->DecompressionStream.avail_out > 0)
+    {
+      LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+      return PLUS_FAIL;
+    }
+    if (ret != Z_OK && ret != Z_STREAM_END)
+    {
+      LOG_ERROR("Cannot uncompress the pixel data (errorCode=" << ret << ")");
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusMetaImageSequenceIO::ClosePixelDataStream()
+{
+  if (this->DecompressionStreamActive)
+  {
+    inflateEnd(&this->DecompressionStream);
+    this->DecompressionStreamActive = false;
+  }
+  std::vector<unsigned char>().swap(this->DecompressionInputBuffer);
+  Superclass::ClosePixelDataStream();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusMetaImageSequenceIO::PrepareImageFile()
 {
@@ -34,6 +34,22 @@ public:
   vtkSetMacro(Output2DDataWithZDimensionIncluded, bool);
   vtkGetMacro(Output2DDataWithZDimensionIncluded, bool);
 
+  /*!
+    If enabled then the parsed header is cached in a binary index file next to the header file
+    (header file name + ".plusidx"). When the header is read next time and the index is still valid
+    (the size of the header file and the checksum of the header bytes are unchanged) then fields are loaded from the index
+    instead of parsing the text header. Disabled by default.
+  */
+  vtkSetMacro(UseHeaderIndexFile, bool);
+  vtkGetMacro(UseHeaderIndexFile, bool);
+  vtkBooleanMacro(UseHeaderIndexFile, bool);
+
+  /*! Returns true if the fields were loaded from the header index file during the last read */
+  vtkGetMacro(HeaderLoadedFromIndexFile, bool);
+
+  /*! Returns the file name of the header index file that belongs to the current file name */
+  std::string GetHeaderIndexFileName() const;
+
   /*! Update the number of frames in the header
       This is used primarily by vtkPlusVirtualCapture to update the final tally of frames, as it continually appends new frames to the file
       /param numberOfFrames the new number of frames to write
@@ -81,9 +97,36 @@ protected:
   /*! Read all the fields in the metaimage file header */
   virtual PlusStatus ReadImageHeader();
 
+  /*!
+    Parse the text header in a single buffered pass. Frame field names are interned, so each
+    distinct field name is parsed and allocated only once, not for every frame.
+  */
+  PlusStatus ReadImageHeaderFields();
+
+  /*! Load the header fields from the binary header index file. Fails if the index is missing, corrupted, or outdated. */
+  PlusStatus ReadHeaderIndexFile();
+
+  /*! Save the header fields that have been read from the text header into the binary header index file */
+  PlusStatus WriteHeaderIndexFile();
+
+  /*!
+    Compute the checksum of the text header (the first headerSize bytes of the header file).
+    The checksum is stored in the header index file to detect any change of the header.
+  */
+  PlusStatus ComputeHeaderChecksum(vtkTypeInt64 headerSize, vtkTypeUInt32& checksum);
+
   /*! Read pixel data from the metaimage */
   virtual PlusStatus ReadImagePixels();
 
+  /*! Open the pixel data for sequential reading. Compressed pixel data is decompressed on the fly. */
+  virtual PlusStatus OpenPixelDataStream();
+
+  /*! Read the next size bytes of uncompressed pixel data */
+  virtual PlusStatus ReadPixelDataStream(unsigned char* buffer, unsigned int size);
+
+  /*! Close the pixel data stream */
+  virtual void ClosePixelDataStream();
+
   /*! Prepare the image file for writing */
   virtual PlusStatus PrepareImageFile();
 
@@ -110,6 +153,18 @@ private:
   bool Output2DDataWithZDimensionIncluded;
   /*! compression stream handle for compression streaming */
   z_stream CompressionStream;
+  /*! decompression stream handle for streamed reading of compressed pixel data */
+  z_stream DecompressionStream;
+  /*! True if DecompressionStream is initialized */
+  bool DecompressionStreamActive;
+  /*! Buffer for compressed pixel data that is read from file during streamed reading */
+  std::vector<unsigned char> DecompressionInputBuffer;
+  /*! Number of compressed pixel data bytes that are not read from the file yet */
+  unsigned long long CompressedBytesRemaining;
+  /*! Cache parsed header fields in a binary index file */
+  bool UseHeaderIndexFile;
+  /*! True if the header fields were loaded from the header index file during the last read */
+  bool HeaderLoadedFromIndexFile;
 
 protected:
   vtkPlusMetaImageSequenceIO(const vtkPlusMetaImageSequenceIO&); //purposely not implemented
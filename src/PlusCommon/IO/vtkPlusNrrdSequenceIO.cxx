@@ -55,12 +55,15 @@ vtkPlusNrrdSequenceIO::vtkPlusNrrdSequenceIO()
   : vtkPlusSequenceIOBase()
   , Encoding(NRRD_ENCODING_RAW)
   , CompressionStream(NULL)
+  , DecompressionStream(NULL)
 {
 }
 
 //----------------------------------------------------------------------------
 vtkPlusNrrdSequenceIO::~vtkPlusNrrdSequenceIO()
 {
+  // The base class destructor cannot release the decompression stream
+  this->ClosePixelDataStream();
 }
 
 //----------------------------------------------------------------------------
@@ -517,6 +520,70 @@ PlusStatus vtkPlusNrrdSequenceIO::ReadImagePixels()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::OpenPixelDataStream()
+{
+  this->ClosePixelDataStream();
+  if (Superclass::OpenPixelDataStream() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (!this->UseCompression || this->Encoding < NRRD_ENCODING_GZ || this->Encoding >= NRRD_ENCODING_BZ2)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  // The gzip stream gets its own file descriptor positioned at the start of the pixel data, same as in ReadImagePixels
+#if _WIN32
+  int dupFd = _dup(_fileno(this->InputImageFileHandle));
+  _lseek(dupFd, this->PixelDataFileOffset, SEEK_SET);
+#else
+  int dupFd = dup(fileno(this->InputImageFileHandle));
+  lseek(dupFd, this->PixelDataFileOffset, SEEK_SET);
+#endif
+  this->DecompressionStream = gzdopen(dupFd, "rb");
+  if (this->DecompressionStream == NULL)
+  {
+    LOG_ERROR("Unable to open gz stream.");
+    Superclass::ClosePixelDataStream();
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusNrrdSequenceIO::ReadPixelDataStream(unsigned char* buffer, unsigned int size)
+{
+  if (this->DecompressionStream == NULL)
+  {
+    return Superclass::ReadPixelDataStream(buffer, size);
+  }
+  int readSize = gzread(this->DecompressionStream, (void*)buffer, size);
+  if (readSize < 0 || static_cast<unsigned int>(readSize) != size)
+  {
+    LOG_ERROR("Could not uncompress " << size << " bytes from " << this->GetPixelDataFilePath());
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNrrdSequenceIO::ClosePixelDataStream()
+{
+  if (this->DecompressionStream != NULL)
+  {
+    gzclose(this->DecompressionStream);
+    this->DecompressionStream = NULL;
+  }
+  Superclass::ClosePixelDataStream();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusNrrdSequenceIO::GetImageStatusFieldName() const
+{
+  return SEQUENCE_FIELD_IMG_STATUS;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusNrrdSequenceIO::PrepareImageFile()
 {
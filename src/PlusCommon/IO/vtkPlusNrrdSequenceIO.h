@@ -59,6 +59,9 @@ public:
   */
   virtual PlusStatus AppendImagesToHeader();
 
+  /*! Name of the per-frame field that stores if the image data of the frame is valid */
+  virtual std::string GetImageStatusFieldName() const;
+
   /*! Finalize the header */
   virtual PlusStatus FinalizeHeader();
 
@@ -96,6 +99,15 @@ protected:
   /*! Read pixel data from the image */
   virtual PlusStatus ReadImagePixels();
 
+  /*! Open the pixel data for sequential reading. Gzip encoded pixel data is decompressed on the fly. */
+  virtual PlusStatus OpenPixelDataStream();
+
+  /*! Read the next size bytes of uncompressed pixel data */
+  virtual PlusStatus ReadPixelDataStream( unsigned char* buffer, unsigned int size );
+
+  /*! Close the pixel data stream */
+  virtual void ClosePixelDataStream();
+
   /*! Prepare the image file for writing */
   virtual PlusStatus PrepareImageFile();
 
@@ -130,6 +142,9 @@ protected:
   /*! file handle for the compression stream */
   gzFile CompressionStream;
 
+  /*! file handle for streamed reading of gzip encoded pixel data */
+  gzFile DecompressionStream;
+
 private:
   vtkPlusNrrdSequenceIO( const vtkPlusNrrdSequenceIO& ); //purposely not implemented
   void operator=( const vtkPlusNrrdSequenceIO& ); //purposely not implemented
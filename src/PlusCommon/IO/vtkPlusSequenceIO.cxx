@@ -48,7 +48,7 @@ PlusStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkPlusTrackedF
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusSequenceIO::Read(const std::string& filename, vtkPlusTrackedFrameList* frameList)
+PlusStatus vtkPlusSequenceIO::Read(const std::string& filename, vtkPlusTrackedFrameList* frameList, bool useHeaderIndexFile/*=false*/)
 {
   if( !vtksys::SystemTools::FileExists(filename.c_str()) )
   {
@@ -59,7 +59,7 @@ PlusStatus vtkPlusSequenceIO::Read(const std::string& filename, vtkPlusTrackedFr
   if( vtkPlusMetaImageSequenceIO::CanReadFile(filename) )
   {
     // Attempt metafile read
-    if ( frameList->ReadFromSequenceMetafile(filename) != PLUS_SUCCESS )
+    if ( frameList->ReadFromSequenceMetafile(filename, useHeaderIndexFile) != PLUS_SUCCESS )
     {
       LOG_ERROR("Failed to read video buffer from sequence metafile: " << filename);
       return PLUS_FAIL;
@@ -25,8 +25,12 @@ public:
   /*! Write object contents into file */
   static PlusStatus Write(const std::string& filename, vtkPlusTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile=US_IMG_ORIENT_MF, bool useCompression=true, bool EnableImageDataWrite=true);
 
-  /*! Read file contents into the object */
-  static PlusStatus Read(const std::string& filename, vtkPlusTrackedFrameList* frameList);
+  /*!
+    Read file contents into the object
+    \param useHeaderIndexFile If true then the parsed header of MetaImage files is cached in a header index file
+    and loaded from there next time (see vtkPlusMetaImageSequenceIO::SetUseHeaderIndexFile). Ignored for other file types.
+  */
+  static PlusStatus Read(const std::string& filename, vtkPlusTrackedFrameList* frameList, bool useHeaderIndexFile=false);
 
   /*! Create a handler for a given filetype */
   static vtkPlusSequenceIOBase* CreateSequenceHandlerForFile(const std::string& filename);
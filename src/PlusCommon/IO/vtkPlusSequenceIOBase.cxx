@@ -11,6 +11,12 @@ See License.txt for details.
 #include "vtksys/SystemTools.hxx"
 #include "PlusTrackedFrame.h"
 
+#ifdef _WIN32
+  #define FSEEK _fseeki64
+#else
+  #define FSEEK fseek
+#endif
+
 #if _WIN32
 #include <errno.h>
 
@@ -43,6 +49,9 @@ vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
   , PixelDataFileOffset( 0 )
   , PixelDataFileName( "" )
   , OutputImageFileHandle( NULL )
+  , InputImageFileHandle( NULL )
+  , StreamedReadActive( false )
+  , NextStreamedFrameNumber( 0 )
 {
   this->Dimensions[0] = 1;
   this->Dimensions[1] = 1;
@@ -53,6 +62,10 @@ vtkPlusSequenceIOBase::vtkPlusSequenceIOBase()
 //----------------------------------------------------------------------------
 vtkPlusSequenceIOBase::~vtkPlusSequenceIOBase()
 {
+  if ( this->StreamedReadActive )
+  {
+    this->CloseStreamedRead();
+  }
   if( this->TrackedFrameList != NULL )
   {
     this->SetTrackedFrameList( NULL );
@@ -71,19 +84,230 @@ PlusStatus vtkPlusSequenceIOBase::Read()
 {
   this->TrackedFrameList->Clear();
 
+  PlusStatus status = PLUS_SUCCESS;
   if ( this->ReadImageHeader() != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Could not load header from file: " << this->FileName );
+    status = PLUS_FAIL;
+  }
+  else if ( this->ReadImagePixels() != PLUS_SUCCESS )
+  {
+    status = PLUS_FAIL;
+  }
+
+  // Frames are created with placeholder timestamps and their fields are set in place while reading
+  this->TrackedFrameList->Modified();
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::OpenForStreamedRead()
+{
+  if ( this->StreamedReadActive )
+  {
+    this->CloseStreamedRead();
+  }
+
+  this->TrackedFrameList->Clear();
+  PlusStatus headerStatus = this->ReadImageHeader();
+  // Frames are created with placeholder timestamps and their fields are set in place while reading
+  this->TrackedFrameList->Modified();
+  if ( headerStatus != PLUS_SUCCESS )
   {
     LOG_ERROR( "Could not load header from file: " << this->FileName );
     return PLUS_FAIL;
   }
 
-  if ( this->ReadImagePixels() != PLUS_SUCCESS )
+  if ( this->GetFrameSizeInBytesFromHeader() > 0 && this->OpenPixelDataStream() != PLUS_SUCCESS )
   {
+    LOG_ERROR( "Could not open pixel data for reading: " << this->GetPixelDataFilePath() );
     return PLUS_FAIL;
   }
+
+  this->NextStreamedFrameNumber = 0;
+  this->StreamedReadActive = true;
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+unsigned int vtkPlusSequenceIOBase::GetNumberOfRemainingStreamedFrames()
+{
+  if ( !this->StreamedReadActive )
+  {
+    return 0;
+  }
+  unsigned int numberOfFrames = this->TrackedFrameList->GetNumberOfTrackedFrames();
+  if ( this->GetFrameSizeInBytesFromHeader() > 0 && this->Dimensions[3] > numberOfFrames )
+  {
+    // Frames without any custom field are only present in the pixel data
+    numberOfFrames = this->Dimensions[3];
+  }
+  return ( numberOfFrames > this->NextStreamedFrameNumber ? numberOfFrames - this->NextStreamedFrameNumber : 0 );
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadNextFrames( vtkPlusTrackedFrameList* outputFrameList, unsigned int maxNumberOfFrames, unsigned int& numberOfFramesRead )
+{
+  numberOfFramesRead = 0;
+  if ( !this->StreamedReadActive )
+  {
+    LOG_ERROR( "ReadNextFrames failed: OpenForStreamedRead has not been called for file " << this->FileName );
+    return PLUS_FAIL;
+  }
+  if ( outputFrameList == NULL )
+  {
+    LOG_ERROR( "ReadNextFrames failed: output frame list is invalid" );
+    return PLUS_FAIL;
+  }
+
+  unsigned int frameSizeInBytes = this->GetFrameSizeInBytesFromHeader();
+  PlusVideoFrame::FlipInfoType flipInfo;
+  if ( frameSizeInBytes > 0 && PlusVideoFrame::GetFlipAxes( this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "Failed to convert image data to the requested orientation, from " << PlusVideoFrame::GetStringFromUsImageOrientation( this->ImageOrientationInFile ) <<
+               " to " << PlusVideoFrame::GetStringFromUsImageOrientation( this->ImageOrientationInMemory ) );
+    return PLUS_FAIL;
+  }
+
+  int clipRectOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  int clipRectSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+  std::vector<unsigned char> pixelBuffer( frameSizeInBytes );
+  const std::string imageStatusFieldName = this->GetImageStatusFieldName();
+
+  int numberOfErrors = 0;
+  PlusStatus status = PLUS_SUCCESS;
+  unsigned int numberOfRemainingFrames = this->GetNumberOfRemainingStreamedFrames();
+  while ( numberOfFramesRead < maxNumberOfFrames && numberOfFramesRead < numberOfRemainingFrames )
+  {
+    unsigned int frameNumber = this->NextStreamedFrameNumber;
+    this->CreateTrackedFrameIfNonExisting( frameNumber );
+
+    // Move the frame fields out of the header frame list, the frame is not needed there anymore
+    PlusTrackedFrame* headerFrame = this->TrackedFrameList->GetTrackedFrame( frameNumber );
+    PlusTrackedFrame* trackedFrame = new PlusTrackedFrame( *headerFrame );
+    *headerFrame = PlusTrackedFrame();
+
+    this->NextStreamedFrameNumber++;
+    numberOfFramesRead++;
+
+    if ( frameSizeInBytes > 0 )
+    {
+      // Pixel data has to be consumed from the stream even if the frame image is invalid
+      if ( this->ReadPixelDataStream( &( pixelBuffer[0] ), frameSizeInBytes ) != PLUS_SUCCESS )
+      {
+        LOG_ERROR( "Failed to read pixel data of frame " << frameNumber << " from " << this->GetPixelDataFilePath() );
+        delete trackedFrame;
+        status = PLUS_FAIL;
+        break;
+      }
+
+      bool imageValid = true;
+      const char* imgStatus = trackedFrame->GetCustomFrameField( imageStatusFieldName.c_str() );
+      if ( imgStatus != NULL )
+      {
+        // Image status can be determined by trackedFrame->GetImageData()->IsImageValid()
+        imageValid = PlusCommon::IsEqualInsensitive( imgStatus, "OK" );
+        trackedFrame->DeleteCustomFrameField( imageStatusFieldName.c_str() );
+      }
+
+      if ( imageValid )
+      {
+        trackedFrame->GetImageData()->SetImageOrientation( this->ImageOrientationInMemory );
+        trackedFrame->GetImageData()->SetImageType( this->ImageType );
+        if ( trackedFrame->GetImageData()->AllocateFrame( this->Dimensions, this->PixelType, this->NumberOfScalarComponents ) != PLUS_SUCCESS )
+        {
+          LOG_ERROR( "Cannot allocate memory for frame " << frameNumber );
+          numberOfErrors++;
+        }
+        else if ( PlusVideoFrame::GetOrientedClippedImage( &( pixelBuffer[0] ), flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents,
+                  this->Dimensions, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize ) != PLUS_SUCCESS )
+        {
+          LOG_ERROR( "Failed to get oriented image from file (frame number: " << frameNumber << ")!" );
+          numberOfErrors++;
+        }
+      }
+    }
+
+    outputFrameList->TakeTrackedFrame( trackedFrame, vtkPlusTrackedFrameList::ADD_INVALID_FRAME );
+  }
+
+  // Header frames may be created and are cleared in place after their fields are moved to the output
+  this->TrackedFrameList->Modified();
+
+  if ( numberOfErrors > 0 )
+  {
+    status = PLUS_FAIL;
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::CloseStreamedRead()
+{
+  this->ClosePixelDataStream();
+  this->TrackedFrameList->Clear();
+  this->NextStreamedFrameNumber = 0;
+  this->StreamedReadActive = false;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::OpenPixelDataStream()
+{
+  this->ClosePixelDataStream();
+  if ( FileOpen( &this->InputImageFileHandle, this->GetPixelDataFilePath().c_str(), "rb" ) != PLUS_SUCCESS )
+  {
+    LOG_ERROR( "The file " << this->GetPixelDataFilePath() << " could not be opened for reading" );
+    return PLUS_FAIL;
+  }
+  FSEEK( this->InputImageFileHandle, this->PixelDataFileOffset, SEEK_SET );
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSequenceIOBase::ReadPixelDataStream( unsigned char* buffer, unsigned int size )
+{
+  if ( this->InputImageFileHandle == NULL )
+  {
+    LOG_ERROR( "Pixel data stream is not open" );
+    return PLUS_FAIL;
+  }
+  size_t readSize = fread( buffer, 1, size, this->InputImageFileHandle );
+  if ( readSize != size )
+  {
+    // Truncated files are tolerated the same way as in ReadImagePixels, missing pixels are left blank
+    LOG_DEBUG( "Could not read " << size << " bytes from " << this->GetPixelDataFilePath() << ", only " << readSize << " bytes are available" );
+    memset( buffer + readSize, 0, size - readSize );
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSequenceIOBase::ClosePixelDataStream()
+{
+  if ( this->InputImageFileHandle != NULL )
+  {
+    fclose( this->InputImageFileHandle );
+    this->InputImageFileHandle = NULL;
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusSequenceIOBase::GetImageStatusFieldName() const
+{
+  return "ImageStatus";
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlusSequenceIOBase::GetFrameSizeInBytesFromHeader() const
+{
+  if ( this->Dimensions[0] == 0 || this->Dimensions[1] == 0 || this->Dimensions[2] == 0 )
+  {
+    return 0;
+  }
+  return this->Dimensions[0] * this->Dimensions[1] * this->Dimensions[2] * PlusVideoFrame::GetNumberOfBytesPerScalar( this->PixelType ) * this->NumberOfScalarComponents;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSequenceIOBase::DeleteCustomFrameString( int frameNumber, const char* fieldName )
 {
@@ -39,6 +39,29 @@ public:
   /*! Read file contents into the object */
   virtual PlusStatus Read();
 
+  /*!
+    Prepare the file for reading the frames in chunks. Only the header is read, pixel data is not loaded
+    until the frames are retrieved by ReadNextFrames, so the memory needed for reading does not depend on
+    the number of frames in the file.
+  */
+  virtual PlusStatus OpenForStreamedRead();
+
+  /*!
+    Read the next maxNumberOfFrames frames (fewer at the end of the sequence) including pixel data and
+    append them to outputFrameList. Frames are retrieved in the order they are stored in the file.
+    \param numberOfFramesRead number of frames appended to outputFrameList, 0 if all frames have been read already
+  */
+  virtual PlusStatus ReadNextFrames(vtkPlusTrackedFrameList* outputFrameList, unsigned int maxNumberOfFrames, unsigned int& numberOfFramesRead);
+
+  /*! Release all resources that were allocated by OpenForStreamedRead */
+  virtual PlusStatus CloseStreamedRead();
+
+  /*! Return the number of frames that have not been retrieved yet by ReadNextFrames */
+  unsigned int GetNumberOfRemainingStreamedFrames();
+
+  /*! Name of the per-frame field that stores if the image data of the frame is valid */
+  virtual std::string GetImageStatusFieldName() const;
+
   /*! Write images to disc, compression allowed */
   virtual PlusStatus WriteImages();
 
@@ -143,6 +166,18 @@ protected:
   /*! Read pixel data from the image */
   virtual PlusStatus ReadImagePixels() = 0;
 
+  /*! Open the pixel data for sequential reading, starting at the first frame. Used by streamed reading. */
+  virtual PlusStatus OpenPixelDataStream();
+
+  /*! Read the next size bytes of uncompressed pixel data. Used by streamed reading. */
+  virtual PlusStatus ReadPixelDataStream(unsigned char* buffer, unsigned int size);
+
+  /*! Close the pixel data stream that was opened by OpenPixelDataStream */
+  virtual void ClosePixelDataStream();
+
+  /*! Size of one frame of pixel data in bytes, as specified in the header. 0 if there is no image data in the file. */
+  unsigned int GetFrameSizeInBytesFromHeader() const;
+
   /*! Write all the fields to the sequence file header */
   virtual PlusStatus WriteInitialImageHeader() = 0;
 
@@ -253,6 +288,12 @@ protected:
   std::string PixelDataFileName;
   /*! file handle for image output */
   FILE* OutputImageFileHandle;
+  /*! file handle for reading pixel data frame by frame */
+  FILE* InputImageFileHandle;
+  /*! True between OpenForStreamedRead and CloseStreamedRead */
+  bool StreamedReadActive;
+  /*! Index of the frame that is returned next by ReadNextFrames */
+  unsigned int NextStreamedFrameNumber;
 
 protected:
   vtkPlusSequenceIOBase();
@@ -11,6 +11,8 @@
 #include "vnl/vnl_sparse_matrix.h"
 #include "vnl/vnl_sparse_matrix_linear_system.h"  
 #include "vnl/algo/vnl_lsqr.h"  
+#include "vnl/algo/vnl_cholesky.h"
+#include "vnl/algo/vnl_svd.h"
 #include "vnl/vnl_cross.h"  
 
 #include "vtkMath.h"
@@ -52,7 +54,8 @@ PlusStatus PlusMath::LSQRMinimize(const std::vector< std::vector<double> > &aMat
   const int n = aMatrix.begin()->size(); 
   const int m = bVector.size();
 
-  std::vector<vnl_vector<double> > aMatrixVnl(m); 
+  std::vector<vnl_vector<double> > aMatrixVnl; 
+  aMatrixVnl.reserve(m); 
   vnl_vector<double> row(n); 
   for ( unsigned int i = 0; i < aMatrix.size(); ++i )
   {
@@ -192,6 +195,211 @@ PlusStatus PlusMath::LSQRMinimize(const vnl_sparse_matrix<double> &sparseMatrixL
   return returnStatus; 
 }
 
+//----------------------------------------------------------------------------
+PlusStatus PlusMath::NormalEquationsMinimize(const std::vector< vnl_vector<double> > &aMatrix, const std::vector<double> &bVector, vnl_vector<double> &resultVector, double* mean/*=NULL*/, double* stdev/*=NULL*/, vnl_vector<unsigned int>* notOutliersIndices /*=NULL*/)
+{
+  LOG_TRACE("PlusMath::NormalEquationsMinimize"); 
+
+  if (aMatrix.size()==0)
+  {
+    LOG_ERROR("NormalEquationsMinimize: A matrix is empty");
+    resultVector.clear();
+    return PLUS_FAIL;
+  }
+  if (bVector.size()!=aMatrix.size())
+  {
+    LOG_ERROR("NormalEquationsMinimize: A matrix and b vector dimensions were not met (number of equations were not the same)");
+    resultVector.clear();
+    return PLUS_FAIL;
+  }
+
+  const int n = aMatrix.begin()->size(); 
+  const int m = bVector.size();
+
+  vnl_matrix<double> denseMatrixLeftSide(m, n);
+  vnl_vector<double> vectorRightSide(m);
+  for (int row = 0; row < m; row++)
+  {
+    denseMatrixLeftSide.set_row(row, aMatrix[row]);
+    vectorRightSide.put(row, bVector[row]);
+  }
+
+  return PlusMath::NormalEquationsMinimize(denseMatrixLeftSide, vectorRightSide, resultVector, mean, stdev, notOutliersIndices); 
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusMath::NormalEquationsMinimize(const vnl_sparse_matrix<double> &sparseMatrixLeftSide, const vnl_vector<double> &vectorRightSide, vnl_vector<double> &resultVector, double* mean/*=NULL*/, double* stdev/*=NULL*/, vnl_vector<unsigned int>* notOutliersIndices/*NULL*/)
+{
+  LOG_TRACE("PlusMath::NormalEquationsMinimize"); 
+
+  vnl_matrix<double> denseMatrixLeftSide(sparseMatrixLeftSide.rows(), sparseMatrixLeftSide.cols(), 0.0);
+  sparseMatrixLeftSide.reset();
+  while (sparseMatrixLeftSide.next())
+  {
+    denseMatrixLeftSide(sparseMatrixLeftSide.getrow(), sparseMatrixLeftSide.getcolumn()) = sparseMatrixLeftSide.value();
+  }
+
+  return PlusMath::NormalEquationsMinimize(denseMatrixLeftSide, vectorRightSide, resultVector, mean, stdev, notOutliersIndices); 
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusMath::NormalEquationsMinimize(const vnl_matrix<double> &aMatrix, const vnl_vector<double> &bVector, vnl_vector<double> &resultVector, double* mean/*=NULL*/, double* stdev/*=NULL*/, vnl_vector<unsigned int>* notOutliersIndices/*NULL*/)
+{
+  LOG_TRACE("PlusMath::NormalEquationsMinimize"); 
+
+  const unsigned int numberOfEquations = aMatrix.rows(); 
+  const unsigned int numberOfUnknowns = aMatrix.cols(); 
+  if (numberOfEquations == 0 || numberOfUnknowns == 0)
+  {
+    LOG_ERROR("NormalEquationsMinimize: A matrix is empty");
+    resultVector.clear();
+    return PLUS_FAIL;
+  }
+  if (bVector.size() != numberOfEquations)
+  {
+    LOG_ERROR("NormalEquationsMinimize: A matrix and b vector dimensions were not met (number of equations were not the same)");
+    resultVector.clear();
+    return PLUS_FAIL;
+  }
+
+  // Accumulate the normal equations (A^T*A x = A^T*b) of all the rows
+  vnl_matrix<double> normalMatrix(numberOfUnknowns, numberOfUnknowns, 0.0);
+  vnl_vector<double> normalVector(numberOfUnknowns, 0.0);
+  std::vector<unsigned int> activeRows(numberOfEquations);
+  for (unsigned int row = 0; row < numberOfEquations; ++row)
+  {
+    activeRows[row] = row;
+    const double* rowData = aMatrix[row];
+    for (unsigned int i = 0; i < numberOfUnknowns; ++i)
+    {
+      for (unsigned int j = 0; j < numberOfUnknowns; ++j)
+      {
+        normalMatrix(i, j) += rowData[i] * rowData[j];
+      }
+      normalVector[i] += rowData[i] * bVector[row];
+    }
+  }
+
+  const double thresholdMultiplier = 3.0; 
+  std::vector<double> differences(numberOfEquations, 0.0);
+  bool outlierFound(true); 
+  while ( outlierFound && (activeRows.size()>MINIMUM_NUMBER_OF_CALIBRATION_EQUATIONS) )
+  {
+    vnl_cholesky cholesky(normalMatrix, vnl_cholesky::quiet);
+    if (cholesky.rank_deficiency() == 0)
+    {
+      resultVector = cholesky.solve(normalVector);
+    }
+    else
+    {
+      // A^T*A is singular, use the minimum norm solution
+      LOG_WARNING("Normal equations fit may be inaccurate, matrix is rank deficient");
+      vnl_svd<double> svd(normalMatrix);
+      svd.zero_out_relative();
+      resultVector = svd.solve(normalVector);
+    }
+
+    // Compute the difference between the measured and computed data ( Ax - b ) for the remaining rows
+    double sumDifference = 0.0;
+    for (unsigned int activeRowIndex = 0; activeRowIndex < activeRows.size(); ++activeRowIndex)
+    {
+      const unsigned int row = activeRows[activeRowIndex];
+      const double* rowData = aMatrix[row];
+      double difference(0); 
+      for (unsigned int i = 0; i < numberOfUnknowns; ++i)
+      {
+        difference += rowData[i] * resultVector[i]; 
+      }
+      difference -= bVector[row]; 
+      differences[activeRowIndex] = difference;
+      sumDifference += difference;
+    }
+    const double meanDifference = sumDifference / activeRows.size();
+    double sumSquaredDiffFromMean = 0.0;
+    for (unsigned int activeRowIndex = 0; activeRowIndex < activeRows.size(); ++activeRowIndex)
+    {
+      sumSquaredDiffFromMean += (differences[activeRowIndex] - meanDifference) * (differences[activeRowIndex] - meanDifference);
+    }
+    const double stdevDifference = sqrt( sumSquaredDiffFromMean / (1.0 * activeRows.size()) ); 
+
+    LOG_DEBUG("Mean = " << std::fixed << meanDifference << "   Stdev = " << stdevDifference); 
+
+    if ( mean != NULL )
+    {
+      *mean = meanDifference; 
+    }
+    if ( stdev != NULL )
+    {
+      *stdev = stdevDifference; 
+    }
+
+    // If the difference from mean larger than thresholdMultiplier * stdev, remove it from the equations
+    std::vector<unsigned int> nonOutlierRows;
+    std::vector<unsigned int> outlierRows;
+    nonOutlierRows.reserve(activeRows.size());
+    for (unsigned int activeRowIndex = 0; activeRowIndex < activeRows.size(); ++activeRowIndex)
+    {
+      if ( fabs(differences[activeRowIndex] - meanDifference) < thresholdMultiplier * stdevDifference )
+      {
+        nonOutlierRows.push_back(activeRows[activeRowIndex]);
+      }
+      else
+      {
+        outlierRows.push_back(activeRows[activeRowIndex]);
+        LOG_DEBUG("Outlier: " << std::fixed << differences[activeRowIndex] << "(mean: " << meanDifference << "  stdev: " << stdevDifference << "  outlierTreshold: " << thresholdMultiplier * stdevDifference << ")" ); 
+      }
+    }
+    outlierFound = !outlierRows.empty();
+    if (!outlierFound)
+    {
+      LOG_DEBUG("*** Outlier removal was successful! No more outlier found!"); 
+      break;
+    }
+    activeRows.swap(nonOutlierRows);
+
+    // Downdate the normal equations by the outlier rows. If most of the rows are removed then it is
+    // faster (and more accurate) to accumulate the remaining rows again.
+    const bool recompute = (outlierRows.size() > activeRows.size());
+    const std::vector<unsigned int>& updateRows = (recompute ? activeRows : outlierRows);
+    const double sign = (recompute ? 1.0 : -1.0);
+    if (recompute)
+    {
+      normalMatrix.fill(0.0);
+      normalVector.fill(0.0);
+    }
+    for (std::vector<unsigned int>::const_iterator rowIt = updateRows.begin(); rowIt != updateRows.end(); ++rowIt)
+    {
+      const double* rowData = aMatrix[*rowIt];
+      for (unsigned int i = 0; i < numberOfUnknowns; ++i)
+      {
+        for (unsigned int j = 0; j < numberOfUnknowns; ++j)
+        {
+          normalMatrix(i, j) += sign * rowData[i] * rowData[j];
+        }
+        normalVector[i] += sign * rowData[i] * bVector[*rowIt];
+      }
+    }
+
+    if (activeRows.size() <= MINIMUM_NUMBER_OF_CALIBRATION_EQUATIONS)
+    {
+      LOG_ERROR("It was not possible calibrate! Not enough equations!"); 
+      return PLUS_FAIL; 
+    }
+  }
+
+  if (notOutliersIndices != NULL && activeRows.size() != numberOfEquations)
+  {
+    vnl_vector<unsigned int> remainingIndices(activeRows.size());
+    for (unsigned int activeRowIndex = 0; activeRowIndex < activeRows.size(); ++activeRowIndex)
+    {
+      remainingIndices.put(activeRowIndex, notOutliersIndices->get(activeRows[activeRowIndex]));
+    }
+    *notOutliersIndices = remainingIndices;
+  }
+
+  return PLUS_SUCCESS; 
+}
+
 //----------------------------------------------------------------------------
 PlusStatus PlusMath::RemoveOutliersFromLSQR(vnl_sparse_matrix<double> &sparseMatrixLeftSide, 
                                             vnl_vector<double> &vectorRightSide, 
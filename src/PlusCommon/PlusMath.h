@@ -12,6 +12,7 @@
 
 #include <vector>
 
+#include "vnl/vnl_matrix.h"
 #include "vnl/vnl_matrix_fixed.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_sparse_matrix.h"
@@ -66,6 +67,24 @@ public:
   */
   static PlusStatus LSQRMinimize(const vnl_sparse_matrix<double> &sparseMatrixLeftSide, const vnl_vector<double> &vectorRightSide, vnl_vector<double> &resultVector, double* mean = NULL, double* stdev = NULL, vnl_vector<unsigned int>* notOutliersIndices=NULL); 
 
+  /*!
+    Solve Ax = b linear equations with robust linear least squares method (normal equations and outlier removal).
+    Faster alternative of LSQRMinimize for tall, thin systems (many equations, few unknowns): A^T*A and A^T*b are accumulated
+    only once, solved by Cholesky decomposition, and the contribution of outlier rows is subtracted from them (downdating)
+    instead of solving the reduced system from scratch. Outliers are removed the same way as in LSQRMinimize.
+    \param aMatrix The coefficient matrix of size m-by-n.
+    \param bVector Column vector of length m.
+    \param resultVector to store the results
+    \param mean Pointer to get the resulting mean of the fit error
+    \param stdev Pointer to get the resulting standard deviation of the fit error
+    \param notOutlierIndices Row that were not removed during the outliers rejection process
+  */
+  static PlusStatus NormalEquationsMinimize(const vnl_matrix<double> &aMatrix, const vnl_vector<double> &bVector, vnl_vector<double> &resultVector, double* mean = NULL, double* stdev = NULL, vnl_vector<unsigned int>* notOutliersIndices=NULL);
+  /*! Solve Ax = b linear equations with robust linear least squares method (normal equations and outlier removal), see NormalEquationsMinimize */
+  static PlusStatus NormalEquationsMinimize(const std::vector<vnl_vector<double> > &aMatrix, const std::vector<double> &bVector, vnl_vector<double> &resultVector, double* mean = NULL, double* stdev = NULL, vnl_vector<unsigned int>* notOutliersIndices=NULL);
+  /*! Solve Ax = b linear equations with robust linear least squares method (normal equations and outlier removal), see NormalEquationsMinimize */
+  static PlusStatus NormalEquationsMinimize(const vnl_sparse_matrix<double> &sparseMatrixLeftSide, const vnl_vector<double> &vectorRightSide, vnl_vector<double> &resultVector, double* mean = NULL, double* stdev = NULL, vnl_vector<unsigned int>* notOutliersIndices=NULL);
+
   /*! Returns the Euclidean distance between two 4x4 homogeneous transformation matrix */
   static double GetPositionDifference(vtkMatrix4x4* aMatrix, vtkMatrix4x4* bMatrix); 
 
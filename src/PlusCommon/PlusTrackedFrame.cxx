@@ -338,7 +338,7 @@ void PlusTrackedFrame::SetFiducialPointsCoordinatePx(vtkPoints* fiducialPoints)
 }
 
 //----------------------------------------------------------------------------
-void PlusTrackedFrame::SetCustomFrameField(std::string name, std::string value)
+void PlusTrackedFrame::SetCustomFrameField(const std::string& name, const std::string& value)
 {
   if (STRCASECMP(name.c_str(), "Timestamp") == 0)
   {
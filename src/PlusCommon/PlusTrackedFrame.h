@@ -62,7 +62,7 @@ public:
   double GetTimestamp() { return this->Timestamp; };
 
   /*! Set custom frame field */
-  void SetCustomFrameField(std::string name, std::string value);
+  void SetCustomFrameField(const std::string& name, const std::string& value);
 
   /*! Get custom frame field value */
   const char* GetCustomFrameField(const char* fieldName);
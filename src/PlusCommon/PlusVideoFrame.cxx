@@ -8,18 +8,23 @@ See License.txt for details.
 #include "PlusVideoFrame.h"
 #include "itkImageBase.h"
 #include "vtkBMPReader.h"
-#include "vtkExtractVOI.h"
 #include "vtkImageData.h"
 #include "vtkImageImport.h"
 #include "vtkImageReader.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPNMReader.h"
+#include "vtkPlusFrameMemoryPool.h"
 #include "vtkTIFFReader.h"
-#include "vtkTrivialProducer.h"
 
 #include <algorithm>
 #include <string>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PLUS_VIDEO_FRAME_USE_SSE2
+#endif
+
 #ifdef PLUS_USE_OpenIGTLink
 #include "igtlImageMessage.h"
 #endif
@@ -334,11 +339,274 @@ namespace
 
     return PLUS_SUCCESS;
   }
+
+  //----------------------------------------------------------------------------
+  // Output images with at least this many pixels are processed by multiple threads.
+  // For smaller images the cost of starting the threads is higher than the gain.
+  const vtkIdType FLIP_CLIP_MIN_NUMBER_OF_PIXELS_FOR_MULTITHREADING = 2 * 1024 * 1024;
+
+  // Size of the square blocks (in pixels) that are transposed together, chosen so that
+  // the source and destination rows of a block stay in the cache
+  const int TRANSPOSE_BLOCK_SIZE = 32;
+
+  //----------------------------------------------------------------------------
+  struct FlipClipGeometry
+  {
+    const void* InputBuffer;
+    void* OutputBuffer;
+    int NumberOfScalarComponents;
+    // Position of the first copied pixel in the input image
+    int ClipOrigin[3];
+    int OutputDimensions[3];
+    // Increments are in number of scalars
+    vtkIdType InputRowIncrement;
+    vtkIdType InputImageIncrement;
+    vtkIdType OutputRowIncrement;
+    vtkIdType OutputImageIncrement;
+    bool HorizontalFlip;
+    bool VerticalFlip;
+    bool ElevationalFlip;
+  };
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void ReverseRowGeneric(const ScalarType* inputRow, ScalarType* outputRow, int width, int numberOfScalarComponents)
+  {
+    const ScalarType* inputPixel = inputRow + (width - 1) * numberOfScalarComponents;
+    if (numberOfScalarComponents == 1)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        outputRow[x] = *(inputPixel - x);
+      }
+      return;
+    }
+    for (int x = 0; x < width; ++x)
+    {
+      for (int s = 0; s < numberOfScalarComponents; ++s)
+      {
+        *(outputRow++) = *(inputPixel + s);
+      }
+      inputPixel -= numberOfScalarComponents;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void ReverseRow(const ScalarType* inputRow, ScalarType* outputRow, int width, int numberOfScalarComponents)
+  {
+    ReverseRowGeneric(inputRow, outputRow, width, numberOfScalarComponents);
+  }
+
+#ifdef PLUS_VIDEO_FRAME_USE_SSE2
+  //----------------------------------------------------------------------------
+  // Reverse the order of the eight 16-bit values in a register
+  inline __m128i Reverse16BitValues(__m128i value)
+  {
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+    value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+  }
+
+  //----------------------------------------------------------------------------
+  template<>
+  void ReverseRow<vtkTypeUInt8>(const vtkTypeUInt8* inputRow, vtkTypeUInt8* outputRow, int width, int numberOfScalarComponents)
+  {
+    if (numberOfScalarComponents != 1)
+    {
+      ReverseRowGeneric(inputRow, outputRow, width, numberOfScalarComponents);
+      return;
+    }
+    // Reverse 16 pixels at a time: swap the bytes in each 16-bit word then reverse the order of the words
+    int x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+      __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputRow + width - x - 16));
+      value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outputRow + x), Reverse16BitValues(value));
+    }
+    for (; x < width; ++x)
+    {
+      outputRow[x] = inputRow[width - 1 - x];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<>
+  void ReverseRow<vtkTypeUInt16>(const vtkTypeUInt16* inputRow, vtkTypeUInt16* outputRow, int width, int numberOfScalarComponents)
+  {
+    if (numberOfScalarComponents != 1)
+    {
+      ReverseRowGeneric(inputRow, outputRow, width, numberOfScalarComponents);
+      return;
+    }
+    // Reverse 8 pixels at a time
+    int x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+      __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inputRow + width - x - 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(outputRow + x), Reverse16BitValues(value));
+    }
+    for (; x < width; ++x)
+    {
+      outputRow[x] = inputRow[width - 1 - x];
+    }
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  // Copy output rows [firstRow, lastRow) (rows of all slices are numbered continuously), applying flips along any axes
+  template<class ScalarType>
+  void FlipClipRows(const FlipClipGeometry& geometry, vtkIdType firstRow, vtkIdType lastRow)
+  {
+    const int outputWidth = geometry.OutputDimensions[0];
+    const int outputHeight = geometry.OutputDimensions[1];
+    const int outputDepth = geometry.OutputDimensions[2];
+    const int numberOfScalarComponents = geometry.NumberOfScalarComponents;
+    const ScalarType* inBuff = static_cast<const ScalarType*>(geometry.InputBuffer);
+    ScalarType* outBuff = static_cast<ScalarType*>(geometry.OutputBuffer);
+
+    for (vtkIdType row = firstRow; row < lastRow; ++row)
+    {
+      const int z = static_cast<int>(row / outputHeight);
+      const int y = static_cast<int>(row % outputHeight);
+      const int inputZ = geometry.ClipOrigin[2] + (geometry.ElevationalFlip ? outputDepth - 1 - z : z);
+      const int inputY = geometry.ClipOrigin[1] + (geometry.VerticalFlip ? outputHeight - 1 - y : y);
+      const ScalarType* inputRow = inBuff + inputZ * geometry.InputImageIncrement + inputY * geometry.InputRowIncrement + geometry.ClipOrigin[0] * numberOfScalarComponents;
+      ScalarType* outputRow = outBuff + z * geometry.OutputImageIncrement + y * geometry.OutputRowIncrement;
+      if (geometry.HorizontalFlip)
+      {
+        ReverseRow<ScalarType>(inputRow, outputRow, outputWidth, numberOfScalarComponents);
+      }
+      else
+      {
+        memcpy(outputRow, inputRow, outputWidth * numberOfScalarComponents * sizeof(ScalarType));
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Transpose an image in KIJ layout to IJK layout: output(i, j, k) = input(j, k, i), for output slices [firstSlice, lastSlice).
+  // The slices are processed in square blocks to keep both the read and the written rows in the cache.
+  template<class ScalarType>
+  void TransposeSlices(const FlipClipGeometry& geometry, vtkIdType firstSlice, vtkIdType lastSlice)
+  {
+    const int outputWidth = geometry.OutputDimensions[0];
+    const int outputHeight = geometry.OutputDimensions[1];
+    const int numberOfScalarComponents = geometry.NumberOfScalarComponents;
+    const ScalarType* inBuff = static_cast<const ScalarType*>(geometry.InputBuffer);
+    ScalarType* outBuff = static_cast<ScalarType*>(geometry.OutputBuffer);
+
+    for (vtkIdType z = firstSlice; z < lastSlice; ++z)
+    {
+      const ScalarType* inputSlice = inBuff + (geometry.ClipOrigin[1] + z) * geometry.InputRowIncrement + geometry.ClipOrigin[0] * numberOfScalarComponents;
+      ScalarType* outputSlice = outBuff + z * geometry.OutputImageIncrement;
+      for (int blockY = 0; blockY < outputHeight; blockY += TRANSPOSE_BLOCK_SIZE)
+      {
+        const int blockHeight = std::min(TRANSPOSE_BLOCK_SIZE, outputHeight - blockY);
+        for (int blockX = 0; blockX < outputWidth; blockX += TRANSPOSE_BLOCK_SIZE)
+        {
+          const int blockWidth = std::min(TRANSPOSE_BLOCK_SIZE, outputWidth - blockX);
+          for (int x = blockX; x < blockX + blockWidth; ++x)
+          {
+            // Each output column of the block is a contiguous part of an input row
+            const ScalarType* inputPixel = inputSlice + (geometry.ClipOrigin[2] + x) * geometry.InputImageIncrement + blockY * numberOfScalarComponents;
+            ScalarType* outputPixel = outputSlice + blockY * geometry.OutputRowIncrement + x * numberOfScalarComponents;
+            for (int y = 0; y < blockHeight; ++y)
+            {
+              for (int s = 0; s < numberOfScalarComponents; ++s)
+              {
+                outputPixel[s] = inputPixel[s];
+              }
+              inputPixel += numberOfScalarComponents;
+              outputPixel += geometry.OutputRowIncrement;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  struct FlipClipThreadFunctionInfoStruct
+  {
+    FlipClipGeometry Geometry;
+    vtkIdType NumberOfWorkItems;
+    void (*ProcessWorkItems)(const FlipClipGeometry& geometry, vtkIdType firstItem, vtkIdType lastItem);
+  };
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE FlipClipThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    FlipClipThreadFunctionInfoStruct* str = static_cast<FlipClipThreadFunctionInfoStruct*>(threadInfo->UserData);
+    // Each thread processes a contiguous range of output rows (or slices)
+    vtkIdType firstItem = str->NumberOfWorkItems * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+    vtkIdType lastItem = str->NumberOfWorkItems * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+    str->ProcessWorkItems(str->Geometry, firstItem, lastItem);
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  // Flip, transpose and clip images that have no paired rows or columns. The output is computed row by row
+  // (slice by slice for transposition) and large images are split between multiple threads.
+  template<class ScalarType>
+  PlusStatus FlipClipImageByRows(vtkImageData* inputImage, const PlusVideoFrame::FlipInfoType& flipInfo, const int clipRectangleOrigin[3], vtkImageData* outputImage)
+  {
+    FlipClipThreadFunctionInfoStruct str;
+    FlipClipGeometry& geometry = str.Geometry;
+    geometry.InputBuffer = inputImage->GetScalarPointer();
+    geometry.OutputBuffer = outputImage->GetScalarPointer();
+    geometry.NumberOfScalarComponents = inputImage->GetNumberOfScalarComponents();
+    geometry.ClipOrigin[0] = clipRectangleOrigin[0];
+    geometry.ClipOrigin[1] = clipRectangleOrigin[1];
+    geometry.ClipOrigin[2] = clipRectangleOrigin[2];
+    outputImage->GetDimensions(geometry.OutputDimensions);
+    vtkIdType pixelIncrement(0);
+    inputImage->GetIncrements(pixelIncrement, geometry.InputRowIncrement, geometry.InputImageIncrement);
+    outputImage->GetIncrements(pixelIncrement, geometry.OutputRowIncrement, geometry.OutputImageIncrement);
+    geometry.HorizontalFlip = flipInfo.hFlip;
+    geometry.VerticalFlip = flipInfo.vFlip;
+    geometry.ElevationalFlip = flipInfo.eFlip;
+
+    if (flipInfo.tranpose == PlusVideoFrame::TRANSPOSE_IJKtoKIJ)
+    {
+      if (flipInfo.hFlip || flipInfo.vFlip || flipInfo.eFlip)
+      {
+        LOG_ERROR("Operation not permitted. Flipping and transposing an image at the same time is not supported.");
+        return PLUS_FAIL;
+      }
+      str.ProcessWorkItems = &TransposeSlices<ScalarType>;
+      str.NumberOfWorkItems = geometry.OutputDimensions[2];
+    }
+    else
+    {
+      str.ProcessWorkItems = &FlipClipRows<ScalarType>;
+      str.NumberOfWorkItems = static_cast<vtkIdType>(geometry.OutputDimensions[1]) * geometry.OutputDimensions[2];
+    }
+
+    vtkIdType numberOfPixels = static_cast<vtkIdType>(geometry.OutputDimensions[0]) * geometry.OutputDimensions[1] * geometry.OutputDimensions[2];
+    if (numberOfPixels < FLIP_CLIP_MIN_NUMBER_OF_PIXELS_FOR_MULTITHREADING || str.NumberOfWorkItems < 2)
+    {
+      str.ProcessWorkItems(geometry, 0, str.NumberOfWorkItems);
+      return PLUS_SUCCESS;
+    }
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    if (threader->GetNumberOfThreads() > str.NumberOfWorkItems)
+    {
+      threader->SetNumberOfThreads(static_cast<int>(str.NumberOfWorkItems));
+    }
+    threader->SetSingleMethod(FlipClipThreadFunction, &str);
+    threader->SingleMethodExecute();
+    return PLUS_SUCCESS;
+  }
 }
 
 //----------------------------------------------------------------------------
 PlusVideoFrame::PlusVideoFrame()
   : Image(NULL)
+  , FrameMemoryPool(NULL)
   , ImageType(US_IMG_BRIGHTNESS)
   , ImageOrientation(US_IMG_ORIENT_MF)
 {
@@ -347,6 +615,7 @@ PlusVideoFrame::PlusVideoFrame()
 //----------------------------------------------------------------------------
 PlusVideoFrame::PlusVideoFrame(const PlusVideoFrame& videoItem)
   : Image(NULL)
+  , FrameMemoryPool(NULL)
   , ImageType(US_IMG_BRIGHTNESS)
   , ImageOrientation(US_IMG_ORIENT_MF)
 {
@@ -357,6 +626,7 @@ PlusVideoFrame::PlusVideoFrame(const PlusVideoFrame& videoItem)
 PlusVideoFrame::~PlusVideoFrame()
 {
   DELETE_IF_NOT_NULL(this->Image);
+  this->SetFrameMemoryPool(NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -371,6 +641,12 @@ PlusVideoFrame& PlusVideoFrame::operator=(PlusVideoFrame const& videoItem)
   this->ImageType = videoItem.ImageType;
   this->ImageOrientation = videoItem.ImageOrientation;
 
+  // Copies of pooled frames (e.g., tracked frames retrieved from a buffer) are allocated from the same pool
+  if (this->FrameMemoryPool == NULL)
+  {
+    this->SetFrameMemoryPool(videoItem.FrameMemoryPool);
+  }
+
   // Copy the pixels. Don't use image duplicator, because that wouldn't reuse the existing buffer
   if (videoItem.GetFrameSizeInBytes() > 0)
   {
@@ -421,7 +697,7 @@ PlusStatus PlusVideoFrame::FillBlank()
 
 
 //----------------------------------------------------------------------------
-PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const int imageSize[3], PlusCommon::VTKScalarPixelType pixType, int numberOfScalarComponents)
+PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const int imageSize[3], PlusCommon::VTKScalarPixelType pixType, int numberOfScalarComponents, vtkPlusFrameMemoryPool* frameMemoryPool)
 {
   if (imageSize[0] > 0 && imageSize[1] > 0 && imageSize[2] == 0)
   {
@@ -444,13 +720,17 @@ PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const int imageSiz
   }
 
   image->SetExtent(0, imageSize[0] - 1, 0, imageSize[1] - 1, 0, imageSize[2] - 1);
+  if (frameMemoryPool != NULL)
+  {
+    return frameMemoryPool->AllocateScalars(image, pixType, numberOfScalarComponents);
+  }
   image->AllocateScalars(pixType, numberOfScalarComponents);
 
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const unsigned int imageSize[3], PlusCommon::VTKScalarPixelType pixType, unsigned int numberOfScalarComponents)
+PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const unsigned int imageSize[3], PlusCommon::VTKScalarPixelType pixType, unsigned int numberOfScalarComponents, vtkPlusFrameMemoryPool* frameMemoryPool)
 {
   if (imageSize[0] > 0 && imageSize[1] > 0 && imageSize[2] == 0)
   {
@@ -473,6 +753,10 @@ PlusStatus PlusVideoFrame::AllocateFrame(vtkImageData* image, const unsigned int
   }
 
   image->SetExtent(0, imageSize[0] - 1, 0, imageSize[1] - 1, 0, imageSize[2] - 1);
+  if (frameMemoryPool != NULL)
+  {
+    return frameMemoryPool->AllocateScalars(image, pixType, numberOfScalarComponents);
+  }
   image->AllocateScalars(pixType, numberOfScalarComponents);
 
   return PLUS_SUCCESS;
@@ -485,7 +769,7 @@ PlusStatus PlusVideoFrame::AllocateFrame(const int imageSize[3], PlusCommon::VTK
   {
     this->SetImageData(vtkImageData::New());
   }
-  PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents);
+  PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents, this->FrameMemoryPool);
   return allocStatus;
 }
 
@@ -496,7 +780,7 @@ PlusStatus PlusVideoFrame::AllocateFrame(const unsigned int imageSize[3], PlusCo
   {
     this->SetImageData(vtkImageData::New());
   }
-  PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents);
+  PlusStatus allocStatus = PlusVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents, this->FrameMemoryPool);
   return allocStatus;
 }
 
@@ -1151,30 +1435,12 @@ PlusStatus PlusVideoFrame::FlipClipImage(vtkImageData* inUsImage,
     return PLUS_FAIL;
   }
 
-  if (!flipInfo.hFlip && !flipInfo.vFlip && !flipInfo.eFlip && flipInfo.tranpose == TRANSPOSE_NONE)
+  const bool flipOrTransposeRequested = (flipInfo.hFlip || flipInfo.vFlip || flipInfo.eFlip || flipInfo.tranpose != TRANSPOSE_NONE);
+  if (!flipOrTransposeRequested && !PlusCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
   {
-    if (PlusCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
-    {
-      // No flip or transpose, but clipping requested, let vtk do the heavy lifting
-      vtkSmartPointer<vtkExtractVOI> extract = vtkSmartPointer<vtkExtractVOI>::New();
-      vtkSmartPointer<vtkTrivialProducer> tp = vtkSmartPointer<vtkTrivialProducer>::New();
-      tp->SetOutput(inUsImage);
-      extract->SetInputConnection(tp->GetOutputPort());
-      extract->SetVOI(
-        clipRectangleOrigin[0], clipRectangleOrigin[0] + clipRectangleSize[0] - 1,
-        clipRectangleOrigin[1], clipRectangleOrigin[1] + clipRectangleSize[1] - 1,
-        clipRectangleOrigin[2], clipRectangleOrigin[2] + clipRectangleSize[2] - 1
-      );
-      extract->SetOutput(outUsOrientedImage);
-      extract->Update();
-      return PLUS_SUCCESS;
-    }
-    else
-    {
-      // no flip, clip or transpose
-      outUsOrientedImage->DeepCopy(inUsImage);
-      return PLUS_SUCCESS;
-    }
+    // no flip, clip or transpose
+    outUsOrientedImage->DeepCopy(inUsImage);
+    return PLUS_SUCCESS;
   }
 
   // Validate output image is correct dimensions to receive final oriented and/or clipped result
@@ -1242,9 +1508,43 @@ PlusStatus PlusVideoFrame::FlipClipImage(vtkImageData* inUsImage,
     outUsOrientedImage->AllocateScalars(inUsImage->GetScalarType(), inUsImage->GetNumberOfScalarComponents());
   }
 
+  if (!flipOrTransposeRequested)
+  {
+    // Clipping only: keep the geometry of the clipped region
+    double* inputSpacing = inUsImage->GetSpacing();
+    double* inputOrigin = inUsImage->GetOrigin();
+    outUsOrientedImage->SetSpacing(inputSpacing);
+    outUsOrientedImage->SetOrigin(inputOrigin[0] + finalClipOrigin[0] * inputSpacing[0],
+                                  inputOrigin[1] + finalClipOrigin[1] * inputSpacing[1],
+                                  inputOrigin[2] + finalClipOrigin[2] * inputSpacing[2]);
+  }
+
   int numberOfBytesPerScalar = PlusVideoFrame::GetNumberOfBytesPerScalar(inUsImage->GetScalarType());
 
   PlusStatus status(PLUS_FAIL);
+  if (!flipInfo.doubleRow && !flipInfo.doubleColumn)
+  {
+    switch (numberOfBytesPerScalar)
+    {
+    case 1:
+      status = FlipClipImageByRows<vtkTypeUInt8>(inUsImage, flipInfo, finalClipOrigin, outUsOrientedImage);
+      break;
+    case 2:
+      status = FlipClipImageByRows<vtkTypeUInt16>(inUsImage, flipInfo, finalClipOrigin, outUsOrientedImage);
+      break;
+    case 4:
+      status = FlipClipImageByRows<vtkTypeUInt32>(inUsImage, flipInfo, finalClipOrigin, outUsOrientedImage);
+      break;
+    case 8:
+      status = FlipClipImageByRows<vtkTypeUInt64>(inUsImage, flipInfo, finalClipOrigin, outUsOrientedImage);
+      break;
+    default:
+      LOG_ERROR("Unsupported bit depth: " << numberOfBytesPerScalar << " bytes per scalar");
+    }
+    return status;
+  }
+
+  // Pairs of rows or columns are kept together (RF data)
   switch (numberOfBytesPerScalar)
   {
   case 1:
@@ -1450,6 +1750,30 @@ void PlusVideoFrame::SetImageData(vtkImageData* imageData)
   this->Image = imageData;
 }
 
+//----------------------------------------------------------------------------
+void PlusVideoFrame::SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool)
+{
+  if (this->FrameMemoryPool == frameMemoryPool)
+  {
+    return;
+  }
+  if (this->FrameMemoryPool != NULL)
+  {
+    this->FrameMemoryPool->UnRegister(NULL);
+  }
+  this->FrameMemoryPool = frameMemoryPool;
+  if (this->FrameMemoryPool != NULL)
+  {
+    this->FrameMemoryPool->Register(NULL);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkPlusFrameMemoryPool* PlusVideoFrame::GetFrameMemoryPool() const
+{
+  return this->FrameMemoryPool;
+}
+
 //----------------------------------------------------------------------------
 #define VTK_TO_STRING(pixType) case pixType: return "##pixType"
 std::string PlusVideoFrame::GetStringFromVTKPixelType(PlusCommon::VTKScalarPixelType vtkScalarPixelType)
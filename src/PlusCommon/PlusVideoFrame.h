@@ -14,6 +14,8 @@ See License.txt for details.
 #include "vtkImageExport.h"
 #include "vtkImageData.h"
 
+class vtkPlusFrameMemoryPool;
+
 /*!
 \enum US_IMAGE_ORIENTATION
 \brief Defines constant values for ultrasound image orientation
@@ -105,10 +107,13 @@ public:
   /*! Equality operator */
   PlusVideoFrame& operator=(PlusVideoFrame const& videoItem);
 
-  /*! Allocate memory for the image. The image object must be already created. */
-  static PlusStatus AllocateFrame(vtkImageData* image, const int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, int numberOfScalarComponents);
-  static PlusStatus AllocateFrame(vtkImageData* image, const unsigned int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, unsigned int numberOfScalarComponents);
-  /*! Allocate memory for the image. */
+  /*!
+    Allocate memory for the image. The image object must be already created.
+    If a frame memory pool is specified then the pixel buffer is taken from the pool.
+  */
+  static PlusStatus AllocateFrame(vtkImageData* image, const int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, int numberOfScalarComponents, vtkPlusFrameMemoryPool* frameMemoryPool = NULL);
+  static PlusStatus AllocateFrame(vtkImageData* image, const unsigned int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, unsigned int numberOfScalarComponents, vtkPlusFrameMemoryPool* frameMemoryPool = NULL);
+  /*! Allocate memory for the image. The pixel buffer is taken from the frame memory pool if it is set. */
   PlusStatus AllocateFrame(const int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, int numberOfScalarComponents);
   PlusStatus AllocateFrame(const unsigned int imageSize[3], PlusCommon::VTKScalarPixelType vtkScalarPixelType, unsigned int numberOfScalarComponents);
 
@@ -173,6 +178,14 @@ public:
   /*! Get the VTK image, does not copy the pixel buffer */
   vtkImageData* GetImage() const;
 
+  /*!
+    Set the pool that pixel buffers are allocated from. If NULL (default) then pixel buffers are allocated by VTK.
+    Copies of the frame use the same pool, unless the destination frame has its own pool.
+  */
+  void SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool);
+  /*! Get the pool that pixel buffers are allocated from */
+  vtkPlusFrameMemoryPool* GetFrameMemoryPool() const;
+
   /*! Copy pixel data from another PlusVideoFrame object, same as operator= */
   PlusStatus DeepCopy(PlusVideoFrame* DataBufferItem);
 
@@ -283,7 +296,8 @@ public:
       const int clipRectangleSize[3]);
 
   /*!
-  Flip a 2D image along one or two axes. This is a performance optimized version of flipping that does not use ITK filters
+  Flip a 2D image along one or two axes. This is a performance optimized version of flipping that does not use ITK filters.
+  Large images are processed by multiple threads.
   \param clipRectangleOrigin the clipping origin relative to the inUsImage data origin
   \param clipRectangleSize the size of the clipping space, a value of NO_CLIP in either [0],[1] or [2] indicates no clipping performed
   */
@@ -320,6 +334,7 @@ protected:
   void SetImageData(vtkImageData* imageData);
 
   vtkImageData* Image;
+  vtkPlusFrameMemoryPool* FrameMemoryPool;
   US_IMAGE_TYPE ImageType;
   US_IMAGE_ORIENTATION ImageOrientation;
 };
@@ -87,7 +87,51 @@ void* timerTestThread( vtkMultiThreader::ThreadInfo *data )
   return 0;
 }
 
+//----------------------------------------------------------------------------
+// Test that time does not advance while the virtual clock is enabled
+PlusStatus TestVirtualClock()
+{
+  const double virtualTimeSec = 123.5;
+  vtkPlusAccurateTimer::SetVirtualClockEnabled(true);
+  vtkPlusAccurateTimer::SetVirtualTime(virtualTimeSec);
+  vtkPlusAccurateTimer::Delay(0.05);
+  double systemTime = vtkPlusAccurateTimer::GetSystemTime();
+  double universalTime = vtkPlusAccurateTimer::GetUniversalTime();
+  vtkPlusAccurateTimer::SetVirtualClockEnabled(false);
+
+  if (systemTime != virtualTimeSec)
+  {
+    LOG_ERROR("System time does not match the virtual time: " << systemTime << " (expected " << virtualTimeSec << ")");
+    return PLUS_FAIL;
+  }
+  if (fabs(vtkPlusAccurateTimer::GetSystemTimeFromUniversalTime(universalTime) - virtualTimeSec) > 1e-3)
+  {
+    LOG_ERROR("Universal time does not match the virtual time: " << universalTime);
+    return PLUS_FAIL;
+  }
+  if (vtkPlusAccurateTimer::GetSystemTime() == virtualTimeSec)
+  {
+    LOG_ERROR("System time is still provided by the virtual clock after it has been disabled");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
 
+//----------------------------------------------------------------------------
+// Test that waiting until an absolute time does not return early
+PlusStatus TestDelayUntil()
+{
+  const double delaySec = 0.05;
+  double wakeupTime = vtkPlusAccurateTimer::GetSystemTime() + delaySec;
+  vtkPlusAccurateTimer::DelayUntil(wakeupTime);
+  double actualWakeupTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (actualWakeupTime < wakeupTime - 0.001)
+  {
+    LOG_ERROR("DelayUntil returned " << (wakeupTime - actualWakeupTime) * 1000.0 << " ms before the requested time");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
 
 int main(int argc, char **argv)
 {
@@ -123,6 +167,17 @@ int main(int argc, char **argv)
 
   vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
 
+  if (TestVirtualClock() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Virtual clock test failed");
+    exit(EXIT_FAILURE);
+  }
+  if (TestDelayUntil() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("DelayUntil test failed");
+    exit(EXIT_FAILURE);
+  }
+
   gMaxDelaySec=averageIntendedDelaySec*2.0; // delay is generated by a uniform distribution => max = mean * 2
 
   LOG_INFO("Testing the accurate timer: numberOfThreads="<<numberOfThreads
@@ -25,6 +25,9 @@ int TestLSQRMinimize(vtkXMLDataElement* xmlPlusMathTest);
 PlusStatus ReadLSQRDataFromXml(vtkXMLDataElement* xmlLSQRMinimize, std::vector<vnl_vector<double> > &aMatrix, std::vector<double> &bVector); 
 PlusStatus GenerateLSQRData(vtkXMLDataElement* xmlLSQRMinimize, int numberOfData, int numberOfOutliers); 
 
+// ************************ PlusMath::NormalEquationsMinimize ****************************
+int TestNormalEquationsMinimize(vtkXMLDataElement* xmlPlusMathTest); 
+
 template<class floatType> int TestFloor(const char* floatName);
 
 //----------------------------------------------------------------------------
@@ -78,6 +81,9 @@ int main(int argc, char **argv)
   // Test PlusMath::LSQRMinimize 
   numberOfErrors += TestLSQRMinimize(xmlPlusMathTest); 
 
+  // Test PlusMath::NormalEquationsMinimize 
+  numberOfErrors += TestNormalEquationsMinimize(xmlPlusMathTest); 
+
   numberOfErrors += TestFloor<float>("float");
   numberOfErrors += TestFloor<double>("double");
 
@@ -178,6 +184,90 @@ int TestLSQRMinimize(vtkXMLDataElement* xmlPlusMathTest)
   return numberOfErrors; 
 }
 
+//----------------------------------------------------------------------------
+int TestNormalEquationsMinimize(vtkXMLDataElement* xmlPlusMathTest)
+{
+  LOG_INFO("Testing PlusMath::NormalEquationsMinimize function..."); 
+
+  int numberOfErrors(0); 
+
+  vtkXMLDataElement* xmlLSQRMinimize = ( xmlPlusMathTest != NULL ? xmlPlusMathTest->FindNestedElementWithName("LSQRMinimize") : NULL ); 
+  if ( xmlLSQRMinimize == NULL )
+  {
+    LOG_ERROR("Unable to find LSQRMinimize xml data element in config file!"); 
+    numberOfErrors++; 
+    return numberOfErrors; 
+  }
+
+  std::vector<vnl_vector<double> > aMatrix; 
+  std::vector<double> bVector;  
+  ReadLSQRDataFromXml(xmlLSQRMinimize, aMatrix, bVector); 
+
+  // Solve the same system with both methods, the results (including the rejected outliers) must be the same
+  vnl_vector<double> lsqrResultVector(2,0); 
+  vnl_vector<unsigned int> lsqrNotOutliersIndices(bVector.size()); 
+  for ( unsigned int i = 0; i < bVector.size(); ++i )
+  {
+    lsqrNotOutliersIndices.put(i, i); 
+  }
+  double lsqrStartTime = vtkPlusAccurateTimer::GetSystemTime(); 
+  if ( PlusMath::LSQRMinimize(aMatrix, bVector, lsqrResultVector, NULL, NULL, &lsqrNotOutliersIndices) != PLUS_SUCCESS )
+  {
+    LOG_ERROR("Failed to run LSQRMinimize on dataset!"); 
+    numberOfErrors++; 
+  }
+  double lsqrTimeSec = vtkPlusAccurateTimer::GetSystemTime() - lsqrStartTime; 
+
+  vnl_vector<double> resultVector(2,0); 
+  vnl_vector<unsigned int> notOutliersIndices(bVector.size()); 
+  for ( unsigned int i = 0; i < bVector.size(); ++i )
+  {
+    notOutliersIndices.put(i, i); 
+  }
+  double startTime = vtkPlusAccurateTimer::GetSystemTime(); 
+  if ( PlusMath::NormalEquationsMinimize(aMatrix, bVector, resultVector, NULL, NULL, &notOutliersIndices) != PLUS_SUCCESS )
+  {
+    LOG_ERROR("Failed to run NormalEquationsMinimize on dataset!"); 
+    numberOfErrors++; 
+    return numberOfErrors; 
+  }
+  double timeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime; 
+
+  LOG_INFO("Linear equation: y = " << resultVector[1] << " + " << resultVector[0] << " x "); 
+  LOG_INFO("Computation time of " << bVector.size() << " equations: LSQRMinimize: " << lsqrTimeSec * 1000.0 << " ms, NormalEquationsMinimize: " << timeSec * 1000.0 << " ms"); 
+
+  for ( unsigned int i = 0; i < resultVector.size(); ++i )
+  {
+    if ( fabs(lsqrResultVector[i] - resultVector[i]) > DOUBLE_DIFF )
+    {
+      LOG_ERROR("Result element " << i << " differs from LSQRMinimize result (current: " << std::fixed << resultVector[i] << "  LSQRMinimize: " << lsqrResultVector[i] << ")!"); 
+      numberOfErrors++; 
+    }
+  }
+
+  if ( notOutliersIndices.size() != lsqrNotOutliersIndices.size() )
+  {
+    LOG_ERROR("Number of non-outlier equations differs from LSQRMinimize (current: " << notOutliersIndices.size() << "  LSQRMinimize: " << lsqrNotOutliersIndices.size() << ")!"); 
+    numberOfErrors++; 
+  }
+
+  vtkXMLDataElement* xmlResult = xmlLSQRMinimize->FindNestedElementWithName("Result"); 
+  double x0Base(0); 
+  double xBase(0); 
+  if ( xmlResult == NULL || !xmlResult->GetScalarAttribute("x0", x0Base) || !xmlResult->GetScalarAttribute("x", xBase) )
+  {
+    LOG_ERROR("Unable to find x0 and x attributes under LSQRMinimize Result tag!"); 
+    numberOfErrors++; 
+  }
+  else if ( fabs(x0Base - resultVector[1]) > DOUBLE_DIFF || fabs(xBase - resultVector[0]) > DOUBLE_DIFF )
+  {
+    LOG_ERROR("Result differs from baseline (current: " << std::fixed << resultVector[1] << ", " << resultVector[0] << "  baseline: " << x0Base << ", " << xBase << ")!"); 
+    numberOfErrors++; 
+  }
+
+  return numberOfErrors; 
+}
+
 //----------------------------------------------------------------------------
 PlusStatus ReadLSQRDataFromXml(vtkXMLDataElement* xmlLSQRMinimize, std::vector<vnl_vector<double> > &aMatrix, std::vector<double> &bVector)
 {
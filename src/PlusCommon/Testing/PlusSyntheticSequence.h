@@ -0,0 +1,77 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusSyntheticSequence.h
+  \brief Synthetic tracked frames and sequence files with known content, shared by the tests
+
+  Frame i has timestamp framePeriodSec*i, all pixels of its 8x6 image are set to i (modulo 256)
+  and the translation of each Tool<t>ToTracker transform is (i, t, 0).
+*/
+
+#ifndef __PlusSyntheticSequence_h
+#define __PlusSyntheticSequence_h
+
+#include "PlusConfigure.h"
+#include "PlusTrackedFrame.h"
+#include "vtkMatrix4x4.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+
+#include <string.h>
+
+namespace PlusSyntheticSequence
+{
+  //----------------------------------------------------------------------------
+  /*! Fill a tracked frame with the content of the specified frame of the synthetic sequence */
+  inline void CreateFrame(PlusTrackedFrame& trackedFrame, int frameIndex, double framePeriodSec = 0.1, int numberOfTools = 0)
+  {
+    const int frameSize[3] = {8, 6, 1};
+    trackedFrame.SetTimestamp(framePeriodSec * frameIndex);
+    trackedFrame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    trackedFrame.GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF);
+    trackedFrame.GetImageData()->SetImageType(US_IMG_BRIGHTNESS);
+    memset(trackedFrame.GetImageData()->GetScalarPointer(), frameIndex % 256, trackedFrame.GetImageData()->GetFrameSizeInBytes());
+
+    for (int t = 0; t < numberOfTools; ++t)
+    {
+      vtkSmartPointer<vtkMatrix4x4> toolToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+      toolToTracker->SetElement(0, 3, frameIndex);
+      toolToTracker->SetElement(1, 3, t);
+      PlusTransformName toolToTrackerName(std::string("Tool") + PlusCommon::ToString(t), "Tracker");
+      trackedFrame.SetCustomFrameTransform(toolToTrackerName, toolToTracker);
+      trackedFrame.SetCustomFrameTransformStatus(toolToTrackerName, FIELD_OK);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Append the first numberOfFrames frames of the synthetic sequence to a tracked frame list */
+  inline void CreateFrameList(vtkPlusTrackedFrameList* trackedFrameList, int numberOfFrames, double framePeriodSec = 0.1, int numberOfTools = 0)
+  {
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      PlusTrackedFrame trackedFrame;
+      CreateFrame(trackedFrame, i, framePeriodSec, numberOfTools);
+      trackedFrameList->AddTrackedFrame(&trackedFrame);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Write the first numberOfFrames frames of the synthetic sequence to an uncompressed sequence file */
+  inline PlusStatus WriteSequenceFile(const std::string& fileName, int numberOfFrames, double framePeriodSec = 0.1, int numberOfTools = 0)
+  {
+    vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    CreateFrameList(trackedFrameList, numberOfFrames, framePeriodSec, numberOfTools);
+    if (vtkPlusSequenceIO::Write(fileName, trackedFrameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write sequence file " << fileName);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusVideoFrameTest.cxx
+  \brief Test image flipping, transposition and clipping in PlusVideoFrame::FlipClipImage
+
+  Every orientation pair that PlusVideoFrame::GetFlipAxes supports is tested with 2D and 3D images
+  of different pixel types, with and without clipping. The result is compared to a reference that
+  is computed pixel by pixel. Images that are large enough to be processed by multiple threads are tested as well.
+*/
+
+#include "PlusConfigure.h"
+
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtkImageData.h"
+
+#include "PlusVideoFrame.h"
+
+#include <string.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Orientation pairs that are supported by PlusVideoFrame::GetFlipAxes (in addition to converting to the same orientation)
+  const US_IMAGE_ORIENTATION SUPPORTED_ORIENTATION_PAIRS[][2] =
+  {
+    {US_IMG_ORIENT_UF, US_IMG_ORIENT_MF}, {US_IMG_ORIENT_MF, US_IMG_ORIENT_UF},
+    {US_IMG_ORIENT_UN, US_IMG_ORIENT_MN}, {US_IMG_ORIENT_MN, US_IMG_ORIENT_UN},
+    {US_IMG_ORIENT_FU, US_IMG_ORIENT_NU}, {US_IMG_ORIENT_NU, US_IMG_ORIENT_FU},
+    {US_IMG_ORIENT_FM, US_IMG_ORIENT_NM}, {US_IMG_ORIENT_NM, US_IMG_ORIENT_FM},
+    {US_IMG_ORIENT_UF, US_IMG_ORIENT_UN}, {US_IMG_ORIENT_MF, US_IMG_ORIENT_MN},
+    {US_IMG_ORIENT_UN, US_IMG_ORIENT_UF}, {US_IMG_ORIENT_MN, US_IMG_ORIENT_MF},
+    {US_IMG_ORIENT_FU, US_IMG_ORIENT_FM}, {US_IMG_ORIENT_NU, US_IMG_ORIENT_NM},
+    {US_IMG_ORIENT_FM, US_IMG_ORIENT_FU}, {US_IMG_ORIENT_NM, US_IMG_ORIENT_NU},
+    {US_IMG_ORIENT_UFA, US_IMG_ORIENT_UFD}, {US_IMG_ORIENT_UFD, US_IMG_ORIENT_UFA},
+    {US_IMG_ORIENT_MFA, US_IMG_ORIENT_MFD}, {US_IMG_ORIENT_MFD, US_IMG_ORIENT_MFA},
+    {US_IMG_ORIENT_UNA, US_IMG_ORIENT_UND}, {US_IMG_ORIENT_UND, US_IMG_ORIENT_UNA},
+    {US_IMG_ORIENT_MNA, US_IMG_ORIENT_MND}, {US_IMG_ORIENT_MND, US_IMG_ORIENT_MNA},
+    {US_IMG_ORIENT_UF, US_IMG_ORIENT_MN}, {US_IMG_ORIENT_MF, US_IMG_ORIENT_UN},
+    {US_IMG_ORIENT_UN, US_IMG_ORIENT_MF}, {US_IMG_ORIENT_MN, US_IMG_ORIENT_UF},
+    {US_IMG_ORIENT_FU, US_IMG_ORIENT_NM}, {US_IMG_ORIENT_NU, US_IMG_ORIENT_FM},
+    {US_IMG_ORIENT_FM, US_IMG_ORIENT_NU}, {US_IMG_ORIENT_NM, US_IMG_ORIENT_FU},
+    {US_IMG_ORIENT_UFA, US_IMG_ORIENT_MFD}, {US_IMG_ORIENT_MFD, US_IMG_ORIENT_UFA},
+    {US_IMG_ORIENT_UNA, US_IMG_ORIENT_MND}, {US_IMG_ORIENT_MND, US_IMG_ORIENT_UNA},
+    {US_IMG_ORIENT_UFA, US_IMG_ORIENT_UND}, {US_IMG_ORIENT_UND, US_IMG_ORIENT_UFA},
+    {US_IMG_ORIENT_MFA, US_IMG_ORIENT_MND}, {US_IMG_ORIENT_MND, US_IMG_ORIENT_MFA},
+    {US_IMG_ORIENT_UFA, US_IMG_ORIENT_MND}, {US_IMG_ORIENT_MND, US_IMG_ORIENT_UFA},
+    {US_IMG_ORIENT_AMF, US_IMG_ORIENT_MFA}, {US_IMG_ORIENT_MFA, US_IMG_ORIENT_AMF},
+  };
+
+  //----------------------------------------------------------------------------
+  void CreateImage(vtkImageData* image, const int dimensions[3], int scalarType, int numberOfScalarComponents)
+  {
+    image->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    image->AllocateScalars(scalarType, numberOfScalarComponents);
+    unsigned char* buffer = static_cast<unsigned char*>(image->GetScalarPointer());
+    vtkIdType numberOfBytes = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2] * numberOfScalarComponents * image->GetScalarSize();
+    for (vtkIdType i = 0; i < numberOfBytes; ++i)
+    {
+      buffer[i] = static_cast<unsigned char>((i * 7919 + i / 251) % 256);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Compare the output of FlipClipImage to the pixel by pixel computed reference
+  PlusStatus CompareToReference(vtkImageData* inputImage, const PlusVideoFrame::FlipInfoType& flipInfo, const int clipOrigin[3], const int clipSize[3], vtkImageData* outputImage)
+  {
+    int inputDimensions[3] = {0, 0, 0};
+    inputImage->GetDimensions(inputDimensions);
+    int origin[3] = {0, 0, 0};
+    int size[3] = {inputDimensions[0], inputDimensions[1], inputDimensions[2]};
+    if (PlusCommon::IsClippingRequested(clipOrigin, clipSize))
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        origin[i] = clipOrigin[i];
+        size[i] = clipSize[i];
+      }
+    }
+    int expectedDimensions[3] = {size[0], size[1], size[2]};
+    if (flipInfo.tranpose == PlusVideoFrame::TRANSPOSE_IJKtoKIJ)
+    {
+      expectedDimensions[0] = size[2];
+      expectedDimensions[1] = size[0];
+      expectedDimensions[2] = size[1];
+    }
+
+    int outputDimensions[3] = {0, 0, 0};
+    outputImage->GetDimensions(outputDimensions);
+    if (outputDimensions[0] != expectedDimensions[0] || outputDimensions[1] != expectedDimensions[1] || outputDimensions[2] != expectedDimensions[2])
+    {
+      LOG_ERROR("Output image size mismatch: [" << outputDimensions[0] << ", " << outputDimensions[1] << ", " << outputDimensions[2] << "], expected ["
+                << expectedDimensions[0] << ", " << expectedDimensions[1] << ", " << expectedDimensions[2] << "]");
+      return PLUS_FAIL;
+    }
+
+    const int bytesPerPixel = inputImage->GetScalarSize() * inputImage->GetNumberOfScalarComponents();
+    int outputExtent[6] = {0, 0, 0, 0, 0, 0};
+    outputImage->GetExtent(outputExtent);
+    for (int z = 0; z < outputDimensions[2]; ++z)
+    {
+      for (int y = 0; y < outputDimensions[1]; ++y)
+      {
+        for (int x = 0; x < outputDimensions[0]; ++x)
+        {
+          int inputPosition[3] = {0, 0, 0};
+          if (flipInfo.tranpose == PlusVideoFrame::TRANSPOSE_IJKtoKIJ)
+          {
+            inputPosition[0] = origin[0] + y;
+            inputPosition[1] = origin[1] + z;
+            inputPosition[2] = origin[2] + x;
+          }
+          else
+          {
+            inputPosition[0] = origin[0] + (flipInfo.hFlip ? size[0] - 1 - x : x);
+            inputPosition[1] = origin[1] + (flipInfo.vFlip ? size[1] - 1 - y : y);
+            inputPosition[2] = origin[2] + (flipInfo.eFlip ? size[2] - 1 - z : z);
+          }
+          if (memcmp(inputImage->GetScalarPointer(inputPosition[0], inputPosition[1], inputPosition[2]),
+                     outputImage->GetScalarPointer(outputExtent[0] + x, outputExtent[2] + y, outputExtent[4] + z), bytesPerPixel) != 0)
+          {
+            LOG_ERROR("Output pixel (" << x << ", " << y << ", " << z << ") does not match input pixel ("
+                      << inputPosition[0] << ", " << inputPosition[1] << ", " << inputPosition[2] << ")");
+            return PLUS_FAIL;
+          }
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestFlipClip(const PlusVideoFrame::FlipInfoType& flipInfo, const int dimensions[3], int scalarType, int numberOfScalarComponents, const int clipOrigin[3], const int clipSize[3])
+  {
+    vtkSmartPointer<vtkImageData> inputImage = vtkSmartPointer<vtkImageData>::New();
+    CreateImage(inputImage, dimensions, scalarType, numberOfScalarComponents);
+    vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+    if (PlusVideoFrame::FlipClipImage(inputImage, flipInfo, clipOrigin, clipSize, outputImage) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("FlipClipImage failed");
+      return PLUS_FAIL;
+    }
+    if (CompareToReference(inputImage, flipInfo, clipOrigin, clipSize, outputImage) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("FlipClipImage result is incorrect for hFlip=" << flipInfo.hFlip << ", vFlip=" << flipInfo.vFlip << ", eFlip=" << flipInfo.eFlip
+                << ", transpose=" << PlusVideoFrame::TransposeToString(flipInfo.tranpose) << ", image size=[" << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]
+                << "], scalar type=" << scalarType << ", number of components=" << numberOfScalarComponents
+                << (PlusCommon::IsClippingRequested(clipOrigin, clipSize) ? ", clipped" : ""));
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestOrientationPair(US_IMAGE_ORIENTATION inputOrientation, US_IMAGE_ORIENTATION outputOrientation)
+  {
+    PlusVideoFrame::FlipInfoType flipInfo;
+    if (PlusVideoFrame::GetFlipAxes(inputOrientation, US_IMG_BRIGHTNESS, outputOrientation, flipInfo) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get flip axes from " << PlusVideoFrame::GetStringFromUsImageOrientation(inputOrientation)
+                << " to " << PlusVideoFrame::GetStringFromUsImageOrientation(outputOrientation));
+      return PLUS_FAIL;
+    }
+
+    // Sizes are chosen so that both the vectorized and the remaining pixels of rows are processed
+    const int dimensions2D[3] = {37, 23, 1};
+    const int dimensions3D[3] = {45, 19, 7};
+    const int noClipOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    const int noClipSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    const int clipOrigin2D[3] = {3, 5, 0};
+    const int clipSize2D[3] = {29, 11, 1};
+    const int clipOrigin3D[3] = {2, 1, 2};
+    const int clipSize3D[3] = {40, 15, 4};
+    const int scalarTypes[] = {VTK_UNSIGNED_CHAR, VTK_SHORT, VTK_FLOAT, VTK_DOUBLE};
+    const int numberOfComponents[] = {1, 3};
+
+    PlusStatus status = PLUS_SUCCESS;
+    for (unsigned int typeIndex = 0; typeIndex < sizeof(scalarTypes) / sizeof(scalarTypes[0]); ++typeIndex)
+    {
+      for (unsigned int componentIndex = 0; componentIndex < sizeof(numberOfComponents) / sizeof(numberOfComponents[0]); ++componentIndex)
+      {
+        if (TestFlipClip(flipInfo, dimensions2D, scalarTypes[typeIndex], numberOfComponents[componentIndex], noClipOrigin, noClipSize) != PLUS_SUCCESS
+            || TestFlipClip(flipInfo, dimensions2D, scalarTypes[typeIndex], numberOfComponents[componentIndex], clipOrigin2D, clipSize2D) != PLUS_SUCCESS
+            || TestFlipClip(flipInfo, dimensions3D, scalarTypes[typeIndex], numberOfComponents[componentIndex], noClipOrigin, noClipSize) != PLUS_SUCCESS
+            || TestFlipClip(flipInfo, dimensions3D, scalarTypes[typeIndex], numberOfComponents[componentIndex], clipOrigin3D, clipSize3D) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Conversion from " << PlusVideoFrame::GetStringFromUsImageOrientation(inputOrientation)
+                    << " to " << PlusVideoFrame::GetStringFromUsImageOrientation(outputOrientation) << " failed");
+          status = PLUS_FAIL;
+        }
+      }
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestLargeImages()
+  {
+    // These images are large enough to be processed by multiple threads
+    const int noClipOrigin[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    const int noClipSize[3] = {PlusCommon::NO_CLIP, PlusCommon::NO_CLIP, PlusCommon::NO_CLIP};
+    const int dimensions2D[3] = {1923, 1201, 1};
+    const int dimensions3D[3] = {131, 127, 129};
+
+    PlusStatus status = PLUS_SUCCESS;
+    PlusVideoFrame::FlipInfoType flipInfo;
+    flipInfo.hFlip = true;
+    if (TestFlipClip(flipInfo, dimensions2D, VTK_UNSIGNED_CHAR, 1, noClipOrigin, noClipSize) != PLUS_SUCCESS)
+    {
+      status = PLUS_FAIL;
+    }
+    flipInfo.vFlip = true;
+    flipInfo.eFlip = true;
+    if (TestFlipClip(flipInfo, dimensions3D, VTK_UNSIGNED_SHORT, 1, noClipOrigin, noClipSize) != PLUS_SUCCESS)
+    {
+      status = PLUS_FAIL;
+    }
+    flipInfo.hFlip = false;
+    flipInfo.vFlip = false;
+    flipInfo.eFlip = false;
+    flipInfo.tranpose = PlusVideoFrame::TRANSPOSE_IJKtoKIJ;
+    if (TestFlipClip(flipInfo, dimensions3D, VTK_UNSIGNED_CHAR, 1, noClipOrigin, noClipSize) != PLUS_SUCCESS)
+    {
+      status = PLUS_FAIL;
+    }
+    return status;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfFailures = 0;
+
+  // Same orientation, only clipping
+  if (TestOrientationPair(US_IMG_ORIENT_MF, US_IMG_ORIENT_MF) != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+
+  for (unsigned int i = 0; i < sizeof(SUPPORTED_ORIENTATION_PAIRS) / sizeof(SUPPORTED_ORIENTATION_PAIRS[0]); ++i)
+  {
+    if (TestOrientationPair(SUPPORTED_ORIENTATION_PAIRS[i][0], SUPPORTED_ORIENTATION_PAIRS[i][1]) != PLUS_SUCCESS)
+    {
+      ++numberOfFailures;
+    }
+  }
+
+  if (TestLargeImages() != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("PlusVideoFrameTest failed: " << numberOfFailures << " test cases failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("PlusVideoFrameTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusColumnarTrackedFrameListTest.cxx
+  \brief Test that vtkPlusColumnarTrackedFrameList columns match the contents of the source tracked frame list
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSyntheticSequence.h"
+
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtkMatrix4x4.h"
+
+#include "PlusTrackedFrame.h"
+#include "vtkPlusColumnarTrackedFrameList.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+  const double TOLERANCE = 1e-9;
+
+  //----------------------------------------------------------------------------
+  // Frame i of the synthetic sequence, ProbeToTracker translation (i, 2i, 0), ProbeToTracker is invalid in every 5th frame,
+  // StylusToTracker is only present in even frames
+  void CreateTrackedFrameList(vtkPlusTrackedFrameList* trackedFrameList, int numberOfFrames)
+  {
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      PlusTrackedFrame trackedFrame;
+      PlusSyntheticSequence::CreateFrame(trackedFrame, i);
+
+      vtkSmartPointer<vtkMatrix4x4> probeToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+      probeToTracker->SetElement(0, 3, i);
+      probeToTracker->SetElement(1, 3, 2 * i);
+      trackedFrame.SetCustomFrameTransform(PlusTransformName("Probe", "Tracker"), probeToTracker);
+      trackedFrame.SetCustomFrameTransformStatus(PlusTransformName("Probe", "Tracker"), (i % 5 == 0) ? FIELD_INVALID : FIELD_OK);
+
+      if (i % 2 == 0)
+      {
+        vtkSmartPointer<vtkMatrix4x4> stylusToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+        stylusToTracker->SetElement(2, 3, -i);
+        trackedFrame.SetCustomFrameTransform(PlusTransformName("Stylus", "Tracker"), stylusToTracker);
+        trackedFrame.SetCustomFrameTransformStatus(PlusTransformName("Stylus", "Tracker"), FIELD_OK);
+      }
+
+      trackedFrameList->AddTrackedFrame(&trackedFrame);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestColumns(int numberOfFrames)
+  {
+    vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    CreateTrackedFrameList(trackedFrameList, numberOfFrames);
+
+    vtkSmartPointer<vtkPlusColumnarTrackedFrameList> columns = vtkSmartPointer<vtkPlusColumnarTrackedFrameList>::New();
+    if (columns->BuildFromTrackedFrameList(trackedFrameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to build columns");
+      return PLUS_FAIL;
+    }
+    if (columns->GetNumberOfFrames() != numberOfFrames || columns->GetNumberOfTransformColumns() != 2)
+    {
+      LOG_ERROR("Unexpected number of frames (" << columns->GetNumberOfFrames() << ") or transform columns (" << columns->GetNumberOfTransformColumns() << ")");
+      return PLUS_FAIL;
+    }
+
+    const int probeColumn = columns->GetTransformColumnIndex(PlusTransformName("Probe", "Tracker"));
+    const int stylusColumn = columns->GetTransformColumnIndex(PlusTransformName("Stylus", "Tracker"));
+    if (probeColumn < 0 || stylusColumn < 0 || columns->GetTransformColumnIndex(PlusTransformName("Image", "Probe")) >= 0)
+    {
+      LOG_ERROR("Invalid transform column indices");
+      return PLUS_FAIL;
+    }
+
+    const double* timestamps = columns->GetTimestamps();
+    const unsigned int* frameSizes = columns->GetFrameSizes();
+    const double* probeMatrices = columns->GetTransformMatrices(probeColumn);
+    const unsigned char* probeValid = columns->GetTransformValidFlags(probeColumn);
+    const double* stylusMatrices = columns->GetTransformMatrices(stylusColumn);
+    const unsigned char* stylusValid = columns->GetTransformValidFlags(stylusColumn);
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      if (fabs(timestamps[i] - 0.1 * i) > TOLERANCE || frameSizes[3 * i] != 8 || frameSizes[3 * i + 1] != 6 || frameSizes[3 * i + 2] != 1)
+      {
+        LOG_ERROR("Timestamp or frame size mismatch in frame " << i);
+        return PLUS_FAIL;
+      }
+      if (fabs(probeMatrices[16 * i + 3] - i) > TOLERANCE || fabs(probeMatrices[16 * i + 7] - 2 * i) > TOLERANCE || fabs(probeMatrices[16 * i + 15] - 1) > TOLERANCE
+          || probeValid[i] != ((i % 5 == 0) ? 0 : 1))
+      {
+        LOG_ERROR("ProbeToTracker transform mismatch in frame " << i);
+        return PLUS_FAIL;
+      }
+      bool stylusPresent = (i % 2 == 0);
+      if (stylusValid[i] != (stylusPresent ? 1 : 0) || fabs(stylusMatrices[16 * i + 11] - (stylusPresent ? -i : 0)) > TOLERANCE || fabs(stylusMatrices[16 * i]  - 1) > TOLERANCE)
+      {
+        LOG_ERROR("StylusToTracker transform mismatch in frame " << i);
+        return PLUS_FAIL;
+      }
+    }
+
+    // Pixel data
+    if (!columns->HasPixelData() || columns->GetFrameSizeInBytes() != 8 * 6 || columns->GetPixelType() != VTK_UNSIGNED_CHAR || columns->GetNumberOfScalarComponents() != 1)
+    {
+      LOG_ERROR("Pixel data is not stored correctly");
+      return PLUS_FAIL;
+    }
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      const unsigned char* framePixels = static_cast<const unsigned char*>(columns->GetFramePixelData(i));
+      if (framePixels != static_cast<const unsigned char*>(columns->GetPixelData()) + i * 8 * 6 || framePixels[0] != (unsigned char)i || framePixels[8 * 6 - 1] != (unsigned char)i)
+      {
+        LOG_ERROR("Pixel data mismatch in frame " << i);
+        return PLUS_FAIL;
+      }
+    }
+
+    // Computed transform column
+    vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+    vtkSmartPointer<vtkMatrix4x4> imageToProbe = vtkSmartPointer<vtkMatrix4x4>::New();
+    imageToProbe->SetElement(0, 0, 0.2);
+    imageToProbe->SetElement(1, 1, 0.2);
+    imageToProbe->SetElement(2, 3, 5.0);
+    transformRepository->SetTransform(PlusTransformName("Image", "Probe"), imageToProbe);
+    transformRepository->SetTransformPersistent(PlusTransformName("Image", "Probe"), true);
+    if (columns->AddComputedTransformColumn(PlusTransformName("Image", "Tracker"), transformRepository) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add computed transform column");
+      return PLUS_FAIL;
+    }
+    const int imageColumn = columns->GetTransformColumnIndex(PlusTransformName("Image", "Tracker"));
+    const double* imageMatrices = columns->GetTransformMatrices(imageColumn);
+    const unsigned char* imageValid = columns->GetTransformValidFlags(imageColumn);
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      // ImageToTracker = ProbeToTracker * ImageToProbe
+      const double expected[16] = {0.2, 0, 0, static_cast<double>(i), 0, 0.2, 0, 2.0 * i, 0, 0, 1, 5.0, 0, 0, 0, 1};
+      for (int element = 0; element < 16; ++element)
+      {
+        if (fabs(imageMatrices[16 * i + element] - expected[element]) > TOLERANCE)
+        {
+          LOG_ERROR("ImageToTracker transform mismatch in frame " << i << " element " << element << ": " << imageMatrices[16 * i + element] << " (expected " << expected[element] << ")");
+          return PLUS_FAIL;
+        }
+      }
+      if (imageValid[i] != probeValid[i])
+      {
+        LOG_ERROR("ImageToTracker transform validity mismatch in frame " << i);
+        return PLUS_FAIL;
+      }
+    }
+
+    // Frames of different size cannot be stored in a single pixel buffer
+    PlusTrackedFrame differentSizeFrame;
+    const int differentFrameSize[3] = {4, 4, 1};
+    differentSizeFrame.GetImageData()->AllocateFrame(differentFrameSize, VTK_UNSIGNED_CHAR, 1);
+    differentSizeFrame.SetTimestamp(1000.0);
+    trackedFrameList->AddTrackedFrame(&differentSizeFrame);
+    int verboseLevel = vtkPlusLogger::Instance()->GetLogLevel();
+    vtkPlusLogger::Instance()->SetLogLevel(vtkPlusLogger::LOG_LEVEL_ERROR); // expected warning
+    columns->BuildFromTrackedFrameList(trackedFrameList);
+    vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+    if (columns->HasPixelData() || columns->GetNumberOfFrames() != numberOfFrames + 1 || columns->GetFrameSizes()[3 * numberOfFrames] != 4)
+    {
+      LOG_ERROR("Frames with different sizes are not handled correctly");
+      return PLUS_FAIL;
+    }
+
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestColumns(50) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusColumnarTrackedFrameListTest failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusColumnarTrackedFrameListTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,299 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusFrameMemoryPoolTest.cxx
+  \brief Test reuse of pixel buffers by vtkPlusFrameMemoryPool and compare frame copy throughput with and without the pool
+*/
+
+#include "PlusConfigure.h"
+
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkPointData.h"
+
+#include "PlusVideoFrame.h"
+#include "vtkPlusFrameMemoryPool.h"
+
+#include <string.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  PlusStatus TestSizeClasses()
+  {
+    const size_t sizes[] = {1, 63, 64, 65, 256, 257, 1000, 4096, 4097, 640 * 480, 1920 * 1080 * 3, 3840 * 2160 * 3};
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+      size_t sizeClassBytes = vtkPlusFrameMemoryPool::GetSizeClassBytes(sizes[i]);
+      if (sizeClassBytes < sizes[i] || sizeClassBytes > sizes[i] + sizes[i] / 4 + 64)
+      {
+        LOG_ERROR("Invalid size class for " << sizes[i] << " bytes: " << sizeClassBytes);
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestBufferReuse()
+  {
+    vtkSmartPointer<vtkPlusFrameMemoryPool> pool = vtkSmartPointer<vtkPlusFrameMemoryPool>::New();
+
+    void* buffer = pool->AcquireBuffer(100000);
+    if (buffer == NULL || reinterpret_cast<size_t>(buffer) % 4096 != 0)
+    {
+      LOG_ERROR("Large buffers must be page aligned");
+      return PLUS_FAIL;
+    }
+    memset(buffer, 1, 100000);
+    void* smallBuffer = pool->AcquireBuffer(100);
+    if (smallBuffer == NULL || reinterpret_cast<size_t>(smallBuffer) % 64 != 0)
+    {
+      LOG_ERROR("Small buffers must be cache line aligned");
+      return PLUS_FAIL;
+    }
+    vtkPlusFrameMemoryPool::ReleaseBuffer(smallBuffer);
+    vtkPlusFrameMemoryPool::ReleaseBuffer(buffer);
+    if (pool->GetNumberOfBuffersInUse() != 0 || pool->GetNumberOfHeapAllocations() != 2)
+    {
+      LOG_ERROR("Unexpected pool state after releasing the buffers: " << pool->GetNumberOfBuffersInUse() << " buffers in use, "
+                << pool->GetNumberOfHeapAllocations() << " heap allocations");
+      return PLUS_FAIL;
+    }
+
+    // A buffer of the same size class is served from the pool
+    void* reusedBuffer = pool->AcquireBuffer(99000);
+    if (reusedBuffer != buffer || pool->GetNumberOfReusedBuffers() != 1 || pool->GetNumberOfHeapAllocations() != 2)
+    {
+      LOG_ERROR("Released buffer was not reused");
+      return PLUS_FAIL;
+    }
+    vtkPlusFrameMemoryPool::ReleaseBuffer(reusedBuffer);
+
+    // Buffers that do not fit in the cache are freed
+    pool->SetMaximumCachedSizeBytes(0);
+    if (pool->GetCachedSizeBytes() != 0)
+    {
+      LOG_ERROR("Cached buffers were not released");
+      return PLUS_FAIL;
+    }
+    pool->ResetCounters();
+    vtkPlusFrameMemoryPool::ReleaseBuffer(pool->AcquireBuffer(100000));
+    if (pool->GetCachedSizeBytes() != 0 || pool->GetNumberOfHeapAllocations() != 1)
+    {
+      LOG_ERROR("Buffer was cached above the maximum cached size");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestPooledFrames()
+  {
+    vtkSmartPointer<vtkPlusFrameMemoryPool> pool = vtkSmartPointer<vtkPlusFrameMemoryPool>::New();
+    const int frameSize[3] = {640, 480, 1};
+
+    PlusVideoFrame frame;
+    frame.SetFrameMemoryPool(pool);
+    if (frame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 3) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate pooled frame");
+      return PLUS_FAIL;
+    }
+    memset(frame.GetScalarPointer(), 7, frame.GetFrameSizeInBytes());
+
+    if (!vtkPlusFrameMemoryPool::IsPooledImageAllocationSupported())
+    {
+      LOG_INFO("Pooled image allocation is not supported with this VTK version, frames are allocated by VTK");
+      return PLUS_SUCCESS;
+    }
+
+    if (reinterpret_cast<size_t>(frame.GetScalarPointer()) % 4096 != 0 || pool->GetNumberOfBuffersInUse() != 1)
+    {
+      LOG_ERROR("Frame pixel buffer is not allocated from the pool");
+      return PLUS_FAIL;
+    }
+
+    // Copies are allocated from the pool of the source frame and return their buffer when deleted
+    {
+      PlusVideoFrame frameCopy(frame);
+      if (frameCopy.GetFrameMemoryPool() != pool.GetPointer() || pool->GetNumberOfBuffersInUse() != 2
+          || memcmp(frameCopy.GetScalarPointer(), frame.GetScalarPointer(), frame.GetFrameSizeInBytes()) != 0)
+      {
+        LOG_ERROR("Frame copy is not allocated from the pool of the source frame");
+        return PLUS_FAIL;
+      }
+    }
+
+    // No heap allocations in steady state
+    pool->ResetCounters();
+    const int numberOfCopies = 100;
+    for (int i = 0; i < numberOfCopies; ++i)
+    {
+      PlusVideoFrame frameCopy;
+      frameCopy = frame;
+    }
+    if (pool->GetNumberOfHeapAllocations() != 0 || pool->GetNumberOfReusedBuffers() != numberOfCopies || pool->GetNumberOfBuffersInUse() != 1)
+    {
+      LOG_ERROR("Frame copies were not served from the pool: " << pool->GetNumberOfHeapAllocations() << " heap allocations, "
+                << pool->GetNumberOfReusedBuffers() << " reused buffers");
+      return PLUS_FAIL;
+    }
+
+    // Shallow copies of the image keep the pixel buffer alive
+    vtkSmartPointer<vtkImageData> shallowCopy = vtkSmartPointer<vtkImageData>::New();
+    {
+      PlusVideoFrame frameCopy(frame);
+      shallowCopy->ShallowCopy(frameCopy.GetImage());
+    }
+    if (pool->GetNumberOfBuffersInUse() != 2 || static_cast<unsigned char*>(shallowCopy->GetScalarPointer())[1000] != 7)
+    {
+      LOG_ERROR("Pixel buffer of a shallow copied image was released");
+      return PLUS_FAIL;
+    }
+    shallowCopy = NULL;
+    if (pool->GetNumberOfBuffersInUse() != 1)
+    {
+      LOG_ERROR("Pixel buffer was not returned to the pool");
+      return PLUS_FAIL;
+    }
+
+    // Scalars are reused only if they are not shared with a shallow copy
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, frameSize[0] - 1, 0, frameSize[1] - 1, 0, 0);
+    if (pool->AllocateScalars(image, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate pooled image scalars");
+      return PLUS_FAIL;
+    }
+    vtkDataArray* unsharedScalars = image->GetPointData()->GetScalars();
+    if (pool->AllocateScalars(image, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS || image->GetPointData()->GetScalars() != unsharedScalars)
+    {
+      LOG_ERROR("Unshared image scalars with matching size were not reused");
+      return PLUS_FAIL;
+    }
+    memset(image->GetScalarPointer(), 3, frameSize[0] * frameSize[1]);
+    shallowCopy = vtkSmartPointer<vtkImageData>::New();
+    shallowCopy->ShallowCopy(image);
+    if (pool->AllocateScalars(image, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS
+        || image->GetPointData()->GetScalars() == shallowCopy->GetPointData()->GetScalars())
+    {
+      LOG_ERROR("Image scalars shared with a shallow copy were reused");
+      return PLUS_FAIL;
+    }
+    memset(image->GetScalarPointer(), 5, frameSize[0] * frameSize[1]);
+    if (static_cast<unsigned char*>(shallowCopy->GetScalarPointer())[1000] != 3)
+    {
+      LOG_ERROR("Pixels of a shallow copy were overwritten by allocating the scalars of the source image");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  double MeasureFrameCopyRate(PlusVideoFrame& sourceFrame, int numberOfCopies)
+  {
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfCopies; ++i)
+    {
+      PlusVideoFrame frameCopy(sourceFrame);
+    }
+    double elapsedTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+    return elapsedTimeSec > 0 ? numberOfCopies / elapsedTimeSec : 0.0;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus BenchmarkFrameCopies()
+  {
+    const int frameSize[3] = {3840, 2160, 1};
+    const int numberOfCopies = 50;
+
+    PlusVideoFrame unpooledFrame;
+    if (unpooledFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 3) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate 4K RGB frame");
+      return PLUS_FAIL;
+    }
+    unpooledFrame.FillBlank();
+
+    vtkSmartPointer<vtkPlusFrameMemoryPool> pool = vtkSmartPointer<vtkPlusFrameMemoryPool>::New();
+    PlusVideoFrame pooledFrame;
+    pooledFrame.SetFrameMemoryPool(pool);
+    if (pooledFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 3) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate pooled 4K RGB frame");
+      return PLUS_FAIL;
+    }
+    pooledFrame.FillBlank();
+
+    double unpooledFramesPerSec = MeasureFrameCopyRate(unpooledFrame, numberOfCopies);
+    pool->ResetCounters();
+    double pooledFramesPerSec = MeasureFrameCopyRate(pooledFrame, numberOfCopies);
+
+    LOG_INFO("4K RGB frame copies: " << unpooledFramesPerSec << " frames/sec without pool, " << pooledFramesPerSec << " frames/sec with pool ("
+             << pool->GetNumberOfHeapAllocations() << " heap allocations, " << pool->GetNumberOfReusedBuffers() << " reused buffers)");
+
+    if (vtkPlusFrameMemoryPool::IsPooledImageAllocationSupported() && pool->GetNumberOfHeapAllocations() > 1)
+    {
+      LOG_ERROR("Pooled frame copies allocated memory from the heap " << pool->GetNumberOfHeapAllocations() << " times");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestSizeClasses() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Size class test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestBufferReuse() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Buffer reuse test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestPooledFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Pooled frame test failed");
+    return EXIT_FAILURE;
+  }
+  if (BenchmarkFrameCopies() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Frame copy benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusFrameMemoryPoolTest completed successfully");
+  return EXIT_SUCCESS;
+}
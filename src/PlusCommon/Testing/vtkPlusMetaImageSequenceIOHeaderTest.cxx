@@ -0,0 +1,293 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusMetaImageSequenceIOHeaderTest.cxx
+  \brief Test that sequence headers loaded from the header index file match the parsed text header, and measure header reading time
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSyntheticSequence.h"
+
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+#include "vtkMatrix4x4.h"
+
+#include "PlusTrackedFrame.h"
+#include "vtkPlusMetaImageSequenceIO.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+
+#include <fstream>
+#include <iterator>
+#include <string.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  PlusStatus ReadSequence(const std::string& fileName, vtkPlusTrackedFrameList* trackedFrameList, bool useHeaderIndexFile, bool expectLoadedFromIndex, double& readTimeSec)
+  {
+    vtkSmartPointer<vtkPlusMetaImageSequenceIO> reader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
+    reader->SetFileName(fileName);
+    reader->SetTrackedFrameList(trackedFrameList);
+    reader->SetUseHeaderIndexFile(useHeaderIndexFile);
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    if (reader->Read() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read sequence file " << fileName);
+      return PLUS_FAIL;
+    }
+    readTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+    if (reader->GetHeaderLoadedFromIndexFile() != expectLoadedFromIndex)
+    {
+      LOG_ERROR("Header of " << fileName << " is " << (reader->GetHeaderLoadedFromIndexFile() ? "" : "not ") << "loaded from the index file, the opposite was expected");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CompareTrackedFrameLists(vtkPlusTrackedFrameList* expected, vtkPlusTrackedFrameList* actual)
+  {
+    if (expected->GetNumberOfTrackedFrames() != actual->GetNumberOfTrackedFrames())
+    {
+      LOG_ERROR("Number of frames mismatch: expected " << expected->GetNumberOfTrackedFrames() << ", actual " << actual->GetNumberOfTrackedFrames());
+      return PLUS_FAIL;
+    }
+
+    std::vector<std::string> fieldNames;
+    expected->GetCustomFieldNameList(fieldNames);
+    for (std::vector<std::string>::iterator fieldNameIt = fieldNames.begin(); fieldNameIt != fieldNames.end(); ++fieldNameIt)
+    {
+      if (expected->GetCustomString(*fieldNameIt) != actual->GetCustomString(*fieldNameIt))
+      {
+        LOG_ERROR("Field " << *fieldNameIt << " mismatch: expected " << expected->GetCustomString(*fieldNameIt) << ", actual " << actual->GetCustomString(*fieldNameIt));
+        return PLUS_FAIL;
+      }
+    }
+
+    for (unsigned int i = 0; i < expected->GetNumberOfTrackedFrames(); ++i)
+    {
+      PlusTrackedFrame* expectedFrame = expected->GetTrackedFrame(i);
+      PlusTrackedFrame* actualFrame = actual->GetTrackedFrame(i);
+      if (expectedFrame->GetTimestamp() != actualFrame->GetTimestamp())
+      {
+        LOG_ERROR("Frame " << i << " timestamp mismatch: expected " << expectedFrame->GetTimestamp() << ", actual " << actualFrame->GetTimestamp());
+        return PLUS_FAIL;
+      }
+      if (expectedFrame->GetCustomFields() != actualFrame->GetCustomFields())
+      {
+        LOG_ERROR("Frame " << i << " fields mismatch");
+        return PLUS_FAIL;
+      }
+      unsigned long frameSizeInBytes = expectedFrame->GetImageData()->GetFrameSizeInBytes();
+      if (actualFrame->GetImageData()->GetFrameSizeInBytes() != frameSizeInBytes
+          || memcmp(expectedFrame->GetImageData()->GetScalarPointer(), actualFrame->GetImageData()->GetScalarPointer(), frameSizeInBytes) != 0)
+      {
+        LOG_ERROR("Frame " << i << " pixel data mismatch");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Change the first character of the frame 1 timestamp value in the header without changing the file size
+  PlusStatus ChangeHeaderInPlace(const std::string& fileName)
+  {
+    std::string content;
+    {
+      std::ifstream inputFile(fileName.c_str(), std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+    }
+    const std::string timestampFieldPrefix = "Seq_Frame0001_Timestamp = ";
+    size_t valuePosition = content.find(timestampFieldPrefix);
+    if (valuePosition == std::string::npos)
+    {
+      LOG_ERROR("Frame 1 timestamp is not found in " << fileName);
+      return PLUS_FAIL;
+    }
+    valuePosition += timestampFieldPrefix.size();
+    content[valuePosition] = (content[valuePosition] == '5' ? '6' : '5');
+    std::ofstream outputFile(fileName.c_str(), std::ios::binary | std::ios::trunc);
+    outputFile.write(content.data(), content.size());
+    return outputFile.good() ? PLUS_SUCCESS : PLUS_FAIL;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Replace the number of sequence fields in the header index file by a count that does not fit in the file */
+  PlusStatus CorruptHeaderIndexFieldCount(const std::string& indexFileName)
+  {
+    // Signature, version, byte order mark, header file size, header size, header checksum and pixel data offset
+    const std::streamoff pixelDataFileNameOffset = 8 + 4 + 4 + 8 + 8 + 4 + 8;
+    std::fstream indexFile(indexFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    vtkTypeUInt32 pixelDataFileNameLength = 0;
+    indexFile.seekg(pixelDataFileNameOffset);
+    indexFile.read(reinterpret_cast<char*>(&pixelDataFileNameLength), sizeof(pixelDataFileNameLength));
+    const vtkTypeUInt32 numberOfFields = 0xFFFFFFFF;
+    indexFile.seekp(pixelDataFileNameOffset + sizeof(pixelDataFileNameLength) + pixelDataFileNameLength);
+    indexFile.write(reinterpret_cast<const char*>(&numberOfFields), sizeof(numberOfFields));
+    if (!indexFile.good())
+    {
+      LOG_ERROR("Failed to modify header index file " << indexFileName);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestHeaderIndex(const std::string& fileName, int numberOfFrames, int numberOfTools)
+  {
+    std::string indexFileName = fileName + ".plusidx";
+    vtksys::SystemTools::RemoveFile(indexFileName.c_str());
+    if (PlusSyntheticSequence::WriteSequenceFile(fileName, numberOfFrames, 0.1, numberOfTools) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Parse the text header without the index
+    vtkSmartPointer<vtkPlusTrackedFrameList> parsedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double parseTimeSec = 0;
+    if (ReadSequence(fileName, parsedFrameList, false, false, parseTimeSec) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (parsedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Number of frames mismatch: expected " << numberOfFrames << ", actual " << parsedFrameList->GetNumberOfTrackedFrames());
+      return PLUS_FAIL;
+    }
+    if (vtksys::SystemTools::FileExists(indexFileName.c_str(), true))
+    {
+      LOG_ERROR("Header index file is created, but it was not requested");
+      return PLUS_FAIL;
+    }
+
+    // First read with index enabled parses the text header and creates the index
+    vtkSmartPointer<vtkPlusTrackedFrameList> indexCreatedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double indexCreateTimeSec = 0;
+    if (ReadSequence(fileName, indexCreatedFrameList, true, false, indexCreateTimeSec) != PLUS_SUCCESS
+        || CompareTrackedFrameLists(parsedFrameList, indexCreatedFrameList) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (!vtksys::SystemTools::FileExists(indexFileName.c_str(), true))
+    {
+      LOG_ERROR("Header index file is not created: " << indexFileName);
+      return PLUS_FAIL;
+    }
+
+    // Second read loads the fields from the index
+    vtkSmartPointer<vtkPlusTrackedFrameList> indexLoadedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double indexLoadTimeSec = 0;
+    if (ReadSequence(fileName, indexLoadedFrameList, true, true, indexLoadTimeSec) != PLUS_SUCCESS
+        || CompareTrackedFrameLists(parsedFrameList, indexLoadedFrameList) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    LOG_INFO("Reading " << numberOfFrames << " frames with " << numberOfTools << " tools: text header " << parseTimeSec * 1000.0 << "ms"
+             << ", text header and index creation " << indexCreateTimeSec * 1000.0 << "ms, index " << indexLoadTimeSec * 1000.0 << "ms");
+
+    // Index must be rejected after the header is changed, even if the file size is the same and
+    // the modification time is within the same second (the index is not updated in this read)
+    if (ChangeHeaderInPlace(fileName) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkPlusTrackedFrameList> editedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double editedReadTimeSec = 0;
+    if (ReadSequence(fileName, editedFrameList, true, false, editedReadTimeSec) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (editedFrameList->GetNumberOfTrackedFrames() < 2
+        || editedFrameList->GetTrackedFrame(1)->GetTimestamp() == parsedFrameList->GetTrackedFrame(1)->GetTimestamp())
+    {
+      LOG_ERROR("Outdated header index file was used after the header was changed in place");
+      return PLUS_FAIL;
+    }
+
+    // Index must be rejected after the sequence file is changed
+    if (PlusSyntheticSequence::WriteSequenceFile(fileName, numberOfFrames + 1, 0.1, numberOfTools) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkPlusTrackedFrameList> changedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double changedReadTimeSec = 0;
+    if (ReadSequence(fileName, changedFrameList, true, false, changedReadTimeSec) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (changedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames + 1))
+    {
+      LOG_ERROR("Outdated header index file was used: expected " << numberOfFrames + 1 << " frames, actual " << changedFrameList->GetNumberOfTrackedFrames());
+      return PLUS_FAIL;
+    }
+
+    // Index with an entry count that does not fit in the file must be rejected without allocating the entries
+    if (CorruptHeaderIndexFieldCount(indexFileName) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkPlusTrackedFrameList> corruptedIndexFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    double corruptedIndexReadTimeSec = 0;
+    if (ReadSequence(fileName, corruptedIndexFrameList, true, false, corruptedIndexReadTimeSec) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (corruptedIndexFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames + 1))
+    {
+      LOG_ERROR("Sequence read with a corrupted header index file has " << corruptedIndexFrameList->GetNumberOfTrackedFrames() << " frames, expected " << numberOfFrames + 1);
+      return PLUS_FAIL;
+    }
+
+    vtksys::SystemTools::RemoveFile(indexFileName.c_str());
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+  int numberOfFrames(500);
+  int numberOfTools(20);
+  std::string outputSequenceFileName("MetaImageSequenceIOHeaderTestOutput.mha");
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--number-of-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames in the generated sequence. Use a large value (e.g., 50000) for benchmarking.");
+  args.AddArgument("--number-of-tools", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfTools, "Number of tool transforms in each frame.");
+  args.AddArgument("--output-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputSequenceFileName, "Filename of the generated sequence.");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestHeaderIndex(outputSequenceFileName, numberOfFrames, numberOfTools) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusMetaImageSequenceIOHeaderTest failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusMetaImageSequenceIOHeaderTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,289 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusTrackedFrameListTest.cxx
+  \brief Test frame validation in vtkPlusTrackedFrameList and measure the time needed for appending validated frames
+*/
+
+#include "PlusConfigure.h"
+
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtkMatrix4x4.h"
+
+#include "PlusSyntheticSequence.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusSequenceIOBase.h"
+#include "vtkPlusTrackedFrameList.h"
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  void CreateTrackedFrame(PlusTrackedFrame& trackedFrame, const PlusTransformName& transformName, double timestamp, double positionMm)
+  {
+    trackedFrame.SetTimestamp(timestamp);
+
+    vtkSmartPointer<vtkMatrix4x4> probeToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+    probeToTracker->SetElement(0, 3, positionMm);
+    trackedFrame.SetCustomFrameTransform(transformName, probeToTracker);
+    trackedFrame.SetCustomFrameTransformStatus(transformName, FIELD_OK);
+
+    std::ostringstream probePosition;
+    probePosition << positionMm;
+    trackedFrame.SetCustomFrameField("ProbePosition", probePosition.str());
+    trackedFrame.SetCustomFrameField("ProbeRotation", "0");
+    trackedFrame.SetCustomFrameField("TemplatePosition", "0");
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestAppendPerformance(int numberOfFrames)
+  {
+    PlusTransformName transformName("Probe", "Tracker");
+
+    vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP | REQUIRE_TRACKING_OK | REQUIRE_CHANGED_ENCODER_POSITION
+        | REQUIRE_SPEED_BELOW_THRESHOLD | REQUIRE_CHANGED_TRANSFORM);
+    trackedFrameList->SetFrameTransformNameForValidation(transformName);
+    trackedFrameList->SetMinRequiredTranslationDifferenceMm(0.5);
+    trackedFrameList->SetMinRequiredAngleDifferenceDeg(0.5);
+    trackedFrameList->SetMaxAllowedTranslationSpeedMmPerSec(1000.0);
+    trackedFrameList->SetMaxAllowedRotationSpeedDegPerSec(1000.0);
+
+    // Frames are acquired at 100fps, moving 1mm between frames
+    const double frameIntervalSec = 0.01;
+    double startTime = vtkPlusAccurateTimer::GetSystemTime();
+    PlusTrackedFrame trackedFrame;
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      CreateTrackedFrame(trackedFrame, transformName, i * frameIntervalSec, i);
+      if (trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME_AND_REPORT_ERROR) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Valid frame " << i << " was rejected");
+        return PLUS_FAIL;
+      }
+    }
+    double appendTimeSec = vtkPlusAccurateTimer::GetSystemTime() - startTime;
+    LOG_INFO("Appended " << numberOfFrames << " validated frames in " << appendTimeSec << " sec (" << appendTimeSec / numberOfFrames * 1e6 << " usec/frame)");
+
+    if (trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Number of frames in the list is " << trackedFrameList->GetNumberOfTrackedFrames() << ", expected " << numberOfFrames);
+      return PLUS_FAIL;
+    }
+
+    // A frame that is too close to the last one must be rejected
+    CreateTrackedFrame(trackedFrame, transformName, numberOfFrames * frameIntervalSec, numberOfFrames - 1 + 0.1);
+    if (trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS
+        || trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Frame with unchanged transform was not rejected");
+      return PLUS_FAIL;
+    }
+
+    // A frame that moves too fast must be rejected
+    CreateTrackedFrame(trackedFrame, transformName, numberOfFrames * frameIntervalSec, numberOfFrames + 100);
+    if (trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS
+        || trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Frame with too high speed was not rejected");
+      return PLUS_FAIL;
+    }
+
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestTimestampValidation()
+  {
+    vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+
+    PlusTrackedFrame trackedFrame;
+    for (int i = 0; i < 10; ++i)
+    {
+      trackedFrame.SetTimestamp(i);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+
+    // Duplicate timestamp
+    trackedFrame.SetTimestamp(5);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 10)
+    {
+      LOG_ERROR("Frame with duplicate timestamp was not rejected");
+      return PLUS_FAIL;
+    }
+
+    // Removed timestamp can be added again
+    trackedFrameList->RemoveTrackedFrame(5);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 10)
+    {
+      LOG_ERROR("Frame with timestamp of a removed frame was rejected");
+      return PLUS_FAIL;
+    }
+
+    // Timestamp of a frame that is modified in the list
+    trackedFrameList->GetTrackedFrame(0)->SetTimestamp(100);
+    trackedFrameList->Modified();
+    trackedFrame.SetTimestamp(100);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 10)
+    {
+      LOG_ERROR("Frame with timestamp of a modified frame was not rejected");
+      return PLUS_FAIL;
+    }
+    trackedFrame.SetTimestamp(0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 11)
+    {
+      LOG_ERROR("Frame with original timestamp of a modified frame was rejected");
+      return PLUS_FAIL;
+    }
+
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Append frames with unique timestamp validation to a list that was read from a file. The sequence
+    has no frame at timestamp 0, so the append fails if the list still has the placeholder timestamps
+    of the frames that were created while reading.
+  */
+  PlusStatus TestValidatedAppendAfterRead(vtkPlusTrackedFrameList* trackedFrameList, const std::string& description)
+  {
+    const unsigned int numberOfFramesInFile = trackedFrameList->GetNumberOfTrackedFrames();
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+
+    PlusTrackedFrame trackedFrame;
+    PlusSyntheticSequence::CreateFrame(trackedFrame, 5);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != numberOfFramesInFile)
+    {
+      LOG_ERROR("Frame with duplicate timestamp was not rejected after " << description);
+      return PLUS_FAIL;
+    }
+
+    PlusSyntheticSequence::CreateFrame(trackedFrame, 0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkPlusTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != numberOfFramesInFile + 1)
+    {
+      LOG_ERROR("Frame with unique timestamp was rejected after " << description);
+      return PLUS_FAIL;
+    }
+
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestTimestampValidationAfterRead(const std::string& fileName)
+  {
+    const int numberOfFrames = 10;
+
+    // Frames at 0.1 ... 1.0 sec
+    vtkSmartPointer<vtkPlusTrackedFrameList> writtenFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    PlusSyntheticSequence::CreateFrameList(writtenFrameList, numberOfFrames + 1);
+    writtenFrameList->RemoveTrackedFrame(0);
+    if (vtkPlusSequenceIO::Write(fileName, writtenFrameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write sequence file " << fileName);
+      return PLUS_FAIL;
+    }
+
+    // The header index is created by the first read and loaded by the second
+    const char* readDescriptions[3] = { "reading the file", "reading the file and creating the header index", "reading the file using the header index" };
+    for (int readIndex = 0; readIndex < 3; ++readIndex)
+    {
+      vtkSmartPointer<vtkPlusTrackedFrameList> readFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+      if (vtkPlusSequenceIO::Read(fileName, readFrameList, readIndex > 0) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to read sequence file " << fileName);
+        return PLUS_FAIL;
+      }
+      if (TestValidatedAppendAfterRead(readFrameList, readDescriptions[readIndex]) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+
+    vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(fileName));
+    if (reader.GetPointer() == NULL || reader->SetFileName(fileName) != PLUS_SUCCESS || reader->OpenForStreamedRead() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open sequence file " << fileName << " for streamed reading");
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkPlusTrackedFrameList> streamedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    unsigned int numberOfFramesRead = 0;
+    do
+    {
+      if (reader->ReadNextFrames(streamedFrameList, 3, numberOfFramesRead) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to read frames from sequence file " << fileName);
+        reader->CloseStreamedRead();
+        return PLUS_FAIL;
+      }
+    }
+    while (numberOfFramesRead > 0);
+    reader->CloseStreamedRead();
+
+    return TestValidatedAppendAfterRead(streamedFrameList, "streamed reading of the file");
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfFrames(100000);
+  std::string outputSequenceFileName("TrackedFrameListTestOutput.mha");
+  int verboseLevel(vtkPlusLogger::LOG_LEVEL_UNDEFINED);
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-frames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames appended in the performance test (default: 100000)");
+  args.AddArgument("--output-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputSequenceFileName, "Filename of the sequence that is generated for testing validation of frames read from file.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfFailures = 0;
+  if (TestTimestampValidation() != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+  if (TestTimestampValidationAfterRead(outputSequenceFileName) != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+  if (TestAppendPerformance(numberOfFrames) != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("vtkPlusTrackedFrameListTest failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusTrackedFrameListTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -8,6 +8,7 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusMetaImageSequenceIO.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtkPlusTransformRepository.h"
@@ -15,12 +16,29 @@ See License.txt for details.
 // VTK includes
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
 #include <vtkXMLDataElement.h>
 #include <vtkXMLUtilities.h>
 #include <vtksys/CommandLineArguments.hxx>
 #include <vtksys/RegularExpression.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <algorithm>
+#include <functional>
+
+// OS includes (peak memory usage)
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 enum OperationType
 {
@@ -51,6 +69,7 @@ public:
     FrameScalarDecimalDigits = 5;
     FrameTransformStart = NULL;
     FrameTransformIncrement = NULL;
+    CurrentFrameScalar = 0;
   }
 
   std::string               FieldName;
@@ -63,8 +82,15 @@ public:
   vtkMatrix4x4*             FrameTransformStart;
   vtkMatrix4x4*             FrameTransformIncrement;
   std::string               FrameTransformIndexFieldName;
+
+  // Current frame scalar and transform values. They are kept between UpdateFrameFieldValue calls,
+  // so that values continue to increment when the frames are updated chunk by chunk.
+  double                        CurrentFrameScalar;
+  vtkSmartPointer<vtkTransform> CurrentFrameTransform;
 };
 
+typedef std::function<PlusStatus(vtkPlusTrackedFrameList*)> TrackedFrameListOperation;
+
 PlusStatus TrimSequenceFile(vtkPlusTrackedFrameList* trackedFrameList, unsigned int firstFrameIndex, unsigned int lastFrameIndex);
 PlusStatus DecimateSequenceFile(vtkPlusTrackedFrameList* trackedFrameList, unsigned int decimationFactor);
 PlusStatus UpdateFrameFieldValue(FrameFieldUpdate& fieldUpdate);
@@ -73,11 +99,305 @@ PlusStatus ConvertStringToMatrix(std::string& strMatrix, vtkMatrix4x4* matrix);
 PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<std::string> transformNamesToAdd, std::string deviceSetConfigurationFileName);
 PlusStatus FillRectangle(vtkPlusTrackedFrameList* trackedFrameList, const std::vector<unsigned int>& fillRectOrigin, const std::vector<unsigned int>& fillRectSize, int fillGrayLevel);
 PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFrame::FlipInfoType& flipInfo, const std::vector<int>& cropRectOrigin, const std::vector<int>& cropRectSize);
+PlusStatus UpdateReferenceTransform(vtkPlusTrackedFrameList* trackedFrameList, const PlusTransformName& referenceTransformName);
+PlusStatus EditSequenceFileStreamed(const std::vector<std::string>& inputFileNames, const std::string& outputFileName, OperationType operation,
+                                    int firstFrameIndex, int lastFrameIndex, int decimationFactor, bool incrementTimestamps, bool mergeByTimestamp, bool useCompression,
+                                    bool useHeaderIndexFile, unsigned int chunkSize, const TrackedFrameListOperation& editGlobalFields, const TrackedFrameListOperation& editFrames);
 
 namespace
 {
   const std::string FIELD_VALUE_FRAME_SCALAR = "{frame-scalar}";
   const std::string FIELD_VALUE_FRAME_TRANSFORM = "{frame-transform}";
+
+  // Number of threads used for per-frame operations (0 = number of processors)
+  int NumberOfFrameProcessingThreads = 0;
+
+  // Global fields that the sequence file writers generate from the written frames, these are not copied from the input
+  const char* GENERATED_GLOBAL_FIELD_NAMES[] =
+  {
+    // MetaImage
+    "ObjectType", "NDims", "DimSize", "Kinds", "ElementType", "ElementNumberOfChannels", "ElementDataFile",
+    "BinaryData", "BinaryDataByteOrderMSB", "CompressedData", "CompressedDataSize", "UltrasoundImageOrientation", "UltrasoundImageType",
+    // NRRD
+    "type", "dimension", "space dimension", "space directions", "sizes", "kinds", "encoding", "endian", "data file",
+    "ultrasound image orientation", "ultrasound image type"
+  };
+
+  //----------------------------------------------------------------------------
+  // Copy the global (not per-frame) fields of a sequence file, except the ones that the writer generates
+  void CopyGlobalFields(vtkPlusTrackedFrameList* source, vtkPlusTrackedFrameList* destination)
+  {
+    std::vector<std::string> fieldNames;
+    source->GetCustomFieldNameList(fieldNames);
+    for (std::vector<std::string>::iterator fieldName = fieldNames.begin(); fieldName != fieldNames.end(); ++fieldName)
+    {
+      bool generatedField = false;
+      for (size_t i = 0; i < sizeof(GENERATED_GLOBAL_FIELD_NAMES) / sizeof(GENERATED_GLOBAL_FIELD_NAMES[0]); ++i)
+      {
+        if (PlusCommon::IsEqualInsensitive(*fieldName, GENERATED_GLOBAL_FIELD_NAMES[i]))
+        {
+          generatedField = true;
+          break;
+        }
+      }
+      if (!generatedField)
+      {
+        destination->SetCustomString(fieldName->c_str(), source->GetCustomString(fieldName->c_str()));
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameTimestampLess(PlusTrackedFrame* a, PlusTrackedFrame* b)
+  {
+    return a->GetTimestamp() < b->GetTimestamp();
+  }
+
+  typedef std::function<PlusStatus(PlusTrackedFrame* trackedFrame, unsigned int frameIndex)> TrackedFrameOperation;
+
+  //----------------------------------------------------------------------------
+  struct TrackedFrameOperationThreadInfo
+  {
+    std::vector<PlusTrackedFrame*> TrackedFrames;
+    const TrackedFrameOperation* Operation;
+    std::vector<int> NumberOfErrors; // one counter for each thread
+  };
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE TrackedFrameOperationThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    TrackedFrameOperationThreadInfo* str = static_cast<TrackedFrameOperationThreadInfo*>(threadInfo->UserData);
+    // Each thread processes a contiguous range of frames
+    size_t numberOfFrames = str->TrackedFrames.size();
+    size_t firstFrameIndex = numberOfFrames * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+    size_t lastFrameIndex = numberOfFrames * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+    for (size_t frameIndex = firstFrameIndex; frameIndex < lastFrameIndex; ++frameIndex)
+    {
+      if ((*str->Operation)(str->TrackedFrames[frameIndex], static_cast<unsigned int>(frameIndex)) != PLUS_SUCCESS)
+      {
+        str->NumberOfErrors[threadInfo->ThreadID]++;
+      }
+    }
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  // Run an operation on each frame of the list. Frames are processed in parallel, so the operation must not
+  // depend on other frames.
+  PlusStatus ForEachTrackedFrame(vtkPlusTrackedFrameList* trackedFrameList, const TrackedFrameOperation& operation)
+  {
+    TrackedFrameOperationThreadInfo str;
+    str.Operation = &operation;
+    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+    {
+      str.TrackedFrames.push_back(trackedFrameList->GetTrackedFrame(i));
+    }
+    if (str.TrackedFrames.empty())
+    {
+      return PLUS_SUCCESS;
+    }
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    if (NumberOfFrameProcessingThreads > 0)
+    {
+      threader->SetNumberOfThreads(NumberOfFrameProcessingThreads);
+    }
+    if (threader->GetNumberOfThreads() > static_cast<int>(str.TrackedFrames.size()))
+    {
+      threader->SetNumberOfThreads(static_cast<int>(str.TrackedFrames.size()));
+    }
+    str.NumberOfErrors.resize(threader->GetNumberOfThreads(), 0);
+    threader->SetSingleMethod(TrackedFrameOperationThreadFunction, &str);
+    threader->SingleMethodExecute();
+
+    for (std::vector<int>::iterator it = str.NumberOfErrors.begin(); it != str.NumberOfErrors.end(); ++it)
+    {
+      if (*it > 0)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Provides the frames of multiple sequence files one by one, either concatenated in the order of the files
+    or merged by timestamp (k-way merge). Only up to BufferSize frames are kept in memory for each file.
+    Merging by timestamp requires that the frames of each file are sorted by timestamp, reading fails
+    at the first frame that has a smaller timestamp than the previous frame of the same file.
+  */
+  class TrackedFrameStream
+  {
+  public:
+    TrackedFrameStream(unsigned int bufferSize, bool mergeByTimestamp, bool incrementTimestamps)
+      : BufferSize(bufferSize)
+      , MergeByTimestamp(mergeByTimestamp)
+      , IncrementTimestamps(incrementTimestamps)
+      , CurrentInputIndex(0)
+      , LastTimestamp(0)
+    {
+    }
+
+    void AddInput(vtkPlusSequenceIOBase* reader)
+    {
+      StreamInput input;
+      input.Reader = reader;
+      input.Buffer = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+      input.BufferPosition = 0;
+      input.FirstFrameRetrieved = false;
+      input.TimestampOffset = 0;
+      input.LastTimestamp = 0;
+      this->Inputs.push_back(input);
+    }
+
+    /*!
+      Retrieve the next frame and append it to outputFrameList. If outputFrameList is NULL then the frame is skipped.
+      frameAvailable is set to false if there are no more frames in any of the inputs.
+    */
+    PlusStatus ReadNextFrame(vtkPlusTrackedFrameList* outputFrameList, bool& frameAvailable)
+    {
+      frameAvailable = false;
+      StreamInput* nextInput = NULL;
+      if (this->MergeByTimestamp)
+      {
+        // Take the frame with the smallest timestamp, in case of equal timestamps prefer the input that was specified first
+        for (std::vector<StreamInput>::iterator input = this->Inputs.begin(); input != this->Inputs.end(); ++input)
+        {
+          PlusTrackedFrame* frame = NULL;
+          if (this->PeekFrame(*input, frame) != PLUS_SUCCESS)
+          {
+            return PLUS_FAIL;
+          }
+          if (frame != NULL && (nextInput == NULL || frame->GetTimestamp() < nextInput->Buffer->GetTrackedFrame(nextInput->BufferPosition)->GetTimestamp()))
+          {
+            nextInput = &(*input);
+          }
+        }
+      }
+      else
+      {
+        // Concatenate inputs in the order they were specified
+        for (; this->CurrentInputIndex < this->Inputs.size(); this->CurrentInputIndex++)
+        {
+          StreamInput& input = this->Inputs[this->CurrentInputIndex];
+          PlusTrackedFrame* frame = NULL;
+          if (this->PeekFrame(input, frame) != PLUS_SUCCESS)
+          {
+            return PLUS_FAIL;
+          }
+          if (frame != NULL)
+          {
+            if (this->IncrementTimestamps && !input.FirstFrameRetrieved)
+            {
+              // Timestamps continue from the last frame of the previous input
+              input.TimestampOffset = this->LastTimestamp;
+            }
+            nextInput = &input;
+            break;
+          }
+        }
+      }
+
+      if (nextInput == NULL)
+      {
+        // All inputs are consumed
+        return PLUS_SUCCESS;
+      }
+
+      PlusTrackedFrame* frame = nextInput->Buffer->GetTrackedFrame(nextInput->BufferPosition);
+      if (this->MergeByTimestamp && nextInput->FirstFrameRetrieved && frame->GetTimestamp() < nextInput->LastTimestamp)
+      {
+        // Frames of the other inputs with timestamps in between have been written already
+        LOG_ERROR("Frames of sequence file " << nextInput->Reader->GetFileName() << " are not sorted by timestamp (timestamp " << frame->GetTimestamp()
+                  << " follows " << nextInput->LastTimestamp << "). Merging unsorted files by timestamp is only supported without --streaming.");
+        return PLUS_FAIL;
+      }
+      nextInput->BufferPosition++;
+      nextInput->FirstFrameRetrieved = true;
+      nextInput->LastTimestamp = frame->GetTimestamp();
+      if (this->IncrementTimestamps)
+      {
+        frame->SetTimestamp(nextInput->TimestampOffset + frame->GetTimestamp());
+        this->LastTimestamp = frame->GetTimestamp();
+      }
+      frameAvailable = true;
+      if (outputFrameList != NULL && outputFrameList->AddTrackedFrame(frame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to append tracked frame to the list!");
+        return PLUS_FAIL;
+      }
+      return PLUS_SUCCESS;
+    }
+
+  protected:
+    struct StreamInput
+    {
+      vtkSmartPointer<vtkPlusSequenceIOBase> Reader;
+      vtkSmartPointer<vtkPlusTrackedFrameList> Buffer;
+      unsigned int BufferPosition;
+      bool FirstFrameRetrieved;
+      double TimestampOffset;
+      double LastTimestamp;
+    };
+
+    // Get the next frame of the input without consuming it (frame is NULL if there are no more frames)
+    PlusStatus PeekFrame(StreamInput& input, PlusTrackedFrame*& frame)
+    {
+      frame = NULL;
+      if (input.BufferPosition >= input.Buffer->GetNumberOfTrackedFrames())
+      {
+        // All buffered frames are consumed, read the next frames from the file
+        input.Buffer->Clear();
+        input.BufferPosition = 0;
+        unsigned int numberOfFramesRead = 0;
+        if (input.Reader->ReadNextFrames(input.Buffer, this->BufferSize, numberOfFramesRead) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Couldn't read frames from sequence file: " << input.Reader->GetFileName());
+          return PLUS_FAIL;
+        }
+      }
+      if (input.BufferPosition < input.Buffer->GetNumberOfTrackedFrames())
+      {
+        frame = input.Buffer->GetTrackedFrame(input.BufferPosition);
+      }
+      return PLUS_SUCCESS;
+    }
+
+    std::vector<StreamInput> Inputs;
+    unsigned int BufferSize;
+    bool MergeByTimestamp;
+    bool IncrementTimestamps;
+    size_t CurrentInputIndex;
+    double LastTimestamp;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! Log the peak memory usage of the process, to compare the memory needed with and without --streaming */
+  void LogPeakMemoryUsage()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memoryCounters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+    {
+      LOG_INFO("Peak memory usage: " << memoryCounters.PeakWorkingSetSize / (1024 * 1024) << " MB");
+    }
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+      // Reported in bytes
+      const long maxResidentSetSizeKb = usage.ru_maxrss / 1024;
+#else
+      // Reported in kilobytes
+      const long maxResidentSetSizeKb = usage.ru_maxrss;
+#endif
+      LOG_INFO("Peak memory usage: " << maxResidentSetSizeKb / 1024 << " MB");
+    }
+#endif
+  }
 }
 
 int main(int argc, char** argv)
@@ -93,7 +413,9 @@ int main(int argc, char** argv)
   std::string                     strOperation;
   OperationType                   operation;
   bool                            useCompression = false;
+  bool                            useHeaderIndexFile = false;
   bool                            incrementTimestamps = false;
+  bool                            mergeByTimestamp = false;
 
   int                             firstFrameIndex = -1; // First frame index used for trimming the sequence file.
   int                             lastFrameIndex = -1; // Last frame index used for trimming the sequence file.
@@ -130,6 +452,10 @@ int main(int argc, char** argv)
   bool                            flipY(false);
   bool                            flipZ(false);
 
+  bool                            streaming(false); // Process the frames in chunks instead of loading all frames into memory
+  int                             streamingChunkSize = 100; // Number of frames processed at once in streaming mode
+  int                             numberOfThreads = 0; // Number of threads for per-frame operations (0 = number of processors)
+
   args.Initialize(argc, argv);
   args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
@@ -162,7 +488,9 @@ int main(int argc, char** argv)
   args.AddArgument("--update-reference-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &strUpdatedReferenceTransformName, "Set the reference transform name to update old files by changing all ToolToReference transforms to ToolToTracker transform.");
 
   args.AddArgument("--use-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &useCompression, "Compress sequence file images.");
+  args.AddArgument("--use-header-index-file", vtksys::CommandLineArguments::NO_ARGUMENT, &useHeaderIndexFile, "Cache the parsed header of MetaImage input files in a header index file (.plusidx) next to the input file, to read the header faster next time.");
   args.AddArgument("--increment-timestamps", vtksys::CommandLineArguments::NO_ARGUMENT, &incrementTimestamps, "Increment timestamps in the order of the input-file-names");
+  args.AddArgument("--merge-by-timestamp", vtksys::CommandLineArguments::NO_ARGUMENT, &mergeByTimestamp, "Order the frames of all input files by timestamp when merging (by default the input files are concatenated in the order of the input-file-names)");
 
   args.AddArgument("--add-transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &transformNamesToAdd, "Name of the transform to add to each frame (e.g., StylusTipToTracker); multiple transforms can be added separated by a comma (e.g., StylusTipToReference,ProbeToReference)");
   args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &deviceSetConfigurationFileName, "Used device set configuration file path and name");
@@ -175,6 +503,11 @@ int main(int argc, char** argv)
   args.AddArgument("--flipZ", vtksys::CommandLineArguments::NO_ARGUMENT, &flipZ, "Flip image along Z axis.");
   args.AddArgument("--fill-gray-level", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &fillGrayLevel, "Rectangle fill gray level. 0 = black, 255 = white. (Default: 0)");
 
+  // Execution arguments
+  args.AddArgument("--streaming", vtksys::CommandLineArguments::NO_ARGUMENT, &streaming, "Read, edit, and write the frames in chunks, so that memory usage does not depend on the length of the sequence. Compressed output is not supported for MetaImage files in this mode.");
+  args.AddArgument("--streaming-chunk-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &streamingChunkSize, "Number of frames that are read, edited, and written at once in streaming mode (Default: 100)");
+  args.AddArgument("--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads used for editing frames in parallel. 0 = number of processors (Default: 0)");
+
   if (!args.Parse())
   {
     std::cerr << "Problem parsing arguments" << std::endl;
@@ -209,7 +542,7 @@ int main(int argc, char** argv)
     std::cout << "- DECIMATE: Keep every N-th frame of the sequence file." << std::endl;
     std::cout << "  Requires --decimation-factor." << std::endl;
     std::cout << "- MERGE: Merge multiple sequence files into one." << std::endl;
-    std::cout << "  Set input files with the --source-seq-files parameter." << std::endl;
+    std::cout << "  Set input files with the --source-seq-files parameter. The files are concatenated, unless --merge-by-timestamp is specified." << std::endl;
 
     std::cout << "- FILL_IMAGE_RECTANGLE: Fill a rectangle in the image (useful for removing patient data from sequences)." << std::endl;
     std::cout << "  Requires --rect-origin, --rect-size, and --fill-gray-level. E.g., --rect-origin 12 34 --rect-size 56 78)" << std::endl;
@@ -218,6 +551,9 @@ int main(int argc, char** argv)
 
     std::cout << "- REMOVE_IMAGE_DATA: Remove image data from a meta file that has both image and tracker data, and keep only the tracker data." << std::endl;
 
+    std::cout << std::endl << "Streaming (--streaming): frames are read, edited, and written in chunks of --streaming-chunk-size frames." << std::endl;
+    std::cout << "  With --merge-by-timestamp the frames of each input file must be sorted by timestamp." << std::endl;
+
     return EXIT_SUCCESS;
   }
 
@@ -236,6 +572,19 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  if (streaming && streamingChunkSize < 1)
+  {
+    LOG_ERROR("Invalid streaming chunk size: " << streamingChunkSize << ". It must be a positive integer.");
+    return EXIT_FAILURE;
+  }
+  NumberOfFrameProcessingThreads = std::max(numberOfThreads, 0);
+
+  if (mergeByTimestamp && incrementTimestamps)
+  {
+    LOG_ERROR("--merge-by-timestamp and --increment-timestamps cannot be used together");
+    return EXIT_FAILURE;
+  }
+
   // Set operation
   if (strOperation.empty())
   {
@@ -319,108 +668,59 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  ///////////////////////////////////////////////////////////////////
-  // Read input files
-
-  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-  vtkSmartPointer<vtkPlusTrackedFrameList> timestampFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-
   if (!inputFileName.empty())
   {
     // Insert file name to the beginning of the list
     inputFileNames.insert(inputFileNames.begin(), inputFileName);
   }
 
-  double lastTimestamp = 0;
-  for (unsigned int i = 0; i < inputFileNames.size(); i++)
+  PlusTransformName referenceTransformName;
+  if (!strUpdatedReferenceTransformName.empty() && referenceTransformName.SetTransformName(strUpdatedReferenceTransformName.c_str()) != PLUS_SUCCESS)
   {
-    LOG_INFO("Read input sequence file: " << inputFileNames[i]);
+    LOG_ERROR("Reference transform name is invalid: " << strUpdatedReferenceTransformName);
+    return EXIT_FAILURE;
+  }
 
-    if (vtkPlusSequenceIO::Read(inputFileNames[i], timestampFrameList) != PLUS_SUCCESS)
+  std::vector<unsigned int> rectOriginPixUint;
+  std::vector<unsigned int> rectSizePixUint;
+  if (operation == FILL_IMAGE_RECTANGLE)
+  {
+    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
     {
-      LOG_ERROR("Couldn't read sequence file: " <<  inputFileName);
+      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
       return EXIT_FAILURE;
     }
-
-    if (incrementTimestamps)
-    {
-      vtkPlusTrackedFrameList* tfList = timestampFrameList;
-      for (unsigned int f = 0; f < tfList->GetNumberOfTrackedFrames(); ++f)
-      {
-        PlusTrackedFrame* tf = tfList->GetTrackedFrame(f);
-        tf->SetTimestamp(lastTimestamp + tf->GetTimestamp());
-      }
-
-      lastTimestamp = tfList->GetTrackedFrame(tfList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
-    }
-
-    if (trackedFrameList->AddTrackedFrameList(timestampFrameList) != PLUS_SUCCESS)
+    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
     {
-      LOG_ERROR("Failed to append tracked frame list!");
-      return EXIT_SUCCESS;
+      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
+      return EXIT_FAILURE;
     }
+    rectOriginPixUint.assign(rectOriginPix.begin(), rectOriginPix.end());
+    rectSizePixUint.assign(rectSizePix.begin(), rectSizePix.end());
   }
 
+  PlusVideoFrame::FlipInfoType flipInfo;
+  flipInfo.hFlip = flipX;
+  flipInfo.vFlip = flipY;
+  flipInfo.eFlip = flipZ;
 
-  ///////////////////////////////////////////////////////////////////
-  // Make the operation
-
-  switch (operation)
-  {
-  case NO_OPERATION:
-  case MERGE:
-  {
-    // No need to do anything just save into output file
-  }
-  break;
-  case TRIM:
+  std::vector<std::string> transformNamesList;
+  if (operation == ADD_TRANSFORM)
   {
-    if (firstFrameIndex < 0)
-    {
-      firstFrameIndex = 0;
-    }
-    if (lastFrameIndex < 0)
-    {
-      lastFrameIndex = 0;
-    }
-    unsigned int firstFrameIndexUint = static_cast<unsigned int>(firstFrameIndex);
-    unsigned int lastFrameIndexUint = static_cast<unsigned int>(lastFrameIndex);
-    if (TrimSequenceFile(trackedFrameList, firstFrameIndexUint, lastFrameIndexUint) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to trim sequence file");
-      return EXIT_FAILURE;
-    }
+    LOG_INFO("Add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
+    PlusCommon::SplitStringIntoTokens(transformNamesToAdd, ',', transformNamesList);
   }
-  break;
-  case DECIMATE:
+  else if (operation == DELETE_FRAME_FIELD)
   {
-    if (DecimateSequenceFile(trackedFrameList, decimationFactor) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to decimate sequence file");
-      return EXIT_FAILURE;
-    }
+    LOG_INFO("Delete frame field: " << fieldName);
   }
-  break;
-  case UPDATE_FRAME_FIELD_NAME:
-  {
-    FrameFieldUpdate fieldUpdate;
-    fieldUpdate.TrackedFrameList = trackedFrameList;
-    fieldUpdate.FieldName = fieldName;
-    fieldUpdate.UpdatedFieldName = updatedFieldName;
 
-    if (UpdateFrameFieldValue(fieldUpdate) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to update frame field name '" << fieldName << "' to '" << updatedFieldName << "'");
-      return EXIT_FAILURE;
-    }
-  }
-  break;
-  case UPDATE_FRAME_FIELD_VALUE:
+  // The field update state is kept between calls, so frame scalar and transform values continue from chunk to chunk in streaming mode
+  FrameFieldUpdate fieldUpdate;
+  fieldUpdate.FieldName = fieldName;
+  fieldUpdate.UpdatedFieldName = updatedFieldName;
+  if (operation == UPDATE_FRAME_FIELD_VALUE)
   {
-    FrameFieldUpdate fieldUpdate;
-    fieldUpdate.TrackedFrameList = trackedFrameList;
-    fieldUpdate.FieldName = fieldName;
-    fieldUpdate.UpdatedFieldName = updatedFieldName;
     fieldUpdate.UpdatedFieldValue = updatedFieldValue;
     fieldUpdate.FrameScalarDecimalDigits = frameScalarDecimalDigits;
     fieldUpdate.FrameScalarIncrement = frameScalarIncrement;
@@ -428,223 +728,242 @@ int main(int argc, char** argv)
     fieldUpdate.FrameTransformStart = frameTransformStart;
     fieldUpdate.FrameTransformIncrement = frameTransformIncrement;
     fieldUpdate.FrameTransformIndexFieldName = strFrameTransformIndexFieldName;
-
-    if (UpdateFrameFieldValue(fieldUpdate) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to update frame field value");
-      return EXIT_FAILURE;
-    }
-  }
-  break;
-  case DELETE_FRAME_FIELD:
-  {
-    if (DeleteFrameField(trackedFrameList, fieldName) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to delete frame field");
-      return EXIT_FAILURE;
-    }
   }
-  break;
-  case DELETE_FIELD:
+
+  // Operations on the fields that are stored for the whole sequence
+  TrackedFrameListOperation editGlobalFields = [&](vtkPlusTrackedFrameList* trackedFrameList) -> PlusStatus
   {
-    // Delete field
-    LOG_INFO("Delete field: " << fieldName);
-    if (trackedFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
+    switch (operation)
     {
-      LOG_ERROR("Failed to delete field: " << fieldName);
-      return EXIT_FAILURE;
-    }
-  }
-  break;
-  case UPDATE_FIELD_NAME:
-  {
-    // Update field name
-    LOG_INFO("Update field name '" << fieldName << "' to  '" << updatedFieldName << "'");
-    const char* fieldValue = trackedFrameList->GetCustomString(fieldName.c_str());
-    if (fieldValue != NULL)
+    case DELETE_FIELD:
     {
       // Delete field
+      LOG_INFO("Delete field: " << fieldName);
       if (trackedFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
       {
         LOG_ERROR("Failed to delete field: " << fieldName);
-        return EXIT_FAILURE;
+        return PLUS_FAIL;
       }
+    }
+    break;
+    case UPDATE_FIELD_NAME:
+    {
+      // Update field name
+      LOG_INFO("Update field name '" << fieldName << "' to  '" << updatedFieldName << "'");
+      const char* fieldValue = trackedFrameList->GetCustomString(fieldName.c_str());
+      if (fieldValue != NULL)
+      {
+        std::string copyOfFieldValue(fieldValue);
+        // Delete field
+        if (trackedFrameList->SetCustomString(fieldName.c_str(), NULL) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to delete field: " << fieldName);
+          return PLUS_FAIL;
+        }
 
-      // Add new field
-      if (trackedFrameList->SetCustomString(updatedFieldName.c_str(), fieldValue) != PLUS_SUCCESS)
+        // Add new field
+        if (trackedFrameList->SetCustomString(updatedFieldName.c_str(), copyOfFieldValue.c_str()) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to update field '" << updatedFieldName << "' with value '" << copyOfFieldValue << "'");
+          return PLUS_FAIL;
+        }
+      }
+    }
+    break;
+    case UPDATE_FIELD_VALUE:
+    {
+      // Update field value
+      LOG_INFO("Update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
+      if (trackedFrameList->SetCustomString(fieldName.c_str(), updatedFieldValue.c_str()) != PLUS_SUCCESS)
       {
-        LOG_ERROR("Failed to update field '" << updatedFieldName << "' with value '" << fieldValue << "'");
-        return EXIT_FAILURE;
+        LOG_ERROR("Failed to update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
+        return PLUS_FAIL;
       }
     }
-  }
-  break;
-  case UPDATE_FIELD_VALUE:
+    break;
+    default:
+      // Other operations do not change global fields
+      break;
+    }
+    return PLUS_SUCCESS;
+  };
+
+  // Operations that are performed on each frame independently (in streaming mode they are called for each chunk of frames)
+  TrackedFrameListOperation editFrames = [&](vtkPlusTrackedFrameList* trackedFrameList) -> PlusStatus
   {
-    // Update field value
-    LOG_INFO("Update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
-    if (trackedFrameList->SetCustomString(fieldName.c_str(), updatedFieldValue.c_str()) != PLUS_SUCCESS)
+    switch (operation)
     {
-      LOG_ERROR("Failed to update field '" << fieldName << "' with value '" << updatedFieldValue << "'");
-      return EXIT_FAILURE;
+    case UPDATE_FRAME_FIELD_NAME:
+    case UPDATE_FRAME_FIELD_VALUE:
+    {
+      fieldUpdate.TrackedFrameList = trackedFrameList;
+      if (UpdateFrameFieldValue(fieldUpdate) != PLUS_SUCCESS)
+      {
+        if (operation == UPDATE_FRAME_FIELD_NAME)
+        {
+          LOG_ERROR("Failed to update frame field name '" << fieldName << "' to '" << updatedFieldName << "'");
+        }
+        else
+        {
+          LOG_ERROR("Failed to update frame field value");
+        }
+        return PLUS_FAIL;
+      }
     }
-  }
-  break;
-  case ADD_TRANSFORM:
-  {
-    // Add transform
-    LOG_INFO("Add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
-    std::vector<std::string> transformNamesList;
-    PlusCommon::SplitStringIntoTokens(transformNamesToAdd, ',', transformNamesList);
-    if (AddTransform(trackedFrameList, transformNamesList, deviceSetConfigurationFileName) != PLUS_SUCCESS)
+    break;
+    case DELETE_FRAME_FIELD:
     {
-      LOG_ERROR("Failed to add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
-      return EXIT_FAILURE;
+      if (DeleteFrameField(trackedFrameList, fieldName) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to delete frame field");
+        return PLUS_FAIL;
+      }
     }
-  }
-  break;
-  case FILL_IMAGE_RECTANGLE:
-  {
-    if (rectOriginPix.size() != 2 || rectSizePix.size() != 2)
+    break;
+    case ADD_TRANSFORM:
     {
-      LOG_ERROR("Incorrect size of vector for rectangle origin or size. Aborting.");
-      return PLUS_FAIL;
+      if (AddTransform(trackedFrameList, transformNamesList, deviceSetConfigurationFileName) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add transform '" << transformNamesToAdd << "' using device set configuration file '" << deviceSetConfigurationFileName << "'");
+        return PLUS_FAIL;
+      }
     }
-    if (rectOriginPix[0] < 0 || rectOriginPix[1] < 0 || rectSizePix[0] < 0 || rectSizePix[1] < 0)
+    break;
+    case FILL_IMAGE_RECTANGLE:
     {
-      LOG_ERROR("Negative value for rectangle origin or size entered. Aborting.");
-      return PLUS_FAIL;
+      // Fill a rectangular region in the image with a solid color
+      if (FillRectangle(trackedFrameList, rectOriginPixUint, rectSizePixUint, fillGrayLevel) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to fill rectangle");
+        return PLUS_FAIL;
+      }
     }
-    std::vector<unsigned int> rectOriginPixUint(rectOriginPix.begin(), rectOriginPix.end());
-    std::vector<unsigned int> rectSizePixUint(rectSizePix.begin(), rectSizePix.end());
-    // Fill a rectangular region in the image with a solid color
-    if (FillRectangle(trackedFrameList, rectOriginPixUint, rectSizePixUint, fillGrayLevel) != PLUS_SUCCESS)
+    break;
+    case CROP:
     {
-      LOG_ERROR("Failed to fill rectangle");
-      return EXIT_FAILURE;
+      // Crop a rectangular region from the image
+      if (CropRectangle(trackedFrameList, flipInfo, rectOriginPix, rectSizePix) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to crop rectangle");
+        return PLUS_FAIL;
+      }
     }
-  }
-  break;
-  case CROP:
+    break;
+    default:
+      // Other operations do not change frames individually
+      break;
+    }
+
+    // Convert files to the new file format
+    if (!strUpdatedReferenceTransformName.empty())
+    {
+      UpdateReferenceTransform(trackedFrameList, referenceTransformName);
+    }
+    return PLUS_SUCCESS;
+  };
+
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  if (streaming)
   {
-    // Crop a rectangular region from the image
-    PlusVideoFrame::FlipInfoType flipInfo;
-    flipInfo.hFlip = flipX;
-    flipInfo.vFlip = flipY;
-    flipInfo.eFlip = flipZ;
-    if (CropRectangle(trackedFrameList, flipInfo, rectOriginPix, rectSizePix) != PLUS_SUCCESS)
+    if (EditSequenceFileStreamed(inputFileNames, outputFileName, operation, firstFrameIndex, lastFrameIndex, decimationFactor, incrementTimestamps,
+                                 mergeByTimestamp, useCompression, useHeaderIndexFile, static_cast<unsigned int>(streamingChunkSize), editGlobalFields, editFrames) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Failed to fill rectangle");
+      LOG_ERROR("Failed to edit sequence file in streaming mode");
       return EXIT_FAILURE;
     }
-  }
-  break;
-  case REMOVE_IMAGE_DATA:
-    // No processing is needed, image data is removed when writing the output
-    break;
-  default:
-  {
-    LOG_WARNING("Unknown operation is specified");
-    return EXIT_FAILURE;
-  }
+    LOG_INFO("Sequence file editing was successful! Elapsed time: " << vtkPlusAccurateTimer::GetSystemTime() - startTime << " sec");
+    LogPeakMemoryUsage();
+    return EXIT_SUCCESS;
   }
 
+  ///////////////////////////////////////////////////////////////////
+  // Read input files
 
-  //////////////////////////////////////////////////////////////////
-  // Convert files to the new file format
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  vtkSmartPointer<vtkPlusTrackedFrameList> timestampFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
 
-  if (!strUpdatedReferenceTransformName.empty())
+  double lastTimestamp = 0;
+  for (unsigned int i = 0; i < inputFileNames.size(); i++)
   {
-    PlusTransformName referenceTransformName;
-    if (referenceTransformName.SetTransformName(strUpdatedReferenceTransformName.c_str()) != PLUS_SUCCESS)
+    LOG_INFO("Read input sequence file: " << inputFileNames[i]);
+
+    if (vtkPlusSequenceIO::Read(inputFileNames[i], timestampFrameList, useHeaderIndexFile) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Reference transform name is invalid: " << strUpdatedReferenceTransformName);
+      LOG_ERROR("Couldn't read sequence file: " <<  inputFileName);
       return EXIT_FAILURE;
     }
 
-    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+    if (incrementTimestamps)
     {
-      PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
-
-      vtkSmartPointer<vtkMatrix4x4> referenceToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      if (trackedFrame->GetCustomFrameTransform(referenceTransformName, referenceToTrackerMatrix) != PLUS_SUCCESS)
+      vtkPlusTrackedFrameList* tfList = timestampFrameList;
+      for (unsigned int f = 0; f < tfList->GetNumberOfTrackedFrames(); ++f)
       {
-        LOG_WARNING("Couldn't get reference transform with name: " << strUpdatedReferenceTransformName);
-        continue;
+        PlusTrackedFrame* tf = tfList->GetTrackedFrame(f);
+        tf->SetTimestamp(lastTimestamp + tf->GetTimestamp());
       }
 
-      std::vector<PlusTransformName> transformNameList;
-      trackedFrame->GetCustomFrameTransformNameList(transformNameList);
-
-      vtkSmartPointer<vtkTransform> toolToTrackerTransform = vtkSmartPointer<vtkTransform>::New();
-      vtkSmartPointer<vtkMatrix4x4> toolToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-      for (unsigned int n = 0; n < transformNameList.size(); ++n)
-      {
-        // No need to change the reference transform
-        if (transformNameList[n] == referenceTransformName)
-        {
-          continue;
-        }
-
-        TrackedFrameFieldStatus status = FIELD_INVALID;
-        if (trackedFrame->GetCustomFrameTransform(transformNameList[n], toolToReferenceMatrix) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to get custom frame transform: " << strTransformName);
-          continue;
-        }
-
-        if (trackedFrame->GetCustomFrameTransformStatus(transformNameList[n], status) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to get custom frame transform status: " << strTransformName);
-          continue;
-        }
+      lastTimestamp = tfList->GetTrackedFrame(tfList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
+    }
 
-        // Compute ToolToTracker transform from ToolToReference
-        toolToTrackerTransform->Identity();
-        toolToTrackerTransform->Concatenate(referenceToTrackerMatrix);
-        toolToTrackerTransform->Concatenate(toolToReferenceMatrix);
+    if (trackedFrameList->AddTrackedFrameList(timestampFrameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to append tracked frame list!");
+      return EXIT_SUCCESS;
+    }
+  }
 
-        // Update the name to ToolToTracker
-        PlusTransformName toolToTracker(transformNameList[n].From().c_str(), "Tracker");
-        // Set the new custom transform
-        if (trackedFrame->SetCustomFrameTransform(toolToTracker, toolToTrackerTransform->GetMatrix()) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to set custom frame transform: " << strTransformName);
-          continue;
-        }
+  if (mergeByTimestamp)
+  {
+    // Frames with equal timestamps keep the order of the input files
+    std::stable_sort(trackedFrameList->begin(), trackedFrameList->end(), TrackedFrameTimestampLess);
+    trackedFrameList->Modified();
+  }
 
-        // Use the same status as it was before
-        if (trackedFrame->SetCustomFrameTransformStatus(toolToTracker, status) != PLUS_SUCCESS)
-        {
-          std::string strTransformName;
-          transformNameList[i].GetTransformName(strTransformName);
-          LOG_ERROR("Failed to set custom frame transform status: " << strTransformName);
-          continue;
-        }
 
-        // Delete old transform and status fields
-        std::string oldTransformName, oldTransformStatus;
-        transformNameList[n].GetTransformName(oldTransformName);
-        // Append Transform to the end of the transform name
-        vtksys::RegularExpression isTransform("Transform$");
-        if (!isTransform.find(oldTransformName))
-        {
-          oldTransformName.append("Transform");
-        }
-        oldTransformStatus = oldTransformName;
-        oldTransformStatus.append("Status");
-        trackedFrame->DeleteCustomFrameField(oldTransformName.c_str());
-        trackedFrame->DeleteCustomFrameField(oldTransformStatus.c_str());
+  ///////////////////////////////////////////////////////////////////
+  // Make the operation
 
-      }
+  switch (operation)
+  {
+  case TRIM:
+  {
+    if (firstFrameIndex < 0)
+    {
+      firstFrameIndex = 0;
+    }
+    if (lastFrameIndex < 0)
+    {
+      lastFrameIndex = 0;
+    }
+    unsigned int firstFrameIndexUint = static_cast<unsigned int>(firstFrameIndex);
+    unsigned int lastFrameIndexUint = static_cast<unsigned int>(lastFrameIndex);
+    if (TrimSequenceFile(trackedFrameList, firstFrameIndexUint, lastFrameIndexUint) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to trim sequence file");
+      return EXIT_FAILURE;
+    }
+  }
+  break;
+  case DECIMATE:
+  {
+    if (DecimateSequenceFile(trackedFrameList, decimationFactor) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to decimate sequence file");
+      return EXIT_FAILURE;
     }
   }
+  break;
+  default:
+    // NO_OPERATION, MERGE, and REMOVE_IMAGE_DATA need no processing (image data is removed when writing the output),
+    // all other operations are performed on global fields or frames
+    break;
+  }
+
+  if (editGlobalFields(trackedFrameList) != PLUS_SUCCESS || editFrames(trackedFrameList) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
 
   ///////////////////////////////////////////////////////////////////
   // Save output file to file
@@ -656,7 +975,8 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  LOG_INFO("Sequence file editing was successful!");
+  LOG_INFO("Sequence file editing was successful! Elapsed time: " << vtkPlusAccurateTimer::GetSystemTime() - startTime << " sec");
+  LogPeakMemoryUsage();
   return EXIT_SUCCESS;
 }
 
@@ -724,7 +1044,6 @@ PlusStatus DeleteFrameField(vtkPlusTrackedFrameList* trackedFrameList, std::stri
     return PLUS_FAIL;
   }
 
-  LOG_INFO("Delete frame field: " << fieldName);
   int numberOfErrors(0);
   for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
@@ -748,18 +1067,24 @@ PlusStatus DeleteFrameField(vtkPlusTrackedFrameList* trackedFrameList, std::stri
 //-------------------------------------------------------
 PlusStatus UpdateFrameFieldValue(FrameFieldUpdate& fieldUpdate)
 {
-  LOG_INFO("Update frame field");
   int numberOfErrors(0);
 
-  // Set the start scalar value
-  double scalarVariable = fieldUpdate.FrameScalarStart;
-
-  // Set the start transform matrix
-  vtkSmartPointer<vtkTransform> frameTransform = vtkSmartPointer<vtkTransform>::New();
-  if (fieldUpdate.FrameTransformStart != NULL)
+  if (fieldUpdate.CurrentFrameTransform == NULL)
   {
-    frameTransform->SetMatrix(fieldUpdate.FrameTransformStart);
+    LOG_INFO("Update frame field");
+
+    // Set the start scalar value
+    fieldUpdate.CurrentFrameScalar = fieldUpdate.FrameScalarStart;
+
+    // Set the start transform matrix
+    fieldUpdate.CurrentFrameTransform = vtkSmartPointer<vtkTransform>::New();
+    if (fieldUpdate.FrameTransformStart != NULL)
+    {
+      fieldUpdate.CurrentFrameTransform->SetMatrix(fieldUpdate.FrameTransformStart);
+    }
   }
+  double& scalarVariable = fieldUpdate.CurrentFrameScalar;
+  vtkTransform* frameTransform = fieldUpdate.CurrentFrameTransform;
 
   for (unsigned int i = 0; i < fieldUpdate.TrackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
@@ -905,10 +1230,8 @@ PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<s
     return PLUS_FAIL;
   }
 
-  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  return ForEachTrackedFrame(trackedFrameList, [&](PlusTrackedFrame* trackedFrame, unsigned int i) -> PlusStatus
   {
-    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
-
     // Set up transform repository
     vtkSmartPointer<vtkPlusTransformRepository> transformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
     if (transformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
@@ -944,9 +1267,8 @@ PlusStatus AddTransform(vtkPlusTrackedFrameList* trackedFrameList, std::vector<s
         trackedFrame->SetCustomFrameTransformStatus(transformName, FIELD_OK);
       }
     }
-  }
-
-  return PLUS_SUCCESS;
+    return PLUS_SUCCESS;
+  });
 }
 
 //-------------------------------------------------------
@@ -963,53 +1285,56 @@ PlusStatus FillRectangle(vtkPlusTrackedFrameList* trackedFrameList, const std::v
     return PLUS_FAIL;
   }
 
-  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  unsigned char fillData = 0;
+  if (fillGrayLevel < 0)
+  {
+    fillData = 0;
+  }
+  else if (fillGrayLevel > 255)
+  {
+    fillData = 255;
+  }
+  else
+  {
+    fillData = fillGrayLevel;
+  }
+
+  ForEachTrackedFrame(trackedFrameList, [&](PlusTrackedFrame* trackedFrame, unsigned int i) -> PlusStatus
   {
-    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
     PlusVideoFrame* videoFrame = trackedFrame->GetImageData();
     unsigned int frameSize[3] = {0, 0, 0};
     if (videoFrame == NULL || videoFrame->GetFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to retrieve pixel data from frame " << i << ". Fill rectangle failed.");
-      continue;
+      return PLUS_FAIL;
     }
     if (fillRectOrigin[0] >= frameSize[0] ||
         fillRectOrigin[1] >= frameSize[1])
     {
       LOG_ERROR("Invalid fill rectangle origin is specified (" << fillRectOrigin[0] << ", " << fillRectOrigin[1] << "). The image size is ("
                 << frameSize[0] << ", " << frameSize[1] << ").");
-      continue;
+      return PLUS_FAIL;
     }
     if (fillRectSize[0] <= 0 || fillRectOrigin[0] + fillRectSize[0] > frameSize[0] ||
         fillRectSize[1] <= 0 || fillRectOrigin[1] + fillRectSize[1] > frameSize[1])
     {
       LOG_ERROR("Invalid fill rectangle size is specified (" << fillRectSize[0] << ", " << fillRectSize[1] << "). The specified fill rectangle origin is ("
                 << fillRectOrigin[0] << ", " << fillRectOrigin[1] << ") and the image size is (" << frameSize[0] << ", " << frameSize[1] << ").");
-      continue;
+      return PLUS_FAIL;
     }
     if (videoFrame->GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
     {
       LOG_ERROR("Fill rectangle is supported only for B-mode images (unsigned char type)");
-      continue;
-    }
-    unsigned char fillData = 0;
-    if (fillGrayLevel < 0)
-    {
-      fillData = 0;
-    }
-    else if (fillGrayLevel > 255)
-    {
-      fillData = 255;
-    }
-    else
-    {
-      fillData = fillGrayLevel;
+      return PLUS_FAIL;
     }
     for (unsigned int y = 0; y < fillRectSize[1]; y++)
     {
       memset(static_cast<unsigned char*>(videoFrame->GetScalarPointer()) + (fillRectOrigin[1] + y)*frameSize[0] + fillRectOrigin[0], fillData, fillRectSize[0]);
     }
-  }
+    return PLUS_SUCCESS;
+  });
+
+  // Frames that cannot be edited are skipped, the errors are already logged
   return PLUS_SUCCESS;
 }
 
@@ -1031,16 +1356,15 @@ PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFra
   tfmMatrix->SetElement(2, 3, -rectOrigin[2]);
   PlusTransformName imageToCroppedImage("Image", "CroppedImage");
 
-  for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  ForEachTrackedFrame(trackedFrameList, [&](PlusTrackedFrame* trackedFrame, unsigned int i) -> PlusStatus
   {
-    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(i);
     PlusVideoFrame* videoFrame = trackedFrame->GetImageData();
 
     unsigned int frameSize[3] = {0, 0, 0};
     if (videoFrame == NULL || videoFrame->GetFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to retrieve pixel data from frame " << i << ". Crop rectangle failed.");
-      continue;
+      return PLUS_FAIL;
     }
 
     vtkSmartPointer<vtkImageData> croppedImage = vtkSmartPointer<vtkImageData>::New();
@@ -1049,11 +1373,281 @@ PlusStatus CropRectangle(vtkPlusTrackedFrameList* trackedFrameList, PlusVideoFra
     videoFrame->DeepCopyFrom(croppedImage);
     trackedFrame->SetCustomFrameTransform(imageToCroppedImage, tfmMatrix);
     trackedFrame->SetCustomFrameTransformStatus(imageToCroppedImage, FIELD_OK);
-  }
+    return PLUS_SUCCESS;
+  });
 
+  // Frames that cannot be edited are skipped, the errors are already logged
   return PLUS_SUCCESS;
 }
 
+//-------------------------------------------------------
+PlusStatus UpdateReferenceTransform(vtkPlusTrackedFrameList* trackedFrameList, const PlusTransformName& referenceTransformName)
+{
+  return ForEachTrackedFrame(trackedFrameList, [&](PlusTrackedFrame* trackedFrame, unsigned int i) -> PlusStatus
+  {
+    vtkSmartPointer<vtkMatrix4x4> referenceToTrackerMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (trackedFrame->GetCustomFrameTransform(referenceTransformName, referenceToTrackerMatrix) != PLUS_SUCCESS)
+    {
+      std::string strReferenceTransformName;
+      referenceTransformName.GetTransformName(strReferenceTransformName);
+      LOG_WARNING("Couldn't get reference transform with name: " << strReferenceTransformName);
+      return PLUS_SUCCESS;
+    }
+
+    std::vector<PlusTransformName> transformNameList;
+    trackedFrame->GetCustomFrameTransformNameList(transformNameList);
+
+    vtkSmartPointer<vtkTransform> toolToTrackerTransform = vtkSmartPointer<vtkTransform>::New();
+    vtkSmartPointer<vtkMatrix4x4> toolToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (unsigned int n = 0; n < transformNameList.size(); ++n)
+    {
+      // No need to change the reference transform
+      if (transformNameList[n] == referenceTransformName)
+      {
+        continue;
+      }
+
+      std::string strTransformName;
+      transformNameList[n].GetTransformName(strTransformName);
+
+      TrackedFrameFieldStatus status = FIELD_INVALID;
+      if (trackedFrame->GetCustomFrameTransform(transformNameList[n], toolToReferenceMatrix) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to get custom frame transform: " << strTransformName);
+        continue;
+      }
+
+      if (trackedFrame->GetCustomFrameTransformStatus(transformNameList[n], status) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to get custom frame transform status: " << strTransformName);
+        continue;
+      }
+
+      // Compute ToolToTracker transform from ToolToReference
+      toolToTrackerTransform->Identity();
+      toolToTrackerTransform->Concatenate(referenceToTrackerMatrix);
+      toolToTrackerTransform->Concatenate(toolToReferenceMatrix);
 
+      // Update the name to ToolToTracker
+      PlusTransformName toolToTracker(transformNameList[n].From().c_str(), "Tracker");
+      // Set the new custom transform
+      if (trackedFrame->SetCustomFrameTransform(toolToTracker, toolToTrackerTransform->GetMatrix()) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to set custom frame transform: " << strTransformName);
+        continue;
+      }
+
+      // Use the same status as it was before
+      if (trackedFrame->SetCustomFrameTransformStatus(toolToTracker, status) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to set custom frame transform status: " << strTransformName);
+        continue;
+      }
+
+      // Delete old transform and status fields
+      std::string oldTransformName, oldTransformStatus;
+      transformNameList[n].GetTransformName(oldTransformName);
+      // Append Transform to the end of the transform name
+      vtksys::RegularExpression isTransform("Transform$");
+      if (!isTransform.find(oldTransformName))
+      {
+        oldTransformName.append("Transform");
+      }
+      oldTransformStatus = oldTransformName;
+      oldTransformStatus.append("Status");
+      trackedFrame->DeleteCustomFrameField(oldTransformName.c_str());
+      trackedFrame->DeleteCustomFrameField(oldTransformStatus.c_str());
+    }
+    return PLUS_SUCCESS;
+  });
+}
 
+//-------------------------------------------------------
+PlusStatus EditSequenceFileStreamed(const std::vector<std::string>& inputFileNames, const std::string& outputFileName, OperationType operation,
+                                    int firstFrameIndex, int lastFrameIndex, int decimationFactor, bool incrementTimestamps, bool mergeByTimestamp, bool useCompression,
+                                    bool useHeaderIndexFile, unsigned int chunkSize, const TrackedFrameListOperation& editGlobalFields, const TrackedFrameListOperation& editFrames)
+{
+  // Open the input files, only the headers are read at this point
+  vtkSmartPointer<vtkPlusTrackedFrameList> chunkFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  TrackedFrameStream frameStream(chunkSize, mergeByTimestamp, incrementTimestamps);
+  unsigned int numberOfInputFrames = 0;
+  for (std::vector<std::string>::const_iterator inputFileName = inputFileNames.begin(); inputFileName != inputFileNames.end(); ++inputFileName)
+  {
+    LOG_INFO("Open input sequence file: " << (*inputFileName));
+    if (!vtksys::SystemTools::FileExists(inputFileName->c_str()))
+    {
+      LOG_ERROR("File: " << (*inputFileName) << " does not exist.");
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkPlusSequenceIOBase> reader = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(*inputFileName));
+    if (reader == NULL)
+    {
+      return PLUS_FAIL;
+    }
+    reader->SetFileName(*inputFileName);
+    vtkPlusMetaImageSequenceIO* metaImageReader = vtkPlusMetaImageSequenceIO::SafeDownCast(reader);
+    if (metaImageReader != NULL)
+    {
+      metaImageReader->SetUseHeaderIndexFile(useHeaderIndexFile);
+    }
+    if (reader->OpenForStreamedRead() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Couldn't read sequence file: " << (*inputFileName));
+      return PLUS_FAIL;
+    }
+    numberOfInputFrames += reader->GetNumberOfRemainingStreamedFrames();
+    if (inputFileName == inputFileNames.begin())
+    {
+      // Global fields of the output are taken from the first input file
+      CopyGlobalFields(reader->GetTrackedFrameList(), chunkFrameList);
+    }
+    frameStream.AddInput(reader);
+  }
+  if (numberOfInputFrames == 0)
+  {
+    LOG_ERROR("No frames found in the input sequence files");
+    return PLUS_FAIL;
+  }
 
+  // Trimming and decimation only determine which frames are kept, so they are performed while the frames are read
+  unsigned int firstKeptFrameIndex = 0;
+  unsigned int lastKeptFrameIndex = numberOfInputFrames - 1;
+  unsigned int keptFrameIndexIncrement = 1;
+  if (operation == TRIM)
+  {
+    firstKeptFrameIndex = static_cast<unsigned int>(std::max(firstFrameIndex, 0));
+    lastKeptFrameIndex = static_cast<unsigned int>(std::max(lastFrameIndex, 0));
+    LOG_INFO("Trim sequence file from frame #: " << firstKeptFrameIndex << " to frame #" << lastKeptFrameIndex);
+    if (lastKeptFrameIndex >= numberOfInputFrames || firstKeptFrameIndex > lastKeptFrameIndex)
+    {
+      LOG_ERROR("Invalid input range: (" << firstKeptFrameIndex << ", " << lastKeptFrameIndex << ")" << " Permitted range within (0, " << numberOfInputFrames - 1 << ")");
+      return PLUS_FAIL;
+    }
+  }
+  else if (operation == DECIMATE)
+  {
+    LOG_INFO("Decimate sequence file: keep 1 frame out of every " << decimationFactor << " frames");
+    if (decimationFactor < 2)
+    {
+      LOG_ERROR("Invalid decimation factor: " << decimationFactor << ". It must be an integer larger or equal than 2.");
+      return PLUS_FAIL;
+    }
+    keptFrameIndexIncrement = static_cast<unsigned int>(decimationFactor);
+  }
+  unsigned int numberOfOutputFrames = (lastKeptFrameIndex - firstKeptFrameIndex) / keptFrameIndexIncrement + 1;
+
+  // Set up the writer, frames are appended to the output file chunk by chunk
+  vtkSmartPointer<vtkPlusSequenceIOBase> writer = vtkSmartPointer<vtkPlusSequenceIOBase>::Take(vtkPlusSequenceIO::CreateSequenceHandlerForFile(outputFileName));
+  if (writer == NULL)
+  {
+    return PLUS_FAIL;
+  }
+  if (useCompression && vtkPlusMetaImageSequenceIO::CanWriteFile(outputFileName))
+  {
+    // Compressed pixel data cannot be appended to metaimage files
+    LOG_WARNING("Compressed saving of metaimage file is not supported in streaming mode. Reverting to uncompressed output.");
+    useCompression = false;
+  }
+  if (vtksys::SystemTools::FileExists(outputFileName.c_str()))
+  {
+    // Remove the file before replacing it
+    vtksys::SystemTools::RemoveFile(outputFileName.c_str());
+  }
+  writer->SetUseCompression(useCompression);
+  writer->SetEnableImageDataWrite(operation != REMOVE_IMAGE_DATA);
+  writer->SetTrackedFrameList(chunkFrameList);
+  writer->SetFileName(outputFileName);
+  if (numberOfOutputFrames == 1)
+  {
+    writer->IsDataTimeSeriesOff();
+  }
+
+  LOG_INFO("Save output sequence file to: " << outputFileName);
+  bool headerPrepared = false;
+  bool isData3D = false;
+  unsigned int numberOfWrittenFrames = 0;
+  unsigned int inputFrameIndex = 0;
+  bool inputFramesAvailable = true;
+  while (inputFramesAvailable && inputFrameIndex <= lastKeptFrameIndex)
+  {
+    // Read the next chunk of frames
+    chunkFrameList->Clear();
+    while (chunkFrameList->GetNumberOfTrackedFrames() < chunkSize && inputFrameIndex <= lastKeptFrameIndex)
+    {
+      bool keepFrame = (inputFrameIndex >= firstKeptFrameIndex && (inputFrameIndex - firstKeptFrameIndex) % keptFrameIndexIncrement == 0);
+      if (frameStream.ReadNextFrame(keepFrame ? chunkFrameList.GetPointer() : NULL, inputFramesAvailable) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+      if (!inputFramesAvailable)
+      {
+        break;
+      }
+      inputFrameIndex++;
+    }
+    if (chunkFrameList->GetNumberOfTrackedFrames() == 0)
+    {
+      break;
+    }
+
+    // Edit the frames of the chunk in parallel
+    if (editFrames(chunkFrameList) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Write the chunk
+    if (!headerPrepared)
+    {
+      // Global fields are written into the header with the first chunk
+      if (editGlobalFields(chunkFrameList) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+      isData3D = (chunkFrameList->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+      if (writer->PrepareHeader() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Unable to prepare header");
+        return PLUS_FAIL;
+      }
+      headerPrepared = true;
+    }
+    if (writer->AppendImagesToHeader() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to append image data to header.");
+      return PLUS_FAIL;
+    }
+    if (writer->WriteImages() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to append images to file: " << outputFileName);
+      return PLUS_FAIL;
+    }
+    numberOfWrittenFrames += chunkFrameList->GetNumberOfTrackedFrames();
+    LOG_DEBUG("Written " << numberOfWrittenFrames << " of " << numberOfOutputFrames << " frames");
+  }
+  chunkFrameList->Clear();
+
+  if (!headerPrepared)
+  {
+    LOG_ERROR("No frames were written to file: " << outputFileName);
+    return PLUS_FAIL;
+  }
+
+  // Fix the header to contain the correct number of frames
+  writer->UpdateDimensionsCustomStrings(numberOfWrittenFrames, isData3D);
+  writer->UpdateFieldInImageHeader(writer->GetDimensionSizeString());
+  writer->UpdateFieldInImageHeader(writer->GetDimensionKindsString());
+  if (writer->FinalizeHeader() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to finalize the header.");
+    return PLUS_FAIL;
+  }
+  if (writer->Close() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Couldn't write sequence file: " << outputFileName);
+    return PLUS_FAIL;
+  }
+
+  LOG_INFO("Number of frames written: " << numberOfWrittenFrames << " (chunk size: " << chunkSize << " frames)");
+  return PLUS_SUCCESS;
+}
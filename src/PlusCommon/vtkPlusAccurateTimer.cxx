@@ -12,6 +12,10 @@
 #include <sstream>
 #include <time.h>
 
+#ifdef __linux__
+#include <errno.h>
+#endif
+
 #ifdef _WIN32
 #include "WindowsAccurateTimer.h"
 WindowsAccurateTimer WindowsAccurateTimer::m_Instance;
@@ -20,6 +24,8 @@ WindowsAccurateTimer WindowsAccurateTimer::m_Instance;
 
 double vtkPlusAccurateTimer::SystemStartTime = 0;
 double vtkPlusAccurateTimer::UniversalStartTime = 0;
+std::atomic<bool> vtkPlusAccurateTimer::VirtualClockEnabled(false);
+std::atomic<double> vtkPlusAccurateTimer::VirtualTime(0.0);
 
 //----------------------------------------------------------------------------
 vtkInstantiatorNewMacro(vtkPlusAccurateTimer);
@@ -124,10 +130,55 @@ void vtkPlusAccurateTimer::Delay(double sec)
 #endif
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusAccurateTimer::DelayUntil(double systemTime)
+{
+  if (vtkPlusAccurateTimer::VirtualClockEnabled.load())
+  {
+    // Virtual time does not advance by waiting
+    return;
+  }
+#if defined(__linux__) && !defined(PLUS_USE_SIMPLE_TIMER)
+  // Internal system time is derived from the wall clock (see GetInternalSystemTime), which may be adjusted while sleeping.
+  // Convert the remaining time to an absolute time of the monotonic clock once and sleep until that.
+  const double remainingSec = systemTime - vtkPlusAccurateTimer::GetSystemTime();
+  if (remainingSec <= 0)
+  {
+    return;
+  }
+  struct timespec wakeupTime;
+  if (clock_gettime(CLOCK_MONOTONIC, &wakeupTime) != 0)
+  {
+    vtkPlusAccurateTimer::Delay(remainingSec);
+    return;
+  }
+  const double remainingWholeSec = floor(remainingSec);
+  wakeupTime.tv_sec += static_cast<time_t>(remainingWholeSec);
+  wakeupTime.tv_nsec += static_cast<long>((remainingSec - remainingWholeSec) * 1e9);
+  if (wakeupTime.tv_nsec >= 1000000000L)
+  {
+    wakeupTime.tv_sec += 1;
+    wakeupTime.tv_nsec -= 1000000000L;
+  }
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeupTime, NULL) == EINTR)
+  {
+    // Interrupted by a signal, continue waiting until the same absolute time
+  }
+#else
+  double delaySec = systemTime - vtkPlusAccurateTimer::GetSystemTime();
+  if (delaySec > 0)
+  {
+    vtkPlusAccurateTimer::Delay(delaySec);
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------
 void vtkPlusAccurateTimer::DelayWithEventProcessing(double waitTimeSec)
 {
 #ifdef _WIN32
-  double waitStartTime = vtkPlusAccurateTimer::GetSystemTime();
+  // Use the internal system time, as the virtual clock may not advance while waiting
+  double waitStartTime = vtkPlusAccurateTimer::GetInternalSystemTime();
   const double commandQueuePollIntervalSec = 0.010;
   do
   {
@@ -140,7 +191,7 @@ void vtkPlusAccurateTimer::DelayWithEventProcessing(double waitTimeSec)
     }
     Sleep(commandQueuePollIntervalSec * 1000); // give a chance to other threads to get CPU time now
   }
-  while (vtkPlusAccurateTimer::GetSystemTime() - waitStartTime < waitTimeSec);
+  while (vtkPlusAccurateTimer::GetInternalSystemTime() - waitStartTime < waitTimeSec);
 #else
   usleep(waitTimeSec * 1000000);
 #endif
@@ -159,13 +210,52 @@ double vtkPlusAccurateTimer::GetInternalSystemTime()
 //----------------------------------------------------------------------------
 double vtkPlusAccurateTimer::GetSystemTime()
 {
+  if (vtkPlusAccurateTimer::VirtualClockEnabled.load())
+  {
+    return vtkPlusAccurateTimer::VirtualTime.load();
+  }
   return (vtkPlusAccurateTimer::GetInternalSystemTime() - vtkPlusAccurateTimer::SystemStartTime);
 }
 
 //----------------------------------------------------------------------------
 double vtkPlusAccurateTimer::GetUniversalTime()
 {
-  return vtkPlusAccurateTimer::UniversalStartTime + (vtkPlusAccurateTimer::GetInternalSystemTime() - vtkPlusAccurateTimer::SystemStartTime);
+  return vtkPlusAccurateTimer::UniversalStartTime + vtkPlusAccurateTimer::GetSystemTime();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusAccurateTimer::SetVirtualClockEnabled(bool enabled)
+{
+  if (vtkPlusAccurateTimer::VirtualClockEnabled.load() == enabled)
+  {
+    return;
+  }
+  if (enabled)
+  {
+    // Continue from the current time, until the virtual time is set explicitly.
+    // The time is stored before the clock is enabled, so other threads never read a stale virtual time.
+    vtkPlusAccurateTimer::VirtualTime.store(vtkPlusAccurateTimer::GetSystemTime());
+  }
+  vtkPlusAccurateTimer::VirtualClockEnabled.store(enabled);
+  LOG_DEBUG("Virtual clock " << (enabled ? "enabled" : "disabled"));
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusAccurateTimer::IsVirtualClockEnabled()
+{
+  return vtkPlusAccurateTimer::VirtualClockEnabled.load();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusAccurateTimer::SetVirtualTime(double systemTime)
+{
+  vtkPlusAccurateTimer::VirtualTime.store(systemTime);
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusAccurateTimer::GetVirtualTime()
+{
+  return vtkPlusAccurateTimer::VirtualTime.load();
 }
 
 //----------------------------------------------------------------------------
@@ -11,6 +11,8 @@
 
 #include "vtkObject.h"
 
+#include <atomic>
+
 //----------------------------------------------------------------------------
 /*!
   \class vtkPlusAccurateTimerCleanup
@@ -62,6 +64,15 @@ public:
   /*! Wait until specified time in seconds */
   static void Delay(double sec);
 
+  /*!
+    Wait until the specified system time (in seconds).
+    On Linux the thread sleeps until an absolute time of the monotonic clock (clock_nanosleep with CLOCK_MONOTONIC),
+    so the wakeup time does not depend on how long it took to go to sleep and is not affected by adjustments of the wall clock.
+    On other platforms the remaining time is waited using Delay.
+    Returns immediately if the time has already passed or the virtual clock is enabled.
+  */
+  static void DelayUntil(double systemTime);
+
   /*!
     Wait until specified time in seconds. Pending events are processed while waiting.
     Certain devices (e.g., VideoForWindows video source) may be blocked on other threads if events are not processed.
@@ -101,6 +112,27 @@ public:
   */
   static double GetSystemTimeFromUniversalTime(double utcTime);
 
+  /*!
+    Enable or disable the virtual clock.
+    While the virtual clock is enabled, system and universal times are computed from the virtual time,
+    which only changes when it is set by SetVirtualTime. This allows replaying a device set in lock-step
+    with simulated time, as fast as possible and with reproducible timestamps.
+    Delay methods still wait in real time, as they are used for synchronization between threads.
+  */
+  static void SetVirtualClockEnabled(bool enabled);
+
+  /*! Returns true if system time is provided by the virtual clock */
+  static bool IsVirtualClockEnabled();
+
+  /*!
+    Set the current time of the virtual clock. It should be only called by the thread that drives the virtual clock.
+    \param systemTime system time in seconds
+  */
+  static void SetVirtualTime(double systemTime);
+
+  /*! Get the current time of the virtual clock, in seconds */
+  static double GetVirtualTime();
+
   /*!
     Get current date in string
     \return Format: MMDDYY
@@ -145,6 +177,12 @@ private:
   /*! Universal time (time elapsed since 00:00:00 January 1, 1970, UTC) at the time of class instantiation, in seconds */
   static double UniversalStartTime;
 
+  /*! If enabled then system time is provided by the virtual clock. Atomic, as it is read by all acquisition threads. */
+  static std::atomic<bool> VirtualClockEnabled;
+
+  /*! Current system time of the virtual clock, in seconds. Atomic, as it is set by the clock thread and read by all acquisition threads. */
+  static std::atomic<double> VirtualTime;
+
   /*! The singleton instance */
   static vtkPlusAccurateTimer* Instance;
 
@@ -0,0 +1,360 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+
+#include "PlusTrackedFrame.h"
+#include "vtkPlusColumnarTrackedFrameList.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusTransformRepository.h"
+
+#include "vtkMatrix4x4.h"
+#include "vtkObjectFactory.h"
+
+#include <string.h>
+
+namespace
+{
+  const double IDENTITY_MATRIX[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+}
+
+//----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusColumnarTrackedFrameList);
+
+//----------------------------------------------------------------------------
+vtkPlusColumnarTrackedFrameList::vtkPlusColumnarTrackedFrameList()
+  : NumberOfFrameTransformColumns(0)
+  , FrameSizeInBytes(0)
+  , PixelType(VTK_VOID)
+  , NumberOfScalarComponents(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusColumnarTrackedFrameList::~vtkPlusColumnarTrackedFrameList()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusColumnarTrackedFrameList::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfFrames: " << this->GetNumberOfFrames() << std::endl;
+  os << indent << "TransformColumns:";
+  for (std::vector<TransformColumn>::iterator columnIt = this->TransformColumns.begin(); columnIt != this->TransformColumns.end(); ++columnIt)
+  {
+    os << " " << columnIt->Name.GetTransformName();
+  }
+  os << std::endl;
+  os << indent << "HasPixelData: " << (this->HasPixelData() ? "true" : "false") << std::endl;
+  os << indent << "FrameSizeInBytes: " << this->FrameSizeInBytes << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusColumnarTrackedFrameList::Clear()
+{
+  this->Timestamps.clear();
+  this->FrameSizes.clear();
+  this->TransformColumns.clear();
+  this->TransformColumnIndices.clear();
+  this->NumberOfFrameTransformColumns = 0;
+  std::vector<unsigned char>().swap(this->PixelData);
+  this->FrameSizeInBytes = 0;
+  this->PixelType = VTK_VOID;
+  this->NumberOfScalarComponents = 0;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusColumnarTrackedFrameList::BuildFromTrackedFrameList(vtkPlusTrackedFrameList* trackedFrameList, bool copyPixelData /*=true*/)
+{
+  this->Clear();
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Failed to build columnar tracked frame list - input frame list is NULL");
+    return PLUS_FAIL;
+  }
+
+  const unsigned int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  this->Timestamps.resize(numberOfFrames);
+  this->FrameSizes.resize(3 * numberOfFrames);
+
+  std::vector<PlusTransformName> transformNames;
+  double matrix[16] = {0};
+  for (unsigned int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    PlusTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameIndex);
+    this->Timestamps[frameIndex] = trackedFrame->GetTimestamp();
+    if (trackedFrame->GetImageData()->IsImageValid())
+    {
+      trackedFrame->GetFrameSize(&this->FrameSizes[3 * frameIndex]);
+    }
+    else
+    {
+      this->FrameSizes[3 * frameIndex] = this->FrameSizes[3 * frameIndex + 1] = this->FrameSizes[3 * frameIndex + 2] = 0;
+    }
+
+    transformNames.clear();
+    trackedFrame->GetCustomFrameTransformNameList(transformNames);
+    for (std::vector<PlusTransformName>::iterator nameIt = transformNames.begin(); nameIt != transformNames.end(); ++nameIt)
+    {
+      if (trackedFrame->GetCustomFrameTransform(*nameIt, matrix) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to get frame transform " << nameIt->GetTransformName() << " of frame " << frameIndex);
+        continue;
+      }
+      TrackedFrameFieldStatus status = FIELD_INVALID;
+      trackedFrame->GetCustomFrameTransformStatus(*nameIt, status);
+
+      int columnIndex = this->GetTransformColumnIndex(*nameIt);
+      TransformColumn& column = (columnIndex >= 0 ? this->TransformColumns[columnIndex] : this->AddTransformColumn(*nameIt));
+      memcpy(&column.Matrices[16 * frameIndex], matrix, sizeof(matrix));
+      column.ValidFlags[frameIndex] = (status == FIELD_OK ? 1 : 0);
+    }
+  }
+
+  this->NumberOfFrameTransformColumns = this->GetNumberOfTransformColumns();
+
+  if (copyPixelData && numberOfFrames > 0 && !this->BuildPixelData(trackedFrameList))
+  {
+    LOG_WARNING("Pixel data is not stored in the columnar tracked frame list: frames have different size or pixel type");
+  }
+
+  this->Modified();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusColumnarTrackedFrameList::BuildFromSequenceFile(const std::string& fileName, bool copyPixelData /*=true*/)
+{
+  vtkSmartPointer<vtkPlusTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(fileName, trackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to build columnar tracked frame list - cannot read sequence file: " << fileName);
+    this->Clear();
+    return PLUS_FAIL;
+  }
+  return this->BuildFromTrackedFrameList(trackedFrameList, copyPixelData);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusColumnarTrackedFrameList::BuildPixelData(vtkPlusTrackedFrameList* trackedFrameList)
+{
+  const unsigned int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  PlusVideoFrame* firstImage = trackedFrameList->GetTrackedFrame(0)->GetImageData();
+  if (!firstImage->IsImageValid())
+  {
+    return false;
+  }
+  const PlusCommon::VTKScalarPixelType pixelType = firstImage->GetVTKScalarPixelType();
+  const int numberOfScalarComponents = firstImage->GetNumberOfScalarComponents();
+  const vtkIdType frameSizeInBytes = firstImage->GetFrameSizeInBytes();
+  for (unsigned int frameIndex = 1; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    PlusVideoFrame* image = trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData();
+    if (!image->IsImageValid()
+        || image->GetVTKScalarPixelType() != pixelType
+        || image->GetNumberOfScalarComponents() != numberOfScalarComponents
+        || memcmp(&this->FrameSizes[3 * frameIndex], &this->FrameSizes[0], 3 * sizeof(unsigned int)) != 0)
+    {
+      return false;
+    }
+  }
+
+  this->PixelData.resize(static_cast<size_t>(frameSizeInBytes) * numberOfFrames);
+  for (unsigned int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    memcpy(&this->PixelData[static_cast<size_t>(frameSizeInBytes) * frameIndex], trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetScalarPointer(), frameSizeInBytes);
+  }
+  this->FrameSizeInBytes = frameSizeInBytes;
+  this->PixelType = pixelType;
+  this->NumberOfScalarComponents = numberOfScalarComponents;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusColumnarTrackedFrameList::TransformColumn& vtkPlusColumnarTrackedFrameList::AddTransformColumn(const PlusTransformName& transformName)
+{
+  const int numberOfFrames = this->GetNumberOfFrames();
+  this->TransformColumnIndices[transformName.GetTransformName()] = static_cast<int>(this->TransformColumns.size());
+  this->TransformColumns.push_back(TransformColumn());
+  TransformColumn& column = this->TransformColumns.back();
+  column.Name = transformName;
+  column.Matrices.resize(16 * numberOfFrames);
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    memcpy(&column.Matrices[16 * frameIndex], IDENTITY_MATRIX, sizeof(IDENTITY_MATRIX));
+  }
+  column.ValidFlags.resize(numberOfFrames, 0);
+  return column;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusColumnarTrackedFrameList::AddComputedTransformColumn(const PlusTransformName& transformName, vtkPlusTransformRepository* transformRepository)
+{
+  if (this->GetTransformColumnIndex(transformName) >= 0)
+  {
+    // already available
+    return PLUS_SUCCESS;
+  }
+  if (transformRepository == NULL)
+  {
+    LOG_ERROR("Failed to add computed transform column " << transformName.GetTransformName() << " - transform repository is NULL");
+    return PLUS_FAIL;
+  }
+
+  // Only the transforms that are stored in the frames are used as input
+  const int numberOfFrameTransformColumns = this->NumberOfFrameTransformColumns;
+  this->AddTransformColumn(transformName);
+  TransformColumn& computedColumn = this->TransformColumns.back();
+
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  int numberOfFailedFrames = 0;
+  for (int frameIndex = 0; frameIndex < this->GetNumberOfFrames(); ++frameIndex)
+  {
+    for (int columnIndex = 0; columnIndex < numberOfFrameTransformColumns; ++columnIndex)
+    {
+      const TransformColumn& frameTransformColumn = this->TransformColumns[columnIndex];
+      if (frameTransformColumn.Name.From() == frameTransformColumn.Name.To())
+      {
+        continue;
+      }
+      matrix->DeepCopy(&frameTransformColumn.Matrices[16 * frameIndex]);
+      transformRepository->SetTransform(frameTransformColumn.Name, matrix, frameTransformColumn.ValidFlags[frameIndex] != 0);
+    }
+
+    bool isValid = false;
+    if (transformRepository->GetTransform(transformName, matrix, &isValid) != PLUS_SUCCESS)
+    {
+      ++numberOfFailedFrames;
+      continue;
+    }
+    for (int row = 0; row < 4; ++row)
+    {
+      for (int col = 0; col < 4; ++col)
+      {
+        computedColumn.Matrices[16 * frameIndex + 4 * row + col] = matrix->GetElement(row, col);
+      }
+    }
+    computedColumn.ValidFlags[frameIndex] = (isValid ? 1 : 0);
+  }
+
+  if (numberOfFailedFrames > 0)
+  {
+    LOG_WARNING("Failed to compute transform " << transformName.GetTransformName() << " for " << numberOfFailedFrames << " out of " << this->GetNumberOfFrames() << " frames");
+  }
+
+  this->Modified();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusColumnarTrackedFrameList::GetNumberOfFrames() const
+{
+  return static_cast<int>(this->Timestamps.size());
+}
+
+//----------------------------------------------------------------------------
+const double* vtkPlusColumnarTrackedFrameList::GetTimestamps() const
+{
+  return this->Timestamps.empty() ? NULL : &this->Timestamps[0];
+}
+
+//----------------------------------------------------------------------------
+const unsigned int* vtkPlusColumnarTrackedFrameList::GetFrameSizes() const
+{
+  return this->FrameSizes.empty() ? NULL : &this->FrameSizes[0];
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusColumnarTrackedFrameList::GetNumberOfTransformColumns() const
+{
+  return static_cast<int>(this->TransformColumns.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusColumnarTrackedFrameList::GetTransformColumnIndex(const PlusTransformName& transformName) const
+{
+  std::map<std::string, int>::const_iterator indexIt = this->TransformColumnIndices.find(transformName.GetTransformName());
+  if (indexIt == this->TransformColumnIndices.end())
+  {
+    return -1;
+  }
+  return indexIt->second;
+}
+
+//----------------------------------------------------------------------------
+PlusTransformName vtkPlusColumnarTrackedFrameList::GetTransformColumnName(int columnIndex) const
+{
+  if (columnIndex < 0 || columnIndex >= this->GetNumberOfTransformColumns())
+  {
+    LOG_ERROR("Invalid transform column index: " << columnIndex);
+    return PlusTransformName();
+  }
+  return this->TransformColumns[columnIndex].Name;
+}
+
+//----------------------------------------------------------------------------
+const double* vtkPlusColumnarTrackedFrameList::GetTransformMatrices(int columnIndex) const
+{
+  if (columnIndex < 0 || columnIndex >= this->GetNumberOfTransformColumns() || this->TransformColumns[columnIndex].Matrices.empty())
+  {
+    return NULL;
+  }
+  return &this->TransformColumns[columnIndex].Matrices[0];
+}
+
+//----------------------------------------------------------------------------
+const unsigned char* vtkPlusColumnarTrackedFrameList::GetTransformValidFlags(int columnIndex) const
+{
+  if (columnIndex < 0 || columnIndex >= this->GetNumberOfTransformColumns() || this->TransformColumns[columnIndex].ValidFlags.empty())
+  {
+    return NULL;
+  }
+  return &this->TransformColumns[columnIndex].ValidFlags[0];
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusColumnarTrackedFrameList::HasPixelData() const
+{
+  return !this->PixelData.empty();
+}
+
+//----------------------------------------------------------------------------
+const void* vtkPlusColumnarTrackedFrameList::GetPixelData() const
+{
+  return this->PixelData.empty() ? NULL : &this->PixelData[0];
+}
+
+//----------------------------------------------------------------------------
+const void* vtkPlusColumnarTrackedFrameList::GetFramePixelData(int frameIndex) const
+{
+  if (this->PixelData.empty() || frameIndex < 0 || frameIndex >= this->GetNumberOfFrames())
+  {
+    return NULL;
+  }
+  return &this->PixelData[static_cast<size_t>(this->FrameSizeInBytes) * frameIndex];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkPlusColumnarTrackedFrameList::GetFrameSizeInBytes() const
+{
+  return this->FrameSizeInBytes;
+}
+
+//----------------------------------------------------------------------------
+PlusCommon::VTKScalarPixelType vtkPlusColumnarTrackedFrameList::GetPixelType() const
+{
+  return this->PixelType;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusColumnarTrackedFrameList::GetNumberOfScalarComponents() const
+{
+  return this->NumberOfScalarComponents;
+}
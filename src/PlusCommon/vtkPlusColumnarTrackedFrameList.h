@@ -0,0 +1,145 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusColumnarTrackedFrameList_h
+#define __vtkPlusColumnarTrackedFrameList_h
+
+#include "vtkPlusCommonExport.h"
+#include "PlusCommon.h"
+
+#include "vtkObject.h"
+
+#include <map>
+#include <vector>
+
+class vtkPlusTrackedFrameList;
+class vtkPlusTransformRepository;
+
+/*!
+  \class vtkPlusColumnarTrackedFrameList
+  \brief Column-wise copy of the contents of a tracked frame list for fast sequential processing
+
+  Timestamps, frame sizes, transforms and pixel data of all frames are stored in contiguous arrays:
+  \li timestamps: one value per frame
+  \li frame sizes: three values (x, y, z) per frame
+  \li transforms: one column per transform name, 16 values (4x4 matrix, row-major) and one validity flag per frame
+  \li pixel data: frames one after the other in a single buffer (only if all frames have the same size and pixel type)
+
+  The columns are built once from a tracked frame list or a sequence file, so that algorithms that process
+  the same transform or timestamp of many frames do not need to parse the string fields of each frame.
+  Transforms that are not stored in the frames (e.g., ImageToReference) can be added as computed columns.
+  The columns are not updated when the source frame list is modified.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport vtkPlusColumnarTrackedFrameList : public vtkObject
+{
+public:
+  static vtkPlusColumnarTrackedFrameList* New();
+  vtkTypeMacro(vtkPlusColumnarTrackedFrameList, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*!
+    Build the columns from a tracked frame list. All frame transforms are stored.
+    \param copyPixelData If false then the pixel data is not copied (only frame sizes are stored)
+  */
+  PlusStatus BuildFromTrackedFrameList(vtkPlusTrackedFrameList* trackedFrameList, bool copyPixelData = true);
+
+  /*! Build the columns from a sequence file */
+  PlusStatus BuildFromSequenceFile(const std::string& fileName, bool copyPixelData = true);
+
+  /*! Remove all data */
+  void Clear();
+
+  /*!
+    Add a column that contains a transform computed from the frame transforms of each frame and
+    the persistent transforms of the transform repository (e.g., ImageToReference). Nothing is done if the column already exists.
+    The frame transforms of the last frame remain set in the transform repository.
+  */
+  PlusStatus AddComputedTransformColumn(const PlusTransformName& transformName, vtkPlusTransformRepository* transformRepository);
+
+  /*! Get the number of frames */
+  int GetNumberOfFrames() const;
+
+  /*! Get the timestamps of all frames */
+  const double* GetTimestamps() const;
+
+  /*! Get the frame sizes of all frames (three values per frame) */
+  const unsigned int* GetFrameSizes() const;
+
+  /*! Get the number of transform columns */
+  int GetNumberOfTransformColumns() const;
+
+  /*! Get the index of a transform column. Returns -1 if there is no column for the transform. */
+  int GetTransformColumnIndex(const PlusTransformName& transformName) const;
+
+  /*! Get the name of the transform stored in a column */
+  PlusTransformName GetTransformColumnName(int columnIndex) const;
+
+  /*!
+    Get the transform matrices stored in a column (16 values per frame, row-major).
+    The identity matrix is stored for frames that do not have the transform.
+    Returns NULL if the column index is invalid.
+  */
+  const double* GetTransformMatrices(int columnIndex) const;
+
+  /*! Get the transform validity flags stored in a column (one value per frame, 1 if the transform is valid). Returns NULL if the column index is invalid. */
+  const unsigned char* GetTransformValidFlags(int columnIndex) const;
+
+  /*! Returns true if the pixel data of the frames are stored */
+  bool HasPixelData() const;
+
+  /*! Get the pixel data of all frames (frames are stored one after the other). Returns NULL if the pixel data is not stored. */
+  const void* GetPixelData() const;
+
+  /*! Get the pixel data of a frame. Returns NULL if the pixel data is not stored or the frame index is invalid. */
+  const void* GetFramePixelData(int frameIndex) const;
+
+  /*! Get the size of the pixel data of a single frame */
+  vtkIdType GetFrameSizeInBytes() const;
+
+  /*! Get the pixel type of the stored pixel data */
+  PlusCommon::VTKScalarPixelType GetPixelType() const;
+
+  /*! Get the number of scalar components of the stored pixel data */
+  int GetNumberOfScalarComponents() const;
+
+protected:
+  vtkPlusColumnarTrackedFrameList();
+  virtual ~vtkPlusColumnarTrackedFrameList();
+
+  /*! Copy pixel data of all frames into a single buffer. Returns false if the frames cannot be stored in a single buffer. */
+  bool BuildPixelData(vtkPlusTrackedFrameList* trackedFrameList);
+
+  struct TransformColumn
+  {
+    PlusTransformName Name;
+    std::vector<double> Matrices;
+    std::vector<unsigned char> ValidFlags;
+  };
+
+  /*! Add a new column, all transforms are initialized to invalid identity */
+  TransformColumn& AddTransformColumn(const PlusTransformName& transformName);
+
+  std::vector<double> Timestamps;
+  std::vector<unsigned int> FrameSizes;
+  std::vector<TransformColumn> TransformColumns;
+  /*! Maps transform names to column indices */
+  std::map<std::string, int> TransformColumnIndices;
+  /*! Transform columns that are read from the frames are stored first, followed by the computed transform columns */
+  int NumberOfFrameTransformColumns;
+
+  std::vector<unsigned char> PixelData;
+  vtkIdType FrameSizeInBytes;
+  PlusCommon::VTKScalarPixelType PixelType;
+  int NumberOfScalarComponents;
+
+private:
+  vtkPlusColumnarTrackedFrameList(const vtkPlusColumnarTrackedFrameList&);  // Not implemented.
+  void operator=(const vtkPlusColumnarTrackedFrameList&);  // Not implemented.
+};
+
+#endif
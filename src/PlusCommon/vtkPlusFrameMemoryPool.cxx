@@ -0,0 +1,323 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+
+#include "vtkPlusFrameMemoryPool.h"
+#include "vtkPlusRecursiveCriticalSection.h"
+
+#include "vtkDataArray.h"
+#include "vtkImageData.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+// Data arrays can only return their buffer to the pool if a custom free function can be set
+#if VTK_MAJOR_VERSION >= 8
+#define PLUS_FRAME_MEMORY_POOL_IMAGE_SUPPORT
+#endif
+
+namespace
+{
+  const size_t CACHE_LINE_SIZE_BYTES = 64;
+  const size_t PAGE_SIZE_BYTES = 4096;
+  const vtkTypeUInt64 DEFAULT_MAXIMUM_CACHED_SIZE_BYTES = 256 * 1024 * 1024;
+}
+
+//----------------------------------------------------------------------------
+// Stored right before the buffer that is handed out, within the alignment padding
+struct vtkPlusFrameMemoryPool::BufferHeader
+{
+  vtkPlusFrameMemoryPool* Pool;
+  void* MemoryBlock;
+  size_t SizeClassBytes;
+};
+
+//----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusFrameMemoryPool);
+
+//----------------------------------------------------------------------------
+vtkPlusFrameMemoryPool::vtkPlusFrameMemoryPool()
+  : MaximumCachedSizeBytes(DEFAULT_MAXIMUM_CACHED_SIZE_BYTES)
+  , CachedSizeBytes(0)
+  , NumberOfHeapAllocations(0)
+  , NumberOfReusedBuffers(0)
+  , NumberOfBuffersInUse(0)
+  , PoolMutex(vtkPlusRecursiveCriticalSection::New())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusFrameMemoryPool::~vtkPlusFrameMemoryPool()
+{
+  // Buffers that are in use keep a reference to the pool, so only cached buffers are left here
+  this->ReleaseCachedBuffers();
+  this->PoolMutex->Delete();
+  this->PoolMutex = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  os << indent << "MaximumCachedSizeBytes: " << this->MaximumCachedSizeBytes << std::endl;
+  os << indent << "CachedSizeBytes: " << this->CachedSizeBytes << std::endl;
+  os << indent << "NumberOfHeapAllocations: " << this->NumberOfHeapAllocations << std::endl;
+  os << indent << "NumberOfReusedBuffers: " << this->NumberOfReusedBuffers << std::endl;
+  os << indent << "NumberOfBuffersInUse: " << this->NumberOfBuffersInUse << std::endl;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusFrameMemoryPool::IsPooledImageAllocationSupported()
+{
+#ifdef PLUS_FRAME_MEMORY_POOL_IMAGE_SUPPORT
+  return true;
+#else
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+size_t vtkPlusFrameMemoryPool::GetSizeClassBytes(size_t numberOfBytes)
+{
+  if (numberOfBytes <= 4 * CACHE_LINE_SIZE_BYTES)
+  {
+    // Small buffers: multiples of the cache line size
+    return ((numberOfBytes + CACHE_LINE_SIZE_BYTES - 1) / CACHE_LINE_SIZE_BYTES) * CACHE_LINE_SIZE_BYTES;
+  }
+  // Each power of two is divided into four size classes, so at most 25% of the buffer is unused
+  size_t highestPowerOfTwo = 1;
+  while (highestPowerOfTwo <= numberOfBytes / 2)
+  {
+    highestPowerOfTwo *= 2;
+  }
+  const size_t step = highestPowerOfTwo / 4;
+  return ((numberOfBytes + step - 1) / step) * step;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusFrameMemoryPool::AcquireBuffer(size_t numberOfBytes)
+{
+  const size_t sizeClassBytes = GetSizeClassBytes(numberOfBytes > 0 ? numberOfBytes : 1);
+  BufferHeader* header = NULL;
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+    std::map<size_t, std::vector<BufferHeader*> >::iterator cachedBuffersIt = this->CachedBuffers.find(sizeClassBytes);
+    if (cachedBuffersIt != this->CachedBuffers.end() && !cachedBuffersIt->second.empty())
+    {
+      header = cachedBuffersIt->second.back();
+      cachedBuffersIt->second.pop_back();
+      this->CachedSizeBytes -= sizeClassBytes;
+      ++this->NumberOfReusedBuffers;
+    }
+    else
+    {
+      ++this->NumberOfHeapAllocations;
+    }
+    ++this->NumberOfBuffersInUse;
+  }
+
+  if (header == NULL)
+  {
+    // The header is stored in the padding before the aligned buffer
+    const size_t alignment = (sizeClassBytes >= PAGE_SIZE_BYTES ? PAGE_SIZE_BYTES : CACHE_LINE_SIZE_BYTES);
+    void* memoryBlock = malloc(sizeClassBytes + alignment + sizeof(BufferHeader));
+    if (memoryBlock == NULL)
+    {
+      LOG_ERROR("Failed to allocate " << sizeClassBytes << " bytes for a frame buffer");
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+      --this->NumberOfHeapAllocations;
+      --this->NumberOfBuffersInUse;
+      return NULL;
+    }
+    size_t bufferAddress = reinterpret_cast<size_t>(memoryBlock) + sizeof(BufferHeader);
+    bufferAddress = ((bufferAddress + alignment - 1) / alignment) * alignment;
+    header = reinterpret_cast<BufferHeader*>(bufferAddress) - 1;
+    header->MemoryBlock = memoryBlock;
+    header->SizeClassBytes = sizeClassBytes;
+  }
+
+  header->Pool = this;
+  this->Register(NULL);
+  return header + 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::ReleaseBuffer(void* buffer)
+{
+  if (buffer == NULL)
+  {
+    return;
+  }
+  BufferHeader* header = static_cast<BufferHeader*>(buffer) - 1;
+  vtkPlusFrameMemoryPool* pool = header->Pool;
+  pool->ReturnBuffer(header);
+  // May delete the pool if this was the last reference
+  pool->UnRegister(NULL);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::ReturnBuffer(BufferHeader* header)
+{
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+    --this->NumberOfBuffersInUse;
+    if (this->CachedSizeBytes + header->SizeClassBytes <= this->MaximumCachedSizeBytes)
+    {
+      this->CachedBuffers[header->SizeClassBytes].push_back(header);
+      this->CachedSizeBytes += header->SizeClassBytes;
+      return;
+    }
+  }
+  FreeBuffer(header);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::FreeBuffer(BufferHeader* header)
+{
+  free(header->MemoryBlock);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::ReleaseCachedBuffers()
+{
+  std::map<size_t, std::vector<BufferHeader*> > buffersToFree;
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+    buffersToFree.swap(this->CachedBuffers);
+    this->CachedSizeBytes = 0;
+  }
+  for (std::map<size_t, std::vector<BufferHeader*> >::iterator sizeClassIt = buffersToFree.begin(); sizeClassIt != buffersToFree.end(); ++sizeClassIt)
+  {
+    for (std::vector<BufferHeader*>::iterator bufferIt = sizeClassIt->second.begin(); bufferIt != sizeClassIt->second.end(); ++bufferIt)
+    {
+      FreeBuffer(*bufferIt);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusFrameMemoryPool::AllocateScalars(vtkImageData* image, int scalarType, int numberOfScalarComponents)
+{
+  if (image == NULL)
+  {
+    LOG_ERROR("vtkPlusFrameMemoryPool::AllocateScalars failed: image is NULL");
+    return PLUS_FAIL;
+  }
+
+#ifdef PLUS_FRAME_MEMORY_POOL_IMAGE_SUPPORT
+  int* extent = image->GetExtent();
+  vtkIdType numberOfTuples = 1;
+  for (int i = 0; i < 3; ++i)
+  {
+    numberOfTuples *= std::max(extent[2 * i + 1] - extent[2 * i] + 1, 0);
+  }
+  if (numberOfTuples == 0 || numberOfScalarComponents <= 0)
+  {
+    // Nothing to pool
+    image->AllocateScalars(scalarType, numberOfScalarComponents);
+    return PLUS_SUCCESS;
+  }
+
+  // Scalars that are shared with other images (e.g., by a shallow copy) are not reused, as writing
+  // the new frame into them would change the pixels of the other images as well
+  vtkDataArray* existingScalars = image->GetPointData()->GetScalars();
+  if (existingScalars != NULL
+      && existingScalars->GetReferenceCount() == 1
+      && existingScalars->GetDataType() == scalarType
+      && existingScalars->GetNumberOfComponents() == numberOfScalarComponents
+      && existingScalars->GetNumberOfTuples() == numberOfTuples)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  const vtkIdType numberOfValues = numberOfTuples * numberOfScalarComponents;
+  void* buffer = this->AcquireBuffer(static_cast<size_t>(numberOfValues) * vtkDataArray::GetDataTypeSize(scalarType));
+  if (buffer == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  vtkDataArray* scalars = vtkDataArray::CreateDataArray(scalarType);
+  scalars->SetNumberOfComponents(numberOfScalarComponents);
+  scalars->SetVoidArray(buffer, numberOfValues, 0, vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+  scalars->SetArrayFreeFunction(&vtkPlusFrameMemoryPool::ReleaseBuffer);
+  image->GetPointData()->SetScalars(scalars);
+  scalars->Delete();
+#else
+  image->AllocateScalars(scalarType, numberOfScalarComponents);
+#endif
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::SetMaximumCachedSizeBytes(vtkTypeUInt64 maximumCachedSizeBytes)
+{
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+    if (this->MaximumCachedSizeBytes == maximumCachedSizeBytes)
+    {
+      return;
+    }
+    this->MaximumCachedSizeBytes = maximumCachedSizeBytes;
+    if (this->CachedSizeBytes <= this->MaximumCachedSizeBytes)
+    {
+      this->Modified();
+      return;
+    }
+  }
+  // Simply drop all cached buffers, the pool is refilled as frames are released
+  this->ReleaseCachedBuffers();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkPlusFrameMemoryPool::GetMaximumCachedSizeBytes()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  return this->MaximumCachedSizeBytes;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkPlusFrameMemoryPool::GetNumberOfHeapAllocations()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  return this->NumberOfHeapAllocations;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkPlusFrameMemoryPool::GetNumberOfReusedBuffers()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  return this->NumberOfReusedBuffers;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkPlusFrameMemoryPool::GetNumberOfBuffersInUse()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  return this->NumberOfBuffersInUse;
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkPlusFrameMemoryPool::GetCachedSizeBytes()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  return this->CachedSizeBytes;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusFrameMemoryPool::ResetCounters()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> poolGuardedLock(this->PoolMutex);
+  this->NumberOfHeapAllocations = 0;
+  this->NumberOfReusedBuffers = 0;
+}
@@ -0,0 +1,114 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusFrameMemoryPool_h
+#define __vtkPlusFrameMemoryPool_h
+
+#include "vtkPlusCommonExport.h"
+#include "PlusCommon.h"
+
+#include "vtkObject.h"
+
+#include <map>
+#include <vector>
+
+class vtkImageData;
+class vtkPlusRecursiveCriticalSection;
+
+/*!
+  \class vtkPlusFrameMemoryPool
+  \brief Reuses the pixel buffers of video frames to avoid heap allocations during acquisition
+
+  Buffers are grouped into size classes (each power of two is divided into four classes) and
+  a released buffer is kept in the pool until an image with a pixel buffer of the same size class is allocated.
+  Buffers are aligned to the cache line size; buffers that are at least one page large are aligned to the page size.
+
+  The buffers are handed over to vtkImageData objects and are returned to the pool automatically when the
+  image scalars are deleted, therefore a shallow copy of an image keeps its buffer alive. Shallow copies share
+  the pixel data: writing into the pixels of an image changes all its shallow copies. Each buffer that is in use
+  keeps a reference to the pool.
+
+  Pooled image scalars require VTK 8 or later (custom free function of data arrays). With earlier VTK
+  versions AllocateScalars falls back to vtkImageData::AllocateScalars.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport vtkPlusFrameMemoryPool : public vtkObject
+{
+public:
+  static vtkPlusFrameMemoryPool* New();
+  vtkTypeMacro(vtkPlusFrameMemoryPool, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Returns true if image scalars can be allocated from the pool with the VTK version that Plus is built with */
+  static bool IsPooledImageAllocationSupported();
+
+  /*!
+    Allocate the scalars of the image using a buffer from the pool. The image extent must be already set.
+    Existing scalars are kept if their type, number of components and size already match and they are
+    not shared with other objects (for example, shallow copies of the image), otherwise a buffer is taken from the pool.
+  */
+  PlusStatus AllocateScalars(vtkImageData* image, int scalarType, int numberOfScalarComponents);
+
+  /*! Get a buffer of at least the requested size. The buffer must be returned by calling ReleaseBuffer. */
+  void* AcquireBuffer(size_t numberOfBytes);
+
+  /*! Return a buffer to the pool that it was acquired from */
+  static void ReleaseBuffer(void* buffer);
+
+  /*! Free all buffers that are not in use */
+  void ReleaseCachedBuffers();
+
+  /*!
+    Set the maximum total size of buffers that are kept in the pool while they are not used.
+    Released buffers that would exceed this limit are freed.
+  */
+  void SetMaximumCachedSizeBytes(vtkTypeUInt64 maximumCachedSizeBytes);
+  vtkTypeUInt64 GetMaximumCachedSizeBytes();
+
+  /*! Number of buffers that were allocated from the heap (since the last ResetCounters call) */
+  vtkTypeUInt64 GetNumberOfHeapAllocations();
+  /*! Number of buffer requests that were served by reusing a buffer from the pool (since the last ResetCounters call) */
+  vtkTypeUInt64 GetNumberOfReusedBuffers();
+  /*! Number of buffers that are currently in use */
+  vtkTypeUInt64 GetNumberOfBuffersInUse();
+  /*! Total size of the buffers that are currently kept in the pool and not used */
+  vtkTypeUInt64 GetCachedSizeBytes();
+  /*! Reset heap allocation and buffer reuse counters */
+  void ResetCounters();
+
+  /*! Returns the allocated size for a buffer request */
+  static size_t GetSizeClassBytes(size_t numberOfBytes);
+
+protected:
+  vtkPlusFrameMemoryPool();
+  virtual ~vtkPlusFrameMemoryPool();
+
+  struct BufferHeader;
+
+  /*! Put the buffer back into the pool or free it if the cache is full */
+  void ReturnBuffer(BufferHeader* header);
+
+  /*! Free the memory block of a buffer */
+  static void FreeBuffer(BufferHeader* header);
+
+  /*! Released buffers, by size class */
+  std::map<size_t, std::vector<BufferHeader*> > CachedBuffers;
+
+  vtkTypeUInt64 MaximumCachedSizeBytes;
+  vtkTypeUInt64 CachedSizeBytes;
+  vtkTypeUInt64 NumberOfHeapAllocations;
+  vtkTypeUInt64 NumberOfReusedBuffers;
+  vtkTypeUInt64 NumberOfBuffersInUse;
+
+  vtkPlusRecursiveCriticalSection* PoolMutex;
+
+private:
+  vtkPlusFrameMemoryPool(const vtkPlusFrameMemoryPool&);  // Not implemented.
+  void operator=(const vtkPlusFrameMemoryPool&);  // Not implemented.
+};
+
+#endif
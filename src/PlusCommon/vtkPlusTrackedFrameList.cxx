@@ -9,6 +9,7 @@
 #include "PlusMath.h"
 #include "PlusTrackedFrame.h"
 #include "vtkImageData.h"
+#include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkObjectFactory.h"
 #include "vtkPlusMetaImageSequenceIO.h"
@@ -17,6 +18,7 @@
 #include "vtkPlusTransformRepository.h"
 #include "vtkXMLUtilities.h"
 #include "vtksys/SystemTools.hxx"
+#include <algorithm>
 #include <math.h>
 
 //----------------------------------------------------------------------------
@@ -34,7 +36,10 @@ vtkPlusTrackedFrameList::vtkPlusTrackedFrameList()
   this->MaxAllowedTranslationSpeedMmPerSec = 0.0;
   this->MaxAllowedRotationSpeedDegPerSec = 0.0;
   this->ValidationRequirements = 0;
-
+  this->CandidateValidationTransform.TrackedFrame = NULL;
+  this->CandidateValidationTransform.Parsed = false;
+  this->CandidateValidationTransform.Valid = false;
+  this->ValidationIndexUpToDate = true;
 }
 
 //----------------------------------------------------------------------------
@@ -52,6 +57,7 @@ PlusStatus vtkPlusTrackedFrameList::RemoveTrackedFrame(int frameNumber)
     return PLUS_FAIL;
   }
 
+  this->RemoveFrameFromValidationIndex(this->TrackedFrameList[frameNumber]);
   delete this->TrackedFrameList[frameNumber];
   this->TrackedFrameList.erase(this->TrackedFrameList.begin() + frameNumber);
 
@@ -69,6 +75,7 @@ PlusStatus vtkPlusTrackedFrameList::RemoveTrackedFrameRange(unsigned int frameNu
 
   for (unsigned int i = frameNumberFrom; i <= frameNumberTo; ++i)
   {
+    this->RemoveFrameFromValidationIndex(this->TrackedFrameList[i]);
     delete this->TrackedFrameList[i];
   }
 
@@ -89,6 +96,10 @@ void vtkPlusTrackedFrameList::Clear()
     }
   }
   this->TrackedFrameList.clear();
+  this->TimestampIndex.clear();
+  this->ValidationTransformCache.clear();
+  this->CandidateValidationTransform.TrackedFrame = NULL;
+  this->ValidationIndexUpToDate = true;
 }
 
 //----------------------------------------------------------------------------
@@ -103,6 +114,14 @@ void vtkPlusTrackedFrameList::PrintSelf(std::ostream& os, vtkIndent indent)
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::Modified()
+{
+  // the whole index will be rebuilt when it is needed
+  this->ValidationIndexUpToDate = false;
+  this->Superclass::Modified();
+}
+
 //----------------------------------------------------------------------------
 PlusTrackedFrame* vtkPlusTrackedFrameList::GetTrackedFrame(int frameNumber)
 {
@@ -132,7 +151,7 @@ PlusStatus vtkPlusTrackedFrameList::AddTrackedFrameList(vtkPlusTrackedFrameList*
   PlusStatus status = PLUS_SUCCESS;
   for (unsigned int i = 0; i < inTrackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->AddTrackedFrame(inTrackedFrameList->GetTrackedFrame(i), action) != PLUS_SUCCESS)
+    if (this->AddTrackedFrame(inTrackedFrameList->TrackedFrameList[i], action) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to add tracked frame to the list!");
       status = PLUS_FAIL;
@@ -146,6 +165,7 @@ PlusStatus vtkPlusTrackedFrameList::AddTrackedFrameList(vtkPlusTrackedFrameList*
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTrackedFrameList::AddTrackedFrame(PlusTrackedFrame* trackedFrame, InvalidFrameAction action /*=ADD_INVALID_FRAME_AND_REPORT_ERROR*/)
 {
+  this->CandidateValidationTransform.TrackedFrame = NULL;
   bool isFrameValid = true;
   if (action != ADD_INVALID_FRAME)
   {
@@ -174,12 +194,14 @@ PlusStatus vtkPlusTrackedFrameList::AddTrackedFrame(PlusTrackedFrame* trackedFra
   // Make a copy and add frame to the list
   PlusTrackedFrame* pTrackedFrame = new PlusTrackedFrame(*trackedFrame);
   this->TrackedFrameList.push_back(pTrackedFrame);
+  this->AddFrameToValidationIndex(pTrackedFrame, trackedFrame);
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTrackedFrameList::TakeTrackedFrame(PlusTrackedFrame* trackedFrame, InvalidFrameAction action /*=ADD_INVALID_FRAME_AND_REPORT_ERROR*/)
 {
+  this->CandidateValidationTransform.TrackedFrame = NULL;
   bool isFrameValid = true;
   if (action != ADD_INVALID_FRAME)
   {
@@ -208,6 +230,7 @@ PlusStatus vtkPlusTrackedFrameList::TakeTrackedFrame(PlusTrackedFrame* trackedFr
 
   // Make a copy and add frame to the list
   this->TrackedFrameList.push_back(trackedFrame);
+  this->AddFrameToValidationIndex(trackedFrame, trackedFrame);
   return PLUS_SUCCESS;
 }
 
@@ -221,6 +244,9 @@ bool vtkPlusTrackedFrameList::ValidateData(PlusTrackedFrame* trackedFrame)
     return true;
   }
 
+  // The caller may reuse the same frame object with different content, so the transform must be parsed again
+  this->CandidateValidationTransform.TrackedFrame = NULL;
+
   if (this->ValidationRequirements & REQUIRE_UNIQUE_TIMESTAMP)
   {
     if (! this->ValidateTimestamp(trackedFrame))
@@ -278,7 +304,13 @@ bool vtkPlusTrackedFrameList::ValidateTimestamp(PlusTrackedFrame* trackedFrame)
     // the existing list is empty, so any frame has unique timestamp and therefore valid
     return true;
   }
-  const bool isTimestampUnique = std::find_if(this->TrackedFrameList.begin(), this->TrackedFrameList.end(), TrackedFrameTimestampFinder(trackedFrame)) == this->TrackedFrameList.end();
+  if (vtkMath::IsNan(trackedFrame->GetTimestamp()))
+  {
+    // NaN is not equal to any timestamp
+    return true;
+  }
+  this->UpdateValidationIndex();
+  const bool isTimestampUnique = this->TimestampIndex.find(trackedFrame->GetTimestamp()) == this->TimestampIndex.end();
   // validation passed if the timestamp is unique
   return isTimestampUnique;
 }
@@ -310,6 +342,12 @@ bool vtkPlusTrackedFrameList::ValidateEncoderPosition(PlusTrackedFrame* trackedF
 //----------------------------------------------------------------------------
 bool vtkPlusTrackedFrameList::ValidateTransform(PlusTrackedFrame* trackedFrame)
 {
+  if (this->MinRequiredTranslationDifferenceMm <= 0 || this->MinRequiredAngleDifferenceDeg <= 0)
+  {
+    // threshold is zero, so the frames are different for sure
+    return true;
+  }
+
   TrackedFrameListType::iterator searchIndex;
   const int containerSize = this->TrackedFrameList.size();
   if (containerSize < this->NumberOfUniqueFrames)
@@ -320,13 +358,39 @@ bool vtkPlusTrackedFrameList::ValidateTransform(PlusTrackedFrame* trackedFrame)
   {
     searchIndex = this->TrackedFrameList.end() - this->NumberOfUniqueFrames;
   }
+  if (searchIndex == this->TrackedFrameList.end())
+  {
+    return true;
+  }
 
-  if (std::find_if(searchIndex, this->TrackedFrameList.end(), TrackedFrameTransformFinder(trackedFrame, this->FrameTransformNameForValidation,
-                   this->MinRequiredTranslationDifferenceMm, this->MinRequiredAngleDifferenceDeg)) != this->TrackedFrameList.end())
+  vtkSmartPointer<vtkMatrix4x4> inputTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  double inputTransformVector[16] = {0};
+  if (!this->GetValidationTransform(trackedFrame, inputTransformVector))
   {
-    // We've already inserted this frame
-    LOG_DEBUG("Tracked frame transform validation result: we've already inserted this frame to container!");
-    return false;
+    LOG_ERROR("TrackedFramePositionFinder: Unable to find base frame transform name for tracked frame validation!");
+    return true;
+  }
+  inputTransformMatrix->DeepCopy(inputTransformVector);
+
+  vtkSmartPointer<vtkMatrix4x4> listTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  double listTransformVector[16] = {0};
+  for (; searchIndex != this->TrackedFrameList.end(); ++searchIndex)
+  {
+    if (!this->GetValidationTransform(*searchIndex, listTransformVector))
+    {
+      LOG_ERROR("TrackedFramePositionFinder: Unable to find frame transform name for new tracked frame validation!");
+      continue;
+    }
+    listTransformMatrix->DeepCopy(listTransformVector);
+
+    double positionDifference = PlusMath::GetPositionDifference(inputTransformMatrix, listTransformMatrix);
+    double angleDifference = PlusMath::GetOrientationDifference(inputTransformMatrix, listTransformMatrix);
+    if (fabs(positionDifference) < this->MinRequiredTranslationDifferenceMm && fabs(angleDifference) < this->MinRequiredAngleDifferenceDeg)
+    {
+      // We've already inserted this frame
+      LOG_DEBUG("Tracked frame transform validation result: we've already inserted this frame to container!");
+      return false;
+    }
   }
 
   return true;
@@ -368,7 +432,7 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
 
   vtkSmartPointer<vtkMatrix4x4> inputTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   double inputTransformVector[16] = {0};
-  if (trackedFrame->GetCustomFrameTransform(this->FrameTransformNameForValidation, inputTransformVector))
+  if (this->GetValidationTransform(trackedFrame, inputTransformVector))
   {
     inputTransformMatrix->DeepCopy(inputTransformVector);
   }
@@ -382,7 +446,7 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
 
   vtkSmartPointer<vtkMatrix4x4> latestTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   double latestTransformVector[16] = {0};
-  if ((*latestFrameInList)->GetCustomFrameTransform(this->FrameTransformNameForValidation, latestTransformVector))
+  if (this->GetValidationTransform(*latestFrameInList, latestTransformVector))
   {
     latestTransformMatrix->DeepCopy(latestTransformVector);
   }
@@ -419,13 +483,152 @@ bool vtkPlusTrackedFrameList::ValidateSpeed(PlusTrackedFrame* trackedFrame)
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkPlusTrackedFrameList::GetValidationTransform(PlusTrackedFrame* trackedFrame, double transformMatrix[16])
+{
+  ValidationTransformCacheEntry* entry = NULL;
+  if (this->CandidateValidationTransform.TrackedFrame == trackedFrame)
+  {
+    entry = &this->CandidateValidationTransform;
+  }
+  else
+  {
+    this->UpdateValidationIndex();
+    for (std::deque<ValidationTransformCacheEntry>::reverse_iterator it = this->ValidationTransformCache.rbegin(); it != this->ValidationTransformCache.rend(); ++it)
+    {
+      if (it->TrackedFrame == trackedFrame)
+      {
+        entry = &(*it);
+        break;
+      }
+    }
+  }
+  if (entry == NULL)
+  {
+    // Not one of the most recent frames in the list, so it is the frame under validation
+    entry = &this->CandidateValidationTransform;
+    entry->TrackedFrame = trackedFrame;
+    entry->Parsed = false;
+  }
+
+  if (!entry->Parsed)
+  {
+    entry->Valid = (trackedFrame->GetCustomFrameTransform(this->FrameTransformNameForValidation, entry->Matrix) == PLUS_SUCCESS);
+    entry->Parsed = true;
+  }
+  if (!entry->Valid)
+  {
+    return false;
+  }
+  std::copy(entry->Matrix, entry->Matrix + 16, transformMatrix);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::UpdateValidationIndex()
+{
+  if (this->ValidationIndexUpToDate)
+  {
+    return;
+  }
+
+  this->TimestampIndex.clear();
+  for (TrackedFrameListType::iterator it = this->TrackedFrameList.begin(); it != this->TrackedFrameList.end(); ++it)
+  {
+    if (!vtkMath::IsNan((*it)->GetTimestamp()))
+    {
+      this->TimestampIndex.insert((*it)->GetTimestamp());
+    }
+  }
+
+  this->ValidationTransformCache.clear();
+  const size_t cacheSize = std::min<size_t>(this->TrackedFrameList.size(), std::max(this->NumberOfUniqueFrames, 1));
+  for (TrackedFrameListType::iterator it = this->TrackedFrameList.end() - static_cast<TrackedFrameListType::difference_type>(cacheSize); it != this->TrackedFrameList.end(); ++it)
+  {
+    ValidationTransformCacheEntry entry;
+    entry.TrackedFrame = *it;
+    entry.Parsed = false;
+    entry.Valid = false;
+    this->ValidationTransformCache.push_back(entry);
+  }
+
+  this->ValidationIndexUpToDate = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::AddFrameToValidationIndex(PlusTrackedFrame* addedFrame, PlusTrackedFrame* validatedFrame)
+{
+  if (!this->ValidationIndexUpToDate)
+  {
+    // the whole index will be rebuilt when it is needed
+    this->CandidateValidationTransform.TrackedFrame = NULL;
+    return;
+  }
+
+  if (!vtkMath::IsNan(addedFrame->GetTimestamp()))
+  {
+    this->TimestampIndex.insert(addedFrame->GetTimestamp());
+  }
+
+  ValidationTransformCacheEntry entry;
+  if (validatedFrame != NULL && this->CandidateValidationTransform.TrackedFrame == validatedFrame)
+  {
+    // reuse the transform that was parsed during validation
+    entry = this->CandidateValidationTransform;
+  }
+  else
+  {
+    entry.Parsed = false;
+    entry.Valid = false;
+  }
+  entry.TrackedFrame = addedFrame;
+  this->CandidateValidationTransform.TrackedFrame = NULL;
+
+  this->ValidationTransformCache.push_back(entry);
+  const size_t maxCacheSize = static_cast<size_t>(std::max(this->NumberOfUniqueFrames, 1));
+  while (this->ValidationTransformCache.size() > maxCacheSize)
+  {
+    this->ValidationTransformCache.pop_front();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTrackedFrameList::RemoveFrameFromValidationIndex(PlusTrackedFrame* removedFrame)
+{
+  if (removedFrame == NULL || !this->ValidationIndexUpToDate)
+  {
+    return;
+  }
+
+  if (!vtkMath::IsNan(removedFrame->GetTimestamp()))
+  {
+    std::multiset<double>::iterator timestampIt = this->TimestampIndex.find(removedFrame->GetTimestamp());
+    if (timestampIt != this->TimestampIndex.end())
+    {
+      this->TimestampIndex.erase(timestampIt);
+    }
+  }
+
+  for (std::deque<ValidationTransformCacheEntry>::iterator it = this->ValidationTransformCache.begin(); it != this->ValidationTransformCache.end();)
+  {
+    if (it->TrackedFrame == removedFrame)
+    {
+      it = this->ValidationTransformCache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 int vtkPlusTrackedFrameList::GetNumberOfBitsPerScalar()
 {
   int numberOfBitsPerScalar = 0;
   if (this->GetNumberOfTrackedFrames() > 0)
   {
-    numberOfBitsPerScalar = this->GetTrackedFrame(0)->GetNumberOfBitsPerScalar();
+    numberOfBitsPerScalar = this->TrackedFrameList[0]->GetNumberOfBitsPerScalar();
   }
   else
   {
@@ -441,7 +644,7 @@ int vtkPlusTrackedFrameList::GetNumberOfBitsPerPixel()
   int numberOfBitsPerPixel = 0;
   if (this->GetNumberOfTrackedFrames() > 0)
   {
-    numberOfBitsPerPixel = this->GetTrackedFrame(0)->GetNumberOfBitsPerPixel();
+    numberOfBitsPerPixel = this->TrackedFrameList[0]->GetNumberOfBitsPerPixel();
   }
   else
   {
@@ -473,7 +676,7 @@ PlusStatus vtkPlusTrackedFrameList::SaveToSequenceMetafile(const std::string& fi
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusTrackedFrameList::ReadFromSequenceMetafile(const std::string& trackedSequenceDataFileName)
+PlusStatus vtkPlusTrackedFrameList::ReadFromSequenceMetafile(const std::string& trackedSequenceDataFileName, bool useHeaderIndexFile /*= false*/)
 {
   std::string trackedSequenceDataFilePath = trackedSequenceDataFileName;
 
@@ -490,6 +693,7 @@ PlusStatus vtkPlusTrackedFrameList::ReadFromSequenceMetafile(const std::string&
   vtkSmartPointer<vtkPlusMetaImageSequenceIO> reader = vtkSmartPointer<vtkPlusMetaImageSequenceIO>::New();
   reader->SetFileName(trackedSequenceDataFilePath.c_str());
   reader->SetTrackedFrameList(this);
+  reader->SetUseHeaderIndexFile(useHeaderIndexFile);
   if (reader->Read() != PLUS_SUCCESS)
   {
     LOG_ERROR("Couldn't read sequence metafile: " <<  trackedSequenceDataFileName);
@@ -557,9 +761,9 @@ PlusCommon::VTKScalarPixelType vtkPlusTrackedFrameList::GetPixelType()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
-      return this->GetTrackedFrame(i)->GetImageData()->GetVTKScalarPixelType();
+      return this->TrackedFrameList[i]->GetImageData()->GetVTKScalarPixelType();
     }
   }
 
@@ -578,9 +782,9 @@ int vtkPlusTrackedFrameList::GetNumberOfScalarComponents()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
-      return this->GetTrackedFrame(i)->GetImageData()->GetImage()->GetNumberOfScalarComponents();
+      return this->TrackedFrameList[i]->GetImageData()->GetImage()->GetNumberOfScalarComponents();
     }
   }
 
@@ -599,9 +803,9 @@ US_IMAGE_ORIENTATION vtkPlusTrackedFrameList::GetImageOrientation()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
-      return this->GetTrackedFrame(i)->GetImageData()->GetImageOrientation();
+      return this->TrackedFrameList[i]->GetImageData()->GetImageOrientation();
     }
   }
 
@@ -620,9 +824,9 @@ US_IMAGE_TYPE vtkPlusTrackedFrameList::GetImageType()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
-      return this->GetTrackedFrame(i)->GetImageData()->GetImageType();
+      return this->TrackedFrameList[i]->GetImageData()->GetImageType();
     }
   }
 
@@ -642,9 +846,9 @@ unsigned int* vtkPlusTrackedFrameList::GetFrameSize()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData() && this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData() && this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
-      return this->GetTrackedFrame(i)->GetFrameSize();
+      return this->TrackedFrameList[i]->GetFrameSize();
     }
   }
 
@@ -901,9 +1105,9 @@ double vtkPlusTrackedFrameList::GetMostRecentTimestamp()
 
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetTimestamp() > mostRecentTimestamp)
+    if (this->TrackedFrameList[i]->GetTimestamp() > mostRecentTimestamp)
     {
-      mostRecentTimestamp = this->GetTrackedFrame(i)->GetTimestamp();
+      mostRecentTimestamp = this->TrackedFrameList[i]->GetTimestamp();
     }
   }
 
@@ -915,7 +1119,7 @@ bool vtkPlusTrackedFrameList::IsContainingValidImageData()
 {
   for (unsigned int i = 0; i < this->GetNumberOfTrackedFrames(); ++i)
   {
-    if (this->GetTrackedFrame(i)->GetImageData()->IsImageValid())
+    if (this->TrackedFrameList[i]->GetImageData()->IsImageValid())
     {
       // found a valid image
       return true;
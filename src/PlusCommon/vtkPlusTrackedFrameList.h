@@ -14,6 +14,7 @@
 #include "vtkObject.h"
 
 #include <deque>
+#include <set>
 
 class vtkXMLDataElement;
 class PlusTrackedFrame;
@@ -31,6 +32,13 @@ class vtkMatrix4x4;
   the position/angle minimum value and the translation/rotation speed is lower
   than the maximum allowed translation/rotation.
 
+  Timestamps of the frames are kept in an ordered index and the validation
+  transforms of the most recent frames are cached, so that validated appends
+  do not need to scan the whole list. Accessing the frames (GetTrackedFrame, iterators)
+  does not update the index: callers that change the timestamp or the validation
+  transform of a frame in place must call Modified(), so that the index is rebuilt
+  at the next validation.
+
   \ingroup PlusLibCommon
 */
 class vtkPlusCommonExport vtkPlusTrackedFrameList : public vtkObject
@@ -44,6 +52,12 @@ public:
   vtkTypeMacro(vtkPlusTrackedFrameList, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
 
+  /*!
+    Mark the list as modified. Call it after changing the timestamp or transforms of frames
+    that are already in the list (or reordering them) so that the validation of new frames uses the updated values.
+  */
+  virtual void Modified() VTK_OVERRIDE;
+
   /*!
     Action performed after AddTrackedFrame got invalid frame.
     Invalid frame can be a TrackedFrame if the validation requirement didn't meet the expectation.
@@ -80,7 +94,7 @@ public:
   PlusStatus SaveToSequenceMetafile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true);
 
   /*! Read the tracked data from sequence metafile */
-  virtual PlusStatus ReadFromSequenceMetafile(const std::string& trackedSequenceDataFileName);
+  virtual PlusStatus ReadFromSequenceMetafile(const std::string& trackedSequenceDataFileName, bool useHeaderIndexFile = false);
 
   /*! Save the tracked data to Nrrd file */
   PlusStatus SaveToNrrdFile(const std::string& filename, US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_MF, bool useCompression = true, bool enableImageDataWrite = true);
@@ -155,6 +169,7 @@ public:
   void SetFrameTransformNameForValidation(const PlusTransformName& aTransformName)
   {
     this->FrameTransformNameForValidation = aTransformName;
+    this->ValidationTransformCache.clear();
   }
 
   /*! Get frame transform name used for transform validation */
@@ -258,6 +273,31 @@ protected:
   bool ValidateEncoderPosition(PlusTrackedFrame* trackedFrame);
   bool ValidateSpeed(PlusTrackedFrame* trackedFrame);
 
+  /*! Validation transform of a tracked frame, parsed from the frame fields */
+  struct ValidationTransformCacheEntry
+  {
+    PlusTrackedFrame* TrackedFrame;
+    bool Parsed;
+    bool Valid;
+    double Matrix[16];
+  };
+
+  /*!
+    Get the validation transform of a frame. Transforms of the most recent frames in the list
+    and of the frame under validation are parsed only once.
+    \return False if the frame does not contain the validation transform
+  */
+  bool GetValidationTransform(PlusTrackedFrame* trackedFrame, double transformMatrix[16]);
+
+  /*! Rebuild the timestamp index if the frames may have been modified since it was built */
+  void UpdateValidationIndex();
+
+  /*! Update the timestamp index and the validation transform cache after a frame is appended to the list */
+  void AddFrameToValidationIndex(PlusTrackedFrame* addedFrame, PlusTrackedFrame* validatedFrame);
+
+  /*! Update the timestamp index and the validation transform cache before a frame is removed from the list */
+  void RemoveFrameFromValidationIndex(PlusTrackedFrame* removedFrame);
+
   TrackedFrameListType TrackedFrameList;
   FieldMapType CustomFields;
 
@@ -275,6 +315,15 @@ protected:
   long ValidationRequirements;
   PlusTransformName FrameTransformNameForValidation;
 
+  /*! Ordered index of the frame timestamps for fast duplicate detection */
+  std::multiset<double> TimestampIndex;
+  /*! Parsed validation transforms of the most recently added frames */
+  std::deque<ValidationTransformCacheEntry> ValidationTransformCache;
+  /*! Parsed validation transform of the frame that is currently validated */
+  ValidationTransformCacheEntry CandidateValidationTransform;
+  /*! If false then the frames have been modified since the timestamp index was built */
+  bool ValidationIndexUpToDate;
+
 private:
   vtkPlusTrackedFrameList(const vtkPlusTrackedFrameList&);
   void operator=(const vtkPlusTrackedFrameList&);
@@ -611,6 +611,18 @@ void vtkPlusTransformRepository::Clear()
   this->CoordinateFrames.clear();
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTransformRepository::Lock()
+{
+  this->CriticalSection->Lock();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTransformRepository::Unlock()
+{
+  this->CriticalSection->Unlock();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTransformRepository::ReadConfiguration(vtkXMLDataElement* configRootElement)
 {
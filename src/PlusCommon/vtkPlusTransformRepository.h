@@ -137,6 +137,15 @@ public:
   /*! Removes all the transforms from the repository */
   void Clear();
 
+  /*!
+    Lock the repository: this should be done before reading multiple properties of a transform
+    that must be consistent with each other (e.g., matrix, date and error) if the repository
+    is being used from multiple threads. The lock is recursive, so repository methods can be called while it is held.
+  */
+  void Lock();
+  /*! Unlock the repository */
+  void Unlock();
+
   /*! Checks if a transform exist */
   virtual PlusStatus IsExistingTransform(const PlusTransformName aTransformName, bool aSilent = true);
 
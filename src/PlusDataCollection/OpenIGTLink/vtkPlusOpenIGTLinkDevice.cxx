@@ -29,6 +29,13 @@ vtkPlusOpenIGTLinkDevice::vtkPlusOpenIGTLinkDevice()
   , ClientSocket(igtl::ClientSocket::New())
   , ReconnectOnReceiveTimeout(true)
   , UseReceivedTimestamps(true)
+  , ReceiveStatisticsMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
+  , NumberOfReceivedFrames(0)
+  , FirstFrameReceiveTime(0.0)
+  , LastFrameReceiveTime(0.0)
+  , NumberOfLatencyMeasurements(0)
+  , LatencySumSec(0.0)
+  , MaxLatencySec(0.0)
 {
   // No callback function provided by the device, so the data capture thread will be used to poll the hardware and add new items to the buffer
   this->StartThreadForInternalUpdates = true;
@@ -63,6 +70,10 @@ void vtkPlusOpenIGTLinkDevice::PrintSelf(ostream& os, vtkIndent indent)
   {
     os << indent << "Image stream: " << this->ImageStream.GetTransformName() << "\n";
   }
+  os << indent << "Number of received frames: " << this->GetNumberOfReceivedFrames() << "\n";
+  os << indent << "Receive rate [fps]: " << this->GetReceiveRateFps() << "\n";
+  os << indent << "Mean latency [s]: " << this->GetMeanLatencySec() << "\n";
+  os << indent << "Max latency [s]: " << this->GetMaxLatencySec() << "\n";
 }
 //----------------------------------------------------------------------------
 std::string vtkPlusOpenIGTLinkDevice::GetSdkVersion()
@@ -343,6 +354,96 @@ PlusStatus vtkPlusOpenIGTLinkDevice::WriteConfiguration(vtkXMLDataElement* rootC
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkDevice::InternalStartRecording()
+{
+  this->ResetReceiveStatistics();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkDevice::InternalStopRecording()
+{
+  LOG_DEBUG("Device " << this->GetDeviceId() << " received " << this->GetNumberOfReceivedFrames() << " frames at " << this->GetReceiveRateFps()
+            << " fps, mean latency: " << this->GetMeanLatencySec() << " s, max latency: " << this->GetMaxLatencySec() << " s");
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkDevice::ResetReceiveStatistics()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  this->NumberOfReceivedFrames = 0;
+  this->FirstFrameReceiveTime = 0.0;
+  this->LastFrameReceiveTime = 0.0;
+  this->NumberOfLatencyMeasurements = 0;
+  this->LatencySumSec = 0.0;
+  this->MaxLatencySec = 0.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkDevice::UpdateReceiveStatistics(double messageTimestampUtc)
+{
+  double currentTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  if (this->NumberOfReceivedFrames == 0)
+  {
+    this->FirstFrameReceiveTime = currentTime;
+  }
+  this->LastFrameReceiveTime = currentTime;
+  this->NumberOfReceivedFrames++;
+
+  if (messageTimestampUtc > 0)
+  {
+    // Time elapsed between the sender timestamping the message and the frame becoming available in the buffer
+    double latencySec = currentTime - vtkPlusAccurateTimer::GetSystemTimeFromUniversalTime(messageTimestampUtc);
+    this->LatencySumSec += latencySec;
+    this->NumberOfLatencyMeasurements++;
+    if (latencySec > this->MaxLatencySec)
+    {
+      this->MaxLatencySec = latencySec;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkPlusOpenIGTLinkDevice::GetNumberOfReceivedFrames()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  return this->NumberOfReceivedFrames;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusOpenIGTLinkDevice::GetReceiveRateFps()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  double elapsedTimeSec = this->LastFrameReceiveTime - this->FirstFrameReceiveTime;
+  if (this->NumberOfReceivedFrames < 2 || elapsedTimeSec <= 0)
+  {
+    return 0.0;
+  }
+  return (this->NumberOfReceivedFrames - 1) / elapsedTimeSec;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusOpenIGTLinkDevice::GetMeanLatencySec()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  if (this->NumberOfLatencyMeasurements == 0)
+  {
+    return 0.0;
+  }
+  return this->LatencySumSec / this->NumberOfLatencyMeasurements;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusOpenIGTLinkDevice::GetMaxLatencySec()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuard(this->ReceiveStatisticsMutex);
+  return this->MaxLatencySec;
+}
+
 //----------------------------------------------------------------------------
 bool vtkPlusOpenIGTLinkDevice::SendMessage(igtl::MessageBase::Pointer packedMessage)
 {
@@ -89,10 +89,37 @@ public:
   /*! Get the ReconnectOnNoData flag */
   vtkGetMacro(ReconnectOnReceiveTimeout, bool);
 
+  /*! Get the number of frames that have been added to the buffers since recording was started */
+  unsigned long GetNumberOfReceivedFrames();
+
+  /*! Get the average rate of frames added to the buffers since recording was started (in frames per second) */
+  double GetReceiveRateFps();
+
+  /*!
+    Get the average time between the timestamp of the received message and the time when its content was added to the buffers.
+    Only meaningful if the sender and receiver clocks are synchronized (e.g., both run on the same computer).
+  */
+  double GetMeanLatencySec();
+
+  /*! Get the maximum time between the timestamp of the received message and the time when its content was added to the buffers */
+  double GetMaxLatencySec();
+
 protected:
   vtkPlusOpenIGTLinkDevice();
   virtual ~vtkPlusOpenIGTLinkDevice();
 
+  /*! Reset the receive statistics */
+  virtual PlusStatus InternalStartRecording();
+
+  /*! Log the receive statistics */
+  virtual PlusStatus InternalStopRecording();
+
+  /*! Reset the receive statistics */
+  void ResetReceiveStatistics();
+
+  /*! Update the receive statistics with a frame that has just been added to the buffers */
+  void UpdateReceiveStatistics(double messageTimestampUtc);
+
   /*! Reconnect the client socket. Used when the connection is established or there is a socket error. */
   virtual PlusStatus ClientSocketReconnect();
 
@@ -165,6 +192,15 @@ protected:
   */
   bool UseReceivedTimestamps;
 
+  /*! Receive statistics */
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> ReceiveStatisticsMutex;
+  unsigned long NumberOfReceivedFrames;
+  double FirstFrameReceiveTime;
+  double LastFrameReceiveTime;
+  unsigned long NumberOfLatencyMeasurements;
+  double LatencySumSec;
+  double MaxLatencySec;
+
 private:
   vtkPlusOpenIGTLinkDevice(const vtkPlusOpenIGTLinkDevice&);   // Not implemented.
   void operator=(const vtkPlusOpenIGTLinkDevice&);   // Not implemented.
@@ -22,6 +22,10 @@ vtkPlusOpenIGTLinkTracker::vtkPlusOpenIGTLinkTracker()
   : TrackerInternalCoordinateSystemName(NULL)
   , UseLastTransformsOnReceiveTimeout(false)
   , IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
+  , TDataResolutionMsec(50)
+  , TDataMessageIndex(0)
+  , ReceivedTrackingDataMessage(igtl::TrackingDataMessage::New())
+  , TDataToolMatrix(vtkSmartPointer<vtkMatrix4x4>::New())
 {
   SetTrackerInternalCoordinateSystemName("Reference");
 }
@@ -88,20 +92,52 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdate()
   }
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::InternalStartRecording()
+{
+  // Tools cannot be added or removed while recording, so the lookup table is built only once
+  this->TDataTools.clear();
+  for (DataSourceContainerConstIterator it = this->GetToolIteratorBegin(); it != this->GetToolIteratorEnd(); ++it)
+  {
+    TDataTool tdataTool;
+    tdataTool.Tool = it->second;
+    tdataTool.LastMessageIndex = 0;
+    this->TDataTools.push_back(tdataTool);
+  }
+  this->TDataToolIndexByName.clear();
+  this->TDataMessageIndex = 0;
+
+  return this->Superclass::InternalStartRecording();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateTData()
 {
   LOG_TRACE("vtkPlusOpenIGTLinkTracker::InternalUpdateTData");
 
-  igtl::MessageBase::Pointer bodyMsg;
-  igtl::MessageHeader::Pointer headerMsg;
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  double maxAllocatedProcessingTime = 2.0;
+  // set maxAllocatedProcessingTime to 2 acquisition periods to allow reading all messages that arrived since the last update
+  if (this->GetAcquisitionRate() > 2.0 / maxAllocatedProcessingTime)
+  {
+    maxAllocatedProcessingTime = 2.0 / this->GetAcquisitionRate();
+  }
 
+  int numberOfProcessedMessages = 0;
   while (true)
   {
+    igtl::MessageHeader::Pointer headerMsg;
     ReceiveMessageHeaderWithErrorHandling(headerMsg);
 
     if (headerMsg.IsNull())
     {
+      if (numberOfProcessedMessages > 0)
+      {
+        // All the messages that were available have been processed
+        return PLUS_SUCCESS;
+      }
+
       // Has not received data
       if (this->UseLastTransformsOnReceiveTimeout)
       {
@@ -129,20 +165,33 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateTData()
     // We've received valid header data
     headerMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
 
-    bodyMsg = IgtlMessageFactory->CreateReceiveMessage(headerMsg);
-    if (typeid(bodyMsg) == typeid(igtl::TransformMessage))
+    std::string messageType = headerMsg->GetMessageType();
+    if (messageType != "TDATA")
     {
-      // received a TDATA message
-      break;
+      // data type is unknown, ignore it
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
+      this->ClientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+      continue;
     }
 
-    // data type is unknown, ignore it
-    PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
-    this->ClientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+    if (this->ProcessTDataMessage(headerMsg) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    numberOfProcessedMessages++;
+
+    if (vtkPlusAccurateTimer::GetSystemTime() - startTime > maxAllocatedProcessingTime)
+    {
+      // no more time for processing messages in this iteration
+      return PLUS_SUCCESS;
+    }
   }
+}
 
-  // TDATA message
-  igtl::TrackingDataMessage::Pointer tdataMsg = dynamic_cast<igtl::TrackingDataMessage*>(bodyMsg.GetPointer());
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkTracker::ProcessTDataMessage(igtl::MessageHeader::Pointer headerMsg)
+{
+  igtl::TrackingDataMessage* tdataMsg = this->ReceivedTrackingDataMessage;
   tdataMsg->SetMessageHeader(headerMsg);
   tdataMsg->AllocateBuffer();
 
@@ -150,6 +199,8 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateTData()
     PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
     this->ClientSocket->Receive(tdataMsg->GetBufferBodyPointer(), tdataMsg->GetBufferBodySize());
   }
+  // The message object is reused, remove the elements of the previous message
+  tdataMsg->ClearTrackingDataElements();
   int c = tdataMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
   if (!(c & igtl::MessageHeader::UNPACK_BODY))
   {
@@ -157,65 +208,106 @@ PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateTData()
     return PLUS_FAIL;
   }
 
+  igtl::TimeStamp::Pointer igtlTimestamp = igtl::TimeStamp::New();
+  tdataMsg->GetTimeStamp(igtlTimestamp);
+  double messageTimestampUtc = igtlTimestamp->GetTimeStamp();
+
   // for now just use system time, all coordinates will be sequential.
   double unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTime();
   double filteredTimestamp = unfilteredTimestamp; // No need to filter already filtered timestamped items received over OpenIGTLink
-  // We store the list of identified tools (tools we get information about from the tracker).
+
+  // We mark the identified tools (tools we get information about from the tracker) with the message index.
   // The tools that are missing from the tracker message are assumed to be out of view.
-  std::set<std::string> identifiedToolSourceIds;
+  this->TDataMessageIndex++;
   for (int i = 0; i < tdataMsg->GetNumberOfTrackingDataElements(); ++ i)
   {
-    igtl::TrackingDataElement::Pointer tdataElem = igtl::TrackingDataElement::New();
+    igtl::TrackingDataElement::Pointer tdataElem;
     tdataMsg->GetTrackingDataElement(i, tdataElem);
 
+    int toolIndex = this->GetTDataToolIndex(tdataElem->GetName());
+    if (toolIndex < 0)
+    {
+      // unknown tool, it has been already reported
+      continue;
+    }
+    TDataTool& tdataTool = this->TDataTools[toolIndex];
+
     igtl::Matrix4x4 igtlMatrix;
     tdataElem->GetMatrix(igtlMatrix);
-    vtkSmartPointer<vtkMatrix4x4> toolMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
     // convert igtl matrix to vtk matrix
+    double toolMatrixElements[16];
     for (int r = 0; r < 4; r++)
     {
       for (int c = 0; c < 4; c++)
       {
-        toolMatrix->SetElement(r, c, igtlMatrix[r][c]);
+        toolMatrixElements[r * 4 + c] = igtlMatrix[r][c];
       }
     }
+    this->TDataToolMatrix->DeepCopy(toolMatrixElements);
 
-    // Get timestamp
-    igtl::TimeStamp::Pointer igtlTimestamp = igtl::TimeStamp::New();
-    tdataMsg->GetTimeStamp(igtlTimestamp);
-
-    // Get igtl transform name
-    std::string igtlTransformName = tdataElem->GetName();
-
-    // Set internal transform name
-    PlusTransformName transformName(igtlTransformName.c_str(), this->TrackerInternalCoordinateSystemName);
-    if (this->ToolTimeStampedUpdateWithoutFiltering(transformName.GetTransformName().c_str(), toolMatrix, TOOL_OK, unfilteredTimestamp, filteredTimestamp) == PLUS_SUCCESS)
+    // Frame numbers are not sent, just auto increment the tool frame number for each received transform
+    unsigned long frameNumber = tdataTool.Tool->GetFrameNumber() + 1;
+    if (tdataTool.Tool->AddTimeStampedItem(this->TDataToolMatrix, TOOL_OK, frameNumber, unfilteredTimestamp, filteredTimestamp) == PLUS_SUCCESS)
     {
-      identifiedToolSourceIds.insert(transformName.GetTransformName());
+      tdataTool.LastMessageIndex = this->TDataMessageIndex;
     }
     else
     {
-      LOG_INFO("ToolTimeStampedUpdate failed for tool: " << transformName.From() << " with timestamp: " << std::fixed << unfilteredTimestamp);
+      LOG_INFO("ToolTimeStampedUpdate failed for tool: " << tdataTool.Tool->GetId() << " with timestamp: " << std::fixed << unfilteredTimestamp);
       // DO NOT return here: we want to update the other tools.
     }
+    tdataTool.Tool->SetFrameNumber(frameNumber);
   }
+
   // Set status for non-detected tools
-  vtkSmartPointer<vtkMatrix4x4> toolMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  toolMatrix->Identity();
-  for (DataSourceContainerConstIterator it = this->GetToolIteratorBegin(); it != this->GetToolIteratorEnd(); ++it)
+  this->TDataToolMatrix->Identity();
+  for (std::vector<TDataTool>::iterator it = this->TDataTools.begin(); it != this->TDataTools.end(); ++it)
   {
-    if (identifiedToolSourceIds.find(it->second->GetId()) != identifiedToolSourceIds.end())
+    if (it->LastMessageIndex == this->TDataMessageIndex)
     {
       // this tool has been found and update has been already called with the correct transform
-      LOG_TRACE("Tool " << it->second->GetId() << ": found");
       continue;
     }
-    LOG_TRACE("Tool " << it->second->GetId() << ": not found");
-    this->ToolTimeStampedUpdateWithoutFiltering(it->second->GetId(), toolMatrix, TOOL_OUT_OF_VIEW, unfilteredTimestamp, filteredTimestamp);
+    LOG_TRACE("Tool " << it->Tool->GetId() << ": not found");
+    unsigned long frameNumber = it->Tool->GetFrameNumber() + 1;
+    it->Tool->AddTimeStampedItem(this->TDataToolMatrix, TOOL_OUT_OF_VIEW, frameNumber, unfilteredTimestamp, filteredTimestamp);
+    it->Tool->SetFrameNumber(frameNumber);
   }
+
+  this->UpdateReceiveStatistics(messageTimestampUtc);
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+int vtkPlusOpenIGTLinkTracker::GetTDataToolIndex(const std::string& igtlTransformName)
+{
+  std::map<std::string, int>::iterator toolIndexIt = this->TDataToolIndexByName.find(igtlTransformName);
+  if (toolIndexIt != this->TDataToolIndexByName.end())
+  {
+    return toolIndexIt->second;
+  }
+
+  // First time this name is received, look up the tool by its internal transform name
+  PlusTransformName transformName(igtlTransformName.c_str(), this->TrackerInternalCoordinateSystemName);
+  std::string toolSourceId = transformName.GetTransformName();
+  int toolIndex = -1;
+  for (unsigned int i = 0; i < this->TDataTools.size(); ++i)
+  {
+    if (this->TDataTools[i].Tool->GetId() == toolSourceId)
+    {
+      toolIndex = i;
+      break;
+    }
+  }
+  if (toolIndex < 0)
+  {
+    LOG_ERROR("Failed to update tool - unable to find tool: " << toolSourceId);
+  }
+
+  this->TDataToolIndexByName[igtlTransformName] = toolIndex;
+  return toolIndex;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkTracker::InternalUpdateGeneral()
 {
@@ -360,7 +452,7 @@ PlusStatus vtkPlusOpenIGTLinkTracker::SendRequestedMessageTypes()
   {
     igtl::StartTrackingDataMessage::Pointer sttMsg = igtl::StartTrackingDataMessage::New();
     sttMsg->SetDeviceName("");
-    sttMsg->SetResolution(50);
+    sttMsg->SetResolution(this->TDataResolutionMsec);
     sttMsg->SetCoordinateName(this->TrackerInternalCoordinateSystemName);
     sttMsg->Pack();
 
@@ -483,6 +575,7 @@ PlusStatus vtkPlusOpenIGTLinkTracker::ReadConfiguration(vtkXMLDataElement* rootC
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_READING(deviceConfig, rootConfigElement);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(TrackerInternalCoordinateSystemName, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseLastTransformsOnReceiveTimeout, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, TDataResolutionMsec, deviceConfig);
   return PLUS_SUCCESS;
 }
 
@@ -492,6 +585,7 @@ PlusStatus vtkPlusOpenIGTLinkTracker::WriteConfiguration(vtkXMLDataElement* root
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceConfig, rootConfigElement);
   deviceConfig->SetAttribute("TrackerInternalCoordinateSystemName", this->TrackerInternalCoordinateSystemName);
   deviceConfig->SetAttribute("UseLastTransformsOnReceiveTimeout", this->UseLastTransformsOnReceiveTimeout ? "true" : "false");
+  deviceConfig->SetIntAttribute("TDataResolutionMsec", this->TDataResolutionMsec);
   return PLUS_SUCCESS;
 }
 
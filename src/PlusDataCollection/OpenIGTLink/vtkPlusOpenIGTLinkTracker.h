@@ -11,11 +11,16 @@
 #include "vtkPlusDataCollectionExport.h"
 #include "vtkPlusOpenIGTLinkDevice.h"
 #include "vtkPlusIgtlMessageFactory.h"
+#include "igtlTrackingDataMessage.h"
 
 /*!
 \class vtkPlusOpenIGTLinkTracker
 \brief OpenIGTLink tracker client
 
+If MessageType is TDATA then all the tools of a tracking frame are received in a single
+message and they are added to the tool buffers in one pass. Otherwise one TRANSFORM or
+POSITION message is received for each tool.
+
 \ingroup PlusLibDataCollection
 */
 class vtkPlusDataCollectionExport vtkPlusOpenIGTLinkTracker : public vtkPlusOpenIGTLinkDevice
@@ -50,6 +55,11 @@ public:
   /*! Get the internal tracker coordinate system name */
   vtkGetStringMacro( TrackerInternalCoordinateSystemName );
 
+  /*! Set the minimum time between TDATA messages that is requested from the server in the STT_TDATA message (in milliseconds) */
+  vtkSetMacro( TDataResolutionMsec, int );
+  /*! Get the minimum time between TDATA messages that is requested from the server in the STT_TDATA message (in milliseconds) */
+  vtkGetMacro( TDataResolutionMsec, int );
+
 protected:
   vtkPlusOpenIGTLinkTracker();
   virtual ~vtkPlusOpenIGTLinkTracker();
@@ -58,15 +68,24 @@ protected:
 
   virtual PlusStatus SendRequestedMessageTypes();
 
+  /*! Prepare the tool lookup table for TDATA processing */
+  virtual PlusStatus InternalStartRecording();
+
   /*! Process TRANSFORM or POSITION messages (add the received transform to the buffer) */
   PlusStatus InternalUpdateGeneral();
 
   /*! Process a single TRANSFORM or POSITION message */
   PlusStatus ProcessTransformMessageGeneral( bool& moreMessagesPossible );
 
-  /*! Process a TDATA message (add all the received transforms to the buffers) */
+  /*! Process TDATA messages (add all the received transforms to the buffers) */
   PlusStatus InternalUpdateTData();
 
+  /*! Receive the body of a single TDATA message and add all the transforms to the tool buffers */
+  PlusStatus ProcessTDataMessage( igtl::MessageHeader::Pointer headerMsg );
+
+  /*! Get the index of the tool in TDataTools that corresponds to a TDATA element name. Returns -1 if there is no such tool. */
+  int GetTDataToolIndex( const std::string& igtlTransformName );
+
   /*!
     Store the latest transforms again in the buffers with the provided timestamp.
     If no transforms are defined then identity transform will be stored.
@@ -95,6 +114,31 @@ protected:
   /*! igtl Factory for message handling */
   vtkSmartPointer<vtkPlusIgtlMessageFactory> IgtlMessageFactory;
 
+  /*! Minimum time between TDATA messages that is requested from the server (in milliseconds) */
+  int TDataResolutionMsec;
+
+  struct TDataTool
+  {
+    vtkPlusDataSource* Tool;
+    /*! Index of the last TDATA message that contained this tool */
+    unsigned long LastMessageIndex;
+  };
+
+  /*! Tools that can be updated from TDATA messages */
+  std::vector<TDataTool> TDataTools;
+
+  /*! Index in TDataTools for each TDATA element name that has been received (-1 for unknown tools) */
+  std::map<std::string, int> TDataToolIndexByName;
+
+  /*! Number of TDATA messages processed since recording was started */
+  unsigned long TDataMessageIndex;
+
+  /*! Reused message object, so that the message body buffer is only reallocated if the message size changes */
+  igtl::TrackingDataMessage::Pointer ReceivedTrackingDataMessage;
+
+  /*! Reused matrix for adding the received transforms to the buffers */
+  vtkSmartPointer<vtkMatrix4x4> TDataToolMatrix;
+
 private:
   vtkPlusOpenIGTLinkTracker( const vtkPlusOpenIGTLinkTracker& );
   void operator=( const vtkPlusOpenIGTLinkTracker& );
@@ -21,6 +21,11 @@ vtkStandardNewMacro(vtkPlusOpenIGTLinkVideoSource);
 //----------------------------------------------------------------------------
 vtkPlusOpenIGTLinkVideoSource::vtkPlusOpenIGTLinkVideoSource()
   : IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
+  , UseReceiveThread(false)
+  , ReceiveThreadActive(std::make_pair(false, false))
+  , ReceiveThreadId(-1)
+  , ReceivedImageMessage(igtl::ImageMessage::New())
+  , ReceivedTrackedFrameMessage(igtl::PlusTrackedFrameMessage::New())
 {
   this->RequireImageOrientationInConfiguration = true;
 }
@@ -28,12 +33,87 @@ vtkPlusOpenIGTLinkVideoSource::vtkPlusOpenIGTLinkVideoSource()
 //----------------------------------------------------------------------------
 vtkPlusOpenIGTLinkVideoSource::~vtkPlusOpenIGTLinkVideoSource()
 {
+  // Stop the receive thread while the object is still fully constructed
+  if (this->Recording)
+  {
+    this->StopRecording();
+  }
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusOpenIGTLinkVideoSource::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "Use receive thread: " << (this->UseReceiveThread ? "true" : "false") << "\n";
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkVideoSource::InternalStartRecording()
+{
+  if (this->Superclass::InternalStartRecording() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  // The internal update thread is only needed if frames are not received in a dedicated thread
+  this->SetStartThreadForInternalUpdates(!this->UseReceiveThread);
+
+  if (this->UseReceiveThread && this->ReceiveThreadId < 0)
+  {
+    this->ReceiveThreadActive.first = true;
+    this->ReceiveThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&ReceiveThread, this);
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkVideoSource::InternalStopRecording()
+{
+  if (this->ReceiveThreadId >= 0)
+  {
+    this->ReceiveThreadActive.first = false;
+    while (this->ReceiveThreadActive.second)
+    {
+      // Wait until the thread stops, it returns at the latest after a receive timeout
+      vtkPlusAccurateTimer::Delay(0.1);
+    }
+    this->ReceiveThreadId = -1;
+  }
+
+  return this->Superclass::InternalStopRecording();
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusOpenIGTLinkVideoSource::ReceiveThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusOpenIGTLinkVideoSource* self = (vtkPlusOpenIGTLinkVideoSource*)(data->UserData);
+  self->ReceiveThreadActive.second = true;
+
+  while (self->ReceiveThreadActive.first)
+  {
+    if (!self->IsRecording() || !self->GetConnected())
+    {
+      // Recording is being started or stopped, don't add frames to the buffer now
+      vtkPlusAccurateTimer::Delay(0.01);
+      continue;
+    }
+    {
+      // Hold the update mutex like the internal update thread does, so that code that pauses
+      // updates by locking it (e.g., while reconfiguring the device) is not raced by this thread
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(self->UpdateMutex);
+      if (!self->ReceiveThreadActive.first)
+      {
+        break;
+      }
+      // Errors are logged by ReceiveFrame, keep receiving
+      self->ReceiveFrame();
+      self->UpdateTime.Modified();
+    }
+  }
+
+  self->ReceiveThreadActive.second = false;
+  return NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -46,6 +126,12 @@ PlusStatus vtkPlusOpenIGTLinkVideoSource::InternalUpdate()
     return PLUS_SUCCESS;
   }
 
+  return this->ReceiveFrame();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkVideoSource::ReceiveFrame()
+{
   igtl::MessageHeader::Pointer headerMsg;
   if (ReceiveMessageHeader(headerMsg) == PLUS_FAIL)
   {
@@ -70,38 +156,106 @@ PlusStatus vtkPlusOpenIGTLinkVideoSource::InternalUpdate()
   // Set unfiltered and filtered timestamp by converting UTC to system timestamp
   double unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTime();
 
-  PlusTrackedFrame trackedFrame;
-  igtl::MessageBase::Pointer bodyMsg = IgtlMessageFactory->CreateReceiveMessage(headerMsg);
+  // The message bodies are received into the reused message objects and the pixel data is copied
+  // from there directly into the buffer, without creating a temporary tracked frame
+  igtl::MessageBase::Pointer bodyMsg;
+  std::string messageType = headerMsg->GetMessageType();
+  if (messageType == "IMAGE")
+  {
+    bodyMsg = this->ReceivedImageMessage.GetPointer();
+  }
+  else if (messageType == "TRACKEDFRAME")
+  {
+    bodyMsg = this->ReceivedTrackedFrameMessage.GetPointer();
+  }
+  else
+  {
+    // if the data type is unknown, skip reading.
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
+    this->ClientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+    return PLUS_SUCCESS;
+  }
+
+  bodyMsg->SetMessageHeader(headerMsg);
+  bodyMsg->AllocateBuffer();
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
+    this->ClientSocket->Receive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
+  }
+  int c = bodyMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+  if (!(c & igtl::MessageHeader::UNPACK_BODY))
+  {
+    LOG_ERROR("Couldn't receive " << messageType << " message from OpenIGTLink server!");
+    return PLUS_FAIL;
+  }
+
+  void* imageData = NULL;
+  int frameSize[3] = {0, 0, 0};
+  PlusCommon::VTKScalarPixelType pixelType = VTK_VOID;
+  int numberOfScalarComponents = 0;
+  US_IMAGE_TYPE imageType = US_IMG_BRIGHTNESS;
+  US_IMAGE_ORIENTATION imageOrientation = US_IMG_ORIENT_MF;
+  const PlusTrackedFrame::FieldMapType* customFields = NULL;
+  double messageTimestampUtc = 0.0;
 
-  if (typeid(*bodyMsg) == typeid(igtl::ImageMessage))
+  if (messageType == "IMAGE")
   {
-    if (vtkPlusIgtlMessageCommon::UnpackImageMessage(bodyMsg, this->ClientSocket, trackedFrame, this->ImageMessageEmbeddedTransformName, this->IgtlMessageCrcCheckEnabled) != PLUS_SUCCESS)
+    igtl::ImageMessage* imgMsg = this->ReceivedImageMessage;
+    igtl::TimeStamp::Pointer igtlTimestamp = igtl::TimeStamp::New();
+    imgMsg->GetTimeStamp(igtlTimestamp);
+    messageTimestampUtc = igtlTimestamp->GetTimeStamp();
+
+    imgMsg->GetDimensions(frameSize);
+    pixelType = PlusVideoFrame::GetVTKScalarPixelTypeFromIGTL(imgMsg->GetScalarType());
+    numberOfScalarComponents = imgMsg->GetNumComponents();
+    // Set the image type to support color images
+    if (imgMsg->GetScalarType() == igtl::ImageMessage::TYPE_INT8)
     {
-      LOG_ERROR("Couldn't get image from OpenIGTLink server!");
-      return PLUS_FAIL;
+      imageType = (imgMsg->GetNumComponents() == igtl::ImageMessage::DTYPE_VECTOR) ? US_IMG_RGB_COLOR : US_IMG_BRIGHTNESS;
+    }
+    imageData = imgMsg->GetScalarPointer();
+
+    if (this->ImageMessageEmbeddedTransformName.IsValid())
+    {
+      // Save the transform that is embedded in the IMAGE message into the custom fields of the buffer item
+      vtkSmartPointer<vtkMatrix4x4> embeddedTransform = vtkSmartPointer<vtkMatrix4x4>::New();
+      vtkPlusIgtlMessageCommon::GetImageMessageEmbeddedTransform(this->ReceivedImageMessage, embeddedTransform);
+      this->EmbeddedTransformFields.SetCustomFrameTransform(this->ImageMessageEmbeddedTransformName, embeddedTransform);
+      customFields = &this->EmbeddedTransformFields.GetCustomFields();
     }
   }
-  else if (typeid(*bodyMsg) == typeid(igtl::PlusTrackedFrameMessage))
+  else
   {
-    if (vtkPlusIgtlMessageCommon::UnpackTrackedFrameMessage(bodyMsg, this->ClientSocket, trackedFrame, this->ImageMessageEmbeddedTransformName, this->IgtlMessageCrcCheckEnabled) != PLUS_SUCCESS)
+    PlusTrackedFrame& trackedFrame = this->ReceivedTrackedFrameMessage->GetTrackedFrame();
+    if (this->ImageMessageEmbeddedTransformName.IsValid())
     {
-      LOG_ERROR("Couldn't get tracked frame from OpenIGTLink server!");
-      return PLUS_FAIL;
+      // Save the transform that is embedded in the TRACKEDFRAME message into the tracked frame
+      trackedFrame.SetCustomFrameTransform(this->ImageMessageEmbeddedTransformName, this->ReceivedTrackedFrameMessage->GetEmbeddedImageTransform());
     }
-    double unfilteredTimestampUtc = trackedFrame.GetTimestamp();
+    messageTimestampUtc = trackedFrame.GetTimestamp();
     if (this->UseReceivedTimestamps)
     {
       // Use the timestamp in the OpenIGTLink message
       // The received timestamp is in UTC and timestamps in the buffer are in system time, so conversion is needed
-      unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTimeFromUniversalTime(unfilteredTimestampUtc);
+      unfilteredTimestamp = vtkPlusAccurateTimer::GetSystemTimeFromUniversalTime(messageTimestampUtc);
     }
-  }
-  else
-  {
-    // if the data type is unknown, skip reading.
-    PlusLockGuard<vtkPlusRecursiveCriticalSection> socketGuard(this->SocketMutex);
-    this->ClientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
-    return PLUS_SUCCESS;
+
+    PlusVideoFrame* videoFrame = trackedFrame.GetImageData();
+    if (videoFrame == NULL || videoFrame->GetImage() == NULL)
+    {
+      LOG_ERROR("Invalid video frame received in OpenIGTLink device " << this->GetDeviceId());
+      return PLUS_FAIL;
+    }
+    unsigned int* trackedFrameSize = trackedFrame.GetFrameSize();
+    frameSize[0] = static_cast<int>(trackedFrameSize[0]);
+    frameSize[1] = static_cast<int>(trackedFrameSize[1]);
+    frameSize[2] = static_cast<int>(trackedFrameSize[2]);
+    pixelType = videoFrame->GetVTKScalarPixelType();
+    numberOfScalarComponents = videoFrame->GetNumberOfScalarComponents();
+    imageType = videoFrame->GetImageType();
+    imageOrientation = videoFrame->GetImageOrientation();
+    imageData = videoFrame->GetScalarPointer();
+    customFields = &trackedFrame.GetCustomFields();
   }
 
   // No need to filter already filtered timestamped items received over OpenIGTLink
@@ -122,21 +276,25 @@ PlusStatus vtkPlusOpenIGTLinkVideoSource::InternalUpdate()
   // If the buffer is empty, set the pixel type and frame size to the first received properties
   if (aSource->GetNumberOfItems() == 0)
   {
-    PlusVideoFrame* videoFrame = trackedFrame.GetImageData();
-    if (videoFrame == NULL)
+    if (imageData == NULL)
     {
       LOG_ERROR("Invalid video frame received, cannot use it to initialize the video buffer");
       return PLUS_FAIL;
     }
-    aSource->SetPixelType(videoFrame->GetVTKScalarPixelType());
-    aSource->SetNumberOfScalarComponents(videoFrame->GetNumberOfScalarComponents());
-    aSource->SetImageType(videoFrame->GetImageType());
-    aSource->SetInputFrameSize(trackedFrame.GetFrameSize());
+    aSource->SetPixelType(pixelType);
+    aSource->SetNumberOfScalarComponents(numberOfScalarComponents);
+    aSource->SetImageType(imageType);
+    aSource->SetInputFrameSize(frameSize);
   }
-  PlusTrackedFrame::FieldMapType customFields = trackedFrame.GetCustomFields();
-  PlusStatus status = aSource->AddItem(trackedFrame.GetImageData(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &customFields);
+  PlusStatus status = aSource->AddItem(imageData, imageOrientation, frameSize, pixelType, numberOfScalarComponents, imageType, 0, this->FrameNumber,
+                                       unfilteredTimestamp, filteredTimestamp, customFields);
   this->Modified();
 
+  if (status == PLUS_SUCCESS)
+  {
+    this->UpdateReceiveStatistics(messageTimestampUtc);
+  }
+
   return status;
 }
 
@@ -145,6 +303,7 @@ PlusStatus vtkPlusOpenIGTLinkVideoSource::ReadConfiguration(vtkXMLDataElement* r
 {
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_READING(deviceConfig, rootConfigElement);
   XML_READ_CSTRING_ATTRIBUTE_OPTIONAL(ImageMessageEmbeddedTransformName, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseReceiveThread, deviceConfig);
   return PLUS_SUCCESS;
 }
 
@@ -153,6 +312,7 @@ PlusStatus vtkPlusOpenIGTLinkVideoSource::WriteConfiguration(vtkXMLDataElement*
 {
   XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceConfig, rootConfigElement);
   deviceConfig->SetAttribute("ImageMessageEmbeddedTransformName", this->ImageMessageEmbeddedTransformName.GetTransformName().c_str());
+  deviceConfig->SetAttribute("UseReceiveThread", this->UseReceiveThread ? "true" : "false");
   return PLUS_SUCCESS;
 }
 
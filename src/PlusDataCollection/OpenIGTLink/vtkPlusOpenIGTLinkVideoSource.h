@@ -11,6 +11,8 @@
 #include "vtkPlusDataCollectionExport.h"
 #include "vtkPlusOpenIGTLinkDevice.h"
 #include "vtkPlusIgtlMessageFactory.h"
+#include "igtlImageMessage.h"
+#include "igtlPlusTrackedFrameMessage.h"
 
 /*!
   \class vtkPlusOpenIGTLinkVideoSource
@@ -18,6 +20,14 @@
 
   vtkPlusOpenIGTLinkVideoSource is a class for providing video input interfaces between VTK and OpenIGTLink ready video device.
 
+  Message bodies are received into message objects that are reused between frames and IMAGE pixel data
+  is copied from the message directly into the buffer, so no temporary tracked frame is created.
+
+  By default the socket is polled from the device's internal update thread at the AcquisitionRate.
+  If UseReceiveThread is enabled then messages are received by a dedicated receive thread instead, which
+  adds each frame to the video buffer as soon as it arrives, independently of the AcquisitionRate.
+  The receive thread holds UpdateMutex while it receives a frame, the same way as the internal update thread.
+
   \ingroup PlusLibDataCollection
 */
 class vtkPlusDataCollectionExport vtkPlusOpenIGTLinkVideoSource : public vtkPlusOpenIGTLinkDevice
@@ -46,16 +56,50 @@ public:
   /*! Verify the device is correctly configured */
   virtual PlusStatus NotifyConfigured();
 
+  /*! If enabled then frames are received in a dedicated thread instead of the internal update thread */
+  vtkSetMacro(UseReceiveThread, bool);
+  /*! If enabled then frames are received in a dedicated thread instead of the internal update thread */
+  vtkGetMacro(UseReceiveThread, bool);
+  vtkBooleanMacro(UseReceiveThread, bool);
+
 protected:
   vtkPlusOpenIGTLinkVideoSource();
   virtual ~vtkPlusOpenIGTLinkVideoSource();
 
+  /*! Start the receive thread */
+  virtual PlusStatus InternalStartRecording();
+
+  /*! Stop the receive thread */
+  virtual PlusStatus InternalStopRecording();
+
+  /*! Receive one message from the socket and add the frame that it contains to the video buffer */
+  PlusStatus ReceiveFrame();
+
+  /*! Thread that receives frames until recording is stopped */
+  static void* ReceiveThread(vtkMultiThreader::ThreadInfo* data);
+
   /*! Name of the transform that is supplied with the IMAGE OpenIGTLink message */
   PlusTransformName ImageMessageEmbeddedTransformName;
 
   /*! igtl Factory for message handling */
   vtkSmartPointer<vtkPlusIgtlMessageFactory> IgtlMessageFactory;
 
+  /*! Receive frames in a dedicated thread. Disabled by default. */
+  bool UseReceiveThread;
+
+  /*! Receive thread state (first: requested to run, second: running) */
+  std::pair<bool, bool> ReceiveThreadActive;
+
+  /*! Receive thread id */
+  int ReceiveThreadId;
+
+  /*! Reused message objects, so that the message body buffers are only reallocated if the message size changes */
+  igtl::ImageMessage::Pointer ReceivedImageMessage;
+  igtl::PlusTrackedFrameMessage::Pointer ReceivedTrackedFrameMessage;
+
+  /*! Holds the custom field of the transform that is embedded in the received IMAGE message */
+  PlusTrackedFrame EmbeddedTransformFields;
+
 private:
   vtkPlusOpenIGTLinkVideoSource( const vtkPlusOpenIGTLinkVideoSource& ); // Not implemented.
   void operator=( const vtkPlusOpenIGTLinkVideoSource& ); // Not implemented.
@@ -12,10 +12,15 @@ See License.txt for details.
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
+#include "vtkPlusMetaImageSequenceIO.h"
+#include "vtkPlusRecursiveCriticalSection.h"
 #include "vtkPlusSavedDataSource.h"
+#include "vtkPlusSequenceIOBase.h"
 #include "vtkPlusTrackedFrameList.h"
 #include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+
 vtkStandardNewMacro(vtkPlusSavedDataSource);
 
 //----------------------------------------------------------------------------
@@ -31,6 +36,20 @@ vtkPlusSavedDataSource::vtkPlusSavedDataSource()
   , LastAddedFrameUid(0)
   , LastAddedLoopIndex(0)
   , SimulatedStream(VIDEO_STREAM)
+  , StreamFromFile(false)
+  , PrefetchBufferSize(50)
+  , UseHeaderIndexFile(false)
+  , StreamedReader(NULL)
+  , StreamedReaderNextFrameIndex(0)
+  , PrefetchNextFrameUid(0)
+  , PrefetchMutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
+  , PrefetchThreadActive(std::make_pair(false, false))
+  , PrefetchThreadId(-1)
+  , NumberOfReplayedFrames(0)
+  , NumberOfMissedReplayDeadlines(0)
+  , LastMissedFrameUid(0)
+  , FirstReplayedFrameTime(0.0)
+  , LastReplayedFrameTime(0.0)
 {
   // No callback function provided by the device, so the data capture thread will be used to poll the hardware and add new items to the buffer
   this->StartThreadForInternalUpdates = true;
@@ -149,6 +168,12 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
   PlusStatus status(PLUS_SUCCESS);
   for (int addedFrames = 0; addedFrames < numberOfFramesToBeAdded; addedFrames++)
   {
+    vtkSmartPointer<vtkPlusTrackedFrameList> prefetchedFrameList;
+    if (this->StreamedReader != NULL && !PopPrefetchedFrame(frameToBeAddedUid, prefetchedFrameList))
+    {
+      // The frame has not been read from the file yet, it will be added in a next update (with its original timestamp)
+      break;
+    }
 
     // The sampling rate is constant, so to have a constant frame rate we have to increase the FrameNumber by a constant.
     // For simplicity, we increase it always by 1.
@@ -178,7 +203,8 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
         {
           fieldMap = dataBufferItemToBeAdded.GetCustomFrameFieldMap();
         }
-        if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap) != PLUS_SUCCESS)
+        const PlusVideoFrame& frame = (prefetchedFrameList != NULL ? *prefetchedFrameList->GetTrackedFrame(0)->GetImageData() : dataBufferItemToBeAdded.GetFrame());
+        if (this->AddVideoItemToVideoSources(this->GetVideoSources(), frame, this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap) != PLUS_SUCCESS)
         {
           status = PLUS_FAIL;
         }
@@ -237,6 +263,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
 
     this->LastAddedFrameUid = frameToBeAddedUid;
     this->LastAddedLoopIndex = frameToBeAddedLoopIndex;
+    RecordReplayedFrame();
 
     frameToBeAddedUid++;
     if (frameToBeAddedUid > this->LoopLastFrameUid)
@@ -261,6 +288,13 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
     return PLUS_SUCCESS;
   }
 
+  vtkSmartPointer<vtkPlusTrackedFrameList> prefetchedFrameList;
+  if (this->StreamedReader != NULL && !PopPrefetchedFrame(frameToBeAddedUid, prefetchedFrameList))
+  {
+    // The frame has not been read from the file yet, try again in the next update
+    return PLUS_SUCCESS;
+  }
+
   this->FrameNumber++;
   StreamBufferItem dataBufferItemToBeAdded;
   if (GetLocalBuffer()->GetStreamBufferItem(frameToBeAddedUid, &dataBufferItemToBeAdded) != ITEM_OK)
@@ -279,7 +313,8 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
       {
         fieldMap = dataBufferItemToBeAdded.GetCustomFrameFieldMap();
       }
-      if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, UNDEFINED_TIMESTAMP, UNDEFINED_TIMESTAMP, &fieldMap) != PLUS_SUCCESS)
+      const PlusVideoFrame& frame = (prefetchedFrameList != NULL ? *prefetchedFrameList->GetTrackedFrame(0)->GetImageData() : dataBufferItemToBeAdded.GetFrame());
+      if (this->AddVideoItemToVideoSources(this->GetVideoSources(), frame, this->FrameNumber, UNDEFINED_TIMESTAMP, UNDEFINED_TIMESTAMP, &fieldMap) != PLUS_SUCCESS)
       {
         // UNDEFINED_TIMESTAMP => use current timestamp
         status = PLUS_FAIL;
@@ -345,6 +380,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
 
   this->LastAddedFrameUid = frameToBeAddedUid;
   this->LastAddedLoopIndex = frameToBeAddedLoopIndex;
+  RecordReplayedFrame();
 
   return status;
 }
@@ -379,28 +415,47 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
     return PLUS_FAIL;
   }
 
-  vtkSmartPointer<vtkPlusTrackedFrameList> savedDataBuffer = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
-
-  // Read sequence file into tracked frame list
-  vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
+  this->NumberOfReplayedFrames = 0;
+  this->NumberOfMissedReplayDeadlines = 0;
+  this->LastMissedFrameUid = 0;
+  this->FirstReplayedFrameTime = 0.0;
+  this->LastReplayedFrameTime = 0.0;
 
-  if (savedDataBuffer->GetNumberOfTrackedFrames() < 1)
+  PlusStatus status = PLUS_FAIL;
+  if (this->StreamFromFile && this->SimulatedStream == VIDEO_STREAM)
   {
-    LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence metafile!");
-    return PLUS_FAIL;
+    // Only the frame timestamps and fields are read now, image data is read during replay
+    status = InternalConnectVideoStreamed(foundAbsoluteImagePath);
   }
-
-  PlusStatus status = PLUS_FAIL;
-  switch (this->SimulatedStream)
+  else
   {
-    case VIDEO_STREAM:
-      status = InternalConnectVideo(savedDataBuffer);
-      break;
-    case TRACKER_STREAM:
-      status = InternalConnectTracker(savedDataBuffer);
-      break;
-    default:
-      LOG_ERROR("Unknown stream type: " << this->SimulatedStream);
+    if (this->StreamFromFile)
+    {
+      LOG_WARNING("StreamFromFile is only supported for video replay. All frames are loaded from " << this->SequenceFile);
+    }
+
+    vtkSmartPointer<vtkPlusTrackedFrameList> savedDataBuffer = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+
+    // Read sequence file into tracked frame list
+    vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer, this->UseHeaderIndexFile);
+
+    if (savedDataBuffer->GetNumberOfTrackedFrames() < 1)
+    {
+      LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence metafile!");
+      return PLUS_FAIL;
+    }
+
+    switch (this->SimulatedStream)
+    {
+      case VIDEO_STREAM:
+        status = InternalConnectVideo(savedDataBuffer);
+        break;
+      case TRACKER_STREAM:
+        status = InternalConnectTracker(savedDataBuffer);
+        break;
+      default:
+        LOG_ERROR("Unknown stream type: " << this->SimulatedStream);
+    }
   }
 
   if (status != PLUS_SUCCESS)
@@ -453,6 +508,11 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
 
+  if (this->StreamedReader != NULL)
+  {
+    StartPrefetchThread();
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -484,6 +544,133 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
   this->LocalVideoBuffer->CopyImagesFromTrackedFrameList(savedDataBuffer, vtkPlusBuffer::READ_FILTERED_IGNORE_UNFILTERED_TIMESTAMPS, this->UseAllFrameFields);
   savedDataBuffer->Clear();
 
+  return SetupVideoSources(this->LocalVideoBuffer->GetFrameSize());
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::InternalConnectVideoStreamed(const std::string& sequenceFilePath)
+{
+  vtkPlusDataSource* outputDataSource = this->GetOutputDataSource();
+  if (outputDataSource == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  DeleteLocalBuffers();
+
+  this->StreamedReader = vtkPlusSequenceIO::CreateSequenceHandlerForFile(sequenceFilePath);
+  if (this->StreamedReader == NULL)
+  {
+    LOG_ERROR("Unable to connect to saved data video source: unsupported sequence file format: " << sequenceFilePath);
+    return PLUS_FAIL;
+  }
+  this->StreamedReader->SetFileName(sequenceFilePath);
+  vtkPlusMetaImageSequenceIO* metaImageReader = vtkPlusMetaImageSequenceIO::SafeDownCast(this->StreamedReader);
+  if (metaImageReader != NULL)
+  {
+    metaImageReader->SetUseHeaderIndexFile(this->UseHeaderIndexFile);
+  }
+  if (this->StreamedReader->OpenForStreamedRead() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to connect to saved data video source: failed to read sequence file header: " << sequenceFilePath);
+    return PLUS_FAIL;
+  }
+  this->StreamedReaderNextFrameIndex = 0;
+
+  // Index the frames: the local buffer contains the timestamps and frame fields but no image data.
+  // The item index is the frame index in the file, used for reading the image data during replay.
+  vtkPlusTrackedFrameList* headerFrames = this->StreamedReader->GetTrackedFrameList();
+  const unsigned int numberOfFrames = headerFrames->GetNumberOfTrackedFrames();
+  if (numberOfFrames < 1)
+  {
+    LOG_ERROR("Failed to connect to saved dataset - there is no frame in the sequence file!");
+    return PLUS_FAIL;
+  }
+  this->LocalVideoBuffer = vtkPlusBuffer::New();
+  this->LocalVideoBuffer->SetBufferSize(numberOfFrames);
+  this->LocalVideoBuffer->SetLocalTimeOffsetSec(0.0);   // the time offset is copied from the output, so reset it to 0
+  const std::string imageStatusFieldName = this->StreamedReader->GetImageStatusFieldName();
+  vtkSmartPointer<vtkMatrix4x4> identityMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (unsigned int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    PlusTrackedFrame* headerFrame = headerFrames->GetTrackedFrame(frameIndex);
+    double timestamp(0);
+    const char* strTimestamp = headerFrame->GetCustomFrameField("Timestamp");
+    if (strTimestamp == NULL || PlusCommon::StringToDouble(strTimestamp, timestamp) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read Timestamp field of frame #" << frameIndex);
+      continue;
+    }
+
+    StreamBufferItem::FieldMapType customFields;
+    if (this->UseAllFrameFields)
+    {
+      const StreamBufferItem::FieldMapType& headerFields = headerFrame->GetCustomFields();
+      for (StreamBufferItem::FieldMapType::const_iterator fieldIt = headerFields.begin(); fieldIt != headerFields.end(); ++fieldIt)
+      {
+        // skip special fields
+        if (PlusCommon::IsEqualInsensitive(fieldIt->first, "TimeStamp")
+            || PlusCommon::IsEqualInsensitive(fieldIt->first, "UnfilteredTimestamp")
+            || PlusCommon::IsEqualInsensitive(fieldIt->first, "FrameNumber")
+            || PlusCommon::IsEqualInsensitive(fieldIt->first, imageStatusFieldName))
+        {
+          continue;
+        }
+        customFields[fieldIt->first] = fieldIt->second;
+      }
+    }
+
+    if (this->LocalVideoBuffer->AddTimeStampedItem(identityMatrix, TOOL_OK, frameIndex, timestamp, timestamp, &customFields) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Failed to add frame #" << frameIndex << " to the replay index");
+    }
+  }
+  if (this->LocalVideoBuffer->GetNumberOfItems() < 1)
+  {
+    LOG_ERROR("Failed to connect to saved dataset - no frames could be indexed in " << sequenceFilePath);
+    return PLUS_FAIL;
+  }
+
+  // Image properties are determined from the first frame
+  vtkSmartPointer<vtkPlusTrackedFrameList> firstFrameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (ReadStreamedFrame(0, firstFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to connect to saved dataset - unable to read the first frame from " << sequenceFilePath);
+    return PLUS_FAIL;
+  }
+  PlusVideoFrame* firstImage = firstFrameList->GetTrackedFrame(0)->GetImageData();
+  if (outputDataSource->SetImageType(firstImage->GetImageType()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to set video buffer image type");
+    return PLUS_FAIL;
+  }
+  // Frame size of the local buffer is left at 0, so that no memory is allocated for image data in the index
+  this->LocalVideoBuffer->SetImageOrientation(firstImage->GetImageOrientation());
+  this->LocalVideoBuffer->SetImageType(firstImage->GetImageType());
+  this->LocalVideoBuffer->SetNumberOfScalarComponents(firstImage->GetNumberOfScalarComponents());
+  this->LocalVideoBuffer->SetPixelType(firstImage->GetVTKScalarPixelType());
+  unsigned int frameSize[3] = {0, 0, 0};
+  firstImage->GetFrameSize(frameSize);
+
+  // The first frame is replayed first, keep it instead of reading it again
+  StreamBufferItem firstItem;
+  BufferItemUidType firstFrameUid = this->LocalVideoBuffer->GetOldestItemUidInBuffer();
+  if (this->LocalVideoBuffer->GetStreamBufferItem(firstFrameUid, &firstItem) == ITEM_OK && firstItem.GetIndex() == 0)
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+    PrefetchedFrame prefetchedFrame;
+    prefetchedFrame.Uid = firstFrameUid;
+    prefetchedFrame.FrameList = firstFrameList;
+    this->PrefetchedFrames.push_back(prefetchedFrame);
+  }
+
+  LOG_INFO("Indexed " << this->LocalVideoBuffer->GetNumberOfItems() << " frames for replay from " << sequenceFilePath);
+  return SetupVideoSources(frameSize);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::SetupVideoSources(unsigned int frameSize[3])
+{
   PlusStatus result(PLUS_SUCCESS);
   for (DataSourceContainerIterator it = this->VideoSources.begin(); it != this->VideoSources.end(); ++it)
   {
@@ -496,7 +683,7 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
       continue;
     }
 
-    if (source->SetInputFrameSize(this->LocalVideoBuffer->GetFrameSize()) != PLUS_SUCCESS)
+    if (source->SetInputFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
@@ -512,7 +699,7 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectVideo(vtkPlusTrackedFrameList*
 
     source->Clear();
 
-    if (source->SetInputFrameSize(this->LocalVideoBuffer->GetFrameSize()) != PLUS_SUCCESS)
+    if (source->SetInputFrameSize(frameSize) != PLUS_SUCCESS)
     {
       LOG_ERROR(source->GetId() << ": Failed to set video image orientation");
       result = PLUS_FAIL;
@@ -595,6 +782,14 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectTracker(vtkPlusTrackedFrameLis
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSavedDataSource::InternalDisconnect()
 {
+  if (this->StreamedReader != NULL)
+  {
+    LOG_INFO("Replayed " << this->NumberOfReplayedFrames << " frames at " << GetReplayFrameRate() << " fps. Number of frames that were not read from file in time: " << this->NumberOfMissedReplayDeadlines);
+  }
+  else if (this->NumberOfReplayedFrames > 0)
+  {
+    LOG_INFO("Replayed " << this->NumberOfReplayedFrames << " frames at " << GetReplayFrameRate() << " fps");
+  }
   DeleteLocalBuffers();
   return PLUS_SUCCESS;
 }
@@ -652,6 +847,9 @@ PlusStatus vtkPlusSavedDataSource::ReadConfiguration(vtkXMLDataElement* rootConf
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(RepeatEnabled, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseOriginalTimestamps, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(StreamFromFile, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, PrefetchBufferSize, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseHeaderIndexFile, deviceConfig);
 
   const char* useData = deviceConfig->GetAttribute("UseData");
   if (useData != NULL)
@@ -689,6 +887,15 @@ PlusStatus vtkPlusSavedDataSource::WriteConfiguration(vtkXMLDataElement* rootCon
   XML_WRITE_CSTRING_ATTRIBUTE_IF_NOT_NULL(SequenceFile, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(RepeatEnabled, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(UseOriginalTimestamps, imageAcquisitionConfig);
+  XML_WRITE_BOOL_ATTRIBUTE(StreamFromFile, imageAcquisitionConfig);
+  if (this->StreamFromFile)
+  {
+    imageAcquisitionConfig->SetIntAttribute("PrefetchBufferSize", this->PrefetchBufferSize);
+  }
+  if (this->UseHeaderIndexFile)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE(UseHeaderIndexFile, imageAcquisitionConfig);
+  }
 
   if (this->UseAllFrameFields)
   {
@@ -750,6 +957,9 @@ void vtkPlusSavedDataSource::GetLoopTimeRange(double& loopStartTime, double& loo
 //-----------------------------------------------------------------------------
 void vtkPlusSavedDataSource::SetLoopTimeRange(double loopStartTime, double loopStopTime)
 {
+  // The prefetch thread follows the loop range
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+
   this->LoopStartTime_Local = loopStartTime;
   this->LoopStopTime_Local = loopStopTime;
 
@@ -758,6 +968,10 @@ void vtkPlusSavedDataSource::SetLoopTimeRange(double loopStartTime, double loopS
 
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
+
+  // Frames that were read ahead for the previous loop range are not replayed
+  this->PrefetchedFrames.clear();
+  this->PrefetchNextFrameUid = this->LoopFirstFrameUid;
 }
 
 //----------------------------------------------------------------------------
@@ -827,6 +1041,15 @@ vtkPlusBuffer* vtkPlusSavedDataSource::GetLocalTrackerBuffer()
 //----------------------------------------------------------------------------
 void vtkPlusSavedDataSource::DeleteLocalBuffers()
 {
+  // The prefetch thread uses the local video buffer and the reader
+  StopPrefetchThread();
+  if (this->StreamedReader != NULL)
+  {
+    this->StreamedReader->CloseStreamedRead();
+    this->StreamedReader->Delete();
+    this->StreamedReader = NULL;
+  }
+
   if (this->LocalVideoBuffer != NULL)
   {
     this->LocalVideoBuffer->Delete();
@@ -932,3 +1155,215 @@ bool vtkPlusSavedDataSource::IsTracker() const
 
   return false;
 }
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::StartPrefetchThread()
+{
+  if (this->PrefetchThreadId >= 0)
+  {
+    return;
+  }
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+    this->PrefetchNextFrameUid = (this->PrefetchedFrames.empty() ? this->LoopFirstFrameUid : GetNextFrameUidInLoop(this->PrefetchedFrames.back().Uid));
+  }
+  this->PrefetchThreadActive.first = true;
+  this->PrefetchThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&PrefetchThread, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::StopPrefetchThread()
+{
+  if (this->PrefetchThreadId >= 0)
+  {
+    this->PrefetchThreadActive.first = false;
+    while (this->PrefetchThreadActive.second)
+    {
+      // Wait until the thread stops, it returns at the latest after reading the current frame
+      vtkPlusAccurateTimer::Delay(0.01);
+    }
+    this->PrefetchThreadId = -1;
+  }
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+  this->PrefetchedFrames.clear();
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusSavedDataSource::PrefetchThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusSavedDataSource* self = (vtkPlusSavedDataSource*)(data->UserData);
+  self->PrefetchThreadActive.second = true;
+
+  const unsigned int prefetchBufferSize = static_cast<unsigned int>(std::max(self->PrefetchBufferSize, 1));
+  while (self->PrefetchThreadActive.first)
+  {
+    // Determine which frame to read next
+    BufferItemUidType frameUid = 0;
+    bool prefetchBufferFull = false;
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(self->PrefetchMutex);
+      prefetchBufferFull = (self->PrefetchedFrames.size() >= prefetchBufferSize);
+      frameUid = self->PrefetchNextFrameUid;
+    }
+    if (prefetchBufferFull)
+    {
+      vtkPlusAccurateTimer::Delay(0.005);
+      continue;
+    }
+
+    StreamBufferItem indexItem;
+    if (self->LocalVideoBuffer->GetStreamBufferItem(frameUid, &indexItem) != ITEM_OK)
+    {
+      LOG_ERROR("vtkPlusSavedDataSource: Failed to retrieve item from the replay index, UID=" << frameUid);
+      vtkPlusAccurateTimer::Delay(0.1);
+      continue;
+    }
+
+    // Read the frame without holding the lock, so that replay is not blocked by file reading
+    vtkSmartPointer<vtkPlusTrackedFrameList> frameList = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    if (self->ReadStreamedFrame(indexItem.GetIndex(), frameList) != PLUS_SUCCESS)
+    {
+      vtkPlusAccurateTimer::Delay(0.1);
+      continue;
+    }
+
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(self->PrefetchMutex);
+    if (self->PrefetchNextFrameUid != frameUid)
+    {
+      // Replay position has been changed while the frame was read, the frame is not needed anymore
+      continue;
+    }
+    PrefetchedFrame prefetchedFrame;
+    prefetchedFrame.Uid = frameUid;
+    prefetchedFrame.FrameList = frameList;
+    self->PrefetchedFrames.push_back(prefetchedFrame);
+    self->PrefetchNextFrameUid = self->GetNextFrameUidInLoop(frameUid);
+  }
+
+  self->PrefetchThreadActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::ReadStreamedFrame(unsigned int fileFrameIndex, vtkPlusTrackedFrameList* outputFrameList)
+{
+  if (fileFrameIndex < this->StreamedReaderNextFrameIndex)
+  {
+    // Frames can only be read forward, restart from the beginning of the file (e.g., at the start of a new loop)
+    LOG_DEBUG("Restart reading frames from the beginning of " << this->StreamedReader->GetFileName());
+    if (this->StreamedReader->OpenForStreamedRead() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to reopen sequence file for reading: " << this->StreamedReader->GetFileName());
+      return PLUS_FAIL;
+    }
+    this->StreamedReaderNextFrameIndex = 0;
+  }
+
+  unsigned int numberOfFramesRead = 0;
+  if (fileFrameIndex > this->StreamedReaderNextFrameIndex)
+  {
+    // Skip frames that are not replayed
+    vtkSmartPointer<vtkPlusTrackedFrameList> skippedFrames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+    while (this->StreamedReaderNextFrameIndex < fileFrameIndex)
+    {
+      skippedFrames->Clear();
+      if (this->StreamedReader->ReadNextFrames(skippedFrames, 1, numberOfFramesRead) != PLUS_SUCCESS || numberOfFramesRead < 1)
+      {
+        LOG_ERROR("Failed to read frame " << this->StreamedReaderNextFrameIndex << " from " << this->StreamedReader->GetFileName());
+        return PLUS_FAIL;
+      }
+      this->StreamedReaderNextFrameIndex++;
+    }
+  }
+
+  if (this->StreamedReader->ReadNextFrames(outputFrameList, 1, numberOfFramesRead) != PLUS_SUCCESS || numberOfFramesRead < 1)
+  {
+    LOG_ERROR("Failed to read frame " << fileFrameIndex << " from " << this->StreamedReader->GetFileName());
+    return PLUS_FAIL;
+  }
+  this->StreamedReaderNextFrameIndex++;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusSavedDataSource::PopPrefetchedFrame(BufferItemUidType frameUid, vtkSmartPointer<vtkPlusTrackedFrameList>& frameList)
+{
+  // With the virtual clock the replayed frames must not depend on the file reading speed,
+  // therefore wait for the prefetch thread instead of skipping the frame
+  const bool waitForFrame = vtkPlusAccurateTimer::IsVirtualClockEnabled();
+  const double maxWaitTimeSec = 5.0;
+  const double waitStartTime = vtkPlusAccurateTimer::GetInternalSystemTime();
+
+  while (true)
+  {
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> prefetchGuardedLock(this->PrefetchMutex);
+
+      // Discard frames that are not replayed (e.g., the replay position has been changed)
+      while (!this->PrefetchedFrames.empty() && this->PrefetchedFrames.front().Uid != frameUid)
+      {
+        this->PrefetchedFrames.pop_front();
+      }
+
+      if (!this->PrefetchedFrames.empty())
+      {
+        frameList = this->PrefetchedFrames.front().FrameList;
+        this->PrefetchedFrames.pop_front();
+        return true;
+      }
+
+      if (this->PrefetchNextFrameUid != frameUid)
+      {
+        // Prefetching has not been following the replay, restart it from the requested frame
+        this->PrefetchNextFrameUid = frameUid;
+      }
+
+      if (!waitForFrame || !this->PrefetchThreadActive.first
+          || vtkPlusAccurateTimer::GetInternalSystemTime() - waitStartTime > maxWaitTimeSec)
+      {
+        if (this->LastMissedFrameUid != frameUid)
+        {
+          LOG_DEBUG("vtkPlusSavedDataSource: frame has not been read from file in time for replay, UID=" << frameUid);
+          this->LastMissedFrameUid = frameUid;
+          this->NumberOfMissedReplayDeadlines++;
+        }
+        return false;
+      }
+    }
+    vtkPlusAccurateTimer::Delay(0.001);
+  }
+}
+
+//----------------------------------------------------------------------------
+BufferItemUidType vtkPlusSavedDataSource::GetNextFrameUidInLoop(BufferItemUidType frameUid)
+{
+  BufferItemUidType nextFrameUid = frameUid + 1;
+  if (nextFrameUid > this->LoopLastFrameUid || nextFrameUid < this->LoopFirstFrameUid)
+  {
+    nextFrameUid = this->LoopFirstFrameUid;
+  }
+  return nextFrameUid;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::RecordReplayedFrame()
+{
+  this->LastReplayedFrameTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (this->NumberOfReplayedFrames == 0)
+  {
+    this->FirstReplayedFrameTime = this->LastReplayedFrameTime;
+  }
+  this->NumberOfReplayedFrames++;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusSavedDataSource::GetReplayFrameRate()
+{
+  double replayTime = this->LastReplayedFrameTime - this->FirstReplayedFrameTime;
+  if (this->NumberOfReplayedFrames < 2 || replayTime <= 0)
+  {
+    return 0.0;
+  }
+  return (this->NumberOfReplayedFrames - 1) / replayTime;
+}
@@ -11,7 +11,11 @@ See License.txt for details.
 
 #include "vtkPlusDevice.h"
 
+#include <deque>
+
 class vtkPlusBuffer;
+class vtkPlusRecursiveCriticalSection;
+class vtkPlusSequenceIOBase;
 
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource;
 
@@ -27,6 +31,12 @@ Attributes:
 \li UseOriginalTimestamps: if true then the original timestamps (recorded originally in the source file)
   will be replayed exactly, otherwise only the timestamp difference will be replayed exactly,
   starting from the current time (TRUE|FALSE)
+\li StreamFromFile: if true then only the frame timestamps and fields are loaded at connect and image data is read
+  from the file during replay by a prefetch thread, so connect is fast and memory usage does not depend on the
+  length of the sequence. Supported for video replay (UseData=IMAGE|IMAGE_AND_TRANSFORM). (TRUE|FALSE)
+\li PrefetchBufferSize: maximum number of frames that are read ahead of the replay position if StreamFromFile is enabled
+\li UseHeaderIndexFile: if true then the parsed header of a MetaImage sequence file is cached in a header index file (.plusidx)
+  next to the sequence file, so that the header is read faster at the next connect (TRUE|FALSE)
 
 */
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource : public vtkPlusDevice
@@ -73,7 +83,35 @@ public:
   /*! Read the timestamps from the file and use provide them in the output (instead of the current time) */
   vtkBooleanMacro( UseOriginalTimestamps, bool );
 
-  /*! Get local video buffer */
+  /*! Read image data from the file during replay instead of loading all frames at connect /sa StreamFromFile */
+  vtkGetMacro( StreamFromFile, bool );
+  /*! Read image data from the file during replay instead of loading all frames at connect /sa StreamFromFile */
+  vtkSetMacro( StreamFromFile, bool );
+  /*! Read image data from the file during replay instead of loading all frames at connect /sa StreamFromFile */
+  vtkBooleanMacro( StreamFromFile, bool );
+
+  /*! Cache the parsed header of MetaImage sequence files in a header index file /sa UseHeaderIndexFile */
+  vtkGetMacro( UseHeaderIndexFile, bool );
+  /*! Cache the parsed header of MetaImage sequence files in a header index file /sa UseHeaderIndexFile */
+  vtkSetMacro( UseHeaderIndexFile, bool );
+  /*! Cache the parsed header of MetaImage sequence files in a header index file /sa UseHeaderIndexFile */
+  vtkBooleanMacro( UseHeaderIndexFile, bool );
+
+  /*! Maximum number of frames that are read ahead of the replay position /sa PrefetchBufferSize */
+  vtkGetMacro( PrefetchBufferSize, int );
+  /*! Maximum number of frames that are read ahead of the replay position /sa PrefetchBufferSize */
+  vtkSetMacro( PrefetchBufferSize, int );
+
+  /*! Number of frames that have been replayed since connect */
+  vtkGetMacro( NumberOfReplayedFrames, unsigned long );
+
+  /*! Number of frames that were not read from the file by the time they had to be replayed (only if StreamFromFile is enabled) */
+  vtkGetMacro( NumberOfMissedReplayDeadlines, unsigned long );
+
+  /*! Average rate of the replayed frames since the first frame was replayed (in frames per second) */
+  double GetReplayFrameRate();
+
+  /*! Get local video buffer. If StreamFromFile is enabled then the buffer contains only the timestamps and frame fields. */
   vtkGetObjectMacro( LocalVideoBuffer, vtkPlusBuffer );
 
   virtual bool IsTracker() const;
@@ -98,9 +136,15 @@ protected:
   /*! Connect to device, in case the output is a video stream */
   virtual PlusStatus InternalConnectVideo( vtkPlusTrackedFrameList* savedDataBuffer );
 
+  /*! Connect to device, in case the output is a video stream that is read from the file during replay */
+  virtual PlusStatus InternalConnectVideoStreamed( const std::string& sequenceFilePath );
+
   /*! Connect to device, in case the output is a tracker stream */
   virtual PlusStatus InternalConnectTracker( vtkPlusTrackedFrameList* savedDataBuffer );
 
+  /*! Set image properties of the output video sources */
+  PlusStatus SetupVideoSources( unsigned int frameSize[3] );
+
   /*! Disconnect from device */
   virtual PlusStatus InternalDisconnect();
 
@@ -129,6 +173,30 @@ protected:
 
   void DeleteLocalBuffers();
 
+  /*! Start reading frames ahead of the replay position */
+  void StartPrefetchThread();
+
+  /*! Stop the prefetch thread and release the frames that have not been replayed */
+  void StopPrefetchThread();
+
+  /*! Read frames from the file into the prefetch queue, in the order they will be replayed */
+  static void* PrefetchThread( vtkMultiThreader::ThreadInfo* data );
+
+  /*! Read a frame from the file. The frames are read sequentially, so reading an earlier frame restarts reading from the first frame. */
+  PlusStatus ReadStreamedFrame( unsigned int fileFrameIndex, vtkPlusTrackedFrameList* outputFrameList );
+
+  /*!
+    Get the frame with the specified local buffer UID from the prefetch queue. Returns false if the frame
+    has not been read from the file yet. While the virtual clock is enabled it waits for the frame to be read.
+  */
+  bool PopPrefetchedFrame( BufferItemUidType frameUid, vtkSmartPointer<vtkPlusTrackedFrameList>& frameList );
+
+  /*! Get the UID of the frame that is replayed after the specified frame */
+  BufferItemUidType GetNextFrameUidInLoop( BufferItemUidType frameUid );
+
+  /*! Update replay statistics after a frame is added to the output */
+  void RecordReplayedFrame();
+
 protected:
   /*! Byte alignment of each row in the framebuffer */
   int FrameBufferRowAlignment;
@@ -181,6 +249,53 @@ protected:
 
   SimulatedStreamType SimulatedStream;
 
+  /*! If enabled, image data is read from the file during replay instead of loading all frames at connect */
+  bool StreamFromFile;
+
+  /*! Maximum number of frames that are read ahead of the replay position */
+  int PrefetchBufferSize;
+
+  /*! If enabled, the parsed header of MetaImage sequence files is cached in a header index file */
+  bool UseHeaderIndexFile;
+
+  /*! Sequence file reader that is used for reading image data during replay (NULL if StreamFromFile is disabled) */
+  vtkPlusSequenceIOBase* StreamedReader;
+
+  /*! Index of the frame in the sequence file that the streamed reader returns next */
+  unsigned int StreamedReaderNextFrameIndex;
+
+  struct PrefetchedFrame
+  {
+    BufferItemUidType Uid;
+    vtkSmartPointer<vtkPlusTrackedFrameList> FrameList;
+  };
+
+  /*! Frames that have been read from the file but not replayed yet, in replay order */
+  std::deque<PrefetchedFrame> PrefetchedFrames;
+
+  /*! Local buffer UID of the frame that the prefetch thread reads next */
+  BufferItemUidType PrefetchNextFrameUid;
+
+  /*! Mutex for protecting the prefetch queue */
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> PrefetchMutex;
+
+  /*! Prefetch thread active flags: first = requested to run, second = running */
+  std::pair<bool, bool> PrefetchThreadActive;
+  int PrefetchThreadId;
+
+  /*! Number of frames that have been replayed since connect */
+  unsigned long NumberOfReplayedFrames;
+
+  /*! Number of frames that were not available by the time they had to be replayed */
+  unsigned long NumberOfMissedReplayDeadlines;
+
+  /*! UID of the last frame that missed its replay deadline, used for counting each frame only once */
+  BufferItemUidType LastMissedFrameUid;
+
+  /*! System time when the first and the last frame was replayed */
+  double FirstReplayedFrameTime;
+  double LastReplayedFrameTime;
+
 private:
   static vtkPlusSavedDataSource* Instance;
   vtkPlusSavedDataSource( const vtkPlusSavedDataSource& ); // Not implemented.
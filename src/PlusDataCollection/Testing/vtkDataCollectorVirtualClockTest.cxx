@@ -0,0 +1,237 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkDataCollectorVirtualClockTest.cxx
+  \brief Test that a device set that is replayed with the virtual clock (UseVirtualClock="TRUE") records exactly the same data
+  when it is run repeatedly. The device set contains a saved data source and a virtual capture device that records its output.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSyntheticSequence.h"
+#include "PlusTrackedFrame.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusTrackedFrameList.h"
+#include "vtkPlusVirtualCapture.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <sstream>
+#include <string.h>
+
+namespace
+{
+  const double FRAME_PERIOD_SEC = 0.1;
+  const double VIRTUAL_CLOCK_START_TIME_SEC = 1000.0;
+  const double TIMESTAMP_TOLERANCE_SEC = 1e-4;
+  // Maximum time to wait in real time for the virtual clock to reach the end of the replay
+  const double MAX_REAL_REPLAY_TIME_SEC = 60.0;
+
+  //----------------------------------------------------------------------------
+  // Replay the device set in virtual time and read back the frames that the virtual capture device recorded
+  PlusStatus RunDeviceSet(const std::string& sequenceFileName, bool streamFromFile, double replayTimeSec, const std::string& captureFileName, vtkPlusTrackedFrameList* capturedFrames)
+  {
+    std::ostringstream configStr;
+    configStr << "<PlusConfiguration version=\"2.1\">"
+              << "<DataCollection StartupDelaySec=\"0.0\" UseVirtualClock=\"TRUE\" VirtualClockStartTimeSec=\"" << VIRTUAL_CLOCK_START_TIME_SEC << "\">"
+              << "<DeviceSet Name=\"DataCollectorVirtualClockTest\" Description=\"Saved data source recorded by a virtual capture device in virtual time\" />"
+              << "<Device Id=\"VideoDevice\" Type=\"SavedDataSource\" SequenceFile=\"" << sequenceFileName << "\""
+              << " UseData=\"IMAGE\" AcquisitionRate=\"30\" RepeatEnabled=\"TRUE\" UseOriginalTimestamps=\"TRUE\""
+              << " StreamFromFile=\"" << (streamFromFile ? "TRUE" : "FALSE") << "\">"
+              << "<DataSources><DataSource Type=\"Video\" Id=\"Video\" PortUsImageOrientation=\"MF\" BufferSize=\"100\" /></DataSources>"
+              << "<OutputChannels><OutputChannel Id=\"VideoStream\" VideoDataSourceId=\"Video\" /></OutputChannels>"
+              << "</Device>"
+              << "<Device Id=\"CaptureDevice\" Type=\"VirtualCapture\" BaseFilename=\"DataCollectorVirtualClockTest.mha\""
+              << " EnableCapturingOnStart=\"TRUE\" EnableFileCompression=\"FALSE\" RequestedFrameRate=\"15\" AcquisitionRate=\"10\">"
+              << "<InputChannels><InputChannel Id=\"VideoStream\" /></InputChannels>"
+              << "</Device>"
+              << "</DataCollection>"
+              << "</PlusConfiguration>";
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(configStr.str().c_str()));
+    if (configRootElement == NULL)
+    {
+      LOG_ERROR("Unable to parse device set configuration");
+      return PLUS_FAIL;
+    }
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to configure data collector");
+      return PLUS_FAIL;
+    }
+
+    vtkPlusDevice* aDevice = NULL;
+    if (dataCollector->GetDevice(aDevice, "CaptureDevice") != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to locate device \'CaptureDevice\'");
+      return PLUS_FAIL;
+    }
+    vtkPlusVirtualCapture* captureDevice = dynamic_cast<vtkPlusVirtualCapture*>(aDevice);
+    if (captureDevice == NULL)
+    {
+      LOG_ERROR("Unable to cast device to vtkPlusVirtualCapture");
+      return PLUS_FAIL;
+    }
+
+    if (dataCollector->Connect() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to connect to data collector");
+      return PLUS_FAIL;
+    }
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+
+    // System time is provided by the virtual clock, the wait is limited in real time
+    const double replayStopTime = VIRTUAL_CLOCK_START_TIME_SEC + replayTimeSec;
+    const double realWaitStartTime = vtkPlusAccurateTimer::GetInternalSystemTime();
+    while (vtkPlusAccurateTimer::GetSystemTime() < replayStopTime)
+    {
+      if (vtkPlusAccurateTimer::GetInternalSystemTime() - realWaitStartTime > MAX_REAL_REPLAY_TIME_SEC)
+      {
+        LOG_ERROR("Virtual clock did not reach the end of the replay in " << MAX_REAL_REPLAY_TIME_SEC << " sec, virtual time: " << std::fixed << vtkPlusAccurateTimer::GetSystemTime());
+        dataCollector->Stop();
+        dataCollector->Disconnect();
+        return PLUS_FAIL;
+      }
+      vtkPlusAccurateTimer::Delay(0.01);
+    }
+
+    dataCollector->Stop();
+
+    // Save with an explicit file name, as the default name only has a resolution of one second
+    std::string capturedFilePath;
+    PlusStatus status = captureDevice->CloseFile(captureFileName.c_str(), &capturedFilePath);
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to save captured frames to " << captureFileName);
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+
+    // Restarting the data collection must not rewind the virtual clock
+    const double stopTime = vtkPlusAccurateTimer::GetSystemTime();
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to restart data collection");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+    const double restartTime = vtkPlusAccurateTimer::GetSystemTime();
+    dataCollector->Stop();
+    dataCollector->Disconnect();
+    if (restartTime < stopTime)
+    {
+      LOG_ERROR("Virtual clock was rewound from " << std::fixed << stopTime << " to " << restartTime << " when data collection was restarted");
+      return PLUS_FAIL;
+    }
+
+    if (vtkPlusSequenceIO::Read(capturedFilePath, capturedFrames) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read captured frames from " << capturedFilePath);
+      return PLUS_FAIL;
+    }
+    LOG_INFO(capturedFrames->GetNumberOfTrackedFrames() << " frames captured to " << capturedFilePath);
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned int GetNumberOfFramesUntil(vtkPlusTrackedFrameList* trackedFrameList, double stopTime)
+  {
+    unsigned int numberOfFrames = 0;
+    while (numberOfFrames < trackedFrameList->GetNumberOfTrackedFrames() && trackedFrameList->GetTrackedFrame(numberOfFrames)->GetTimestamp() <= stopTime)
+    {
+      ++numberOfFrames;
+    }
+    return numberOfFrames;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  bool streamFromFile = false;
+  double replayTimeSec = 5.0;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--stream-from-file", vtksys::CommandLineArguments::NO_ARGUMENT, &streamFromFile, "Stream image data from file in the saved data source (StreamFromFile=TRUE).");
+  args.AddArgument("--replay-time", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &replayTimeSec, "Replay time in virtual seconds for each run (default: 5.0)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments." << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  std::string sequenceFileName = vtkPlusConfig::GetInstance()->GetOutputPath("DataCollectorVirtualClockTestInput.mha");
+  if (PlusSyntheticSequence::WriteSequenceFile(sequenceFileName, 20, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkPlusTrackedFrameList> firstRunFrames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  vtkSmartPointer<vtkPlusTrackedFrameList> secondRunFrames = vtkSmartPointer<vtkPlusTrackedFrameList>::New();
+  if (RunDeviceSet(sequenceFileName, streamFromFile, replayTimeSec, "DataCollectorVirtualClockTestRun1.mha", firstRunFrames) != PLUS_SUCCESS
+      || RunDeviceSet(sequenceFileName, streamFromFile, replayTimeSec, "DataCollectorVirtualClockTestRun2.mha", secondRunFrames) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // The virtual clock may advance a bit further after the end of the replay before the data collection is stopped,
+  // so only the frames up to the end of the replay are compared
+  const double replayStopTime = VIRTUAL_CLOCK_START_TIME_SEC + replayTimeSec;
+  const unsigned int numberOfFirstRunFrames = GetNumberOfFramesUntil(firstRunFrames, replayStopTime);
+  const unsigned int numberOfSecondRunFrames = GetNumberOfFramesUntil(secondRunFrames, replayStopTime);
+  if (numberOfFirstRunFrames == 0 || numberOfFirstRunFrames != numberOfSecondRunFrames)
+  {
+    LOG_ERROR("Number of captured frames mismatch: first run " << numberOfFirstRunFrames << ", second run " << numberOfSecondRunFrames);
+    return EXIT_FAILURE;
+  }
+
+  for (unsigned int i = 0; i < numberOfFirstRunFrames; ++i)
+  {
+    PlusTrackedFrame* firstRunFrame = firstRunFrames->GetTrackedFrame(i);
+    PlusTrackedFrame* secondRunFrame = secondRunFrames->GetTrackedFrame(i);
+    if (fabs(firstRunFrame->GetTimestamp() - secondRunFrame->GetTimestamp()) > TIMESTAMP_TOLERANCE_SEC)
+    {
+      LOG_ERROR("Captured frame " << i << " timestamp mismatch: first run " << std::fixed << firstRunFrame->GetTimestamp() << ", second run " << secondRunFrame->GetTimestamp());
+      return EXIT_FAILURE;
+    }
+    PlusVideoFrame* firstRunImage = firstRunFrame->GetImageData();
+    PlusVideoFrame* secondRunImage = secondRunFrame->GetImageData();
+    if (firstRunImage->GetFrameSizeInBytes() != secondRunImage->GetFrameSizeInBytes()
+        || memcmp(firstRunImage->GetScalarPointer(), secondRunImage->GetScalarPointer(), firstRunImage->GetFrameSizeInBytes()) != 0)
+    {
+      LOG_ERROR("Captured frame " << i << " image content mismatch");
+      return EXIT_FAILURE;
+    }
+  }
+
+  LOG_INFO("Test completed successfully: " << numberOfFirstRunFrames << " captured frames match");
+  return EXIT_SUCCESS;
+}
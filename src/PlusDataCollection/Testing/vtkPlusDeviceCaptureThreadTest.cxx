@@ -0,0 +1,250 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusDeviceCaptureThreadTest.cxx
+  \brief Test the data capture thread scheduling options of devices: parsing and writing of the ThreadCpuAffinity
+  and ThreadDeadlineWakeup attributes, and the capture loop statistics of a fake tracker that is recorded with deadline wakeup.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDevice.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLDataElement.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  const char TRACKER_DEVICE_ID[] = "TrackerDevice";
+  const double ACQUISITION_RATE = 50.0;
+
+  //----------------------------------------------------------------------------
+  // Device set with a fake tracker, threadAttributes are added to the attributes of the tracker device element
+  vtkXMLDataElement* CreateDeviceSetConfiguration(const std::string& threadAttributes)
+  {
+    std::ostringstream configStr;
+    configStr << "<PlusConfiguration version=\"2.1\">"
+              << "<DataCollection StartupDelaySec=\"0.0\">"
+              << "<DeviceSet Name=\"DeviceCaptureThreadTest\" Description=\"Fake tracker with data capture thread scheduling options\" />"
+              << "<Device Id=\"" << TRACKER_DEVICE_ID << "\" Type=\"FakeTracker\" Mode=\"ToolState\" ToolReferenceFrame=\"Tracker\""
+              << " AcquisitionRate=\"" << ACQUISITION_RATE << "\" " << threadAttributes << ">"
+              << "<DataSources><DataSource Type=\"Tool\" Id=\"Test\" PortName=\"0\" /></DataSources>"
+              << "<OutputChannels><OutputChannel Id=\"TrackerStream\"><DataSource Id=\"Test\" /></OutputChannel></OutputChannels>"
+              << "</Device>"
+              << "</DataCollection>"
+              << "</PlusConfiguration>";
+    return vtkXMLUtilities::ReadElementFromString(configStr.str().c_str());
+  }
+
+  //----------------------------------------------------------------------------
+  // Read the device set into a new data collector and return its tracker device
+  PlusStatus ReadTrackerDevice(vtkXMLDataElement* configRootElement, vtkPlusDataCollector* dataCollector, vtkPlusDevice*& trackerDevice)
+  {
+    if (configRootElement == NULL)
+    {
+      LOG_ERROR("Unable to parse device set configuration");
+      return PLUS_FAIL;
+    }
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to configure data collector");
+      return PLUS_FAIL;
+    }
+    if (dataCollector->GetDevice(trackerDevice, TRACKER_DEVICE_ID) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to locate device " << TRACKER_DEVICE_ID);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckThreadCpuAffinity(vtkPlusDevice* trackerDevice, const std::vector<int>& expectedCpuIndices, const std::string& description)
+  {
+    if (trackerDevice->GetThreadCpuAffinity() != expectedCpuIndices)
+    {
+      std::ostringstream cpuIndices;
+      for (std::vector<int>::const_iterator it = trackerDevice->GetThreadCpuAffinity().begin(); it != trackerDevice->GetThreadCpuAffinity().end(); ++it)
+      {
+        cpuIndices << " " << *it;
+      }
+      LOG_ERROR("Thread CPU affinity " << description << " is [" << cpuIndices.str() << " ], expected " << expectedCpuIndices.size() << " CPUs");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Invalid CPU indices are skipped, the configuration is written and read back without change
+  PlusStatus TestConfiguration()
+  {
+    std::vector<int> expectedCpuIndices;
+    expectedCpuIndices.push_back(0);
+    expectedCpuIndices.push_back(3);
+
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(
+          CreateDeviceSetConfiguration("ThreadCpuAffinity=\"0 abc -1 3\" ThreadDeadlineWakeup=\"TRUE\""));
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    vtkPlusDevice* trackerDevice = NULL;
+    // Warnings about the invalid CPU indices are expected
+    const int logLevel = vtkPlusLogger::Instance()->GetLogLevel();
+    vtkPlusLogger::Instance()->SetLogLevel(vtkPlusLogger::LOG_LEVEL_ERROR);
+    PlusStatus status = ReadTrackerDevice(configRootElement, dataCollector, trackerDevice);
+    vtkPlusLogger::Instance()->SetLogLevel(logLevel);
+    if (status != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (CheckThreadCpuAffinity(trackerDevice, expectedCpuIndices, "read from the configuration") != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (!trackerDevice->GetThreadDeadlineWakeup())
+    {
+      LOG_ERROR("Thread deadline wakeup is not enabled by the configuration");
+      return PLUS_FAIL;
+    }
+
+    // Write into a configuration that does not have the attributes yet
+    vtkSmartPointer<vtkXMLDataElement> writtenConfigRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(CreateDeviceSetConfiguration(""));
+    if (writtenConfigRootElement == NULL || trackerDevice->WriteConfiguration(writtenConfigRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to write device configuration");
+      return PLUS_FAIL;
+    }
+    vtkXMLDataElement* writtenDeviceElement = writtenConfigRootElement->FindNestedElementWithName("DataCollection")->FindNestedElementWithNameAndAttribute("Device", "Id", TRACKER_DEVICE_ID);
+    if (writtenDeviceElement == NULL || writtenDeviceElement->GetAttribute("ThreadCpuAffinity") == NULL
+        || std::string(writtenDeviceElement->GetAttribute("ThreadCpuAffinity")) != "0 3"
+        || writtenDeviceElement->GetAttribute("ThreadDeadlineWakeup") == NULL
+        || !PlusCommon::IsEqualInsensitive(writtenDeviceElement->GetAttribute("ThreadDeadlineWakeup"), "TRUE"))
+    {
+      LOG_ERROR("Data capture thread scheduling attributes are not written to the device configuration");
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkPlusDataCollector> readBackDataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    vtkPlusDevice* readBackTrackerDevice = NULL;
+    if (ReadTrackerDevice(writtenConfigRootElement, readBackDataCollector, readBackTrackerDevice) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (CheckThreadCpuAffinity(readBackTrackerDevice, expectedCpuIndices, "read back from the written configuration") != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (!readBackTrackerDevice->GetThreadDeadlineWakeup())
+    {
+      LOG_ERROR("Thread deadline wakeup is not enabled after reading back the written configuration");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Record the fake tracker with deadline wakeup and check the capture loop statistics
+  PlusStatus TestDeadlineWakeupRecording(double recordingTimeSec)
+  {
+    // CPU affinity is not set, as the CPUs that the test may run on are not known in advance
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(CreateDeviceSetConfiguration("ThreadDeadlineWakeup=\"TRUE\""));
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    vtkPlusDevice* trackerDevice = NULL;
+    if (ReadTrackerDevice(configRootElement, dataCollector, trackerDevice) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    if (dataCollector->Connect() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to connect to data collector");
+      return PLUS_FAIL;
+    }
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+    vtkPlusAccurateTimer::Delay(recordingTimeSec);
+    dataCollector->Stop();
+
+    const unsigned long numberOfLoops = trackerDevice->GetNumberOfDataCaptureLoops();
+    const unsigned long numberOfOverruns = trackerDevice->GetNumberOfDataCaptureLoopOverruns();
+    const double meanJitterSec = trackerDevice->GetMeanDataCaptureWakeupJitterSec();
+    const double maxJitterSec = trackerDevice->GetMaxDataCaptureWakeupJitterSec();
+    dataCollector->Disconnect();
+
+    LOG_INFO("Data capture loops: " << numberOfLoops << ", overruns: " << numberOfOverruns
+             << ", wakeup jitter mean: " << meanJitterSec * 1000.0 << "ms, max: " << maxJitterSec * 1000.0 << "ms");
+
+    if (numberOfLoops == 0)
+    {
+      LOG_ERROR("Data capture thread loop was not executed");
+      return PLUS_FAIL;
+    }
+    if (numberOfOverruns > numberOfLoops)
+    {
+      LOG_ERROR("Number of data capture loop overruns (" << numberOfOverruns << ") is larger than the number of loops (" << numberOfLoops << ")");
+      return PLUS_FAIL;
+    }
+    // Jitter is bounded by the recording time, anything larger means that the statistics are not computed correctly
+    if (!(meanJitterSec >= 0.0 && meanJitterSec <= maxJitterSec && maxJitterSec < recordingTimeSec))
+    {
+      LOG_ERROR("Invalid data capture wakeup jitter: mean " << meanJitterSec << " sec, max " << maxJitterSec << " sec");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  double recordingTimeSec = 2.0;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--recording-time", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &recordingTimeSec, "Recording time of the fake tracker in seconds (default: 2.0)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments." << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestConfiguration() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Data capture thread configuration test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestDeadlineWakeupRecording(recordingTimeSec) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Data capture thread deadline wakeup test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusDeviceCaptureThreadTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,294 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusOpenIGTLinkTrackerTDataBenchmark.cxx
+  \brief Measures the end-to-end latency and CPU cost of receiving many tools in TDATA messages.
+
+  A sender thread streams TDATA messages with the requested number of tools at a fixed rate
+  through the loopback interface. A vtkPlusOpenIGTLinkTracker receives them and the receive rate,
+  latency and CPU time per tool update is reported.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusAccurateTimer.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusOpenIGTLinkTracker.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// OpenIGTLink includes
+#include <igtlServerSocket.h>
+#include <igtlTrackingDataMessage.h>
+
+// STL includes
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  struct SenderInfo
+  {
+    int ServerPort;
+    int NumberOfTools;
+    double RateHz;
+    std::pair<bool, bool> Active;
+    unsigned long NumberOfSentMessages;
+    bool Failed;
+    // Sockets are closed by the main thread after the receiver is disconnected,
+    // so that the receiver does not see a socket error while it is still recording
+    igtl::ServerSocket::Pointer ServerSocket;
+    igtl::ClientSocket::Pointer ClientSocket;
+  };
+
+  std::string GetToolName(int toolIndex)
+  {
+    std::ostringstream toolName;
+    toolName << "Tool" << std::setw(2) << std::setfill('0') << toolIndex;
+    return toolName.str();
+  }
+
+  //----------------------------------------------------------------------------
+  void* SenderThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    SenderInfo* info = static_cast<SenderInfo*>(data->UserData);
+    info->Active.second = true;
+
+    info->ServerSocket = igtl::ServerSocket::New();
+    if (info->ServerSocket->CreateServer(info->ServerPort) < 0)
+    {
+      LOG_ERROR("Cannot create a server socket on port " << info->ServerPort);
+      info->Failed = true;
+      info->Active.second = false;
+      return NULL;
+    }
+
+    igtl::ClientSocket::Pointer clientSocket;
+    while (info->Active.first && clientSocket.IsNull())
+    {
+      clientSocket = info->ServerSocket->WaitForConnection(100);
+    }
+    info->ClientSocket = clientSocket;
+
+    // All tools are sent in one message, the message is packed again before each send
+    igtl::TrackingDataMessage::Pointer tdataMsg = igtl::TrackingDataMessage::New();
+    tdataMsg->SetDeviceName("Tracker");
+    for (int toolIndex = 0; toolIndex < info->NumberOfTools; ++toolIndex)
+    {
+      igtl::TrackingDataElement::Pointer trackElement = igtl::TrackingDataElement::New();
+      trackElement->SetName(GetToolName(toolIndex).c_str());
+      trackElement->SetType(igtl::TrackingDataElement::TYPE_6D);
+      tdataMsg->AddTrackingDataElement(trackElement);
+    }
+    igtl::TimeStamp::Pointer igtlTime = igtl::TimeStamp::New();
+
+    const double framePeriodSec = 1.0 / info->RateHz;
+    double nextSendTime = vtkPlusAccurateTimer::GetSystemTime();
+    while (info->Active.first && clientSocket.IsNotNull())
+    {
+      for (int toolIndex = 0; toolIndex < info->NumberOfTools; ++toolIndex)
+      {
+        igtl::TrackingDataElement::Pointer trackElement;
+        tdataMsg->GetTrackingDataElement(toolIndex, trackElement);
+        igtl::Matrix4x4 matrix;
+        igtl::IdentityMatrix(matrix);
+        matrix[0][3] = toolIndex;
+        matrix[1][3] = info->NumberOfSentMessages % 100;
+        trackElement->SetMatrix(matrix);
+      }
+      igtlTime->SetTime(vtkPlusAccurateTimer::GetUniversalTime());
+      tdataMsg->SetTimeStamp(igtlTime);
+      tdataMsg->Pack();
+      if (clientSocket->Send(tdataMsg->GetBufferPointer(), tdataMsg->GetBufferSize()) == 0)
+      {
+        LOG_ERROR("Failed to send TDATA message");
+        info->Failed = true;
+        break;
+      }
+      info->NumberOfSentMessages++;
+
+      nextSendTime += framePeriodSec;
+      double waitTimeSec = nextSendTime - vtkPlusAccurateTimer::GetSystemTime();
+      if (waitTimeSec > 0)
+      {
+        vtkPlusAccurateTimer::Delay(waitTimeSec);
+      }
+    }
+
+    info->Active.second = false;
+    return NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  // Stop sending messages and wait for the sender thread to exit, the sockets are kept open
+  void StopSenderThread(vtkMultiThreader* threader, int senderThreadId, SenderInfo& info)
+  {
+    info.Active.first = false;
+    while (info.Active.second)
+    {
+      vtkPlusAccurateTimer::Delay(0.1);
+    }
+    threader->TerminateThread(senderThreadId);
+  }
+
+  //----------------------------------------------------------------------------
+  void CloseSenderSockets(SenderInfo& info)
+  {
+    if (info.ClientSocket.IsNotNull())
+    {
+      info.ClientSocket->CloseSocket();
+    }
+    if (info.ServerSocket.IsNotNull())
+    {
+      info.ServerSocket->CloseSocket();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfTools(40);
+  double rateHz(250.0);
+  double durationSec(5.0);
+  int serverPort(18955);
+  double minRateRatio(0.0);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-tools", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfTools, "Number of tools sent in each TDATA message (Default: 40).");
+  args.AddArgument("--rate", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &rateHz, "Rate of the sent TDATA messages in Hz (Default: 250).");
+  args.AddArgument("--duration", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Duration of the measurement in seconds (Default: 5).");
+  args.AddArgument("--port", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &serverPort, "Loopback port used for the measurement (Default: 18955).");
+  args.AddArgument("--min-rate-ratio", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &minRateRatio, "Minimum ratio of the receive rate and the send rate. The rate is only reported if 0 (Default: 0).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (numberOfTools < 1 || rateHz <= 0 || durationSec <= 0)
+  {
+    LOG_ERROR("Invalid arguments: number-of-tools, rate and duration must be positive");
+    return EXIT_FAILURE;
+  }
+
+  SenderInfo senderInfo;
+  senderInfo.ServerPort = serverPort;
+  senderInfo.NumberOfTools = numberOfTools;
+  senderInfo.RateHz = rateHz;
+  senderInfo.Active = std::make_pair(true, false);
+  senderInfo.NumberOfSentMessages = 0;
+  senderInfo.Failed = false;
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  int senderThreadId = threader->SpawnThread((vtkThreadFunctionType)&SenderThread, &senderInfo);
+
+  vtkSmartPointer<vtkPlusOpenIGTLinkTracker> tracker = vtkSmartPointer<vtkPlusOpenIGTLinkTracker>::New();
+  tracker->SetDeviceId("TDataBenchmarkTracker");
+  tracker->SetServerAddress("127.0.0.1");
+  tracker->SetServerPort(serverPort);
+  tracker->SetMessageType("TDATA");
+  tracker->SetTDataResolutionMsec(0);
+  tracker->SetAcquisitionRate(rateHz);
+  for (int toolIndex = 0; toolIndex < numberOfTools; ++toolIndex)
+  {
+    vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+    tool->SetId(PlusTransformName(GetToolName(toolIndex), "Reference").GetTransformName());
+    tool->SetBufferSize(static_cast<int>(rateHz * durationSec) + 10);
+    if (tracker->AddTool(tool) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tool " << tool->GetId());
+      StopSenderThread(threader, senderThreadId, senderInfo);
+      CloseSenderSockets(senderInfo);
+      return EXIT_FAILURE;
+    }
+  }
+
+  int numberOfErrors = 0;
+  if (tracker->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to connect to the loopback TDATA sender");
+    numberOfErrors++;
+    StopSenderThread(threader, senderThreadId, senderInfo);
+  }
+  else
+  {
+    tracker->StartRecording();
+    std::clock_t cpuStartTime = std::clock();
+    vtkPlusAccurateTimer::Delay(durationSec);
+    std::clock_t cpuStopTime = std::clock();
+    // Statistics are reset when recording starts, so they have to be read before stopping
+    unsigned long numberOfReceivedMessages = tracker->GetNumberOfReceivedFrames();
+    double receiveRateFps = tracker->GetReceiveRateFps();
+    double meanLatencySec = tracker->GetMeanLatencySec();
+    double maxLatencySec = tracker->GetMaxLatencySec();
+    // The sender must not write to the socket while the tracker disconnects
+    StopSenderThread(threader, senderThreadId, senderInfo);
+    tracker->StopRecording();
+    tracker->Disconnect();
+
+    double cpuTimeSec = static_cast<double>(cpuStopTime - cpuStartTime) / CLOCKS_PER_SEC;
+    double numberOfToolUpdates = static_cast<double>(numberOfReceivedMessages) * numberOfTools;
+    LOG_INFO("Tools: " << numberOfTools << ", send rate: " << rateHz << " Hz, sent messages: " << senderInfo.NumberOfSentMessages);
+    LOG_INFO("Received messages: " << numberOfReceivedMessages << ", receive rate: " << std::fixed << std::setprecision(1) << receiveRateFps << " Hz ("
+             << std::setprecision(1) << receiveRateFps / rateHz * 100.0 << "% of the send rate)");
+    LOG_INFO("Latency: mean " << std::setprecision(3) << meanLatencySec * 1000.0 << " ms, max " << maxLatencySec * 1000.0 << " ms");
+    if (numberOfToolUpdates > 0)
+    {
+      // The process CPU time includes the sender thread, so this is an upper bound of the receiving cost
+      LOG_INFO("CPU time per tool update (sender and receiver): " << std::setprecision(3) << cpuTimeSec / numberOfToolUpdates * 1e6 << " us");
+    }
+
+    if (minRateRatio > 0 && receiveRateFps < rateHz * minRateRatio)
+    {
+      LOG_ERROR("Receive rate " << receiveRateFps << " Hz is below the required " << rateHz * minRateRatio << " Hz");
+      numberOfErrors++;
+    }
+    for (DataSourceContainerConstIterator it = tracker->GetToolIteratorBegin(); it != tracker->GetToolIteratorEnd(); ++it)
+    {
+      if (it->second->GetFrameNumber() == 0)
+      {
+        LOG_ERROR("No data was received for tool " << it->second->GetId());
+        numberOfErrors++;
+      }
+    }
+  }
+
+  CloseSenderSockets(senderInfo);
+
+  if (senderInfo.Failed)
+  {
+    numberOfErrors++;
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("vtkPlusOpenIGTLinkTrackerTDataBenchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusOpenIGTLinkTrackerTDataBenchmark completed successfully");
+  return EXIT_SUCCESS;
+}
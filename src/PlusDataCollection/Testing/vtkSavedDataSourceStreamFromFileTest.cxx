@@ -0,0 +1,248 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkSavedDataSourceStreamFromFileTest.cxx
+  \brief Test that vtkPlusSavedDataSource replays the same frames with the same timestamps
+  when image data is streamed from file (StreamFromFile=TRUE) and when all frames are loaded at connect (StreamFromFile=FALSE)
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSyntheticSequence.h"
+#include "PlusXmlUtils.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusSavedDataSource.h"
+#include "vtkSmartPointer.h"
+#include "vtkXMLUtilities.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  const double FRAME_PERIOD_SEC = 0.1;
+  // The loop contains frames 5-9: the closest frames within the range are used as first and last frame of the loop
+  const double LOOP_START_TIME_SEC = 0.48;
+  const double LOOP_STOP_TIME_SEC = 0.98;
+  const int LOOP_FIRST_FRAME_INDEX = 5;
+  const int LOOP_LAST_FRAME_INDEX = 9;
+  const double TIMESTAMP_TOLERANCE_SEC = 1e-4;
+
+  struct ReplayedFrame
+  {
+    int PixelValue;
+    double TimeSinceStartSec;
+  };
+
+  //----------------------------------------------------------------------------
+  PlusStatus Replay(const std::string& sequenceFileName, bool streamFromFile, double replayTimeSec, std::vector<ReplayedFrame>& replayedFrames)
+  {
+    replayedFrames.clear();
+
+    std::ostringstream configStr;
+    configStr << "<PlusConfiguration version=\"2.1\">"
+              << "<DataCollection StartupDelaySec=\"0.0\">"
+              << "<DeviceSet Name=\"SavedDataSourceStreamFromFileTest\" Description=\"Replay of a synthetic sequence\" />"
+              << "<Device Id=\"VideoDevice\" Type=\"SavedDataSource\" SequenceFile=\"" << sequenceFileName << "\""
+              << " UseData=\"IMAGE\" AcquisitionRate=\"50\" RepeatEnabled=\"TRUE\" UseOriginalTimestamps=\"TRUE\""
+              << " StreamFromFile=\"" << (streamFromFile ? "TRUE" : "FALSE") << "\" PrefetchBufferSize=\"3\">"
+              << "<DataSources><DataSource Type=\"Video\" Id=\"Video\" PortUsImageOrientation=\"MF\" BufferSize=\"500\" /></DataSources>"
+              << "<OutputChannels><OutputChannel Id=\"VideoStream\" VideoDataSourceId=\"Video\" /></OutputChannels>"
+              << "</Device>"
+              << "</DataCollection>"
+              << "</PlusConfiguration>";
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(configStr.str().c_str()));
+    if (configRootElement == NULL)
+    {
+      LOG_ERROR("Unable to parse device set configuration");
+      return PLUS_FAIL;
+    }
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to configure data collector (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << ")");
+      return PLUS_FAIL;
+    }
+
+    vtkPlusDevice* aDevice = NULL;
+    if (dataCollector->GetDevice(aDevice, "VideoDevice") != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to locate device \'VideoDevice\'");
+      return PLUS_FAIL;
+    }
+    vtkPlusSavedDataSource* savedDataSource = dynamic_cast<vtkPlusSavedDataSource*>(aDevice);
+    if (savedDataSource == NULL)
+    {
+      LOG_ERROR("Unable to cast device to vtkPlusSavedDataSource");
+      return PLUS_FAIL;
+    }
+
+    if (dataCollector->Connect() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to connect to data collector (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << ")");
+      return PLUS_FAIL;
+    }
+
+    savedDataSource->SetLoopTimeRange(LOOP_START_TIME_SEC, LOOP_STOP_TIME_SEC);
+
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << ")");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+
+    vtkPlusAccurateTimer::Delay(replayTimeSec);
+
+    dataCollector->Stop();
+
+    PlusStatus status = PLUS_SUCCESS;
+    vtkPlusChannel* aChannel = NULL;
+    vtkPlusDataSource* aSource = NULL;
+    if (aDevice->GetOutputChannelByName(aChannel, "VideoStream") != PLUS_SUCCESS || aChannel == NULL || aChannel->GetVideoSource(aSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to retrieve the video source");
+      status = PLUS_FAIL;
+    }
+    else if (aSource->GetNumberOfItems() > 0)
+    {
+      for (BufferItemUidType uid = aSource->GetOldestItemUidInBuffer(); uid <= aSource->GetLatestItemUidInBuffer(); ++uid)
+      {
+        StreamBufferItem bufferItem;
+        if (aSource->GetStreamBufferItem(uid, &bufferItem) != ITEM_OK)
+        {
+          LOG_ERROR("Failed to retrieve replayed frame from the buffer, UID=" << uid);
+          status = PLUS_FAIL;
+          break;
+        }
+        ReplayedFrame replayedFrame;
+        replayedFrame.PixelValue = *static_cast<unsigned char*>(bufferItem.GetFrame().GetScalarPointer());
+        replayedFrame.TimeSinceStartSec = bufferItem.GetFilteredTimestamp(aSource->GetLocalTimeOffsetSec()) - aSource->GetStartTime();
+        replayedFrames.push_back(replayedFrame);
+      }
+
+      if (savedDataSource->GetNumberOfReplayedFrames() != replayedFrames.size())
+      {
+        LOG_ERROR("Number of replayed frames mismatch (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << "): reported "
+                  << savedDataSource->GetNumberOfReplayedFrames() << ", found in buffer " << replayedFrames.size());
+        status = PLUS_FAIL;
+      }
+    }
+
+    LOG_INFO("StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << ": " << replayedFrames.size() << " frames replayed, "
+             << savedDataSource->GetNumberOfMissedReplayDeadlines() << " missed replay deadlines");
+
+    dataCollector->Disconnect();
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  // Frames have to cycle through the loop range with the original frame period, the loop is shifted by the loop length at each repeat
+  PlusStatus CheckReplayedFrames(const std::vector<ReplayedFrame>& replayedFrames, bool streamFromFile)
+  {
+    const int numberOfFramesInTheLoop = LOOP_LAST_FRAME_INDEX - LOOP_FIRST_FRAME_INDEX + 1;
+    const double loopTimeSec = LOOP_STOP_TIME_SEC - LOOP_START_TIME_SEC;
+    for (unsigned int i = 0; i < replayedFrames.size(); ++i)
+    {
+      int loopIndex = i / numberOfFramesInTheLoop;
+      int expectedPixelValue = LOOP_FIRST_FRAME_INDEX + i % numberOfFramesInTheLoop;
+      double expectedTimeSinceStartSec = FRAME_PERIOD_SEC * expectedPixelValue + loopIndex * loopTimeSec - LOOP_START_TIME_SEC;
+      if (replayedFrames[i].PixelValue != expectedPixelValue)
+      {
+        LOG_ERROR("Replayed frame " << i << " content mismatch (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << "): expected frame "
+                  << expectedPixelValue << ", actual frame " << replayedFrames[i].PixelValue);
+        return PLUS_FAIL;
+      }
+      if (fabs(replayedFrames[i].TimeSinceStartSec - expectedTimeSinceStartSec) > TIMESTAMP_TOLERANCE_SEC)
+      {
+        LOG_ERROR("Replayed frame " << i << " timestamp mismatch (StreamFromFile=" << (streamFromFile ? "TRUE" : "FALSE") << "): expected "
+                  << expectedTimeSinceStartSec << " sec after start, actual " << replayedFrames[i].TimeSinceStartSec << " sec");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp = false;
+  double replayTimeSec = 2.0;
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--replay-time", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &replayTimeSec, "Replay time in seconds for each mode (default: 2.0)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments." << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  std::string sequenceFileName = vtkPlusConfig::GetInstance()->GetOutputPath("SavedDataSourceStreamFromFileTest.mha");
+  if (PlusSyntheticSequence::WriteSequenceFile(sequenceFileName, 20, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<ReplayedFrame> loadedFrames;
+  std::vector<ReplayedFrame> streamedFrames;
+  if (Replay(sequenceFileName, false, replayTimeSec, loadedFrames) != PLUS_SUCCESS
+      || Replay(sequenceFileName, true, replayTimeSec, streamedFrames) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Both replays have to go through the loop more than once to test repeating
+  const unsigned int minimumNumberOfReplayedFrames = 2 * (LOOP_LAST_FRAME_INDEX - LOOP_FIRST_FRAME_INDEX + 1) + 1;
+  if (loadedFrames.size() < minimumNumberOfReplayedFrames || streamedFrames.size() < minimumNumberOfReplayedFrames)
+  {
+    LOG_ERROR("Too few frames are replayed: StreamFromFile=FALSE: " << loadedFrames.size() << ", StreamFromFile=TRUE: " << streamedFrames.size()
+              << ", expected at least " << minimumNumberOfReplayedFrames);
+    return EXIT_FAILURE;
+  }
+
+  if (CheckReplayedFrames(loadedFrames, false) != PLUS_SUCCESS || CheckReplayedFrames(streamedFrames, true) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // The replays are stopped at slightly different positions, so only the common part is compared
+  const unsigned int numberOfFramesToCompare = std::min(loadedFrames.size(), streamedFrames.size());
+  for (unsigned int i = 0; i < numberOfFramesToCompare; ++i)
+  {
+    if (loadedFrames[i].PixelValue != streamedFrames[i].PixelValue
+        || fabs(loadedFrames[i].TimeSinceStartSec - streamedFrames[i].TimeSinceStartSec) > TIMESTAMP_TOLERANCE_SEC)
+    {
+      LOG_ERROR("Replayed frame " << i << " differs: StreamFromFile=FALSE: frame " << loadedFrames[i].PixelValue << " at " << loadedFrames[i].TimeSinceStartSec
+                << " sec, StreamFromFile=TRUE: frame " << streamedFrames[i].PixelValue << " at " << streamedFrames[i].TimeSinceStartSec << " sec");
+      return EXIT_FAILURE;
+    }
+  }
+
+  LOG_INFO("Test completed successfully: " << numberOfFramesToCompare << " replayed frames match");
+  return EXIT_SUCCESS;
+}
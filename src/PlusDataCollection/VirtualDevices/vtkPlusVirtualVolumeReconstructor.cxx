@@ -317,7 +317,16 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::GetReconstructedVolumeFromFile(con
     return PLUS_FAIL;
   }
 
+  // The lock is held from clearing the volume until the result is extracted, so that frames of
+  // a live reconstruction started meanwhile cannot be pasted into the volume
   PlusLockGuard<vtkPlusRecursiveCriticalSection> writerLock(this->VolumeReconstructorAccessMutex);
+  if (this->EnableReconstruction)
+  {
+    errorMessage = "Volume reconstruction failed, live volume reconstruction is in progress";
+    LOG_INFO(errorMessage);
+    return PLUS_FAIL;
+  }
+  this->VolumeReconstructor->Reset();
 
   // Determine volume extents automatically
   std::string errorDetail;
@@ -30,6 +30,7 @@ public:
   void PrintSelf(ostream& os, vtkIndent indent);
 
   /*!
+    Clear the volume and reconstruct it from the frames of a sequence file. Fails if live reconstruction is enabled.
     This method is safe to be called from any thread.
   */
   virtual PlusStatus GetReconstructedVolumeFromFile(const std::string& inputSeqFilename, vtkImageData* reconstructedVolume, std::string& errorMessage);
@@ -123,6 +123,7 @@ PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
 
   for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
   {
+    this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().SetFrameMemoryPool(this->FrameMemoryPool);
     if (this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
     {
       LOCAL_LOG_ERROR("Failed to allocate memory for frame " << i);
@@ -132,6 +133,29 @@ PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
   return result;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool)
+{
+  if (this->FrameMemoryPool == frameMemoryPool)
+  {
+    return;
+  }
+  this->FrameMemoryPool = frameMemoryPool;
+
+  PlusLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
+  {
+    this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().SetFrameMemoryPool(this->FrameMemoryPool);
+  }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPlusFrameMemoryPool* vtkPlusBuffer::GetFrameMemoryPool()
+{
+  return this->FrameMemoryPool;
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::SetLocalTimeOffsetSec(double offsetSec)
 {
@@ -20,6 +20,7 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 #include "PlusStreamBufferItem.h"
 #include "PlusTrackedFrame.h"
 #include "vtkObject.h"
+#include "vtkPlusFrameMemoryPool.h"
 #include "vtkPlusTimestampedCircularBuffer.h"
 
 class vtkPlusDevice;
@@ -290,6 +291,14 @@ public:
   /*! Get the image orientation (MF, MN, ...) */
   vtkGetMacro(ImageOrientation, US_IMAGE_ORIENTATION);
 
+  /*!
+    Set the pool that the pixel buffers of the frames are allocated from (NULL means allocation by VTK).
+    Frames that are already allocated keep their pixel buffer until the frame format changes.
+  */
+  void SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool);
+  /*! Get the pool that the pixel buffers of the frames are allocated from */
+  vtkPlusFrameMemoryPool* GetFrameMemoryPool();
+
   /*! Get the number of bytes per scalar component */
   int GetNumberOfBytesPerScalar();
 
@@ -357,6 +366,9 @@ protected:
   /*! Timestamped circular buffer that stores the last N frames */
   StreamItemCircularBuffer* StreamBuffer;
 
+  /*! Pool that the pixel buffers of the frames are allocated from */
+  vtkSmartPointer<vtkPlusFrameMemoryPool> FrameMemoryPool;
+
   /*! Maximum allowed time difference in seconds between the desired and the closest valid timestamp */
   double MaxAllowedTimeDifference;
 
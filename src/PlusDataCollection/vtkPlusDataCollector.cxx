@@ -13,6 +13,7 @@ See License.txt for details.
 #include "vtkPlusDataSource.h"
 #include "vtkPlusDevice.h"
 #include "vtkPlusDeviceFactory.h"
+#include "vtkPlusFrameMemoryPool.h"
 #include "vtkPlusSavedDataSource.h"
 #include "vtkPlusTrackedFrameList.h"
 
@@ -21,6 +22,9 @@ See License.txt for details.
 #include <vtkXMLDataElement.h>
 #include <vtksys/SystemTools.hxx>
 
+// STL includes
+#include <algorithm>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusDataCollector);
@@ -30,6 +34,12 @@ vtkPlusDataCollector::vtkPlusDataCollector()
   : vtkObject()
   , StartupDelaySec(0.0)
   , DeviceFactory(vtkSmartPointer<vtkPlusDeviceFactory>::New())
+  , FrameMemoryPool(vtkSmartPointer<vtkPlusFrameMemoryPool>::New())
+  , UseVirtualClock(false)
+  , VirtualClockStartTimeSec(0.0)
+  , Threader(vtkSmartPointer<vtkMultiThreader>::New())
+  , VirtualClockThreadActive(std::make_pair(false, false))
+  , VirtualClockThreadId(-1)
   , Connected(false)
   , Started(false)
 {
@@ -89,6 +99,50 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     LOG_DEBUG("StartupDelaySec: " << std::fixed << startupDelaySec);
   }
 
+  // Read frame memory pool settings
+  const char* useFrameMemoryPool = dataCollectionElement->GetAttribute("UseFrameMemoryPool");
+  if (useFrameMemoryPool != NULL)
+  {
+    if (PlusCommon::IsEqualInsensitive(useFrameMemoryPool, "FALSE"))
+    {
+      this->SetFrameMemoryPool(NULL);
+    }
+    else if (!PlusCommon::IsEqualInsensitive(useFrameMemoryPool, "TRUE"))
+    {
+      LOG_WARNING("Failed to read UseFrameMemoryPool attribute: expected 'TRUE' or 'FALSE', got '" << useFrameMemoryPool << "'");
+    }
+  }
+  double frameMemoryPoolMaximumCachedSizeMb(0.0);
+  if (this->FrameMemoryPool != NULL && dataCollectionElement->GetScalarAttribute("FrameMemoryPoolMaximumCachedSizeMb", frameMemoryPoolMaximumCachedSizeMb))
+  {
+    this->FrameMemoryPool->SetMaximumCachedSizeBytes(static_cast<vtkTypeUInt64>(frameMemoryPoolMaximumCachedSizeMb * 1024 * 1024));
+    LOG_DEBUG("FrameMemoryPoolMaximumCachedSizeMb: " << std::fixed << frameMemoryPoolMaximumCachedSizeMb);
+  }
+
+  // Read virtual clock settings
+  const char* useVirtualClock = dataCollectionElement->GetAttribute("UseVirtualClock");
+  if (useVirtualClock != NULL)
+  {
+    if (PlusCommon::IsEqualInsensitive(useVirtualClock, "TRUE"))
+    {
+      this->SetUseVirtualClock(true);
+    }
+    else if (PlusCommon::IsEqualInsensitive(useVirtualClock, "FALSE"))
+    {
+      this->SetUseVirtualClock(false);
+    }
+    else
+    {
+      LOG_WARNING("Failed to read UseVirtualClock attribute: expected 'TRUE' or 'FALSE', got '" << useVirtualClock << "'");
+    }
+  }
+  double virtualClockStartTimeSec(0.0);
+  if (dataCollectionElement->GetScalarAttribute("VirtualClockStartTimeSec", virtualClockStartTimeSec))
+  {
+    this->SetVirtualClockStartTimeSec(virtualClockStartTimeSec);
+    LOG_DEBUG("VirtualClockStartTimeSec: " << std::fixed << virtualClockStartTimeSec);
+  }
+
   std::set<std::string> existingDeviceIds;
 
   for (int i = 0; i < dataCollectionElement->GetNumberOfNestedElements(); ++i)
@@ -161,6 +215,8 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     LOG_WARNING("No output channels defined. Unable to locate any for data collection.");
   }
 
+  this->AssignFrameMemoryPoolToBuffers();
+
   // Connect any and all input streams to their corresponding output streams
   for (int i = 0; i < dataCollectionElement->GetNumberOfNestedElements(); ++i)
   {
@@ -243,6 +299,21 @@ PlusStatus vtkPlusDataCollector::WriteConfiguration(vtkXMLDataElement* aConfig)
   }
 
   dataCollectionConfig->SetDoubleAttribute("StartupDelaySec", GetStartupDelaySec());
+  dataCollectionConfig->SetAttribute("UseFrameMemoryPool", this->FrameMemoryPool != NULL ? "TRUE" : "FALSE");
+  if (this->FrameMemoryPool != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("FrameMemoryPoolMaximumCachedSizeMb", this->FrameMemoryPool->GetMaximumCachedSizeBytes() / (1024.0 * 1024.0));
+  }
+  if (this->UseVirtualClock)
+  {
+    dataCollectionConfig->SetAttribute("UseVirtualClock", "TRUE");
+    dataCollectionConfig->SetDoubleAttribute("VirtualClockStartTimeSec", this->VirtualClockStartTimeSec);
+  }
+  else
+  {
+    dataCollectionConfig->RemoveAttribute("UseVirtualClock");
+    dataCollectionConfig->RemoveAttribute("VirtualClockStartTimeSec");
+  }
 
   PlusStatus status = PLUS_SUCCESS;
 
@@ -282,6 +353,18 @@ PlusStatus vtkPlusDataCollector::Start()
 
   PlusStatus status = PLUS_SUCCESS;
 
+  if (this->UseVirtualClock)
+  {
+    // Devices do not start their data capture threads while the virtual clock is enabled.
+    // The clock stays enabled until disconnect, so after a restart the time continues from where it was stopped.
+    if (!vtkPlusAccurateTimer::IsVirtualClockEnabled())
+    {
+      vtkPlusAccurateTimer::SetVirtualTime(this->VirtualClockStartTimeSec);
+      vtkPlusAccurateTimer::SetVirtualClockEnabled(true);
+    }
+    LOG_INFO("Data collection uses virtual clock, devices are updated in lock-step as fast as possible");
+  }
+
   const double startTime = vtkPlusAccurateTimer::GetSystemTime();
 
   for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
@@ -298,7 +381,19 @@ PlusStatus vtkPlusDataCollector::Start()
 
   LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
 
-  vtkPlusAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  if (this->UseVirtualClock)
+  {
+    this->StartVirtualClockThread();
+    // Wait until the startup delay has elapsed in simulated time
+    while (this->VirtualClockThreadActive.first && vtkPlusAccurateTimer::GetVirtualTime() < startTime + this->StartupDelaySec)
+    {
+      vtkPlusAccurateTimer::Delay(0.001);
+    }
+  }
+  else
+  {
+    vtkPlusAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  }
 
   this->Started = true;
 
@@ -310,11 +405,111 @@ PlusStatus vtkPlusDataCollector::Stop()
 {
   LOG_TRACE("vtkPlusDataCollector::Stop()");
 
+  this->StopVirtualClockThread();
+
   this->Started = false;
 
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::StartVirtualClockThread()
+{
+  if (this->VirtualClockThreadId >= 0)
+  {
+    return;
+  }
+
+  const double startTime = vtkPlusAccurateTimer::GetVirtualTime();
+  this->VirtualClockNextUpdateTimes.clear();
+  for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++it)
+  {
+    vtkPlusDevice* device = *it;
+    if (device->IsRecording() && device->GetStartThreadForInternalUpdates() && device->GetAcquisitionRate() > 0)
+    {
+      this->VirtualClockNextUpdateTimes.push_back(startTime);
+      continue;
+    }
+    this->VirtualClockNextUpdateTimes.push_back(UNDEFINED_TIMESTAMP);
+    if (!device->IsVirtual() && !device->GetStartThreadForInternalUpdates())
+    {
+      LOG_WARNING("Device " << device->GetDeviceId() << " acquires data without a data capture thread, its data is not synchronized to the virtual clock");
+    }
+  }
+
+  this->VirtualClockThreadActive.first = true;
+  this->VirtualClockThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&VirtualClockThread, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::StopVirtualClockThread()
+{
+  if (this->VirtualClockThreadId < 0)
+  {
+    return;
+  }
+  this->VirtualClockThreadActive.first = false;
+  while (this->VirtualClockThreadActive.second)
+  {
+    vtkPlusAccurateTimer::Delay(0.01);
+  }
+  this->VirtualClockThreadId = -1;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusDataCollector::VirtualClockThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusDataCollector* self = (vtkPlusDataCollector*)(data->UserData);
+  self->VirtualClockThreadActive.second = true;
+
+  while (self->VirtualClockThreadActive.first)
+  {
+    if (!self->AdvanceVirtualClock())
+    {
+      LOG_WARNING("No device is updated by the virtual clock, virtual time is not advanced anymore");
+      break;
+    }
+  }
+
+  self->VirtualClockThreadActive.first = false;
+  self->VirtualClockThreadActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusDataCollector::AdvanceVirtualClock()
+{
+  double nextUpdateTime = UNDEFINED_TIMESTAMP;
+  for (std::vector<double>::iterator it = this->VirtualClockNextUpdateTimes.begin(); it != this->VirtualClockNextUpdateTimes.end(); ++it)
+  {
+    nextUpdateTime = std::min(nextUpdateTime, *it);
+  }
+  if (nextUpdateTime == UNDEFINED_TIMESTAMP)
+  {
+    return false;
+  }
+
+  vtkPlusAccurateTimer::SetVirtualTime(nextUpdateTime);
+
+  // Devices are updated in the order of the device set, so data that is acquired at this time
+  // is already available to the virtual devices that are defined later in the device set.
+  for (unsigned int deviceIndex = 0; deviceIndex < this->Devices.size(); ++deviceIndex)
+  {
+    if (this->VirtualClockNextUpdateTimes[deviceIndex] > nextUpdateTime)
+    {
+      continue;
+    }
+    vtkPlusDevice* device = this->Devices[deviceIndex];
+    if (device->LockStepUpdate() != PLUS_SUCCESS)
+    {
+      LOG_DEBUG("Lock-step update of device " << device->GetDeviceId() << " failed at virtual time " << std::fixed << nextUpdateTime);
+    }
+    this->VirtualClockNextUpdateTimes[deviceIndex] = nextUpdateTime + 1.0 / device->GetAcquisitionRate();
+  }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataCollector::Connect()
 {
@@ -322,6 +517,9 @@ PlusStatus vtkPlusDataCollector::Connect()
 
   PlusStatus status = PLUS_SUCCESS;
 
+  // Devices may have added video sources since the configuration was read
+  this->AssignFrameMemoryPoolToBuffers();
+
   for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
   {
     vtkPlusDevice* device = *it;
@@ -370,6 +568,11 @@ PlusStatus vtkPlusDataCollector::Disconnect()
   Connected = false;
   LOG_DEBUG("vtkPlusDataCollector::Disconnect: All devices have been disconnected");
 
+  if (this->UseVirtualClock)
+  {
+    vtkPlusAccurateTimer::SetVirtualClockEnabled(false);
+  }
+
   return status;
 }
 
@@ -385,6 +588,48 @@ void vtkPlusDataCollector::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "Device: " << std::endl;
     (*it)->PrintSelf(os, indent);
   }
+
+  os << indent << "UseVirtualClock: " << (this->UseVirtualClock ? "TRUE" : "FALSE") << std::endl;
+  os << indent << "VirtualClockStartTimeSec: " << this->VirtualClockStartTimeSec << std::endl;
+  os << indent << "FrameMemoryPool: " << this->FrameMemoryPool.GetPointer() << std::endl;
+  if (this->FrameMemoryPool != NULL)
+  {
+    this->FrameMemoryPool->PrintSelf(os, indent.GetNextIndent());
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool)
+{
+  if (this->FrameMemoryPool == frameMemoryPool)
+  {
+    return;
+  }
+  this->FrameMemoryPool = frameMemoryPool;
+  this->AssignFrameMemoryPoolToBuffers();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPlusFrameMemoryPool* vtkPlusDataCollector::GetFrameMemoryPool() const
+{
+  return this->FrameMemoryPool;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::AssignFrameMemoryPoolToBuffers()
+{
+  for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    for (DataSourceContainerConstIterator sourceIt = (*it)->GetVideoSourceIteratorBegin(); sourceIt != (*it)->GetVideoSourceIteratorEnd(); ++sourceIt)
+    {
+      vtkPlusDataSource* videoSource = sourceIt->second;
+      if (videoSource != NULL && videoSource->GetBuffer() != NULL)
+      {
+        videoSource->GetBuffer()->SetFrameMemoryPool(this->FrameMemoryPool);
+      }
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -13,11 +13,13 @@ See License.txt for details.
 #include "vtkPlusDevice.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkObject.h>
 
 class PlusTrackedFrame;
 class vtkPlusChannel;
 class vtkPlusDeviceFactory;
+class vtkPlusFrameMemoryPool;
 class vtkPlusTrackedFrameList;
 class vtkXMLDataElement;
 
@@ -153,6 +155,31 @@ public:
   /*! Get startup delay in sec to give some time to the buffers for proper initialization */
   vtkGetMacro(StartupDelaySec, double);
 
+  /*!
+    Set the pool that the video frames of the device buffers (and their copies) are allocated from.
+    If NULL then frame pixel buffers are allocated by VTK. The data collector creates a pool by default.
+  */
+  void SetFrameMemoryPool(vtkPlusFrameMemoryPool* frameMemoryPool);
+  /*! Get the pool that video frames are allocated from, e.g., to check the allocation counters */
+  vtkPlusFrameMemoryPool* GetFrameMemoryPool() const;
+
+  /*!
+    If enabled, then the devices are not updated by their own data capture threads, but in lock-step with
+    a virtual clock (see vtkPlusAccurateTimer::SetVirtualClockEnabled) that is advanced as fast as possible.
+    Each device is updated at its acquisition rate in simulated time, in the order of the device set.
+    Devices that acquire data from their own threads or callbacks are not synchronized to the virtual clock.
+  */
+  vtkSetMacro(UseVirtualClock, bool);
+  vtkGetMacro(UseVirtualClock, bool);
+
+  /*!
+    Set the system time that the virtual clock is set to when data collection is first started after connecting, in seconds.
+    When data collection is stopped and started again, the virtual time continues from where it was stopped.
+  */
+  vtkSetMacro(VirtualClockStartTimeSec, double);
+  /*! Get the system time that the virtual clock is set to when data collection is first started after connecting, in seconds */
+  vtkGetMacro(VirtualClockStartTimeSec, double);
+
 protected:
   vtkPlusDataCollector();
   virtual ~vtkPlusDataCollector();
@@ -162,6 +189,43 @@ protected:
 
   vtkSmartPointer<vtkPlusDeviceFactory> DeviceFactory;
 
+  /*! Set the frame memory pool in the buffers of all video sources */
+  void AssignFrameMemoryPoolToBuffers();
+
+  /*! Pool that the video frames are allocated from */
+  vtkSmartPointer<vtkPlusFrameMemoryPool> FrameMemoryPool;
+
+  /*! Schedule the lock-step updates of the recording devices and start the virtual clock thread */
+  void StartVirtualClockThread();
+
+  /*! Stop the virtual clock thread and wait until it is terminated */
+  void StopVirtualClockThread();
+
+  /*! Thread function that advances the virtual clock until the thread is stopped or no device is scheduled for update */
+  static void* VirtualClockThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*!
+    Advance the virtual clock to the earliest scheduled device update and perform all the updates that are due at that time.
+    \return false if no device is scheduled for update
+  */
+  bool AdvanceVirtualClock();
+
+  /*! If enabled, then devices are updated in lock-step with the virtual clock */
+  bool UseVirtualClock;
+
+  /*! System time that the virtual clock is set to when data collection is started, in seconds */
+  double VirtualClockStartTimeSec;
+
+  /*! Virtual time of the next update of each device (in the order of Devices), UNDEFINED_TIMESTAMP if the device is not updated by the virtual clock */
+  std::vector<double> VirtualClockNextUpdateTimes;
+
+  vtkSmartPointer<vtkMultiThreader> Threader;
+
+  /*! First: virtual clock thread is requested to run, second: virtual clock thread is running */
+  std::pair<bool, bool> VirtualClockThreadActive;
+
+  int VirtualClockThreadId;
+
   DeviceCollection Devices;
 
   bool Connected;
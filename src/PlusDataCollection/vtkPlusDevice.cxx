@@ -26,8 +26,15 @@ See License.txt for details.
 #include <vtksys/SystemTools.hxx>
 
 // System includes
+#include <algorithm>
 #include <ctype.h>
+#include <math.h>
 #include <time.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#endif
 
 #if ( _MSC_VER >= 1300 ) // Visual studio .NET
 #pragma warning ( disable : 4311 )
@@ -149,6 +156,14 @@ vtkPlusDevice::vtkPlusDevice()
   , OutputNeedsInitialization(1)
   , CorrectlyConfigured(true)
   , StartThreadForInternalUpdates(false)
+  , ThreadRealTimePriority(0)
+  , ThreadDeadlineWakeup(false)
+  , NumberOfDataCaptureLoops(0)
+  , NumberOfDataCaptureLoopOverruns(0)
+  , NumberOfDataCaptureWakeups(0)
+  , DataCaptureWakeupJitterSumSec(0.0)
+  , MaxDataCaptureWakeupJitterSec(0.0)
+  , DataCaptureStatisticsMutex(vtkPlusRecursiveCriticalSection::New())
   , LocalTimeOffsetSec(0.0)
   , MissingInputGracePeriodSec(0.0)
   , RequireImageOrientationInConfiguration(false)
@@ -197,6 +212,7 @@ vtkPlusDevice::~vtkPlusDevice()
   DELETE_IF_NOT_NULL(this->Threader);
 
   DELETE_IF_NOT_NULL(this->UpdateMutex);
+  DELETE_IF_NOT_NULL(this->DataCaptureStatisticsMutex);
 
   LOCAL_LOG_TRACE("vtkPlusDevice::~vtkPlusDevice() completed");
 }
@@ -210,6 +226,22 @@ void vtkPlusDevice::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "SDK version: " << this->GetSdkVersion() << "\n";
   os << indent << "AcquisitionRate: " << this->AcquisitionRate << "\n";
   os << indent << "Recording: " << (this->Recording ? "On\n" : "Off\n");
+  if (this->StartThreadForInternalUpdates)
+  {
+    os << indent << "ThreadRealTimePriority: " << this->ThreadRealTimePriority << "\n";
+    os << indent << "ThreadCpuAffinity:";
+    for (std::vector<int>::const_iterator it = this->ThreadCpuAffinity.begin(); it != this->ThreadCpuAffinity.end(); ++it)
+    {
+      os << " " << *it;
+    }
+    os << "\n";
+    os << indent << "ThreadDeadlineWakeup: " << (this->ThreadDeadlineWakeup ? "TRUE\n" : "FALSE\n");
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+    os << indent << "NumberOfDataCaptureLoops: " << this->NumberOfDataCaptureLoops << "\n";
+    os << indent << "NumberOfDataCaptureLoopOverruns: " << this->NumberOfDataCaptureLoopOverruns << "\n";
+    os << indent << "MeanDataCaptureWakeupJitterSec: " << this->GetMeanDataCaptureWakeupJitterSec() << "\n";
+    os << indent << "MaxDataCaptureWakeupJitterSec: " << this->MaxDataCaptureWakeupJitterSec << "\n";
+  }
 
   for (ChannelContainerConstIterator it = this->OutputChannels.begin(); it != this->OutputChannels.end(); ++it)
   {
@@ -1053,6 +1085,27 @@ PlusStatus vtkPlusDevice::ReadConfiguration(vtkXMLDataElement* rootXMLElement)
     LOCAL_LOG_DEBUG("Unable to find acquisition rate in device element when it is required, using default " << this->GetAcquisitionRate());
   }
 
+  // Data capture thread scheduling
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, ThreadRealTimePriority, deviceXMLElement);
+  const char* threadCpuAffinity = deviceXMLElement->GetAttribute("ThreadCpuAffinity");
+  if (threadCpuAffinity != NULL)
+  {
+    std::vector<int> cpuIndices;
+    std::vector<std::string> cpuIndexStrings = PlusCommon::SplitStringIntoTokens(threadCpuAffinity, ' ', false);
+    for (std::vector<std::string>::iterator it = cpuIndexStrings.begin(); it != cpuIndexStrings.end(); ++it)
+    {
+      int cpuIndex = -1;
+      if (PlusCommon::StringToInt(it->c_str(), cpuIndex) != PLUS_SUCCESS || cpuIndex < 0)
+      {
+        LOCAL_LOG_WARNING("Invalid CPU index '" << *it << "' in ThreadCpuAffinity attribute, it is ignored");
+        continue;
+      }
+      cpuIndices.push_back(cpuIndex);
+    }
+    this->SetThreadCpuAffinity(cpuIndices);
+  }
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ThreadDeadlineWakeup, deviceXMLElement);
+
   vtkXMLDataElement* outputChannelsElement = deviceXMLElement->FindNestedElementWithName("OutputChannels");
   if (outputChannelsElement != NULL)
   {
@@ -1178,6 +1231,24 @@ PlusStatus vtkPlusDevice::WriteConfiguration(vtkXMLDataElement* config)
     deviceDataElement->SetDoubleAttribute("LocalTimeOffsetSec", this->GetLocalTimeOffsetSec());
   }
 
+  if (this->ThreadRealTimePriority != 0)
+  {
+    deviceDataElement->SetIntAttribute("ThreadRealTimePriority", this->ThreadRealTimePriority);
+  }
+  if (!this->ThreadCpuAffinity.empty())
+  {
+    std::ostringstream cpuIndices;
+    for (std::vector<int>::const_iterator it = this->ThreadCpuAffinity.begin(); it != this->ThreadCpuAffinity.end(); ++it)
+    {
+      cpuIndices << (it == this->ThreadCpuAffinity.begin() ? "" : " ") << *it;
+    }
+    deviceDataElement->SetAttribute("ThreadCpuAffinity", cpuIndices.str().c_str());
+  }
+  if (this->ThreadDeadlineWakeup)
+  {
+    deviceDataElement->SetAttribute("ThreadDeadlineWakeup", "TRUE");
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -1259,7 +1330,17 @@ PlusStatus vtkPlusDevice::StartRecording()
   this->RecordingStartTime = vtkPlusAccurateTimer::GetSystemTime();
   this->Recording = 1;
 
-  if (this->StartThreadForInternalUpdates)
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+    this->NumberOfDataCaptureLoops = 0;
+    this->NumberOfDataCaptureLoopOverruns = 0;
+    this->NumberOfDataCaptureWakeups = 0;
+    this->DataCaptureWakeupJitterSumSec = 0.0;
+    this->MaxDataCaptureWakeupJitterSec = 0.0;
+  }
+
+  // With the virtual clock the device is updated by the data collector (see LockStepUpdate)
+  if (this->StartThreadForInternalUpdates && !vtkPlusAccurateTimer::IsVirtualClockEnabled())
   {
     this->ThreadId =
       this->Threader->SpawnThread((vtkThreadFunctionType)\
@@ -1297,6 +1378,13 @@ PlusStatus vtkPlusDevice::StopRecording()
     }
     this->ThreadId = -1;
     LOCAL_LOG_DEBUG("Internal update thread terminated");
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+    if (this->NumberOfDataCaptureLoops > 0)
+    {
+      LOCAL_LOG_DEBUG("Data capture loop statistics: " << this->NumberOfDataCaptureLoops << " iterations, "
+                      << this->NumberOfDataCaptureLoopOverruns << " overruns, wakeup jitter mean = "
+                      << this->GetMeanDataCaptureWakeupJitterSec() * 1000.0 << "ms, max = " << this->MaxDataCaptureWakeupJitterSec * 1000.0 << "ms");
+    }
   }
 
   if (this->InternalStopRecording() != PLUS_SUCCESS)
@@ -1321,9 +1409,16 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
   unsigned long updatecount = 0;
   self->ThreadAlive = true;
 
+  self->ApplyDataCaptureThreadScheduling();
+
+  // Scheduled wakeup time of the next loop iteration
+  double wakeupTime = UNDEFINED_TIMESTAMP;
+
   while (self->IsRecording() && self->GetCorrectlyConfigured())
   {
     double newtime = vtkPlusAccurateTimer::GetSystemTime();
+    // Negative if the loop iteration was not scheduled (first iteration)
+    const double wakeupJitterSec = (wakeupTime != UNDEFINED_TIMESTAMP ? fabs(newtime - wakeupTime) : -1.0);
     // get current tracking rate over last few updates
     double difftime = newtime - currtime[updatecount % FRAME_RATE_AVERAGING];
     currtime[updatecount % FRAME_RATE_AVERAGING] = newtime;
@@ -1344,10 +1439,46 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
       self->UpdateTime.Modified();
     }
 
-    double delay = (newtime + 1.0 / rate - vtkPlusAccurateTimer::GetSystemTime());
-    if (delay > 0)
+    if (self->ThreadDeadlineWakeup && wakeupTime != UNDEFINED_TIMESTAMP)
+    {
+      // Deadlines are spaced by the acquisition period, regardless of the actual wakeup time
+      wakeupTime += 1.0 / rate;
+    }
+    else
     {
-      vtkPlusAccurateTimer::Delay(delay);
+      wakeupTime = newtime + 1.0 / rate;
+    }
+
+    double currentTime = vtkPlusAccurateTimer::GetSystemTime();
+    const bool overrun = (currentTime >= wakeupTime);
+
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(self->DataCaptureStatisticsMutex);
+      if (wakeupJitterSec >= 0)
+      {
+        self->DataCaptureWakeupJitterSumSec += wakeupJitterSec;
+        self->MaxDataCaptureWakeupJitterSec = std::max(self->MaxDataCaptureWakeupJitterSec, wakeupJitterSec);
+        self->NumberOfDataCaptureWakeups++;
+      }
+      self->NumberOfDataCaptureLoops++;
+      if (overrun)
+      {
+        self->NumberOfDataCaptureLoopOverruns++;
+      }
+    }
+
+    if (overrun)
+    {
+      // The update took longer than the acquisition period, start the next iteration immediately
+      wakeupTime = currentTime;
+    }
+    else if (self->ThreadDeadlineWakeup)
+    {
+      vtkPlusAccurateTimer::DelayUntil(wakeupTime);
+    }
+    else
+    {
+      vtkPlusAccurateTimer::Delay(wakeupTime - currentTime);
     }
 
     updatecount++;
@@ -1551,6 +1682,82 @@ PlusStatus vtkPlusDevice::ForceUpdate()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusDevice::ApplyDataCaptureThreadScheduling()
+{
+  if (this->ThreadRealTimePriority > 0)
+  {
+#ifdef _WIN32
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+    {
+      LOCAL_LOG_WARNING("Failed to set time-critical priority for the data capture thread (error code: " << GetLastError() << ")");
+    }
+#else
+    struct sched_param schedulingParameters;
+    memset(&schedulingParameters, 0, sizeof(schedulingParameters));
+    schedulingParameters.sched_priority = this->ThreadRealTimePriority;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &schedulingParameters);
+    if (result != 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set real-time priority " << this->ThreadRealTimePriority << " for the data capture thread: " << strerror(result)
+                        << ". Real-time scheduling usually requires elevated privileges.");
+    }
+    else
+    {
+      LOCAL_LOG_DEBUG("Data capture thread uses real-time priority " << this->ThreadRealTimePriority);
+    }
+#endif
+  }
+
+  if (!this->ThreadCpuAffinity.empty())
+  {
+#if defined(_WIN32)
+    DWORD_PTR affinityMask = 0;
+    for (std::vector<int>::const_iterator it = this->ThreadCpuAffinity.begin(); it != this->ThreadCpuAffinity.end(); ++it)
+    {
+      if (*it < static_cast<int>(sizeof(DWORD_PTR) * 8))
+      {
+        affinityMask |= (static_cast<DWORD_PTR>(1) << *it);
+      }
+    }
+    if (affinityMask == 0 || SetThreadAffinityMask(GetCurrentThread(), affinityMask) == 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set CPU affinity of the data capture thread (error code: " << GetLastError() << ")");
+    }
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (std::vector<int>::const_iterator it = this->ThreadCpuAffinity.begin(); it != this->ThreadCpuAffinity.end(); ++it)
+    {
+      if (*it < CPU_SETSIZE)
+      {
+        CPU_SET(*it, &cpuSet);
+      }
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+    if (result != 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set CPU affinity of the data capture thread: " << strerror(result));
+    }
+#else
+    LOCAL_LOG_WARNING("Setting CPU affinity of the data capture thread is not supported on this platform");
+#endif
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDevice::LockStepUpdate()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  if (!this->Recording || !this->GetCorrectlyConfigured())
+  {
+    return PLUS_SUCCESS;
+  }
+  PlusStatus status = this->InternalUpdate();
+  this->UpdateTime.Modified();
+  return status;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::ToolTimeStampedUpdateWithoutFiltering(const std::string& aToolSourceId, vtkMatrix4x4* matrix, ToolStatus status, double unfilteredtimestamp, double filteredtimestamp, const PlusTrackedFrame::FieldMapType* customFields /* = NULL */)
 {
@@ -2026,6 +2233,50 @@ void vtkPlusDevice::InternalWriteInputChannels(vtkXMLDataElement* rootXMLElement
   }
 }
 
+//----------------------------------------------------------------------------
+unsigned long vtkPlusDevice::GetNumberOfDataCaptureLoops() const
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+  return this->NumberOfDataCaptureLoops;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkPlusDevice::GetNumberOfDataCaptureLoopOverruns() const
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+  return this->NumberOfDataCaptureLoopOverruns;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusDevice::GetMeanDataCaptureWakeupJitterSec() const
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+  if (this->NumberOfDataCaptureWakeups == 0)
+  {
+    return 0.0;
+  }
+  return this->DataCaptureWakeupJitterSumSec / this->NumberOfDataCaptureWakeups;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusDevice::GetMaxDataCaptureWakeupJitterSec() const
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> statisticsGuardedLock(this->DataCaptureStatisticsMutex);
+  return this->MaxDataCaptureWakeupJitterSec;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDevice::SetThreadCpuAffinity(const std::vector<int>& cpuIndices)
+{
+  this->ThreadCpuAffinity = cpuIndices;
+}
+
+//----------------------------------------------------------------------------
+const std::vector<int>& vtkPlusDevice::GetThreadCpuAffinity() const
+{
+  return this->ThreadCpuAffinity;
+}
+
 //----------------------------------------------------------------------------
 bool vtkPlusDevice::GetStartThreadForInternalUpdates() const
 {
@@ -102,6 +102,13 @@ public:
   */
   virtual PlusStatus ForceUpdate();
 
+  /*!
+  Perform one update of a recording device the same way as its data capture thread does.
+  When the virtual clock is enabled, no data capture thread is started and the data collector
+  calls this method in lock-step with the virtual clock instead.
+  */
+  PlusStatus LockStepUpdate();
+
   /*!
   Disconnect from device.
   This method must be called before application exit, or else the
@@ -171,6 +178,40 @@ public:
   /*! Get the internal update rate for this tracking system.  This is the number of buffer entry items sent by the device per second (per tool). */
   double GetInternalUpdateRate() const;
 
+  /*! Get the number of data capture thread loop iterations since recording was started */
+  unsigned long GetNumberOfDataCaptureLoops() const;
+
+  /*! Get the number of data capture thread loop iterations that were not completed by the next scheduled wakeup time */
+  unsigned long GetNumberOfDataCaptureLoopOverruns() const;
+
+  /*! Get the average delay of the data capture thread wakeups compared to the scheduled wakeup times, in seconds */
+  double GetMeanDataCaptureWakeupJitterSec() const;
+
+  /*! Get the maximum delay of the data capture thread wakeups compared to the scheduled wakeup times, in seconds */
+  double GetMaxDataCaptureWakeupJitterSec() const;
+
+  /*!
+    Set the real-time (SCHED_FIFO) priority of the data capture thread (1-99).
+    0 means normal scheduling. Setting real-time priority usually requires elevated privileges.
+    On Windows any positive value sets time-critical thread priority.
+  */
+  vtkSetMacro(ThreadRealTimePriority, int);
+  /*! Get the real-time priority of the data capture thread. 0 means normal scheduling. */
+  vtkGetMacro(ThreadRealTimePriority, int);
+
+  /*! Set the indices of the CPUs that the data capture thread is allowed to run on. Empty list means no restriction. */
+  void SetThreadCpuAffinity(const std::vector<int>& cpuIndices);
+  /*! Get the indices of the CPUs that the data capture thread is allowed to run on */
+  const std::vector<int>& GetThreadCpuAffinity() const;
+
+  /*!
+    If enabled, the data capture thread wakes up at absolute deadlines that are spaced by the acquisition period,
+    so wakeup delays do not accumulate. If disabled, the next wakeup is scheduled one period after the current wakeup.
+  */
+  vtkSetMacro(ThreadDeadlineWakeup, bool);
+  /*! Get whether the data capture thread wakes up at absolute deadlines */
+  vtkGetMacro(ThreadDeadlineWakeup, bool);
+
   /*! Get the data source object for the specified Id name, checks both video and tools */
   PlusStatus GetDataSource(const char* aSourceId, vtkPlusDataSource*& aSource);
   PlusStatus GetDataSource(const std::string& aSourceId, vtkPlusDataSource*& aSource);
@@ -467,6 +508,9 @@ public:
 protected:
   static void* vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data);
 
+  /*! Apply the configured priority and CPU affinity to the calling thread. Called by the data capture thread when it starts. */
+  void ApplyDataCaptureThreadScheduling();
+
   /* Construct a lookup table for indexing channels by depth, mode and probe */
   PlusStatus BuildParameterIndexList(const ChannelContainer& channels, bool& depthSwitchingEnabled, bool& modeSwitchingEnabled, bool& probeSwitchingEnabled, std::vector<ParamIndexKey*>& output);
 
@@ -612,6 +656,33 @@ protected:
   */
   bool StartThreadForInternalUpdates;
 
+  /*! Real-time priority of the data capture thread, 0 means normal scheduling */
+  int ThreadRealTimePriority;
+
+  /*! Indices of the CPUs that the data capture thread is allowed to run on, empty means no restriction */
+  std::vector<int> ThreadCpuAffinity;
+
+  /*! If enabled, the data capture thread wakes up at absolute deadlines */
+  bool ThreadDeadlineWakeup;
+
+  /*! Number of data capture thread loop iterations since recording was started */
+  unsigned long NumberOfDataCaptureLoops;
+
+  /*! Number of data capture thread loop iterations that were not completed by the next scheduled wakeup time */
+  unsigned long NumberOfDataCaptureLoopOverruns;
+
+  /*! Number of data capture thread wakeups that the jitter statistics are computed from */
+  unsigned long NumberOfDataCaptureWakeups;
+
+  /*! Sum of the data capture thread wakeup delays, in seconds */
+  double DataCaptureWakeupJitterSumSec;
+
+  /*! Maximum data capture thread wakeup delay, in seconds */
+  double MaxDataCaptureWakeupJitterSec;
+
+  /*! Protects the data capture loop statistics, which are updated by the data capture thread and read by any thread */
+  vtkPlusRecursiveCriticalSection* DataCaptureStatisticsMutex;
+
   /*! Value to use when mixing data with another temporally calibrated device*/
   double LocalTimeOffsetSec;
 
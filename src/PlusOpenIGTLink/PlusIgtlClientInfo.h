@@ -69,7 +69,7 @@ struct vtkPlusOpenIGTLinkExport PlusIgtlClientInfo
   std::vector<ImageStream> ImageStreams;
 
   /*! A new TDATA is only sent if the time elapsed is at least the resolution
-     value (otherwise we don't send this tracking data to the client) */
+     value in milliseconds (otherwise we don't send this tracking data to the client) */
   int Resolution;
 
   /*! flag for start TDATA transmission request: true on STT, false on STP.
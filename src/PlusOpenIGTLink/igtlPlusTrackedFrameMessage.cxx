@@ -82,7 +82,7 @@ namespace igtl
   }
 
   //----------------------------------------------------------------------------
-  PlusTrackedFrame PlusTrackedFrameMessage::GetTrackedFrame()
+  PlusTrackedFrame& PlusTrackedFrameMessage::GetTrackedFrame()
   {
     return this->m_TrackedFrame;
   }
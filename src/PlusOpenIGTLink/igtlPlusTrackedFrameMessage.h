@@ -48,8 +48,8 @@ namespace igtl
     /*! Set Plus TrackedFrame */
     PlusStatus SetTrackedFrame(const PlusTrackedFrame& trackedFrame, const std::vector<PlusTransformName>& requestedTransforms);
 
-    /*! Get Plus TrackedFrame */
-    PlusTrackedFrame GetTrackedFrame();
+    /*! Get Plus TrackedFrame. The returned frame is owned by the message and is overwritten by the next Unpack. */
+    PlusTrackedFrame& GetTrackedFrame();
 
     /*! Set the embedded transform of the underlying image */
     PlusStatus SetEmbeddedImageTransform(vtkSmartPointer<vtkMatrix4x4> matrix);
@@ -389,26 +389,43 @@ PlusStatus vtkPlusIgtlMessageCommon::UnpackImageMessage(igtl::MessageHeader::Poi
   if (embeddedTransformName.IsValid())
   {
     // Save the transform that is embedded in the IMAGE message into the tracked frame
-    // igtlMatrix origin is in the image center
-    // vtkMatrix origin is in the image corner
-    vtkSmartPointer<vtkMatrix4x4> igtlMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer< vtkMatrix4x4 > vtkMatrix = vtkSmartPointer< vtkMatrix4x4 >::New();
+    vtkPlusIgtlMessageCommon::GetImageMessageEmbeddedTransform(imgMsg, vtkMatrix);
+    trackedFrame.SetCustomFrameTransform(embeddedTransformName, vtkMatrix);
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// static
+PlusStatus vtkPlusIgtlMessageCommon::GetImageMessageEmbeddedTransform(igtl::ImageMessage::Pointer imageMessage, vtkMatrix4x4* embeddedTransform)
+{
+  if (imageMessage.IsNull() || embeddedTransform == NULL)
+  {
+    LOG_ERROR("Unable to get embedded transform from image message - invalid input!");
+    return PLUS_FAIL;
+  }
+
+  // igtlMatrix origin is in the image center
+  // vtkMatrix origin is in the image corner
+  vtkSmartPointer<vtkMatrix4x4> igtlMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  {
+    igtl::Matrix4x4 igtlMatrixSource;
+    imageMessage->GetMatrix(igtlMatrixSource);
+    for (int row = 0; row < 4; ++ row)
     {
-      igtl::Matrix4x4 igtlMatrixSource;
-      imgMsg->GetMatrix(igtlMatrixSource);
-      for (int row = 0; row < 4; ++ row)
+      for (int col = 0; col < 4; ++ col)
       {
-        for (int col = 0; col < 4; ++ col)
-        {
-          igtlMatrix->SetElement(row, col, igtlMatrixSource[row][col]);
-        }
+        igtlMatrix->SetElement(row, col, igtlMatrixSource[row][col]);
       }
     }
-    vtkSmartPointer<vtkTransform> igtlToVtkTransform = vtkSmartPointer<vtkTransform>::New();
-    igtlToVtkTransform->Translate(-imgSize[ 0 ] / 2.0, -imgSize[ 1 ] / 2.0, -imgSize[ 2 ] / 2.0);
-    vtkSmartPointer< vtkMatrix4x4 > vtkMatrix = vtkSmartPointer< vtkMatrix4x4 >::New();
-    vtkMatrix4x4::Multiply4x4(igtlMatrix, igtlToVtkTransform->GetMatrix(), vtkMatrix);
-    trackedFrame.SetCustomFrameTransform(embeddedTransformName, vtkMatrix);
   }
+  int imgSize[3] = {0}; // image dimension in pixels
+  imageMessage->GetDimensions(imgSize);
+  vtkSmartPointer<vtkTransform> igtlToVtkTransform = vtkSmartPointer<vtkTransform>::New();
+  igtlToVtkTransform->Translate(-imgSize[ 0 ] / 2.0, -imgSize[ 1 ] / 2.0, -imgSize[ 2 ] / 2.0);
+  vtkMatrix4x4::Multiply4x4(igtlMatrix, igtlToVtkTransform->GetMatrix(), embeddedTransform);
 
   return PLUS_SUCCESS;
 }
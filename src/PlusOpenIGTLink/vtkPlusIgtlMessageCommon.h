@@ -61,6 +61,9 @@ public:
   /*! Unpack image message to tracked frame */
   static PlusStatus UnpackImageMessage(igtl::MessageHeader::Pointer headerMsg, igtl::Socket* socket, PlusTrackedFrame& trackedFrame, const PlusTransformName& embeddedTransformName, int crccheck);
 
+  /*! Get the image to reference transform embedded in an unpacked image message, with the origin moved from the image center to the image corner */
+  static PlusStatus GetImageMessageEmbeddedTransform(igtl::ImageMessage::Pointer imageMessage, vtkMatrix4x4* embeddedTransform);
+
   /*! Pack image message from vtkImageData volume */
   static PlusStatus PackImageMessage(igtl::ImageMessage::Pointer imageMessage, vtkImageData* volume, vtkMatrix4x4* volumeToReferenceTransform, double timestamp);
 
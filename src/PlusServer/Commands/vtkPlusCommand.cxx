@@ -14,12 +14,16 @@
 
 const std::string vtkPlusCommand::DEVICE_NAME_COMMAND = "CMD";
 const std::string vtkPlusCommand::DEVICE_NAME_REPLY = "ACK";
+const std::string vtkPlusCommand::JOB_ID_PARAMETER_NAME = "JobId";
+const std::string vtkPlusCommand::JOB_STATUS_PARAMETER_NAME = "JobStatus";
+const std::string vtkPlusCommand::JOB_PROGRESS_PARAMETER_NAME = "JobProgress";
 
 //----------------------------------------------------------------------------
 vtkPlusCommand::vtkPlusCommand()
   : CommandProcessor(NULL)
   , ClientId(0)
   , Id(0)
+  , JobId(0)
   , RespondWithCommandMessage(true)
 {
 }
@@ -33,6 +37,30 @@ vtkPlusCommand::~vtkPlusCommand()
 void vtkPlusCommand::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "ConcurrencyClass: " << GetConcurrencyClassAsString(this->GetConcurrencyClass()) << std::endl;
+  os << indent << "JobId: " << this->JobId << std::endl;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusCommand::CommandConcurrencyClass vtkPlusCommand::GetConcurrencyClass()
+{
+  return COMMAND_CONCURRENCY_EXCLUSIVE;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusCommand::GetConcurrencyClassAsString(CommandConcurrencyClass concurrencyClass)
+{
+  switch (concurrencyClass)
+  {
+    case COMMAND_CONCURRENCY_FAST:
+      return "Fast";
+    case COMMAND_CONCURRENCY_EXCLUSIVE:
+      return "Exclusive";
+    case COMMAND_CONCURRENCY_BACKGROUND:
+      return "Background";
+    default:
+      return "Unknown";
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -261,3 +289,31 @@ void vtkPlusCommand::QueueCommandResponse(PlusStatus status, const std::string&
   }
   this->CommandResponseQueue.push_back(commandResponse);
 }
+
+//------------------------------------------------------------------------------
+void vtkPlusCommand::ReportJobProgress(double percent, const std::string& message)
+{
+  if (this->JobId == 0 || this->CommandProcessor == NULL)
+  {
+    // not executed as a background job, the client only expects the final response
+    return;
+  }
+
+  std::map<std::string, std::string> parameters;
+  parameters[JOB_ID_PARAMETER_NAME] = PlusCommon::ToString(this->JobId);
+  parameters[JOB_STATUS_PARAMETER_NAME] = "InProgress";
+  parameters[JOB_PROGRESS_PARAMETER_NAME] = PlusCommon::ToString(percent);
+
+  vtkSmartPointer<vtkPlusCommandCommandResponse> commandResponse = vtkSmartPointer<vtkPlusCommandCommandResponse>::New();
+  commandResponse->SetClientId(this->ClientId);
+  commandResponse->SetOriginalId(this->Id);
+  commandResponse->SetDeviceName(this->DeviceName);
+  commandResponse->SetCommandName(this->GetName());
+  commandResponse->SetStatus(PLUS_SUCCESS);
+  commandResponse->SetRespondWithCommandMessage(this->RespondWithCommandMessage);
+  commandResponse->SetResultString(message);
+  commandResponse->SetParameters(parameters);
+
+  // Progress must reach the client while the command is still running, so it bypasses the command's own response queue
+  this->CommandProcessor->QueueResponse(commandResponse);
+}
@@ -31,6 +31,25 @@ public:
   static const std::string DEVICE_NAME_COMMAND;
   static const std::string DEVICE_NAME_REPLY;
 
+  /*! Response parameter names used by the job protocol of background commands */
+  static const std::string JOB_ID_PARAMETER_NAME;
+  static const std::string JOB_STATUS_PARAMETER_NAME;
+  static const std::string JOB_PROGRESS_PARAMETER_NAME;
+
+  /*!
+    Determines how the command processor may schedule the command relative to other commands.
+    FAST commands are short, read-only queries that may run concurrently with any other command.
+    EXCLUSIVE commands are executed one at a time, in the order they were received.
+    BACKGROUND commands are long operations: the client immediately receives a job id,
+    then progress and completion are reported asynchronously.
+  */
+  enum CommandConcurrencyClass
+  {
+    COMMAND_CONCURRENCY_FAST,
+    COMMAND_CONCURRENCY_EXCLUSIVE,
+    COMMAND_CONCURRENCY_BACKGROUND
+  };
+
   virtual vtkPlusCommand* Clone() = 0;
 
   virtual void PrintSelf(ostream& os, vtkIndent indent);
@@ -76,6 +95,19 @@ public:
   vtkGetMacro(Id, uint32_t);
   vtkSetMacro(Id, uint32_t);
 
+  /*! Identifier of the background job that executes the command (0 if the command is not executed as a job) */
+  vtkGetMacro(JobId, unsigned int);
+  vtkSetMacro(JobId, unsigned int);
+
+  /*!
+    Returns the concurrency class of the command. Must be called after ReadConfiguration,
+    as the class may depend on the command name and parameters. Commands are EXCLUSIVE by default.
+  */
+  virtual CommandConcurrencyClass GetConcurrencyClass();
+
+  /*! Returns the human-readable name of a concurrency class */
+  static std::string GetConcurrencyClassAsString(CommandConcurrencyClass concurrencyClass);
+
   /*!
     Get command responses from the device, append them to the provided list, and then remove them from the command.
     The ownership of the command responses are transferred to the caller, it is responsible
@@ -136,6 +168,15 @@ protected:
   /*! Helper method to add a command response to the response queue */
   void QueueCommandResponse(PlusStatus status, const std::string& message, const std::string& error = "", const std::map<std::string, std::string>* keyValuePairs = NULL);
 
+  /*!
+    Report progress of a command that is executed as a background job. The response is sent
+    to the client immediately, without waiting for the command to complete.
+    Does nothing if the command is not executed as a job.
+    \param percent Completion percentage (0-100)
+    \param message Human-readable description of the current processing step
+  */
+  void ReportJobProgress(double percent, const std::string& message);
+
   vtkPlusCommand();
   virtual ~vtkPlusCommand();
 
@@ -150,6 +191,9 @@ protected:
   /*! Unique identifier of the command. It can be used to match commands and replies. */
   uint32_t Id;
 
+  /*! Identifier of the background job, assigned by the command processor. 0 if not executed as a job. */
+  unsigned int JobId;
+
   /*! Should we respond using igtl::StringMessage or igtl::CommandMessage */
   bool RespondWithCommandMessage;
 
@@ -100,20 +100,28 @@ PlusStatus vtkPlusGetTransformCommand::Execute()
   PlusTransformName aName;
   aName.SetTransformName(this->GetTransformName());
 
-  if (this->GetTransformRepository()->IsExistingTransform(aName) != PLUS_SUCCESS)
+  bool transformExists = false;
+  bool persistent = false;
+  vtkSmartPointer<vtkMatrix4x4> value = vtkSmartPointer<vtkMatrix4x4>::New();
+  std::string date;
+  double error = 0.0;
+  {
+    // The command may be executed concurrently with transform updates, read all properties of the transform in one locked step
+    PlusLockGuard<vtkPlusTransformRepository> repositoryGuardedLock(this->GetTransformRepository());
+    transformExists = (this->GetTransformRepository()->IsExistingTransform(aName) == PLUS_SUCCESS);
+    if (transformExists)
+    {
+      this->GetTransformRepository()->GetTransformPersistent(aName, persistent);
+      this->GetTransformRepository()->GetTransform(aName, value);
+      this->GetTransformRepository()->GetTransformDate(aName, date);
+      this->GetTransformRepository()->GetTransformError(aName, error);
+    }
+  }
+  if (!transformExists)
   {
     this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", baseMessageString + " Failed. Transform not found.");
     return PLUS_SUCCESS;
   }
-
-  bool persistent;
-  this->GetTransformRepository()->GetTransformPersistent(aName, persistent);
-  vtkSmartPointer<vtkMatrix4x4> value = vtkSmartPointer<vtkMatrix4x4>::New();
-  this->GetTransformRepository()->GetTransform(aName, value);
-  std::string date;
-  this->GetTransformRepository()->GetTransformDate(aName, date);
-  double error;
-  this->GetTransformRepository()->GetTransformError(aName, error);
   std::ostringstream errorStringStream;
   errorStringStream << error;
 
@@ -28,6 +28,12 @@ public:
   /*! Executes the command  */
   virtual PlusStatus Execute();
 
+  /*!
+    Read-only query, it may be executed concurrently with other commands.
+    The transform repository is locked while the transform and its properties are read, so they are consistent with each other.
+  */
+  virtual CommandConcurrencyClass GetConcurrencyClass() { return COMMAND_CONCURRENCY_FAST; }
+
   /*! Read command parameters from XML */
   virtual PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig);
 
@@ -196,6 +196,16 @@ PlusStatus vtkPlusReconstructVolumeCommand::WriteConfiguration(vtkXMLDataElement
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+vtkPlusCommand::CommandConcurrencyClass vtkPlusReconstructVolumeCommand::GetConcurrencyClass()
+{
+  if (PlusCommon::IsEqualInsensitive(this->Name, RECONSTRUCT_PRERECORDED_CMD))
+  {
+    return COMMAND_CONCURRENCY_BACKGROUND;
+  }
+  return COMMAND_CONCURRENCY_EXCLUSIVE;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusReconstructVolumeCommand::Execute()
 {
@@ -264,7 +274,8 @@ PlusStatus vtkPlusReconstructVolumeCommand::Execute()
       this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", baseMessage + " Reconstruction from sequence file failed: cannot get transform repository.");
       return PLUS_FAIL;
     }
-    reconstructorDevice->Reset(); // Clear volume
+    // The volume is cleared by the reconstructor device, while it is locked against live reconstruction
+    this->ReportJobProgress(0, baseMessage + " Reconstructing volume from sequence file.");
     vtkSmartPointer<vtkImageData> volumeToSend = vtkSmartPointer<vtkImageData>::New();
     std::string errorMessage;
     if (reconstructorDevice->GetReconstructedVolumeFromFile(this->InputSeqFilename, volumeToSend, errorMessage) != PLUS_SUCCESS)
@@ -272,6 +283,7 @@ PlusStatus vtkPlusReconstructVolumeCommand::Execute()
       this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", baseMessage + " Reconstruction from sequence file failed: " + errorMessage);
       return PLUS_FAIL;
     }
+    this->ReportJobProgress(90, baseMessage + " Volume reconstructed, sending output.");
     std::string statusMessage;
     PlusStatus status = ProcessImageReply(volumeToSend, outputVolFilename, outputVolDeviceName, statusMessage);
     this->QueueCommandResponse(status, std::string("Command ") + std::string((status == PLUS_SUCCESS ? "succeeded." : "failed. See error message.")), baseMessage + " Reconstruction from sequence file completed: " + statusMessage);
@@ -32,6 +32,9 @@ public:
   /*! Executes the command  */
   virtual PlusStatus Execute();
 
+  /*! Reconstruction from a sequence file is executed as a background job, all other commands are exclusive */
+  virtual CommandConcurrencyClass GetConcurrencyClass();
+
   /*! Read command parameters from XML */
   virtual PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig);
 
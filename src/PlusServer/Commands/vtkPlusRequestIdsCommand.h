@@ -28,6 +28,9 @@ public:
   /*! Executes the command  */
   virtual PlusStatus Execute();
 
+  /*! Read-only query, it may be executed concurrently with other commands */
+  virtual CommandConcurrencyClass GetConcurrencyClass() { return COMMAND_CONCURRENCY_FAST; }
+
   /*! Get all the command names that this class can execute */
   virtual void GetCommandNames(std::list<std::string>& cmdNames);
 
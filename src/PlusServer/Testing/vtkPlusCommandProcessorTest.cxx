@@ -0,0 +1,436 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+\file vtkPlusCommandProcessorTest.cxx
+\brief This test queues a mix of fast, exclusive and background commands, executes them on the worker threads
+of vtkPlusCommandProcessor and checks the execution order, the job responses and the latency statistics
+*/
+
+// Local includes
+#include "PlusCommon.h"
+#include "PlusConfigure.h"
+#include "vtkPlusAccurateTimer.h"
+#include "vtkPlusCommand.h"
+#include "vtkPlusCommandProcessor.h"
+#include "vtkPlusRecursiveCriticalSection.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkXMLDataElement.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <algorithm>
+#include <set>
+
+namespace
+{
+  const char TEST_EXCLUSIVE_COMMAND[] = "TestExclusive";
+  const char TEST_FAST_COMMAND[] = "TestFast";
+  const char TEST_BACKGROUND_COMMAND[] = "TestBackground";
+  const double MAX_TEST_DURATION_SEC = 20.0;
+
+  struct ExecutionEvent
+  {
+    bool Started;
+    std::string CommandName;
+    int Index;
+  };
+
+  /*! Execution events of all the test commands, in the order they happened */
+  std::vector<ExecutionEvent> ExecutionEvents;
+  int NumberOfExecutingExclusiveCommands = 0;
+  int MaximumNumberOfExecutingExclusiveCommands = 0;
+  vtkPlusRecursiveCriticalSection* ExecutionEventsMutex = NULL;
+}
+
+//----------------------------------------------------------------------------
+/*!
+  \class vtkPlusCommandProcessorTestCommand
+  \brief Test command that records its execution and waits for a specified time. The command name determines the concurrency class.
+*/
+class vtkPlusCommandProcessorTestCommand : public vtkPlusCommand
+{
+public:
+  static vtkPlusCommandProcessorTestCommand* New();
+  vtkTypeMacro(vtkPlusCommandProcessorTestCommand, vtkPlusCommand);
+  virtual vtkPlusCommand* Clone() { return New(); }
+
+  virtual void GetCommandNames(std::list<std::string>& cmdNames)
+  {
+    cmdNames.clear();
+    cmdNames.push_back(TEST_EXCLUSIVE_COMMAND);
+    cmdNames.push_back(TEST_FAST_COMMAND);
+    cmdNames.push_back(TEST_BACKGROUND_COMMAND);
+  }
+
+  virtual std::string GetDescription(const std::string& commandName)
+  {
+    return "Test command for vtkPlusCommandProcessor";
+  }
+
+  virtual CommandConcurrencyClass GetConcurrencyClass()
+  {
+    if (this->Name == TEST_FAST_COMMAND)
+    {
+      return COMMAND_CONCURRENCY_FAST;
+    }
+    if (this->Name == TEST_BACKGROUND_COMMAND)
+    {
+      return COMMAND_CONCURRENCY_BACKGROUND;
+    }
+    return COMMAND_CONCURRENCY_EXCLUSIVE;
+  }
+
+  virtual PlusStatus ReadConfiguration(vtkXMLDataElement* aConfig)
+  {
+    if (this->Superclass::ReadConfiguration(aConfig) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    aConfig->GetScalarAttribute("Index", this->Index);
+    aConfig->GetScalarAttribute("DelaySec", this->DelaySec);
+    return PLUS_SUCCESS;
+  }
+
+  virtual PlusStatus Execute()
+  {
+    this->RecordEvent(true);
+    this->ReportJobProgress(50, "Half done");
+    vtkPlusAccurateTimer::Delay(this->DelaySec);
+    this->RecordEvent(false);
+    this->QueueCommandResponse(PLUS_SUCCESS, this->Name + " " + PlusCommon::ToString(this->Index) + " completed");
+    return PLUS_SUCCESS;
+  }
+
+protected:
+  vtkPlusCommandProcessorTestCommand()
+    : Index(0)
+    , DelaySec(0.0)
+  {
+  }
+
+  void RecordEvent(bool started)
+  {
+    PlusLockGuard<vtkPlusRecursiveCriticalSection> eventsGuardedLock(ExecutionEventsMutex);
+    ExecutionEvent executionEvent;
+    executionEvent.Started = started;
+    executionEvent.CommandName = this->Name;
+    executionEvent.Index = this->Index;
+    ExecutionEvents.push_back(executionEvent);
+    if (this->GetConcurrencyClass() == COMMAND_CONCURRENCY_EXCLUSIVE)
+    {
+      NumberOfExecutingExclusiveCommands += (started ? 1 : -1);
+      MaximumNumberOfExecutingExclusiveCommands = std::max(MaximumNumberOfExecutingExclusiveCommands, NumberOfExecutingExclusiveCommands);
+    }
+  }
+
+  int Index;
+  double DelaySec;
+
+private:
+  vtkPlusCommandProcessorTestCommand(const vtkPlusCommandProcessorTestCommand&);
+  void operator=(const vtkPlusCommandProcessorTestCommand&);
+};
+
+vtkStandardNewMacro(vtkPlusCommandProcessorTestCommand);
+
+//----------------------------------------------------------------------------
+struct TestCommandDefinition
+{
+  uint32_t Uid;
+  std::string Name;
+  int Index;
+  double DelaySec;
+};
+
+//----------------------------------------------------------------------------
+int FindExecutionEvent(bool started, const std::string& commandName, int index)
+{
+  for (unsigned int i = 0; i < ExecutionEvents.size(); ++i)
+  {
+    if (ExecutionEvents[i].Started == started && ExecutionEvents[i].CommandName == commandName && ExecutionEvents[i].Index == index)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+std::string GetResponseParameter(vtkPlusCommandCommandResponse* response, const std::string& parameterName)
+{
+  std::map<std::string, std::string>::const_iterator parameterIt = response->GetParameters().find(parameterName);
+  if (parameterIt == response->GetParameters().end())
+  {
+    return "";
+  }
+  return parameterIt->second;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus CheckExecutionOrder()
+{
+  PlusStatus status = PLUS_SUCCESS;
+
+  // Exclusive commands are executed one at a time, in the order they were received
+  if (MaximumNumberOfExecutingExclusiveCommands != 1)
+  {
+    LOG_ERROR("Exclusive commands were executed concurrently (maximum number of concurrently executed exclusive commands: " << MaximumNumberOfExecutingExclusiveCommands << ")");
+    status = PLUS_FAIL;
+  }
+  int previousExclusiveIndex = -1;
+  for (std::vector<ExecutionEvent>::iterator eventIt = ExecutionEvents.begin(); eventIt != ExecutionEvents.end(); ++eventIt)
+  {
+    if (!eventIt->Started || eventIt->CommandName != TEST_EXCLUSIVE_COMMAND)
+    {
+      continue;
+    }
+    if (eventIt->Index != previousExclusiveIndex + 1)
+    {
+      LOG_ERROR("Exclusive command " << eventIt->Index << " was started after exclusive command " << previousExclusiveIndex);
+      status = PLUS_FAIL;
+    }
+    previousExclusiveIndex = eventIt->Index;
+  }
+
+  // Fast commands do not wait for a long exclusive command
+  if (FindExecutionEvent(false, TEST_FAST_COMMAND, 0) > FindExecutionEvent(false, TEST_EXCLUSIVE_COMMAND, 0))
+  {
+    LOG_ERROR("Fast command was not executed concurrently with the preceding exclusive command");
+    status = PLUS_FAIL;
+  }
+
+  // At most one background job is executed at a time
+  if (FindExecutionEvent(true, TEST_BACKGROUND_COMMAND, 1) < FindExecutionEvent(false, TEST_BACKGROUND_COMMAND, 0))
+  {
+    LOG_ERROR("Background jobs were executed concurrently although MaximumNumberOfBackgroundJobs is 1");
+    status = PLUS_FAIL;
+  }
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus CheckResponses(const std::vector<TestCommandDefinition>& commands, PlusCommandResponseList& responses)
+{
+  PlusStatus status = PLUS_SUCCESS;
+  std::set<std::string> jobIds;
+  for (std::vector<TestCommandDefinition>::const_iterator commandIt = commands.begin(); commandIt != commands.end(); ++commandIt)
+  {
+    // Collect the responses of the command in the order they were queued
+    std::vector<vtkPlusCommandCommandResponse*> commandResponses;
+    for (PlusCommandResponseList::iterator responseIt = responses.begin(); responseIt != responses.end(); ++responseIt)
+    {
+      vtkPlusCommandCommandResponse* commandResponse = vtkPlusCommandCommandResponse::SafeDownCast(*responseIt);
+      if (commandResponse != NULL && commandResponse->GetOriginalId() == commandIt->Uid)
+      {
+        commandResponses.push_back(commandResponse);
+      }
+    }
+
+    if (commandIt->Name != TEST_BACKGROUND_COMMAND)
+    {
+      // Single response, without job information
+      if (commandResponses.size() != 1 || commandResponses[0]->GetStatus() != PLUS_SUCCESS
+          || !GetResponseParameter(commandResponses[0], vtkPlusCommand::JOB_ID_PARAMETER_NAME).empty())
+      {
+        LOG_ERROR("Expected a single successful response for command " << commandIt->Uid << " (" << commandIt->Name << "), received " << commandResponses.size());
+        status = PLUS_FAIL;
+      }
+      continue;
+    }
+
+    // Background job: Started, InProgress, Completed
+    const char* expectedJobStatuses[] = { "Started", "InProgress", "Completed" };
+    if (commandResponses.size() != 3)
+    {
+      LOG_ERROR("Expected 3 responses for background command " << commandIt->Uid << ", received " << commandResponses.size());
+      status = PLUS_FAIL;
+      continue;
+    }
+    std::string jobId = GetResponseParameter(commandResponses[0], vtkPlusCommand::JOB_ID_PARAMETER_NAME);
+    if (jobId.empty() || jobIds.find(jobId) != jobIds.end())
+    {
+      LOG_ERROR("Background command " << commandIt->Uid << " has an invalid or duplicate job id: '" << jobId << "'");
+      status = PLUS_FAIL;
+    }
+    jobIds.insert(jobId);
+    for (int i = 0; i < 3; ++i)
+    {
+      std::string jobStatus = GetResponseParameter(commandResponses[i], vtkPlusCommand::JOB_STATUS_PARAMETER_NAME);
+      if (jobStatus != expectedJobStatuses[i] || GetResponseParameter(commandResponses[i], vtkPlusCommand::JOB_ID_PARAMETER_NAME) != jobId)
+      {
+        LOG_ERROR("Background command " << commandIt->Uid << " response " << i << " has job status '" << jobStatus << "' (expected '" << expectedJobStatuses[i] << "')");
+        status = PLUS_FAIL;
+      }
+    }
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus CheckLatencyStatistics(vtkPlusCommandProcessor* processor, const std::vector<TestCommandDefinition>& commands)
+{
+  PlusStatus status = PLUS_SUCCESS;
+  vtkPlusCommandProcessor::CommandLatencyStatisticsMap statistics;
+  processor->GetCommandLatencyStatistics(statistics);
+  const char* commandNames[] = { TEST_EXCLUSIVE_COMMAND, TEST_FAST_COMMAND, TEST_BACKGROUND_COMMAND };
+  for (int nameIndex = 0; nameIndex < 3; ++nameIndex)
+  {
+    int expectedNumberOfExecutions = 0;
+    double maximumDelaySec = 0.0;
+    for (std::vector<TestCommandDefinition>::const_iterator commandIt = commands.begin(); commandIt != commands.end(); ++commandIt)
+    {
+      if (commandIt->Name == commandNames[nameIndex])
+      {
+        ++expectedNumberOfExecutions;
+        maximumDelaySec = std::max(maximumDelaySec, commandIt->DelaySec);
+      }
+    }
+    const vtkPlusCommandProcessor::CommandLatencyStatistics& stat = statistics[commandNames[nameIndex]];
+    if (stat.NumberOfExecutions != expectedNumberOfExecutions || stat.NumberOfFailures != 0)
+    {
+      LOG_ERROR(commandNames[nameIndex] << " latency statistics: " << stat.NumberOfExecutions << " executions and " << stat.NumberOfFailures
+                << " failures (expected " << expectedNumberOfExecutions << " executions and no failures)");
+      status = PLUS_FAIL;
+    }
+    if (stat.MaximumExecutionTimeSec < maximumDelaySec || stat.MinimumExecutionTimeSec > stat.MaximumExecutionTimeSec
+        || stat.TotalExecutionTimeSec < stat.MaximumExecutionTimeSec || stat.MaximumQueueTimeSec < 0)
+    {
+      LOG_ERROR(commandNames[nameIndex] << " latency statistics are inconsistent: execution time min=" << stat.MinimumExecutionTimeSec
+                << " max=" << stat.MaximumExecutionTimeSec << " total=" << stat.TotalExecutionTimeSec << ", max queue time=" << stat.MaximumQueueTimeSec
+                << " (expected max execution time >= " << maximumDelaySec << ")");
+      status = PLUS_FAIL;
+    }
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfWorkerThreads(4);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-worker-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfWorkerThreads, "Number of command execution threads (default: 4, at least 2 is needed for concurrent execution)");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (numberOfWorkerThreads < 2)
+  {
+    LOG_ERROR("At least 2 worker threads are needed to test concurrent command execution");
+    exit(EXIT_FAILURE);
+  }
+
+  vtkSmartPointer<vtkPlusRecursiveCriticalSection> executionEventsMutex = vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New();
+  ExecutionEventsMutex = executionEventsMutex;
+
+  vtkSmartPointer<vtkPlusCommandProcessor> processor = vtkSmartPointer<vtkPlusCommandProcessor>::New();
+  processor->SetNumberOfWorkerThreads(numberOfWorkerThreads);
+  processor->SetMaximumNumberOfBackgroundJobs(1);
+  processor->RegisterPlusCommand(vtkSmartPointer<vtkPlusCommandProcessorTestCommand>::New());
+
+  // The first exclusive command is long, so that the following commands are queued while it is executed
+  std::vector<TestCommandDefinition> commands;
+  TestCommandDefinition commandDefinitions[] =
+  {
+    { 1, TEST_EXCLUSIVE_COMMAND, 0, 0.5 },
+    { 2, TEST_FAST_COMMAND, 0, 0.0 },
+    { 3, TEST_BACKGROUND_COMMAND, 0, 0.3 },
+    { 4, TEST_EXCLUSIVE_COMMAND, 1, 0.05 },
+    { 5, TEST_FAST_COMMAND, 1, 0.0 },
+    { 6, TEST_EXCLUSIVE_COMMAND, 2, 0.05 },
+    { 7, TEST_BACKGROUND_COMMAND, 1, 0.05 },
+    { 8, TEST_EXCLUSIVE_COMMAND, 3, 0.0 }
+  };
+  commands.assign(commandDefinitions, commandDefinitions + sizeof(commandDefinitions) / sizeof(commandDefinitions[0]));
+
+  for (std::vector<TestCommandDefinition>::iterator commandIt = commands.begin(); commandIt != commands.end(); ++commandIt)
+  {
+    std::ostringstream commandString;
+    commandString << "<Command Name=\"" << commandIt->Name << "\" Index=\"" << commandIt->Index << "\" DelaySec=\"" << commandIt->DelaySec << "\" />";
+    if (processor->QueueCommand(true, 1, commandIt->Name, commandString.str(), "TestClient", commandIt->Uid) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to queue command " << commandIt->Uid << " (" << commandIt->Name << ")");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (processor->Start() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to start the command execution threads");
+    exit(EXIT_FAILURE);
+  }
+
+  // Wait until all the commands are executed
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  while (vtkPlusAccurateTimer::GetSystemTime() - startTime < MAX_TEST_DURATION_SEC)
+  {
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> eventsGuardedLock(ExecutionEventsMutex);
+      if (ExecutionEvents.size() == 2 * commands.size() && processor->GetNumberOfActiveJobs() == 0)
+      {
+        break;
+      }
+    }
+    vtkPlusAccurateTimer::Delay(0.05);
+  }
+  processor->Stop();
+
+  PlusCommandResponseList responses;
+  processor->PopCommandResponses(responses);
+
+  int numberOfFailures = 0;
+  if (ExecutionEvents.size() != 2 * commands.size())
+  {
+    LOG_ERROR("Not all the commands were executed in " << MAX_TEST_DURATION_SEC << " sec: " << ExecutionEvents.size() / 2 << " of " << commands.size());
+    ++numberOfFailures;
+  }
+  if (CheckExecutionOrder() != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+  if (CheckResponses(commands, responses) != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+  if (CheckLatencyStatistics(processor, commands) != PLUS_SUCCESS)
+  {
+    ++numberOfFailures;
+  }
+
+  ExecutionEventsMutex = NULL;
+
+  if (numberOfFailures > 0)
+  {
+    LOG_ERROR("vtkPlusCommandProcessorTest failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("vtkPlusCommandProcessorTest completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -28,6 +28,7 @@ See License.txt for details.
 #include "vtkPlusUpdateTransformCommand.h"
 #include "vtkPlusVersionCommand.h"
 #include "vtkXMLUtilities.h"
+#include <algorithm>
 
 vtkStandardNewMacro(vtkPlusCommandProcessor);
 
@@ -37,7 +38,13 @@ vtkPlusCommandProcessor::vtkPlusCommandProcessor()
   , Threader(vtkSmartPointer<vtkMultiThreader>::New())
   , Mutex(vtkSmartPointer<vtkPlusRecursiveCriticalSection>::New())
   , CommandExecutionActive(std::make_pair(false, false))
-  , CommandExecutionThreadId(-1)
+  , NumberOfWorkerThreads(4)
+  , NumberOfRunningWorkerThreads(0)
+  , MaximumNumberOfBackgroundJobs(1)
+  , NumberOfExecutingExclusiveCommands(0)
+  , NumberOfExecutingBackgroundCommands(0)
+  , NumberOfActiveJobs(0)
+  , LastJobId(0)
 {
   // Register default commands
   RegisterPlusCommand(vtkSmartPointer<vtkPlusStartStopRecordingCommand>::New());
@@ -66,6 +73,8 @@ vtkPlusCommandProcessor::~vtkPlusCommandProcessor()
 void vtkPlusCommandProcessor::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfWorkerThreads: " << this->NumberOfWorkerThreads << std::endl;
+  os << indent << "MaximumNumberOfBackgroundJobs: " << this->MaximumNumberOfBackgroundJobs << std::endl;
   os << indent << "Available Commands : ";
   // TODO: print registered commands
   /*
@@ -78,35 +87,80 @@ void vtkPlusCommandProcessor::PrintSelf(ostream& os, vtkIndent indent)
     os << "None.";
   }
   */
+  os << std::endl;
+
+  CommandLatencyStatisticsMap statistics;
+  GetCommandLatencyStatistics(statistics);
+  os << indent << "Command latency statistics:" << std::endl;
+  for (CommandLatencyStatisticsMap::iterator it = statistics.begin(); it != statistics.end(); ++it)
+  {
+    const CommandLatencyStatistics& stat = it->second;
+    os << indent.GetNextIndent() << it->first << ": executions=" << stat.NumberOfExecutions << ", failures=" << stat.NumberOfFailures;
+    if (stat.NumberOfExecutions > 0)
+    {
+      os << ", queue time [ms] mean=" << 1000.0 * stat.TotalQueueTimeSec / stat.NumberOfExecutions << " max=" << 1000.0 * stat.MaximumQueueTimeSec
+         << ", execution time [ms] mean=" << 1000.0 * stat.TotalExecutionTimeSec / stat.NumberOfExecutions
+         << " min=" << 1000.0 * stat.MinimumExecutionTimeSec << " max=" << 1000.0 * stat.MaximumExecutionTimeSec;
+    }
+    os << std::endl;
+  }
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusCommandProcessor::Start()
 {
-  if (this->CommandExecutionThreadId < 0)
+  if (!this->CommandExecutionThreadIds.empty())
+  {
+    // already started
+    return PLUS_SUCCESS;
+  }
+
+  this->CommandExecutionActive.first = true;
+  for (int i = 0; i < this->NumberOfWorkerThreads; ++i)
   {
-    this->CommandExecutionActive.first = true;
-    this->CommandExecutionThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&CommandExecutionThread, this);
+    {
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+      this->NumberOfRunningWorkerThreads++;
+      this->CommandExecutionActive.second = true;
+    }
+    int threadId = this->Threader->SpawnThread((vtkThreadFunctionType)&CommandExecutionThread, this);
+    if (threadId < 0)
+    {
+      LOG_ERROR("Failed to start command execution thread " << i);
+      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+      this->NumberOfRunningWorkerThreads--;
+      this->CommandExecutionActive.second = (this->NumberOfRunningWorkerThreads > 0);
+      break;
+    }
+    this->CommandExecutionThreadIds.push_back(threadId);
   }
+
+  if (this->CommandExecutionThreadIds.empty())
+  {
+    this->CommandExecutionActive.first = false;
+    return PLUS_FAIL;
+  }
+
+  LOG_DEBUG("Started " << this->CommandExecutionThreadIds.size() << " command execution threads");
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusCommandProcessor::Stop()
 {
-  // Stop the command execution thread
-  if (this->CommandExecutionThreadId >= 0)
+  // Stop the command execution threads. Commands that are being executed (including background jobs) are completed first.
+  if (!this->CommandExecutionThreadIds.empty())
   {
     this->CommandExecutionActive.first = false;
     while (this->CommandExecutionActive.second)
     {
-      // Wait until the thread stops
+      // Wait until all the threads stop
       vtkPlusAccurateTimer::Delay(0.2);
     }
-    this->CommandExecutionThreadId = -1;
+    this->CommandExecutionThreadIds.clear();
   }
 
-  LOG_DEBUG("Command execution thread stopped");
+  LOG_DEBUG("Command execution threads stopped");
 
   return PLUS_SUCCESS;
 }
@@ -116,13 +170,16 @@ void* vtkPlusCommandProcessor::CommandExecutionThread(vtkMultiThreader::ThreadIn
 {
   vtkPlusCommandProcessor* self = (vtkPlusCommandProcessor*)(data->UserData);
 
-  self->CommandExecutionActive.second = true;
-
   // Execute commands until a stop is requested
   while (self->CommandExecutionActive.first)
   {
-    self->ExecuteCommands();
-    // no commands in the queue, wait a bit before checking again
+    QueuedCommand command;
+    if (self->TakeNextRunnableCommand(command))
+    {
+      self->ExecuteQueuedCommand(command);
+      continue;
+    }
+    // no command can be started now, wait a bit before checking again
     const double commandQueuePollIntervalSec = 0.010;
 #ifdef _WIN32
     Sleep(commandQueuePollIntervalSec * 1000);
@@ -132,8 +189,12 @@ void* vtkPlusCommandProcessor::CommandExecutionThread(vtkMultiThreader::ThreadIn
   }
 
   // Close thread
-  self->CommandExecutionThreadId = -1;
-  self->CommandExecutionActive.second = false;
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(self->Mutex);
+  self->NumberOfRunningWorkerThreads--;
+  if (self->NumberOfRunningWorkerThreads <= 0)
+  {
+    self->CommandExecutionActive.second = false;
+  }
   return NULL;
 }
 
@@ -141,37 +202,129 @@ void* vtkPlusCommandProcessor::CommandExecutionThread(vtkMultiThreader::ThreadIn
 int vtkPlusCommandProcessor::ExecuteCommands()
 {
   // Implemented in a while loop to not block the mutex during command execution, only during management of the queue.
+  // If no worker threads are running then the commands are executed in the order they were received.
   int numberOfExecutedCommands(0);
-  while (1)
+  QueuedCommand command; // next command to be processed
+  while (TakeNextRunnableCommand(command))
+  {
+    ExecuteQueuedCommand(command);
+    numberOfExecutedCommands++;
+  }
+  return numberOfExecutedCommands;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusCommandProcessor::TakeNextRunnableCommand(QueuedCommand& command)
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  // An exclusive command must not overtake an earlier exclusive command, so after the first
+  // exclusive command in the queue only fast and background commands may be started.
+  bool exclusiveCommandAllowed = (this->NumberOfExecutingExclusiveCommands == 0);
+  for (QueuedCommandList::iterator it = this->CommandQueue.begin(); it != this->CommandQueue.end(); ++it)
   {
-    vtkSmartPointer<vtkPlusCommand> cmd; // next command to be processed
+    bool runnable = false;
+    switch (it->ConcurrencyClass)
     {
-      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-      if (this->CommandQueue.empty())
-      {
-        return numberOfExecutedCommands;
-      }
-      cmd = this->CommandQueue.front();
-      this->CommandQueue.pop_front();
+      case vtkPlusCommand::COMMAND_CONCURRENCY_FAST:
+        runnable = true;
+        break;
+      case vtkPlusCommand::COMMAND_CONCURRENCY_BACKGROUND:
+        runnable = (this->NumberOfExecutingBackgroundCommands < this->MaximumNumberOfBackgroundJobs);
+        break;
+      case vtkPlusCommand::COMMAND_CONCURRENCY_EXCLUSIVE:
+      default:
+        runnable = exclusiveCommandAllowed;
+        exclusiveCommandAllowed = false;
+        break;
+    }
+    if (!runnable)
+    {
+      continue;
     }
 
-    LOG_DEBUG("Executing command");
-    if (cmd->Execute() != PLUS_SUCCESS)
+    command = *it;
+    this->CommandQueue.erase(it);
+    if (command.ConcurrencyClass == vtkPlusCommand::COMMAND_CONCURRENCY_BACKGROUND)
+    {
+      this->NumberOfExecutingBackgroundCommands++;
+    }
+    else if (command.ConcurrencyClass != vtkPlusCommand::COMMAND_CONCURRENCY_FAST)
     {
-      LOG_ERROR("Command execution failed");
+      this->NumberOfExecutingExclusiveCommands++;
     }
+    return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusCommandProcessor::ExecuteQueuedCommand(QueuedCommand& command)
+{
+  vtkPlusCommand* cmd = command.Command;
+  std::string commandName = cmd->GetName();
+
+  LOG_DEBUG("Executing command " << commandName << " (" << vtkPlusCommand::GetConcurrencyClassAsString(command.ConcurrencyClass) << ")");
+  double startTime = vtkPlusAccurateTimer::GetSystemTime();
+  PlusStatus status = cmd->Execute();
+  double endTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (status != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Command execution failed: " << commandName);
+  }
 
-    // move the response objects from the command to the processor's queue
+  PlusCommandResponseList responses;
+  cmd->PopCommandResponses(responses);
+  if (cmd->GetJobId() > 0)
+  {
+    // Mark the final responses of the job, so that the client can match them to the job started response
+    for (PlusCommandResponseList::iterator responseIt = responses.begin(); responseIt != responses.end(); ++responseIt)
     {
-      PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-      cmd->PopCommandResponses(this->CommandResponseQueue);
+      vtkPlusCommandCommandResponse* commandResponse = vtkPlusCommandCommandResponse::SafeDownCast(*responseIt);
+      if (commandResponse == NULL)
+      {
+        continue;
+      }
+      std::map<std::string, std::string> parameters = commandResponse->GetParameters();
+      parameters[vtkPlusCommand::JOB_ID_PARAMETER_NAME] = PlusCommon::ToString(cmd->GetJobId());
+      parameters[vtkPlusCommand::JOB_STATUS_PARAMETER_NAME] = (status == PLUS_SUCCESS ? "Completed" : "Failed");
+      commandResponse->SetParameters(parameters);
     }
+  }
 
-    numberOfExecutedCommands++;
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+
+  // move the response objects from the command to the processor's queue
+  this->CommandResponseQueue.splice(this->CommandResponseQueue.end(), responses, responses.begin(), responses.end());
+
+  if (command.ConcurrencyClass == vtkPlusCommand::COMMAND_CONCURRENCY_BACKGROUND)
+  {
+    this->NumberOfExecutingBackgroundCommands--;
+  }
+  else if (command.ConcurrencyClass != vtkPlusCommand::COMMAND_CONCURRENCY_FAST)
+  {
+    this->NumberOfExecutingExclusiveCommands--;
+  }
+  if (cmd->GetJobId() > 0)
+  {
+    this->NumberOfActiveJobs--;
   }
 
-  // we never actually reach this point
-  return numberOfExecutedCommands;
+  CommandLatencyStatistics& stat = this->LatencyStatistics[commandName];
+  double queueTimeSec = startTime - command.QueueTime;
+  double executionTimeSec = endTime - startTime;
+  if (stat.NumberOfExecutions == 0 || executionTimeSec < stat.MinimumExecutionTimeSec)
+  {
+    stat.MinimumExecutionTimeSec = executionTimeSec;
+  }
+  stat.MaximumExecutionTimeSec = std::max(stat.MaximumExecutionTimeSec, executionTimeSec);
+  stat.MaximumQueueTimeSec = std::max(stat.MaximumQueueTimeSec, queueTimeSec);
+  stat.TotalExecutionTimeSec += executionTimeSec;
+  stat.TotalQueueTimeSec += queueTimeSec;
+  stat.NumberOfExecutions++;
+  if (status != PLUS_SUCCESS)
+  {
+    stat.NumberOfFailures++;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -268,13 +421,47 @@ PlusStatus vtkPlusCommandProcessor::QueueCommand(bool respondUsingIGTLCommand, u
   cmd->SetId(uid);
   cmd->SetRespondWithCommandMessage(respondUsingIGTLCommand);
 
+  QueuedCommand queuedCommand;
+  queuedCommand.Command = cmd;
+  queuedCommand.ConcurrencyClass = cmd->GetConcurrencyClass();
+  queuedCommand.QueueTime = vtkPlusAccurateTimer::GetSystemTime();
+
   // Add command to the execution queue
   PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
-  this->CommandQueue.push_back(cmd);
+  // Legacy string message clients expect exactly one reply per command, therefore the job protocol is only used with command messages
+  if (queuedCommand.ConcurrencyClass == vtkPlusCommand::COMMAND_CONCURRENCY_BACKGROUND && respondUsingIGTLCommand)
+  {
+    cmd->SetJobId(++this->LastJobId);
+    this->NumberOfActiveJobs++;
+    QueueJobStartedResponse(cmd);
+  }
+  this->CommandQueue.push_back(queuedCommand);
 
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusCommandProcessor::QueueJobStartedResponse(vtkPlusCommand* cmd)
+{
+  std::map<std::string, std::string> parameters;
+  parameters[vtkPlusCommand::JOB_ID_PARAMETER_NAME] = PlusCommon::ToString(cmd->GetJobId());
+  parameters[vtkPlusCommand::JOB_STATUS_PARAMETER_NAME] = "Started";
+  parameters[vtkPlusCommand::JOB_PROGRESS_PARAMETER_NAME] = "0";
+
+  vtkSmartPointer<vtkPlusCommandCommandResponse> response = vtkSmartPointer<vtkPlusCommandCommandResponse>::New();
+  response->SetClientId(cmd->GetClientId());
+  response->SetDeviceName(cmd->GetDeviceName());
+  response->SetOriginalId(cmd->GetId());
+  response->SetCommandName(cmd->GetName());
+  response->SetRespondWithCommandMessage(true);
+  response->SetStatus(PLUS_SUCCESS);
+  response->SetResultString(std::string("Job ") + PlusCommon::ToString(cmd->GetJobId()) + " started.");
+  response->SetParameters(parameters);
+
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  this->CommandResponseQueue.push_back(response);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusCommandProcessor::QueueStringResponse(const PlusStatus& status, const std::string& deviceName, const std::string& replyString)
 {
@@ -321,6 +508,22 @@ PlusStatus vtkPlusCommandProcessor::QueueCommandResponse(const PlusStatus& statu
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusCommandProcessor::QueueResponse(vtkPlusCommandResponse* response)
+{
+  if (response == NULL)
+  {
+    LOG_ERROR("vtkPlusCommandProcessor::QueueResponse failed: invalid response");
+    return PLUS_FAIL;
+  }
+
+  // Add response to the command response queue
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  this->CommandResponseQueue.push_back(response);
+
+  return PLUS_SUCCESS;
+}
+
 //------------------------------------------------------------------------------
 void vtkPlusCommandProcessor::PopCommandResponses(PlusCommandResponseList& responses)
 {
@@ -337,3 +540,24 @@ bool vtkPlusCommandProcessor::IsRunning()
   return this->CommandExecutionActive.second;
 }
 
+//------------------------------------------------------------------------------
+void vtkPlusCommandProcessor::GetCommandLatencyStatistics(CommandLatencyStatisticsMap& statistics)
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  statistics = this->LatencyStatistics;
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusCommandProcessor::ResetCommandLatencyStatistics()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  this->LatencyStatistics.clear();
+}
+
+//------------------------------------------------------------------------------
+int vtkPlusCommandProcessor::GetNumberOfActiveJobs()
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> updateMutexGuardedLock(this->Mutex);
+  return this->NumberOfActiveJobs;
+}
+
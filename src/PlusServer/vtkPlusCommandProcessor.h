@@ -14,7 +14,9 @@
 #include "vtkPlusCommand.h"
 #include "vtkPlusCommandResponse.h"
 #include "vtkPlusOpenIGTLinkServer.h"
+#include <map>
 #include <string>
+#include <vector>
 
 class vtkImageData;
 class vtkMatrix4x4;
@@ -23,14 +25,47 @@ class vtkMatrix4x4;
   \class vtkPlusCommandProcessor 
   \brief Creates a PlusCommand from a string.
   If the commands are to be executed on the main thread then call ExecuteCommands() periodically from the main thread.
-  If the commands are to be executed on a separate thread (to allow background processing, but maybe requiring more synchronization) call Start() to start an internal processing thread. 
+  If the commands are to be executed on separate threads (to allow background processing, but maybe requiring more synchronization) call Start() to start a pool of worker threads.
   Probably one of the processing models would be enough, but at this point it's not clear which one is better.
   TODO: keep only one method and remove the other approach completely once the processing model decision is finalized.
+
+  The worker threads schedule each command according to its concurrency class (see vtkPlusCommand::CommandConcurrencyClass):
+  fast commands are executed as soon as a worker is available, exclusive commands are executed one at a time in the order
+  they were received, background commands are executed as jobs (at most MaximumNumberOfBackgroundJobs at a time).
+  When a background command is received from a client that uses command messages, a response containing the job id
+  is sent immediately, followed by progress responses and a final response that includes the job id and completion status.
   \ingroup PlusLibPlusServer
 */
 class vtkPlusServerExport vtkPlusCommandProcessor : public vtkObject
 {
 public:
+  /*! Latency statistics of a command type. Times are in seconds. */
+  struct CommandLatencyStatistics
+  {
+    CommandLatencyStatistics()
+      : NumberOfExecutions(0)
+      , NumberOfFailures(0)
+      , TotalQueueTimeSec(0.0)
+      , MaximumQueueTimeSec(0.0)
+      , TotalExecutionTimeSec(0.0)
+      , MinimumExecutionTimeSec(0.0)
+      , MaximumExecutionTimeSec(0.0)
+    {
+    }
+    /*! Number of completed executions */
+    unsigned int NumberOfExecutions;
+    /*! Number of executions that returned PLUS_FAIL */
+    unsigned int NumberOfFailures;
+    /*! Time between queuing the command and starting its execution */
+    double TotalQueueTimeSec;
+    double MaximumQueueTimeSec;
+    /*! Time spent in vtkPlusCommand::Execute() */
+    double TotalExecutionTimeSec;
+    double MinimumExecutionTimeSec;
+    double MaximumExecutionTimeSec;
+  };
+  typedef std::map<std::string, CommandLatencyStatistics> CommandLatencyStatisticsMap;
+
   static vtkPlusCommandProcessor *New();
   vtkTypeMacro(vtkPlusCommandProcessor, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
@@ -41,15 +76,32 @@ public:
   */
   int ExecuteCommands();
 
-  /*! Start thread for processing the commands in the queue. Must be called from the main thread. */
+  /*! Start worker threads for processing the commands in the queue. Must be called from the main thread. */
   virtual PlusStatus Start();
 
   /*! Stop command processing. Must be called from the main thread. */
   virtual PlusStatus Stop();
 
-  /*! Returns true if the command processing thread is running. Can be called from any thread. */
+  /*! Returns true if the command processing threads are running. Can be called from any thread. */
   virtual bool IsRunning();
 
+  /*! Number of worker threads started by Start(). Must be set before calling Start(). */
+  vtkSetClampMacro(NumberOfWorkerThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfWorkerThreads, int);
+
+  /*! Maximum number of background jobs that may be executed at the same time */
+  vtkSetClampMacro(MaximumNumberOfBackgroundJobs, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(MaximumNumberOfBackgroundJobs, int);
+
+  /*! Get a copy of the latency statistics of all executed command types, keyed by command name. Can be called from any thread. */
+  void GetCommandLatencyStatistics(CommandLatencyStatisticsMap& statistics);
+
+  /*! Clear the latency statistics. Can be called from any thread. */
+  void ResetCommandLatencyStatistics();
+
+  /*! Returns the number of background jobs that are queued or being executed. Can be called from any thread. */
+  int GetNumberOfActiveJobs();
+
   /*!
     Register custom command. Must be called from the main thread.
     \param cmd It should point to a valid vtkPlusCommand instance. The caller can delete the cmd object after the call.
@@ -71,6 +123,12 @@ public:
   */
   virtual PlusStatus QueueCommandResponse(const PlusStatus& status, const std::string &deviceName, unsigned int clientId, const std::string& commandName, uint32_t uid, const std::string &replyString);
 
+  /*!
+    Adds an already created response to the response queue for reply. Can be called from any thread.
+    Used by commands to report progress while they are being executed.
+  */
+  virtual PlusStatus QueueResponse(vtkPlusCommandResponse* response);
+
   /*!
     Return the queued command responses and removes the items from the queue (so that each item is returned only once) and clears the response queue.
     The caller is responsible for deleting the returned response objects.
@@ -82,9 +140,31 @@ public:
   vtkSetObjectMacro(PlusServer, vtkPlusOpenIGTLinkServer); 
 
 protected:
+  /*! Command waiting for execution, with the information needed for scheduling */
+  struct QueuedCommand
+  {
+    vtkSmartPointer<vtkPlusCommand> Command;
+    vtkPlusCommand::CommandConcurrencyClass ConcurrencyClass;
+    /*! System time when the command was added to the queue */
+    double QueueTime;
+  };
+  typedef std::list<QueuedCommand> QueuedCommandList;
+
   vtkPlusCommand* CreatePlusCommand(const std::string& commandName, const std::string &commandStr);
 
-  /*! Thread for client connection handling */ 
+  /*!
+    Remove the first command from the queue that may be started now, considering the commands that are already being executed.
+    \return false if there is no command that can be started
+  */
+  bool TakeNextRunnableCommand(QueuedCommand& command);
+
+  /*! Execute a command that was taken from the queue, collect its responses and update the statistics */
+  void ExecuteQueuedCommand(QueuedCommand& command);
+
+  /*! Queue the response that tells the client the id of the job that will execute the command */
+  void QueueJobStartedResponse(vtkPlusCommand* cmd);
+
+  /*! Worker thread for command execution */ 
   static void* CommandExecutionThread( vtkMultiThreader::ThreadInfo* data );
 
   vtkPlusCommandProcessor();
@@ -103,8 +183,30 @@ private:
   // Active flag for threads (first: request, second: respond )
   std::pair<bool,bool> CommandExecutionActive;
 
-  // Thread identifier
-  int  CommandExecutionThreadId;
+  // Thread identifiers of the worker threads
+  std::vector<int> CommandExecutionThreadIds;
+
+  /*! Number of worker threads started by Start() */
+  int NumberOfWorkerThreads;
+
+  /*! Number of worker threads that have not exited yet */
+  int NumberOfRunningWorkerThreads;
+
+  /*! Maximum number of background jobs that may be executed at the same time */
+  int MaximumNumberOfBackgroundJobs;
+
+  /*! Number of commands of each concurrency class that are currently being executed */
+  int NumberOfExecutingExclusiveCommands;
+  int NumberOfExecutingBackgroundCommands;
+
+  /*! Number of background jobs that are queued or being executed */
+  int NumberOfActiveJobs;
+
+  /*! Last assigned job identifier */
+  unsigned int LastJobId;
+
+  /*! Latency statistics for each command name */
+  CommandLatencyStatisticsMap LatencyStatistics;
 
   /*! Map command names and the New() static methods of vtkPlusCommand classes */ 
   std::map<std::string,vtkPlusCommand*> RegisteredCommands; 
@@ -114,9 +216,7 @@ private:
     After a command's execute method is called it may still remain active (remain in the queue),
     until it signals that it is completed.
   */	
-  //std::list<vtkPlusCommand*> CommandQueue;
-  typedef std::list< vtkSmartPointer<vtkPlusCommand> > PlusCommandList;
-  PlusCommandList CommandQueue;
+  QueuedCommandList CommandQueue;
   PlusCommandResponseList CommandResponseQueue;
 
   vtkPlusCommandProcessor(const vtkPlusCommandProcessor&);  // Not implemented.
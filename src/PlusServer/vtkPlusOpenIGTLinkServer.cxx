@@ -93,6 +93,7 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , BroadcastChannel(NULL)
   , LogWarningOnNoDataAvailable(true)
   , KeepAliveIntervalSec(CLIENT_SOCKET_TIMEOUT_SEC / 2.0)
+  , NumberOfCommandExecutionThreads(0)
   , GracePeriodLogLevel(vtkPlusLogger::LOG_LEVEL_DEBUG)
   , MissingInputGracePeriodSec(0.0)
   , BroadcastStartTime(0.0)
@@ -170,6 +171,15 @@ PlusStatus vtkPlusOpenIGTLinkServer::StartOpenIGTLinkService()
   LOG_DEBUG(ss.str());
 
   this->PlusCommandProcessor->SetPlusServer(this);
+  if (this->NumberOfCommandExecutionThreads > 0)
+  {
+    this->PlusCommandProcessor->SetNumberOfWorkerThreads(this->NumberOfCommandExecutionThreads);
+    if (this->PlusCommandProcessor->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start command execution threads");
+      return PLUS_FAIL;
+    }
+  }
 
   this->BroadcastStartTime = vtkPlusAccurateTimer::GetSystemTime();
 
@@ -179,6 +189,9 @@ PlusStatus vtkPlusOpenIGTLinkServer::StartOpenIGTLinkService()
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkServer::StopOpenIGTLinkService()
 {
+  // Stop command execution threads (running commands are completed first)
+  this->PlusCommandProcessor->Stop();
+
   // Stop connection receiver thread
   if (this->ConnectionReceiverThreadId >= 0)
   {
@@ -879,8 +892,11 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(PlusTrackedFrame& trackedF
           break;
         }
 
-        // Update the TDATA timestamp, even if TDATA isn't sent (cheaper than checking for existing TDATA message type)
-        clientIterator->ClientInfo.LastTDATASentTimeStamp = trackedFrame.GetTimestamp();
+        // Update the TDATA timestamp only when TDATA is sent, otherwise other message types would keep postponing it
+        if (typeid(*igtlMessage) == typeid(igtl::TrackingDataMessage))
+        {
+          clientIterator->ClientInfo.LastTDATASentTimeStamp = trackedFrame.GetTimestamp();
+        }
       }
     }
   }
@@ -1062,6 +1078,7 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfRetryAttempts, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, DelayBetweenRetryAttemptsSec, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, KeepAliveIntervalSec, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfCommandExecutionThreads, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SendValidTransformsOnly, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IgtlMessageCrcCheckEnabled, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LogWarningOnNoDataAvailable, serverElement);
@@ -1093,6 +1110,11 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
 //------------------------------------------------------------------------------
 int vtkPlusOpenIGTLinkServer::ProcessPendingCommands()
 {
+  if (this->PlusCommandProcessor->IsRunning())
+  {
+    // commands are executed by the command processor threads
+    return 0;
+  }
   return this->PlusCommandProcessor->ExecuteCommands();
 }
 
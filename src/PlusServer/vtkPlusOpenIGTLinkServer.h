@@ -153,7 +153,8 @@ public:
   vtkGetMacro(IGTLProtocolVersion, int);
 
   /*!
-    Execute all commands in the queue from the current thread (useful if commands should be executed from the main thread)
+    Execute all commands in the queue from the current thread (useful if commands should be executed from the main thread).
+    Does nothing if the commands are executed by command execution threads (NumberOfCommandExecutionThreads > 0).
     \return Number of executed commands
   */
   int ProcessPendingCommands();
@@ -215,6 +216,9 @@ protected:
   vtkSetMacro(KeepAliveIntervalSec, double);
   vtkGetMacroConst(KeepAliveIntervalSec, double);
 
+  vtkSetMacro(NumberOfCommandExecutionThreads, int);
+  vtkGetMacroConst(NumberOfCommandExecutionThreads, int);
+
   vtkSetStdStringMacro(OutputChannelId);
   vtkSetStdStringMacro(ConfigFilename);
 
@@ -311,6 +315,12 @@ private:
 
   double KeepAliveIntervalSec;
 
+  /*!
+    Number of worker threads that execute the received commands.
+    If 0 then commands are executed from the main thread by ProcessPendingCommands().
+  */
+  int NumberOfCommandExecutionThreads;
+
   std::string ConfigFilename;
 
   vtkPlusLogger::LogLevelType GracePeriodLogLevel;
@@ -10,6 +10,7 @@
 
 #include "PlusConfigure.h"
 #include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
 
 #include <fstream>
 #include <iostream>
@@ -41,6 +42,16 @@ int SimpleCompareVolumes( vtkImageData* testVol, vtkImageData* refVol, double si
 
   int* testExt = testVol->GetExtent();
   int* refExt = refVol->GetExtent();
+  if ( testExt[1] < testExt[0] || testExt[3] < testExt[2] || testExt[5] < testExt[4] )
+  {
+    LOG_ERROR( "Test volume is empty" );
+    return EXIT_FAILURE;
+  }
+  if ( refExt[1] < refExt[0] || refExt[3] < refExt[2] || refExt[5] < refExt[4] )
+  {
+    LOG_ERROR( "Reference volume is empty" );
+    return EXIT_FAILURE;
+  }
   if ( testExt[0] != refExt[0] || testExt[1] != refExt[1]
        || testExt[2] != refExt[2] || testExt[3] != refExt[3]
        || testExt[4] != refExt[4] || testExt[5] != refExt[5] )
@@ -98,8 +109,91 @@ int SimpleCompareVolumes( vtkImageData* testVol, vtkImageData* refVol, double si
   return EXIT_SUCCESS;
 }
 
+//-----------------------------------------------------------------------------
+// Returns NULL if the file cannot be read or the volume is empty
+vtkSmartPointer<vtkImageData> ReadVolume( const std::string& fileName )
+{
+  if ( !vtksys::SystemTools::FileExists( fileName.c_str(), true ) )
+  {
+    LOG_ERROR( "Volume file not found: " << fileName );
+    return NULL;
+  }
+  vtkSmartPointer<vtkMetaImageReader> reader = vtkSmartPointer<vtkMetaImageReader>::New();
+  reader->SetFileName( fileName.c_str() );
+  reader->Update();
+  vtkSmartPointer<vtkImageData> volume = vtkImageData::SafeDownCast( reader->GetOutput() );
+  if ( volume == NULL )
+  {
+    LOG_ERROR( "Failed to read volume from file: " << fileName );
+    return NULL;
+  }
+  int* extent = volume->GetExtent();
+  if ( extent[1] < extent[0] || extent[3] < extent[2] || extent[5] < extent[4] )
+  {
+    LOG_ERROR( "Volume read from file is empty: " << fileName );
+    return NULL;
+  }
+  return volume;
+}
+
+//-----------------------------------------------------------------------------
+// Performs simple comparison of all the volume pairs listed in a text file.
+// Each line contains a ground truth and a testing image file name, separated by whitespace.
+// Empty lines and lines starting with # are ignored.
+int SimpleCompareVolumePairs( const std::string& volumePairsFileName, double simpleCompareMaxError )
+{
+  std::ifstream volumePairsFile( volumePairsFileName.c_str() );
+  if ( !volumePairsFile.is_open() )
+  {
+    LOG_ERROR( "Failed to open volume pairs file: " << volumePairsFileName );
+    return EXIT_FAILURE;
+  }
+
+  int numberOfPairs( 0 );
+  int numberOfFailedPairs( 0 );
+  std::string line;
+  while ( std::getline( volumePairsFile, line ) )
+  {
+    PlusCommon::Trim( line );
+    if ( line.empty() || line[0] == '#' )
+    {
+      continue;
+    }
+    std::istringstream lineStream( line );
+    std::string groundTruthFileName;
+    std::string testingFileName;
+    if ( !( lineStream >> groundTruthFileName >> testingFileName ) )
+    {
+      LOG_ERROR( "Invalid line in volume pairs file (expected ground truth and testing image file names): " << line );
+      numberOfFailedPairs++;
+      continue;
+    }
+
+    numberOfPairs++;
+    LOG_INFO( "Compare " << testingFileName << " to " << groundTruthFileName );
+    vtkSmartPointer<vtkImageData> groundTruth = ReadVolume( groundTruthFileName );
+    vtkSmartPointer<vtkImageData> testingImage = ReadVolume( testingFileName );
+    if ( SimpleCompareVolumes( testingImage, groundTruth, simpleCompareMaxError ) != EXIT_SUCCESS )
+    {
+      numberOfFailedPairs++;
+    }
+  }
 
+  if ( numberOfPairs == 0 && numberOfFailedPairs == 0 )
+  {
+    LOG_ERROR( "No volume pairs found in file: " << volumePairsFileName );
+    return EXIT_FAILURE;
+  }
+  if ( numberOfFailedPairs > 0 )
+  {
+    LOG_ERROR( numberOfFailedPairs << " volume comparisons failed out of " << numberOfPairs );
+    return EXIT_FAILURE;
+  }
+  LOG_INFO( "All " << numberOfPairs << " volume comparisons succeeded" );
+  return EXIT_SUCCESS;
+}
 
+//-----------------------------------------------------------------------------
 int main( int argc, char** argv )
 {
   bool printHelp( false );
@@ -114,6 +208,7 @@ int main( int argc, char** argv )
   std::vector<int> roiOriginV;
   std::vector<int> roiSizeV;
   double simpleCompareMaxError = -1;
+  std::string volumePairsFileName;
 
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
@@ -131,6 +226,7 @@ int main( int argc, char** argv )
   args.AddArgument( "--output-diff-volume-true", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputTrueDiffFileName, "Save the true difference volume to this file" );
   args.AddArgument( "--output-diff-volume-absolute", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &outputAbsoluteDiffFileName, "Save the absolute difference volume to this file" );
   args.AddArgument( "--simple-compare-max-error", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &simpleCompareMaxError, "If specified, a simple comparison of the volumes is performed (no detailed statistics are computed, only the ground truth and test volumes are used) and if the stdev of pixel values of the absolute difference image is larger than the specified value then the test returns with failure" );
+  args.AddArgument( "--volume-pairs-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &volumePairsFileName, "Text file listing volume pairs to compare with simple comparison (requires --simple-compare-max-error). Each line contains a ground truth and a testing image file name, separated by whitespace." );
   args.AddArgument( "--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)" );
   args.AddArgument( "--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help." );
 
@@ -151,6 +247,17 @@ int main( int argc, char** argv )
 
   /************************************************************/
 
+  // Compare multiple volume pairs
+  if ( !volumePairsFileName.empty() )
+  {
+    if ( simpleCompareMaxError < 0 )
+    {
+      LOG_ERROR( "volume-pairs-file requires simple-compare-max-error to be specified" );
+      exit( EXIT_FAILURE );
+    }
+    return SimpleCompareVolumePairs( volumePairsFileName, simpleCompareMaxError );
+  }
+
   // Check file names
   if ( inputGTFileName.empty() || inputTestingFileName.empty() )
   {
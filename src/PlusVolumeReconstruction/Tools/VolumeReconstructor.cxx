@@ -14,6 +14,7 @@
 #include "vtkPlusVolumeReconstructor.h"
 #include "vtkXMLUtilities.h"
 #include "vtksys/CommandLineArguments.hxx"
+#include <iomanip>
 
 int main(int argc, char* argv[])
 {
@@ -36,6 +37,8 @@ int main(int argc, char* argv[])
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
   bool disableCompression = false;
+  bool frameParallel = false;
+  int numberOfPreparationThreads = 0;
 
   vtksys::CommandLineArguments cmdargs;
   cmdargs.Initialize(argc, argv);
@@ -50,6 +53,8 @@ int main(int argc, char* argv[])
   cmdargs.AddArgument("--disable-compression", vtksys::CommandLineArguments::NO_ARGUMENT, &disableCompression, "Do not compress output image files.");
   cmdargs.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
   cmdargs.AddArgument("--importance-mask-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &importanceMaskFileName, "The file to use as the importance mask.");
+  cmdargs.AddArgument("--frame-parallel", vtksys::CommandLineArguments::NO_ARGUMENT, &frameParallel, "Prepare frames (transform lookup, fan angle detection) in parallel before inserting them into the volume. The reconstructed volume is the same as in sequential mode. Cannot be used with --output-frame-file.");
+  cmdargs.AddArgument("--preparation-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfPreparationThreads, "Number of threads used for frame preparation in --frame-parallel mode (default: 0 = number of CPUs).");
 
   // Deprecated arguments (2013-07-29, #800)
   cmdargs.AddArgument("--transform", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputImageToReferenceTransformNameDeprecated, "Image to reference transform name used for the reconstruction. DEPRECATED, use --image-to-reference-transform argument instead");
@@ -178,11 +183,32 @@ int main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
+  if (frameParallel && !outputFrameFileName.empty())
+  {
+    LOG_WARNING("--output-frame-file cannot be used with --frame-parallel. Frames are reconstructed sequentially.");
+    frameParallel = false;
+  }
+
   LOG_INFO("Reconstruct volume...");
   const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
   int numberOfFramesAddedToVolume = 0;
 
-  for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex += reconstructor->GetSkipInterval())
+  double reconstructionStartTime = vtkPlusAccurateTimer::GetSystemTime();
+  if (frameParallel)
+  {
+    double preparationTimeSec = 0.0;
+    double insertionTimeSec = 0.0;
+    reconstructor->SetNumberOfPreparationThreads(numberOfPreparationThreads);
+    if (reconstructor->AddTrackedFrameList(trackedFrameList, transformRepository, &numberOfFramesAddedToVolume, &preparationTimeSec, &insertionTimeSec) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tracked frames to volume");
+      return EXIT_FAILURE;
+    }
+    LOG_INFO("Frame preparation time: " << std::fixed << std::setprecision(3) << preparationTimeSec << " sec");
+    LOG_INFO("Slice insertion time: " << std::fixed << std::setprecision(3) << insertionTimeSec << " sec");
+  }
+
+  for (int frameIndex = 0; !frameParallel && frameIndex < numberOfFrames; frameIndex += reconstructor->GetSkipInterval())
   {
     LOG_DEBUG("Frame: " << frameIndex);
     vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
@@ -240,6 +266,7 @@ int main(int argc, char* argv[])
   }
 
   vtkPlusLogger::PrintProgressbar(100);
+  LOG_INFO("Reconstruction time: " << std::fixed << std::setprecision(3) << vtkPlusAccurateTimer::GetSystemTime() - reconstructionStartTime << " sec");
 
   trackedFrameList->Clear();
 
@@ -18,6 +18,7 @@
 #include "vtkPlusCompareVolumes.h"
 
 #include "PlusMath.h"
+#include "vtkPlusRecursiveCriticalSection.h"
 
 #include "vtkImageData.h"
 #include "vtkImageProgressIterator.h"
@@ -25,8 +26,8 @@
 #include "vtkInformationVector.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include <algorithm>
 #include <vector>
-#include <list>
 
 static const int INPUT_GROUND_TRUTH_VOLUME = 0;
 static const int INPUT_GROUND_TRUTH_VOLUME_ALPHA = 1;
@@ -34,6 +35,7 @@ static const int INPUT_TEST_VOLUME = 2;
 static const int INPUT_TEST_VOLUME_ALPHA = 3;
 static const int INPUT_SLICES_VOLUME_ALPHA = 4;
 
+static const int OUTPUT_TRUE_DIFF_VOLUME = 0;
 static const int OUTPUT_ABS_DIFF_VOLUME = 1;
 
 vtkStandardNewMacro( vtkPlusCompareVolumes );
@@ -146,13 +148,67 @@ void vtkPlusCompareVolumes::resetAbsoluteHistogramWithHoles()
   }
 }
 
+//----------------------------------------------------------------------------
+vtkPlusCompareVolumes::PieceStatistics::PieceStatistics()
+  : NumberOfHoles(0)
+  , NumberOfFilledHoles(0)
+  , NumberVoxelsVisible(0)
+  , AbsoluteDifferenceSumInAllHoles(0.0)
+{
+  std::fill(this->Extent, this->Extent + 6, 0);
+  std::fill(this->TrueHistogram, this->TrueHistogram + 511, 0);
+  std::fill(this->AbsoluteHistogram, this->AbsoluteHistogram + 256, 0);
+  std::fill(this->AbsoluteHistogramWithHoles, this->AbsoluteHistogramWithHoles + 256, 0);
+}
+
+namespace
+{
+  // Order pieces by their position in memory (z, then y, then x start index)
+  bool ComparePieceExtents(const vtkPlusCompareVolumes::PieceStatistics& pieceA, const vtkPlusCompareVolumes::PieceStatistics& pieceB)
+  {
+    const int* a = pieceA.Extent;
+    const int* b = pieceB.Extent;
+    if (a[4] != b[4])
+    {
+      return a[4] < b[4];
+    }
+    if (a[2] != b[2])
+    {
+      return a[2] < b[2];
+    }
+    return a[0] < b[0];
+  }
+
+  // Interpolated percentile of a sorted vector
+  double GetPercentile(const std::vector<double>& sortedValues, double percentile)
+  {
+    int count = static_cast<int>(sortedValues.size());
+    double rank = (count - 1) * percentile;
+    double fraction = fmod(rank, 1.0);
+    int rankFloor = std::max(0, static_cast<int>(floor(rank)));
+    int rankCeil = std::min(count - 1, static_cast<int>(ceil(rank)));
+    return sortedValues[rankFloor] * (1 - fraction) + sortedValues[rankCeil] * fraction;
+  }
+}
+
+//----------------------------------------------------------------------------
 vtkPlusCompareVolumes::vtkPlusCompareVolumes()
+  : PiecesMutex(vtkPlusRecursiveCriticalSection::New())
 {
   this->SetNumberOfInputPorts( 5 );
   this->SetNumberOfOutputPorts( 2 );
-  this->SetNumberOfThreads( 1 ); // TODO: Remove when vtkPlusCompareVolumesExecute is made thread-safe (e.g., simultaneous access to member variables are protected by locking)
+  this->resetTrueHistogram();
+  this->resetAbsoluteHistogram();
+  this->resetAbsoluteHistogramWithHoles();
+}
+
+//----------------------------------------------------------------------------
+vtkPlusCompareVolumes::~vtkPlusCompareVolumes()
+{
+  DELETE_IF_NOT_NULL(this->PiecesMutex);
 }
 
+//----------------------------------------------------------------------------
 int vtkPlusCompareVolumes::RequestInformation (
   vtkInformation*        vtkNotUsed( request ),
   vtkInformationVector** vtkNotUsed( inputVector ),
@@ -166,96 +222,61 @@ int vtkPlusCompareVolumes::RequestInformation (
   return 1;
 }
 
-
-template <class T>
-void vtkPlusCompareVolumesExecute( vtkPlusCompareVolumes* self,
-                                   vtkImageData* inData,
-                                   vtkImageData* outData,
-                                   T* gtPtr,
-                                   T* gtAlphaPtr,
-                                   T* testPtr,
-                                   T* testAlphaPtr,
-                                   T* slicesAlphaPtr,
-                                   double* outPtrTru,
-                                   double* outPtrAbs,
-                                   int outExt[6],
-                                   int id )
+//----------------------------------------------------------------------------
+int vtkPlusCompareVolumes::RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector)
 {
+  this->Pieces.clear();
+  // The superclass splits the output extent and calls ThreadedRequestData for each piece
+  int result = this->Superclass::RequestData(request, inputVector, outputVector);
+  this->MergePieceStatistics();
+  this->Pieces.clear();
+  return result;
+}
 
-  vtkIdType inOffsets[3] = {0}; //x,y,z
-  inData->GetIncrements( inOffsets[0], inOffsets[1], inOffsets[2] );
-
-  vtkIdType outOffsets[3] = {0}; //x,y,z
-  outData->GetIncrements( outOffsets[0], outOffsets[1], outOffsets[2] );
+//----------------------------------------------------------------------------
+void vtkPlusCompareVolumes::AddPieceStatistics(const PieceStatistics& pieceStatistics)
+{
+  PlusLockGuard<vtkPlusRecursiveCriticalSection> piecesGuardedLock(this->PiecesMutex);
+  this->Pieces.push_back(pieceStatistics);
+}
 
-  int xtemp( 0 ), ytemp( 0 ), ztemp( 0 ); // indices for each of the axes
-  self->resetTrueHistogram(); // count inside the class variables
-  self->resetAbsoluteHistogramWithHoles();
-  self->resetAbsoluteHistogram();
-  std::vector<double> trueDifferences; // store all differences here
-  std::vector<double> absoluteDifferences;
+//----------------------------------------------------------------------------
+void vtkPlusCompareVolumes::MergePieceStatistics()
+{
+  this->resetTrueHistogram();
+  this->resetAbsoluteHistogramWithHoles();
+  this->resetAbsoluteHistogram();
 
-  // same as absolute difference, but in hole voxels -
-  // this can be added to find the absolute error when
-  // we consider holes to be part of the image (and
-  // choose to not ignore them in the error computation)
-  // note these are not put into the histogram
-  std::vector<double> absoluteDifferencesInAllHoles;
+  // Merge pieces in memory order, so that the result is independent of the number of threads
+  std::sort(this->Pieces.begin(), this->Pieces.end(), ComparePieceExtents);
 
   int countVisibleVoxels( 0 );
   int countFilledHoles( 0 );
   int countHoles( 0 );
-
-  // iterate through all voxels
-  for ( ztemp = 0; ztemp <= outExt[5] - outExt[4]; ztemp++ )
+  double absoluteMeanWithHoles( 0.0 ); // include holes in this computation
+  std::vector<double> trueDifferences; // store all differences here
+  for (unsigned int i = 0; i < this->Pieces.size(); ++i)
   {
-    for ( ytemp = 0; ytemp <= outExt[3] - outExt[2]; ytemp++ )
+    const PieceStatistics& piece = this->Pieces[i];
+    for (int bin = 0; bin < 511; bin++)
     {
-      for ( xtemp = 0; xtemp <= outExt[1] - outExt[0]; xtemp++ )
-      {
-        int inIndex  =  inOffsets[0] * xtemp + inOffsets[1] * ytemp + inOffsets[2] * ztemp;
-        int outIndex = outOffsets[0] * xtemp + outOffsets[1] * ytemp + outOffsets[2] * ztemp;
-        if ( gtAlphaPtr[inIndex] != 0 )
-        {
-          countVisibleVoxels++;
-          if ( slicesAlphaPtr[inIndex] == 0 )
-          {
-            countHoles++;
-            double difference = ( double )gtPtr[inIndex] - testPtr[inIndex];
-            self->incAbsoluteHistogramWithHolesAtIndex( PlusMath::Round( fabs( difference ) ) );
-            absoluteDifferencesInAllHoles.push_back( fabs( difference ) );
-            if ( testAlphaPtr[inIndex] != 0 )
-            {
-              countFilledHoles++;
-              trueDifferences.push_back( difference );
-              self->incTrueHistogramAtIndex( PlusMath::Round( difference ) );
-              outPtrTru[outIndex] = difference; // cast to double to minimize precision loss
-              absoluteDifferences.push_back( fabs( difference ) );
-              self->incAbsoluteHistogramAtIndex( PlusMath::Round( fabs( difference ) ) );
-              outPtrAbs[outIndex] = fabs( difference );
-            }
-          }
-          else // not a hole, but these may still be different
-          {
-            //double difference = (double)gtPtr[inIndex] - testPtr[inIndex]; // cast to double to minimize precision loss
-            outPtrTru[outIndex] = 0.0; //difference;
-            outPtrAbs[outIndex] = 0.0; //abs(difference);
-          } // end slicesAlphaPtr check
-        }
-        else
-        {
-          outPtrTru[outIndex] = 0.0;
-          outPtrAbs[outIndex] = 0.0;
-        } // end gtAlphaPtr check
-      } // end x loop
-    } // end y loop
-  } // end z loop
-
-  double absoluteMeanWithHoles( 0.0 ); // include holes in this computation
-  // on this iteration, add only holes
-  for ( unsigned int i = 0; i < absoluteDifferencesInAllHoles.size(); i++ )
+      this->TrueHistogram[bin] += piece.TrueHistogram[bin];
+    }
+    for (int bin = 0; bin < 256; bin++)
+    {
+      this->AbsoluteHistogram[bin] += piece.AbsoluteHistogram[bin];
+      this->AbsoluteHistogramWithHoles[bin] += piece.AbsoluteHistogramWithHoles[bin];
+    }
+    countVisibleVoxels += piece.NumberVoxelsVisible;
+    countFilledHoles += piece.NumberOfFilledHoles;
+    countHoles += piece.NumberOfHoles;
+    absoluteMeanWithHoles += piece.AbsoluteDifferenceSumInAllHoles;
+    trueDifferences.insert(trueDifferences.end(), piece.TrueDifferences.begin(), piece.TrueDifferences.end());
+  }
+  std::vector<double> absoluteDifferences(trueDifferences.size());
+  for (unsigned int i = 0; i < trueDifferences.size(); i++)
   {
-    absoluteMeanWithHoles += absoluteDifferencesInAllHoles[i];
+    absoluteDifferences[i] = fabs(trueDifferences[i]);
   }
 
   // mean calculations
@@ -312,25 +333,8 @@ void vtkPlusCompareVolumesExecute( vtkPlusCompareVolumes* self,
     absoluteStdev = 0;
   }
 
-  // need to sort, temporarily store in a list, sort, then assign back to vector <== THIS IS SLOW SLOW SLOW, as in about half a minute for this alone, so TODO: Make this faster
-  std::list<double> trueDifferencesList;
-  std::list<double> absoluteDifferencesList;
-  for ( int i = 0; i < countFilledHoles; i++ )
-  {
-    trueDifferencesList.push_front( trueDifferences.back() );
-    trueDifferences.pop_back();
-    absoluteDifferencesList.push_front( absoluteDifferences.back() );
-    absoluteDifferences.pop_back();
-  }
-  trueDifferencesList.sort();
-  absoluteDifferencesList.sort();
-  for ( int i = 0; i < countFilledHoles; i++ )
-  {
-    trueDifferences.push_back( trueDifferencesList.front() );
-    trueDifferencesList.pop_front();
-    absoluteDifferences.push_back( absoluteDifferencesList.front() );
-    absoluteDifferencesList.pop_front();
-  }
+  std::sort( trueDifferences.begin(), trueDifferences.end() );
+  std::sort( absoluteDifferences.begin(), absoluteDifferences.end() );
 
   double true5thPercentile( 0.0 );
   double true95thPercentile( 0.0 );
@@ -350,88 +354,144 @@ void vtkPlusCompareVolumesExecute( vtkPlusCompareVolumes* self,
     absoluteMinimum = absoluteDifferences[0];
     absoluteMaximum = absoluteDifferences[countFilledHoles - 1];
 
-    // old median calculation
-    //double trueMedian = (countFilledHoles%2==0)?(trueDifferences[countFilledHoles/2]+trueDifferences[(countFilledHoles/2)-1])/2.0:trueDifferences[(countFilledHoles-1)/2];
-    //double absoluteMedian = (countFilledHoles%2==0)?(absoluteDifferences[countFilledHoles/2]+absoluteDifferences[(countFilledHoles/2)-1])/2.0:absoluteDifferences[(countFilledHoles-1)/2];
+    trueMedian = GetPercentile( trueDifferences, 0.5 );
+    absoluteMedian = GetPercentile( absoluteDifferences, 0.5 );
+    true5thPercentile = GetPercentile( trueDifferences, 0.05 );
+    absolute5thPercentile = GetPercentile( absoluteDifferences, 0.05 );
+    true95thPercentile = GetPercentile( trueDifferences, 0.95 );
+    absolute95thPercentile = GetPercentile( absoluteDifferences, 0.95 );
+  }
 
-    double medianRank = ( countFilledHoles - 1 ) * 0.5;
-    double medianFraction = fmod( medianRank, 1.0 );
-    int medianFloor = ( int )floor( medianRank );
-    if ( medianFloor < 0 )
-    {
-      medianFloor = 0;
-    }
-    int medianCeil = ( int )ceil( medianRank );
-    if ( medianCeil > ( countFilledHoles - 1 ) )
-    {
-      medianCeil = ( countFilledHoles - 1 );
-    }
-    trueMedian = trueDifferences[medianFloor] * ( 1 - medianFraction ) + trueDifferences[medianCeil] * medianFraction;
-    absoluteMedian = absoluteDifferences[medianFloor] * ( 1 - medianFraction ) + absoluteDifferences[medianCeil] * medianFraction;
+  this->SetNumberOfHoles( countHoles );
+  this->SetNumberVoxelsVisible( countVisibleVoxels );
+  this->SetNumberOfFilledHoles( countFilledHoles );
+
+  this->SetTrue95thPercentile( true95thPercentile );
+  this->SetTrue5thPercentile( true5thPercentile );
+  this->SetTrueMaximum( trueMaximum );
+  this->SetTrueMinimum( trueMinimum );
+  this->SetTrueMedian( trueMedian );
+  this->SetTrueStdev( trueStdev );
+  this->SetTrueMean( trueMean );
+
+  this->SetAbsolute95thPercentile( absolute95thPercentile );
+  this->SetAbsolute5thPercentile( absolute5thPercentile );
+  this->SetAbsoluteMaximum( absoluteMaximum );
+  this->SetAbsoluteMinimum( absoluteMinimum );
+  this->SetAbsoluteMedian( absoluteMedian );
+  this->SetAbsoluteStdev( absoluteStdev );
+  this->SetAbsoluteMean( absoluteMean );
+
+  this->SetAbsoluteMeanWithHoles( absoluteMeanWithHoles );
+
+  this->SetRMS( rms );
+}
 
-    double percentile5rank = ( countFilledHoles - 1 ) * 0.05;
-    double percentile5fraction = fmod( percentile5rank, 1.0 );
-    int percentile5floor = ( int )floor( percentile5rank );
-    if ( percentile5floor < 0 )
-    {
-      percentile5floor = 0;
-    }
-    int percentile5ceil = ( int )ceil( percentile5rank );
-    if ( percentile5ceil > ( countFilledHoles - 1 ) )
-    {
-      percentile5ceil = ( countFilledHoles - 1 );
-    }
-    true5thPercentile = trueDifferences[percentile5floor] * ( 1 - percentile5fraction ) + trueDifferences[percentile5ceil] * percentile5fraction;
-    absolute5thPercentile = absoluteDifferences[percentile5floor] * ( 1 - percentile5fraction ) + absoluteDifferences[percentile5ceil] * percentile5fraction;
+//----------------------------------------------------------------------------
+// Computes the difference images for one row. The loop has no branches,
+// so that the compiler can vectorize it.
+template <class T>
+void vtkPlusCompareVolumesComputeRowDifferences( const T* gtPtr,
+    const T* gtAlphaPtr,
+    const T* testPtr,
+    const T* testAlphaPtr,
+    const T* slicesAlphaPtr,
+    int rowLength,
+    double* outPtrTru,
+    double* outPtrAbs )
+{
+  for ( int x = 0; x < rowLength; x++ )
+  {
+    double difference = static_cast<double>( gtPtr[x] ) - static_cast<double>( testPtr[x] );
+    // only filled holes contribute to the difference images
+    bool filledHole = ( gtAlphaPtr[x] != 0 ) & ( slicesAlphaPtr[x] == 0 ) & ( testAlphaPtr[x] != 0 );
+    outPtrTru[x] = filledHole ? difference : 0.0;
+    outPtrAbs[x] = filledHole ? fabs( difference ) : 0.0;
+  }
+}
 
-    double percentile95rank = ( countFilledHoles - 1 ) * 0.95;
-    double percentile95fraction = fmod( percentile95rank, 1.0 );
-    int percentile95floor = ( int )floor( percentile95rank );
-    if ( percentile95floor < 0 )
-    {
-      percentile95floor = 0;
-    }
-    int percentile95ceil = ( int )ceil( percentile95rank );
-    if ( percentile95ceil > ( countFilledHoles - 1 ) )
+//----------------------------------------------------------------------------
+template <class T>
+void vtkPlusCompareVolumesExecute( vtkPlusCompareVolumes* self,
+                                   vtkImageData** inData,
+                                   vtkImageData** outData,
+                                   int outExt[6] )
+{
+  vtkImageData* gtVolData = inData[INPUT_GROUND_TRUTH_VOLUME];
+  T* gtPtr = static_cast<T*>( gtVolData->GetScalarPointerForExtent( outExt ) );
+  T* gtAlphaPtr = static_cast<T*>( inData[INPUT_GROUND_TRUTH_VOLUME_ALPHA]->GetScalarPointerForExtent( outExt ) );
+  T* testPtr = static_cast<T*>( inData[INPUT_TEST_VOLUME]->GetScalarPointerForExtent( outExt ) );
+  T* testAlphaPtr = static_cast<T*>( inData[INPUT_TEST_VOLUME_ALPHA]->GetScalarPointerForExtent( outExt ) );
+  T* slicesAlphaPtr = static_cast<T*>( inData[INPUT_SLICES_VOLUME_ALPHA]->GetScalarPointerForExtent( outExt ) );
+  double* outPtrTru = static_cast<double*>( outData[OUTPUT_TRUE_DIFF_VOLUME]->GetScalarPointerForExtent( outExt ) );
+  double* outPtrAbs = static_cast<double*>( outData[OUTPUT_ABS_DIFF_VOLUME]->GetScalarPointerForExtent( outExt ) );
+
+  // all inputs have the same extent and type, and a single component, so they share the same increments
+  vtkIdType inOffsets[3] = {0}; //x,y,z
+  gtVolData->GetIncrements( inOffsets[0], inOffsets[1], inOffsets[2] );
+
+  vtkIdType outOffsets[3] = {0}; //x,y,z
+  outData[OUTPUT_TRUE_DIFF_VOLUME]->GetIncrements( outOffsets[0], outOffsets[1], outOffsets[2] );
+
+  vtkPlusCompareVolumes::PieceStatistics piece;
+  std::copy( outExt, outExt + 6, piece.Extent );
+
+  int rowLength = outExt[1] - outExt[0] + 1;
+
+  // iterate through all rows
+  for ( int ztemp = 0; ztemp <= outExt[5] - outExt[4]; ztemp++ )
+  {
+    for ( int ytemp = 0; ytemp <= outExt[3] - outExt[2]; ytemp++ )
     {
-      percentile95ceil = ( countFilledHoles - 1 );
-    }
-    true95thPercentile = trueDifferences[percentile95floor] * ( 1 - percentile95fraction ) + trueDifferences[percentile95ceil] * percentile95fraction;
-    absolute95thPercentile = absoluteDifferences[percentile95floor] * ( 1 - percentile95fraction ) + absoluteDifferences[percentile95ceil] * percentile95fraction;
-  }
+      vtkIdType inIndex  =  inOffsets[1] * ytemp +  inOffsets[2] * ztemp;
+      vtkIdType outIndex = outOffsets[1] * ytemp + outOffsets[2] * ztemp;
+      const T* gtRow = gtPtr + inIndex;
+      const T* gtAlphaRow = gtAlphaPtr + inIndex;
+      const T* testRow = testPtr + inIndex;
+      const T* testAlphaRow = testAlphaPtr + inIndex;
+      const T* slicesAlphaRow = slicesAlphaPtr + inIndex;
+
+      vtkPlusCompareVolumesComputeRowDifferences( gtRow, gtAlphaRow, testRow, testAlphaRow, slicesAlphaRow, rowLength, outPtrTru + outIndex, outPtrAbs + outIndex );
+
+      // statistics are only collected from hole voxels
+      for ( int xtemp = 0; xtemp < rowLength; xtemp++ )
+      {
+        if ( gtAlphaRow[xtemp] == 0 )
+        {
+          continue;
+        }
+        piece.NumberVoxelsVisible++;
+        if ( slicesAlphaRow[xtemp] != 0 )
+        {
+          // not a hole
+          continue;
+        }
+        piece.NumberOfHoles++;
+        double difference = ( double )gtRow[xtemp] - testRow[xtemp];
+        piece.AbsoluteHistogramWithHoles[PlusMath::Round( fabs( difference ) )]++;
+        piece.AbsoluteDifferenceSumInAllHoles += fabs( difference );
+        if ( testAlphaRow[xtemp] != 0 )
+        {
+          piece.NumberOfFilledHoles++;
+          piece.TrueDifferences.push_back( difference );
+          piece.TrueHistogram[PlusMath::Round( difference ) + 256]++;
+          piece.AbsoluteHistogram[PlusMath::Round( fabs( difference ) )]++;
+        }
+      } // end x loop
+    } // end y loop
+  } // end z loop
 
-  self->SetNumberOfHoles( countHoles );
-  self->SetNumberVoxelsVisible( countVisibleVoxels );
-  self->SetNumberOfFilledHoles( countFilledHoles );
-
-  self->SetTrue95thPercentile( true95thPercentile );
-  self->SetTrue5thPercentile( true5thPercentile );
-  self->SetTrueMaximum( trueMaximum );
-  self->SetTrueMinimum( trueMinimum );
-  self->SetTrueMedian( trueMedian );
-  self->SetTrueStdev( trueStdev );
-  self->SetTrueMean( trueMean );
-
-  self->SetAbsolute95thPercentile( absolute95thPercentile );
-  self->SetAbsolute5thPercentile( absolute5thPercentile );
-  self->SetAbsoluteMaximum( absoluteMaximum );
-  self->SetAbsoluteMinimum( absoluteMinimum );
-  self->SetAbsoluteMedian( absoluteMedian );
-  self->SetAbsoluteStdev( absoluteStdev );
-  self->SetAbsoluteMean( absoluteMean );
-
-  self->SetAbsoluteMeanWithHoles( absoluteMeanWithHoles );
-
-  self->SetRMS( rms );
+  self->AddPieceStatistics( piece );
 }
 
+//----------------------------------------------------------------------------
 void vtkPlusCompareVolumes::ThreadedRequestData (
   vtkInformation* vtkNotUsed( request ),
   vtkInformationVector** vtkNotUsed( inputVector ),
   vtkInformationVector* vtkNotUsed( outputVector ),
   vtkImageData** *inData,
   vtkImageData** outData,
-  int outExt[6], int threadId )
+  int outExt[6], int vtkNotUsed( threadId ) )
 {
   if ( inData[INPUT_GROUND_TRUTH_VOLUME][0] == NULL
        || inData[INPUT_GROUND_TRUTH_VOLUME_ALPHA][0] == NULL
@@ -454,25 +514,21 @@ void vtkPlusCompareVolumes::ThreadedRequestData (
     return;
   }
 
-  vtkImageData* gtVolData = inData[INPUT_GROUND_TRUTH_VOLUME][0];
-  void* gtPtr = gtVolData->GetScalarPointer();
-  void* gtAlphaPtr = inData[INPUT_GROUND_TRUTH_VOLUME_ALPHA][0]->GetScalarPointer();
-  void* testPtr = inData[INPUT_TEST_VOLUME][0]->GetScalarPointer();
-  void* testAlphaPtr = inData[INPUT_TEST_VOLUME_ALPHA][0]->GetScalarPointer();
-  void* slicesAlphaPtr = inData[INPUT_SLICES_VOLUME_ALPHA][0]->GetScalarPointer();
-
-  vtkImageData* outVolDataTru = inData[INPUT_GROUND_TRUTH_VOLUME][0];
-  double* outPtrTru = static_cast< double* >( outVolDataTru->GetScalarPointer() );
-  double* outPtrAbs = static_cast< double* >( outData[OUTPUT_ABS_DIFF_VOLUME]->GetScalarPointer() );
+  vtkImageData* inVolumes[5] = { NULL };
+  for ( int i = 0; i < 5; i++ )
+  {
+    inVolumes[i] = inData[i][0];
+    if ( inVolumes[i]->GetNumberOfScalarComponents() != 1 )
+    {
+      vtkErrorMacro( << "Execute: input volumes must have a single scalar component" );
+      return;
+    }
+  }
 
-  switch ( gtVolData->GetScalarType() )
+  switch ( inVolumes[INPUT_GROUND_TRUTH_VOLUME]->GetScalarType() )
   {
     vtkTemplateMacro(
-      vtkPlusCompareVolumesExecute( this, gtVolData, outVolDataTru,
-                                    static_cast<VTK_TT*>( gtPtr ),   static_cast<VTK_TT*>( gtAlphaPtr ),
-                                    static_cast<VTK_TT*>( testPtr ), static_cast<VTK_TT*>( testAlphaPtr ),
-                                    static_cast<VTK_TT*>( slicesAlphaPtr ),
-                                    outPtrTru, outPtrAbs, outExt, threadId )
+      vtkPlusCompareVolumesExecute<VTK_TT>( this, inVolumes, outData, outExt )
     );
   default:
     vtkErrorMacro( << "Execute: Unknown ScalarType" );
@@ -480,6 +536,7 @@ void vtkPlusCompareVolumes::ThreadedRequestData (
   }
 }
 
+//----------------------------------------------------------------------------
 int vtkPlusCompareVolumes::FillInputPortInformation( int port, vtkInformation* info )
 {
   /*if (port == 1)
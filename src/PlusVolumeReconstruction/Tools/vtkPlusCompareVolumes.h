@@ -27,6 +27,8 @@
 #include "vtkThreadedImageAlgorithm.h"
 #include <vector>
 
+class vtkPlusRecursiveCriticalSection;
+
 class vtkPlusCompareVolumes : public vtkThreadedImageAlgorithm
 {
 public:
@@ -110,9 +112,34 @@ public:
   void resetAbsoluteHistogram();
   void resetAbsoluteHistogramWithHoles();
 
+  /*!
+    Statistics computed by one ThreadedRequestData call for its piece of the volume.
+    Each piece is processed independently and the pieces are merged in RequestData
+    in the order of their extents, so the result does not depend on the thread scheduling.
+  */
+  struct PieceStatistics
+  {
+    PieceStatistics();
+    int Extent[6];
+    int TrueHistogram[511];
+    int AbsoluteHistogram[256];
+    int AbsoluteHistogramWithHoles[256];
+    int NumberOfHoles;
+    int NumberOfFilledHoles;
+    int NumberVoxelsVisible;
+    double AbsoluteDifferenceSumInAllHoles;
+    std::vector<double> TrueDifferences;
+  };
+
+  /*! Add the statistics of a processed piece (thread-safe) */
+  void AddPieceStatistics(const PieceStatistics& pieceStatistics);
+
 protected:
   vtkPlusCompareVolumes();
-  ~vtkPlusCompareVolumes() {};
+  ~vtkPlusCompareVolumes();
+
+  /*! Merge the statistics of all the pieces and compute the final statistics */
+  void MergePieceStatistics();
 
   double RMS;
   double TrueMean,     TrueStdev,     TrueMedian,     TrueMinimum,     TrueMaximum,     True95thPercentile,     True5thPercentile;
@@ -125,8 +152,13 @@ protected:
   int NumberOfFilledHoles;
   int NumberVoxelsVisible;
 
+  std::vector<PieceStatistics> Pieces;
+  vtkPlusRecursiveCriticalSection* PiecesMutex;
+
   virtual int RequestInformation (vtkInformation *, vtkInformationVector**, vtkInformationVector *);
 
+  virtual int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector);
+
   void ThreadedRequestData (vtkInformation* request,
                             vtkInformationVector** inputVector,
                             vtkInformationVector* outputVector,
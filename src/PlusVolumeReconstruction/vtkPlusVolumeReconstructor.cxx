@@ -7,6 +7,7 @@
 // Local includes
 #include "PlusConfigure.h"
 #include "PlusTrackedFrame.h"
+#include "vtkPlusColumnarTrackedFrameList.h"
 #include "vtkPlusFanAngleDetectorAlgo.h"
 #include "vtkPlusFillHolesInVolume.h"
 #include "vtkPlusTrackedFrameList.h"
@@ -22,6 +23,7 @@
 #include <vtkImageExtractComponents.h>
 #include <vtkImageImport.h>
 #include <vtkImageViewer.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
@@ -36,6 +38,40 @@
 
 vtkStandardNewMacro(vtkPlusVolumeReconstructor);
 
+namespace
+{
+  /*! Result of the preparation of a single frame, consumed by the insertion stage of AddTrackedFrameList */
+  struct PreparedFrame
+  {
+    PreparedFrame()
+      : Status(PLUS_FAIL)
+      , IsMatrixValid(false)
+      , IsImageEmpty(false)
+    {
+      FanAnglesDeg[0] = 0.0;
+      FanAnglesDeg[1] = 0.0;
+    }
+    PlusStatus Status;
+    bool IsMatrixValid;
+    bool IsImageEmpty;
+    double FanAnglesDeg[2];
+    vtkSmartPointer<vtkMatrix4x4> ImageToReferenceTransformMatrix;
+  };
+
+  struct PrepareFramesThreadFunctionInfoStruct
+  {
+    vtkPlusTrackedFrameList* TrackedFrameList;
+    PlusTransformName ImageToReferenceTransformName;
+    bool EnableFanAnglesAutoDetect;
+    double FanAnglesDeg[2];
+    std::vector<int> FrameIndices;
+    std::vector<PreparedFrame> PreparedFrames;
+    // Each thread uses its own transform repository and fan angle detector, as they store per-frame state
+    std::vector< vtkSmartPointer<vtkPlusTransformRepository> > TransformRepositories;
+    std::vector< vtkSmartPointer<vtkPlusFanAngleDetectorAlgo> > FanAngleDetectors;
+  };
+}
+
 //----------------------------------------------------------------------------
 vtkPlusVolumeReconstructor::vtkPlusVolumeReconstructor()
   : ReconstructedVolume(vtkSmartPointer<vtkImageData>::New())
@@ -46,6 +82,7 @@ vtkPlusVolumeReconstructor::vtkPlusVolumeReconstructor()
   , EnableFanAnglesAutoDetect(false)
   , SkipInterval(1)
   , ReconstructedVolumeUpdatedTime(0)
+  , NumberOfPreparationThreads(0)
 {
   this->FanAnglesDeg[0] = 0.0;
   this->FanAnglesDeg[1] = 0.0;
@@ -264,12 +301,11 @@ PlusStatus vtkPlusVolumeReconstructor::WriteConfiguration(vtkXMLDataElement* con
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusVolumeReconstructor::AddImageToExtent(vtkImageData* image, vtkMatrix4x4* imageToReference, double* extent_Ref)
+void vtkPlusVolumeReconstructor::AddImageToExtent(const int frameExtent[6], const double imageToReference[16], double* extent_Ref)
 {
   // Output volume is in the Reference coordinate system.
 
   // Prepare the four corner points of the input US image.
-  int* frameExtent = image->GetExtent();
   std::vector< double* > corners_ImagePix;
   double minX = frameExtent[0];
   double maxX = frameExtent[1];
@@ -296,7 +332,7 @@ void vtkPlusVolumeReconstructor::AddImageToExtent(vtkImageData* image, vtkMatrix
   for (unsigned int corner = 0; corner < corners_ImagePix.size(); ++corner)
   {
     double corner_Ref[ 4 ] = { 0, 0, 0, 1 }; // position of the corner in the Reference coordinate system
-    imageToReference->MultiplyPoint(corners_ImagePix[corner], corner_Ref);
+    vtkMatrix4x4::MultiplyPoint(imageToReference, corners_ImagePix[corner], corner_Ref);
 
     for (int axis = 0; axis < 3; axis ++)
     {
@@ -375,39 +411,34 @@ PlusStatus vtkPlusVolumeReconstructor::SetOutputExtentFromFrameList(vtkPlusTrack
     VTK_DOUBLE_MAX, VTK_DOUBLE_MIN
   };
 
-  const int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  // Collect the ImageToReference transforms and frame sizes of all frames into contiguous arrays (pixel data is not needed)
+  vtkSmartPointer<vtkPlusColumnarTrackedFrameList> frameColumns = vtkSmartPointer<vtkPlusColumnarTrackedFrameList>::New();
+  if (frameColumns->BuildFromTrackedFrameList(trackedFrameList, false) != PLUS_SUCCESS
+      || frameColumns->AddComputedTransformColumn(imageToReferenceTransformName, transformRepository) != PLUS_SUCCESS)
+  {
+    errorDescription = "Failed to get frame transforms";
+    LOG_ERROR("Failed to set output extent from tracked frame list - cannot get ImageToReference transforms of the frames");
+    return PLUS_FAIL;
+  }
+  const int imageToReferenceColumnIndex = frameColumns->GetTransformColumnIndex(imageToReferenceTransformName);
+  const double* imageToReferenceMatrices = frameColumns->GetTransformMatrices(imageToReferenceColumnIndex);
+  const unsigned char* imageToReferenceValidFlags = frameColumns->GetTransformValidFlags(imageToReferenceColumnIndex);
+  const unsigned int* frameSizes = frameColumns->GetFrameSizes();
+
+  const int numberOfFrames = frameColumns->GetNumberOfFrames();
   int numberOfValidFrames = 0;
   for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
   {
-    PlusTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
-
-    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to update transform repository with tracked frame!");
-      continue;
-    }
-
-    // Get transform
-    bool isMatrixValid(false);
-    vtkSmartPointer<vtkMatrix4x4> imageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    if (transformRepository->GetTransform(imageToReferenceTransformName, imageToReferenceTransformMatrix, &isMatrixValid) != PLUS_SUCCESS)
+    if (!imageToReferenceValidFlags[frameIndex])
     {
-      std::string strImageToReferenceTransformName;
-      imageToReferenceTransformName.GetTransformName(strImageToReferenceTransformName);
-      LOG_WARNING("Failed to get transform '" << strImageToReferenceTransformName << "' from transform repository!");
       continue;
     }
+    numberOfValidFrames++;
 
-    if (isMatrixValid)
-    {
-      numberOfValidFrames++;
-
-      // Get image (only the frame extents will be used)
-      vtkImageData* frameImage = trackedFrameList->GetTrackedFrame(frameIndex)->GetImageData()->GetImage();
-
-      // Expand the extent_Ref to include this frame
-      AddImageToExtent(frameImage, imageToReferenceTransformMatrix, extent_Ref);
-    }
+    // Expand the extent_Ref to include this frame
+    const unsigned int* frameSize = frameSizes + 3 * frameIndex;
+    const int frameExtent[6] = { 0, static_cast<int>(frameSize[0]) - 1, 0, static_cast<int>(frameSize[1]) - 1, 0, static_cast<int>(frameSize[2]) - 1 };
+    AddImageToExtent(frameExtent, imageToReferenceMatrices + 16 * frameIndex, extent_Ref);
   }
 
   LOG_DEBUG("Automatic volume extent computation from frames used " << numberOfValidFrames << " out of " << numberOfFrames << " (probably wrong image or reference coordinate system was defined or all transforms were invalid)");
@@ -512,6 +543,172 @@ PlusStatus vtkPlusVolumeReconstructor::AddTrackedFrame(PlusTrackedFrame* frame,
   return status;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVolumeReconstructor::AddTrackedFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository,
+    int* numberOfFramesAddedToVolume/*=NULL*/, double* preparationTimeSec/*=NULL*/, double* insertionTimeSec/*=NULL*/)
+{
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Failed to add tracked frame list to volume - input frame list is NULL");
+    return PLUS_FAIL;
+  }
+  if (transformRepository == NULL)
+  {
+    LOG_ERROR("Failed to add tracked frame list to volume - input transform repository is NULL");
+    return PLUS_FAIL;
+  }
+
+  PrepareFramesThreadFunctionInfoStruct str;
+  if (GetImageToReferenceTransformName(str.ImageToReferenceTransformName) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Invalid ImageToReference transform name");
+    return PLUS_FAIL;
+  }
+  str.TrackedFrameList = trackedFrameList;
+  str.EnableFanAnglesAutoDetect = this->EnableFanAnglesAutoDetect;
+  str.FanAnglesDeg[0] = this->FanAnglesDeg[0];
+  str.FanAnglesDeg[1] = this->FanAnglesDeg[1];
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); frameIndex += this->SkipInterval)
+  {
+    str.FrameIndices.push_back(frameIndex);
+  }
+  str.PreparedFrames.resize(str.FrameIndices.size());
+
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (this->NumberOfPreparationThreads > 0)
+  {
+    threader->SetNumberOfThreads(this->NumberOfPreparationThreads);
+  }
+  int numberOfThreads = threader->GetNumberOfThreads();
+
+  // Create per-thread copies of the stateful helper objects (must be done on the calling thread)
+  for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+  {
+    vtkSmartPointer<vtkPlusTransformRepository> threadTransformRepository = vtkSmartPointer<vtkPlusTransformRepository>::New();
+    threadTransformRepository->DeepCopy(transformRepository, true);
+    str.TransformRepositories.push_back(threadTransformRepository);
+
+    vtkSmartPointer<vtkPlusFanAngleDetectorAlgo> threadFanAngleDetector = vtkSmartPointer<vtkPlusFanAngleDetectorAlgo>::New();
+    threadFanAngleDetector->SetClipRectangleOrigin(this->FanAngleDetector->GetClipRectangleOrigin());
+    threadFanAngleDetector->SetClipRectangleSize(this->FanAngleDetector->GetClipRectangleSize());
+    threadFanAngleDetector->SetFanOrigin(this->FanAngleDetector->GetFanOrigin());
+    threadFanAngleDetector->SetFanRadiusStart(this->FanAngleDetector->GetFanRadiusStart());
+    threadFanAngleDetector->SetFanRadiusStop(this->FanAngleDetector->GetFanRadiusStop());
+    threadFanAngleDetector->SetFilterRadiusPixel(this->FanAngleDetector->GetFilterRadiusPixel());
+    threadFanAngleDetector->SetBrightnessThreshold(this->FanAngleDetector->GetBrightnessThreshold());
+    threadFanAngleDetector->SetMaxFanAnglesDeg(this->FanAnglesDeg);
+    str.FanAngleDetectors.push_back(threadFanAngleDetector);
+  }
+
+  // Preparation stage: transform lookup and fan angle detection, in parallel
+  double preparationStartTime = vtkPlusAccurateTimer::GetSystemTime();
+  threader->SetSingleMethod(PrepareFramesThreadFunction, &str);
+  threader->SingleMethodExecute();
+  double insertionStartTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  // Insertion stage: paste the prepared slices in frame order, so that the result is identical to sequential insertion
+  int framesAddedToVolume = 0;
+  for (unsigned int i = 0; i < str.FrameIndices.size(); ++i)
+  {
+    vtkPlusLogger::PrintProgressbar((100.0 * str.FrameIndices[i]) / trackedFrameList->GetNumberOfTrackedFrames());
+    PreparedFrame& preparedFrame = str.PreparedFrames[i];
+    if (preparedFrame.Status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tracked frame to volume with frame #" << str.FrameIndices[i]);
+      continue;
+    }
+    if (!preparedFrame.IsMatrixValid)
+    {
+      continue;
+    }
+    framesAddedToVolume++;
+    this->Reconstructor->SetFanAnglesDeg(preparedFrame.FanAnglesDeg);
+    if (preparedFrame.IsImageEmpty)
+    {
+      continue;
+    }
+    vtkImageData* frameImage = trackedFrameList->GetTrackedFrame(str.FrameIndices[i])->GetImageData()->GetImage();
+    if (this->Reconstructor->InsertSlice(frameImage, preparedFrame.ImageToReferenceTransformMatrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tracked frame to volume with frame #" << str.FrameIndices[i]);
+      continue;
+    }
+    this->Modified();
+  }
+  double insertionStopTime = vtkPlusAccurateTimer::GetSystemTime();
+
+  if (numberOfFramesAddedToVolume != NULL)
+  {
+    *numberOfFramesAddedToVolume = framesAddedToVolume;
+  }
+  if (preparationTimeSec != NULL)
+  {
+    *preparationTimeSec = insertionStartTime - preparationStartTime;
+  }
+  if (insertionTimeSec != NULL)
+  {
+    *insertionTimeSec = insertionStopTime - insertionStartTime;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlusVolumeReconstructor::PrepareFramesThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  PrepareFramesThreadFunctionInfoStruct* str = static_cast<PrepareFramesThreadFunctionInfoStruct*>(threadInfo->UserData);
+
+  int threadId = threadInfo->ThreadID;
+  int threadCount = threadInfo->NumberOfThreads;
+  vtkPlusTransformRepository* transformRepository = str->TransformRepositories[threadId];
+  vtkPlusFanAngleDetectorAlgo* fanAngleDetector = str->FanAngleDetectors[threadId];
+
+  // Frames are distributed in an interleaved way to balance the load between threads
+  for (unsigned int i = threadId; i < str->FrameIndices.size(); i += threadCount)
+  {
+    PreparedFrame& preparedFrame = str->PreparedFrames[i];
+    PlusTrackedFrame* frame = str->TrackedFrameList->GetTrackedFrame(str->FrameIndices[i]);
+
+    if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to update transform repository with frame #" << str->FrameIndices[i]);
+      continue;
+    }
+
+    preparedFrame.ImageToReferenceTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (transformRepository->GetTransform(str->ImageToReferenceTransformName, preparedFrame.ImageToReferenceTransformMatrix, &preparedFrame.IsMatrixValid) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get transform '" << str->ImageToReferenceTransformName.GetTransformName() << "' from transform repository");
+      continue;
+    }
+    preparedFrame.Status = PLUS_SUCCESS;
+    if (!preparedFrame.IsMatrixValid)
+    {
+      // Insert only valid frame into volume
+      continue;
+    }
+
+    preparedFrame.FanAnglesDeg[0] = str->FanAnglesDeg[0];
+    preparedFrame.FanAnglesDeg[1] = str->FanAnglesDeg[1];
+    if (str->EnableFanAnglesAutoDetect)
+    {
+      fanAngleDetector->SetImage(frame->GetImageData()->GetImage());
+      fanAngleDetector->Update();
+      fanAngleDetector->SetImage(NULL);
+      if (fanAngleDetector->GetIsFrameEmpty())
+      {
+        // no image content is found, the frame is skipped
+        preparedFrame.IsImageEmpty = true;
+        continue;
+      }
+      fanAngleDetector->GetDetectedFanAnglesDeg(preparedFrame.FanAnglesDeg);
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusVolumeReconstructor::UpdateReconstructedVolume()
 {
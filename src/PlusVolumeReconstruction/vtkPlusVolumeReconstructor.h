@@ -73,6 +73,22 @@ public:
   */
   virtual PlusStatus AddTrackedFrame(PlusTrackedFrame* frame, vtkPlusTransformRepository* transformRepository, bool* insertedIntoVolume = NULL);
 
+  /*!
+    Inserts every SkipInterval-th frame of the tracked frame list into the volume (offline reconstruction).
+    Per-frame preparation (transform lookup and fan angle detection) is performed in parallel, on
+    NumberOfPreparationThreads threads, then the prepared slices are pasted into the volume in frame order.
+    The resulting volume is the same as if AddTrackedFrame was called for each frame.
+    \param numberOfFramesAddedToVolume Optional output: number of frames with a valid ImageToReference transform
+    \param preparationTimeSec Optional output: time spent with preparing the frames
+    \param insertionTimeSec Optional output: time spent with pasting the slices into the volume
+  */
+  virtual PlusStatus AddTrackedFrameList(vtkPlusTrackedFrameList* trackedFrameList, vtkPlusTransformRepository* transformRepository,
+                                         int* numberOfFramesAddedToVolume = NULL, double* preparationTimeSec = NULL, double* insertionTimeSec = NULL);
+
+  /*! Number of threads used for frame preparation in AddTrackedFrameList. If 0 then the number of threads is determined automatically. */
+  vtkGetMacro(NumberOfPreparationThreads, int);
+  vtkSetMacro(NumberOfPreparationThreads, int);
+
   /*!
     Makes the reconstructed volume ready to be retrieved.
     The slices are pasted into the volume immediately, but hole filling is performed only when this method is called.
@@ -198,12 +214,19 @@ protected:
   vtkPlusVolumeReconstructor();
   virtual ~vtkPlusVolumeReconstructor();
 
-  /*! Helper function for computing the extent of the reconstructed volume that encloses all the frames */
-  void AddImageToExtent(vtkImageData* image, vtkMatrix4x4* imageToReference, double* extent_Ref);
+  /*!
+    Helper function for computing the extent of the reconstructed volume that encloses all the frames
+    \param frameExtent Extent of the frame in pixels
+    \param imageToReference ImageToReference transform matrix (row-major)
+  */
+  void AddImageToExtent(const int frameExtent[6], const double imageToReference[16], double* extent_Ref);
 
   /*! Construct ImageToReference transform name from the image and reference coordinate frame member variables */
   PlusStatus GetImageToReferenceTransformName(PlusTransformName& imageToReferenceTransformName);
 
+  /*! Thread function that prepares a subset of the frames for AddTrackedFrameList */
+  static VTK_THREAD_RETURN_TYPE PrepareFramesThreadFunction(void* arg);
+
 protected:
   vtkPlusPasteSliceIntoVolume* Reconstructor;
   vtkPlusFillHolesInVolume* HoleFiller;
@@ -241,6 +264,9 @@ protected:
 
   std::string ImportanceMaskFilename;
 
+  /*! Number of threads used for frame preparation in AddTrackedFrameList (0 = automatic) */
+  int NumberOfPreparationThreads;
+
 private:
   vtkPlusVolumeReconstructor(const vtkPlusVolumeReconstructor&);  // Not implemented.
   void operator=(const vtkPlusVolumeReconstructor&);  // Not implemented.
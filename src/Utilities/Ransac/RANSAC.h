@@ -9,7 +9,6 @@
 #include <limits>
 #include "ParametersEstimator.h"
 #include "itkMultiThreader.h"
-#include "itkSimpleFastMutexLock.h"
 #include "itkExceptionObject.h"
 
 /**
@@ -25,6 +24,12 @@
  *    number of data objects.
  * 4. Take the largest subset of objects which agreed on the parameters and 
  *    compute a least squares fit using them.
+ *
+ * Hypotheses are evaluated in parallel in fixed size batches. The subset of
+ * each hypothesis is drawn by a random generator that only depends on the
+ * random seed and the index of the hypothesis, and the batch results are
+ * merged in hypothesis index order. Therefore for a given seed the result
+ * does not depend on the number of threads or the thread scheduling.
  * 
  * This is based on:
  * Fischler M.A., Bolles R.C., 
@@ -68,6 +73,38 @@ public:
   void SetNumberOfThreads( unsigned int numberOfThreads );
   unsigned int GetNumberOfThreads();
 
+  /**
+   * Set/Get the seed of the random generator used for selecting the subsets.
+   * If the seed is 0 (default) then the generator is seeded with the current
+   * time, so two runs do not give the same result. With any other value the
+   * result is reproducible.
+   */
+  void SetRandomSeed( unsigned int seed );
+  unsigned int GetRandomSeed();
+
+  /**
+   * Enable/disable adaptive early termination. If enabled (default) then the
+   * number of hypotheses is updated whenever a larger consensus set is found,
+   * using the current inlier ratio and desiredProbabilityForNoOutliers. If
+   * disabled then MaximumNumberOfTries hypotheses are tested (or all possible
+   * subsets, if there are fewer).
+   */
+  void SetAdaptiveTermination( bool adaptiveTermination );
+  bool GetAdaptiveTermination();
+
+  /**
+   * Set/Get the maximum number of hypotheses that are tested. Default is
+   * std::numeric_limits<unsigned int>::max() (no limit, other than the number
+   * of all possible subsets).
+   */
+  void SetMaximumNumberOfTries( unsigned int maximumNumberOfTries );
+  unsigned int GetMaximumNumberOfTries();
+
+  /**
+   * Get the number of hypotheses that were tested in the last Compute call.
+   */
+  unsigned int GetNumberOfTriesPerformed();
+
   /**
    * Set the function object that is able to estimate the desired parametric 
    * entity (e.g. PlaneParametersEstimator).
@@ -124,48 +161,65 @@ private:
     */
   unsigned int Choose( unsigned int n, unsigned int m );
 
-  class SubSetIndexComparator {
-    private:
-      int length;
+  /**
+   * Random generator (SplitMix64) for selecting the subset of a hypothesis.
+   * The sequence only depends on the seed and the hypothesis index, so each
+   * hypothesis can be generated by any thread without shared state.
+   */
+  class HypothesisRandomGenerator {
     public:
-      SubSetIndexComparator(int arrayLength) : length(arrayLength){}
-      bool operator()(const int *arr1, const int *arr2) const {
-        for(int i=0; i<this->length; i++) {
-          if(arr1[i] < arr2[i])
-            return true;
-          else if(arr1[i] > arr2[i]) 
-            return false;
-        }
-        return false;      
+      HypothesisRandomGenerator( unsigned long long seed, unsigned long long hypothesisIndex )
+        : state( seed ^ ( ( hypothesisIndex + 1 ) * 0x9E3779B97F4A7C15ULL ) ) {}
+      unsigned long long Next() {
+        unsigned long long z = ( this->state += 0x9E3779B97F4A7C15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+        return z ^ ( z >> 31 );
       }
+      //uniformly distributed integer in [0,maxValue]
+      unsigned int NextIndex( unsigned int maxValue ) {
+        return static_cast<unsigned int>( this->Next() % ( static_cast<unsigned long long>( maxValue ) + 1 ) );
+      }
+    private:
+      unsigned long long state;
   };
-                   
+
   static ITK_THREAD_RETURN_TYPE RANSACThreadCallback( void *arg );
 
+          //number of hypotheses evaluated in parallel before the results are
+          //merged, independent of the number of threads to get the same
+          //result with any number of threads
+  static const unsigned int HYPOTHESES_PER_BATCH = 128;
+
                  //number of threads used in computing the RANSAC hypotheses
   unsigned int numberOfThreads;
 
-       //the following variables are shared by all threads used in the RANSAC
-       //computation
-
-         //array corresponding to length of data array, data[i]== true if it 
-         //agrees with the best model, otherwise false
-  bool *bestVotes;
-  unsigned int numVotesForBest;
+  unsigned int randomSeed;
+  bool adaptiveTermination;
+  unsigned int maximumNumberOfTries;
+  unsigned int numberOfTriesPerformed;
 
   std::vector<T> data;
 
-          //set which holds all of the subgroups/hypotheses already selected
-   std::set<int *, SubSetIndexComparator > *chosenSubSets;
-          //number of iterations, equivalent to desired number of hypotheses
-   unsigned int numTries;
-
-   double numerator;
-   unsigned int allTries;
-
    typename ParametersEstimator<T,S>::Pointer paramEstimator;
-   itk::SimpleFastMutexLock hypothesisMutex;
-   itk::SimpleFastMutexLock resultsMutex;
+
+       //the following variables are shared by all threads used in the RANSAC
+       //computation, each hypothesis of the current batch is written by exactly
+       //one thread
+
+  unsigned long long currentSeed;
+          //index of the first hypothesis and number of hypotheses in the batch
+  unsigned int batchStart;
+  unsigned int batchSize;
+          //number of votes of the best hypothesis at the start of the batch
+  unsigned int numVotesForBest;
+          //subset indexes of the hypotheses in the batch (numForEstimate each)
+  std::vector<int> batchSubSets;
+  std::vector< std::vector<S> > batchParameters;
+  std::vector<unsigned int> batchNumVotes;
+          //per-thread scratch buffers
+  std::vector< std::vector<char> > threadNotChosen;
+  std::vector< std::vector<T *> > threadExactEstimateData;
 };
 
 } // end namespace itk
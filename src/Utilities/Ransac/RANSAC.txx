@@ -8,6 +8,10 @@ template<class T, class S>
 RANSAC<T,S>::RANSAC( )
 {
   this->numberOfThreads = 1;
+  this->randomSeed = 0;
+  this->adaptiveTermination = true;
+  this->maximumNumberOfTries = std::numeric_limits<unsigned int>::max();
+  this->numberOfTriesPerformed = 0;
 }
 
 
@@ -36,6 +40,58 @@ unsigned int RANSAC<T,S>::GetNumberOfThreads()
 }
 
 
+template<class T, class S>
+void RANSAC<T,S>::SetRandomSeed( unsigned int seed )
+{
+  this->randomSeed = seed;
+}
+
+
+template<class T, class S>
+unsigned int RANSAC<T,S>::GetRandomSeed()
+{
+  return this->randomSeed;
+}
+
+
+template<class T, class S>
+void RANSAC<T,S>::SetAdaptiveTermination( bool adaptiveTermination )
+{
+  this->adaptiveTermination = adaptiveTermination;
+}
+
+
+template<class T, class S>
+bool RANSAC<T,S>::GetAdaptiveTermination()
+{
+  return this->adaptiveTermination;
+}
+
+
+template<class T, class S>
+void RANSAC<T,S>::SetMaximumNumberOfTries( unsigned int maximumNumberOfTries )
+{
+  if( maximumNumberOfTries==0 )
+     throw ExceptionObject(__FILE__,__LINE__,
+                           "Invalid setting for maximum number of tries.");
+  this->maximumNumberOfTries = maximumNumberOfTries;
+}
+
+
+template<class T, class S>
+unsigned int RANSAC<T,S>::GetMaximumNumberOfTries()
+{
+  return this->maximumNumberOfTries;
+}
+
+
+template<class T, class S>
+unsigned int RANSAC<T,S>::GetNumberOfTriesPerformed()
+{
+  return this->numberOfTriesPerformed;
+}
+
+
 template<class T, class S>
 void RANSAC<T,S>::SetParametersEstimator( typename ParametersEstimator<T,S>::Pointer paramEstimator )
 {
@@ -70,6 +126,7 @@ double RANSAC<T,S>::Compute( std::vector<S> &parameters,
 {
                         //STEP1: setup
   parameters.clear();
+  this->numberOfTriesPerformed = 0;
   //the data or the parameter estimator were not set
   //or desiredProbabilityForNoOutliers is not in (0.0,1.0)
   if( this->paramEstimator.IsNull() ||
@@ -79,54 +136,99 @@ double RANSAC<T,S>::Compute( std::vector<S> &parameters,
     return 0;
 
   unsigned int numForEstimate = this->paramEstimator->GetMinimalForEstimate();  
-  size_t numDataObjects = this->data.size();
+  unsigned int numDataObjects = static_cast<unsigned int>( this->data.size() );
 
-  this->bestVotes = new bool[numDataObjects];
                  //initalize with 0 so that the first computation which gives 
                 //any type of fit will be set to best
   this->numVotesForBest = 0;
+  std::vector<S> bestParameters;
 
-  SubSetIndexComparator subSetIndexComparator( numForEstimate );
-  this->chosenSubSets = 
-    new std::set<int *, SubSetIndexComparator >( subSetIndexComparator );
           //initialize with the number of all possible subsets
-  this->allTries = Choose( numDataObjects, numForEstimate );
-  this->numTries = this->allTries;
-  this->numerator = log( 1.0-desiredProbabilityForNoOutliers );
-  
-
-  srand( (unsigned)time(NULL) ); //seed random number generator
+  unsigned int allTries = Choose( numDataObjects, numForEstimate );
+  if( allTries > this->maximumNumberOfTries )
+    allTries = this->maximumNumberOfTries;
+  unsigned int numTries = allTries;
+  double numerator = log( 1.0-desiredProbabilityForNoOutliers );
+
+  this->currentSeed = ( this->randomSeed != 0 ) ? this->randomSeed : static_cast<unsigned long long>( time(NULL) );
+
+          //set which holds all of the subgroups/hypotheses already selected,
+          //only accessed when merging the batch results (single thread)
+  std::set< std::vector<int> > chosenSubSets;
+
+          //allocate per-batch results and per-thread scratch buffers once
+  this->batchSubSets.resize( HYPOTHESES_PER_BATCH*numForEstimate );
+  this->batchParameters.resize( HYPOTHESES_PER_BATCH );
+  this->batchNumVotes.resize( HYPOTHESES_PER_BATCH );
+  this->threadNotChosen.resize( this->numberOfThreads );
+  this->threadExactEstimateData.resize( this->numberOfThreads );
+  for( unsigned int t=0; t<this->numberOfThreads; t++ ) {
+    this->threadNotChosen[t].resize( numDataObjects );
+    this->threadExactEstimateData[t].reserve( numForEstimate );
+  }
 
-                  //STEP2: create the threads that generate hypotheses and test
+                  //STEP2: create the threads that generate hypotheses and test,
+                  //batch by batch
 
   itk::MultiThreader::Pointer threader = itk::MultiThreader::New();   
   threader->SetNumberOfThreads( this->numberOfThreads );
   threader->SetSingleMethod( RANSAC<T,S>::RANSACThreadCallback, this );
+
+  for( this->batchStart = 0; this->batchStart < numTries; this->batchStart += this->batchSize ) {
+    this->batchSize = numTries - this->batchStart;
+    if( this->batchSize > HYPOTHESES_PER_BATCH )
+      this->batchSize = HYPOTHESES_PER_BATCH;
+
             //runs all threads and blocks till they finish
-  threader->SingleMethodExecute();
+    threader->SingleMethodExecute();
+
+            //merge the results in hypothesis index order, exactly as if the
+            //hypotheses were tested one after the other
+    for( unsigned int j=0; j<this->batchSize && this->batchStart+j<numTries; j++ ) {
+      this->numberOfTriesPerformed++;
+              //check that the sub-set is unique
+      std::vector<int> subSet( this->batchSubSets.begin()+j*numForEstimate,
+                               this->batchSubSets.begin()+(j+1)*numForEstimate );
+      if( !chosenSubSets.insert( subSet ).second )
+        continue;
+              //selected data is a singular configuration (e.g. three 
+              //colinear points for a circle fit)
+      if( this->batchParameters[j].empty() )
+        continue;
+      unsigned int numVotesForCur = this->batchNumVotes[j];
+      if( numVotesForCur <= this->numVotesForBest )
+        continue;
+
+              //found a larger consensus set
+      this->numVotesForBest = numVotesForCur;
+      bestParameters = this->batchParameters[j];
+      if( this->numVotesForBest == numDataObjects ) {
+              //all data objects are inliers, terminate the search
+        numTries = this->batchStart+j+1;
+      }
+      else if( this->adaptiveTermination ) {
+              //update the estimate of outliers and the number of iterations we need                                 
+        double denominator = log( 1.0 - pow((double)numVotesForCur/(double)numDataObjects, 
+          (double)(numForEstimate)) );
+        double newNumTries = numerator/denominator + 0.5;
+              //there are cases when the probablistic number of tries is greater than all possible sub-sets
+        numTries = newNumTries<allTries ? (unsigned int)newNumTries : allTries;
+      }
+    }
+  }
 
-         //STEP3: least squares estimate using largest consensus set and cleanup
+         //STEP3: least squares estimate using largest consensus set
 
   std::vector<T *> leastSquaresEstimateData;
   if( this->numVotesForBest > 0 ) {
+            //vote counting may stop early, so count the votes of the best
+            //hypothesis again
     for( unsigned int j=0; j<numDataObjects; j++ ) {
-      if( this->bestVotes[j] )
-        leastSquaresEstimateData.push_back( &(data[j]) );
+      if( this->paramEstimator->Agree( bestParameters, this->data[j] ) )
+        leastSquaresEstimateData.push_back( &(this->data[j]) );
     }
     paramEstimator->LeastSquaresEstimate( leastSquaresEstimateData,parameters );
   }
-                      //cleanup
-  typename std::set<int *, SubSetIndexComparator >::iterator it = 
-    this->chosenSubSets->begin();
-  typename std::set<int *, SubSetIndexComparator >::iterator chosenSubSetsEnd = 
-    this->chosenSubSets->end();
-  while( it!=chosenSubSetsEnd ) {
-    delete [] (*it);
-    it++;
-  }
-  this->chosenSubSets->clear();
-  delete this->chosenSubSets;
-  delete [] this->bestVotes;
 
   return (double)this->numVotesForBest/(double)numDataObjects;
 }
@@ -141,53 +243,48 @@ ITK_THREAD_RETURN_TYPE RANSAC<T,S>::RANSACThreadCallback( void *arg )
 
   if( caller != NULL )
   {
-    unsigned int maxIndex, numVotesForCur;
-    int *curSubSetIndexes(NULL);
-
-    unsigned int numDataObjects = caller->data.size();
+    unsigned int threadId = infoStruct->ThreadID;
+    unsigned int threadCount = infoStruct->NumberOfThreads;
+    unsigned int numDataObjects = static_cast<unsigned int>( caller->data.size() );
     unsigned int numForEstimate = caller->paramEstimator->GetMinimalForEstimate();
-    std::vector<T *> exactEstimateData;
-    std::vector<S> exactEstimateParameters;
-    double denominator;
-    
-    //true if data[i] agrees with the current model, otherwise false
-    bool *curVotes = new bool[numDataObjects];
 
     //true if data[i] is NOT chosen for computing the exact fit, otherwise false
-    bool *notChosen = new bool[numDataObjects]; 
+    std::vector<char> &notChosen = caller->threadNotChosen[threadId];
+    std::vector<T *> &exactEstimateData = caller->threadExactEstimateData[threadId];
 
-    for( unsigned int i = 0; i < caller->numTries; i++ )
+    for( unsigned int j = threadId; j < caller->batchSize; j += threadCount )
     {
+      HypothesisRandomGenerator generator( caller->currentSeed, caller->batchStart + j );
+
       //randomly select data for exact model fit ('numForEstimate' objects).
-      std::fill( notChosen, notChosen+numDataObjects, true );      
-      curSubSetIndexes = new int[numForEstimate];
+      std::fill( notChosen.begin(), notChosen.end(), 1 );
       exactEstimateData.clear();
-      maxIndex = numDataObjects-1; 
+      unsigned int maxIndex = numDataObjects-1; 
 
       for( unsigned int l = 0; l < numForEstimate; l++ )
       {
         //selectedIndex is in [0,maxIndex]
-        int selectedIndex = (int)( ((float)rand() / (float)RAND_MAX) * maxIndex + 0.5);
+        int selectedIndex = static_cast<int>( generator.NextIndex( maxIndex ) );
         unsigned int k(0);
-        int j(-1);
-        for( ; k < numDataObjects && j < selectedIndex; k++ )
+        int i(-1);
+        for( ; k < numDataObjects && i < selectedIndex; k++ )
         {
           if( notChosen[k] )
           {
-            j++;
+            i++;
           }
         }
         k--;
         exactEstimateData.push_back( &(caller->data[k]) );
-        notChosen[k] = false;
+        notChosen[k] = 0;
         maxIndex--;
       }
       
-      //get the indexes of the chosen objects so we can check that 
+      //store the indexes of the chosen objects so we can check that 
       //this sub-set hasn't been chosen already
-      unsigned int m(0);
+      int *curSubSetIndexes = &( caller->batchSubSets[j*numForEstimate] );
       unsigned int l(0);
-      for( ; m < numDataObjects; m++ )
+      for( unsigned int m = 0; m < numDataObjects; m++ )
       {
         if( !notChosen[m] )
         {
@@ -196,79 +293,27 @@ ITK_THREAD_RETURN_TYPE RANSAC<T,S>::RANSACThreadCallback( void *arg )
         }
       }
 
-      std::pair< typename std::set<int *, SubSetIndexComparator >::iterator, bool> res;
-
-      caller->hypothesisMutex.Lock();
-      //check that the sub-set just chosen is unique
-      res = caller->chosenSubSets->insert( curSubSetIndexes );
-      caller->hypothesisMutex.Unlock();
+      //use the selected data for an exact model parameter fit
+      std::vector<S> &exactEstimateParameters = caller->batchParameters[j];
+      caller->paramEstimator->Estimate( exactEstimateData,
+                                        exactEstimateParameters );
 
-      if(res.second == true)
+      //see how many agree on this estimate
+      unsigned int numVotesForCur = 0;
+      if( !exactEstimateParameters.empty() )
       {
-        //first time we chose this sub set        
-        //use the selected data for an exact model parameter fit
-        caller->paramEstimator->Estimate( exactEstimateData,
-                                          exactEstimateParameters );
-
-        //selected data is a singular configuration (e.g. three 
-        //colinear points for a circle fit)
-        if( exactEstimateParameters.size() == 0 )
-        {
-          continue;
-        }
-
-        //see how many agree on this estimate
-        numVotesForCur = 0;        
-        std::fill( curVotes, curVotes+numDataObjects, false );
-
         //continue checking data until there is no chance of getting a larger consensus set 
-        //or all the data has been checked              
-        for( m = 0; m < numDataObjects && caller->numVotesForBest-numVotesForCur < numDataObjects - m + 1; m++ )
+        //than the best one at the start of the batch, or all the data has been checked              
+        for( unsigned int m = 0; m < numDataObjects && numVotesForCur + ( numDataObjects - m ) > caller->numVotesForBest; m++ )
         {
           if( caller->paramEstimator->Agree( exactEstimateParameters, caller->data[m] ) ) 
           {
-            curVotes[m] = true;
             numVotesForCur++;
           }
-        } //found a larger consensus set?
-
-        caller->resultsMutex.Lock();
-        if( numVotesForCur > caller->numVotesForBest )
-        {
-          caller->numVotesForBest = numVotesForCur;
-          for( unsigned int objIndex = 0; objIndex < numDataObjects; ++objIndex )
-          {
-            caller->bestVotes[objIndex] = curVotes[objIndex];
-          }
-          //std::copy( curVotes, curVotes+numDataObjects, caller->bestVotes );
-        
-          //all data objects are inliers, terminate the search
-          if( caller->numVotesForBest == numDataObjects )
-          {
-            i = caller->numTries;
-          }
-          else
-          {
-            //update the estimate of outliers and the number of iterations we need                                 
-            denominator = log( 1.0 - pow((double)numVotesForCur/(double)numDataObjects, 
-              (double)(numForEstimate)) );
-            caller->numTries = (int)( caller->numerator/denominator + 0.5 );
-
-            //there are cases when the probablistic number of tries is greater than all possible sub-sets
-            caller->numTries = caller->numTries<caller->allTries ? caller->numTries : caller->allTries;
-          }
         }
-        caller->resultsMutex.Unlock();
-
-      }
-      else
-      {
-        //this sub set already appeared, release memory
-        delete [] curSubSetIndexes;      
       }
+      caller->batchNumVotes[j] = numVotesForCur;
     }
-    delete [] curVotes;
-    delete [] notChosen;
   }
   return ITK_THREAD_RETURN_VALUE;
 }
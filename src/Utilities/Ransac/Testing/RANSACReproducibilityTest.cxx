@@ -0,0 +1,125 @@
+#include <vector>
+#include <iostream>
+#include <itkPoint.h>
+#include <itkMultiThreader.h>
+#include <cmath>
+#include "RandomNumberGenerator.h"
+#include "PlaneParametersEstimator.h"
+#include "RANSAC.h"
+
+const unsigned int DIMENSION = 3;
+typedef itk::Point<double,DIMENSION> PointType;
+typedef itk::PlaneParametersEstimator<DIMENSION> PlaneEstimatorType;
+typedef itk::RANSAC<PointType, double> RANSACType;
+
+/**
+ * Generate points on the plane z=0 with additive zero mean Gaussian noise and
+ * a set of outliers above it. The generator is seeded, so the data is
+ * identical in every run.
+ */
+void GenerateData( unsigned int numInliers, unsigned int numOutliers,
+                   std::vector<PointType> &data )
+{
+  RandomNumberGenerator random( 12345 );
+  PointType p;
+  for( unsigned int i=0; i<numInliers; i++ )
+  {
+    p[0] = random.uniform( -100.0, 100.0 );
+    p[1] = random.uniform( -100.0, 100.0 );
+    p[2] = random.normal( 0.1 );
+    data.push_back( p );
+  }
+  for( unsigned int i=0; i<numOutliers; i++ )
+  {
+    p[0] = random.uniform( -100.0, 100.0 );
+    p[1] = random.uniform( -100.0, 100.0 );
+    p[2] = random.uniform( 5.0, 100.0 );
+    data.push_back( p );
+  }
+}
+
+/**
+ * Run RANSAC with the given seed and number of threads.
+ */
+double Estimate( std::vector<PointType> &data, unsigned int seed,
+                 unsigned int numberOfThreads,
+                 std::vector<double> &parameters,
+                 unsigned int &numberOfTries )
+{
+  PlaneEstimatorType::Pointer planeEstimator = PlaneEstimatorType::New();
+  planeEstimator->SetDelta( 0.5 );
+
+  RANSACType::Pointer ransacEstimator = RANSACType::New();
+  ransacEstimator->SetData( data );
+  ransacEstimator->SetParametersEstimator( planeEstimator.GetPointer() );
+  ransacEstimator->SetNumberOfThreads( numberOfThreads );
+  ransacEstimator->SetRandomSeed( seed );
+  double percentageOfDataUsed = ransacEstimator->Compute( parameters, 0.999 );
+  numberOfTries = ransacEstimator->GetNumberOfTriesPerformed();
+  return percentageOfDataUsed;
+}
+
+/**
+ * Check that RANSAC with a fixed seed yields bit-identical results
+ * regardless of the number of threads, and that the result is correct.
+ */
+int main( int argc, char *argv[] )
+{
+  std::vector<PointType> data;
+  GenerateData( 700, 300, data );
+
+  const unsigned int seed = 2016;
+                       //RANSAC accepts at most the global default number of threads,
+                       //raise it on single core machines so that the multi-threaded
+                       //computation is tested as well
+  if( itk::MultiThreader::GetGlobalDefaultNumberOfThreads() < 4 )
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( 4 );
+  unsigned int maxThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  std::vector<double> referenceParameters;
+  unsigned int referenceTries = 0;
+  double referenceUsed = Estimate( data, seed, 1, referenceParameters, referenceTries );
+  if( referenceParameters.empty() )
+  {
+    std::cout<<"RANSAC estimate failed with a single thread.\n";
+    return EXIT_FAILURE;
+  }
+  std::cout<<"Single thread: "<<referenceTries<<" hypotheses, "<<referenceUsed*100<<"% of data used\n";
+
+                       //the plane normal should be (0,0,+-1)
+  if( fabs( fabs( referenceParameters[2] ) - 1.0 ) > 0.01 )
+  {
+    std::cout<<"Estimated plane normal is incorrect: ["<<referenceParameters[0]<<", "
+             <<referenceParameters[1]<<", "<<referenceParameters[2]<<"]\n";
+    return EXIT_FAILURE;
+  }
+
+  if( maxThreads < 2 )
+  {
+    std::cout<<"Only a single thread is available, multi-threaded results are not compared.\n";
+    return EXIT_SUCCESS;
+  }
+
+  bool succeeded = true;
+  std::vector<unsigned int> threadCounts;
+  for( unsigned int numberOfThreads = 2; numberOfThreads < maxThreads; numberOfThreads*=2 )
+    threadCounts.push_back( numberOfThreads );
+  threadCounts.push_back( maxThreads );
+  for( unsigned int i=0; i<threadCounts.size(); i++ )
+  {
+    unsigned int numberOfThreads = threadCounts[i];
+    std::vector<double> parameters;
+    unsigned int tries = 0;
+    double used = Estimate( data, seed, numberOfThreads, parameters, tries );
+    std::cout<<numberOfThreads<<" threads: "<<tries<<" hypotheses, "<<used*100<<"% of data used\n";
+    if( parameters != referenceParameters || tries != referenceTries || used != referenceUsed )
+    {
+      std::cout<<"Result with "<<numberOfThreads<<" threads differs from the single thread result.\n";
+      succeeded = false;
+    }
+  }
+
+  if( succeeded )
+    return EXIT_SUCCESS;
+  return EXIT_FAILURE;
+}